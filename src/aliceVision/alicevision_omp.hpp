@@ -15,6 +15,7 @@ using omp_lock_t = char;
 
 inline int omp_get_thread_num() { return 0; }
 inline int omp_get_max_threads() { return 1; }
+inline int omp_get_num_threads() { return 1; }
 inline void omp_set_num_threads(int num_threads) {}
 inline int omp_get_num_procs() { return 1; }
 inline void omp_set_nested(int nested) {}
@@ -25,3 +26,8 @@ inline void omp_destroy_lock(omp_lock_t *lock) {}
 inline void omp_set_lock(omp_lock_t *lock) {}
 inline void omp_unset_lock(omp_lock_t *lock) {}
 #endif
+
+// OpenMP >= 3.1 is required for "omp atomic capture" (not available with MSVC OpenMP 2.0)
+#if defined _OPENMP && _OPENMP >= 201107
+#define ALICEVISION_OMP_HAVE_ATOMIC_CAPTURE
+#endif
@@ -92,13 +92,26 @@ struct IntrinsicBase
   Mat2X residuals(const geometry::Pose3 & pose, const Mat3X & X, const Mat2X & x) const
   {
     assert(X.cols() == x.cols());
-    const std::size_t numPts = x.cols();
-    Mat2X residuals = Mat2X::Zero(2, numPts);
-    for(std::size_t i = 0; i < numPts; ++i)
-    {
-      residuals.col(i) = residual(pose, X.col(i), x.col(i));
-    }
-    return residuals;
+    Mat2X proj;
+    this->project(pose, X, proj);
+    return x - proj;
+  }
+
+  /// Projection of 3D points (one per column) into the camera plane (Apply pose, disto (if any) and Intrinsics)
+  void project(
+    const geometry::Pose3 & pose,
+    const Mat3X & pts3D,
+    Mat2X & out_pts2D,
+    bool applyDistortion = true) const
+  {
+    const Mat3X X = pose(pts3D); // apply pose
+    out_pts2D.resize(2, X.cols());
+    for(Mat3X::Index i = 0; i < X.cols(); ++i)
+      out_pts2D.col(i) = X.col(i).head<2>() / X(2, i);
+
+    if (applyDistortion && this->have_disto()) // apply disto
+      this->add_disto(out_pts2D, out_pts2D);
+    this->cam2ima(out_pts2D, out_pts2D); // apply intrinsics
   }
 
   // --
@@ -138,6 +151,68 @@ struct IntrinsicBase
   /// Return the distorted pixel (with added distortion)
   virtual Vec2 get_d_pixel(const Vec2& p) const = 0;
 
+  // --
+  // Batch members: points are stored one per column, out may be the same matrix as the input.
+  // The default implementations call the single point virtual members,
+  // the camera models override them with devirtualized (and vectorized when possible) loops.
+  // --
+
+  /// Get bearing vectors of image points
+  virtual void operator () (const Mat2X& pts, Mat3X& out) const
+  {
+    out.resize(3, pts.cols());
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      out.col(i) = (*this)(Vec2(pts.col(i)));
+  }
+
+  /// Transform points from the camera plane to the image plane
+  virtual void cam2ima(const Mat2X& pts, Mat2X& out) const
+  {
+    out.resize(2, pts.cols());
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      out.col(i) = cam2ima(Vec2(pts.col(i)));
+  }
+
+  /// Transform points from the image plane to the camera plane
+  virtual void ima2cam(const Mat2X& pts, Mat2X& out) const
+  {
+    out.resize(2, pts.cols());
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      out.col(i) = ima2cam(Vec2(pts.col(i)));
+  }
+
+  /// Add the distortion field to points (that are in normalized camera frame)
+  virtual void add_disto(const Mat2X& pts, Mat2X& out) const
+  {
+    out.resize(2, pts.cols());
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      out.col(i) = add_disto(Vec2(pts.col(i)));
+  }
+
+  /// Remove the distortion to camera points (that are in normalized camera frame)
+  virtual void remove_disto(const Mat2X& pts, Mat2X& out) const
+  {
+    out.resize(2, pts.cols());
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      out.col(i) = remove_disto(Vec2(pts.col(i)));
+  }
+
+  /// Return the un-distorted pixels (with removed distortion)
+  virtual void get_ud_pixel(const Mat2X& pts, Mat2X& out) const
+  {
+    out.resize(2, pts.cols());
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      out.col(i) = get_ud_pixel(Vec2(pts.col(i)));
+  }
+
+  /// Return the distorted pixels (with added distortion)
+  virtual void get_d_pixel(const Mat2X& pts, Mat2X& out) const
+  {
+    out.resize(2, pts.cols());
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      out.col(i) = get_d_pixel(Vec2(pts.col(i)));
+  }
+
   /// Normalize a given unit pixel error to the camera plane
   virtual double imagePlane_toCameraPlaneError(double value) const = 0;
 
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <aliceVision/config.hpp>
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/camera/cameraCommon.hpp>
 #include <aliceVision/camera/IntrinsicBase.hpp>
@@ -16,6 +17,10 @@
 #include <vector>
 #include <sstream>
 
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+#include <emmintrin.h>
+#endif
+
 
 namespace aliceVision {
 namespace camera {
@@ -92,12 +97,68 @@ class Pinhole : public IntrinsicBase
     return ( p -  principal_point() ) / focal();
   }
 
+  // Get bearing vectors of image points
+  virtual void operator () (const Mat2X& pts, Mat3X& out) const
+  {
+    out.resize(3, pts.cols());
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      out.col(i) = (_Kinv * Vec3(pts(0,i), pts(1,i), 1.0)).normalized();
+  }
+
+  // Transform points from the camera plane to the image plane
+  virtual void cam2ima(const Mat2X& pts, Mat2X& out) const
+  {
+    out.resize(2, pts.cols());
+    const double* in = pts.data();
+    double* o = out.data();
+    const Mat2X::Index size = pts.cols();
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+    const __m128d f = _mm_set1_pd(focal());
+    const __m128d pp = _mm_setr_pd(_K(0,2), _K(1,2));
+    for(Mat2X::Index i = 0; i < size; ++i)
+      _mm_storeu_pd(o + 2*i, _mm_add_pd(_mm_mul_pd(f, _mm_loadu_pd(in + 2*i)), pp));
+#else
+    const double f = focal();
+    for(Mat2X::Index i = 0; i < size; ++i)
+    {
+      o[2*i]   = f * in[2*i]   + _K(0,2);
+      o[2*i+1] = f * in[2*i+1] + _K(1,2);
+    }
+#endif
+  }
+
+  // Transform points from the image plane to the camera plane
+  virtual void ima2cam(const Mat2X& pts, Mat2X& out) const
+  {
+    out.resize(2, pts.cols());
+    const double* in = pts.data();
+    double* o = out.data();
+    const Mat2X::Index size = pts.cols();
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+    const __m128d f = _mm_set1_pd(focal());
+    const __m128d pp = _mm_setr_pd(_K(0,2), _K(1,2));
+    for(Mat2X::Index i = 0; i < size; ++i)
+      _mm_storeu_pd(o + 2*i, _mm_div_pd(_mm_sub_pd(_mm_loadu_pd(in + 2*i), pp), f));
+#else
+    const double f = focal();
+    for(Mat2X::Index i = 0; i < size; ++i)
+    {
+      o[2*i]   = (in[2*i]   - _K(0,2)) / f;
+      o[2*i+1] = (in[2*i+1] - _K(1,2)) / f;
+    }
+#endif
+  }
+
   virtual bool have_disto() const {  return false; }
 
   virtual Vec2 add_disto(const Vec2& p) const  { return p; }
 
   virtual Vec2 remove_disto(const Vec2& p) const  { return p; }
 
+  virtual void add_disto(const Mat2X& pts, Mat2X& out) const { out = pts; }
+
+  virtual void remove_disto(const Mat2X& pts, Mat2X& out) const { out = pts; }
+
   virtual double imagePlane_toCameraPlaneError(double value) const
   {
     return value / focal();
@@ -152,6 +213,32 @@ class Pinhole : public IntrinsicBase
   /// Return the distorted pixel (with added distortion)
   virtual Vec2 get_d_pixel(const Vec2& p) const {return p;}
 
+  /// Return the un-distorted pixels (with removed distortion)
+  virtual void get_ud_pixel(const Mat2X& pts, Mat2X& out) const
+  {
+    if(!have_disto())
+    {
+      out = pts;
+      return;
+    }
+    ima2cam(pts, out);
+    remove_disto(out, out);
+    cam2ima(out, out);
+  }
+
+  /// Return the distorted pixels (with added distortion)
+  virtual void get_d_pixel(const Mat2X& pts, Mat2X& out) const
+  {
+    if(!have_disto())
+    {
+      out = pts;
+      return;
+    }
+    ima2cam(pts, out);
+    add_disto(out, out);
+    cam2ima(out, out);
+  }
+
 private:
   // Focal & principal point are embed into the calibration matrix K
   Mat3 _K, _Kinv;
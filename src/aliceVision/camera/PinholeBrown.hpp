@@ -50,7 +50,7 @@ class PinholeBrownT2 : public Pinhole
         const double epsilon = 1e-8; //criteria to stop the iteration
         Vec2 p_u = p;
 
-        while((add_disto(p_u)-p).lpNorm<1>() > epsilon)//manhattan distance between the two points
+        while((p_u + distoFunction(_distortionParams, p_u) - p).lpNorm<1>() > epsilon)//manhattan distance between the two points
         {
             p_u = p - distoFunction(_distortionParams, p_u);
         }
@@ -58,6 +58,23 @@ class PinholeBrownT2 : public Pinhole
         return p_u;
     }
 
+    virtual void add_disto(const Mat2X& pts, Mat2X& out) const
+    {
+        out.resize(2, pts.cols());
+        for(Mat2X::Index j = 0; j < pts.cols(); ++j)
+            out.col(j) = PinholeBrownT2::add_disto(Vec2(pts.col(j)));
+    }
+
+    virtual void remove_disto(const Mat2X& pts, Mat2X& out) const
+    {
+        out.resize(2, pts.cols());
+        for(Mat2X::Index j = 0; j < pts.cols(); ++j)
+            out.col(j) = PinholeBrownT2::remove_disto(Vec2(pts.col(j)));
+    }
+
+    using Pinhole::get_ud_pixel;
+    using Pinhole::get_d_pixel;
+
     /// Return the un-distorted pixel (with removed distortion)
     virtual Vec2 get_ud_pixel(const Vec2& p) const
     {
@@ -57,6 +57,23 @@ public:
     return  p * coef;
   }
 
+  virtual void add_disto(const Mat2X& pts, Mat2X& out) const
+  {
+    out.resize(2, pts.cols());
+    for(Mat2X::Index j = 0; j < pts.cols(); ++j)
+      out.col(j) = PinholeFisheye1::add_disto(Vec2(pts.col(j)));
+  }
+
+  virtual void remove_disto(const Mat2X& pts, Mat2X& out) const
+  {
+    out.resize(2, pts.cols());
+    for(Mat2X::Index j = 0; j < pts.cols(); ++j)
+      out.col(j) = PinholeFisheye1::remove_disto(Vec2(pts.col(j)));
+  }
+
+  using Pinhole::get_ud_pixel;
+  using Pinhole::get_d_pixel;
+
   /// Return the un-distorted pixel (with removed distortion)
   virtual Vec2 get_ud_pixel(const Vec2& p) const
   {
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <aliceVision/config.hpp>
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/camera/cameraCommon.hpp>
 #include <aliceVision/camera/Pinhole.hpp>
@@ -44,6 +45,38 @@ namespace radial_distortion{
     return .5*(lowerbound+upbound);
   }
 
+  /// Apply the radial distortion x_d = x_u (1 + K_1 r^2 + K_2 r^4 + K_3 r^6) to points (one per column)
+  inline void applyRadialDistortion(const Mat2X& pts, double k1, double k2, double k3, Mat2X& out)
+  {
+    out.resize(2, pts.cols());
+    const double* in = pts.data();
+    double* o = out.data();
+    const Mat2X::Index size = pts.cols();
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d vk1 = _mm_set1_pd(k1), vk2 = _mm_set1_pd(k2), vk3 = _mm_set1_pd(k3);
+    for(Mat2X::Index i = 0; i < size; ++i)
+    {
+      const __m128d p = _mm_loadu_pd(in + 2*i);
+      const __m128d p2 = _mm_mul_pd(p, p);
+      const __m128d r2 = _mm_add_pd(p2, _mm_shuffle_pd(p2, p2, 1)); // x^2 + y^2 in both lanes
+      __m128d coeff = _mm_add_pd(vk2, _mm_mul_pd(r2, vk3));
+      coeff = _mm_add_pd(vk1, _mm_mul_pd(r2, coeff));
+      coeff = _mm_add_pd(one, _mm_mul_pd(r2, coeff));
+      _mm_storeu_pd(o + 2*i, _mm_mul_pd(p, coeff));
+    }
+#else
+    for(Mat2X::Index i = 0; i < size; ++i)
+    {
+      const double x = in[2*i], y = in[2*i+1];
+      const double r2 = x*x + y*y;
+      const double coeff = 1. + r2*(k1 + r2*(k2 + r2*k3));
+      o[2*i]   = x * coeff;
+      o[2*i+1] = y * coeff;
+    }
+#endif
+  }
+
 } // namespace radial_distortion
 
 /// Implement a Pinhole camera with a 1 radial distortion coefficient.
@@ -90,6 +123,21 @@ class PinholeRadialK1 : public Pinhole
     return radius * p;
   }
 
+  virtual void add_disto(const Mat2X& pts, Mat2X& out) const
+  {
+    radial_distortion::applyRadialDistortion(pts, _distortionParams.at(0), 0.0, 0.0, out);
+  }
+
+  virtual void remove_disto(const Mat2X& pts, Mat2X& out) const
+  {
+    out.resize(2, pts.cols());
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      out.col(i) = PinholeRadialK1::remove_disto(Vec2(pts.col(i)));
+  }
+
+  using Pinhole::get_ud_pixel;
+  using Pinhole::get_d_pixel;
+
   /// Return the un-distorted pixel (with removed distortion)
   virtual Vec2 get_ud_pixel(const Vec2& p) const
   {
@@ -158,6 +206,21 @@ class PinholeRadialK3 : public Pinhole
     return radius * p;
   }
 
+  virtual void add_disto(const Mat2X& pts, Mat2X& out) const
+  {
+    radial_distortion::applyRadialDistortion(pts, _distortionParams[0], _distortionParams[1], _distortionParams[2], out);
+  }
+
+  virtual void remove_disto(const Mat2X& pts, Mat2X& out) const
+  {
+    out.resize(2, pts.cols());
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      out.col(i) = PinholeRadialK3::remove_disto(Vec2(pts.col(i)));
+  }
+
+  using Pinhole::get_ud_pixel;
+  using Pinhole::get_d_pixel;
+
   /// Return the un-distorted pixel (with removed distortion)
   virtual Vec2 get_ud_pixel(const Vec2& p) const
   {
@@ -0,0 +1,158 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/camera/IntrinsicBase.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace aliceVision {
+namespace camera {
+
+/**
+ * @brief Lookup grid of the distortion field of a camera.
+ *
+ * The distorted position of the undistorted pixels (get_d_pixel) and the undistorted position
+ * of the distorted pixels (get_ud_pixel) are computed once on a regular grid covering the image,
+ * then bilinearly interpolated. It replaces the per pixel evaluation of the distortion model
+ * (and its iterative inversion) by a table lookup when a full image is remapped.
+ * Points outside of the grid fall back to the exact camera model.
+ */
+class UndistortionGrid
+{
+public:
+  /**
+   * @brief Build the grids for the given camera
+   * @param[in] intrinsic the camera model (copied)
+   * @param[in] step the distance in pixels between two grid nodes
+   */
+  explicit UndistortionGrid(const IntrinsicBase& intrinsic, int step = 8)
+    : _intrinsic(intrinsic.clone())
+    , _step(step)
+  {
+    if(_step <= 0)
+      throw std::invalid_argument("UndistortionGrid: the grid step must be positive.");
+
+    // nodes at [0, step, ..., >= size] so that every pixel of the image is inside a cell
+    _nbNodesX = std::max(2, static_cast<int>((intrinsic.w() + _step - 1) / _step) + 1);
+    _nbNodesY = std::max(2, static_cast<int>((intrinsic.h() + _step - 1) / _step) + 1);
+
+    Mat2X nodes(2, _nbNodesX * _nbNodesY);
+    for(int y = 0; y < _nbNodesY; ++y)
+      for(int x = 0; x < _nbNodesX; ++x)
+        nodes.col(y * _nbNodesX + x) = Vec2(x * _step, y * _step);
+
+    _intrinsic->get_d_pixel(nodes, _distortedNodes);
+    _intrinsic->get_ud_pixel(nodes, _undistortedNodes);
+  }
+
+  int step() const { return _step; }
+
+  /// Return the distorted pixel (with added distortion)
+  Vec2 get_d_pixel(const Vec2& p) const
+  {
+    Vec2 out;
+    if(!interpolate(_distortedNodes, p(0), p(1), out))
+      return _intrinsic->get_d_pixel(p);
+    return out;
+  }
+
+  /// Return the un-distorted pixel (with removed distortion)
+  Vec2 get_ud_pixel(const Vec2& p) const
+  {
+    Vec2 out;
+    if(!interpolate(_undistortedNodes, p(0), p(1), out))
+      return _intrinsic->get_ud_pixel(p);
+    return out;
+  }
+
+  /// Return the distorted pixels (one per column, out may be the same matrix as the input)
+  void get_d_pixel(const Mat2X& pts, Mat2X& out) const
+  {
+    out.resize(2, pts.cols());
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      out.col(i) = get_d_pixel(Vec2(pts.col(i)));
+  }
+
+  /// Return the un-distorted pixels (one per column, out may be the same matrix as the input)
+  void get_ud_pixel(const Mat2X& pts, Mat2X& out) const
+  {
+    out.resize(2, pts.cols());
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      out.col(i) = get_ud_pixel(Vec2(pts.col(i)));
+  }
+
+  /**
+   * @brief Compute the distorted position of all the undistorted pixels (x, y) of an image row
+   * @param[in] y the row index
+   * @param[in] width the number of pixels of the row
+   * @param[out] out the distorted positions (2 x width)
+   */
+  void get_d_pixelsRow(int y, int width, Mat2X& out) const
+  {
+    out.resize(2, width);
+
+    const int cellY = y / _step;
+    if(y < 0 || cellY >= _nbNodesY - 1 || width > (_nbNodesX - 1) * _step)
+    {
+      for(int x = 0; x < width; ++x)
+        out.col(x) = get_d_pixel(Vec2(x, y));
+      return;
+    }
+
+    // interpolate along y once per column of nodes, then along x for each pixel
+    const double ty = static_cast<double>(y - cellY * _step) / _step;
+    const double invStep = 1.0 / _step;
+    for(int cellX = 0; cellX * _step < width; ++cellX)
+    {
+      const Vec2 left = (1.0 - ty) * _distortedNodes.col(cellY * _nbNodesX + cellX) + ty * _distortedNodes.col((cellY + 1) * _nbNodesX + cellX);
+      const Vec2 right = (1.0 - ty) * _distortedNodes.col(cellY * _nbNodesX + cellX + 1) + ty * _distortedNodes.col((cellY + 1) * _nbNodesX + cellX + 1);
+      const Vec2 delta = (right - left) * invStep;
+
+      const int xEnd = std::min(width, (cellX + 1) * _step);
+      for(int x = cellX * _step; x < xEnd; ++x)
+        out.col(x) = left + (x - cellX * _step) * delta;
+    }
+  }
+
+private:
+  bool interpolate(const Mat2X& nodes, double x, double y, Vec2& out) const
+  {
+    const double gx = x / _step;
+    const double gy = y / _step;
+    if(!(gx >= 0.0 && gy >= 0.0 && gx <= _nbNodesX - 1 && gy <= _nbNodesY - 1))
+      return false;
+
+    const int cellX = std::min(static_cast<int>(gx), _nbNodesX - 2);
+    const int cellY = std::min(static_cast<int>(gy), _nbNodesY - 2);
+    const double tx = gx - cellX;
+    const double ty = gy - cellY;
+
+    const Mat2X::Index n00 = cellY * _nbNodesX + cellX;
+    const Mat2X::Index n10 = n00 + _nbNodesX;
+    out = (1.0 - ty) * ((1.0 - tx) * nodes.col(n00) + tx * nodes.col(n00 + 1)) +
+          ty * ((1.0 - tx) * nodes.col(n10) + tx * nodes.col(n10 + 1));
+    return true;
+  }
+
+  std::unique_ptr<IntrinsicBase> _intrinsic;
+  int _step;
+  int _nbNodesX = 0;
+  int _nbNodesY = 0;
+  /// distorted position of each node (undistorted pixel)
+  Mat2X _distortedNodes;
+  /// undistorted position of each node (distorted pixel)
+  Mat2X _undistortedNodes;
+};
+
+} // namespace camera
+} // namespace aliceVision
@@ -14,6 +14,7 @@
 #include <aliceVision/camera/PinholeBrown.hpp>
 #include <aliceVision/camera/PinholeFisheye.hpp>
 #include <aliceVision/camera/PinholeFisheye1.hpp>
+#include <aliceVision/camera/UndistortionGrid.hpp>
 #include <aliceVision/camera/cameraUndistortImage.hpp>
 
 namespace aliceVision {
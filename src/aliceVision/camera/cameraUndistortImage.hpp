@@ -11,23 +11,237 @@
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/image/Image.hpp>
 #include <aliceVision/image/Sampler.hpp>
+#include <aliceVision/image/warping.hpp>
 #include <aliceVision/camera/cameraCommon.hpp>
 #include <aliceVision/camera/IntrinsicBase.hpp>
 #include <aliceVision/camera/Pinhole.hpp>
+#include <aliceVision/camera/UndistortionGrid.hpp>
 
+#include <future>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <tuple>
 
 namespace aliceVision {
 namespace camera {
 
+/**
+ * @brief Build the remap table of the undistortion of the images of a camera
+ * @param[in] intrinsic the camera model
+ * @param[in] width, height the image size
+ * @param[in] correctPrincipalPoint move the principal point to the image center
+ * @param[out] table the remap table (undistorted pixel -> distorted pixel)
+ * @param[in] gridStep the step of the grid on which the distortion field is evaluated and interpolated
+ *            (see UndistortionGrid), 0 to evaluate the camera model at each pixel.
+ *            The interpolation error grows with the square of the step and with the curvature of the distortion:
+ *            with a step of 8 pixels, it stays below 0.01 pixel for moderate radial distortions
+ *            and reaches about 0.15 pixel in the corners of strongly distorted wide angle images.
+ */
+inline void createUndistortRemapTable(
+  const camera::IntrinsicBase& intrinsic,
+  int width, int height,
+  bool correctPrincipalPoint,
+  image::RemapTable& table,
+  int gridStep = 0)
+{
+  const Vec2 center(width * 0.5, height * 0.5);
+  Vec2 ppCorrection(0.0, 0.0);
+
+  if(correctPrincipalPoint)
+  {
+    if(camera::isPinhole(intrinsic.getType()))
+    {
+      const camera::Pinhole* pinholePtr = dynamic_cast<const camera::Pinhole*>(&intrinsic);
+      ppCorrection = pinholePtr->principal_point() - center;
+    }
+  }
+
+  if(gridStep <= 0)
+  {
+    // compute coordinates with distortion of each row with the exact camera model
+    image::BuildRemapTable(width, height, width, height, [&](int y, Mat2X& out)
+    {
+      Mat2X row(2, width);
+      for(int x = 0; x < width; ++x)
+        row.col(x) = Vec2(x, y);
+      intrinsic.get_d_pixel(row, out);
+      out.colwise() += ppCorrection;
+    }, table);
+    return;
+  }
+
+  const UndistortionGrid grid(intrinsic, gridStep);
+
+  // compute coordinates with distortion of each row
+  image::BuildRemapTable(width, height, width, height, [&](int y, Mat2X& out)
+  {
+    grid.get_d_pixelsRow(y, width, out);
+    out.colwise() += ppCorrection;
+  }, table);
+}
+
+/**
+ * @brief Thread-safe cache of the undistortion remap tables.
+ * The tables are shared by the images of the same intrinsic (and image size).
+ * Each table takes about 10 bytes per pixel, the least recently used tables are
+ * released when the cache exceeds its memory budget.
+ */
+class UndistortRemapCache
+{
+public:
+  /**
+   * @param[in] correctPrincipalPoint move the principal point to the image center
+   * @param[in] gridStep the step of the distortion grid, 0 for the exact camera model (see createUndistortRemapTable)
+   * @param[in] maxMemorySize the memory budget of the cached tables in bytes
+   * @note the last built table is always kept, even if it exceeds the budget alone
+   */
+  explicit UndistortRemapCache(bool correctPrincipalPoint = false, int gridStep = 0, std::size_t maxMemorySize = std::size_t(1) << 30)
+    : _correctPrincipalPoint(correctPrincipalPoint)
+    , _gridStep(gridStep)
+    , _maxMemorySize(maxMemorySize)
+  {}
+
+  /**
+   * @brief Get the remap table of an intrinsic, build it on the first request
+   * @note concurrent requests of the same table wait for a single build
+   */
+  std::shared_ptr<const image::RemapTable> get(const camera::IntrinsicBase& intrinsic, int width, int height)
+  {
+    const Key key(intrinsic.hashValue(), width, height);
+
+    std::promise<std::shared_ptr<const image::RemapTable>> promise;
+    std::shared_future<std::shared_ptr<const image::RemapTable>> future;
+    bool build = false;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto it = _entries.find(key);
+      if(it == _entries.end())
+      {
+        future = promise.get_future().share();
+        _lru.push_front(key);
+        _entries.emplace(key, Entry{future, 0, _lru.begin()});
+        build = true;
+      }
+      else
+      {
+        future = it->second.future;
+        // move to the front of the LRU list
+        _lru.splice(_lru.begin(), _lru, it->second.lruIt);
+      }
+    }
+
+    if(build)
+    {
+      try
+      {
+        std::shared_ptr<image::RemapTable> table = std::make_shared<image::RemapTable>();
+        createUndistortRemapTable(intrinsic, width, height, _correctPrincipalPoint, *table, _gridStep);
+        promise.set_value(table);
+        insertBuiltTable(key, table->memorySize());
+      }
+      catch(...)
+      {
+        promise.set_exception(std::current_exception());
+        // do not keep the failure: the next request builds the table again
+        std::lock_guard<std::mutex> lock(_mutex);
+        eraseEntry(key);
+      }
+    }
+    return future.get();
+  }
+
+  /// Memory size in bytes of the cached (built) tables
+  std::size_t memorySize() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _memorySize;
+  }
+
+  /// Number of cached (built or being built) tables
+  std::size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _entries.size();
+  }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.clear();
+    _lru.clear();
+    _memorySize = 0;
+  }
+
+private:
+  /// intrinsic hash, width, height
+  typedef std::tuple<std::size_t, int, int> Key;
+
+  struct Entry
+  {
+    std::shared_future<std::shared_ptr<const image::RemapTable>> future;
+    /// 0 while the table is being built
+    std::size_t memorySize;
+    std::list<Key>::iterator lruIt;
+  };
+
+  /// Account for the memory of a new table and release the least recently used tables over the budget
+  void insertBuiltTable(const Key& key, std::size_t tableMemorySize)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _entries.find(key);
+    if(it == _entries.end()) // cleared in the meantime
+      return;
+    it->second.memorySize = tableMemorySize;
+    _memorySize += tableMemorySize;
+
+    auto lruIt = _lru.end();
+    while(_memorySize > _maxMemorySize && lruIt != _lru.begin())
+    {
+      --lruIt;
+      const auto entryIt = _entries.find(*lruIt);
+      // keep the new table and the tables being built
+      if(*lruIt == key || entryIt->second.memorySize == 0)
+        continue;
+      // the requesters still holding the table keep it alive
+      _memorySize -= entryIt->second.memorySize;
+      lruIt = _lru.erase(lruIt);
+      _entries.erase(entryIt);
+    }
+  }
+
+  void eraseEntry(const Key& key)
+  {
+    auto it = _entries.find(key);
+    if(it == _entries.end())
+      return;
+    _memorySize -= it->second.memorySize;
+    _lru.erase(it->second.lruIt);
+    _entries.erase(it);
+  }
+
+  const bool _correctPrincipalPoint;
+  const int _gridStep;
+  const std::size_t _maxMemorySize;
+  mutable std::mutex _mutex;
+  /// keys from the most to the least recently used
+  std::list<Key> _lru;
+  std::map<Key, Entry> _entries;
+  std::size_t _memorySize = 0;
+};
+
 /// Undistort an image according a given camera and its distortion model
+/// With gridStep > 0, the distortion field is evaluated on a grid of gridStep pixels and bilinearly interpolated,
+/// see createUndistortRemapTable for the approximation error
 template <typename T>
 void UndistortImage(
   const image::Image<T>& imageIn,
   const camera::IntrinsicBase* intrinsicPtr,
   image::Image<T>& image_ud,
   T fillcolor,
-  bool correctPrincipalPoint = false)
+  bool correctPrincipalPoint = false,
+  int gridStep = 0)
 {
   if (!intrinsicPtr->have_disto()) // no distortion, perform a direct copy
   {
@@ -35,37 +249,23 @@ void UndistortImage(
   }
   else // There is distortion
   {
-    const Vec2 center(imageIn.Width() * 0.5, imageIn.Height() * 0.5);
-    Vec2 ppCorrection(0.0, 0.0);
-
-    if(correctPrincipalPoint)
-    {
-      if(camera::isPinhole(intrinsicPtr->getType()))
-      {
-        const camera::Pinhole* pinholePtr = dynamic_cast<const camera::Pinhole*>(intrinsicPtr);
-        ppCorrection = pinholePtr->principal_point() - center;
-      }
-    }
-
-    image_ud.resize(imageIn.Width(), imageIn.Height(), true, fillcolor);
-    const image::Sampler2d<image::SamplerLinear> sampler;
-
-    #pragma omp parallel for
-    for (int j = 0; j < imageIn.Height(); ++j)
-      for (int i = 0; i < imageIn.Width(); ++i)
-      {
-        const Vec2 undisto_pix(i,j);
-
-        // compute coordinates with distortion
-        const Vec2 disto_pix = intrinsicPtr->get_d_pixel(undisto_pix) + ppCorrection;
-
-        // pick pixel if it is in the image domain
-        if ( imageIn.Contains(disto_pix(1), disto_pix(0)) )
-          image_ud( j, i ) = sampler(imageIn, disto_pix(1), disto_pix(0));
-      }
+    image::RemapTable table;
+    createUndistortRemapTable(*intrinsicPtr, imageIn.Width(), imageIn.Height(), correctPrincipalPoint, table, gridStep);
+    image::Remap(imageIn, table, image_ud, fillcolor);
   }
 }
 
+/// Undistort an image with a precomputed remap table (see UndistortRemapCache)
+template <typename T>
+void UndistortImage(
+  const image::Image<T>& imageIn,
+  const image::RemapTable& table,
+  image::Image<T>& image_ud,
+  T fillcolor)
+{
+  image::Remap(imageIn, table, image_ud, fillcolor);
+}
+
 } // namespace camera
 } // namespace aliceVision
 
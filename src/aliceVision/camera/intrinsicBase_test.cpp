@@ -0,0 +1,111 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/camera/camera.hpp>
+
+#define BOOST_TEST_MODULE intrinsicBase
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include <aliceVision/unitTest.hpp>
+
+#include <memory>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::camera;
+
+namespace {
+
+std::vector<std::shared_ptr<IntrinsicBase>> createCameras()
+{
+  return {
+    std::make_shared<Pinhole>(1000, 800, 1000, 500, 400),
+    std::make_shared<PinholeRadialK1>(1000, 800, 1000, 500, 400, 0.1),
+    std::make_shared<PinholeRadialK3>(1000, 800, 1000, 500, 400, -0.245539, 0.255195, 0.163773),
+    std::make_shared<PinholeBrownT2>(1000, 800, 1000, 500, 400, -0.245539, 0.255195, 0.163773, 0.001, -0.002),
+    std::make_shared<PinholeFisheye>(1000, 800, 1000, 500, 400, 0.1, 0.05, -0.01, 0.001),
+    std::make_shared<PinholeFisheye1>(1000, 800, 1000, 500, 400, 0.9)
+  };
+}
+
+} // namespace
+
+//-----------------
+// Test summary:
+//-----------------
+// - Create a camera of each model
+// - Generate random points inside the image domain
+// - Check that the batch members give the same results as the single point members
+//-----------------
+BOOST_AUTO_TEST_CASE(cameraIntrinsicBase_batch_vs_single)
+{
+  const double epsilon = 1e-10;
+  Mat2X ptsImage(2, 100);
+  for(Mat2X::Index i = 0; i < ptsImage.cols(); ++i)
+    ptsImage.col(i) = (Vec2::Random().cwiseProduct(Vec2(450., 350.))) + Vec2(500., 400.);
+
+  for(const auto& cam : createCameras())
+  {
+    const IntrinsicBase& intrinsic = *cam;
+
+    Mat2X ptsCamera, distorted, undistorted, dPixels, udPixels, ptsImageBack;
+    Mat3X bearings;
+    intrinsic.ima2cam(ptsImage, ptsCamera);
+    intrinsic.add_disto(ptsCamera, distorted);
+    intrinsic.remove_disto(ptsCamera, undistorted);
+    intrinsic.get_d_pixel(ptsImage, dPixels);
+    intrinsic.get_ud_pixel(ptsImage, udPixels);
+    intrinsic.cam2ima(ptsCamera, ptsImageBack);
+    intrinsic(ptsImage, bearings);
+
+    for(Mat2X::Index i = 0; i < ptsImage.cols(); ++i)
+    {
+      const Vec2 ptImage = ptsImage.col(i);
+      const Vec2 ptCamera = intrinsic.ima2cam(ptImage);
+      EXPECT_MATRIX_NEAR(ptCamera, ptsCamera.col(i), epsilon);
+      EXPECT_MATRIX_NEAR(intrinsic.add_disto(ptCamera), distorted.col(i), epsilon);
+      EXPECT_MATRIX_NEAR(intrinsic.remove_disto(ptCamera), undistorted.col(i), epsilon);
+      EXPECT_MATRIX_NEAR(intrinsic.get_d_pixel(ptImage), dPixels.col(i), epsilon);
+      EXPECT_MATRIX_NEAR(intrinsic.get_ud_pixel(ptImage), udPixels.col(i), epsilon);
+      EXPECT_MATRIX_NEAR(ptImage, ptsImageBack.col(i), epsilon);
+      EXPECT_MATRIX_NEAR(intrinsic(ptImage), bearings.col(i), epsilon);
+    }
+
+    // in place
+    Mat2X inPlace = ptsImage;
+    intrinsic.get_ud_pixel(inPlace, inPlace);
+    EXPECT_MATRIX_NEAR(udPixels, inPlace, epsilon);
+  }
+}
+
+//-----------------
+// Test summary:
+//-----------------
+// - Project random 3D points with a pose
+// - Check that the batch projection and residuals match the single point ones
+//-----------------
+BOOST_AUTO_TEST_CASE(cameraIntrinsicBase_batch_project)
+{
+  const geometry::Pose3 pose(RotationAroundY(0.2), Vec3(0.1, -0.2, 0.3));
+  Mat3X pts3D(3, 50);
+  for(Mat3X::Index i = 0; i < pts3D.cols(); ++i)
+    pts3D.col(i) = Vec3::Random() + Vec3(0., 0., 5.);
+
+  for(const auto& cam : createCameras())
+  {
+    Mat2X projected;
+    cam->project(pose, pts3D, projected);
+
+    Mat2X observations = projected + Mat2X::Random(2, projected.cols());
+    const Mat2X residuals = cam->residuals(pose, pts3D, observations);
+
+    for(Mat3X::Index i = 0; i < pts3D.cols(); ++i)
+    {
+      EXPECT_MATRIX_NEAR(cam->project(pose, pts3D.col(i)), projected.col(i), 1e-8);
+      EXPECT_MATRIX_NEAR(cam->residual(pose, pts3D.col(i), observations.col(i)), residuals.col(i), 1e-8);
+    }
+  }
+}
@@ -0,0 +1,148 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/camera/camera.hpp>
+
+#define BOOST_TEST_MODULE undistortionGrid
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include <aliceVision/unitTest.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::camera;
+
+//-----------------
+// Test summary:
+//-----------------
+// - Create a PinholeRadialK3 camera and its undistortion grid
+// - Generate random points inside the image domain
+// - Check that the interpolated mapping is close to the exact one
+// - Check that the row mapping matches the point mapping
+//-----------------
+BOOST_AUTO_TEST_CASE(cameraUndistortionGrid_interpolation)
+{
+  const PinholeRadialK3 cam(1000, 800, 1000, 500, 400,
+    // K1, K2, K3
+    -0.245539, 0.255195, 0.163773);
+
+  const UndistortionGrid grid(cam, 8);
+
+  const double epsilon = 1e-2; // pixels
+  for(int i = 0; i < 100; ++i)
+  {
+    const Vec2 ptImage = (Vec2::Random().cwiseProduct(Vec2(500., 400.))) + Vec2(500., 400.);
+    EXPECT_MATRIX_NEAR(cam.get_d_pixel(ptImage), grid.get_d_pixel(ptImage), epsilon);
+    EXPECT_MATRIX_NEAR(cam.get_ud_pixel(ptImage), grid.get_ud_pixel(ptImage), epsilon);
+  }
+
+  // outside of the grid: exact camera model
+  const Vec2 outside(-50., 900.);
+  EXPECT_MATRIX_NEAR(cam.get_d_pixel(outside), grid.get_d_pixel(outside), 1e-10);
+
+  for(int y : {0, 7, 8, 399, 799})
+  {
+    Mat2X row;
+    grid.get_d_pixelsRow(y, cam.w(), row);
+    BOOST_CHECK_EQUAL(row.cols(), cam.w());
+    for(int x = 0; x < cam.w(); ++x)
+      EXPECT_MATRIX_NEAR(grid.get_d_pixel(Vec2(x, y)), row.col(x), 1e-8);
+  }
+}
+
+//-----------------
+// Test summary:
+//-----------------
+// - Undistort a random image with UndistortImage and with the remap table cache
+// - Check that the result matches the per pixel exact undistortion
+// - Check that the grid approximation is close to the exact undistortion
+// - Check that the cache shares the table of a same intrinsic
+//-----------------
+BOOST_AUTO_TEST_CASE(cameraUndistortionGrid_undistortImage)
+{
+  const PinholeRadialK3 cam(160, 120, 150, 80, 60,
+    // K1, K2, K3
+    -0.245539, 0.255195, 0.163773);
+
+  image::Image<float> image(cam.w(), cam.h());
+  for(int j = 0; j < image.Height(); ++j)
+    for(int i = 0; i < image.Width(); ++i)
+      image(j, i) = static_cast<float>(std::sin(0.1 * i) * std::cos(0.07 * j));
+
+  image::Image<float> undistorted;
+  UndistortImage(image, &cam, undistorted, 0.f);
+
+  UndistortRemapCache cache;
+  const auto table = cache.get(cam, image.Width(), image.Height());
+  BOOST_CHECK(table == cache.get(cam, image.Width(), image.Height()));
+
+  image::Image<float> undistortedCached;
+  UndistortImage(image, *table, undistortedCached, 0.f);
+
+  image::Image<float> undistortedGrid;
+  UndistortImage(image, &cam, undistortedGrid, 0.f, false, 8);
+
+  const image::Sampler2d<image::SamplerLinear> sampler;
+  for(int j = 0; j < image.Height(); ++j)
+    for(int i = 0; i < image.Width(); ++i)
+    {
+      BOOST_CHECK_EQUAL(undistorted(j, i), undistortedCached(j, i));
+
+      const Vec2 d = cam.get_d_pixel(Vec2(i, j));
+      // skip the pixels close to the image border, where the grid approximation may change the mapping
+      if(d(0) < 1.0 || d(1) < 1.0 || d(0) > image.Width() - 2 || d(1) > image.Height() - 2)
+        continue;
+      BOOST_CHECK_SMALL(undistorted(j, i) - sampler(image, d(1), d(0)), 1e-3f);
+      BOOST_CHECK_SMALL(undistortedGrid(j, i) - sampler(image, d(1), d(0)), 1e-2f);
+    }
+}
+
+//-----------------
+// Test summary:
+// - Check that the cache releases the least recently used tables over its memory budget
+//-----------------
+BOOST_AUTO_TEST_CASE(cameraUndistortionGrid_remapCacheBudget)
+{
+  const PinholeRadialK3 camA(160, 120, 150, 80, 60, -0.245539, 0.255195, 0.163773);
+  const PinholeRadialK3 camB(160, 120, 150, 80, 60, -0.1, 0.05, 0.0);
+  const PinholeRadialK3 camC(160, 120, 150, 80, 60, 0.1, 0.0, 0.0);
+
+  image::RemapTable reference;
+  createUndistortRemapTable(camA, 160, 120, false, reference, 8);
+  const std::size_t tableSize = reference.memorySize();
+
+  // room for 2 tables
+  UndistortRemapCache cache(false, 8, 2 * tableSize + tableSize / 2);
+
+  const auto tableA = cache.get(camA, 160, 120);
+  cache.get(camB, 160, 120);
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK_EQUAL(cache.memorySize(), 2 * tableSize);
+
+  // A is used again, so B is the least recently used table
+  BOOST_CHECK(tableA == cache.get(camA, 160, 120));
+  cache.get(camC, 160, 120);
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK_EQUAL(cache.memorySize(), 2 * tableSize);
+  BOOST_CHECK(tableA == cache.get(camA, 160, 120));
+
+  // A becomes the least recently used table: it is released when B is built again,
+  // the table stays valid for its holders
+  cache.get(camC, 160, 120);
+  cache.get(camB, 160, 120);
+  BOOST_CHECK(tableA != cache.get(camA, 160, 120));
+  BOOST_CHECK(tableA->offsets == reference.offsets);
+
+  // a table larger than the budget is still returned, and kept alone
+  UndistortRemapCache smallCache(false, 8, tableSize / 2);
+  smallCache.get(camA, 160, 120);
+  smallCache.get(camB, 160, 120);
+  BOOST_CHECK_EQUAL(smallCache.size(), 1);
+  BOOST_CHECK_EQUAL(smallCache.memorySize(), tableSize);
+
+  cache.clear();
+  BOOST_CHECK_EQUAL(cache.size(), 0);
+  BOOST_CHECK_EQUAL(cache.memorySize(), 0);
+}
@@ -13,6 +13,7 @@
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
 #include <exception>
 #include <iostream>
 #include <string>
@@ -22,8 +23,12 @@
 namespace aliceVision{
 namespace dataio{
 
-FeedProvider::FeedProvider(const std::string &feedPath, const std::string &calibPath) 
-: _isVideo(false), _isLiveFeed(false)
+namespace {
+
+std::unique_ptr<IFeed> createFeed(const std::string &feedPath,
+                                  const std::string &calibPath,
+                                  bool &isVideo,
+                                  bool &isLiveFeed)
 {
   namespace bf = boost::filesystem;
   if(feedPath.empty())
@@ -36,14 +41,14 @@ FeedProvider::FeedProvider(const std::string &feedPath, const std::string &calib
     const std::string extension = bf::path(feedPath).extension().string();
     if(ImageFeed::isSupported(extension))
     {
-      _feeder.reset(new ImageFeed(feedPath, calibPath));
+      return std::unique_ptr<IFeed>(new ImageFeed(feedPath, calibPath));
     }
     else 
     {
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_OPENCV)
       // let's try it with a video
-      _feeder.reset(new VideoFeed(feedPath, calibPath));
-      _isVideo = true;
+      isVideo = true;
+      return std::unique_ptr<IFeed>(new VideoFeed(feedPath, calibPath));
 #else
       throw std::invalid_argument("Unsupported mode! If you intended to use a video"
                                   " please add OpenCV support");
@@ -55,16 +60,16 @@ FeedProvider::FeedProvider(const std::string &feedPath, const std::string &calib
   else if(bf::is_directory(bf::path(feedPath)) || bf::is_directory(bf::path(feedPath).parent_path()))
   {
     // Folder or sequence of images
-    _feeder.reset(new ImageFeed(feedPath, calibPath));
+    return std::unique_ptr<IFeed>(new ImageFeed(feedPath, calibPath));
   }
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_OPENCV)
   else if(isdigit(feedPath[0]))
   {
     // let's try it with a video
     const int deviceNumber =  std::atoi(feedPath.c_str());
-    _feeder.reset(new VideoFeed(deviceNumber, calibPath));
-    _isVideo = true;
-    _isLiveFeed = true;
+    isVideo = true;
+    isLiveFeed = true;
+    return std::unique_ptr<IFeed>(new VideoFeed(deviceNumber, calibPath));
   }
 #endif
   else
@@ -73,6 +78,39 @@ FeedProvider::FeedProvider(const std::string &feedPath, const std::string &calib
   }
 }
 
+} // namespace
+
+FeedProvider::FeedProvider(const std::string &feedPath, const std::string &calibPath) 
+: _isVideo(false), _isLiveFeed(false)
+{
+  _feeder = createFeed(feedPath, calibPath, _isVideo, _isLiveFeed);
+}
+
+FeedProvider::FeedProvider(const std::string &feedPath,
+                           const std::string &calibPath,
+                           const FeedPrefetchOptions &prefetchOptions)
+: _isVideo(false), _isLiveFeed(false)
+{
+  _feeder = createFeed(feedPath, calibPath, _isVideo, _isLiveFeed);
+
+  if(prefetchOptions.nbFrames == 0 || _isLiveFeed || !_feeder->isInit())
+    return;
+
+  // a feed per decode thread, a video is decoded sequentially as seeking is expensive
+  const std::size_t nbThreads = _isVideo ? 1 : std::max<std::size_t>(prefetchOptions.nbThreads, 1);
+
+  std::vector<std::unique_ptr<IFeed>> feeds;
+  feeds.push_back(std::move(_feeder));
+  for(std::size_t i = 1; i < nbThreads; ++i)
+  {
+    bool isVideo = false;
+    bool isLiveFeed = false;
+    feeds.push_back(createFeed(feedPath, calibPath, isVideo, isLiveFeed));
+  }
+
+  _feeder.reset(new PrefetchFeed(std::move(feeds), prefetchOptions));
+}
+
 bool FeedProvider::readImage(image::Image<image::RGBColor> &imageRGB,
       camera::PinholeRadialK3 &camIntrinsics,
       std::string &mediaPath,
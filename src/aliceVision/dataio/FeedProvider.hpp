@@ -7,6 +7,7 @@
 #pragma once
 
 #include "IFeed.hpp"
+#include "PrefetchFeed.hpp"
 
 #include <string>
 #include <memory>
@@ -19,6 +20,18 @@ class FeedProvider
 public:
   
   FeedProvider(const std::string &feedPath, const std::string &calibPath = "");
+
+  /**
+   * @brief Create a feed whose next frames are decoded ahead by background threads
+   * (see PrefetchFeed). The live feeds are never prefetched.
+   *
+   * @param[in] feedPath The media path (see FeedProvider(feedPath, calibPath)).
+   * @param[in] calibPath The camera intrinsics file.
+   * @param[in] prefetchOptions The prefetching options.
+   */
+  FeedProvider(const std::string &feedPath,
+               const std::string &calibPath,
+               const FeedPrefetchOptions &prefetchOptions);
   
   /**
    * @brief Provide a new RGB image from the feed.
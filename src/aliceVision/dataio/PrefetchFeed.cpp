@@ -0,0 +1,280 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "PrefetchFeed.hpp"
+#include <aliceVision/image/convertion.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace aliceVision{
+namespace dataio{
+
+namespace {
+
+// conversions of the decoded image to the type requested by the consumer,
+// the images of the same type are copied in the consumer buffer (reused if it has the same size)
+
+void convertImage(const image::Image<image::RGBColor>& in, image::Image<image::RGBColor>& out) { out = in; }
+void convertImage(const image::Image<float>& in, image::Image<float>& out) { out = in; }
+void convertImage(const image::Image<unsigned char>& in, image::Image<unsigned char>& out) { out = in; }
+
+void convertImage(const image::Image<image::RGBColor>& in, image::Image<unsigned char>& out)
+{
+  image::ConvertPixelType(in, &out);
+}
+
+void convertImage(const image::Image<unsigned char>& in, image::Image<image::RGBColor>& out)
+{
+  image::ConvertPixelType(in, &out);
+}
+
+void convertImage(const image::Image<unsigned char>& in, image::Image<float>& out)
+{
+  out = (in.GetMat().cast<float>() / 255.f);
+}
+
+void convertImage(const image::Image<float>& in, image::Image<unsigned char>& out)
+{
+  out = (in.GetMat() * 255.f).cast<unsigned char>();
+}
+
+void convertImage(const image::Image<image::RGBColor>& in, image::Image<float>& out)
+{
+  image::Image<unsigned char> imageGray;
+  convertImage(in, imageGray);
+  convertImage(imageGray, out);
+}
+
+void convertImage(const image::Image<float>& in, image::Image<image::RGBColor>& out)
+{
+  image::Image<unsigned char> imageGray;
+  convertImage(in, imageGray);
+  convertImage(imageGray, out);
+}
+
+template <typename ImageT, typename SlotT>
+void convertSlotImage(EFeedImageType imageType, const SlotT& slot, ImageT& out)
+{
+  switch(imageType)
+  {
+    case EFeedImageType::RGB:        convertImage(slot.imageRGB, out);       break;
+    case EFeedImageType::GRAY_FLOAT: convertImage(slot.imageGrayFloat, out); break;
+    case EFeedImageType::GRAY_UCHAR: convertImage(slot.imageGrayUChar, out); break;
+  }
+}
+
+} // namespace
+
+PrefetchFeed::PrefetchFeed(std::vector<std::unique_ptr<IFeed>> feeds, const FeedPrefetchOptions& options)
+  : _feeds(std::move(feeds))
+  , _imageType(options.imageType)
+  , _slots(std::max<std::size_t>(options.nbFrames, 1))
+{
+  if(_feeds.empty())
+    throw std::invalid_argument("Cannot prefetch the frames without a feed.");
+
+  _nbFrames = _feeds.front()->nbFrames();
+
+  if(!isInit())
+    return;
+
+  for(auto& feed : _feeds)
+  {
+    IFeed* decodedFeed = feed.get();
+    _threads.emplace_back([this, decodedFeed]() { decode(*decodedFeed); });
+  }
+}
+
+PrefetchFeed::~PrefetchFeed()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _slotFree.notify_all();
+  for(std::thread& thread : _threads)
+    thread.join();
+}
+
+bool PrefetchFeed::isInit() const
+{
+  return _feeds.front()->isInit();
+}
+
+void PrefetchFeed::decode(IFeed& feed)
+{
+  // the feeds start at the first frame
+  std::size_t feedFrame = 0;
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  while(true)
+  {
+    // wait for the slot of the next frame, at most nbSlots frames ahead of the consumer
+    _slotFree.wait(lock, [this]()
+    {
+      return _stop ||
+             (_nextFrame < _nbFrames &&
+              _nextFrame < _currentFrame + _slots.size() &&
+              _slots[_nextFrame % _slots.size()].state == ESlotState::FREE);
+    });
+    if(_stop)
+      return;
+
+    const std::size_t frame = _nextFrame++;
+    Slot& slot = _slots[frame % _slots.size()];
+    slot.state = ESlotState::DECODING;
+    slot.frame = frame;
+    slot.generation = _generation;
+    lock.unlock();
+
+    // the slot is owned by this thread until its state changes
+    bool isDecoded = (feedFrame == frame) || feed.goToFrame(frame);
+    if(isDecoded)
+    {
+      switch(_imageType)
+      {
+        case EFeedImageType::RGB:
+          isDecoded = feed.readImage(slot.imageRGB, slot.camIntrinsics, slot.mediaPath, slot.hasIntrinsics);
+          break;
+        case EFeedImageType::GRAY_FLOAT:
+          isDecoded = feed.readImage(slot.imageGrayFloat, slot.camIntrinsics, slot.mediaPath, slot.hasIntrinsics);
+          break;
+        case EFeedImageType::GRAY_UCHAR:
+          isDecoded = feed.readImage(slot.imageGrayUChar, slot.camIntrinsics, slot.mediaPath, slot.hasIntrinsics);
+          break;
+      }
+    }
+    feed.goToNextFrame();
+    feedFrame = frame + 1;
+
+    lock.lock();
+    // drop the frame if the consumer moved past it or seeked in the meantime
+    if(slot.generation == _generation && slot.frame >= _currentFrame)
+    {
+      slot.state = isDecoded ? ESlotState::READY : ESlotState::FAILED;
+      _frameReady.notify_all();
+    }
+    else
+    {
+      slot.state = ESlotState::FREE;
+      _slotFree.notify_all();
+    }
+  }
+}
+
+const PrefetchFeed::Slot* PrefetchFeed::waitCurrentFrame(camera::PinholeRadialK3 &camIntrinsics,
+                                                         std::string &mediaPath,
+                                                         bool &hasIntrinsics)
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  if(_currentFrame >= _nbFrames || !isInit())
+    return nullptr;
+
+  const Slot& slot = _slots[_currentFrame % _slots.size()];
+  _frameReady.wait(lock, [&]()
+  {
+    return slot.frame == _currentFrame &&
+           slot.generation == _generation &&
+           (slot.state == ESlotState::READY || slot.state == ESlotState::FAILED);
+  });
+
+  if(slot.state == ESlotState::FAILED)
+  {
+    ALICEVISION_LOG_WARNING("Cannot decode the frame " << _currentFrame << ".");
+    return nullptr;
+  }
+
+  // the slot is not modified until the consumer moves
+  camIntrinsics = slot.camIntrinsics;
+  mediaPath = slot.mediaPath;
+  hasIntrinsics = slot.hasIntrinsics;
+  return &slot;
+}
+
+bool PrefetchFeed::readImage(image::Image<image::RGBColor> &imageRGB,
+                             camera::PinholeRadialK3 &camIntrinsics,
+                             std::string &mediaPath,
+                             bool &hasIntrinsics)
+{
+  const Slot* slot = waitCurrentFrame(camIntrinsics, mediaPath, hasIntrinsics);
+  if(slot == nullptr)
+    return false;
+  convertSlotImage(_imageType, *slot, imageRGB);
+  return true;
+}
+
+bool PrefetchFeed::readImage(image::Image<float> &imageGray,
+                             camera::PinholeRadialK3 &camIntrinsics,
+                             std::string &mediaPath,
+                             bool &hasIntrinsics)
+{
+  const Slot* slot = waitCurrentFrame(camIntrinsics, mediaPath, hasIntrinsics);
+  if(slot == nullptr)
+    return false;
+  convertSlotImage(_imageType, *slot, imageGray);
+  return true;
+}
+
+bool PrefetchFeed::readImage(image::Image<unsigned char> &imageGray,
+                             camera::PinholeRadialK3 &camIntrinsics,
+                             std::string &mediaPath,
+                             bool &hasIntrinsics)
+{
+  const Slot* slot = waitCurrentFrame(camIntrinsics, mediaPath, hasIntrinsics);
+  if(slot == nullptr)
+    return false;
+  convertSlotImage(_imageType, *slot, imageGray);
+  return true;
+}
+
+std::size_t PrefetchFeed::nbFrames() const
+{
+  return _nbFrames;
+}
+
+bool PrefetchFeed::goToFrame(const unsigned int frame)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    // drop the prefetched frames, the frames being decoded are dropped by their thread
+    ++_generation;
+    for(Slot& slot : _slots)
+    {
+      if(slot.state != ESlotState::DECODING)
+        slot.state = ESlotState::FREE;
+    }
+    _currentFrame = frame;
+    _nextFrame = frame;
+  }
+  _slotFree.notify_all();
+
+  if(frame >= _nbFrames)
+  {
+    ALICEVISION_LOG_WARNING("The current frame is out of the range.");
+    return false;
+  }
+  return true;
+}
+
+bool PrefetchFeed::goToNextFrame()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Slot& slot = _slots[_currentFrame % _slots.size()];
+    if(slot.frame == _currentFrame && slot.generation == _generation &&
+       (slot.state == ESlotState::READY || slot.state == ESlotState::FAILED))
+      slot.state = ESlotState::FREE;
+    ++_currentFrame;
+  }
+  _slotFree.notify_all();
+
+  return _currentFrame < _nbFrames;
+}
+
+}//namespace dataio
+}//namespace aliceVision
@@ -0,0 +1,151 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "IFeed.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aliceVision{
+namespace dataio{
+
+/**
+ * @brief Image type decoded by the prefetching threads
+ */
+enum class EFeedImageType
+{
+  RGB,
+  GRAY_FLOAT,
+  GRAY_UCHAR
+};
+
+/**
+ * @brief Prefetching options of a feed
+ */
+struct FeedPrefetchOptions
+{
+  /// number of frames decoded ahead (size of the ring buffer), 0 to disable the prefetching
+  std::size_t nbFrames = 8;
+  /// number of decode threads (a video is always decoded by a single thread)
+  std::size_t nbThreads = 1;
+  /// image type decoded by the threads, the other types are converted when they are read
+  EFeedImageType imageType = EFeedImageType::RGB;
+};
+
+/**
+ * @brief Feed decoding the next frames of other feeds in background threads.
+ *
+ * The decoded frames are stored in a bounded ring buffer whose slots (and their image buffers)
+ * are reused from frame to frame. Each decode thread owns a feed on the same media, so that
+ * the frames of an image sequence are decoded in parallel; the frames are still provided
+ * in order. A seek (goToFrame) drops the prefetched frames and restarts the decoding
+ * from the new position.
+ * The feed is used by a single consumer thread, like the other feeds.
+ */
+class PrefetchFeed : public IFeed
+{
+public:
+  /**
+   * @param[in] feeds the feeds on the same media, one per decode thread, at their first frame
+   * @param[in] options the prefetching options (options.nbThreads is ignored)
+   */
+  PrefetchFeed(std::vector<std::unique_ptr<IFeed>> feeds, const FeedPrefetchOptions& options);
+
+  PrefetchFeed(const PrefetchFeed&) = delete;
+  PrefetchFeed& operator=(const PrefetchFeed&) = delete;
+
+  bool isInit() const override;
+
+  bool readImage(image::Image<image::RGBColor> &imageRGB,
+                 camera::PinholeRadialK3 &camIntrinsics,
+                 std::string &mediaPath,
+                 bool &hasIntrinsics) override;
+
+  bool readImage(image::Image<float> &imageGray,
+                 camera::PinholeRadialK3 &camIntrinsics,
+                 std::string &mediaPath,
+                 bool &hasIntrinsics) override;
+
+  bool readImage(image::Image<unsigned char> &imageGray,
+                 camera::PinholeRadialK3 &camIntrinsics,
+                 std::string &mediaPath,
+                 bool &hasIntrinsics) override;
+
+  std::size_t nbFrames() const override;
+
+  bool goToFrame(const unsigned int frame) override;
+
+  bool goToNextFrame() override;
+
+  ~PrefetchFeed() override;
+
+private:
+  enum class ESlotState
+  {
+    FREE,
+    DECODING,
+    READY,
+    FAILED
+  };
+
+  struct Slot
+  {
+    ESlotState state = ESlotState::FREE;
+    std::size_t frame = 0;
+    std::size_t generation = 0;
+    image::Image<image::RGBColor> imageRGB;
+    image::Image<float> imageGrayFloat;
+    image::Image<unsigned char> imageGrayUChar;
+    camera::PinholeRadialK3 camIntrinsics;
+    std::string mediaPath;
+    bool hasIntrinsics = false;
+  };
+
+  /**
+   * @brief Decode loop of a thread
+   * @param[in] feed the feed of the thread
+   */
+  void decode(IFeed& feed);
+
+  /**
+   * @brief Wait for the current frame
+   * @return the slot of the current frame, nullptr if there is no more frame
+   * or if it cannot be decoded
+   */
+  const Slot* waitCurrentFrame(camera::PinholeRadialK3 &camIntrinsics,
+                               std::string &mediaPath,
+                               bool &hasIntrinsics);
+
+  std::vector<std::unique_ptr<IFeed>> _feeds;
+  EFeedImageType _imageType;
+  std::size_t _nbFrames;
+
+  std::vector<Slot> _slots;
+  /// frame provided to the consumer
+  std::size_t _currentFrame = 0;
+  /// next frame to decode
+  std::size_t _nextFrame = 0;
+  /// incremented by each seek, to drop the frames decoded before it
+  std::size_t _generation = 0;
+  bool _stop = false;
+
+  std::mutex _mutex;
+  /// a decoded frame is ready
+  std::condition_variable _frameReady;
+  /// a slot is free or the consumer moved
+  std::condition_variable _slotFree;
+  std::vector<std::thread> _threads;
+};
+
+}//namespace dataio
+}//namespace aliceVision
@@ -116,6 +116,12 @@ public:
    */
   virtual void setCudaPipe(int pipe) {}
 
+  /**
+   * @brief Set the size of the tiles used to process large images
+   * @param[in] tileSize The tile size in pixels (0 to disable the tiling)
+   */
+  virtual void setTileSize(std::size_t tileSize) {}
+
   /**
    * @brief Use a preset to control the number of detected regions
    * @param[in] preset The preset configuration
@@ -15,6 +15,7 @@
 
 #include <string>
 #include <cstddef>
+#include <cstring>
 #include <typeinfo>
 #include <memory>
 
@@ -97,6 +98,25 @@ public:
    */
   virtual const void * DescriptorRawData() const = 0;
 
+  /**
+   * @brief Return a pointer to the first feature of the feature array.
+   *
+   * @note: Features are always stored as a flat array of features.
+   */
+  virtual const void * FeatureRawData() const = 0;
+
+  /// Return the size in bytes of a feature in the raw feature array
+  virtual std::size_t FeatureRawSize() const = 0;
+
+  /// Return the size in bytes of a descriptor in the raw descriptor array
+  virtual std::size_t DescriptorRawSize() const = 0;
+
+  /**
+   * @brief Replace the regions by a copy of raw features and descriptors arrays,
+   * as given by FeatureRawData() and DescriptorRawData().
+   */
+  virtual void LoadRaw(const void* featuresRawData, const void* descriptorsRawData, std::size_t count) = 0;
+
   virtual void clearDescriptors() = 0;
 
   /// Return the squared distance between two descriptors
@@ -152,6 +172,10 @@ public:
   /// Return the number of defined regions
   std::size_t RegionCount() const {return _vec_feats.size();}
 
+  const void* FeatureRawData() const override { return _vec_feats.data(); }
+
+  std::size_t FeatureRawSize() const override { return sizeof(FeatureT); }
+
   /// Mutable and non-mutable FeatureT getters.
   inline std::vector<FeatureT> & Features() { return _vec_feats; }
   inline const std::vector<FeatureT> & Features() const { return _vec_feats; }
@@ -247,6 +271,18 @@ public:
 
   inline const void* DescriptorRawData() const override { return &_vec_descs[0];}
 
+  std::size_t DescriptorRawSize() const override { return sizeof(DescriptorT); }
+
+  void LoadRaw(const void* featuresRawData, const void* descriptorsRawData, std::size_t count) override
+  {
+    this->_vec_feats.resize(count);
+    _vec_descs.resize(count);
+    if(count == 0)
+      return;
+    std::memcpy(this->_vec_feats.data(), featuresRawData, count * sizeof(FeatT));
+    std::memcpy(_vec_descs.data(), descriptorsRawData, count * sizeof(DescriptorT));
+  }
+
   inline void clearDescriptors() override { _vec_descs.clear(); }
 
   inline void swap(This& other)
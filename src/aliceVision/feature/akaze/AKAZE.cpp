@@ -33,24 +33,179 @@ inline float Sigma( const float sigma0 , const int p , const int q , const int Q
     return sigma0 * powf( 2.f , p + static_cast<float>( q ) / static_cast<float>( Q ) ) ;
 }
 
+namespace {
+
+/// Center weight of the Scharr smoothing kernel [1, 10/3, 1]
+const float scharrWeight = 10.f / 3.f;
+
+/// Normalization of the scaled Scharr derivatives: 1 / (2 * scale * (scharrWeight + 2))
+inline float scaledScharrFactor(int scale)
+{
+  return 1.f / (2.f * scale * (scharrWeight + 2.f));
+}
+
+/**
+ * @brief Mirror an index into [0, size[ (same borders as image::SeparableConvolution2d)
+ */
+inline int mirrorIndex(int i, int size)
+{
+  if(size == 1)
+    return 0;
+  const int period = 2 * size - 2;
+  i %= period;
+  if(i < 0)
+    i += period;
+  return (i < size) ? i : period - i;
+}
+
+/**
+ * @brief Rows and columns used by the Scharr stencils of scale s at a pixel: (i - s, i, i + s) and (j - s, j + s)
+ * The scaled Scharr kernels have only 3 non-zero taps per direction: they are applied as sparse stencils
+ * instead of (2 * scale + 1) taps separable convolutions.
+ */
+struct ScharrStencil
+{
+  const float* up;
+  const float* center;
+  const float* down;
+  int left;
+  int right;
+
+  ScharrStencil(const Image<float>& img, int i, int scale)
+    : up(img.data() + std::size_t(mirrorIndex(i - scale, img.Height())) * img.Width())
+    , center(img.data() + std::size_t(i) * img.Width())
+    , down(img.data() + std::size_t(mirrorIndex(i + scale, img.Height())) * img.Width())
+  {}
+
+  void setColumn(int j, int scale, int width)
+  {
+    left = (j >= scale) ? j - scale : mirrorIndex(j - scale, width);
+    right = (j + scale < width) ? j + scale : mirrorIndex(j + scale, width);
+  }
+
+  /// Non normalized Scharr X derivative
+  float dx() const
+  {
+    return (up[right] - up[left]) + scharrWeight * (center[right] - center[left]) + (down[right] - down[left]);
+  }
+
+  /// Non normalized Scharr Y derivative
+  float dy(int j) const
+  {
+    return (down[left] - up[left]) + scharrWeight * (down[j] - up[j]) + (down[right] - up[right]);
+  }
+};
+
+/**
+ * @brief Call function(i, j, dx, dy) with the Scharr derivatives of each pixel (multiplied by factor), rows in parallel
+ */
+template <typename Function>
+void forEachScharrDerivatives(const Image<float>& src, int scale, float factor, Function function)
+{
+  const int width = src.Width();
+  const int height = src.Height();
+
+  #pragma omp parallel for
+  for(int i = 0; i < height; ++i)
+  {
+    ScharrStencil stencil(src, i, scale);
+    for(int j = 0; j < width; ++j)
+    {
+      stencil.setColumn(j, scale, width);
+      function(i, j, factor * stencil.dx(), factor * stencil.dy(j));
+    }
+  }
+}
+
+/**
+ * @brief Perona and Malik G2 diffusion coefficients from the (non normalized) Scharr derivatives of an image
+ * Fuses the derivatives and ImagePeronaMalikG2DiffusionCoef: the derivatives images are not stored.
+ */
+void computePeronaMalikG2Diffusivity(const Image<float>& smoothed, float k, Image<float>& diffusivity)
+{
+  diffusivity.resize(smoothed.Width(), smoothed.Height());
+  const float invSquaredK = 1.f / (k * k);
+
+  // ImageScharrXDerivative(false) uses the kernel [3, 10, 3]
+  forEachScharrDerivatives(smoothed, 1, 3.f, [&](int i, int j, float dx, float dy)
+  {
+    diffusivity(i, j) = 1.f / (1.f + (dx * dx + dy * dy) * invSquaredK);
+  });
+}
+
+/**
+ * @brief Scaled Scharr first derivatives, multiplied by the scale (as used by the descriptors)
+ */
+void computeScaledDerivatives(const Image<float>& smoothed, int scale, Image<float>& Lx, Image<float>& Ly)
+{
+  Lx.resize(smoothed.Width(), smoothed.Height());
+  Ly.resize(smoothed.Width(), smoothed.Height());
+
+  forEachScharrDerivatives(smoothed, scale, scale * scaledScharrFactor(scale), [&](int i, int j, float dx, float dy)
+  {
+    Lx(i, j) = dx;
+    Ly(i, j) = dy;
+  });
+}
+
+/**
+ * @brief Scale normalized determinant of the Hessian from the first derivatives
+ * The second derivatives (Lxx, Lxy, Lyy) are computed and combined in a single pass.
+ * @param Lx, Ly first derivatives multiplied by the scale (see computeScaledDerivatives)
+ */
+void computeHessianDeterminant(const Image<float>& Lx, const Image<float>& Ly, int scale, Image<float>& Lhess)
+{
+  const int width = Lx.Width();
+  const int height = Lx.Height();
+  const float factor = scaledScharrFactor(scale);
+  // the first derivatives are already multiplied by the scale: scale^4 becomes scale^2
+  const float determinantScale = Square(scale);
+
+  Lhess.resize(width, height);
+
+  #pragma omp parallel for
+  for(int i = 0; i < height; ++i)
+  {
+    ScharrStencil stencilX(Lx, i, scale);
+    ScharrStencil stencilY(Ly, i, scale);
+    for(int j = 0; j < width; ++j)
+    {
+      stencilX.setColumn(j, scale, width);
+      stencilY.left = stencilX.left;
+      stencilY.right = stencilX.right;
+
+      const float Lxx = factor * stencilX.dx();
+      const float Lxy = factor * stencilX.dy(j);
+      const float Lyy = factor * stencilY.dy(j);
+      Lhess(i, j) = (Lxx * Lyy - Lxy * Lxy) * determinantScale;
+    }
+  }
+}
+
+} // namespace
+
 float AKAZE::ComputeAutomaticContrastFactor( const Image<float> & src , const float percentile )
 {
   const size_t nb_bin = 300 ;
   const int height = src.Height() ;
   const int width = src.Width() ;
 
+  // Temporary images are taken from the image pool of the thread
+  ImagePool<float> & pool = ImagePool<float>::local() ;
+
   // Smooth the image
   Image<float> smoothed ;
+  pool.resize( smoothed , width , height ) ;
   ImageGaussianFilter( src , 1.f , smoothed , 0, 0) ;
 
-  // Compute gradient
-  Image<float> Lx, Ly ;
-  ImageScharrXDerivative( smoothed , Lx , false ) ;
-  ImageScharrYDerivative( smoothed , Ly , false ) ;
-
-  Image<float> & grad = smoothed; // reuse smoothed to avoid new allocation
-  // grad = sqrt(Lx^2 + Ly^2)
-  grad.array() = (Lx.array().square() + Ly.array().square()).sqrt();
+  // Compute gradient: grad = sqrt(Lx^2 + Ly^2), Scharr derivatives (non normalized)
+  Image<float> grad ;
+  pool.resize( grad , width , height ) ;
+  forEachScharrDerivatives( smoothed , 1 , 3.f , [&grad]( int i , int j , float dx , float dy )
+  {
+    grad( i , j ) = std::sqrt( dx * dx + dy * dy ) ;
+  }) ;
+  pool.release( smoothed ) ;
   const float grad_max = grad.maxCoeff();
 
   // Compute histogram
@@ -79,6 +234,8 @@ float AKAZE::ComputeAutomaticContrastFactor( const Image<float> & src , const fl
     }
   }
 
+  pool.release( grad ) ;
+
   const size_t search_id = percentile * static_cast<float>(nb_value) ;
 
   int id_bin = 0 ;
@@ -108,13 +265,14 @@ void AKAZE::ComputeAKAZESlice( const Image<float> & src , const int p , const in
                         Image<float> & Li , // Diffusion image
                         Image<float> & Lx , // X derivatives
                         Image<float> & Ly , // Y derivatives
-                        Image<float> & Lhess ) // Det(Hessian)
+                        Image<float> & Lhess , // Det(Hessian)
+                        TSliceWorkspace & workspace ) // Temporary images
 {
   const float sigma_cur = Sigma( sigma0 , p , q , nbSlice );
   const float ratio = 1 << p; //pow(2,p);
   const int sigma_scale = MathTrait<float>::round(sigma_cur * fderivative_factor / ratio);
 
-  Image<float> smoothed;
+  Image<float> & smoothed = workspace.smoothed;
   if( p == 0 && q == 0 )
   {
     // Compute new image
@@ -123,12 +281,11 @@ void AKAZE::ComputeAKAZESlice( const Image<float> & src , const int p , const in
   else
   {
     // general case
-    Image<float> in ;
     if( q == 0 )  {
-      ImageHalfSample( src , in ) ;
+      ImageHalfSample( src , Li ) ;
     }
     else {
-      in = src ;
+      Li = src ;
     }
 
     const float sigma_prev = ( q == 0 ) ? Sigma( sigma0 , p - 1 , nbSlice - 1 , nbSlice ) : Sigma( sigma0 , p , q - 1 , nbSlice ) ;
@@ -138,51 +295,28 @@ void AKAZE::ComputeAKAZESlice( const Image<float> & src , const int p , const in
     const float t_cur  = 0.5f * ( sigma_cur * sigma_cur ) ;
     const float total_cycle_time = t_cur - t_prev ;
 
-    // Compute first derivatives (Scharr scale 1, non normalized) for diffusion coef
-    ImageGaussianFilter( in , 1.f , smoothed, 0, 0 ) ;
-
-    ImageScharrXDerivative( smoothed , Lx , false ) ;
-    ImageScharrYDerivative( smoothed , Ly , false ) ;
+    // Compute diffusion coefficient from the first derivatives (Scharr scale 1, non normalized)
+    ImageGaussianFilter( Li , 1.f , smoothed, 0, 0 ) ;
+    computePeronaMalikG2Diffusivity( smoothed , contrast_factor , workspace.diffusivity ) ;
 
-    // Compute diffusion coefficient
-    Image<float> & diff = smoothed; // diffusivity image (reuse existing memory)
-    ImagePeronaMalikG2DiffusionCoef( Lx , Ly , contrast_factor , diff ) ;
-
-    // Compute FED cycles
+    // Compute FED cycles (Li is the evolution image)
     std::vector< float > tau ;
     FEDCycleTimings( total_cycle_time , 0.25f , tau ) ;
-    ImageFEDCycle( in , diff , tau ) ;
-    Li = in ; // evolution image
+    ImageFEDCycle( Li , workspace.diffusivity , tau , workspace.fedBuffer ) ;
   }
 
   // Compute Hessian response
-  if( p == 0 && q == 0 )
-  {
-    smoothed = Li ;
-  }
-  else
+  if( !( p == 0 && q == 0 ) )
   {
     // Add a little smooth to image (for robustness of Scharr derivatives)
     ImageGaussianFilter( Li , 1.f , smoothed, 0, 0 );
   }
 
-  // Compute true first derivatives
-  ImageScaledScharrXDerivative( smoothed , Lx , sigma_scale ) ;
-  ImageScaledScharrYDerivative( smoothed , Ly , sigma_scale ) ;
-
-  // Second order spatial derivatives
-  Image<float> Lxx, Lyy, Lxy;
-  ImageScaledScharrXDerivative( Lx , Lxx , sigma_scale ) ;
-  ImageScaledScharrYDerivative( Lx , Lxy , sigma_scale ) ;
-  ImageScaledScharrYDerivative( Ly , Lyy , sigma_scale ) ;
+  // Compute true first derivatives (multiplied by the scale)
+  computeScaledDerivatives( ( p == 0 && q == 0 ) ? Li : smoothed , sigma_scale , Lx , Ly ) ;
 
-  Lx *= static_cast<float>( sigma_scale ) ;
-  Ly *= static_cast<float>( sigma_scale ) ;
-
-  // Compute Determinant of the Hessian
-  Lhess.resize(Li.Width(), Li.Height());
-  const float sigma_size_quad = Square(sigma_scale) * Square(sigma_scale);
-  Lhess.array() = (Lxx.array()*Lyy.array()-Lxy.array().square())*sigma_size_quad;
+  // Compute Determinant of the Hessian from the second order spatial derivatives
+  computeHessianDeterminant( Lx , Ly , sigma_scale , Lhess ) ;
 }
 
 template <typename Image>
@@ -195,36 +329,76 @@ void convert_scale(Image &src)
 
 /// Constructor with input arguments
 AKAZE::AKAZE(const Image<float> & in, const AKAZEConfig & options):
-    in_(in),
     options_(options)
 {
+  ImagePool<float>::local().resize(in_, in.Width(), in.Height());
+  in_ = in;
   options_.fDesc_factor = std::max(6.f*sqrtf(2.f), options_.fDesc_factor);
   //-- Safety check to limit the computable octave count
   const int nbOctaveMax = ceil(std::log2( std::min(in_.Width(), in_.Height())));
   options_.iNbOctave = std::min(options_.iNbOctave, nbOctaveMax);
 }
 
+/// Destructor: the images go back to the image pool of the thread
+AKAZE::~AKAZE()
+{
+  ImagePool<float> & pool = ImagePool<float>::local();
+  pool.release(in_);
+  releaseSlices();
+}
+
+/// Give the scale space images back to the image pool of the thread
+void AKAZE::releaseSlices()
+{
+  ImagePool<float> & pool = ImagePool<float>::local();
+  for( TEvolution & evo : evolution_ )
+  {
+    pool.release( evo.cur );
+    pool.release( evo.Lx );
+    pool.release( evo.Ly );
+    pool.release( evo.Lhess );
+  }
+  evolution_.clear();
+}
+
 /// Compute the AKAZE non linear diffusion scale space per slice
 void AKAZE::Compute_AKAZEScaleSpace(void)
 {
   float contrast_factor = ComputeAutomaticContrastFactor( in_, 0.7f ) ;
-  Image<float> input = in_;
+
+  // Each slice is computed from the previous one
+  releaseSlices();
+  evolution_.resize( options_.iNbOctave * options_.iNbSlicePerOctave );
+  TSliceWorkspace workspace;
+  ImagePool<float> & pool = ImagePool<float>::local();
+  int width = in_.Width();
+  int height = in_.Height();
 
   // Octave computation
   for( int p = 0 ; p < options_.iNbOctave ; ++p )
   {
     contrast_factor *= (p == 0) ? 1.f : 0.75f;
+    if( p > 0 )
+    {
+      // octave size, see ImageHalfSample
+      width /= 2;
+      height /= 2;
+    }
 
     for( int q = 0 ; q < options_.iNbSlicePerOctave ; ++q )
     {
-      evolution_.emplace_back(TEvolution());
-      TEvolution & evo = evolution_.back();
+      const int sliceId = p * options_.iNbSlicePerOctave + q;
+      TEvolution & evo = evolution_[sliceId];
+      const Image<float> & input = ( sliceId == 0 ) ? in_ : evolution_[sliceId - 1].cur;
+
+      // Slice and temporary images are drawn from the pool, the computations keep their buffers
+      for( Image<float> * image : { &evo.cur , &evo.Lx , &evo.Ly , &evo.Lhess ,
+                                    &workspace.smoothed , &workspace.diffusivity , &workspace.fedBuffer } )
+        pool.resize( *image , width , height );
+
       // Compute Slice at (p,q) index
       ComputeAKAZESlice( input , p , q , options_.iNbSlicePerOctave , options_.fSigma0 , contrast_factor,
-        evo.cur , evo.Lx , evo.Ly , evo.Lhess );
-
-      // Prepare inputs for next slice
-      input = evo.cur;
+        evo.cur , evo.Lx , evo.Ly , evo.Lhess , workspace );
 
       // DEBUG octave image
 #if DEBUG_OCTAVE
@@ -237,6 +411,10 @@ void AKAZE::Compute_AKAZEScaleSpace(void)
 #endif // DEBUG_OCTAVE
     }
   }
+
+  pool.release( workspace.smoothed );
+  pool.release( workspace.diffusivity );
+  pool.release( workspace.fedBuffer );
 }
 
 void detectDuplicates(
@@ -268,46 +446,46 @@ void AKAZE::Feature_Detection(std::vector<AKAZEKeypoint>& kpts) const
 {
   std::vector< std::vector< std::pair<AKAZEKeypoint, bool> > > vec_kpts_perSlice(options_.iNbOctave*options_.iNbSlicePerOctave);
 
+  // one task per slice
   #pragma omp parallel for schedule(dynamic)
-  for( int p = 0 ; p < options_.iNbOctave ; ++p )
+  for( int sliceId = 0 ; sliceId < static_cast<int>(vec_kpts_perSlice.size()) ; ++sliceId )
   {
+    const int p = sliceId / options_.iNbSlicePerOctave;
+    const int q = sliceId % options_.iNbSlicePerOctave;
     const float ratio = (float) (1 << p);
 
-    for( int q = 0 ; q < options_.iNbSlicePerOctave ; ++q )
-    {
-      const float sigma_cur = Sigma( options_.fSigma0 , p , q , options_.iNbSlicePerOctave ) ;
-      const Image<float> & LDetHess = evolution_[options_.iNbOctave * p + q].Lhess;
-
-      // Check that the point is under the image limits for the descriptor computation
-      const float borderLimit =
-        MathTrait<float>::round(options_.fDesc_factor*sigma_cur*fderivative_factor/ratio)+1;
-
-      for (int jx = borderLimit; jx < LDetHess.Height()-borderLimit; ++jx)
-      for (int ix = borderLimit; ix < LDetHess.Width()-borderLimit; ++ix) {
-
-        const float value = LDetHess(jx, ix);
-
-        // Filter the points with the detector threshold
-        if (value > options_.fThreshold &&
-          value > LDetHess(jx-1, ix) &&
-          value > LDetHess(jx-1, ix+1) &&
-          value > LDetHess(jx-1, ix-1) &&
-          value > LDetHess(jx  , ix-1) &&
-          value > LDetHess(jx  , ix+1) &&
-          value > LDetHess(jx+1, ix-1) &&
-          value > LDetHess(jx+1, ix) &&
-          value > LDetHess(jx+1, ix+1))
-        {
-          AKAZEKeypoint point;
-          point.size = sigma_cur * fderivative_factor ;
-          point.octave = p;
-          point.response = fabs(value);
-          point.x = ix * ratio + 0.5 * (ratio-1);
-          point.y = jx * ratio + 0.5 * (ratio-1);
-          point.angle = 0.0f;
-          point.class_id = p * options_.iNbSlicePerOctave + q;
-          vec_kpts_perSlice[options_.iNbOctave * p + q].emplace_back( point,false );
-        }
+    const float sigma_cur = Sigma( options_.fSigma0 , p , q , options_.iNbSlicePerOctave ) ;
+    const Image<float> & LDetHess = evolution_[sliceId].Lhess;
+
+    // Check that the point is under the image limits for the descriptor computation
+    const float borderLimit =
+      MathTrait<float>::round(options_.fDesc_factor*sigma_cur*fderivative_factor/ratio)+1;
+
+    for (int jx = borderLimit; jx < LDetHess.Height()-borderLimit; ++jx)
+    for (int ix = borderLimit; ix < LDetHess.Width()-borderLimit; ++ix) {
+
+      const float value = LDetHess(jx, ix);
+
+      // Filter the points with the detector threshold
+      if (value > options_.fThreshold &&
+        value > LDetHess(jx-1, ix) &&
+        value > LDetHess(jx-1, ix+1) &&
+        value > LDetHess(jx-1, ix-1) &&
+        value > LDetHess(jx  , ix-1) &&
+        value > LDetHess(jx  , ix+1) &&
+        value > LDetHess(jx+1, ix-1) &&
+        value > LDetHess(jx+1, ix) &&
+        value > LDetHess(jx+1, ix+1))
+      {
+        AKAZEKeypoint point;
+        point.size = sigma_cur * fderivative_factor ;
+        point.octave = p;
+        point.response = fabs(value);
+        point.x = ix * ratio + 0.5 * (ratio-1);
+        point.y = jx * ratio + 0.5 * (ratio-1);
+        point.angle = 0.0f;
+        point.class_id = p * options_.iNbSlicePerOctave + q;
+        vec_kpts_perSlice[sliceId].emplace_back( point,false );
       }
     }
   }
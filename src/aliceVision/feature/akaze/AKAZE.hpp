@@ -87,6 +87,15 @@ struct TEvolution
     Lhess;  ///< Current Determinant of Hessian
 };
 
+/// Temporary images of the slice computation, reused from one slice to the next
+struct TSliceWorkspace
+{
+  image::Image<float>
+    smoothed,     ///< Gaussian smoothed image
+    diffusivity,  ///< Diffusion coefficients
+    fedBuffer;    ///< FED step output
+};
+
 // AKAZE Class Declaration
 class AKAZE {
 
@@ -96,11 +105,17 @@ private:
   std::vector<TEvolution> evolution_;	///< Vector of nonlinear diffusion evolution (Scale Space)
   image::Image<float> in_;            ///< Input image
 
+  /// Give the scale space images back to the image pool of the thread
+  void releaseSlices();
+
 public:
 
   /// Constructor
   AKAZE(const image::Image<float> & in, const AKAZEConfig & options);
 
+  /// Destructor
+  ~AKAZE();
+
   /// Compute the AKAZE non linear diffusion scale space per slice
   void Compute_AKAZEScaleSpace(void);
 
@@ -138,7 +153,8 @@ public:
     image::Image<float> & Li, // Diffusion image
     image::Image<float> & Lx, // X derivatives
     image::Image<float> & Ly, // Y derivatives
-    image::Image<float> & Lhess // Det(Hessian)
+    image::Image<float> & Lhess, // Det(Hessian)
+    TSliceWorkspace & workspace // Temporary images
     );
 
   /// Compute Contrast Factor
@@ -90,6 +90,15 @@ public:
     _isOriented = !upRight;
   }
 
+  /**
+   * @brief Set the size of the tiles used to process large images
+   * @param[in] tileSize The tile size in pixels (0 to disable the tiling)
+   */
+  void setTileSize(std::size_t tileSize) override
+  {
+    _params._tileSize = tileSize;
+  }
+
   /**
    * @brief Use a preset to control the number of detected regions
    * @param[in] preset The preset configuration
@@ -5,31 +5,231 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "SIFT.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <cmath>
 
 namespace aliceVision {
 namespace feature {
 
 int VLFeatInstance::nbInstances = 0;
 
+namespace {
+
+/**
+ * @brief Memory needed by the VLFeat buffers of a SIFT pyramid
+ * @param[in] scaleFactor The scale of the first octave relatively to the input image
+ */
+std::size_t getPyramidMemoryConsumption(std::size_t width, std::size_t height, double scaleFactor, int numOctaves, int numScales)
+{
+  std::size_t fullImgSize = width * height * scaleFactor * scaleFactor;
+
+  std::size_t pyramidMemoryConsuption = 0;
+  double downscale = 1.0;
+  for(int octave = 0; octave < numOctaves; ++octave)
+  {
+    pyramidMemoryConsuption += fullImgSize / (downscale*downscale);
+    downscale *= 2.0;
+  }
+  pyramidMemoryConsuption *= numScales * sizeof(float);
+
+  return 4 * pyramidMemoryConsuption;
+}
+
+/**
+ * @brief Radius (in pixels of the input image) of the image area used to detect
+ * and describe the keypoints of the given octave.
+ */
+int getSIFTOctaveSupport(int octave, int numScales)
+{
+  // largest keypoint scale: detection up to the level (numScales - 1), refined by half a level
+  const double sigma = 1.6 * std::pow(2.0, octave + (numScales + 0.5) / numScales);
+  // descriptor window radius (magnif * sqrt(2) * (NBP + 1) / 2) and gaussian smoothing support
+  return static_cast<int>(std::ceil((3.0 * std::sqrt(2.0) * 2.5 + 4.0) * sigma));
+}
+
+} // namespace
+
 std::size_t getMemoryConsumptionVLFeat(std::size_t width, std::size_t height, const SiftParams& params)
 {
+  const std::size_t descriptorsMemory = params._maxTotalKeypoints * 128 * sizeof(float);
+
+  int lastTileOctave = 0;
+  std::vector<SiftTile> tiles;
+  if(computeSIFTTiling(width, height, params, lastTileOctave, tiles))
+  {
+    // tiles processed in parallel, each one with its own keypoint budget
+    const std::size_t nbParallelTiles = std::min(tiles.size(), static_cast<std::size_t>(omp_get_max_threads()));
+    std::size_t tileWidth = 0;
+    std::size_t tileHeight = 0;
+    for(const SiftTile& tile : tiles)
+    {
+      tileWidth = std::max(tileWidth, static_cast<std::size_t>(tile.x1 - tile.x0));
+      tileHeight = std::max(tileHeight, static_cast<std::size_t>(tile.y1 - tile.y0));
+    }
+    const std::size_t tileMemory = getPyramidMemoryConsumption(tileWidth, tileHeight, std::pow(2.0, -params._firstOctave), lastTileOctave - params._firstOctave + 1, params._numScales)
+                                   + (tileWidth * tileHeight * sizeof(float)) + 2 * descriptorsMemory;
+
+    const int lastOctave = params._firstOctave + params._numOctaves - 1;
+    const std::size_t coarseMemory = (lastTileOctave < lastOctave) ? getPyramidMemoryConsumption(width, height, std::pow(2.0, -(lastTileOctave + 1)), lastOctave - lastTileOctave, params._numScales) : 0;
+
+    return nbParallelTiles * tileMemory + coarseMemory + (3 * width * height * sizeof(float)) + 4 * descriptorsMemory;
+  }
+
   double scaleFactor = 1.0;
   if(params._firstOctave > 0)
     scaleFactor = 1.0/params._firstOctave;
   else if(params._firstOctave < 0)
     scaleFactor = 2.0 * -params._firstOctave;
-  std::size_t fullImgSize = width * height * scaleFactor * scaleFactor;
 
-  std::size_t pyramidMemoryConsuption = 0;
-  double downscale = 1.0;
-  for(int octave = 0; octave < params._numOctaves; ++octave)
+  return getPyramidMemoryConsumption(width, height, scaleFactor, params._numOctaves, params._numScales) + (3 * width * height * sizeof(float)) + descriptorsMemory;
+}
+
+bool computeSIFTTiling(std::size_t width, std::size_t height, const SiftParams& params, int& lastTileOctave, std::vector<SiftTile>& tiles)
+{
+  tiles.clear();
+
+  // the octaves below -1 are not supported by the tiling
+  if(params._tileSize == 0 || params._firstOctave < -1 || (width <= params._tileSize && height <= params._tileSize))
+    return false;
+
+  // the margin of the tiles must stay small compared to the tile size
+  const int lastOctave = params._firstOctave + params._numOctaves - 1;
+  lastTileOctave = params._firstOctave - 1;
+  while(lastTileOctave < lastOctave && 4 * getSIFTOctaveSupport(lastTileOctave + 1, params._numScales) <= params._tileSize)
+    ++lastTileOctave;
+
+  if(lastTileOctave < params._firstOctave)
   {
-    pyramidMemoryConsuption += fullImgSize / (downscale*downscale);
-    downscale *= 2.0;
+    ALICEVISION_LOG_WARNING("SIFT tile size is too small (" << params._tileSize << " px), extraction on the whole image.");
+    return false;
+  }
+
+  // align the tiles on the pixel grid of the first coarse octave to sample the octaves as on the whole image,
+  // and on 4 pixels in all the tile octaves so that VLFeat uses the same SSE2 code path as on the whole image
+  const int alignment = 4 << (lastTileOctave + 1);
+  const auto alignUp = [alignment](std::size_t value) { return static_cast<int>((value + alignment - 1) / alignment * alignment); };
+  const int tileSize = alignUp(params._tileSize);
+  const int margin = alignUp(getSIFTOctaveSupport(lastTileOctave, params._numScales));
+  const int w = static_cast<int>(width);
+  const int h = static_cast<int>(height);
+
+  for(int y = 0; y < h; y += tileSize)
+  {
+    for(int x = 0; x < w; x += tileSize)
+    {
+      SiftTile tile;
+      tile.coreX0 = x;
+      tile.coreY0 = y;
+      tile.coreX1 = std::min(x + tileSize, w);
+      tile.coreY1 = std::min(y + tileSize, h);
+      tile.x0 = std::max(x - margin, 0);
+      tile.y0 = std::max(y - margin, 0);
+      tile.x1 = std::min(tile.coreX1 + margin, w);
+      tile.y1 = std::min(tile.coreY1 + margin, h);
+      tiles.push_back(tile);
+    }
   }
-  pyramidMemoryConsuption *= params._numScales * sizeof(float);
 
-  return 4 * pyramidMemoryConsuption + (3 * width * height * sizeof(float)) + (params._maxTotalKeypoints * 128 * sizeof(float));
+  return tiles.size() > 1;
+}
+
+void copySIFTTileToCoarseImage(const VlSiftFilt* filt, const SiftTile& tile, image::Image<float>& coarseImage)
+{
+  // base of the next octave, see vl_sift_process_next_octave
+  const int octave = vl_sift_get_octave_index(filt);
+  const int level = std::min(filt->s_min + filt->S, filt->s_max);
+  const vl_sift_pix* data = vl_sift_get_octave(filt, level);
+  const int dataWidth = vl_sift_get_octave_width(filt);
+
+  // coarse pixel (x, y) is the tile octave pixel (2x - x0 / 2^octave, 2y - y0 / 2^octave)
+  const int step = 1 << (octave + 1);
+  const int offsetX = (octave >= 0) ? (tile.x0 >> octave) : (tile.x0 << -octave);
+  const int offsetY = (octave >= 0) ? (tile.y0 >> octave) : (tile.y0 << -octave);
+  const int xBegin = (tile.coreX0 + step - 1) / step;
+  const int yBegin = (tile.coreY0 + step - 1) / step;
+  const int xEnd = std::min((tile.coreX1 + step - 1) / step, coarseImage.Width());
+  const int yEnd = std::min((tile.coreY1 + step - 1) / step, coarseImage.Height());
+
+  for(int y = yBegin; y < yEnd; ++y)
+  {
+    const vl_sift_pix* row = data + (2 * y - offsetY) * dataWidth - offsetX;
+    for(int x = xBegin; x < xEnd; ++x)
+      coarseImage(y, x) = row[2 * x];
+  }
+}
+
+VlSiftFilt* createSIFTCoarseFilter(const image::Image<float>& coarseImage, int numOctaves, const SiftParams& params)
+{
+  VlSiftFilt *filt = createSIFTFilter(coarseImage.Width(), coarseImage.Height(), 0, numOctaves, params);
+  // the base image already has the smoothing of the first octave level: skip the initial smoothing
+  filt->sigman = filt->sigma0 * std::pow(filt->sigmak, filt->s_min);
+  return filt;
+}
+
+VlSiftFilt* createSIFTFilter(int width, int height, int firstOctave, int numOctaves, const SiftParams& params)
+{
+  VlSiftFilt *filt = vl_sift_new(width, height, numOctaves, params._numScales, firstOctave);
+  if (params._edgeThreshold >= 0)
+    vl_sift_set_edge_thresh(filt, params._edgeThreshold);
+  if (params._peakThreshold >= 0)
+    vl_sift_set_peak_thresh(filt, params._peakThreshold/params._numScales);
+  return filt;
+}
+
+bool gridFilteringSIFT(const std::vector<SIOPointFeature>& features,
+                       std::size_t width,
+                       std::size_t height,
+                       const SiftParams& params,
+                       bool keepCandidates,
+                       std::vector<IndexT>& out_indexes)
+{
+  // Only filter features if we have more features than the maxTotalKeypoints
+  if(!params._gridSize || !params._maxTotalKeypoints || features.size() <= params._maxTotalKeypoints)
+    return false;
+
+  std::vector<IndexT>& filtered_indexes = out_indexes;
+  std::vector<IndexT> rejected_indexes;
+  filtered_indexes.clear();
+  filtered_indexes.reserve(std::min(features.size(), params._maxTotalKeypoints));
+  rejected_indexes.reserve(features.size());
+
+  const std::size_t sizeMat = params._gridSize * params._gridSize;
+  std::vector<std::size_t> countFeatPerCell(sizeMat, 0);
+  const std::size_t keypointsPerCell = params._maxTotalKeypoints / sizeMat;
+  const double regionWidth = width / double(params._gridSize);
+  const double regionHeight = height / double(params._gridSize);
+
+  for(IndexT i = 0; i < features.size(); ++i)
+  {
+    const auto& keypoint = features.at(i);
+
+    const std::size_t cellX = std::min(std::size_t(keypoint.x() / regionWidth), params._gridSize);
+    const std::size_t cellY = std::min(std::size_t(keypoint.y() / regionHeight), params._gridSize);
+
+    std::size_t &count = countFeatPerCell[cellX*params._gridSize + cellY];
+    ++count;
+
+    if(count < keypointsPerCell)
+      filtered_indexes.push_back(i);
+    else if(keepCandidates && i < params._maxTotalKeypoints)
+      filtered_indexes.push_back(i); // can still be selected among the best remaining ones
+    else if(!keepCandidates)
+      rejected_indexes.push_back(i);
+  }
+
+  if(keepCandidates)
+    return true;
+
+  // If we don't have enough features (less than maxTotalKeypoints) after the grid filtering (empty regions in the grid for example).
+  // We add the best other ones, without repartition constraint.
+  if( filtered_indexes.size() < params._maxTotalKeypoints )
+  {
+    const std::size_t remainingElements = std::min(rejected_indexes.size(), params._maxTotalKeypoints - filtered_indexes.size());
+    ALICEVISION_LOG_TRACE("Grid filtering -- Copy remaining points: " << remainingElements);
+    filtered_indexes.insert(filtered_indexes.end(), rejected_indexes.begin(), rejected_indexes.begin() + remainingElements);
+  }
+  return true;
 }
 
 void VLFeatInstance::initialize()
@@ -10,6 +10,7 @@
 #include <aliceVision/feature/Descriptor.hpp>
 #include <aliceVision/feature/ImageDescriber.hpp>
 #include <aliceVision/feature/regionsFactory.hpp>
+#include <aliceVision/image/ImagePool.hpp>
 #include <aliceVision/config.hpp>
 #include <aliceVision/system/Logger.hpp>
 
@@ -17,9 +18,11 @@ extern "C" {
 #include "nonFree/sift/vl/sift.h"
 }
 
+#include <algorithm>
 #include <iostream>
 #include <numeric>
 #include <stdexcept>
+#include <vector>
 
 namespace aliceVision {
 namespace feature {
@@ -39,7 +42,8 @@ struct SiftParams
              float peakThreshold = 0.04f,
              std::size_t gridSize = 4,
              std::size_t maxTotalKeypoints = 1000,
-             bool rootSift = true)
+             bool rootSift = true,
+             std::size_t tileSize = 0)
     : _firstOctave(firstOctave)
     , _numOctaves(numOctaves)
     , _numScales(numScales)
@@ -48,6 +52,7 @@ struct SiftParams
     , _gridSize(gridSize)
     , _maxTotalKeypoints(maxTotalKeypoints)
     , _rootSift(rootSift)
+    , _tileSize(tileSize)
   {}
 
   // Parameters
@@ -66,6 +71,8 @@ struct SiftParams
   std::size_t _maxTotalKeypoints;
   /// see [1]
   bool _rootSift;
+  /// Images larger than this size (in pixels) are processed on overlapping tiles, 0 to disable the tiling
+  std::size_t _tileSize;
   
   void setPreset(EImageDescriberPreset preset)
   {
@@ -183,44 +190,164 @@ inline void convertSIFT<unsigned char>(
 std::size_t getMemoryConsumptionVLFeat(std::size_t width, std::size_t height, const SiftParams& params);
 
 /**
- * @brief Extract SIFT regions (in float or unsigned char).
- *
- * @param image
- * @param regions
- * @param params
- * @param orientation
- * @param mask
- * @return
+ * @brief Image area processed by one VLFeat filter in tiled extraction.
+ * Only the keypoints inside the core area are kept, the margin around the core
+ * provides the image support of the keypoints detected near the core border.
+ * The cores of all the tiles form a partition of the image.
+ */
+struct SiftTile
+{
+  /// padded area [x0, x1[ x [y0, y1[
+  int x0, y0, x1, y1;
+  /// core area [coreX0, coreX1[ x [coreY0, coreY1[
+  int coreX0, coreY0, coreX1, coreY1;
+
+  bool inCore(float x, float y) const
+  {
+    return x >= coreX0 && x < coreX1 && y >= coreY0 && y < coreY1;
+  }
+};
+
+/**
+ * @brief Split an image in overlapping tiles for SIFT extraction, see SiftParams::_tileSize.
+ * The finest octaves (up to lastTileOctave) are computed on the tiles, with a margin large enough
+ * to contain the support of their keypoints. The coarsest octaves are computed on the whole image,
+ * from the base image assembled from the tiles (see copySIFTTileToCoarseImage).
+ * @param[in] width The image width
+ * @param[in] height The image height
+ * @param[in] params The SIFT parameters
+ * @param[out] lastTileOctave The last octave computed on the tiles
+ * @param[out] tiles The image tiles
+ * @return false if the image is not large enough to be tiled
+ */
+bool computeSIFTTiling(std::size_t width, std::size_t height, const SiftParams& params, int& lastTileOctave, std::vector<SiftTile>& tiles);
+
+/**
+ * @brief Copy the core of a tile into the base image of the octave following the last tile octave.
+ * @param[in] filt The filter of the tile, after the processing of its last octave
+ * @param[in] tile The tile
+ * @param[in,out] coarseImage The base image of the coarsest octaves (tiles write disjoint areas)
+ */
+void copySIFTTileToCoarseImage(const VlSiftFilt* filt, const SiftTile& tile, image::Image<float>& coarseImage);
+
+/**
+ * @brief Create a VLFeat SIFT filter for the coarsest octaves of a tiled extraction.
+ * @param[in] coarseImage The base image assembled from the tiles, already smoothed
+ * @param[in] numOctaves The number of coarse octaves
+ * @note The caller must delete the filter with vl_sift_delete.
+ */
+VlSiftFilt* createSIFTCoarseFilter(const image::Image<float>& coarseImage, int numOctaves, const SiftParams& params);
+
+/**
+ * @brief Create a VLFeat SIFT filter configured with the given parameters.
+ * @note The caller must delete the filter with vl_sift_delete.
+ */
+VlSiftFilt* createSIFTFilter(int width, int height, int firstOctave, int numOctaves, const SiftParams& params);
+
+/**
+ * @brief Grid filtering of the keypoints to ensure a global repartition.
+ * @param[in] features The keypoints sorted by decreasing scale
+ * @param[in] width The image width
+ * @param[in] height The image height
+ * @param[in] params The SIFT parameters (_gridSize and _maxTotalKeypoints)
+ * @param[in] keepCandidates If true, keep every keypoint that can still be selected
+ *            by the grid filtering of a larger set containing these keypoints (per-tile budget)
+ * @param[out] out_indexes The indexes of the kept keypoints
+ * @return false if there is nothing to filter
+ */
+bool gridFilteringSIFT(const std::vector<SIOPointFeature>& features,
+                       std::size_t width,
+                       std::size_t height,
+                       const SiftParams& params,
+                       bool keepCandidates,
+                       std::vector<IndexT>& out_indexes);
+
+/**
+ * @brief Sort SIFT regions according to their scale (decreasing).
+ * @param[in,out] regions
+ */
+template <typename SIFT_Region_T>
+void sortSIFTRegions(SIFT_Region_T& regions)
+{
+  const auto& features = regions.Features();
+  const auto& descriptors = regions.Descriptors();
+  assert(features.size() == descriptors.size());
+
+  std::vector<std::size_t> indexSort(features.size());
+  std::iota(indexSort.begin(), indexSort.end(), 0);
+  std::sort(indexSort.begin(), indexSort.end(), [&](std::size_t a, std::size_t b){ return features[a].scale() > features[b].scale(); });
+
+  std::vector<typename SIFT_Region_T::FeatureT> sortedFeatures(features.size());
+  std::vector<typename SIFT_Region_T::DescriptorT> sortedDescriptors(features.size());
+  for(std::size_t i: indexSort)
+  {
+    sortedFeatures[i] = features[indexSort[i]];
+    sortedDescriptors[i] = descriptors[indexSort[i]];
+  }
+  regions.Features().swap(sortedFeatures);
+  regions.Descriptors().swap(sortedDescriptors);
+}
+
+/**
+ * @brief Grid filtering of SIFT regions sorted by decreasing scale, see gridFilteringSIFT.
+ * @param[in,out] regions
+ */
+template <typename SIFT_Region_T>
+void gridFilterSIFTRegions(SIFT_Region_T& regions,
+                           std::size_t width,
+                           std::size_t height,
+                           const SiftParams& params,
+                           bool keepCandidates)
+{
+  const auto& features = regions.Features();
+  const auto& descriptors = regions.Descriptors();
+
+  std::vector<IndexT> filtered_indexes;
+  if(!gridFilteringSIFT(features, width, height, params, keepCandidates, filtered_indexes))
+    return;
+
+  std::vector<typename SIFT_Region_T::FeatureT> filtered_features(filtered_indexes.size());
+  std::vector<typename SIFT_Region_T::DescriptorT> filtered_descriptors(filtered_indexes.size());
+  for(IndexT i = 0; i < filtered_indexes.size(); ++i)
+  {
+    filtered_features[i] = features[filtered_indexes[i]];
+    filtered_descriptors[i] = descriptors[filtered_indexes[i]];
+  }
+  regions.Features().swap(filtered_features);
+  regions.Descriptors().swap(filtered_descriptors);
+}
+
+/**
+ * @brief Detect and describe the SIFT keypoints of all the octaves of a VLFeat filter.
+ * @param[in] filt The VLFeat filter
+ * @param[in] data The image data (filter width x filter height)
+ * @param[in] tile The image tile of the data, the keypoints outside of its core are ignored (nullptr for the whole image)
+ * @param[in] scale The scale of the filter octave 0 relatively to the input image
+ * @param[in] params The SIFT parameters
+ * @param[in] orientation Compute the keypoints orientation
+ * @param[in] mask The mask of the whole image (optional)
+ * @param[in] parallel Describe the keypoints of each octave in parallel
+ * @param[out] regions The detected regions (appended)
  */
 template <typename T>
-bool extractSIFT(const image::Image<float>& image,
-    std::unique_ptr<Regions>& regions,
+void extractSIFTOctaves(VlSiftFilt* filt,
+    const vl_sift_pix* data,
+    const SiftTile* tile,
+    float scale,
     const SiftParams& params,
     bool orientation,
-    const image::Image<unsigned char>* mask)
+    const image::Image<unsigned char>* mask,
+    bool parallel,
+    ScalarRegions<SIOPointFeature,T,128>& regions)
 {
-  const int w = image.Width(), h = image.Height();
-  VlSiftFilt *filt = vl_sift_new(w, h, params._numOctaves, params._numScales, params._firstOctave);
-  if (params._edgeThreshold >= 0)
-    vl_sift_set_edge_thresh(filt, params._edgeThreshold);
-  if (params._peakThreshold >= 0)
-    vl_sift_set_peak_thresh(filt, params._peakThreshold/params._numScales);
+  const float offsetX = tile ? tile->x0 : 0.f;
+  const float offsetY = tile ? tile->y0 : 0.f;
 
   Descriptor<vl_sift_pix, 128> vlFeatDescriptor;
   Descriptor<T, 128> descriptor;
 
   // Process SIFT computation
-  vl_sift_process_first_octave(filt, image.data());
-
-  typedef ScalarRegions<SIOPointFeature,T,128> SIFT_Region_T;
-  regions.reset( new SIFT_Region_T );
-  
-  // Build alias to cached data
-  SIFT_Region_T * regionsCasted = dynamic_cast<SIFT_Region_T*>(regions.get());
-  // reserve some memory for faster keypoint saving
-  const std::size_t reserveSize = (params._gridSize && params._maxTotalKeypoints) ? params._maxTotalKeypoints : 2000;
-  regionsCasted->Features().reserve(reserveSize);
-  regionsCasted->Descriptors().reserve(reserveSize);
+  vl_sift_process_first_octave(filt, data);
 
   while (true)
   {
@@ -232,15 +359,21 @@ bool extractSIFT(const image::Image<float>& image,
     // Update gradient before launching parallel extraction
     vl_sift_update_gradient(filt);
 
-    #pragma omp parallel for private(vlFeatDescriptor, descriptor)
+    #pragma omp parallel for private(vlFeatDescriptor, descriptor) if(parallel)
     for (int i = 0; i < nkeys; ++i)
     {
+      const float x = keys[i].x * scale + offsetX;
+      const float y = keys[i].y * scale + offsetY;
+
+      // Border deduplication: each keypoint belongs to one tile core
+      if (tile && !tile->inCore(x, y))
+        continue;
 
       // Feature masking
       if (mask)
       {
         const image::Image<unsigned char> & maskIma = *mask;
-        if (maskIma(keys[i].y, keys[i].x) > 0)
+        if (maskIma(y, x) > 0)
           continue;
       }
 
@@ -254,15 +387,15 @@ bool extractSIFT(const image::Image<float>& image,
       for (int q=0 ; q < nangles ; ++q)
       {
         vl_sift_calc_keypoint_descriptor(filt, &vlFeatDescriptor[0], keys+i, angles[q]);
-        const SIOPointFeature fp(keys[i].x, keys[i].y,
-          keys[i].sigma, static_cast<float>(angles[q]));
+        const SIOPointFeature fp(x, y,
+          keys[i].sigma * scale, static_cast<float>(angles[q]));
 
         convertSIFT<T>(&vlFeatDescriptor[0], descriptor, params._rootSift);
         
         #pragma omp critical
         {
-          regionsCasted->Descriptors().push_back(descriptor);
-          regionsCasted->Features().push_back(fp);
+          regions.Descriptors().push_back(descriptor);
+          regions.Features().push_back(fp);
         }
         
       }
@@ -271,86 +404,116 @@ bool extractSIFT(const image::Image<float>& image,
     if (vl_sift_process_next_octave(filt))
       break; // Last octave
   }
-  vl_sift_delete(filt);
+}
 
-  const auto& features = regionsCasted->Features();
-  const auto& descriptors = regionsCasted->Descriptors();
-  assert(features.size() == descriptors.size());
+/**
+ * @brief Extract SIFT regions (in float or unsigned char).
+ *
+ * Images larger than params._tileSize are processed on overlapping tiles in parallel,
+ * see computeSIFTTiling. Each tile keeps only the keypoints that the grid filtering
+ * of the whole image can select, so the tiled extraction keeps a bounded memory.
+ *
+ * @param image
+ * @param regions
+ * @param params
+ * @param orientation
+ * @param mask
+ * @return
+ */
+template <typename T>
+bool extractSIFT(const image::Image<float>& image,
+    std::unique_ptr<Regions>& regions,
+    const SiftParams& params,
+    bool orientation,
+    const image::Image<unsigned char>* mask)
+{
+  const int w = image.Width(), h = image.Height();
+
+  typedef ScalarRegions<SIOPointFeature,T,128> SIFT_Region_T;
+  regions.reset( new SIFT_Region_T );
   
-  //Sorting the extracted features according to their scale
+  // Build alias to cached data
+  SIFT_Region_T * regionsCasted = dynamic_cast<SIFT_Region_T*>(regions.get());
+  // reserve some memory for faster keypoint saving
+  const bool useGridFiltering = (params._gridSize && params._maxTotalKeypoints);
+  const std::size_t reserveSize = useGridFiltering ? params._maxTotalKeypoints : 2000;
+  regionsCasted->Features().reserve(reserveSize);
+  regionsCasted->Descriptors().reserve(reserveSize);
+
+  int lastTileOctave = 0;
+  std::vector<SiftTile> tiles;
+
+  if(!computeSIFTTiling(w, h, params, lastTileOctave, tiles))
   {
-    std::vector<std::size_t> indexSort(features.size());
-    std::iota(indexSort.begin(), indexSort.end(), 0);
-    std::sort(indexSort.begin(), indexSort.end(), [&](std::size_t a, std::size_t b){ return features[a].scale() > features[b].scale(); });
-    
-    std::vector<typename SIFT_Region_T::FeatureT> sortedFeatures(features.size());
-    std::vector<typename SIFT_Region_T::DescriptorT> sortedDescriptors(features.size());
-    for(std::size_t i: indexSort)
-    {
-      sortedFeatures[i] = features[indexSort[i]];
-      sortedDescriptors[i] = descriptors[indexSort[i]];
-    }
-    regionsCasted->Features().swap(sortedFeatures);
-    regionsCasted->Descriptors().swap(sortedDescriptors);
+    VlSiftFilt *filt = createSIFTFilter(w, h, params._firstOctave, params._numOctaves, params);
+    extractSIFTOctaves<T>(filt, image.data(), nullptr, 1.f, params, orientation, mask, true, *regionsCasted);
+    vl_sift_delete(filt);
   }
-
-  // Grid filtering of the keypoints to ensure a global repartition
-  if(params._gridSize && params._maxTotalKeypoints)
+  else
   {
-    // Only filter features if we have more features than the maxTotalKeypoints
-    if(features.size() > params._maxTotalKeypoints)
-    {
-      std::vector<IndexT> filtered_indexes;
-      std::vector<IndexT> rejected_indexes;
-      filtered_indexes.reserve(std::min(features.size(), params._maxTotalKeypoints));
-      rejected_indexes.reserve(features.size());
-
-      const std::size_t sizeMat = params._gridSize * params._gridSize;
-      std::vector<std::size_t> countFeatPerCell(sizeMat, 0);
-      for (int Indice = 0; Indice < sizeMat; Indice++)
-      {
-    	  countFeatPerCell[Indice] = 0;
-      }
-      const std::size_t keypointsPerCell = params._maxTotalKeypoints / sizeMat;
-      const double regionWidth = w / double(params._gridSize);
-      const double regionHeight = h / double(params._gridSize);
-
-      for(IndexT i = 0; i < features.size(); ++i)
-      {
-        const auto& keypoint = features.at(i);
-        
-        const std::size_t cellX = std::min(std::size_t(keypoint.x() / regionWidth), params._gridSize);
-        const std::size_t cellY = std::min(std::size_t(keypoint.y() / regionHeight), params._gridSize);
+    ALICEVISION_LOG_TRACE("SIFT extraction on " << tiles.size() << " tiles (octaves " << params._firstOctave << " to " << lastTileOctave << ").");
 
-        std::size_t &count = countFeatPerCell[cellX*params._gridSize + cellY];
-        ++count;
+    const int lastOctave = params._firstOctave + params._numOctaves - 1;
+    const int coarseOctave = lastTileOctave + 1;
+    image::Image<float> coarseImage;
+    if(coarseOctave <= lastOctave)
+      coarseImage.resize(w >> coarseOctave, h >> coarseOctave);
 
-        if(count < keypointsPerCell)
-          filtered_indexes.push_back(i);
-        else
-          rejected_indexes.push_back(i);
-      }
-      // If we don't have enough features (less than maxTotalKeypoints) after the grid filtering (empty regions in the grid for example).
-      // We add the best other ones, without repartition constraint.
-      if( filtered_indexes.size() < params._maxTotalKeypoints )
+    // finest octaves: one filter per tile
+    #pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < tiles.size(); ++i)
+    {
+      const SiftTile& tile = tiles.at(i);
+
+      // the tiles of a thread mostly share the same size: reuse the tile buffer through the image pool
+      image::ImagePool<float>& pool = image::ImagePool<float>::local();
+      image::Image<float> tileImage;
+      pool.resize(tileImage, tile.x1 - tile.x0, tile.y1 - tile.y0);
+      tileImage.array() = image.block(tile.y0, tile.x0, tile.y1 - tile.y0, tile.x1 - tile.x0).array();
+
+      SIFT_Region_T tileRegions;
+      VlSiftFilt *filt = createSIFTFilter(tileImage.Width(), tileImage.Height(), params._firstOctave, lastTileOctave - params._firstOctave + 1, params);
+      extractSIFTOctaves<T>(filt, tileImage.data(), &tile, 1.f, params, orientation, mask, false, tileRegions);
+      if(coarseImage.Width() > 0)
+        copySIFTTileToCoarseImage(filt, tile, coarseImage);
+      vl_sift_delete(filt);
+      pool.release(tileImage);
+
+      // per-tile keypoint budget
+      sortSIFTRegions(tileRegions);
+      gridFilterSIFTRegions(tileRegions, w, h, params, true);
+
+      #pragma omp critical
       {
-        const std::size_t remainingElements = std::min(rejected_indexes.size(), params._maxTotalKeypoints - filtered_indexes.size());
-        ALICEVISION_LOG_TRACE("Grid filtering -- Copy remaining points: " << remainingElements);
-        filtered_indexes.insert(filtered_indexes.end(), rejected_indexes.begin(), rejected_indexes.begin() + remainingElements);
-      }
+        auto& features = regionsCasted->Features();
+        auto& descriptors = regionsCasted->Descriptors();
+        features.insert(features.end(), tileRegions.Features().begin(), tileRegions.Features().end());
+        descriptors.insert(descriptors.end(), tileRegions.Descriptors().begin(), tileRegions.Descriptors().end());
 
-      std::vector<typename SIFT_Region_T::FeatureT> filtered_features(filtered_indexes.size());
-      std::vector<typename SIFT_Region_T::DescriptorT> filtered_descriptors(filtered_indexes.size());
-      for(IndexT i = 0; i < filtered_indexes.size(); ++i)
-      {
-        filtered_features[i] = features[filtered_indexes[i]];
-        filtered_descriptors[i] = descriptors[filtered_indexes[i]];
+        if(useGridFiltering && features.size() > 4 * params._maxTotalKeypoints)
+        {
+          sortSIFTRegions(*regionsCasted);
+          gridFilterSIFTRegions(*regionsCasted, w, h, params, true);
+        }
       }
-      regionsCasted->Features().swap(filtered_features);
-      regionsCasted->Descriptors().swap(filtered_descriptors);
+    }
+
+    // coarsest octaves: the whole image is small enough at these resolutions
+    if(coarseImage.Width() > 0)
+    {
+      VlSiftFilt *filt = createSIFTCoarseFilter(coarseImage, lastOctave - lastTileOctave, params);
+      extractSIFTOctaves<T>(filt, coarseImage.data(), nullptr, static_cast<float>(1 << coarseOctave), params, orientation, mask, true, *regionsCasted);
+      vl_sift_delete(filt);
     }
   }
-  assert(features.size() == descriptors.size());
+
+  //Sorting the extracted features according to their scale
+  sortSIFTRegions(*regionsCasted);
+
+  // Grid filtering of the keypoints to ensure a global repartition
+  gridFilterSIFTRegions(*regionsCasted, w, h, params, false);
+
+  assert(regionsCasted->Features().size() == regionsCasted->Descriptors().size());
   
   return true;
 }
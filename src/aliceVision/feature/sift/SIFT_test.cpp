@@ -0,0 +1,180 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/feature/sift/SIFT.hpp>
+#include <aliceVision/image/Image.hpp>
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE SIFT
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::feature;
+
+namespace {
+
+typedef ScalarRegions<SIOPointFeature, unsigned char, 128> SIFT_Regions;
+
+/**
+ * @brief Create a textured image made of random gaussian blobs.
+ */
+image::Image<float> createTexturedImage(int width, int height)
+{
+  std::mt19937 randomNumberGenerator(0);
+  std::uniform_real_distribution<float> positionX(0.f, width);
+  std::uniform_real_distribution<float> positionY(0.f, height);
+  std::uniform_real_distribution<float> radius(2.f, 12.f);
+  std::uniform_real_distribution<float> intensity(-0.5f, 0.5f);
+
+  image::Image<float> image(width, height, true, 0.5f);
+  for(int i = 0; i < 1500; ++i)
+  {
+    const float cx = positionX(randomNumberGenerator);
+    const float cy = positionY(randomNumberGenerator);
+    const float r = radius(randomNumberGenerator);
+    const float a = intensity(randomNumberGenerator);
+    const int extent = static_cast<int>(std::ceil(3.f * r));
+
+    for(int y = std::max(0, int(cy) - extent); y < std::min(height, int(cy) + extent + 1); ++y)
+      for(int x = std::max(0, int(cx) - extent); x < std::min(width, int(cx) + extent + 1); ++x)
+        image(y, x) += a * std::exp(-((x - cx) * (x - cx) + (y - cy) * (y - cy)) / (2.f * r * r));
+  }
+  for(int y = 0; y < height; ++y)
+    for(int x = 0; x < width; ++x)
+      image(y, x) = std::min(1.f, std::max(0.f, image(y, x)));
+  return image;
+}
+
+const SIFT_Regions& extract(const image::Image<float>& image, const SiftParams& params, std::unique_ptr<Regions>& regions)
+{
+  BOOST_REQUIRE(extractSIFT<unsigned char>(image, regions, params, true, nullptr));
+  return dynamic_cast<const SIFT_Regions&>(*regions);
+}
+
+/**
+ * @brief Check that the keypoints of both sets match within a tolerance.
+ * The keypoints are sorted by decreasing scale, so the match of a keypoint is searched among its neighbours.
+ */
+void checkSameKeypoints(const std::vector<SIOPointFeature>& expected, const std::vector<SIOPointFeature>& features)
+{
+  BOOST_REQUIRE_EQUAL(expected.size(), features.size());
+
+  std::size_t nbMatches = 0;
+  for(const SIOPointFeature& e : expected)
+  {
+    for(const SIOPointFeature& f : features)
+    {
+      if(std::abs(e.x() - f.x()) < 0.1f &&
+         std::abs(e.y() - f.y()) < 0.1f &&
+         std::abs(e.scale() - f.scale()) < 0.01f * e.scale() &&
+         std::abs(e.orientation() - f.orientation()) < 0.01f)
+      {
+        ++nbMatches;
+        break;
+      }
+    }
+  }
+  BOOST_CHECK_EQUAL(nbMatches, expected.size());
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(SIFT_extractTiles)
+{
+  VLFeatInstance::initialize();
+
+  const image::Image<float> image = createTexturedImage(1000, 700);
+
+  SiftParams params;
+  params._gridSize = 0;
+
+  int lastTileOctave = 0;
+  std::vector<SiftTile> tiles;
+  params._tileSize = 256;
+  BOOST_REQUIRE(computeSIFTTiling(image.Width(), image.Height(), params, lastTileOctave, tiles));
+  BOOST_CHECK_GT(tiles.size(), 4);
+
+  // the tile cores form a partition of the image
+  std::size_t coreArea = 0;
+  for(const SiftTile& tile : tiles)
+    coreArea += (tile.coreX1 - tile.coreX0) * (tile.coreY1 - tile.coreY0);
+  BOOST_CHECK_EQUAL(coreArea, image.Width() * image.Height());
+
+  std::unique_ptr<Regions> wholeRegions;
+  std::unique_ptr<Regions> tiledRegions;
+  params._tileSize = 0;
+  const SIFT_Regions& whole = extract(image, params, wholeRegions);
+  params._tileSize = 256;
+  const SIFT_Regions& tiled = extract(image, params, tiledRegions);
+
+  BOOST_CHECK_GT(whole.Features().size(), 500);
+  checkSameKeypoints(whole.Features(), tiled.Features());
+
+  VLFeatInstance::destroy();
+}
+
+BOOST_AUTO_TEST_CASE(SIFT_gridFilterTiles)
+{
+  VLFeatInstance::initialize();
+
+  const image::Image<float> image = createTexturedImage(1000, 700);
+
+  SiftParams params;
+  params._gridSize = 4;
+  params._maxTotalKeypoints = 500;
+
+  std::unique_ptr<Regions> wholeRegions;
+  std::unique_ptr<Regions> tiledRegions;
+  params._tileSize = 0;
+  const SIFT_Regions& whole = extract(image, params, wholeRegions);
+  params._tileSize = 256;
+  const SIFT_Regions& tiled = extract(image, params, tiledRegions);
+
+  // the per-tile budget keeps the keypoints selected by the grid filtering of the whole image
+  BOOST_CHECK_EQUAL(whole.Features().size(), params._maxTotalKeypoints);
+  BOOST_CHECK_EQUAL(whole.Descriptors().size(), params._maxTotalKeypoints);
+  BOOST_CHECK_EQUAL(tiled.Descriptors().size(), tiled.Features().size());
+  checkSameKeypoints(whole.Features(), tiled.Features());
+
+  VLFeatInstance::destroy();
+}
+
+BOOST_AUTO_TEST_CASE(SIFT_gridFiltering)
+{
+  // 2x2 grid, keypoints sorted by decreasing scale, a dense cell and a sparse one
+  SiftParams params;
+  params._gridSize = 2;
+  params._maxTotalKeypoints = 16;
+
+  std::vector<SIOPointFeature> features;
+  for(int i = 0; i < 40; ++i)
+    features.push_back(SIOPointFeature(10.f + (i % 4) * 2.f, 10.f, 40.f - i));
+  for(int i = 0; i < 4; ++i)
+    features.push_back(SIOPointFeature(90.f, 90.f, 1.f));
+
+  std::vector<IndexT> indexes;
+  BOOST_REQUIRE(gridFilteringSIFT(features, 100, 100, params, false, indexes));
+  BOOST_CHECK_EQUAL(indexes.size(), params._maxTotalKeypoints);
+
+  // the sparse cell keeps some of its small keypoints, the remaining ones are the largest of the dense cell
+  std::size_t nbSparseCell = 0;
+  for(IndexT i : indexes)
+  {
+    if(i >= 40)
+      ++nbSparseCell;
+    else
+      BOOST_CHECK_LT(i, params._maxTotalKeypoints);
+  }
+  BOOST_CHECK_GT(nbSparseCell, 0);
+
+  // nothing to filter under the cap
+  params._maxTotalKeypoints = features.size();
+  BOOST_CHECK(!gridFilteringSIFT(features, 100, 100, params, false, indexes));
+}
@@ -23,6 +23,8 @@
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/operations.hpp>
 
+#include <algorithm>
+
 // OpenMP >= 3.1 for advanced atomic clauses (https://software.intel.com/en-us/node/608160)
 // OpenMP preprocessor version: https://github.com/jeffhammond/HPCInfo/wiki/Preprocessor-Macros
 #if defined _OPENMP && _OPENMP >= 201107 
@@ -396,7 +398,20 @@ DelaunayGraphCut::DelaunayGraphCut(mvsUtils::MultiViewParams* _mp, mvsUtils::Pre
     saveTemporaryBinFiles = mp->_ini.get<bool>("LargeScale.saveTemporaryBinFiles", false);
 
     GEO::initialize();
-    _tetrahedralization = GEO::Delaunay::create(3, "BDEL");
+    // "BDEL" is the sequential geogram backend (deterministic), "PDEL" the multi-threaded one:
+    // PDEL is faster but its cells and vertices numbering depends on the threads scheduling,
+    // so the resulting mesh can change between two runs on the same input.
+    const std::string delaunayAlgorithm = mp->_ini.get<std::string>("delaunaycut.delaunayAlgorithm", "BDEL");
+    _tetrahedralization = GEO::Delaunay::create(3, delaunayAlgorithm);
+    if(_tetrahedralization.is_null() && delaunayAlgorithm != "BDEL")
+    {
+        ALICEVISION_LOG_WARNING("Delaunay algorithm '" << delaunayAlgorithm << "' is not available, fallback to 'BDEL'.");
+        _tetrahedralization = GEO::Delaunay::create(3, "BDEL");
+    }
+    else if(delaunayAlgorithm == "PDEL")
+    {
+        ALICEVISION_LOG_INFO("Multi-threaded Delaunay tetrahedralization (PDEL): the result is not deterministic.");
+    }
     // _tetrahedralization->set_keeps_infinite(true);
     _tetrahedralization->set_stores_neighbors(true);
     // _tetrahedralization->set_stores_cicl(true);
@@ -466,9 +481,13 @@ void DelaunayGraphCut::computeDelaunay()
     _tetrahedralization->set_vertices(_verticesCoords.size(), _verticesCoords.front().m);
     mvsUtils::printfElapsedTime(tall, "GEOGRAM Delaunay tetrahedralization ");
 
+    long t = clock();
     initCells();
+    mvsUtils::printfElapsedTime(t, "initCells ");
 
+    t = clock();
     updateVertexToCellsCache();
+    mvsUtils::printfElapsedTime(t, "updateVertexToCellsCache ");
 
     ALICEVISION_LOG_DEBUG("computeDelaunay done\n");
 }
@@ -480,6 +499,7 @@ void DelaunayGraphCut::initCells()
     _cellsAttr.resize(_tetrahedralization->nb_cells()); // or nb_finite_cells() if keeps_infinite()
 
     ALICEVISION_LOG_INFO(_cellsAttr.size() << " cells created by tetrahedralization.");
+    #pragma omp parallel for
     for(int i = 0; i < _cellsAttr.size(); ++i)
     {
         GC_cellInfo& c = _cellsAttr[i];
@@ -498,6 +518,70 @@ void DelaunayGraphCut::initCells()
     ALICEVISION_LOG_DEBUG("initCells done\n");
 }
 
+void DelaunayGraphCut::updateVertexToCellsCache()
+{
+    const int nbVertices = _verticesCoords.size();
+    const int nbCells = _tetrahedralization->nb_cells();
+
+    std::vector<int> nbCellsPerVertex(nbVertices, 0);
+    int coutInvalidVertices = 0;
+
+    #pragma omp parallel for reduction(+:coutInvalidVertices)
+    for(int ci = 0; ci < nbCells; ++ci)
+    {
+        for(VertexIndex k = 0; k < 4; ++k)
+        {
+            const VertexIndex vi = _tetrahedralization->cell_vertex(ci, k);
+            if(vi == GEO::NO_VERTEX || vi >= _verticesCoords.size())
+            {
+                ++coutInvalidVertices;
+                continue;
+            }
+            #pragma omp atomic
+            ++nbCellsPerVertex[vi];
+        }
+    }
+    ALICEVISION_LOG_INFO("coutInvalidVertices: " << coutInvalidVertices);
+    ALICEVISION_LOG_INFO("verticesCoords: " << nbVertices);
+
+    _neighboringCellsPerVertex.clear();
+    _neighboringCellsPerVertex.resize(nbVertices);
+
+    #pragma omp parallel for
+    for(int vi = 0; vi < nbVertices; ++vi)
+    {
+        _neighboringCellsPerVertex[vi].resize(nbCellsPerVertex[vi]);
+        nbCellsPerVertex[vi] = 0; // reused as filling cursor
+    }
+
+#ifdef ALICEVISION_OMP_HAVE_ATOMIC_CAPTURE
+    #pragma omp parallel for
+#endif
+    for(int ci = 0; ci < nbCells; ++ci)
+    {
+        for(VertexIndex k = 0; k < 4; ++k)
+        {
+            const VertexIndex vi = _tetrahedralization->cell_vertex(ci, k);
+            if(vi == GEO::NO_VERTEX || vi >= _verticesCoords.size())
+                continue;
+            int pos;
+#ifdef ALICEVISION_OMP_HAVE_ATOMIC_CAPTURE
+            #pragma omp atomic capture
+#endif
+            pos = nbCellsPerVertex[vi]++;
+            _neighboringCellsPerVertex[vi][pos] = ci;
+        }
+    }
+
+    // the 4 vertices of a cell are distinct, so sorting is enough to get the same result as a std::set
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(int vi = 0; vi < nbVertices; ++vi)
+    {
+        std::vector<CellIndex>& cells = _neighboringCellsPerVertex[vi];
+        std::sort(cells.begin(), cells.end());
+    }
+}
+
 void DelaunayGraphCut::displayStatistics()
 {
     // Display some statistics
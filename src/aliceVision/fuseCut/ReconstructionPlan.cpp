@@ -14,11 +14,14 @@
 #include <aliceVision/fuseCut/DelaunayGraphCut.hpp>
 
 #include <boost/filesystem.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
 
 namespace aliceVision {
 namespace fuseCut {
 
 namespace bfs = boost::filesystem;
+namespace bpt = boost::property_tree;
 
 ReconstructionPlan::ReconstructionPlan(Voxel& dimmensions, Point3d* space, mvsUtils::MultiViewParams* _mp, mvsUtils::PreMatchCams* _pc,
                                        std::string _spaceRootDir)
@@ -249,67 +252,214 @@ void ReconstructionPlan::getHexahedronForID(float dist, int id, Point3d* out)
     mvsUtils::inflateHexahedron(&(*voxels)[id * 8], out, dist);
 }
 
-void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileName, LargeScale* ls)
+VoxelReconstructionJob createVoxelReconstructionJob(const StaticVector<Point3d>& voxelsArray, int voxelId, const std::string& outputFolder)
 {
-    StaticVector<Point3d>* voxelsArray = loadArrayFromFile<Point3d>(voxelsArrayFileName);
+    VoxelReconstructionJob job;
+    job.voxelId = voxelId;
+    job.outputFolder = outputFolder;
+    std::copy(&voxelsArray[voxelId * 8], &voxelsArray[voxelId * 8] + 8, job.hexah.begin());
+
+    // the previous voxels are reconstructed by their own jobs
+    job.hexahsToExclude.resize(voxelId);
+    for(int i = 0; i < voxelId; ++i)
+    {
+        mvsUtils::inflateHexahedron(&voxelsArray[i * 8], &job.hexahsToExclude[i][0], 0.9);
+    }
+    return job;
+}
 
-    ReconstructionPlan* rp =
-        new ReconstructionPlan(ls->dimensions, &ls->space[0], ls->mp, ls->pc, ls->spaceVoxelsFolderName);
+std::string getVoxelReconstructionJobFilepath(const LargeScale& ls, int voxelId)
+{
+    return ls.getReconstructionVoxelFolder(voxelId) + "voxelJob.json";
+}
 
-    StaticVector<Point3d>* hexahsToExcludeFromResultingMesh = new StaticVector<Point3d>();
-    hexahsToExcludeFromResultingMesh->reserve(voxelsArray->size());
+namespace {
 
-    for(int i = 0; i < voxelsArray->size() / 8; i++)
+bpt::ptree hexahToTree(const std::array<Point3d, 8>& hexah)
+{
+    bpt::ptree hexahTree;
+    for(const Point3d& p : hexah)
     {
-        ALICEVISION_LOG_INFO("Reconstructing " << (voxelsArray->size() / 8) << "-th Voxel of " <<  i << ".");
-
-        const std::string folderName = ls->getReconstructionVoxelFolder(i);
-        bfs::create_directory(folderName);
-
-        const std::string meshBinFilepath = folderName + "mesh.bin";
-        if(!mvsUtils::FileExists(meshBinFilepath))
+        bpt::ptree pointTree;
+        for(int k = 0; k < 3; ++k)
         {
-            StaticVector<int>* voxelsIds = rp->voxelsIdsIntersectingHexah(&(*voxelsArray)[i * 8]);
-            DelaunayGraphCut delaunayGC(ls->mp, ls->pc);
-            Point3d* hexah = &(*voxelsArray)[i * 8];
-            delaunayGC.reconstructVoxel(hexah, voxelsIds, folderName, ls->getSpaceCamsTracksDir(), false,
-                                  (VoxelsGrid*)rp, ls->getSpaceSteps(), FuseParams());
-            delete voxelsIds;
-
-            // Save mesh as .bin and .obj
-            mesh::Mesh* mesh = delaunayGC.createMesh();
-            StaticVector<StaticVector<int>*>* ptsCams = delaunayGC.createPtsCams();
-            StaticVector<int> usedCams = delaunayGC.getSortedUsedCams();
-
-            mesh::meshPostProcessing(mesh, ptsCams, usedCams, *ls->mp, *ls->pc, ls->mp->mvDir, hexahsToExcludeFromResultingMesh, hexah);
-            mesh->saveToBin(folderName + "mesh.bin");
-            mesh->saveToObj(folderName + "mesh.obj");
-
-            saveArrayOfArraysToFile<int>(folderName + "meshPtsCamsFromDGC.bin", ptsCams);
-            deleteArrayOfArrays<int>(&ptsCams);
-
-            delete mesh;
+            bpt::ptree coordTree;
+            coordTree.put("", p.m[k]);
+            pointTree.push_back(std::make_pair("", coordTree));
         }
+        hexahTree.push_back(std::make_pair("", pointTree));
+    }
+    return hexahTree;
+}
 
-        /*
-        if(doComputeColoredMeshes)
-        {
-            std::string resultFolderName = folderName + "/";
-            computeColoredMesh(resultFolderName, ls);
-        }
-        */
-        Point3d hexahThin[8];
-        mvsUtils::inflateHexahedron(&(*voxelsArray)[i * 8], hexahThin, 0.9);
-        for(int k = 0; k < 8; k++)
+void treeToHexah(const bpt::ptree& hexahTree, std::array<Point3d, 8>& out_hexah)
+{
+    if(hexahTree.size() != 8)
+        throw std::runtime_error("Invalid hexahedron in voxel reconstruction job.");
+
+    int i = 0;
+    for(const auto& pointTree : hexahTree)
+    {
+        int k = 0;
+        for(const auto& coordTree : pointTree.second)
         {
-            hexahsToExcludeFromResultingMesh->push_back(hexahThin[k]);
+            if(k < 3)
+                out_hexah[i].m[k] = coordTree.second.get_value<double>();
+            ++k;
         }
-        delete hexahsToExcludeFromResultingMesh;
+        ++i;
+    }
+}
+
+} // namespace
+
+void saveVoxelReconstructionJob(const std::string& filepath, const VoxelReconstructionJob& job)
+{
+    // the output folder is stored relative to the job file folder, so the jobs can be moved with their folder
+    const bfs::path jobFolder = bfs::absolute(bfs::path(filepath).parent_path());
+    const bfs::path outputFolder = bfs::relative(bfs::absolute(job.outputFolder), jobFolder);
+
+    bpt::ptree fileTree;
+    fileTree.put("voxelId", job.voxelId);
+    fileTree.put("outputFolder", outputFolder.generic_string());
+    fileTree.add_child("hexah", hexahToTree(job.hexah));
+
+    bpt::ptree hexahsToExcludeTree;
+    for(const auto& hexah : job.hexahsToExclude)
+        hexahsToExcludeTree.push_back(std::make_pair("", hexahToTree(hexah)));
+    fileTree.add_child("hexahsToExclude", hexahsToExcludeTree);
+
+    bpt::write_json(filepath, fileTree);
+}
+
+void loadVoxelReconstructionJob(const std::string& filepath, VoxelReconstructionJob& out_job)
+{
+    bpt::ptree fileTree;
+    bpt::read_json(filepath, fileTree);
+
+    out_job.voxelId = fileTree.get<int>("voxelId");
+    const bfs::path jobFolder = bfs::absolute(bfs::path(filepath).parent_path());
+    const bfs::path outputFolder = fileTree.get<std::string>("outputFolder");
+    bfs::path absoluteOutputFolder = (jobFolder / outputFolder).lexically_normal();
+    if(absoluteOutputFolder.filename() == ".")
+        absoluteOutputFolder.remove_filename();
+    out_job.outputFolder = absoluteOutputFolder.string();
+    if(out_job.outputFolder.empty() || (out_job.outputFolder.back() != '/' && out_job.outputFolder.back() != '\\'))
+        out_job.outputFolder += "/";
+    treeToHexah(fileTree.get_child("hexah"), out_job.hexah);
+
+    out_job.hexahsToExclude.clear();
+    for(const auto& hexahTree : fileTree.get_child("hexahsToExclude"))
+    {
+        out_job.hexahsToExclude.emplace_back();
+        treeToHexah(hexahTree.second, out_job.hexahsToExclude.back());
+    }
+}
+
+int writeVoxelsReconstructionJobs(const std::string& voxelsArrayFileName, LargeScale* ls)
+{
+    StaticVector<Point3d>* voxelsArray = loadArrayFromFile<Point3d>(voxelsArrayFileName);
+    const int nbVoxels = voxelsArray->size() / 8;
+
+    for(int i = 0; i < nbVoxels; ++i)
+    {
+        const VoxelReconstructionJob job = createVoxelReconstructionJob(*voxelsArray, i, ls->getReconstructionVoxelFolder(i));
+        bfs::create_directory(job.outputFolder);
+        saveVoxelReconstructionJob(getVoxelReconstructionJobFilepath(*ls, i), job);
+    }
+    ALICEVISION_LOG_INFO(nbVoxels << " voxel reconstruction jobs written in: " << ls->spaceFolderName);
+
+    delete voxelsArray;
+    return nbVoxels;
+}
+
+void reconstructVoxelJob(const VoxelReconstructionJob& job, ReconstructionPlan* rp, LargeScale* ls)
+{
+    const std::string& folderName = job.outputFolder;
+    bfs::create_directory(folderName);
+
+    const std::string meshBinFilepath = folderName + "mesh.bin";
+    if(mvsUtils::FileExists(meshBinFilepath))
+    {
+        ALICEVISION_LOG_INFO("Voxel " << job.voxelId << " already reconstructed.");
+        return;
+    }
+
+    std::array<Point3d, 8> hexah = job.hexah;
+
+    StaticVector<Point3d> hexahsToExcludeFromResultingMesh;
+    hexahsToExcludeFromResultingMesh.reserve(job.hexahsToExclude.size() * 8);
+    for(const auto& hexahToExclude : job.hexahsToExclude)
+    {
+        for(const Point3d& p : hexahToExclude)
+            hexahsToExcludeFromResultingMesh.push_back(p);
+    }
+
+    StaticVector<int>* voxelsIds = rp->voxelsIdsIntersectingHexah(&hexah[0]);
+    DelaunayGraphCut delaunayGC(ls->mp, ls->pc);
+    delaunayGC.reconstructVoxel(&hexah[0], voxelsIds, folderName, ls->getSpaceCamsTracksDir(), false,
+                          (VoxelsGrid*)rp, ls->getSpaceSteps(), FuseParams());
+    delete voxelsIds;
+
+    // Save mesh as .bin and .obj
+    mesh::Mesh* mesh = delaunayGC.createMesh();
+    StaticVector<StaticVector<int>*>* ptsCams = delaunayGC.createPtsCams();
+    StaticVector<int> usedCams = delaunayGC.getSortedUsedCams();
+
+    mesh::meshPostProcessing(mesh, ptsCams, usedCams, *ls->mp, *ls->pc, ls->mp->mvDir, &hexahsToExcludeFromResultingMesh, &hexah[0]);
+
+    // write the visibilities before the mesh: mesh.bin marks the voxel as done
+    saveArrayOfArraysToFile<int>(folderName + "meshPtsCamsFromDGC.bin", ptsCams);
+    deleteArrayOfArrays<int>(&ptsCams);
+
+    mesh->saveToObj(folderName + "mesh.obj");
+    mesh->saveToBin(meshBinFilepath);
+
+    delete mesh;
+}
+
+void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileName, LargeScale* ls,
+                                            int rangeStart, int rangeSize)
+{
+    StaticVector<Point3d>* voxelsArray = loadArrayFromFile<Point3d>(voxelsArrayFileName);
+
+    ReconstructionPlan* rp =
+        new ReconstructionPlan(ls->dimensions, &ls->space[0], ls->mp, ls->pc, ls->spaceVoxelsFolderName);
+
+    const int nbVoxels = voxelsArray->size() / 8;
+    const int voxelStart = std::max(0, rangeStart);
+    const int voxelEnd = (rangeSize < 0) ? nbVoxels : std::min(voxelStart + rangeSize, nbVoxels);
+
+    for(int i = voxelStart; i < voxelEnd; i++)
+    {
+        ALICEVISION_LOG_INFO("Reconstructing " << i << "-th Voxel of " << nbVoxels << ".");
+
+        VoxelReconstructionJob job;
+        const std::string jobFilepath = getVoxelReconstructionJobFilepath(*ls, i);
+        if(mvsUtils::FileExists(jobFilepath))
+            loadVoxelReconstructionJob(jobFilepath, job);
+        else
+            job = createVoxelReconstructionJob(*voxelsArray, i, ls->getReconstructionVoxelFolder(i));
+
+        reconstructVoxelJob(job, rp, ls);
     }
     delete rp;
     delete voxelsArray;
 }
 
+std::vector<int> getNotReconstructedVoxels(const std::vector<std::string>& recsDirs)
+{
+    std::vector<int> notReconstructed;
+    for(int i = 0; i < recsDirs.size(); ++i)
+    {
+        if(!mvsUtils::FileExists(recsDirs[i] + "mesh.bin") ||
+           !mvsUtils::FileExists(recsDirs[i] + "meshPtsCamsFromDGC.bin"))
+        {
+            notReconstructed.push_back(i);
+        }
+    }
+    return notReconstructed;
+}
 
 StaticVector<StaticVector<int>*>* loadLargeScalePtsCams(const std::vector<std::string>& recsDirs)
 {
@@ -13,6 +13,10 @@
 #include <aliceVision/fuseCut/VoxelsGrid.hpp>
 #include <aliceVision/mesh/Mesh.hpp>
 
+#include <array>
+#include <string>
+#include <vector>
+
 namespace aliceVision {
 namespace fuseCut {
 
@@ -33,8 +37,66 @@ public:
     void getHexahedronForID(float dist, int id, Point3d* out);
 };
 
+/**
+ * @brief Self-contained description of the reconstruction of one voxel of the reconstruction plan.
+ * Each job can be processed independently (in another process or on another node),
+ * the per-voxel results are then merged with joinMeshes and loadLargeScalePtsCams.
+ */
+struct VoxelReconstructionJob
+{
+    /// index of the voxel in the voxels array
+    int voxelId = -1;
+    /// hexahedron of the voxel to reconstruct
+    std::array<Point3d, 8> hexah;
+    /// thin hexahedrons of the previous voxels (their triangles are reconstructed by the other jobs)
+    std::vector<std::array<Point3d, 8>> hexahsToExclude;
+    /// output folder for the voxel mesh and visibilities
+    std::string outputFolder;
+};
+
+/**
+ * @brief Create the reconstruction job of the voxel @p voxelId of the voxels array.
+ */
+VoxelReconstructionJob createVoxelReconstructionJob(const StaticVector<Point3d>& voxelsArray, int voxelId, const std::string& outputFolder);
+
+std::string getVoxelReconstructionJobFilepath(const LargeScale& ls, int voxelId);
+
+/**
+ * @brief Save a voxel reconstruction job description.
+ * The output folder is stored relative to the folder of @p filepath.
+ */
+void saveVoxelReconstructionJob(const std::string& filepath, const VoxelReconstructionJob& job);
+
+/**
+ * @brief Load a voxel reconstruction job description.
+ * The output folder is resolved from the folder of @p filepath.
+ */
+void loadVoxelReconstructionJob(const std::string& filepath, VoxelReconstructionJob& out_job);
+
+/**
+ * @brief Write one job description file per voxel of the voxels array.
+ * @return the number of voxels
+ */
+int writeVoxelsReconstructionJobs(const std::string& voxelsArrayFileName, LargeScale* ls);
+
+/**
+ * @brief Reconstruct one voxel (skipped if its mesh already exists).
+ */
+void reconstructVoxelJob(const VoxelReconstructionJob& job, ReconstructionPlan* rp, LargeScale* ls);
+
 void reconstructAccordingToOptimalReconstructionPlan(int gl, LargeScale* ls);
-void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileName, LargeScale* ls);
+
+/**
+ * @brief Reconstruct the voxels of the voxels array from index @p rangeStart to @p rangeStart + @p rangeSize
+ * (all voxels if @p rangeSize is negative). The job description files are used if they exist.
+ */
+void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileName, LargeScale* ls,
+                                            int rangeStart = 0, int rangeSize = -1);
+
+/**
+ * @brief Get the ids of the voxels without reconstructed mesh.
+ */
+std::vector<int> getNotReconstructedVoxels(const std::vector<std::string>& recsDirs);
 mesh::Mesh* joinMeshes(const std::vector<std::string>& recsDirs, StaticVector<Point3d>* voxelsArray, LargeScale* ls);
 mesh::Mesh* joinMeshes(int gl, LargeScale* ls);
 mesh::Mesh* joinMeshes(const std::string& voxelsArrayFileName, LargeScale* ls);
@@ -0,0 +1,140 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/fuseCut/ReconstructionPlan.hpp>
+#include <aliceVision/mvsUtils/common.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE reconstructionPlan
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::fuseCut;
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+/**
+ * @brief Create a voxels array of @p nbVoxels unit cubes along the x axis.
+ */
+StaticVector<Point3d> createVoxelsArray(int nbVoxels)
+{
+    StaticVector<Point3d> voxelsArray;
+    for(int i = 0; i < nbVoxels; ++i)
+    {
+        voxelsArray.push_back(Point3d(i, 0.0, 0.0));
+        voxelsArray.push_back(Point3d(i + 1, 0.0, 0.0));
+        voxelsArray.push_back(Point3d(i + 1, 1.0, 0.0));
+        voxelsArray.push_back(Point3d(i, 1.0, 0.0));
+        voxelsArray.push_back(Point3d(i, 0.0, 1.0));
+        voxelsArray.push_back(Point3d(i + 1, 0.0, 1.0));
+        voxelsArray.push_back(Point3d(i + 1, 1.0, 1.0));
+        voxelsArray.push_back(Point3d(i, 1.0, 1.0));
+    }
+    return voxelsArray;
+}
+
+void checkHexahEqual(const std::array<Point3d, 8>& a, const std::array<Point3d, 8>& b)
+{
+    for(int i = 0; i < 8; ++i)
+    {
+        BOOST_CHECK_SMALL((a[i] - b[i]).size(), 1e-9);
+    }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(ReconstructionPlan_createVoxelReconstructionJob)
+{
+    const StaticVector<Point3d> voxelsArray = createVoxelsArray(3);
+
+    const VoxelReconstructionJob firstJob = createVoxelReconstructionJob(voxelsArray, 0, "voxel0/");
+    BOOST_CHECK_EQUAL(firstJob.voxelId, 0);
+    BOOST_CHECK_EQUAL(firstJob.outputFolder, "voxel0/");
+    BOOST_CHECK(firstJob.hexahsToExclude.empty());
+
+    // each job excludes the thin hexahedrons of the previous voxels
+    const VoxelReconstructionJob lastJob = createVoxelReconstructionJob(voxelsArray, 2, "voxel2/");
+    BOOST_CHECK_EQUAL(lastJob.voxelId, 2);
+    BOOST_REQUIRE_EQUAL(lastJob.hexahsToExclude.size(), 2);
+
+    std::array<Point3d, 8> hexah;
+    std::copy(&voxelsArray[2 * 8], &voxelsArray[2 * 8] + 8, hexah.begin());
+    checkHexahEqual(lastJob.hexah, hexah);
+
+    for(int i = 0; i < 2; ++i)
+    {
+        std::array<Point3d, 8> hexahThin;
+        mvsUtils::inflateHexahedron(&voxelsArray[i * 8], &hexahThin[0], 0.9);
+        checkHexahEqual(lastJob.hexahsToExclude[i], hexahThin);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ReconstructionPlan_saveLoadVoxelReconstructionJob)
+{
+    const bfs::path rootFolder = bfs::temp_directory_path() / bfs::unique_path();
+    const bfs::path jobFolder = rootFolder / "space" / "reconstructedVoxel0001";
+    bfs::create_directories(jobFolder);
+
+    const StaticVector<Point3d> voxelsArray = createVoxelsArray(2);
+    const VoxelReconstructionJob job = createVoxelReconstructionJob(voxelsArray, 1, jobFolder.string() + "/");
+    const std::string jobFilepath = (jobFolder / "voxelJob.json").string();
+    saveVoxelReconstructionJob(jobFilepath, job);
+
+    VoxelReconstructionJob loadedJob;
+    loadVoxelReconstructionJob(jobFilepath, loadedJob);
+    BOOST_CHECK_EQUAL(loadedJob.voxelId, job.voxelId);
+    BOOST_CHECK(bfs::equivalent(loadedJob.outputFolder, jobFolder));
+    BOOST_CHECK_EQUAL(loadedJob.outputFolder.back(), '/');
+    checkHexahEqual(loadedJob.hexah, job.hexah);
+    BOOST_REQUIRE_EQUAL(loadedJob.hexahsToExclude.size(), 1);
+    checkHexahEqual(loadedJob.hexahsToExclude[0], job.hexahsToExclude[0]);
+
+    // the job file does not contain absolute paths: it is still valid once the folder is moved
+    const bfs::path movedRootFolder = bfs::temp_directory_path() / bfs::unique_path();
+    bfs::rename(rootFolder, movedRootFolder);
+    const bfs::path movedJobFolder = movedRootFolder / "space" / "reconstructedVoxel0001";
+
+    VoxelReconstructionJob movedJob;
+    loadVoxelReconstructionJob((movedJobFolder / "voxelJob.json").string(), movedJob);
+    BOOST_CHECK(bfs::equivalent(movedJob.outputFolder, movedJobFolder));
+
+    std::ifstream jobFile((movedJobFolder / "voxelJob.json").string());
+    const std::string jobFileContent((std::istreambuf_iterator<char>(jobFile)), std::istreambuf_iterator<char>());
+    BOOST_CHECK(jobFileContent.find(rootFolder.string()) == std::string::npos);
+
+    bfs::remove_all(movedRootFolder);
+}
+
+BOOST_AUTO_TEST_CASE(ReconstructionPlan_getNotReconstructedVoxels)
+{
+    const bfs::path rootFolder = bfs::temp_directory_path() / bfs::unique_path();
+
+    std::vector<std::string> recsDirs;
+    for(int i = 0; i < 3; ++i)
+    {
+        const bfs::path folder = rootFolder / ("reconstructedVoxel" + std::to_string(i));
+        bfs::create_directories(folder);
+        recsDirs.push_back(folder.string() + "/");
+    }
+
+    // voxel 0: done, voxel 1: visibilities only (interrupted), voxel 2: nothing
+    std::ofstream(recsDirs[0] + "meshPtsCamsFromDGC.bin");
+    std::ofstream(recsDirs[0] + "mesh.bin");
+    std::ofstream(recsDirs[1] + "meshPtsCamsFromDGC.bin");
+
+    const std::vector<int> notReconstructed = getNotReconstructedVoxels(recsDirs);
+    BOOST_CHECK(notReconstructed == std::vector<int>({1, 2}));
+
+    bfs::remove_all(rootFolder);
+}
@@ -0,0 +1,69 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ImagePool.hpp"
+
+#include <atomic>
+
+namespace aliceVision {
+namespace image {
+
+namespace {
+
+std::atomic<bool> imagePoolEnabled(true);
+std::atomic<std::size_t> nbAllocations(0);
+std::atomic<std::size_t> allocatedBytes(0);
+std::atomic<std::size_t> nbReuses(0);
+std::atomic<std::size_t> nbReleases(0);
+
+} // namespace
+
+ImagePoolStatistics getImagePoolStatistics()
+{
+  ImagePoolStatistics statistics;
+  statistics.nbAllocations = nbAllocations;
+  statistics.allocatedBytes = allocatedBytes;
+  statistics.nbReuses = nbReuses;
+  statistics.nbReleases = nbReleases;
+  return statistics;
+}
+
+void resetImagePoolStatistics()
+{
+  nbAllocations = 0;
+  allocatedBytes = 0;
+  nbReuses = 0;
+  nbReleases = 0;
+}
+
+void setImagePoolEnabled(bool enabled)
+{
+  imagePoolEnabled = enabled;
+}
+
+bool isImagePoolEnabled()
+{
+  return imagePoolEnabled;
+}
+
+void countImagePoolAllocation(std::size_t bytes)
+{
+  ++nbAllocations;
+  allocatedBytes += bytes;
+}
+
+void countImagePoolReuse()
+{
+  ++nbReuses;
+}
+
+void countImagePoolRelease()
+{
+  ++nbReleases;
+}
+
+} // namespace image
+} // namespace aliceVision
@@ -0,0 +1,320 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/image/Image.hpp>
+
+#include <cstddef>
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace aliceVision {
+namespace image {
+
+/// Default amount of memory kept by an image pool (in bytes)
+const std::size_t defaultImagePoolCapacity = std::size_t(1) << 30;
+
+/// Default amount of memory kept by each thread-local image pool (in bytes), see ImagePool::local
+const std::size_t defaultLocalImagePoolCapacity = std::size_t(128) << 20;
+
+/**
+ * @brief Allocation counters of the image buffers resized through the image pools (all threads).
+ */
+struct ImagePoolStatistics
+{
+  /// buffers allocated: no pooled buffer of the requested size (or the pools are disabled)
+  std::size_t nbAllocations = 0;
+  /// bytes of the allocated buffers
+  std::size_t allocatedBytes = 0;
+  /// buffers taken from a pool instead of being allocated
+  std::size_t nbReuses = 0;
+  /// buffers given back to a pool
+  std::size_t nbReleases = 0;
+};
+
+/**
+ * @brief Get the allocation counters of the image pools since the last reset.
+ */
+ImagePoolStatistics getImagePoolStatistics();
+
+void resetImagePoolStatistics();
+
+/**
+ * @brief Enable or disable the image pools (enabled by default).
+ * Once disabled, ImagePool::resize allocates the buffers and ImagePool::release frees them.
+ */
+void setImagePoolEnabled(bool enabled);
+
+bool isImagePoolEnabled();
+
+void countImagePoolAllocation(std::size_t bytes);
+void countImagePoolReuse();
+void countImagePoolRelease();
+
+/**
+ * @brief Pool of image buffers, to avoid allocating and freeing the same large buffers
+ * for each image (pyramid levels, scale space slices, conversions...).
+ *
+ * The buffers are sorted by resolution class, i.e. by number of pixels: a buffer can be reused
+ * by any image with the same number of pixels, whatever its width and height, without reallocation.
+ * The buffers keep the alignment of the Eigen allocations.
+ * The pool is thread safe, but local() gives a pool per thread to avoid the contention
+ * and to keep the buffers in the memory of the thread which uses them.
+ * The thread-local pools share a small capacity (see setLocalPoolsCapacity) and are never
+ * trimmed by themselves: the callers free them with clearLocalPools once a job is done.
+ */
+template <typename T>
+class ImagePool
+{
+public:
+  typedef typename Image<T>::Base Buffer;
+
+  /**
+   * @param[in] capacity the maximum amount of memory kept by the pool (in bytes)
+   */
+  explicit ImagePool(std::size_t capacity = defaultImagePoolCapacity)
+    : _capacity(capacity)
+  {}
+
+  ImagePool(const ImagePool&) = delete;
+  ImagePool& operator=(const ImagePool&) = delete;
+
+  /**
+   * @brief Get the pool of the calling thread
+   */
+  static ImagePool& local()
+  {
+    thread_local LocalPool localPool;
+    return localPool.pool;
+  }
+
+  /**
+   * @brief Set the maximum amount of memory kept by each thread-local pool (in bytes),
+   * the current pools free their oldest buffers over the new capacity
+   */
+  static void setLocalPoolsCapacity(std::size_t capacity)
+  {
+    LocalPools& localPools = getLocalPools();
+    std::lock_guard<std::mutex> lock(localPools.mutex);
+    localPools.capacity = capacity;
+    for(ImagePool* pool : localPools.pools)
+      pool->setCapacity(capacity);
+  }
+
+  /**
+   * @brief Free the pooled buffers of the thread-local pools of all the threads
+   * @note the buffers in use are not affected
+   */
+  static void clearLocalPools()
+  {
+    LocalPools& localPools = getLocalPools();
+    std::lock_guard<std::mutex> lock(localPools.mutex);
+    for(ImagePool* pool : localPools.pools)
+      pool->clear();
+  }
+
+  /**
+   * @brief Get the amount of memory kept by the thread-local pools of all the threads (in bytes)
+   */
+  static std::size_t localPoolsPooledBytes()
+  {
+    LocalPools& localPools = getLocalPools();
+    std::lock_guard<std::mutex> lock(localPools.mutex);
+    std::size_t pooledBytes = 0;
+    for(const ImagePool* pool : localPools.pools)
+      pooledBytes += pool->pooledBytes();
+    return pooledBytes;
+  }
+
+  /**
+   * @brief Resize an image without initializing its pixels.
+   * If the image buffer does not have the requested number of pixels,
+   * it is given back to the pool and replaced by a pooled buffer (or a new one).
+   * @param[in,out] image the image to resize
+   * @param[in] width the new width
+   * @param[in] height the new height
+   */
+  void resize(Image<T>& image, int width, int height)
+  {
+    const std::size_t nbPixels = static_cast<std::size_t>(width) * height;
+
+    if(static_cast<std::size_t>(image.size()) != nbPixels)
+    {
+      release(image);
+
+      if(nbPixels != 0 && !take(nbPixels, image))
+        countImagePoolAllocation(nbPixels * sizeof(T));
+    }
+    // same number of pixels: Eigen keeps the buffer
+    image.resize(width, height, false);
+  }
+
+  /**
+   * @brief Give the image buffer back to the pool, the image is empty after the call.
+   * If the pool is full, the oldest buffers of the other resolutions are freed first,
+   * the buffer is freed if there is still no room or if the pool is disabled.
+   * @param[in,out] image the image to release
+   */
+  void release(Image<T>& image)
+  {
+    const std::size_t nbPixels = static_cast<std::size_t>(image.size());
+    if(nbPixels == 0)
+      return;
+
+    const std::size_t bytes = nbPixels * sizeof(T);
+    if(isImagePoolEnabled())
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      evictOtherResolutions(nbPixels, bytes);
+      if(_pooledBytes + bytes <= _capacity)
+      {
+        std::deque<PooledBuffer>& buffers = _buffers[nbPixels];
+        buffers.emplace_back();
+        buffers.back().releaseIndex = _nbReleases++;
+        buffers.back().buffer.swap(image); // swap the pointers, no copy
+        _pooledBytes += bytes;
+        countImagePoolRelease();
+        return;
+      }
+    }
+    image.resize(0, 0, false);
+  }
+
+  /**
+   * @brief Free all the pooled buffers
+   */
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _buffers.clear();
+    _pooledBytes = 0;
+  }
+
+  /**
+   * @brief Set the maximum amount of memory kept by the pool (in bytes),
+   * the oldest buffers over the new capacity are freed
+   */
+  void setCapacity(std::size_t capacity)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _capacity = capacity;
+    evictOtherResolutions(0, 0);
+  }
+
+  /**
+   * @brief Get the amount of memory kept by the pool (in bytes)
+   */
+  std::size_t pooledBytes() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _pooledBytes;
+  }
+
+private:
+  /// Registry of the thread-local pools
+  struct LocalPools
+  {
+    std::mutex mutex;
+    std::size_t capacity = defaultLocalImagePoolCapacity;
+    std::vector<ImagePool*> pools;
+  };
+
+  static LocalPools& getLocalPools()
+  {
+    static LocalPools localPools;
+    return localPools;
+  }
+
+  /// Thread-local pool, registered while its thread is alive
+  struct LocalPool
+  {
+    ImagePool pool;
+
+    LocalPool()
+      : pool(0)
+    {
+      LocalPools& localPools = getLocalPools();
+      std::lock_guard<std::mutex> lock(localPools.mutex);
+      pool.setCapacity(localPools.capacity);
+      localPools.pools.push_back(&pool);
+    }
+
+    ~LocalPool()
+    {
+      LocalPools& localPools = getLocalPools();
+      std::lock_guard<std::mutex> lock(localPools.mutex);
+      localPools.pools.erase(std::remove(localPools.pools.begin(), localPools.pools.end(), &pool), localPools.pools.end());
+    }
+  };
+
+  struct PooledBuffer
+  {
+    std::size_t releaseIndex = 0; //< order of the release, to find the oldest buffers
+    Buffer buffer;
+  };
+
+  /**
+   * @brief Free the oldest buffers of the other resolutions until the given amount of memory fits in the pool
+   * @note the mutex must be locked, nbPixels = 0 frees the buffers of all the resolutions
+   */
+  void evictOtherResolutions(std::size_t nbPixels, std::size_t bytes)
+  {
+    while(_pooledBytes + bytes > _capacity)
+    {
+      auto oldest = _buffers.end();
+      for(auto it = _buffers.begin(); it != _buffers.end(); ++it)
+      {
+        if(it->first != nbPixels && (oldest == _buffers.end() ||
+           it->second.front().releaseIndex < oldest->second.front().releaseIndex))
+          oldest = it;
+      }
+      if(oldest == _buffers.end())
+        return;
+
+      oldest->second.pop_front();
+      _pooledBytes -= oldest->first * sizeof(T);
+      if(oldest->second.empty())
+        _buffers.erase(oldest);
+    }
+  }
+
+  /**
+   * @brief Move a pooled buffer of the given number of pixels into an empty image
+   * @return false if there is no pooled buffer of this size
+   */
+  bool take(std::size_t nbPixels, Image<T>& image)
+  {
+    if(!isImagePoolEnabled())
+      return false;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _buffers.find(nbPixels);
+    if(it == _buffers.end() || it->second.empty())
+      return false;
+
+    image.swap(it->second.back().buffer);
+    it->second.pop_back();
+    if(it->second.empty())
+      _buffers.erase(it);
+    _pooledBytes -= nbPixels * sizeof(T);
+    countImagePoolReuse();
+    return true;
+  }
+
+  std::size_t _capacity;
+  std::size_t _pooledBytes = 0;
+  std::size_t _nbReleases = 0;
+  /// pooled buffers per number of pixels, from the oldest to the most recently released
+  std::map<std::size_t, std::deque<PooledBuffer>> _buffers;
+  mutable std::mutex _mutex;
+};
+
+} // namespace image
+} // namespace aliceVision
@@ -7,72 +7,298 @@
 
 #include "convolution.hpp"
 
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+#include <xmmintrin.h>
+#endif
+
 namespace aliceVision {
 namespace image {
 
-void SeparableConvolution2d(const RowMatrixXf& image,
-                            const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
-                            const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
-                            RowMatrixXf* out) {
-  const int sigma_y = static_cast<int>( kernel_y.cols() );
-  const int half_sigma_y = static_cast<int>( kernel_y.cols() ) / 2;
+namespace {
 
-  // Convolving a vertical filter across rows is the same thing as transpose
-  // multiply i.e. kernel_y^t * rows. This will give us the convoled value for
-  // each row. However, care must be taken at the top and bottom borders.
-  const Eigen::Matrix<float, 1, Eigen::Dynamic> reverse_kernel_y = kernel_y.reverse();
+/// number of output columns per tile: ksize rows of a tile stay in the L2 cache
+const int tileCols = 512;
+/// number of output rows processed by a thread at once
+const int bandRows = 16;
 
-  #pragma omp parallel for schedule(dynamic)
-  for (int i = 0; i < half_sigma_y; i++)
+/**
+ * @brief Mirror an index into [0, size[ without repeating the border element
+ */
+inline int mirrorIndex(int i, int size)
+{
+  if(size == 1)
+    return 0;
+  const int period = 2 * size - 2;
+  i %= period;
+  if(i < 0)
+    i += period;
+  return (i < size) ? i : period - i;
+}
+
+/**
+ * @brief Symmetry of a kernel: 1 if k[i] == k[n-1-i], -1 if k[i] == -k[n-1-i], 0 otherwise
+ * The taps of (anti)symmetric kernels are folded: each weight is multiplied once for two taps.
+ */
+int kernelSymmetry(const float* kernel, int ksize)
+{
+  bool symmetric = true;
+  bool antisymmetric = true;
+  for(int i = 0; i < ksize; ++i)
   {
-    const int forward_size = i + half_sigma_y + 1;
-    const int reverse_size = sigma_y - forward_size;
-    out->row(i) = kernel_y.tail(forward_size) *
-                  image.block(0, 0, forward_size, image.cols()) +
-                  reverse_kernel_y.tail(reverse_size) *
-                  image.block(1, 0, reverse_size, image.cols());
-
-    // Apply the same technique for the end rows.
-    out->row(image.rows() - i - 1) =
-      kernel_y.head(forward_size) *
-      image.block(image.rows() - forward_size, 0, forward_size, image.cols())
-      +
-      reverse_kernel_y.head(reverse_size) *
-      image.block(image.rows() - reverse_size - 1, 0, reverse_size, image.cols());
+    symmetric &= (kernel[i] == kernel[ksize - 1 - i]);
+    antisymmetric &= (kernel[i] == -kernel[ksize - 1 - i]);
   }
+  return symmetric ? 1 : (antisymmetric ? -1 : 0);
+}
 
-  // Applying the rest of the y filter.
-  #pragma omp parallel for schedule(dynamic)
-  for (int row = half_sigma_y; row < image.rows() - half_sigma_y; row++)
+/// Sum of the tap values a and b (difference for antisymmetric kernels), a only for asymmetric kernels
+template <int Symmetry>
+inline float foldTaps(const float* a, const float* b)
+{
+  return (Symmetry == 0) ? *a : ((Symmetry > 0) ? *a + *b : *a - *b);
+}
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+/// Load 4 values: p[0], p[Step], p[2 * Step], p[3 * Step] (Step = 1 or 2)
+template <int Step>
+inline __m128 loadValues(const float* p)
+{
+  if(Step == 1)
+    return _mm_loadu_ps(p);
+  // keep the even elements of p[0, 8[
+  return _mm_shuffle_ps(_mm_loadu_ps(p), _mm_loadu_ps(p + 4), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+template <int Symmetry, int Step>
+inline __m128 foldTaps(const float* a, const float* b)
+{
+  if(Symmetry == 0)
+    return loadValues<Step>(a);
+  if(Symmetry > 0)
+    return _mm_add_ps(loadValues<Step>(a), loadValues<Step>(b));
+  return _mm_sub_ps(loadValues<Step>(a), loadValues<Step>(b));
+}
+#endif
+
+/**
+ * @brief Vertical pass: out[x] = sum_k kernel[k] * rows[k][offset + x], x in [0, size[
+ */
+template <int Symmetry>
+void convolveRows(const float* const* rows, const float* kernel, int ksize, int offset, int size, float* out)
+{
+  const int half = ksize / 2;
+  // folded kernels: the center tap initializes the sum, the other weights are used for two rows
+  const int nbTaps = (Symmetry == 0) ? ksize : half;
+  const float centerWeight = (Symmetry == 0) ? 0.f : kernel[half];
+
+  int x = 0;
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+  const __m128 center = _mm_set1_ps(centerWeight);
+  // 4 independent sums hide the latency of the additions
+  for(; x + 16 <= size; x += 16)
+  {
+    const float* c = rows[half] + offset + x;
+    __m128 sum0 = _mm_mul_ps(center, _mm_loadu_ps(c));
+    __m128 sum1 = _mm_mul_ps(center, _mm_loadu_ps(c + 4));
+    __m128 sum2 = _mm_mul_ps(center, _mm_loadu_ps(c + 8));
+    __m128 sum3 = _mm_mul_ps(center, _mm_loadu_ps(c + 12));
+    for(int k = 0; k < nbTaps; ++k)
+    {
+      const __m128 weight = _mm_set1_ps(kernel[k]);
+      const float* a = rows[k] + offset + x;
+      const float* b = rows[ksize - 1 - k] + offset + x;
+      sum0 = _mm_add_ps(sum0, _mm_mul_ps(weight, foldTaps<Symmetry, 1>(a, b)));
+      sum1 = _mm_add_ps(sum1, _mm_mul_ps(weight, foldTaps<Symmetry, 1>(a + 4, b + 4)));
+      sum2 = _mm_add_ps(sum2, _mm_mul_ps(weight, foldTaps<Symmetry, 1>(a + 8, b + 8)));
+      sum3 = _mm_add_ps(sum3, _mm_mul_ps(weight, foldTaps<Symmetry, 1>(a + 12, b + 12)));
+    }
+    _mm_storeu_ps(out + x, sum0);
+    _mm_storeu_ps(out + x + 4, sum1);
+    _mm_storeu_ps(out + x + 8, sum2);
+    _mm_storeu_ps(out + x + 12, sum3);
+  }
+  for(; x + 4 <= size; x += 4)
+  {
+    __m128 sum = _mm_mul_ps(center, _mm_loadu_ps(rows[half] + offset + x));
+    for(int k = 0; k < nbTaps; ++k)
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel[k]), foldTaps<Symmetry, 1>(rows[k] + offset + x, rows[ksize - 1 - k] + offset + x)));
+    _mm_storeu_ps(out + x, sum);
+  }
+#endif
+  for(; x < size; ++x)
   {
-    out->row(row) =  kernel_y * image.block(row - half_sigma_y, 0, sigma_y, out->cols());
+    float sum = centerWeight * rows[half][offset + x];
+    for(int k = 0; k < nbTaps; ++k)
+      sum += kernel[k] * foldTaps<Symmetry>(rows[k] + offset + x, rows[ksize - 1 - k] + offset + x);
+    out[x] = sum;
   }
+}
 
-  const int sigma_x = static_cast<int>(kernel_x.cols());
-  const int half_sigma_x = static_cast<int>(kernel_x.cols() / 2);
+/**
+ * @brief Horizontal pass: out[j] = sum_k kernel[k] * line[j * Step + k], j in [0, size[
+ * @note line must be readable up to (size - 1) * Step + ksize + 8
+ */
+template <int Symmetry, int Step>
+void convolveLine(const float* line, const float* kernel, int ksize, int size, float* out)
+{
+  const int half = ksize / 2;
+  const int nbTaps = (Symmetry == 0) ? ksize : half;
+  const float centerWeight = (Symmetry == 0) ? 0.f : kernel[half];
 
-  // Convolving with the horizontal filter is easy. Rather than using the kernel
-  // as a sliding window, we use the row pixels as a sliding window around the
-  // filter. We prepend and append the proper border values so that we are sure
-  // to end up with the correct convolved values.
-  Eigen::RowVectorXf temp_row(image.cols() + sigma_x - 1);
+  int j = 0;
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+  const __m128 center = _mm_set1_ps(centerWeight);
+  const int vectorStride = 4 * Step;
+  for(; j + 16 <= size; j += 16)
+  {
+    const float* src = line + j * Step;
+    __m128 sum0 = _mm_mul_ps(center, loadValues<Step>(src + half));
+    __m128 sum1 = _mm_mul_ps(center, loadValues<Step>(src + half + vectorStride));
+    __m128 sum2 = _mm_mul_ps(center, loadValues<Step>(src + half + 2 * vectorStride));
+    __m128 sum3 = _mm_mul_ps(center, loadValues<Step>(src + half + 3 * vectorStride));
+    for(int k = 0; k < nbTaps; ++k)
+    {
+      const __m128 weight = _mm_set1_ps(kernel[k]);
+      const float* a = src + k;
+      const float* b = src + ksize - 1 - k;
+      sum0 = _mm_add_ps(sum0, _mm_mul_ps(weight, foldTaps<Symmetry, Step>(a, b)));
+      sum1 = _mm_add_ps(sum1, _mm_mul_ps(weight, foldTaps<Symmetry, Step>(a + vectorStride, b + vectorStride)));
+      sum2 = _mm_add_ps(sum2, _mm_mul_ps(weight, foldTaps<Symmetry, Step>(a + 2 * vectorStride, b + 2 * vectorStride)));
+      sum3 = _mm_add_ps(sum3, _mm_mul_ps(weight, foldTaps<Symmetry, Step>(a + 3 * vectorStride, b + 3 * vectorStride)));
+    }
+    _mm_storeu_ps(out + j, sum0);
+    _mm_storeu_ps(out + j + 4, sum1);
+    _mm_storeu_ps(out + j + 8, sum2);
+    _mm_storeu_ps(out + j + 12, sum3);
+  }
+  for(; j + 4 <= size; j += 4)
+  {
+    const float* src = line + j * Step;
+    __m128 sum = _mm_mul_ps(center, loadValues<Step>(src + half));
+    for(int k = 0; k < nbTaps; ++k)
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel[k]), foldTaps<Symmetry, Step>(src + k, src + ksize - 1 - k)));
+    _mm_storeu_ps(out + j, sum);
+  }
+#endif
+  for(; j < size; ++j)
+  {
+    const float* src = line + j * Step;
+    float sum = centerWeight * src[half];
+    for(int k = 0; k < nbTaps; ++k)
+      sum += kernel[k] * foldTaps<Symmetry>(src + k, src + ksize - 1 - k);
+    out[j] = sum;
+  }
+}
+
+typedef void (*ConvolveRowsFunction)(const float* const*, const float*, int, int, int, float*);
+typedef void (*ConvolveLineFunction)(const float*, const float*, int, int, float*);
 
-  #pragma omp parallel for firstprivate(temp_row), schedule(dynamic)
-  for (int row = 0; row < out->rows(); row++)
+ConvolveRowsFunction getConvolveRowsFunction(int symmetry)
+{
+  switch(symmetry)
   {
-    temp_row.head(half_sigma_x) =
-      out->row(row).segment(1, half_sigma_x).reverse();
-    temp_row.segment(half_sigma_x, image.cols()) = out->row(row);
-    temp_row.tail(half_sigma_x) =
-      out->row(row)
-      .segment(image.cols() - 2 - half_sigma_x, half_sigma_x)
-      .reverse();
-
-    // Convolve the row. We perform the first step here explicitly so that we
-    // avoid setting the row equal to zero.
-    out->row(row) = kernel_x(0) * temp_row.head(image.cols());
-    for (int i = 1; i < sigma_x; i++) {
-      out->row(row) += kernel_x(i) * temp_row.segment(i, image.cols());
+    case 1:  return &convolveRows<1>;
+    case -1: return &convolveRows<-1>;
+    default: return &convolveRows<0>;
+  }
+}
+
+ConvolveLineFunction getConvolveLineFunction(int symmetry, int step)
+{
+  if(step == 1)
+  {
+    switch(symmetry)
+    {
+      case 1:  return &convolveLine<1, 1>;
+      case -1: return &convolveLine<-1, 1>;
+      default: return &convolveLine<0, 1>;
+    }
+  }
+  switch(symmetry)
+  {
+    case 1:  return &convolveLine<1, 2>;
+    case -1: return &convolveLine<-1, 2>;
+    default: return &convolveLine<0, 2>;
+  }
+}
+
+} // namespace
+
+void SeparableConvolution2d(const RowMatrixXf& image,
+                            const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
+                            const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
+                            RowMatrixXf* out,
+                            int step)
+{
+  assert(kernel_x.size() % 2 == 1 && kernel_y.size() % 2 == 1);
+  assert(step == 1 || step == 2);
+
+  if(&image == out)
+  {
+    const RowMatrixXf copy(image);
+    SeparableConvolution2d(copy, kernel_x, kernel_y, out, step);
+    return;
+  }
+
+  const int rows = static_cast<int>(image.rows());
+  const int cols = static_cast<int>(image.cols());
+  const int outRows = (rows + step - 1) / step;
+  const int outCols = (cols + step - 1) / step;
+
+  out->resize(outRows, outCols);
+  if(outRows == 0 || outCols == 0)
+    return;
+
+  const int ksize_x = static_cast<int>(kernel_x.size());
+  const int ksize_y = static_cast<int>(kernel_y.size());
+  const int half_x = ksize_x / 2;
+  const int half_y = ksize_y / 2;
+  const int nbBands = (outRows + bandRows - 1) / bandRows;
+
+  const ConvolveRowsFunction convolveRowsFunction = getConvolveRowsFunction(kernelSymmetry(kernel_y.data(), ksize_y));
+  const ConvolveLineFunction convolveLineFunction = getConvolveLineFunction(kernelSymmetry(kernel_x.data(), ksize_x), step);
+
+  #pragma omp parallel
+  {
+    std::vector<const float*> kernelRows(ksize_y);
+    // vertical pass result of a tile row, with the horizontal borders
+    std::vector<float> line((tileCols - 1) * step + ksize_x + 8, 0.f);
+
+    #pragma omp for schedule(dynamic)
+    for(int band = 0; band < nbBands; ++band)
+    {
+      const int rowBegin = band * bandRows;
+      const int rowEnd = std::min(outRows, rowBegin + bandRows);
+
+      for(int tileBegin = 0; tileBegin < outCols; tileBegin += tileCols)
+      {
+        const int tileEnd = std::min(outCols, tileBegin + tileCols);
+
+        // input columns [xBegin, xEnd[ are needed by the horizontal pass,
+        // those in [cBegin, cEnd[ lie inside the image
+        const int xBegin = tileBegin * step - half_x;
+        const int xEnd = (tileEnd - 1) * step + half_x + 1;
+        const int cBegin = std::max(0, xBegin);
+        const int cEnd = std::min(cols, xEnd);
+
+        for(int row = rowBegin; row < rowEnd; ++row)
+        {
+          const int inRow = row * step;
+          for(int k = 0; k < ksize_y; ++k)
+            kernelRows[k] = image.data() + std::size_t(mirrorIndex(inRow + k - half_y, rows)) * cols;
+
+          convolveRowsFunction(kernelRows.data(), kernel_y.data(), ksize_y, cBegin, cEnd - cBegin, &line[cBegin - xBegin]);
+
+          // the vertical pass does not depend on the other columns: mirror its result
+          for(int x = xBegin; x < cBegin; ++x)
+            line[x - xBegin] = line[mirrorIndex(x, cols) - xBegin];
+          for(int x = cEnd; x < xEnd; ++x)
+            line[x - xBegin] = line[mirrorIndex(x, cols) - xBegin];
+
+          convolveLineFunction(line.data(), kernel_x.data(), ksize_x, tileEnd - tileBegin,
+                               out->data() + std::size_t(row) * outCols + tileBegin);
+        }
+      }
     }
   }
 }
@@ -13,6 +13,8 @@
 #include <aliceVision/image/Image.hpp>
 #include <aliceVision/config.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <vector>
 #include <cassert>
 
@@ -73,7 +75,7 @@ void ImageConvolution( const Image & img , const Mat & kernel , Image & out)
 
 /**
  ** Horizontal (1d) convolution
- ** assume kernel has odd size
+ ** assume kernel has odd size (border pixels are copied)
  ** @param img Input image
  ** @param kernel convolution kernel
  ** @param out Output image
@@ -91,33 +93,38 @@ void ImageHorizontalConvolution( const ImageTypeIn & img , const Kernel & kernel
   const int kernel_width = kernel.size() ;
   const int half_kernel_width = kernel_width / 2 ;
 
-  std::vector<pix_t, Eigen::aligned_allocator<pix_t> > line( cols + kernel_width );
-
-  for( int row = 0 ; row < rows ; ++row )
+  #pragma omp parallel if( rows * cols > 65536 )
   {
-    // Copy line
-    const pix_t start_pix = img.coeffRef( row , 0 ) ;
-    for( int k = 0 ; k < half_kernel_width ; ++k ) // pad before
-    {
-      line[ k ] = start_pix ;
-    }
-    memcpy(&line[0] + half_kernel_width, img.data() + row * cols, sizeof(pix_t) * cols);
-    const pix_t end_pix = img.coeffRef( row , cols - 1 ) ;
-    for( int k = 0 ; k < half_kernel_width ; ++k ) // pad after
+    std::vector<pix_t, Eigen::aligned_allocator<pix_t> > line( cols + kernel_width );
+
+    #pragma omp for
+    for( int row = 0 ; row < rows ; ++row )
     {
-      line[ k + half_kernel_width + cols ] = end_pix ;
-    }
+      // Copy line
+      const pix_t start_pix = img.coeffRef( row , 0 ) ;
+      for( int k = 0 ; k < half_kernel_width ; ++k ) // pad before
+      {
+        line[ k ] = start_pix ;
+      }
+      memcpy(&line[0] + half_kernel_width, img.data() + row * cols, sizeof(pix_t) * cols);
+      const pix_t end_pix = img.coeffRef( row , cols - 1 ) ;
+      for( int k = 0 ; k < half_kernel_width ; ++k ) // pad after
+      {
+        line[ k + half_kernel_width + cols ] = end_pix ;
+      }
 
-    // Apply convolution
-    conv_buffer_( &line[0] , kernel.data() , cols , kernel_width );
+      // Apply convolution
+      conv_buffer_( &line[0] , kernel.data() , cols , kernel_width );
 
-    memcpy(out.data() + row * cols, &line[0], sizeof(pix_t) * cols);
+      memcpy(out.data() + row * cols, &line[0], sizeof(pix_t) * cols);
+    }
   }
 }
 
 /**
  ** Vertical (1d) convolution
- ** assume kernel has odd size
+ ** assume kernel has odd size (border pixels are copied)
+ ** The rows are accumulated one after the other (row-major access, no strided column walk).
  ** @param img Input image
  ** @param kernel convolution kernel
  ** @param out Output image
@@ -126,6 +133,7 @@ template< typename ImageTypeIn , typename ImageTypeOut, typename Kernel >
 void ImageVerticalConvolution( const ImageTypeIn & img , const Kernel & kernel , ImageTypeOut & out)
 {
   typedef typename ImageTypeIn::Tpixel pix_t ;
+  typedef typename Kernel::Scalar kernel_t ;
 
   const int kernel_width = kernel.size() ;
   const int half_kernel_width = kernel_width / 2 ;
@@ -133,32 +141,43 @@ void ImageVerticalConvolution( const ImageTypeIn & img , const Kernel & kernel ,
   const int rows = img.rows() ;
   const int cols = img.cols() ;
 
-  out.resize( cols , rows ) ;
+  // the output rows are written while the input rows are still read
+  if( static_cast<const void*>( &img ) == static_cast<const void*>( &out ) )
+  {
+    const ImageTypeIn copy( img ) ;
+    ImageVerticalConvolution( copy , kernel , out ) ;
+    return ;
+  }
 
-  std::vector<pix_t, Eigen::aligned_allocator<pix_t> > line( rows + kernel_width );
+  out.resize( cols , rows ) ;
 
-  for( int col = 0 ; col < cols ; ++col )
+  #pragma omp parallel if( rows * cols > 65536 )
   {
-    // Copy column
-    for( int k = 0 ; k < half_kernel_width ; ++k )
-    {
-      line[ k ] = img.coeffRef( 0 , col ) ;
-    }
-    for( int k = 0 ; k < rows ; ++k )
-    {
-      line[ k + half_kernel_width ] = img.coeffRef( k , col ) ;
-    }
-    for( int k = 0 ; k < half_kernel_width ; ++k )
-    {
-      line[ k + half_kernel_width + rows ] = img.coeffRef( rows - 1 , col ) ;
-    }
-
-    // Apply convolution
-    conv_buffer_( &line[0] , kernel.data() , rows , kernel_width );
+    std::vector<kernel_t> sum( cols );
 
+    #pragma omp for
     for( int row = 0 ; row < rows ; ++row )
     {
-      out.coeffRef( row , col ) = line[row];
+      std::fill( sum.begin() , sum.end() , kernel_t( 0 ) ) ;
+
+      for( int k = 0 ; k < kernel_width ; ++k )
+      {
+        int idy = row + k - half_kernel_width ;
+        idy = idy < 0 ? 0 : ( idy >= rows ? rows - 1 : idy ) ;
+
+        const pix_t * line = img.data() + idy * cols ;
+        const kernel_t weight = kernel( k ) ;
+        for( int col = 0 ; col < cols ; ++col )
+        {
+          sum[ col ] += line[ col ] * weight ;
+        }
+      }
+
+      pix_t * outLine = out.data() + row * cols ;
+      for( int col = 0 ; col < cols ; ++col )
+      {
+        outLine[ col ] = sum[ col ] ;
+      }
     }
   }
 }
@@ -190,11 +209,22 @@ void ImageSeparableConvolution( const ImageType & img ,
 
 typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXf;
 
-/// Specialization for Float based image (for arbitrary sized kernel)
+/**
+ ** Separable 2D convolution of a float image (for arbitrary sized kernel, mirrored borders)
+ ** The image is processed by tiles of columns: the vertical pass walks the rows of the tile
+ ** and its result is convolved horizontally while it is still in cache (SSE when available).
+ ** @param image source image
+ ** @param kernel_x horizontal kernel (odd size)
+ ** @param kernel_y vertical kernel (odd size)
+ ** @param[out] out output image (resized, must not alias the source image)
+ ** @param step output sampling step (1 or 2): with step = 2, only the even rows and columns are computed
+ **        (fused blur and half sample, the output size is ((cols + 1) / 2, (rows + 1) / 2))
+ **/
 void SeparableConvolution2d(const RowMatrixXf& image,
                             const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
                             const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
-                            RowMatrixXf* out);
+                            RowMatrixXf* out,
+                            int step = 1);
 
 // Specialization for Image<float> in order to use SeparableConvolution2d
 template<typename Kernel>
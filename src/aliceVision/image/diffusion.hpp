@@ -218,23 +218,108 @@ void ImageFED( const Image & src , const Image & diff , const typename Image::Tp
   }
 }
 
+/**
+** Apply one Fast Explicit Diffusion step to an Image: out = src + FED(src)
+** The diffusion and the update are computed in a single pass, rows in parallel.
+** The borders (including the corners) only use their neighbors inside the image.
+** @param src input image
+** @param diff diffusion coefficient image
+** @param t diffusion time
+** @param out output image (must not alias src)
+**/
+template< typename Image >
+void ImageFEDStep( const Image & src , const Image & diff , const typename Image::Tpixel t , Image & out )
+{
+  typedef typename Image::Tpixel Real ;
+  const int width = src.Width() ;
+  const int height = src.Height() ;
+  const Real half_t = t * static_cast<Real>( 0.5 ) ;
+  out.resize( width , height ) ;
+
+  #pragma omp parallel for if( width * height > 65536 )
+  for( int i = 0 ; i < height ; ++i )
+  {
+    const Real * srcRow = src.data() + i * width ;
+    const Real * diffRow = diff.data() + i * width ;
+    const Real * srcUp = srcRow - width ;
+    const Real * diffUp = diffRow - width ;
+    const Real * srcDown = srcRow + width ;
+    const Real * diffDown = diffRow + width ;
+    Real * outRow = out.data() + i * width ;
+
+    const bool hasUp = ( i > 0 ) ;
+    const bool hasDown = ( i < height - 1 ) ;
+
+    // same terms as ImageFEDCentral: a - c + d - b
+    const auto borderPixel = [&]( int j )
+    {
+      const Real cur_src = srcRow[ j ] ;
+      const Real cur_diff = diffRow[ j ] ;
+      Real value = 0 ;
+      if( j < width - 1 )
+        value += ( cur_diff + diffRow[ j + 1 ] ) * ( srcRow[ j + 1 ] - cur_src ) ;
+      if( j > 0 )
+        value -= ( cur_diff + diffRow[ j - 1 ] ) * ( cur_src - srcRow[ j - 1 ] ) ;
+      if( hasDown )
+        value += ( cur_diff + diffDown[ j ] ) * ( srcDown[ j ] - cur_src ) ;
+      if( hasUp )
+        value -= ( cur_diff + diffUp[ j ] ) * ( cur_src - srcUp[ j ] ) ;
+      outRow[ j ] = cur_src + half_t * value ;
+    } ;
+
+    if( !hasUp || !hasDown )
+    {
+      for( int j = 0 ; j < width ; ++j )
+        borderPixel( j ) ;
+      continue ;
+    }
+
+    borderPixel( 0 ) ;
+    for( int j = 1 ; j < width - 1 ; ++j )
+    {
+      const Real cur_src = srcRow[ j ] ;
+      const Real cur_diff = diffRow[ j ] ;
+      const Real a = ( cur_diff + diffRow[ j + 1 ] ) * ( srcRow[ j + 1 ] - cur_src ) ;
+      const Real b = ( cur_diff + diffUp[ j ] ) * ( cur_src - srcUp[ j ] ) ;
+      const Real c = ( cur_diff + diffRow[ j - 1 ] ) * ( cur_src - srcRow[ j - 1 ] ) ;
+      const Real d = ( cur_diff + diffDown[ j ] ) * ( srcDown[ j ] - cur_src ) ;
+      outRow[ j ] = cur_src + half_t * ( a - c + d - b ) ;
+    }
+    if( width > 1 )
+      borderPixel( width - 1 ) ;
+  }
+}
+
 /**
  ** Compute Fast Explicit Diffusion cycle
  ** @param self input/output image
  ** @param diff diffusion coefficient
  ** @param tau cycle timing vector
+ ** @param buffer temporary image (reused if it already has the size of self)
  **/
 template< typename Image >
-void ImageFEDCycle( Image & self , const Image & diff , const std::vector< typename Image::Tpixel > & tau )
+void ImageFEDCycle( Image & self , const Image & diff , const std::vector< typename Image::Tpixel > & tau , Image & buffer )
 {
-  Image tmp;
   for( int i = 0 ; i < tau.size() ; ++i )
   {
-    ImageFED( self , diff , tau[i] , tmp ) ;
-    self.array() += tmp.array();
+    ImageFEDStep( self , diff , tau[i] , buffer ) ;
+    self.swap( buffer ) ;
   }
 }
 
+/**
+ ** Compute Fast Explicit Diffusion cycle
+ ** @param self input/output image
+ ** @param diff diffusion coefficient
+ ** @param tau cycle timing vector
+ **/
+template< typename Image >
+void ImageFEDCycle( Image & self , const Image & diff , const std::vector< typename Image::Tpixel > & tau )
+{
+  Image buffer ;
+  ImageFEDCycle( self , diff , tau , buffer ) ;
+}
+
 // Compute if a number is prime of not
 inline bool IsPrime( const int i )
 {
@@ -7,6 +7,9 @@
 
 #include "filtering.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 namespace aliceVision {
 namespace image {
 
@@ -42,5 +45,63 @@ Vec ComputeGaussianKernel(const std::size_t size, const double sigma)
   return res ;
 }
 
+namespace {
+
+/// Separable gaussian blur of sigma, with an output sampling step (see SeparableConvolution2d)
+void gaussianBlur( const Image<float> & img , const double sigma , const int step , Image<float> & out )
+{
+  const Eigen::Matrix<float, 1, Eigen::Dynamic> kernel = ComputeGaussianKernel( 0 , sigma ).cast<float>().transpose() ;
+  SeparableConvolution2d( img.GetMat() , kernel , kernel , &static_cast<Image<float>::Base&>( out ) , step ) ;
+}
+
+} // namespace
+
+void ImageGaussianPyramid( const Image<float> & img , const int nbOctaves , const int nbScales ,
+                           const float sigma0 , const float sigmaIn , GaussianPyramid & pyramid )
+{
+  assert( nbScales > 0 ) ;
+
+  pyramid.clear() ;
+  if( img.Width() == 0 || img.Height() == 0 )
+    return ;
+
+  // blur of the scale s of an octave: sigma0 * 2^(s / nbScales)
+  std::vector<double> sigmas( nbScales ) ;
+  for( int s = 0 ; s < nbScales ; ++s )
+    sigmas[ s ] = sigma0 * std::pow( 2.0 , static_cast<double>( s ) / nbScales ) ;
+
+  for( int o = 0 ; o < nbOctaves ; ++o )
+  {
+    std::vector< Image<float> > octave( nbScales ) ;
+
+    if( o == 0 )
+    {
+      const double sigmaFirst = std::sqrt( std::max( 0.0 , Square( double( sigma0 ) ) - Square( double( sigmaIn ) ) ) ) ;
+      if( sigmaFirst > 0.0 )
+        gaussianBlur( img , sigmaFirst , 1 , octave[ 0 ] ) ;
+      else
+        octave[ 0 ] = img ;
+    }
+    else
+    {
+      const Image<float> & previous = pyramid.back().back() ;
+      if( previous.Width() < 2 || previous.Height() < 2 )
+        break ;
+
+      // twice sigma0 in the previous octave is sigma0 in the new one
+      const double sigmaNext = std::sqrt( Square( 2.0 * sigma0 ) - Square( sigmas.back() ) ) ;
+      gaussianBlur( previous , sigmaNext , 2 , octave[ 0 ] ) ;
+    }
+
+    for( int s = 1 ; s < nbScales ; ++s )
+    {
+      const double sigmaIncrement = std::sqrt( Square( sigmas[ s ] ) - Square( sigmas[ s - 1 ] ) ) ;
+      gaussianBlur( octave[ s - 1 ] , sigmaIncrement , 1 , octave[ s ] ) ;
+    }
+
+    pyramid.push_back( std::move( octave ) ) ;
+  }
+}
+
 } // namespace image
 } // namespace aliceVision
@@ -308,5 +308,23 @@ namespace image {
     ImageSeparableConvolution( img , kernel_horiz , kernel_vert , out) ;
   }
 
+  /// Gaussian pyramid: pyramid[octave][scale], the images of an octave are downsampled by 2^octave
+  typedef std::vector< std::vector< Image<float> > > GaussianPyramid;
+
+  /**
+   ** @brief Build a Gaussian pyramid (linear scale space) of an image
+   ** The image (octave, scale) is blurred at sigma0 * 2^(scale / nbScales) in the octave coordinates.
+   ** Each scale is blurred incrementally from the previous one and the first scale of an octave
+   ** is computed from the last scale of the previous octave with a fused blur and half sample pass.
+   ** @param img Input image
+   ** @param nbOctaves Maximal number of octaves (stops when the image cannot be half sampled anymore)
+   ** @param nbScales Number of scales per octave
+   ** @param sigma0 Scale of the first image of each octave
+   ** @param sigmaIn Assumed blur of the input image
+   ** @param pyramid Output pyramid
+   **/
+  void ImageGaussianPyramid( const Image<float> & img , const int nbOctaves , const int nbScales ,
+                             const float sigma0 , const float sigmaIn , GaussianPyramid & pyramid ) ;
+
 } // namespace image
 } // namespace aliceVision
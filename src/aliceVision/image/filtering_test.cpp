@@ -135,3 +135,127 @@ BOOST_AUTO_TEST_CASE(Image_Convolution_Sobel_X_Y)
   outFilteredCast = Image<unsigned char>(outFiltered.cast<unsigned char>());
   BOOST_CHECK_NO_THROW(writeImage("out_SobelY.png", outFilteredCast));
 }
+
+namespace {
+
+int mirror(int i, int size)
+{
+  if(size == 1)
+    return 0;
+  while(i < 0 || i >= size)
+    i = (i < 0) ? -i : 2 * size - 2 - i;
+  return i;
+}
+
+/// Direct separable convolution with mirrored borders
+Image<float> referenceSeparableConvolution(const Image<float>& in, const Vec& kernel_x, const Vec& kernel_y, int step)
+{
+  const int half_x = kernel_x.size() / 2;
+  const int half_y = kernel_y.size() / 2;
+  Image<float> out((in.Width() + step - 1) / step, (in.Height() + step - 1) / step);
+  for(int y = 0; y < out.Height(); ++y)
+    for(int x = 0; x < out.Width(); ++x)
+    {
+      double sum = 0.0;
+      for(int i = 0; i < kernel_y.size(); ++i)
+        for(int j = 0; j < kernel_x.size(); ++j)
+          sum += kernel_y(i) * kernel_x(j) * in(mirror(y * step + i - half_y, in.Height()), mirror(x * step + j - half_x, in.Width()));
+      out(y, x) = sum;
+    }
+  return out;
+}
+
+Image<float> randomImage(int width, int height)
+{
+  Image<float> img(width, height);
+  for(int y = 0; y < height; ++y)
+    for(int x = 0; x < width; ++x)
+      img(y, x) = rand() % 256;
+  return img;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(Image_SeparableConvolution2d)
+{
+  const std::vector<std::pair<int, int>> sizes = {{1, 1}, {3, 2}, {17, 9}, {600, 21}, {1030, 5}};
+  for(const auto& size : sizes)
+  {
+    const Image<float> in = randomImage(size.first, size.second);
+    for(int ksize : {1, 3, 7, 31})
+    {
+      // symmetric, antisymmetric and asymmetric kernels
+      const Vec gaussian = ComputeGaussianKernel(ksize, ksize / 4.0 + 0.5);
+      const Vec derivative = Vec::LinSpaced(ksize, -1.0, 1.0);
+      const Vec random = Vec::Random(ksize);
+      const std::vector<std::pair<Vec, Vec>> kernels = {{gaussian, gaussian}, {derivative, gaussian}, {gaussian, derivative}, {random, random}};
+      for(int step : {1, 2})
+      for(const auto& kernel : kernels)
+      {
+        const Vec& kernel_x = kernel.first;
+        const Vec& kernel_y = kernel.second;
+        Image<float> out;
+        SeparableConvolution2d(in.GetMat(), kernel_x.cast<float>().transpose(), kernel_y.cast<float>().transpose(), &static_cast<Image<float>::Base&>(out), step);
+
+        const Image<float> expected = referenceSeparableConvolution(in, kernel_x, kernel_y, step);
+        BOOST_REQUIRE_EQUAL(out.Width(), expected.Width());
+        BOOST_REQUIRE_EQUAL(out.Height(), expected.Height());
+        BOOST_CHECK_SMALL((out.GetMat() - expected.GetMat()).cwiseAbs().maxCoeff(), 1e-2f);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Image_Convolution_Vertical_Horizontal)
+{
+  const Image<float> in = randomImage(300, 250);
+  const Vec kernel = ComputeGaussianKernel(9, 2.0);
+
+  Image<float> outVertical, outHorizontal, expectedVertical, expectedHorizontal;
+  ImageVerticalConvolution(in, kernel, outVertical);
+  ImageHorizontalConvolution(in, kernel, outHorizontal);
+  ImageConvolution(in, Mat(kernel), expectedVertical);
+  ImageConvolution(in, Mat(kernel.transpose()), expectedHorizontal);
+
+  BOOST_CHECK_SMALL((outVertical.GetMat() - expectedVertical.GetMat()).cwiseAbs().maxCoeff(), 1e-3f);
+  BOOST_CHECK_SMALL((outHorizontal.GetMat() - expectedHorizontal.GetMat()).cwiseAbs().maxCoeff(), 1e-3f);
+}
+
+BOOST_AUTO_TEST_CASE(Image_GaussianPyramid)
+{
+  // a centered impulse: the variance of each pyramid image is the scale of the image
+  const int size = 64;
+  Image<float> in(size, size, true, 0.f);
+  in(size / 2, size / 2) = 1.f;
+
+  const int nbScales = 3;
+  const float sigma0 = 1.6f;
+  GaussianPyramid pyramid;
+  ImageGaussianPyramid(in, 10, nbScales, sigma0, 0.f, pyramid);
+
+  // stops when the image cannot be half sampled anymore: 64, 32, 16, 8, 4, 2, 1
+  BOOST_CHECK_EQUAL(pyramid.size(), 7);
+
+  for(int o = 0; o < 3; ++o)
+  {
+    BOOST_REQUIRE_EQUAL(pyramid[o].size(), nbScales);
+    const int center = (size / 2) >> o;
+    for(int s = 0; s < nbScales; ++s)
+    {
+      const Image<float>& img = pyramid[o][s];
+      BOOST_CHECK_EQUAL(img.Width(), size >> o);
+      BOOST_CHECK_EQUAL(img.Height(), size >> o);
+
+      double sum = 0.0;
+      double variance = 0.0;
+      for(int y = 0; y < img.Height(); ++y)
+        for(int x = 0; x < img.Width(); ++x)
+        {
+          sum += img(y, x);
+          variance += img(y, x) * Square(x - center);
+        }
+      const double sigma = sigma0 * std::pow(2.0, double(s) / nbScales);
+      BOOST_CHECK_CLOSE(std::sqrt(variance / sum), sigma, 10.0);
+    }
+  }
+}
@@ -0,0 +1,163 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/image/Image.hpp"
+#include "aliceVision/image/ImagePool.hpp"
+
+#include <thread>
+
+#define BOOST_TEST_MODULE ImagePool
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::image;
+
+BOOST_AUTO_TEST_CASE(ImagePool_reuse)
+{
+  ImagePool<float> pool;
+  resetImagePoolStatistics();
+
+  Image<float> image;
+  pool.resize(image, 64, 48);
+  BOOST_CHECK_EQUAL(image.Width(), 64);
+  BOOST_CHECK_EQUAL(image.Height(), 48);
+  const float* data = image.data();
+
+  // same size: the image keeps its buffer
+  pool.resize(image, 64, 48);
+  BOOST_CHECK_EQUAL(image.data(), data);
+
+  // same number of pixels: the image keeps its buffer
+  pool.resize(image, 48, 64);
+  BOOST_CHECK_EQUAL(image.Width(), 48);
+  BOOST_CHECK_EQUAL(image.data(), data);
+
+  pool.release(image);
+  BOOST_CHECK_EQUAL(image.size(), 0);
+  BOOST_CHECK_EQUAL(pool.pooledBytes(), 64 * 48 * sizeof(float));
+
+  // another image of the same resolution class takes the pooled buffer
+  Image<float> other;
+  pool.resize(other, 32, 96);
+  BOOST_CHECK_EQUAL(other.data(), data);
+  BOOST_CHECK_EQUAL(other.Width(), 32);
+  BOOST_CHECK_EQUAL(other.Height(), 96);
+  BOOST_CHECK_EQUAL(pool.pooledBytes(), 0);
+
+  // another resolution: the buffer goes back to the pool and a new one is allocated
+  pool.resize(other, 10, 10);
+  BOOST_CHECK_EQUAL(pool.pooledBytes(), 64 * 48 * sizeof(float));
+  BOOST_CHECK_EQUAL(other.size(), 100);
+
+  const ImagePoolStatistics statistics = getImagePoolStatistics();
+  BOOST_CHECK_EQUAL(statistics.nbAllocations, 2);
+  BOOST_CHECK_EQUAL(statistics.allocatedBytes, (64 * 48 + 100) * sizeof(float));
+  BOOST_CHECK_EQUAL(statistics.nbReuses, 1);
+  BOOST_CHECK_EQUAL(statistics.nbReleases, 2);
+
+  pool.clear();
+  BOOST_CHECK_EQUAL(pool.pooledBytes(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(ImagePool_capacity)
+{
+  ImagePool<unsigned char> pool(1000);
+
+  Image<unsigned char> a, b, c;
+  pool.resize(a, 20, 30);
+  pool.resize(b, 30, 30);
+  pool.resize(c, 30, 30);
+  pool.release(a);
+  BOOST_CHECK_EQUAL(pool.pooledBytes(), 600);
+
+  // the pool is full: the buffer of the other resolution is freed
+  pool.release(b);
+  BOOST_CHECK_EQUAL(pool.pooledBytes(), 900);
+
+  // the pool is full of the same resolution: the buffer is freed
+  pool.release(c);
+  BOOST_CHECK_EQUAL(c.size(), 0);
+  BOOST_CHECK_EQUAL(pool.pooledBytes(), 900);
+
+  resetImagePoolStatistics();
+  pool.resize(a, 20, 30);
+  pool.resize(b, 30, 30);
+  BOOST_CHECK_EQUAL(getImagePoolStatistics().nbAllocations, 1);
+  BOOST_CHECK_EQUAL(getImagePoolStatistics().nbReuses, 1);
+}
+
+BOOST_AUTO_TEST_CASE(ImagePool_disabled)
+{
+  ImagePool<float> pool;
+  setImagePoolEnabled(false);
+  resetImagePoolStatistics();
+
+  Image<float> image;
+  pool.resize(image, 16, 16);
+  pool.release(image);
+  BOOST_CHECK_EQUAL(image.size(), 0);
+  BOOST_CHECK_EQUAL(pool.pooledBytes(), 0);
+
+  pool.resize(image, 16, 16);
+  BOOST_CHECK_EQUAL(getImagePoolStatistics().nbAllocations, 2);
+  BOOST_CHECK_EQUAL(getImagePoolStatistics().nbReuses, 0);
+
+  setImagePoolEnabled(true);
+}
+
+BOOST_AUTO_TEST_CASE(ImagePool_threadLocal)
+{
+  ImagePool<float>* mainPool = &ImagePool<float>::local();
+  ImagePool<float>* otherPool = nullptr;
+
+  std::thread thread([&]()
+  {
+    otherPool = &ImagePool<float>::local();
+  });
+  thread.join();
+
+  BOOST_CHECK(mainPool == &ImagePool<float>::local());
+  BOOST_CHECK(mainPool != otherPool);
+}
+
+BOOST_AUTO_TEST_CASE(ImagePool_localPools)
+{
+  ImagePool<unsigned char>::setLocalPoolsCapacity(1000);
+  ImagePool<unsigned char>& mainPool = ImagePool<unsigned char>::local();
+
+  Image<unsigned char> a, b;
+  mainPool.resize(a, 20, 30);
+  mainPool.release(a);
+
+  std::thread thread([&]()
+  {
+    // the pool of the thread gets the capacity of the local pools
+    ImagePool<unsigned char>& pool = ImagePool<unsigned char>::local();
+    Image<unsigned char> c, d;
+    pool.resize(c, 30, 30);
+    pool.resize(d, 30, 30);
+    pool.release(c);
+    pool.release(d);
+    BOOST_CHECK_EQUAL(pool.pooledBytes(), 900);
+    BOOST_CHECK_EQUAL(ImagePool<unsigned char>::localPoolsPooledBytes(), 1500);
+  });
+  thread.join();
+
+  // the pool of the finished thread is freed with the thread
+  BOOST_CHECK_EQUAL(ImagePool<unsigned char>::localPoolsPooledBytes(), 600);
+
+  // a smaller capacity frees the oldest buffers
+  mainPool.resize(b, 10, 10);
+  mainPool.release(b);
+  ImagePool<unsigned char>::setLocalPoolsCapacity(300);
+  BOOST_CHECK_EQUAL(mainPool.pooledBytes(), 100);
+
+  ImagePool<unsigned char>::clearLocalPools();
+  BOOST_CHECK_EQUAL(mainPool.pooledBytes(), 0);
+  BOOST_CHECK_EQUAL(ImagePool<unsigned char>::localPoolsPooledBytes(), 0);
+
+  ImagePool<unsigned char>::setLocalPoolsCapacity(defaultLocalImagePoolCapacity);
+}
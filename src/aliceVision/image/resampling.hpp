@@ -27,6 +27,7 @@ namespace image {
 
     const Sampler2d<SamplerLinear> sampler;
 
+    #pragma omp parallel for if( new_width * new_height > 65536 )
     for( int i = 0 ; i < new_height ; ++i )
     {
       for( int j = 0 ; j < new_width ; ++j )
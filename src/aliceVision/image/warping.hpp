@@ -8,13 +8,25 @@
 #pragma once
 
 #include <aliceVision/config.hpp>
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/image/Image.hpp>
+#include <aliceVision/image/pixelTypes.hpp>
+#include <aliceVision/image/Sampler.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+#include <xmmintrin.h>
+#endif
 
 namespace aliceVision{
 namespace image{
 
 /// Apply inplace homography transform for the given point (x,y).
 /// Return true if H is orientation preserving around the point.
-bool ApplyH_AndCheckOrientation(const Mat3 &H, double &x, double &y)
+inline bool ApplyH_AndCheckOrientation(const Mat3 &H, double &x, double &y)
 {
   Vec3 X(x, y, 1.0);
   X = H*X;
@@ -44,5 +56,235 @@ void Warp(const Image &im, const Mat3 & H, Image &out)
     }
 }
 
+/**
+ * @brief Precomputed backward mapping of an image (bilinear sampling).
+ *
+ * For each output pixel, it stores the index of the top-left source pixel of the
+ * bilinear neighborhood and the fixed-point fractional offsets.
+ * The neighbors outside of the source image are clamped, which gives the same
+ * result as the renormalized weights of Sampler2d<SamplerLinear>.
+ */
+struct RemapTable
+{
+  /// number of bits of the fixed-point fractional offsets
+  static const int fractionBits = 10;
+  static const int fractionOne = 1 << fractionBits;
+
+  int width = 0;
+  int height = 0;
+  int srcWidth = 0;
+  int srcHeight = 0;
+  /// index of the top-left source pixel (y * srcWidth + x), -1 if the output pixel is not mapped
+  std::vector<int> offsets;
+  /// fixed-point fractional offsets in [0, fractionOne]
+  std::vector<std::uint16_t> fractionsX;
+  std::vector<std::uint16_t> fractionsY;
+  /// 1 if the right (resp. bottom) neighbor is inside the source image, 0 otherwise
+  std::vector<std::uint8_t> hasNextX;
+  std::vector<std::uint8_t> hasNextY;
+
+  std::size_t memorySize() const
+  {
+    return offsets.size() * (sizeof(int) + 2 * sizeof(std::uint16_t) + 2 * sizeof(std::uint8_t));
+  }
+};
+
+/**
+ * @brief Build a remap table from a mapping function
+ * @param[in] width, height the output image size
+ * @param[in] srcWidth, srcHeight the source image size
+ * @param[in] rowMapping functor (int y, Mat2X& out) computing the source positions (x, y) of the output row y
+ * @param[out] table the remap table
+ */
+template <typename RowMappingFunc>
+void BuildRemapTable(int width, int height, int srcWidth, int srcHeight, const RowMappingFunc& rowMapping, RemapTable& table)
+{
+  table.width = width;
+  table.height = height;
+  table.srcWidth = srcWidth;
+  table.srcHeight = srcHeight;
+
+  const std::size_t size = static_cast<std::size_t>(width) * height;
+  table.offsets.resize(size);
+  table.fractionsX.resize(size);
+  table.fractionsY.resize(size);
+  table.hasNextX.resize(size);
+  table.hasNextY.resize(size);
+
+  #pragma omp parallel for
+  for(int j = 0; j < height; ++j)
+  {
+    Mat2X srcRow;
+    rowMapping(j, srcRow);
+
+    for(int i = 0; i < width; ++i)
+    {
+      const std::size_t index = static_cast<std::size_t>(j) * width + i;
+      const double x = srcRow(0, i);
+      const double y = srcRow(1, i);
+
+      const double fx = x - std::floor(x);
+      const double fy = y - std::floor(y);
+      const int x0 = static_cast<int>(std::floor(x));
+      const int y0 = static_cast<int>(std::floor(y));
+
+      // total weight of the neighbors inside the source image (see Sampler2d)
+      const double weightX = (x0 >= 0 ? 1.0 - fx : 0.0) + (x0 + 1 < srcWidth ? fx : 0.0);
+      const double weightY = (y0 >= 0 ? 1.0 - fy : 0.0) + (y0 + 1 < srcHeight ? fy : 0.0);
+
+      if(!(x > -1.0 && x < srcWidth && y > -1.0 && y < srcHeight) || weightX * weightY <= 0.2)
+      {
+        table.offsets[index] = -1;
+        continue;
+      }
+
+      // clamp the neighbors outside of the source image
+      int fractionX = static_cast<int>(fx * RemapTable::fractionOne + 0.5);
+      int fractionY = static_cast<int>(fy * RemapTable::fractionOne + 0.5);
+      int left = x0;
+      int top = y0;
+      if(left < 0)
+      {
+        left = 0;
+        fractionX = 0;
+      }
+      if(top < 0)
+      {
+        top = 0;
+        fractionY = 0;
+      }
+
+      table.offsets[index] = top * srcWidth + left;
+      table.fractionsX[index] = static_cast<std::uint16_t>(fractionX);
+      table.fractionsY[index] = static_cast<std::uint16_t>(fractionY);
+      table.hasNextX[index] = (left + 1 < srcWidth) ? 1 : 0;
+      table.hasNextY[index] = (top + 1 < srcHeight) ? 1 : 0;
+    }
+  }
+}
+
+/**
+ * @brief Bilinear interpolation of 4 pixels with fixed-point fractional offsets.
+ * The generic implementation works with the RealPixel conversions of the samplers.
+ */
+template <typename T>
+struct RemapInterpolation
+{
+  static T interpolate(const T& p00, const T& p01, const T& p10, const T& p11, int fx, int fy)
+  {
+    const double wx = static_cast<double>(fx) / RemapTable::fractionOne;
+    const double wy = static_cast<double>(fy) / RemapTable::fractionOne;
+    typedef typename RealPixel<T>::real_type Real;
+    const Real top = RealPixel<T>::convert_to_real(p00) * (1.0 - wx) + RealPixel<T>::convert_to_real(p01) * wx;
+    const Real bottom = RealPixel<T>::convert_to_real(p10) * (1.0 - wx) + RealPixel<T>::convert_to_real(p11) * wx;
+    return RealPixel<T>::convert_from_real(top * (1.0 - wy) + bottom * wy);
+  }
+};
+
+template <>
+struct RemapInterpolation<unsigned char>
+{
+  static unsigned char interpolate(unsigned char p00, unsigned char p01, unsigned char p10, unsigned char p11, int fx, int fy)
+  {
+    // integer arithmetic: 8 bits + 2 * fractionBits fit in 32 bits
+    const int one = RemapTable::fractionOne;
+    const int top = p00 * (one - fx) + p01 * fx;
+    const int bottom = p10 * (one - fx) + p11 * fx;
+    return static_cast<unsigned char>((top * (one - fy) + bottom * fy + (1 << (2 * RemapTable::fractionBits - 1))) >> (2 * RemapTable::fractionBits));
+  }
+};
+
+template <>
+struct RemapInterpolation<Rgb<unsigned char>>
+{
+  static Rgb<unsigned char> interpolate(const Rgb<unsigned char>& p00, const Rgb<unsigned char>& p01,
+                                        const Rgb<unsigned char>& p10, const Rgb<unsigned char>& p11, int fx, int fy)
+  {
+    typedef RemapInterpolation<unsigned char> Interpolation;
+    return Rgb<unsigned char>(Interpolation::interpolate(p00.r(), p01.r(), p10.r(), p11.r(), fx, fy),
+                              Interpolation::interpolate(p00.g(), p01.g(), p10.g(), p11.g(), fx, fy),
+                              Interpolation::interpolate(p00.b(), p01.b(), p10.b(), p11.b(), fx, fy));
+  }
+};
+
+template <>
+struct RemapInterpolation<float>
+{
+  static float interpolate(float p00, float p01, float p10, float p11, int fx, int fy)
+  {
+    const float wx = static_cast<float>(fx) / RemapTable::fractionOne;
+    const float wy = static_cast<float>(fy) / RemapTable::fractionOne;
+    const float top = p00 + (p01 - p00) * wx;
+    const float bottom = p10 + (p11 - p10) * wx;
+    return top + (bottom - top) * wy;
+  }
+};
+
+template <>
+struct RemapInterpolation<Rgb<float>>
+{
+  static Rgb<float> interpolate(const Rgb<float>& p00, const Rgb<float>& p01, const Rgb<float>& p10, const Rgb<float>& p11, int fx, int fy)
+  {
+    const float wx = static_cast<float>(fx) / RemapTable::fractionOne;
+    const float wy = static_cast<float>(fy) / RemapTable::fractionOne;
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+    // the 3 channels are interpolated at once
+    const __m128 v00 = _mm_setr_ps(p00.r(), p00.g(), p00.b(), 0.f);
+    const __m128 v01 = _mm_setr_ps(p01.r(), p01.g(), p01.b(), 0.f);
+    const __m128 v10 = _mm_setr_ps(p10.r(), p10.g(), p10.b(), 0.f);
+    const __m128 v11 = _mm_setr_ps(p11.r(), p11.g(), p11.b(), 0.f);
+    const __m128 vwx = _mm_set1_ps(wx);
+    const __m128 top = _mm_add_ps(v00, _mm_mul_ps(_mm_sub_ps(v01, v00), vwx));
+    const __m128 bottom = _mm_add_ps(v10, _mm_mul_ps(_mm_sub_ps(v11, v10), vwx));
+    float res[4];
+    _mm_storeu_ps(res, _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), _mm_set1_ps(wy))));
+    return Rgb<float>(res[0], res[1], res[2]);
+#else
+    typedef RemapInterpolation<float> Interpolation;
+    return Rgb<float>(Interpolation::interpolate(p00.r(), p01.r(), p10.r(), p11.r(), fx, fy),
+                      Interpolation::interpolate(p00.g(), p01.g(), p10.g(), p11.g(), fx, fy),
+                      Interpolation::interpolate(p00.b(), p01.b(), p10.b(), p11.b(), fx, fy));
+#endif
+  }
+};
+
+/**
+ * @brief Resample an image with a precomputed remap table
+ * @param[in] src the source image (of the size used to build the table)
+ * @param[in] table the remap table
+ * @param[out] out the output image
+ * @param[in] fillColor the color of the output pixels that are not mapped
+ */
+template <typename T>
+void Remap(const Image<T>& src, const RemapTable& table, Image<T>& out, const T& fillColor)
+{
+  assert(src.Width() == table.srcWidth && src.Height() == table.srcHeight);
+
+  out.resize(table.width, table.height, false);
+  const T* srcData = src.data();
+  const int srcWidth = table.srcWidth;
+
+  #pragma omp parallel for
+  for(int j = 0; j < table.height; ++j)
+  {
+    const std::size_t rowBegin = static_cast<std::size_t>(j) * table.width;
+    for(int i = 0; i < table.width; ++i)
+    {
+      const std::size_t index = rowBegin + i;
+      const int offset = table.offsets[index];
+      if(offset < 0)
+      {
+        out(j, i) = fillColor;
+        continue;
+      }
+      const T* p00 = srcData + offset;
+      const T* p10 = p00 + (table.hasNextY[index] ? srcWidth : 0);
+      const int nextX = table.hasNextX[index] ? 1 : 0;
+      out(j, i) = RemapInterpolation<T>::interpolate(p00[0], p00[nextX], p10[0], p10[nextX],
+                                                     table.fractionsX[index], table.fractionsY[index]);
+    }
+  }
+}
+
 }; // namespace image
 }; // namespace aliceVision
@@ -0,0 +1,106 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/image/all.hpp"
+#include "aliceVision/image/warping.hpp"
+
+#include <cmath>
+#include <cstdlib>
+
+#define BOOST_TEST_MODULE ImageWarping
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::image;
+
+namespace {
+
+/// rotation and scale around the image center, partially outside of the source image
+void rowMapping(int y, int width, int height, Mat2X& out)
+{
+  out.resize(2, width);
+  const double c = std::cos(0.3) * 1.1, s = std::sin(0.3) * 1.1;
+  for(int x = 0; x < width; ++x)
+  {
+    const double dx = x - width * 0.5, dy = y - height * 0.5;
+    out(0, x) = c * dx - s * dy + width * 0.5 + 0.37;
+    out(1, x) = s * dx + c * dy + height * 0.5 - 0.21;
+  }
+}
+
+/// reference implementation: per pixel Sampler2d, as done by the former UndistortImage
+template <typename T>
+void remapReference(const Image<T>& src, Image<T>& out, const T& fillColor)
+{
+  out.resize(src.Width(), src.Height(), true, fillColor);
+  const Sampler2d<SamplerLinear> sampler;
+  Mat2X row;
+  for(int j = 0; j < src.Height(); ++j)
+  {
+    rowMapping(j, src.Width(), src.Height(), row);
+    for(int i = 0; i < src.Width(); ++i)
+      if(src.Contains(row(1, i), row(0, i)))
+        out(j, i) = sampler(src, row(1, i), row(0, i));
+  }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(Warping_Remap_vs_Sampler)
+{
+  const int width = 97, height = 64;
+
+  Image<unsigned char> imageU8(width, height);
+  Image<float> imageF(width, height);
+  Image<RGBfColor> imageRGBf(width, height);
+  Image<RGBColor> imageRGB(width, height);
+  for(int j = 0; j < height; ++j)
+    for(int i = 0; i < width; ++i)
+    {
+      imageU8(j, i) = static_cast<unsigned char>(std::rand() % 256);
+      imageF(j, i) = static_cast<float>(std::rand()) / RAND_MAX;
+      imageRGBf(j, i) = RGBfColor(imageF(j, i), 1.f - imageF(j, i), 0.5f * imageF(j, i));
+      imageRGB(j, i) = RGBColor(imageU8(j, i), 255 - imageU8(j, i), imageU8(j, i) / 2);
+    }
+
+  RemapTable table;
+  BuildRemapTable(width, height, width, height, [&](int y, Mat2X& out) { rowMapping(y, width, height, out); }, table);
+  BOOST_CHECK_EQUAL(table.offsets.size(), width * height);
+
+  {
+    Image<unsigned char> out, ref;
+    Remap(imageU8, table, out, static_cast<unsigned char>(0));
+    remapReference(imageU8, ref, static_cast<unsigned char>(0));
+    for(int j = 0; j < height; ++j)
+      for(int i = 0; i < width; ++i)
+        BOOST_CHECK_SMALL(static_cast<int>(out(j, i)) - static_cast<int>(ref(j, i)), 2);
+  }
+  {
+    Image<float> out, ref;
+    Remap(imageF, table, out, 0.f);
+    remapReference(imageF, ref, 0.f);
+    for(int j = 0; j < height; ++j)
+      for(int i = 0; i < width; ++i)
+        BOOST_CHECK_SMALL(out(j, i) - ref(j, i), 2e-3f);
+  }
+  {
+    Image<RGBfColor> out, ref;
+    Remap(imageRGBf, table, out, FBLACK);
+    remapReference(imageRGBf, ref, FBLACK);
+    for(int j = 0; j < height; ++j)
+      for(int i = 0; i < width; ++i)
+        BOOST_CHECK_SMALL((out(j, i) - ref(j, i)).norm(), 3e-3f);
+  }
+  {
+    Image<RGBColor> out, ref;
+    Remap(imageRGB, table, out, BLACK);
+    remapReference(imageRGB, ref, BLACK);
+    for(int j = 0; j < height; ++j)
+      for(int i = 0; i < width; ++i)
+        BOOST_CHECK_SMALL((out(j, i).cast<int>() - ref(j, i).cast<int>()).cwiseAbs().maxCoeff(), 2);
+  }
+}
@@ -9,9 +9,12 @@
 #include <aliceVision/sensorDB/parseDatabase.hpp>
 #include <aliceVision/feature/sift/ImageDescriber_SIFT.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/ConcurrentQueue.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <tuple>
 #include <cassert>
+#include <thread>
 
 namespace aliceVision {
 namespace keyframe {
@@ -73,9 +76,6 @@ KeyframeSelector::KeyframeSelector(const std::vector<std::string>& mediaPaths,
 
   // resize selection data vector
   _framesData.resize(nbFrames);
-
-  // create SIFT image describer
-  _imageDescriber.reset(new feature::ImageDescriber_SIFT());
 }
 
 void KeyframeSelector::process()
@@ -89,8 +89,9 @@ void KeyframeSelector::process()
   // process variables
   const unsigned int frameStep = _maxFrameStep - _minFrameStep;
   const unsigned int tileSharpSubset =  (_nbTileSide * _nbTileSide) / _sharpSubset;
+  const std::size_t nbMedias = _feeds.size();
   
-  for(std::size_t mediaIndex = 0 ; mediaIndex < _feeds.size(); ++mediaIndex)
+  for(std::size_t mediaIndex = 0 ; mediaIndex < nbMedias; ++mediaIndex)
   {
     // first frame
     if(!_feeds.at(mediaIndex)->readImage(image, queryIntrinsics, currentImgName, hasIntrinsics))
@@ -118,110 +119,166 @@ void KeyframeSelector::process()
     mediaInfo.spec.attribute("Exif:FocalLength", _cameraInfos[mediaIndex].focalLength);
   }
 
-  // iteration process
-  _keyframeIndexes.clear();
-  std::size_t currentFrameStep = _minFrameStep; // start directly (dont skip minFrameStep first frames)
-  
-  for(std::size_t frameIndex = 0; frameIndex < _framesData.size(); ++frameIndex)
+  // create SIFT image describers (one per worker thread)
+  const int nbThreads = _pipelined ? ((_maxThreads > 0) ? static_cast<int>(_maxThreads) : omp_get_max_threads()) : 1;
+  _imageDescribers.clear();
+  for(int i = 0; i < nbThreads; ++i)
+    _imageDescribers.emplace_back(new feature::ImageDescriber_SIFT());
+
+  // in pipelined mode, a decoder thread per media reads its frames in order
+  // and converts them while the previous ones are evaluated
+  std::vector< std::unique_ptr< system::ConcurrentQueue< image::Image<float> > > > decodedFrames;
+  std::vector<std::thread> decoders;
+
+  const auto stopDecoders = [&]()
+  {
+    for(auto& queue : decodedFrames)
+      queue->close();
+    for(std::thread& decoder : decoders)
+      decoder.join();
+    decoders.clear();
+  };
+
+  if(_pipelined)
   {
-    ALICEVISION_LOG_TRACE("frame : " << frameIndex);
-    bool frameSelected = true;
-    auto& frameData = _framesData.at(frameIndex);
-    frameData.mediasData.resize(_feeds.size());
+    ALICEVISION_LOG_INFO("Pipelined keyframe selection with " << nbMedias << " decoder thread(s) and " << nbThreads << " worker thread(s).");
 
-    for(std::size_t mediaIndex = 0; mediaIndex < _feeds.size(); ++mediaIndex)
-    {
-      ALICEVISION_LOG_TRACE("media : " << _mediaPaths.at(mediaIndex));
-      auto& feed = *_feeds.at(mediaIndex);
+    for(std::size_t mediaIndex = 0; mediaIndex < nbMedias; ++mediaIndex)
+      decodedFrames.emplace_back(new system::ConcurrentQueue< image::Image<float> >(std::max(_decodeAheadFrames, 1u)));
 
-      if(frameSelected) // false if a camera of a rig is not selected
+    for(std::size_t mediaIndex = 0; mediaIndex < nbMedias; ++mediaIndex)
+    {
+      decoders.emplace_back([this, mediaIndex, &decodedFrames]()
       {
-        if(!feed.readImage(image, queryIntrinsics, currentImgName, hasIntrinsics))
+        auto& queue = *decodedFrames.at(mediaIndex);
+        for(std::size_t frameIndex = 0; frameIndex < _framesData.size(); ++frameIndex)
         {
-          ALICEVISION_LOG_ERROR("Cannot read frame '" << currentImgName << "' !");
-          throw std::invalid_argument("Cannot read frame '" + currentImgName + "' !");
+          image::Image<float> imageGrayHalfSample;
+          if(!readFrame(mediaIndex, imageGrayHalfSample) || !queue.push(std::move(imageGrayHalfSample)))
+            break;
         }
+        // the evaluation stops on the missing frames
+        queue.close();
+      });
+    }
+  }
+
+  // frames whose sharpness and histograms are computed
+  std::size_t nbComputedFrames = 0;
+  // frames whose histograms are released (neither keyframes nor evaluated again)
+  std::size_t nbReleasedFrames = 0;
 
-        // compute sharpness and sparse distance
-        if(!computeFrameData(image, frameIndex, mediaIndex, tileSharpSubset))
+  const auto computeNextFrames = [&]()
+  {
+    // a step window at a time in pipelined mode, a frame at a time otherwise
+    const std::size_t nbFrames = std::min(_pipelined ? std::max<std::size_t>(frameStep, 1) : 1,
+                                          _framesData.size() - nbComputedFrames);
+    std::vector< std::vector< image::Image<float> > > images(nbFrames, std::vector< image::Image<float> >(nbMedias));
+
+    for(std::size_t i = 0; i < nbFrames; ++i)
+    {
+      for(std::size_t mediaIndex = 0; mediaIndex < nbMedias; ++mediaIndex)
+      {
+        const bool isRead = _pipelined ? decodedFrames.at(mediaIndex)->pop(images[i][mediaIndex])
+                                       : readFrame(mediaIndex, images[i][mediaIndex]);
+        if(!isRead)
         {
-          frameSelected = false;
+          const std::string frameName = std::to_string(nbComputedFrames + i) + " of media " + _mediaPaths.at(mediaIndex);
+          ALICEVISION_LOG_ERROR("Cannot read frame " << frameName << " !");
+          throw std::invalid_argument("Cannot read frame " + frameName + " !");
         }
       }
-
-      feed.goToNextFrame();
     }
+    computeFramesData(nbComputedFrames, images, tileSharpSubset);
+    nbComputedFrames += nbFrames;
+  };
 
+  // iteration process
+  _keyframeIndexes.clear();
+  std::size_t currentFrameStep = _minFrameStep; // start directly (dont skip minFrameStep first frames)
+
+  try
+  {
+    for(std::size_t frameIndex = 0; frameIndex < _framesData.size(); ++frameIndex)
     {
-      if(frameSelected)
+      ALICEVISION_LOG_TRACE("frame : " << frameIndex);
+
+      // the frames evaluated again after a keyframe are already computed
+      while(frameIndex >= nbComputedFrames)
+        computeNextFrames();
+
+      if(evaluateFrame(frameIndex))
       {
         ALICEVISION_LOG_TRACE(" > selected" << std::endl);
-        frameData.selected = true;
-        frameData.computeAvgSharpness();
       }
       else
       {
         ALICEVISION_LOG_TRACE(" > skipped" << std::endl);
-        frameData.mediasData.clear(); // remove unselected mediasData
       }
-    }
 
-    // selection process
-    if(currentFrameStep >= _maxFrameStep)
-    {
-      currentFrameStep = _minFrameStep;
-      bool hasKeyframe = false;
-      std::size_t keyframeIndex = 0;
-      float maxSharpness = 0;
-
-      // find the sharpest selected frame
-      for(std::size_t index = frameIndex - (frameStep - 1); index <= frameIndex; ++index)
+      // selection process
+      if(currentFrameStep >= _maxFrameStep)
       {
-        if(_framesData[index].selected && (_framesData[index].avgSharpness > maxSharpness))
+        currentFrameStep = _minFrameStep;
+        bool hasKeyframe = false;
+        std::size_t keyframeIndex = 0;
+        float maxSharpness = 0;
+
+        // find the sharpest selected frame
+        for(std::size_t index = frameIndex - (frameStep - 1); index <= frameIndex; ++index)
         {
-          hasKeyframe = true;
-          keyframeIndex = index;
-          maxSharpness = _framesData[index].avgSharpness;
+          if(_framesData[index].selected && (_framesData[index].avgSharpness > maxSharpness))
+          {
+            hasKeyframe = true;
+            keyframeIndex = index;
+            maxSharpness = _framesData[index].avgSharpness;
+          }
         }
-      }
 
-      // save keyframe
-      if(hasKeyframe)
-      {
-        ALICEVISION_LOG_INFO("keyframe choice : " << keyframeIndex << std::endl);
-
-        // write keyframe
-        for(std::size_t mediaIndex = 0; mediaIndex < _feeds.size(); ++mediaIndex)
+        // save keyframe
+        if(hasKeyframe)
         {
-          auto& feed = *_feeds.at(mediaIndex);
+          ALICEVISION_LOG_INFO("keyframe choice : " << keyframeIndex << std::endl);
+
+          _framesData[keyframeIndex].keyframe = true;
+          _keyframeIndexes.push_back(keyframeIndex);
 
-          feed.goToFrame(keyframeIndex);
+          frameIndex = keyframeIndex + _minFrameStep - 1;
 
-          if(_maxOutFrame == 0) // no limit of keyframes (direct evaluation)
+          // the frames before the next evaluated one are only needed if they are keyframes
+          for(; nbReleasedFrames < std::min(frameIndex + 1, nbComputedFrames); ++nbReleasedFrames)
           {
-            feed.readImage(image, queryIntrinsics, currentImgName, hasIntrinsics);
-            writeKeyframe(image, keyframeIndex, mediaIndex);
+            auto& frameData = _framesData.at(nbReleasedFrames);
+            if(!frameData.keyframe)
+            {
+              for(auto& mediaData : frameData.mediasData)
+                mediaData.histogram = voctree::FlatSparseHistogram();
+            }
           }
         }
-        _framesData[keyframeIndex].keyframe = true;
-        _keyframeIndexes.push_back(keyframeIndex);
-
-        frameIndex = keyframeIndex + _minFrameStep - 1;
-      }
-      else
-      {
-        ALICEVISION_LOG_INFO("keyframe choice : none" << std::endl);
+        else
+        {
+          ALICEVISION_LOG_INFO("keyframe choice : none" << std::endl);
+        }
       }
+      ++currentFrameStep;
     }
-    ++currentFrameStep;
   }
-
-  if(_maxOutFrame == 0) // no limit of keyframes (evaluation and write already done)
+  catch(...)
   {
-    return;
+    stopDecoders();
+    throw;
   }
+  stopDecoders();
 
-  // if limited number of keyframe select smallest sparse distance
+  // select the output keyframes
+  std::vector<std::size_t> outFrameIndexes;
+
+  if(_maxOutFrame == 0) // no limit of keyframes
+  {
+    outFrameIndexes = _keyframeIndexes;
+  }
+  else // if limited number of keyframe select smallest sparse distance
   {
     std::vector< std::tuple<float, float, std::size_t> > keyframes;
 
@@ -237,15 +294,18 @@ void KeyframeSelector::process()
     const std::size_t nbOutFrames = std::min(static_cast<std::size_t>(_maxOutFrame), keyframes.size());
 
     for(std::size_t i = 0; i < nbOutFrames; ++i)
+      outFrameIndexes.push_back(std::get<2>(keyframes.at(i)));
+  }
+
+  // write keyframes
+  for(const std::size_t frameIndex : outFrameIndexes)
+  {
+    for(std::size_t mediaIndex = 0; mediaIndex < nbMedias; ++mediaIndex)
     {
-      const std::size_t frameIndex = std::get<2>(keyframes.at(i));
-      for(std::size_t mediaIndex = 0; mediaIndex < _feeds.size(); ++mediaIndex)
-      {
-        auto& feed = *_feeds.at(mediaIndex);
-        feed.goToFrame(frameIndex);
-        feed.readImage(image, queryIntrinsics, currentImgName, hasIntrinsics);
-        writeKeyframe(image, frameIndex, mediaIndex);
-      }
+      auto& feed = *_feeds.at(mediaIndex);
+      feed.goToFrame(frameIndex);
+      feed.readImage(image, queryIntrinsics, currentImgName, hasIntrinsics);
+      writeKeyframe(image, frameIndex, mediaIndex);
     }
   }
 }
@@ -261,19 +321,42 @@ float KeyframeSelector::computeSharpness(const image::Image<float>& imageGray,
   image::ImageScharrXDerivative(imageGray, scharrXDer); // normalized
   image::ImageScharrYDerivative(imageGray, scharrYDer); // normalized
 
-  scharrXDer = scharrXDer.cwiseAbs(); // absolute value
-  scharrYDer = scharrYDer.cwiseAbs(); // absolute value
+  // integral image of the absolute derivatives over the tiled area:
+  // the sum over a tile only needs 4 lookups
+  const std::size_t height = _nbTileSide * tileHeight;
+  const std::size_t width = _nbTileSide * tileWidth;
+  const std::size_t stride = width + 1;
+  std::vector<double> integral(stride * (height + 1), 0.0);
+
+  for(std::size_t y = 0; y < height; ++y)
+  {
+    const float* rowX = scharrXDer.data() + y * scharrXDer.Width();
+    const float* rowY = scharrYDer.data() + y * scharrYDer.Width();
+    const double* prevRow = integral.data() + y * stride;
+    double* row = integral.data() + (y + 1) * stride;
+    double rowSum = 0.0;
+
+    for(std::size_t x = 0; x < width; ++x)
+    {
+      rowSum += std::abs(rowX[x]) + std::abs(rowY[x]);
+      row[x + 1] = prevRow[x + 1] + rowSum;
+    }
+  }
 
   // image tiles
   std::vector<float> averageTileIntensity;
-  const float tileSizeInv = 1 / static_cast<float>(tileHeight * tileWidth);
+  averageTileIntensity.reserve(_nbTileSide * _nbTileSide);
+  const double tileSizeInv = 1 / static_cast<double>(tileHeight * tileWidth);
 
-  for(std::size_t y =  0; y < (_nbTileSide * tileHeight); y += tileHeight)
+  for(std::size_t y =  0; y < height; y += tileHeight)
   {
-    for(std::size_t x =  0; x < (_nbTileSide * tileWidth); x += tileWidth)
+    for(std::size_t x =  0; x < width; x += tileWidth)
     {
-      const auto sum = scharrXDer.block(y, x, tileHeight, tileWidth).sum() + scharrYDer.block(y, x, tileHeight, tileWidth).sum();
-      averageTileIntensity.push_back(sum * tileSizeInv);
+      const double sum = integral[(y + tileHeight) * stride + x + tileWidth]
+                       - integral[y * stride + x + tileWidth]
+                       - integral[(y + tileHeight) * stride + x]
+                       + integral[y * stride + x];
+      averageTileIntensity.push_back(static_cast<float>(sum * tileSizeInv));
     }
   }
 
@@ -284,39 +367,96 @@ float KeyframeSelector::computeSharpness(const image::Image<float>& imageGray,
   return std::accumulate(averageTileIntensity.end() - tileSharpSubset, averageTileIntensity.end(), 0.0f) / tileSharpSubset;
 }
 
-
-bool KeyframeSelector::computeFrameData(const image::Image<image::RGBColor>& image,
-                                        std::size_t frameIndex,
-                                        std::size_t mediaIndex,
-                                        unsigned int tileSharpSubset)
+bool KeyframeSelector::readFrame(std::size_t mediaIndex, image::Image<float>& imageGrayHalfSample)
 {
-  image::Image<float> imageGray;                // grayscale image
-  image::Image<float> imageGrayHalfSample;      // half resolution grayscale image
-  
-  const auto& currMediaInfo = _mediasInfo.at(mediaIndex);
-  auto& currframeData = _framesData.at(frameIndex);
-  auto& currMediaData = currframeData.mediasData.at(mediaIndex);
+  image::Image<image::RGBColor> image;       // original image
+  image::Image<float> imageGray;              // grayscale image
+  camera::PinholeRadialK3 queryIntrinsics;
+  bool hasIntrinsics = false;
+  std::string currentImgName;
+
+  auto& feed = *_feeds.at(mediaIndex);
+
+  if(!feed.readImage(image, queryIntrinsics, currentImgName, hasIntrinsics))
+  {
+    ALICEVISION_LOG_ERROR("Cannot read frame '" << currentImgName << "' !");
+    return false;
+  }
+  feed.goToNextFrame();
 
   // get grayscale image and resize
   image::ConvertPixelType(image, &imageGray);
   image::ImageHalfSample(imageGray, imageGrayHalfSample);
+  return true;
+}
 
-  // compute sharpness
-  currMediaData.sharpness = computeSharpness(imageGrayHalfSample,
-                                             currMediaInfo.tileHeight,
-                                             currMediaInfo.tileWidth,
-                                             tileSharpSubset);
+void KeyframeSelector::computeFramesData(std::size_t firstFrame,
+                                         const std::vector< std::vector< image::Image<float> > >& images,
+                                         unsigned int tileSharpSubset)
+{
+  const std::size_t nbMedias = _feeds.size();
+  const int nbThreads = static_cast<int>(_imageDescribers.size());
+
+  for(std::size_t i = 0; i < images.size(); ++i)
+    _framesData.at(firstFrame + i).mediasData.resize(nbMedias);
+
+  // compute sharpness of each media frame
+  const int nbImages = static_cast<int>(images.size() * nbMedias);
 
-  ALICEVISION_LOG_TRACE( " - sharpness : " << currMediaData.sharpness);
+  #pragma omp parallel for schedule(dynamic) num_threads(nbThreads)
+  for(int i = 0; i < nbImages; ++i)
+  {
+    const std::size_t frameOffset = i / nbMedias;
+    const std::size_t mediaIndex = i % nbMedias;
+    const auto& mediaInfo = _mediasInfo.at(mediaIndex);
+    auto& mediaData = _framesData.at(firstFrame + frameOffset).mediasData.at(mediaIndex);
+
+    mediaData.sharpness = computeSharpness(images[frameOffset][mediaIndex],
+                                           mediaInfo.tileHeight,
+                                           mediaInfo.tileWidth,
+                                           tileSharpSubset);
+  }
 
-  if(currMediaData.sharpness > _sharpnessThreshold)
+  // compute sparse histogram of the sharp media frames only
+  std::vector<int> sharpImages;
+  for(int i = 0; i < nbImages; ++i)
   {
-    bool noKeyframe = (_keyframeIndexes.empty());
+    if(_framesData.at(firstFrame + i / nbMedias).mediasData.at(i % nbMedias).sharpness > _sharpnessThreshold)
+      sharpImages.push_back(i);
+  }
+
+  #pragma omp parallel for schedule(dynamic) num_threads(nbThreads)
+  for(int s = 0; s < static_cast<int>(sharpImages.size()); ++s)
+  {
+    const std::size_t frameOffset = sharpImages[s] / nbMedias;
+    const std::size_t mediaIndex = sharpImages[s] % nbMedias;
+    auto& mediaData = _framesData.at(firstFrame + frameOffset).mediasData.at(mediaIndex);
 
-    // compute current frame sparse histogram
     std::unique_ptr<feature::Regions> regions;
-    _imageDescriber->describe(imageGrayHalfSample, regions);
-    currMediaData.histogram = voctree::SparseHistogram(_voctree->quantizeToSparse(dynamic_cast<feature::SIFT_Regions*>(regions.get())->Descriptors()));
+    _imageDescribers.at(omp_get_thread_num())->describe(images[frameOffset][mediaIndex], regions);
+    // only the number of features per word is needed by the distance
+    mediaData.histogram = voctree::FlatSparseHistogram(_voctree->quantize(dynamic_cast<feature::SIFT_Regions*>(regions.get())->Descriptors()), false);
+  }
+}
+
+bool KeyframeSelector::evaluateFrame(std::size_t frameIndex)
+{
+  auto& currFrameData = _framesData.at(frameIndex);
+  const bool noKeyframe = (_keyframeIndexes.empty());
+
+  // the frame may be evaluated again with new keyframes
+  currFrameData.selected = false;
+  currFrameData.maxDistScore = 0;
+
+  for(auto& currMediaData : currFrameData.mediasData)
+  {
+    currMediaData.distScore = 0;
+
+    ALICEVISION_LOG_TRACE(" - sharpness : " << currMediaData.sharpness);
+
+    // false if a camera of a rig is not selected
+    if(currMediaData.sharpness <= _sharpnessThreshold)
+      return false;
 
     // compute sparseDistance
     if(!noKeyframe)
@@ -330,16 +470,17 @@ bool KeyframeSelector::computeFrameData(const image::Image<image::RGBColor>& ima
           currMediaData.distScore = std::max(currMediaData.distScore, std::abs(voctree::sparseDistance(media.histogram, currMediaData.histogram, "strongCommonPoints")));
         }
       }
-      currframeData.maxDistScore = std::max(currframeData.maxDistScore, currMediaData.distScore);
+      currFrameData.maxDistScore = std::max(currFrameData.maxDistScore, currMediaData.distScore);
       ALICEVISION_LOG_TRACE(" - distScore : " << currMediaData.distScore);
-    }
 
-    if(noKeyframe || (currMediaData.distScore < _distScoreMax))
-    {
-      return true;
+      if(currMediaData.distScore >= _distScoreMax)
+        return false;
     }
-  } 
-  return false;
+  }
+
+  currFrameData.selected = true;
+  currFrameData.computeAvgSharpness();
+  return true;
 }
 
 void KeyframeSelector::writeKeyframe(const image::Image<image::RGBColor>& image, 
@@ -9,6 +9,7 @@
 #include <aliceVision/feature/feature.hpp>
 #include <aliceVision/dataio/FeedProvider.hpp>
 #include <aliceVision/voctree/VocabularyTree.hpp>
+#include <aliceVision/voctree/FlatSparseHistogram.hpp>
 
 #include <OpenImageIO/imageio.h>
 
@@ -141,6 +142,36 @@ public:
       _maxOutFrame = nbFrame;
   }
 
+  /**
+   * @brief Set the pipelined mode for process algorithm:
+   * the frames of each media are decoded ahead by a dedicated thread, then the sharpness
+   * and the histograms of the frames of a step window are computed in parallel.
+   * The selected keyframes are the same as in the sequential mode.
+   * @param[in] pipelined true to enable the pipelined mode
+   */
+  void setPipelined(bool pipelined)
+  {
+      _pipelined = pipelined;
+  }
+
+  /**
+   * @brief Set max number of threads for the pipelined mode (decoder threads excluded)
+   * @param[in] maxThreads maximum number of threads (if 0, all the available threads)
+   */
+  void setMaxThreads(unsigned int maxThreads)
+  {
+      _maxThreads = maxThreads;
+  }
+
+  /**
+   * @brief Set the number of decoded frames waiting per media in the pipelined mode
+   * @param[in] nbFrames maximum number of frames decoded ahead per media
+   */
+  void setDecodeAheadFrames(unsigned int nbFrames)
+  {
+      _decodeAheadFrames = nbFrames;
+  }
+
   /**
    * @brief Get sharp subset size for process algorithm
    * @return sharp part of the image (1 = all, 2 = size/2, ...)
@@ -176,6 +207,33 @@ public:
   {
       return _maxOutFrame;
   }
+
+  /**
+   * @brief Get the pipelined mode for process algorithm
+   * @return true if the frames are decoded ahead and evaluated in parallel
+   */
+  bool isPipelined() const
+  {
+      return _pipelined;
+  }
+
+  /**
+   * @brief Get max number of threads for the pipelined mode
+   * @return maximum number of threads (if 0, all the available threads)
+   */
+  unsigned int getMaxThreads() const
+  {
+      return _maxThreads;
+  }
+
+  /**
+   * @brief Get the number of decoded frames waiting per media in the pipelined mode
+   * @return maximum number of frames decoded ahead per media
+   */
+  unsigned int getDecodeAheadFrames() const
+  {
+      return _decodeAheadFrames;
+  }
     
 private:
 
@@ -208,14 +266,20 @@ private:
   float _sharpnessThreshold = 15.0f;
   /// Distance max score (image with smallest distance from the last keyframe will be selected)
   float _distScoreMax = 100.0f;
+  /// Decode ahead and evaluate the frames in parallel
+  bool _pipelined = false;
+  /// Maximum number of threads in pipelined mode (0 = all)
+  unsigned int _maxThreads = 0;
+  /// Maximum number of frames decoded ahead per media in pipelined mode
+  unsigned int _decodeAheadFrames = 32;
 
   /// Camera metadatas
   std::vector<CameraInfo> _cameraInfos;
 
   // Tools
 
-  /// Image describer in order to extract describer
-  std::unique_ptr<feature::ImageDescriber> _imageDescriber;
+  /// Image describers in order to extract describer (one per thread)
+  std::vector< std::unique_ptr<feature::ImageDescriber> > _imageDescribers;
   /// Voctree in order to compute sparseHistogram
   std::unique_ptr< aliceVision::voctree::VocabularyTree<DescriptorFloat> > _voctree;
   /// Feed provider for media paths images extraction
@@ -246,7 +310,7 @@ private:
     /// maximum distance score with keyframe media histograms
     float distScore = 0;
     /// sparseHistogram
-    voctree::SparseHistogram histogram;
+    voctree::FlatSparseHistogram histogram;
   };
 
   /**
@@ -270,6 +334,7 @@ private:
      */
     void computeAvgSharpness()
     {
+      avgSharpness = 0;
       for(const auto& media : mediasData)
         avgSharpness += media.sharpness;
       avgSharpness /= mediasData.size();
@@ -297,17 +362,31 @@ private:
                          const unsigned int tileSharpSubset) const;
 
   /**
-   * @brief Compute sharpness and distance score for a given image
-   * @param[in] image an image of the media
-   * @param[in] frameIndex the image index in the media sequence
+   * @brief Read the current frame of a media as a half resolution grayscale image,
+   * then go to the next frame
    * @param[in] mediaIndex the media index
+   * @param[out] imageGrayHalfSample half resolution grayscale image
+   * @return false if the frame cannot be read
+   */
+  bool readFrame(std::size_t mediaIndex, image::Image<float>& imageGrayHalfSample);
+
+  /**
+   * @brief Compute the sharpness and the histogram of the frames of each media.
+   * They do not depend on the previous keyframes, so they are computed once per frame.
+   * @param[in] firstFrame the index of the first frame in the media sequence
+   * @param[in] images the half resolution grayscale images per frame and per media
    * @param[in] tileSharpSubset number of sharp tiles
+   */
+  void computeFramesData(std::size_t firstFrame,
+                         const std::vector< std::vector< image::Image<float> > >& images,
+                         unsigned int tileSharpSubset);
+
+  /**
+   * @brief Compute the distance score of a frame with the last keyframes
+   * @param[in] frameIndex the image index in the media sequence
    * @return true if the frame is selected
    */
-  bool computeFrameData(const image::Image<image::RGBColor>& image,
-                        std::size_t frameIndex,
-                        std::size_t mediaIndex,
-                        unsigned int tileSharpSubset);
+  bool evaluateFrame(std::size_t frameIndex);
 
   /**
    * @brief Write a keyframe and metadata
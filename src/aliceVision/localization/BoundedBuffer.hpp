@@ -89,6 +89,23 @@ public:
     _buffer.emplace_back(args...);
   }
 
+  /**
+   * @brief Returns the number of elements in the buffer.
+   */
+  std::size_t size() const { return _buffer.size(); }
+
+  bool empty() const { return _buffer.empty(); }
+
+  /**
+   * @brief Returns the last element added to the buffer.
+   */
+  const T& back() const { return _buffer.back(); }
+
+  /**
+   * @brief Removes all the elements of the buffer.
+   */
+  void clear() { _buffer.clear(); }
+
 };
 
 }
@@ -0,0 +1,401 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LocalizationServer.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace localization {
+
+std::string ELocalizationStage_enumToString(ELocalizationStage stage)
+{
+  switch(stage)
+  {
+    case ELocalizationStage::QUEUE:          return "queue";
+    case ELocalizationStage::EXTRACTION:     return "extraction";
+    case ELocalizationStage::DATABASE_QUERY: return "database query";
+    case ELocalizationStage::LOCALIZATION:   return "localization";
+    case ELocalizationStage::TOTAL:          return "total";
+  }
+  throw std::out_of_range("Invalid localization stage enum");
+}
+
+LatencyHistogram::LatencyHistogram()
+  : _counts(nbBuckets, 0)
+{}
+
+double LatencyHistogram::bucketUpperBound(int bucket)
+{
+  // in microseconds: 1 for the first bucket, then 2^(bucket / nbBucketsPerOctave)
+  return std::pow(2.0, static_cast<double>(bucket) / nbBucketsPerOctave) / 1000.0;
+}
+
+int LatencyHistogram::bucketIndex(double latencyMs)
+{
+  const double latencyUs = latencyMs * 1000.0;
+  if(!(latencyUs >= 1.0))
+    return 0;
+  const int bucket = 1 + static_cast<int>(std::floor(nbBucketsPerOctave * std::log2(latencyUs)));
+  return std::min(bucket, nbBuckets - 1);
+}
+
+void LatencyHistogram::add(double latencyMs)
+{
+  const int bucket = bucketIndex(latencyMs);
+  std::lock_guard<std::mutex> lock(_mutex);
+  ++_counts[bucket];
+  ++_count;
+  _sum += latencyMs;
+  _max = std::max(_max, latencyMs);
+}
+
+void LatencyHistogram::reset()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::fill(_counts.begin(), _counts.end(), 0);
+  _count = 0;
+  _sum = 0.0;
+  _max = 0.0;
+}
+
+std::size_t LatencyHistogram::count() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _count;
+}
+
+double LatencyHistogram::mean() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return (_count == 0) ? 0.0 : _sum / _count;
+}
+
+double LatencyHistogram::max() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _max;
+}
+
+double LatencyHistogram::percentile(double p) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return percentileNoLock(p);
+}
+
+double LatencyHistogram::percentileNoLock(double p) const
+{
+  if(_count == 0)
+    return 0.0;
+
+  const std::size_t rank = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(p * _count)));
+  std::size_t cumulated = 0;
+  for(int bucket = 0; bucket < nbBuckets; ++bucket)
+  {
+    cumulated += _counts[bucket];
+    if(cumulated >= rank)
+      return std::min(bucketUpperBound(bucket), _max);
+  }
+  return _max;
+}
+
+void LatencyHistogram::print(std::ostream& os) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  os << std::fixed << std::setprecision(3)
+     << "count: " << _count
+     << ", mean: " << ((_count == 0) ? 0.0 : _sum / _count) << " ms"
+     << ", p50: " << percentileNoLock(0.5) << " ms"
+     << ", p90: " << percentileNoLock(0.9) << " ms"
+     << ", p99: " << percentileNoLock(0.99) << " ms"
+     << ", max: " << _max << " ms" << std::endl;
+}
+
+void LatencyHistogram::printBuckets(std::ostream& os) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  for(int bucket = 0; bucket < nbBuckets; ++bucket)
+  {
+    if(_counts[bucket] == 0)
+      continue;
+    os << std::fixed << std::setprecision(3)
+       << "  [" << std::setw(10) << ((bucket == 0) ? 0.0 : bucketUpperBound(bucket - 1))
+       << ", " << std::setw(10) << bucketUpperBound(bucket) << "[ ms: "
+       << _counts[bucket] << std::endl;
+  }
+}
+
+LocalizationServer::LocalizationServer(ILocalizer& localizer,
+                                       const LocalizerParameters& param,
+                                       std::size_t nbThreads,
+                                       std::size_t maxBatchSize,
+                                       std::size_t queueCapacity)
+  : _localizer(localizer)
+  , _param(&param)
+  , _maxBatchSize(std::max<std::size_t>(1, maxBatchSize))
+  , _queue(queueCapacity)
+{
+  if(!localizer.isInit())
+    throw std::invalid_argument("The localizer of the localization server is not initialized.");
+
+  _voctreeLocalizer = dynamic_cast<VoctreeLocalizer*>(&localizer);
+  if(_voctreeLocalizer)
+  {
+    const VoctreeLocalizer::Parameters* voctreeParam = dynamic_cast<const VoctreeLocalizer::Parameters*>(&param);
+    if(!voctreeParam)
+      throw std::invalid_argument("The parameters are not in the right format!!");
+
+    // the frame buffer and the tracking state are shared by all the requests:
+    // they are not thread safe and they would mix frames of different cameras
+    _voctreeParam.reset(new VoctreeLocalizer::Parameters(*voctreeParam));
+    _voctreeParam->_nbFrameBufferMatching = 0;
+    _voctreeParam->_useTracking = false;
+    _param = _voctreeParam.get();
+  }
+
+  if(nbThreads == 0)
+    nbThreads = std::max(1u, std::thread::hardware_concurrency());
+
+  ALICEVISION_LOG_INFO("Start the localization server with " << nbThreads << " threads (batches of " << _maxBatchSize << " requests).");
+
+  for(std::size_t i = 0; i < nbThreads; ++i)
+    _workers.emplace_back(&LocalizationServer::processRequests, this);
+}
+
+LocalizationServer::~LocalizationServer()
+{
+  stop();
+}
+
+bool LocalizationServer::submit(LocalizationRequest request, ResponseCallback callback)
+{
+  std::unique_ptr<Job> job(new Job);
+  job->request = std::move(request);
+  job->callback = std::move(callback);
+  job->submitTime = Clock::now();
+  return _queue.push(std::move(job));
+}
+
+void LocalizationServer::stop()
+{
+  _queue.close();
+  for(std::thread& worker : _workers)
+  {
+    if(worker.joinable())
+      worker.join();
+  }
+}
+
+void LocalizationServer::printStatistics(std::ostream& os, bool printHistograms) const
+{
+  const std::size_t nbRequests = _nbRequests;
+  const std::size_t nbBatches = _nbBatches;
+
+  os << "requests: " << nbRequests
+     << ", localized: " << _nbLocalized
+     << ", batches: " << nbBatches
+     << ", mean batch size: " << std::fixed << std::setprecision(2) << ((nbBatches == 0) ? 0.0 : static_cast<double>(nbRequests) / nbBatches)
+     << std::endl;
+
+  for(std::size_t i = 0; i < nbLocalizationStages; ++i)
+  {
+    os << ELocalizationStage_enumToString(static_cast<ELocalizationStage>(i)) << ": ";
+    _latencies[i].print(os);
+  }
+
+  if(!printHistograms)
+    return;
+
+  for(std::size_t i = 0; i < nbLocalizationStages; ++i)
+  {
+    os << ELocalizationStage_enumToString(static_cast<ELocalizationStage>(i)) << " latency histogram:" << std::endl;
+    _latencies[i].printBuckets(os);
+  }
+}
+
+void LocalizationServer::processRequests()
+{
+  Workspace workspace;
+  if(_voctreeLocalizer)
+  {
+    for(const auto& imageDescriber : _voctreeLocalizer->_imageDescribers)
+    {
+      workspace.imageDescribers.push_back(feature::createImageDescriber(imageDescriber->getDescriberType()));
+      workspace.imageDescribers.back()->setConfigurationPreset(_param->_featurePreset);
+    }
+  }
+
+  std::vector<std::unique_ptr<Job>> batch;
+  std::vector<LocalizationResponse> responses;
+
+  while(_queue.popBatch(batch, _maxBatchSize))
+  {
+    const Clock::time_point popTime = Clock::now();
+    ++_nbBatches;
+
+    responses.assign(batch.size(), LocalizationResponse());
+    for(std::size_t i = 0; i < batch.size(); ++i)
+    {
+      LocalizationResponse& response = responses[i];
+      response.requestId = batch[i]->request.id;
+      response.batchSize = batch.size();
+      response.latenciesMs[static_cast<std::size_t>(ELocalizationStage::QUEUE)] =
+        std::chrono::duration<double, std::milli>(popTime - batch[i]->submitTime).count();
+      if(batch[i]->request.regions.empty() && batch[i]->request.image.size() == 0)
+        response.error = "The request has no image and no features.";
+    }
+
+    // extract the features of the images with the describers of the worker
+    if(_voctreeLocalizer)
+    {
+      for(std::size_t i = 0; i < batch.size(); ++i)
+      {
+        LocalizationRequest& request = batch[i]->request;
+        if(!request.regions.empty() || !responses[i].error.empty())
+          continue;
+
+        system::Timer timer;
+        try
+        {
+          extractRegions(workspace, request);
+        }
+        catch(std::exception& e)
+        {
+          responses[i].error = e.what();
+        }
+        responses[i].latenciesMs[static_cast<std::size_t>(ELocalizationStage::EXTRACTION)] = timer.elapsedMs();
+      }
+    }
+
+    // query the database once for the whole batch
+    std::vector<voctree::DocMatches> databaseMatches;
+    if(_voctreeLocalizer)
+    {
+      system::Timer timer;
+      std::vector<const feature::MapRegionsPerDesc*> batchRegions;
+      batchRegions.reserve(batch.size());
+      for(const auto& job : batch)
+        batchRegions.push_back(&job->request.regions);
+
+      _voctreeLocalizer->queryDatabase(batchRegions, *_voctreeParam, databaseMatches);
+
+      const double queryTime = timer.elapsedMs();
+      for(LocalizationResponse& response : responses)
+        response.latenciesMs[static_cast<std::size_t>(ELocalizationStage::DATABASE_QUERY)] = queryTime;
+    }
+
+    for(std::size_t i = 0; i < batch.size(); ++i)
+    {
+      Job& job = *batch[i];
+      LocalizationResponse& response = responses[i];
+
+      if(response.error.empty())
+      {
+        system::Timer timer;
+        try
+        {
+          localize(job.request, databaseMatches.empty() ? nullptr : &databaseMatches[i], response);
+        }
+        catch(std::exception& e)
+        {
+          ALICEVISION_LOG_WARNING("Localization request " << job.request.id << " failed: " << e.what());
+          response.error = e.what();
+          response.localized = false;
+        }
+        response.latenciesMs[static_cast<std::size_t>(ELocalizationStage::LOCALIZATION)] = timer.elapsedMs();
+      }
+      response.latenciesMs[static_cast<std::size_t>(ELocalizationStage::TOTAL)] =
+        std::chrono::duration<double, std::milli>(Clock::now() - job.submitTime).count();
+
+      for(std::size_t s = 0; s < nbLocalizationStages; ++s)
+      {
+        // the skipped stages are not counted
+        if(response.latenciesMs[s] > 0.0 || s == static_cast<std::size_t>(ELocalizationStage::TOTAL))
+          _latencies[s].add(response.latenciesMs[s]);
+      }
+      ++_nbRequests;
+      if(response.localized)
+        ++_nbLocalized;
+
+      if(job.callback)
+        job.callback(response);
+    }
+  }
+}
+
+void LocalizationServer::extractRegions(Workspace& workspace, LocalizationRequest& request) const
+{
+  bool hasUCharImage = false;
+  for(const auto& imageDescriber : workspace.imageDescribers)
+  {
+    std::unique_ptr<feature::Regions>& regions = request.regions[imageDescriber->getDescriberType()];
+    imageDescriber->allocate(regions);
+
+    if(imageDescriber->useFloatImage())
+    {
+      imageDescriber->describe(request.image, regions, nullptr);
+    }
+    else
+    {
+      if(!hasUCharImage)
+      {
+        // the conversion reuses the buffer of the previous requests of the worker
+        image::Image<unsigned char>::Base& imageUChar = workspace.imageUChar;
+        imageUChar = (request.image.GetMat() * 255.f).cast<unsigned char>();
+        hasUCharImage = true;
+      }
+      imageDescriber->describe(workspace.imageUChar, regions, nullptr);
+    }
+  }
+  request.imageSize = std::make_pair(request.image.Width(), request.image.Height());
+  // the image is not needed anymore
+  request.image = image::Image<float>();
+}
+
+void LocalizationServer::localize(LocalizationRequest& request,
+                                  const std::vector<voctree::DocMatch>* databaseMatches,
+                                  LocalizationResponse& response)
+{
+  LocalizationResult localizationResult;
+
+  if(_voctreeLocalizer)
+  {
+    _voctreeLocalizer->localize(request.regions,
+                                request.imageSize,
+                                *_voctreeParam,
+                                databaseMatches,
+                                request.useInputIntrinsics,
+                                request.intrinsics,
+                                localizationResult);
+  }
+  else
+  {
+    std::lock_guard<std::mutex> lock(_localizerMutex);
+    if(!request.regions.empty())
+      _localizer.localize(request.regions, request.imageSize, _param, request.useInputIntrinsics, request.intrinsics, localizationResult);
+    else
+      _localizer.localize(request.image, _param, request.useInputIntrinsics, request.intrinsics, localizationResult);
+  }
+
+  response.localized = localizationResult.isValid();
+  response.intrinsics = request.intrinsics;
+  response.nbAssociations = localizationResult.getIndMatch3D2D().size();
+  if(response.localized)
+  {
+    response.pose = localizationResult.getPose();
+    response.nbInliers = localizationResult.getInliers().size();
+  }
+}
+
+} // namespace localization
+} // namespace aliceVision
@@ -0,0 +1,253 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/localization/ILocalizer.hpp>
+#include <aliceVision/localization/VoctreeLocalizer.hpp>
+#include <aliceVision/system/ConcurrentQueue.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aliceVision {
+namespace localization {
+
+/// Processing stages of a localization request, each one has its latency histogram
+enum class ELocalizationStage
+{
+  QUEUE = 0,      //< waiting in the request queue
+  EXTRACTION,     //< features extraction (requests with an image)
+  DATABASE_QUERY, //< vocabulary tree query of the batch
+  LOCALIZATION,   //< matching and resection
+  TOTAL           //< from the submission to the response
+};
+
+const std::size_t nbLocalizationStages = static_cast<std::size_t>(ELocalizationStage::TOTAL) + 1;
+
+std::string ELocalizationStage_enumToString(ELocalizationStage stage);
+
+/**
+ * @brief Thread safe histogram of latencies, with logarithmic buckets:
+ * each power of two is split in nbBucketsPerOctave buckets (about 19% wide),
+ * from 1 microsecond to several hours.
+ */
+class LatencyHistogram
+{
+public:
+  static const int nbBucketsPerOctave = 4;
+  static const int nbBuckets = 1 + 34 * nbBucketsPerOctave;
+
+  LatencyHistogram();
+
+  /**
+   * @brief Add a latency
+   * @param[in] latencyMs the latency in milliseconds
+   */
+  void add(double latencyMs);
+
+  void reset();
+
+  std::size_t count() const;
+
+  /// mean latency in milliseconds
+  double mean() const;
+
+  /// maximum latency in milliseconds
+  double max() const;
+
+  /**
+   * @brief Get a percentile of the latencies (upper bound of its bucket)
+   * @param[in] p the percentile in [0, 1]
+   * @return the latency in milliseconds
+   */
+  double percentile(double p) const;
+
+  /**
+   * @brief Print the count, the mean, the main percentiles and the maximum of the latencies
+   */
+  void print(std::ostream& os) const;
+
+  /**
+   * @brief Print the bounds and the count of the non-empty buckets
+   */
+  void printBuckets(std::ostream& os) const;
+
+  /// upper bound of the bucket in milliseconds
+  static double bucketUpperBound(int bucket);
+
+  static int bucketIndex(double latencyMs);
+
+private:
+  double percentileNoLock(double p) const;
+
+  std::vector<std::size_t> _counts;
+  std::size_t _count = 0;
+  double _sum = 0.0;
+  double _max = 0.0;
+  mutable std::mutex _mutex;
+};
+
+/**
+ * @brief A request to localize one image: either the image or its features (regions).
+ */
+struct LocalizationRequest
+{
+  /// identifier given by the client, copied in the response
+  std::uint64_t id = 0;
+  /// the greyscale image to localize, only used if there is no regions
+  image::Image<float> image;
+  /// the features of the image to localize
+  feature::MapRegionsPerDesc regions;
+  /// size of the image (width, height)
+  std::pair<std::size_t, std::size_t> imageSize;
+  /// use the intrinsics as known calibration
+  bool useInputIntrinsics = false;
+  camera::PinholeRadialK3 intrinsics;
+};
+
+/**
+ * @brief The result of a localization request
+ */
+struct LocalizationResponse
+{
+  std::uint64_t requestId = 0;
+  bool localized = false;
+  geometry::Pose3 pose;
+  /// the input intrinsics, or the estimated ones if useInputIntrinsics is false
+  camera::PinholeRadialK3 intrinsics;
+  std::size_t nbAssociations = 0;
+  std::size_t nbInliers = 0;
+  /// number of requests processed in the same batch
+  std::size_t batchSize = 0;
+  /// the latency of each stage in milliseconds
+  std::array<double, nbLocalizationStages> latenciesMs{};
+  /// error message if the localization failed with an exception
+  std::string error;
+};
+
+/**
+ * @brief Long-running localization service around a localizer.
+ *
+ * The requests are queued and processed by a pool of worker threads. Each worker takes
+ * all the queued requests (up to maxBatchSize) at once: it extracts the features of the
+ * images with its own image describers, queries the vocabulary tree database for the whole
+ * batch in a single pass, then localizes the requests one by one.
+ * A worker never waits to fill a batch, so the batches only grow when the server is loaded.
+ *
+ * With a VoctreeLocalizer, the requests are localized concurrently: the frame buffer matching
+ * and the tracking are disabled as the requests come from several cameras.
+ * The other localizers are called by one worker at a time.
+ */
+class LocalizationServer
+{
+public:
+  using ResponseCallback = std::function<void(const LocalizationResponse&)>;
+
+  /**
+   * @param[in] localizer the initialized localizer, it must outlive the server
+   * @param[in] param the parameters of the localization
+   * @param[in] nbThreads the number of worker threads (0 for the number of cores)
+   * @param[in] maxBatchSize the maximum number of requests processed together by a worker
+   * @param[in] queueCapacity the maximum number of pending requests, submit blocks when
+   * the queue is full (0 for an unbounded queue)
+   */
+  LocalizationServer(ILocalizer& localizer,
+                     const LocalizerParameters& param,
+                     std::size_t nbThreads = 0,
+                     std::size_t maxBatchSize = 8,
+                     std::size_t queueCapacity = 64);
+
+  LocalizationServer(const LocalizationServer&) = delete;
+  LocalizationServer& operator=(const LocalizationServer&) = delete;
+
+  /**
+   * @brief Stop the server, the pending requests are processed before
+   */
+  ~LocalizationServer();
+
+  /**
+   * @brief Queue a localization request (blocks while the queue is full)
+   * @param[in] request the request
+   * @param[in] callback called by a worker thread with the response
+   * @return false if the server is stopped
+   */
+  bool submit(LocalizationRequest request, ResponseCallback callback);
+
+  /**
+   * @brief Stop accepting requests, process the pending ones and join the worker threads
+   */
+  void stop();
+
+  std::size_t getNbWorkers() const { return _workers.size(); }
+
+  const LatencyHistogram& getLatencyHistogram(ELocalizationStage stage) const
+  {
+    return _latencies.at(static_cast<std::size_t>(stage));
+  }
+
+  /**
+   * @brief Print the number of requests, the batch sizes and the latencies of each stage
+   * @param[in] os the output stream
+   * @param[in] printHistograms print the buckets of the latency histograms
+   */
+  void printStatistics(std::ostream& os, bool printHistograms = false) const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Job
+  {
+    LocalizationRequest request;
+    ResponseCallback callback;
+    Clock::time_point submitTime;
+  };
+
+  /// features extraction workspace of a worker thread
+  struct Workspace
+  {
+    std::vector<std::unique_ptr<feature::ImageDescriber>> imageDescribers;
+    image::Image<unsigned char> imageUChar;
+  };
+
+  void processRequests();
+
+  void extractRegions(Workspace& workspace, LocalizationRequest& request) const;
+
+  void localize(LocalizationRequest& request,
+                const std::vector<voctree::DocMatch>* databaseMatches,
+                LocalizationResponse& response);
+
+  ILocalizer& _localizer;
+  /// not null if the localizer is a VoctreeLocalizer
+  VoctreeLocalizer* _voctreeLocalizer = nullptr;
+  /// copy of the parameters of the VoctreeLocalizer, without the frame buffer
+  std::unique_ptr<VoctreeLocalizer::Parameters> _voctreeParam;
+  const LocalizerParameters* _param = nullptr;
+  /// serializes the calls to the localizers which are not thread safe
+  std::mutex _localizerMutex;
+
+  const std::size_t _maxBatchSize;
+  system::ConcurrentQueue<std::unique_ptr<Job>> _queue;
+  std::vector<std::thread> _workers;
+
+  std::array<LatencyHistogram, nbLocalizationStages> _latencies;
+  std::atomic<std::size_t> _nbRequests{0};
+  std::atomic<std::size_t> _nbLocalized{0};
+  std::atomic<std::size_t> _nbBatches{0};
+};
+
+} // namespace localization
+} // namespace aliceVision
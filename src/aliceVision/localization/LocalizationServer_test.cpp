@@ -0,0 +1,389 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LocalizationServer.hpp"
+#include "localizationServerIO.hpp"
+#include <aliceVision/feature/regionsFactory.hpp>
+#include <aliceVision/system/system.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BOOST_TEST_MODULE LocalizationServer
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::localization;
+
+namespace {
+
+/// localizer which only counts the requests
+class CountingLocalizer : public ILocalizer
+{
+public:
+  CountingLocalizer() { _isInit = true; }
+
+  bool localize(const image::Image<float>& imageGrey,
+                const LocalizerParameters* param,
+                bool useInputIntrinsics,
+                camera::PinholeRadialK3& queryIntrinsics,
+                LocalizationResult& localizationResult,
+                const std::string& imagePath = std::string()) override
+  {
+    ++nbImages;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return false;
+  }
+
+  bool localize(const feature::MapRegionsPerDesc& queryRegions,
+                const std::pair<std::size_t, std::size_t>& imageSize,
+                const LocalizerParameters* param,
+                bool useInputIntrinsics,
+                camera::PinholeRadialK3& queryIntrinsics,
+                LocalizationResult& localizationResult,
+                const std::string& imagePath = std::string()) override
+  {
+    ++nbRegions;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return false;
+  }
+
+  bool localizeRig(const std::vector<image::Image<float>>& vec_imageGrey,
+                   const LocalizerParameters* param,
+                   std::vector<camera::PinholeRadialK3>& vec_queryIntrinsics,
+                   const std::vector<geometry::Pose3>& vec_subPoses,
+                   geometry::Pose3& rigPose,
+                   std::vector<LocalizationResult>& vec_locResults) override
+  {
+    return false;
+  }
+
+  bool localizeRig(const std::vector<feature::MapRegionsPerDesc>& vec_queryRegions,
+                   const std::vector<std::pair<std::size_t, std::size_t>>& imageSize,
+                   const LocalizerParameters* param,
+                   std::vector<camera::PinholeRadialK3>& vec_queryIntrinsics,
+                   const std::vector<geometry::Pose3>& vec_subPoses,
+                   geometry::Pose3& rigPose,
+                   std::vector<LocalizationResult>& vec_locResults) override
+  {
+    return false;
+  }
+
+  std::atomic<int> nbImages{0};
+  std::atomic<int> nbRegions{0};
+};
+
+struct CountingParameters : public LocalizerParameters
+{};
+
+std::unique_ptr<feature::Regions> generateSiftRegions(std::size_t count)
+{
+  std::unique_ptr<feature::SIFT_Regions> regions(new feature::SIFT_Regions);
+  for(std::size_t i = 0; i < count; ++i)
+  {
+    regions->Features().emplace_back(float(i), float(2 * i), 1.5f + i, 0.1f * i);
+    feature::SIFT_Regions::DescriptorT descriptor;
+    for(std::size_t j = 0; j < descriptor.size(); ++j)
+      descriptor[j] = static_cast<unsigned char>(i + j);
+    regions->Descriptors().push_back(descriptor);
+  }
+  return std::unique_ptr<feature::Regions>(regions.release());
+}
+
+template <typename T>
+void append(std::string& message, const T& value)
+{
+  message.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(LocalizationServer_latencyHistogram)
+{
+  LatencyHistogram histogram;
+  for(int i = 1; i <= 100; ++i)
+    histogram.add(i);
+
+  BOOST_CHECK_EQUAL(histogram.count(), 100);
+  BOOST_CHECK_CLOSE(histogram.mean(), 50.5, 1e-6);
+  BOOST_CHECK_CLOSE(histogram.max(), 100.0, 1e-6);
+
+  // the percentiles are the upper bounds of the buckets: at most 19% larger
+  BOOST_CHECK_GE(histogram.percentile(0.5), 50.0);
+  BOOST_CHECK_LE(histogram.percentile(0.5), 50.0 * 1.19);
+  BOOST_CHECK_GE(histogram.percentile(0.9), 90.0);
+  BOOST_CHECK_LE(histogram.percentile(0.9), 90.0 * 1.19);
+  BOOST_CHECK_CLOSE(histogram.percentile(1.0), 100.0, 1e-6);
+
+  // latencies out of the range of the buckets
+  BOOST_CHECK_EQUAL(LatencyHistogram::bucketIndex(0.0), 0);
+  BOOST_CHECK_EQUAL(LatencyHistogram::bucketIndex(1e12), LatencyHistogram::nbBuckets - 1);
+
+  histogram.reset();
+  BOOST_CHECK_EQUAL(histogram.count(), 0);
+  BOOST_CHECK_EQUAL(histogram.percentile(0.5), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(LocalizationServer_requestIO)
+{
+  LocalizationRequest request;
+  request.id = 42;
+  request.imageSize = std::make_pair(8, 4);
+  request.useInputIntrinsics = true;
+  request.intrinsics = camera::PinholeRadialK3(8, 4, 10.0, 4.0, 2.0, 0.1, -0.01, 0.001);
+  request.image = image::Image<float>(8, 4);
+  for(int y = 0; y < 4; ++y)
+    for(int x = 0; x < 8; ++x)
+      request.image(y, x) = (y * 8 + x) / 255.f;
+  request.regions[feature::EImageDescriberType::SIFT] = generateSiftRegions(5);
+
+  std::stringstream stream;
+  writeLocalizationRequest(stream, request);
+
+  LocalizationRequest readRequest;
+  readLocalizationRequest(stream, readRequest);
+
+  BOOST_CHECK_EQUAL(readRequest.id, request.id);
+  BOOST_CHECK(readRequest.imageSize == request.imageSize);
+  BOOST_CHECK(readRequest.useInputIntrinsics);
+  BOOST_CHECK(readRequest.intrinsics.getParams() == request.intrinsics.getParams());
+  BOOST_CHECK_EQUAL(readRequest.intrinsics.w(), 8);
+  BOOST_CHECK_EQUAL(readRequest.intrinsics.h(), 4);
+
+  // the image is sent with 8 bits
+  BOOST_CHECK_EQUAL(readRequest.image.Width(), 8);
+  BOOST_CHECK_EQUAL(readRequest.image.Height(), 4);
+  BOOST_CHECK_SMALL((readRequest.image.GetMat() - request.image.GetMat()).cwiseAbs().maxCoeff(), 1.f / 255.f);
+
+  BOOST_CHECK_EQUAL(readRequest.regions.size(), 1);
+  const feature::SIFT_Regions& regions = dynamic_cast<const feature::SIFT_Regions&>(*request.regions.at(feature::EImageDescriberType::SIFT));
+  const feature::SIFT_Regions& readRegions = dynamic_cast<const feature::SIFT_Regions&>(*readRequest.regions.at(feature::EImageDescriberType::SIFT));
+  BOOST_CHECK_EQUAL(readRegions.RegionCount(), 5);
+  for(std::size_t i = 0; i < regions.RegionCount(); ++i)
+  {
+    BOOST_CHECK(readRegions.Features()[i].coords() == regions.Features()[i].coords());
+    BOOST_CHECK_EQUAL(readRegions.Features()[i].scale(), regions.Features()[i].scale());
+    BOOST_CHECK_EQUAL(readRegions.Features()[i].orientation(), regions.Features()[i].orientation());
+    BOOST_CHECK(readRegions.Descriptors()[i] == regions.Descriptors()[i]);
+  }
+
+  // truncated message
+  const std::string data = stream.str();
+  std::stringstream truncatedStream(data.substr(0, data.size() - 10));
+  BOOST_CHECK_THROW(readLocalizationRequest(truncatedStream, readRequest), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(LocalizationServer_requestIOInvalidSizes)
+{
+  // request without image and regions: the message ends with the image size and the number of describer types
+  LocalizationRequest request;
+  request.intrinsics = camera::PinholeRadialK3(8, 4, 10.0, 4.0, 2.0);
+  std::stringstream stream;
+  writeLocalizationRequest(stream, request);
+  const std::string data = stream.str();
+  const std::string header = data.substr(0, data.size() - 3 * sizeof(std::uint32_t));
+
+  LocalizationRequest readRequest;
+
+  // huge image: rejected before the allocation
+  std::string hugeImage = header;
+  append(hugeImage, std::uint32_t(0xFFFFFFFF));
+  append(hugeImage, std::uint32_t(0xFFFFFFFF));
+  std::stringstream hugeImageStream(hugeImage);
+  BOOST_CHECK_THROW(readLocalizationRequest(hugeImageStream, readRequest), std::runtime_error);
+
+  // regions count whose size in bytes overflows
+  std::string hugeRegions = header;
+  append(hugeRegions, std::uint32_t(0));
+  append(hugeRegions, std::uint32_t(0));
+  append(hugeRegions, std::uint32_t(1));
+  append(hugeRegions, static_cast<std::int32_t>(feature::EImageDescriberType::SIFT));
+  append(hugeRegions, std::uint64_t(1) << 62);
+  std::stringstream hugeRegionsStream(hugeRegions);
+  BOOST_CHECK_THROW(readLocalizationRequest(hugeRegionsStream, readRequest), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(LocalizationServer_responseIO)
+{
+  LocalizationResponse response;
+  response.requestId = 7;
+  response.localized = true;
+  response.pose = geometry::Pose3(Mat3::Random(), Vec3::Random());
+  response.intrinsics = camera::PinholeRadialK3(640, 480, 1400, 320.5, 240.5, 0.001, -0.05, 0.00003);
+  response.nbAssociations = 120;
+  response.nbInliers = 80;
+  response.batchSize = 3;
+  for(std::size_t i = 0; i < nbLocalizationStages; ++i)
+    response.latenciesMs[i] = 1.5 * i;
+  response.error = "none";
+
+  std::stringstream stream;
+  writeLocalizationResponse(stream, response);
+
+  LocalizationResponse readResponse;
+  readLocalizationResponse(stream, readResponse);
+
+  BOOST_CHECK_EQUAL(readResponse.requestId, response.requestId);
+  BOOST_CHECK(readResponse.localized);
+  BOOST_CHECK(readResponse.pose.rotation() == response.pose.rotation());
+  BOOST_CHECK(readResponse.pose.center() == response.pose.center());
+  BOOST_CHECK(readResponse.intrinsics.getParams() == response.intrinsics.getParams());
+  BOOST_CHECK_EQUAL(readResponse.nbAssociations, response.nbAssociations);
+  BOOST_CHECK_EQUAL(readResponse.nbInliers, response.nbInliers);
+  BOOST_CHECK_EQUAL(readResponse.batchSize, response.batchSize);
+  BOOST_CHECK(readResponse.latenciesMs == response.latenciesMs);
+  BOOST_CHECK_EQUAL(readResponse.error, response.error);
+}
+
+BOOST_AUTO_TEST_CASE(LocalizationServer_processAllRequests)
+{
+  CountingLocalizer localizer;
+  CountingParameters param;
+
+  const int nbClients = 4;
+  const int nbRequestsPerClient = 24;
+
+  std::mutex mutex;
+  std::set<std::uint64_t> responseIds;
+  std::size_t nbErrors = 0;
+  std::size_t maxBatchSize = 0;
+
+  {
+    LocalizationServer server(localizer, param, 3, 4, 8);
+    BOOST_CHECK_EQUAL(server.getNbWorkers(), 3);
+
+    const auto callback = [&](const LocalizationResponse& response)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      responseIds.insert(response.requestId);
+      if(!response.error.empty())
+        ++nbErrors;
+      maxBatchSize = std::max(maxBatchSize, response.batchSize);
+    };
+
+    std::vector<std::thread> clients;
+    for(int c = 0; c < nbClients; ++c)
+    {
+      clients.emplace_back([&, c]()
+      {
+        for(int i = 0; i < nbRequestsPerClient; ++i)
+        {
+          LocalizationRequest request;
+          request.id = c * nbRequestsPerClient + i;
+          if(i % 2 == 0)
+            request.image = image::Image<float>(8, 8);
+          else
+            request.regions[feature::EImageDescriberType::SIFT] = generateSiftRegions(3);
+          BOOST_CHECK(server.submit(std::move(request), callback));
+        }
+      });
+    }
+    for(std::thread& client : clients)
+      client.join();
+
+    // a request without image and features is rejected
+    BOOST_CHECK(server.submit(LocalizationRequest(), callback));
+
+    // the pending requests are processed before the server stops
+    server.stop();
+    BOOST_CHECK(!server.submit(LocalizationRequest(), callback));
+
+    const std::size_t nbRequests = nbClients * nbRequestsPerClient + 1;
+    BOOST_CHECK_EQUAL(server.getLatencyHistogram(ELocalizationStage::TOTAL).count(), nbRequests);
+    BOOST_CHECK_EQUAL(server.getLatencyHistogram(ELocalizationStage::LOCALIZATION).count(), nbRequests - 1);
+  }
+
+  BOOST_CHECK_EQUAL(responseIds.size(), nbClients * nbRequestsPerClient);
+  BOOST_CHECK_EQUAL(nbErrors, 1);
+  BOOST_CHECK_LE(maxBatchSize, 4);
+  BOOST_CHECK_EQUAL(localizer.nbImages, nbClients * nbRequestsPerClient / 2);
+  BOOST_CHECK_EQUAL(localizer.nbRegions + localizer.nbImages, nbClients * nbRequestsPerClient);
+}
+
+#if defined(__LINUX__) || defined(__APPLE__)
+BOOST_AUTO_TEST_CASE(LocalizationServer_localSocket)
+{
+  CountingLocalizer localizer;
+  CountingParameters param;
+  LocalizationServer server(localizer, param, 1, 1, 4);
+
+  const std::string socketPath = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("localizationServer-%%%%-%%%%.sock")).string();
+  const int serverSocket = listenLocalSocket(socketPath);
+  BOOST_REQUIRE_NE(serverSocket, -1);
+
+  // server side: process one LOCALIZE message and send the response
+  // (the Boost.Test assertions are only used by the main thread)
+  bool serverSuccess = false;
+  std::thread serverThread([&]()
+  {
+    const int socket = acceptLocalSocket(serverSocket, 10000);
+    if(socket == -1)
+      return;
+
+    EServerMessage type;
+    std::string payload;
+    if(receiveMessage(socket, type, payload) && type == EServerMessage::LOCALIZE)
+    {
+      LocalizationRequest request;
+      std::istringstream requestStream(payload);
+      readLocalizationRequest(requestStream, request);
+
+      std::string responsePayload;
+      server.submit(std::move(request), [&](const LocalizationResponse& response)
+      {
+        std::ostringstream responseStream;
+        writeLocalizationResponse(responseStream, response);
+        responsePayload = responseStream.str();
+      });
+      server.stop();
+
+      serverSuccess = !responsePayload.empty() && sendMessage(socket, EServerMessage::LOCALIZE_RESULT, responsePayload);
+    }
+    closeLocalSocket(socket);
+  });
+
+  // client side
+  const int socket = connectLocalSocket(socketPath);
+  BOOST_CHECK_NE(socket, -1);
+
+  LocalizationRequest request;
+  request.id = 42;
+  request.regions[feature::EImageDescriberType::SIFT] = generateSiftRegions(3);
+  std::ostringstream requestStream;
+  writeLocalizationRequest(requestStream, request);
+  BOOST_CHECK(sendMessage(socket, EServerMessage::LOCALIZE, requestStream.str()));
+
+  EServerMessage type;
+  std::string payload;
+  BOOST_CHECK(receiveMessage(socket, type, payload));
+  BOOST_CHECK(type == EServerMessage::LOCALIZE_RESULT);
+
+  LocalizationResponse response;
+  std::istringstream responseStream(payload);
+  readLocalizationResponse(responseStream, response);
+  BOOST_CHECK_EQUAL(response.requestId, 42);
+  BOOST_CHECK(!response.localized);
+  BOOST_CHECK_EQUAL(localizer.nbRegions, 1);
+
+  // the connection is closed by the server
+  BOOST_CHECK(!receiveMessage(socket, type, payload));
+
+  closeLocalSocket(socket);
+  serverThread.join();
+  BOOST_CHECK(serverSuccess);
+  closeLocalSocket(serverSocket);
+  boost::filesystem::remove(socketPath);
+}
+#endif
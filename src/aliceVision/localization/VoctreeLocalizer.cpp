@@ -8,6 +8,7 @@
 #include "rigResection.hpp"
 #include "optimization.hpp"
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
 #include <aliceVision/sfm/pipeline/RelativePoseInfo.hpp>
 #include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
@@ -26,9 +27,18 @@
 
 #include <boost/progress.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/streams/bufferstream.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <set>
 
 namespace aliceVision {
 namespace localization {
@@ -44,6 +54,110 @@ std::ostream& operator<<( std::ostream& os, const voctree::Document &doc )
   return os;
 }
 
+namespace {
+
+/// Localization map file identifier and version (see VoctreeLocalizer::saveLocalizationMap)
+const char localizationMapMagic[8] = {'A', 'V', 'L', 'O', 'C', 'M', 'A', 'P'};
+const std::uint32_t localizationMapVersion = 2;
+
+/// 64-bit FNV-1a hash of a value, portable across compilers (unlike std::hash)
+template <typename T>
+void hashMapValue(std::uint64_t& hash, const T& value)
+{
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+  for(std::size_t i = 0; i < sizeof(T); ++i)
+  {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+}
+
+/**
+ * @brief Hash of the view ids, the landmark ids and the landmark observations of a scene:
+ * the localization map associates the features of the views to the landmarks
+ */
+std::uint64_t computeSceneHash(const sfmData::SfMData& sfmData)
+{
+  std::uint64_t hash = 14695981039346656037ull;
+  for(const auto& viewIt : sfmData.getViews())
+    hashMapValue<std::uint64_t>(hash, viewIt.first);
+  for(const auto& landmarkIt : sfmData.getLandmarks())
+  {
+    hashMapValue<std::uint64_t>(hash, landmarkIt.first);
+    for(const auto& observationIt : landmarkIt.second.observations)
+    {
+      hashMapValue<std::uint64_t>(hash, observationIt.first);
+      hashMapValue<std::uint64_t>(hash, observationIt.second.id_feat);
+    }
+  }
+  return hash;
+}
+
+template <typename T>
+void writeMapValue(std::ostream& stream, const T& value)
+{
+  stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void writeMapString(std::ostream& stream, const std::string& value)
+{
+  writeMapValue<std::uint32_t>(stream, value.size());
+  stream.write(value.data(), value.size());
+}
+
+/**
+ * @brief Sequential reader of a memory mapped localization map
+ */
+class LocalizationMapReader
+{
+public:
+  LocalizationMapReader(const char* begin, const char* end)
+    : _current(begin)
+    , _end(end)
+  {}
+
+  /// Skip the given number of bytes and return a pointer on them
+  const char* read(std::size_t size)
+  {
+    if(static_cast<std::size_t>(_end - _current) < size)
+      throw std::runtime_error("Truncated localization map.");
+    const char* data = _current;
+    _current += size;
+    return data;
+  }
+
+  /**
+   * @brief Check that nbElements elements of elementSize bytes are left,
+   * to validate the sizes read from the map before allocating anything
+   */
+  void checkRemaining(std::uint64_t nbElements, std::uint64_t elementSize) const
+  {
+    // compare with a division: nbElements * elementSize may overflow
+    if(elementSize != 0 && nbElements > static_cast<std::uint64_t>(_end - _current) / elementSize)
+      throw std::runtime_error("Truncated localization map.");
+  }
+
+  template <typename T>
+  T readValue()
+  {
+    T value;
+    std::memcpy(&value, read(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  std::string readString()
+  {
+    const std::uint32_t size = readValue<std::uint32_t>();
+    return std::string(read(size), size);
+  }
+
+private:
+  const char* _current;
+  const char* _end;
+};
+
+} // namespace
+
 std::ostream& operator<<(std::ostream& os, VoctreeLocalizer::Algorithm a)
 {
   switch(a)
@@ -121,9 +235,11 @@ VoctreeLocalizer::VoctreeLocalizer(const sfmData::SfMData &sfmData,
                                    const std::string &descriptorsFolder,
                                    const std::string &vocTreeFilepath,
                                    const std::string &weightsFilepath,
-                                   const std::vector<feature::EImageDescriberType>& matchingDescTypes)
+                                   const std::vector<feature::EImageDescriberType>& matchingDescTypes,
+                                   const std::string &localizationMapFilepath)
   : ILocalizer()
   , _frameBuffer(5)
+  , _trackedPoses(2)
 {
   using namespace aliceVision::feature;
 
@@ -141,7 +257,7 @@ VoctreeLocalizer::VoctreeLocalizer(const sfmData::SfMData &sfmData,
   // then we can store only those associated to 3D points
   //? can we use Feature_Provider to load the features and filter them later?
 
-  _isInit = initDatabase(vocTreeFilepath, weightsFilepath, descriptorsFolder);
+  _isInit = initDatabase(vocTreeFilepath, weightsFilepath, descriptorsFolder, localizationMapFilepath);
 }
 
 bool VoctreeLocalizer::localize(const feature::MapRegionsPerDesc & queryRegions,
@@ -158,29 +274,246 @@ bool VoctreeLocalizer::localize(const feature::MapRegionsPerDesc & queryRegions,
     // error!
     throw std::invalid_argument("The parameters are not in the right format!!");
   }
-  
-  switch(voctreeParam->_algorithm)
+
+  return localize(queryRegions,
+                  imageSize,
+                  *voctreeParam,
+                  nullptr,
+                  useInputIntrinsics,
+                  queryIntrinsics,
+                  localizationResult,
+                  imagePath);
+}
+
+bool VoctreeLocalizer::localize(const feature::MapRegionsPerDesc & queryRegions,
+                                const std::pair<std::size_t, std::size_t> &imageSize,
+                                const Parameters &param,
+                                const std::vector<voctree::DocMatch>* databaseMatches,
+                                bool useInputIntrinsics,
+                                camera::PinholeRadialK3 &queryIntrinsics,
+                                LocalizationResult & localizationResult,
+                                const std::string& imagePath)
+{
+  // fast path: track the previous frames, the database is only used if the tracking fails
+  if(param._useTracking && localizeByTracking(queryRegions, imageSize, param, useInputIntrinsics, queryIntrinsics, localizationResult))
+    return true;
+
+  bool localized = false;
+  switch(param._algorithm)
   {
     case Algorithm::FirstBest:
-    return localizeFirstBestResult(queryRegions,
+    localized = localizeFirstBestResult(queryRegions,
+                                        imageSize,
+                                        param,
+                                        useInputIntrinsics,
+                                        queryIntrinsics,
+                                        localizationResult,
+                                        imagePath,
+                                        databaseMatches);
+    break;
+    case Algorithm::BestResult: throw std::invalid_argument("BestResult not yet implemented");
+    case Algorithm::AllResults:
+    localized = localizeAllResults(queryRegions,
                                    imageSize,
-                                   *voctreeParam,
+                                   param,
                                    useInputIntrinsics,
                                    queryIntrinsics,
                                    localizationResult,
-                                   imagePath);
-    case Algorithm::BestResult: throw std::invalid_argument("BestResult not yet implemented");
-    case Algorithm::AllResults:
-    return localizeAllResults(queryRegions,
-                              imageSize,
-                              *voctreeParam,
-                              useInputIntrinsics,
-                              queryIntrinsics,
-                              localizationResult,
-                              imagePath);
+                                   imagePath,
+                                   databaseMatches);
+    break;
     case Algorithm::Cluster: throw std::invalid_argument("Cluster not yet implemented");
     default: throw std::invalid_argument("Unknown algorithm type");
   }
+
+  if(param._useTracking)
+  {
+    if(localized)
+    {
+      // the landmarks of the best retrieved images are tracked in the next frames
+      const std::vector<voctree::DocMatch>& matchedImages = localizationResult.getMatchedImages();
+      _trackedImages.assign(matchedImages.begin(), matchedImages.begin() + std::min(matchedImages.size(), param._trackingNbViews));
+      _trackedPoses.emplace_back(localizationResult.getPose());
+      _trackedIntrinsics = queryIntrinsics;
+    }
+    else
+    {
+      resetTracking();
+    }
+  }
+  return localized;
+}
+
+bool VoctreeLocalizer::localizeByTracking(const feature::MapRegionsPerDesc &queryRegions,
+                                          const std::pair<std::size_t, std::size_t> &imageSize,
+                                          const Parameters &param,
+                                          bool useInputIntrinsics,
+                                          camera::PinholeRadialK3 &queryIntrinsics,
+                                          LocalizationResult &localizationResult)
+{
+  if(_trackedPoses.empty() || _trackedImages.empty())
+    return false;
+
+  if(!useInputIntrinsics && (_trackedIntrinsics.w() != imageSize.first || _trackedIntrinsics.h() != imageSize.second))
+  {
+    ALICEVISION_LOG_DEBUG("[tracking]\tThe image size changed, the frame is relocalized");
+    return false;
+  }
+
+  // the intrinsics are known for the resection: the input ones or the ones of the previous frame
+  camera::PinholeRadialK3 intrinsics = useInputIntrinsics ? queryIntrinsics : _trackedIntrinsics;
+
+  // A. predict the pose with a constant motion model
+  const geometry::Pose3& lastPose = _trackedPoses.back();
+  geometry::Pose3 predictedPose = lastPose;
+  if(_trackedPoses.size() > 1)
+  {
+    const geometry::Pose3& previousPose = *_trackedPoses.begin();
+    predictedPose = (lastPose * previousPose.inverse()) * lastPose;
+  }
+
+  // B. project the landmarks seen by the tracked images and match them with the
+  // query features located in a window around their projection
+  std::set<IndexT> projectedLandmarks;
+  std::set<IndMatch3D2D> associations;
+  for(const voctree::DocMatch& trackedImage : _trackedImages)
+  {
+    const IndexT viewId = trackedImage.id;
+    const auto& regionsMapping = _reconstructedRegionsMappingPerView.at(viewId);
+
+    for(const auto& regionsIt : _regionsPerView.getRegionsPerDesc(viewId))
+    {
+      const feature::EImageDescriberType descType = regionsIt.first;
+      const auto queryRegionsIt = queryRegions.find(descType);
+      if(queryRegionsIt == queryRegions.end())
+        continue;
+
+      const feature::Regions& regions = *regionsIt.second;
+      const std::vector<IndexT>& associated3dPoint = regionsMapping.at(descType)._associated3dPoint;
+      std::vector<Vec2> predictedPositions(regions.RegionCount(), Vec2::Constant(std::numeric_limits<double>::quiet_NaN()));
+
+      for(std::size_t i = 0; i < regions.RegionCount(); ++i)
+      {
+        // each landmark is projected once, even if it is seen by several tracked images
+        if(!projectedLandmarks.insert(associated3dPoint[i]).second)
+          continue;
+
+        const Vec3& X = _sfm_data.getLandmarks().at(associated3dPoint[i]).X;
+        if(predictedPose.depth(X) <= 0.0)
+          continue;
+
+        const Vec2 projection = intrinsics.project(predictedPose, X);
+        if(projection.x() < 0.0 || projection.y() < 0.0 || projection.x() >= imageSize.first || projection.y() >= imageSize.second)
+          continue;
+
+        predictedPositions[i] = projection;
+      }
+
+      matching::IndMatches matches;
+      robustEstimation::GuidedMatchingInWindow(predictedPositions,
+                                               regions,
+                                               *queryRegionsIt->second,
+                                               param._trackingWindowRadius,
+                                               Square(param._fDistRatio),
+                                               matches);
+
+      for(const matching::IndMatch& match : matches)
+        associations.emplace(associated3dPoint[match._i], descType, match._j);
+    }
+  }
+
+  ALICEVISION_LOG_DEBUG("[tracking]\t" << associations.size() << " associations found from " << projectedLandmarks.size() << " projected landmarks");
+  if(associations.size() < std::max<std::size_t>(param._trackingMinInliers, 6))
+  {
+    ALICEVISION_LOG_DEBUG("[tracking]\tNot enough associations, the frame is relocalized");
+    return false;
+  }
+
+  // C. estimate the pose with the known intrinsics and refine it
+  sfm::ImageLocalizerMatchData resectionData;
+  resectionData.pt2D = Mat2X(2, associations.size());
+  resectionData.pt3D = Mat3X(3, associations.size());
+  resectionData.vec_descType.reserve(associations.size());
+  std::vector<IndMatch3D2D> associationIDs;
+  associationIDs.reserve(associations.size());
+
+  std::size_t index = 0;
+  for(const IndMatch3D2D& association : associations)
+  {
+    resectionData.pt2D.col(index) = queryRegions.at(association.descType)->GetRegionPosition(association.featId);
+    resectionData.pt3D.col(index) = _sfm_data.getLandmarks().at(association.landmarkId).X;
+    resectionData.vec_descType.push_back(association.descType);
+    associationIDs.push_back(association);
+    ++index;
+  }
+
+  resectionData.error_max = param._errorMax;
+  geometry::Pose3 pose;
+  if(!sfm::SfMLocalizer::Localize(imageSize, &intrinsics, resectionData, pose, param._resectionEstimator))
+  {
+    ALICEVISION_LOG_DEBUG("[tracking]\tResection failed, the frame is relocalized");
+    return false;
+  }
+  if(resectionData.vec_inliers.size() < param._trackingMinInliers)
+  {
+    ALICEVISION_LOG_DEBUG("[tracking]\tNot enough inliers (" << resectionData.vec_inliers.size() << "), the frame is relocalized");
+    return false;
+  }
+  if(!sfm::SfMLocalizer::RefinePose(&intrinsics, pose, resectionData, true /*b_refine_pose*/, param._refineIntrinsics /*b_refine_intrinsic*/))
+  {
+    ALICEVISION_LOG_DEBUG("[tracking]\tRefine pose failed, the frame is relocalized");
+    return false;
+  }
+
+  ALICEVISION_LOG_DEBUG("[tracking]\tFrame tracked with " << resectionData.vec_inliers.size() << " inliers");
+
+  queryIntrinsics = intrinsics;
+  localizationResult = LocalizationResult(resectionData, associationIDs, pose, queryIntrinsics, _trackedImages, true);
+
+  _trackedPoses.emplace_back(pose);
+  _trackedIntrinsics = queryIntrinsics;
+  ++_nbTrackedFrames;
+
+  if(param._nbFrameBufferMatching > 0)
+  {
+    // add everything to the buffer
+    _frameBuffer.emplace_back(localizationResult, queryRegions);
+  }
+  return true;
+}
+
+void VoctreeLocalizer::resetTracking()
+{
+  _trackedPoses.clear();
+  _trackedImages.clear();
+}
+
+void VoctreeLocalizer::queryDatabase(const std::vector<const feature::MapRegionsPerDesc*>& vec_queryRegions,
+                                     const Parameters &param,
+                                     std::vector<voctree::DocMatches>& out_databaseMatches) const
+{
+  // same number of results as localizeFirstBestResult and getAllAssociations
+  const std::size_t numResults = (param._algorithm != Algorithm::FirstBest && param._numResults == 0) ? _database.size() : param._numResults;
+
+  std::vector<voctree::SparseHistogram> requestImagesWords(vec_queryRegions.size());
+
+  #pragma omp parallel for
+  for(int i = 0; i < static_cast<int>(vec_queryRegions.size()); ++i)
+  {
+    const auto it = vec_queryRegions[i]->find(_voctreeDescType);
+    if(it == vec_queryRegions[i]->end())
+      continue;
+    requestImagesWords[i] = _voctree->quantizeToSparse(it->second->blindDescriptors());
+  }
+
+  _database.find(requestImagesWords, numResults, out_databaseMatches);
+
+  // no match for the images without regions of the vocabulary tree describer type
+  for(std::size_t i = 0; i < vec_queryRegions.size(); ++i)
+  {
+    if(requestImagesWords[i].empty())
+      out_databaseMatches[i].clear();
+  }
 }
 
 bool VoctreeLocalizer::localize(const image::Image<float>& imageGrey,
@@ -265,7 +598,8 @@ bool VoctreeLocalizer::loadReconstructionDescriptors(const sfmData::SfMData & sf
  */
 bool VoctreeLocalizer::initDatabase(const std::string & vocTreeFilepath,
                                     const std::string & weightsFilepath,
-                                    const std::string & featFolder)
+                                    const std::string & featFolder,
+                                    const std::string & localizationMapFilepath)
 {
 
   bool withWeights = !weightsFilepath.empty();
@@ -278,6 +612,17 @@ bool VoctreeLocalizer::initDatabase(const std::string & vocTreeFilepath,
   ALICEVISION_LOG_DEBUG("tree loaded with " << _voctree->levels() << " levels and "
           << _voctree->splits() << " branching factors");
 
+  if(!localizationMapFilepath.empty())
+  {
+    system::Timer timer;
+    if(loadLocalizationMap(localizationMapFilepath))
+    {
+      ALICEVISION_LOG_INFO("Localization map loaded in " << timer.elapsedMs() << " ms: " << _database.size() << " images in the database.");
+      return true;
+    }
+    ALICEVISION_LOG_WARNING("Cannot use the localization map '" << localizationMapFilepath << "', the database is built from the features and descriptors.");
+  }
+
   ALICEVISION_LOG_DEBUG("Creating the database...");
   // Add each object (document) to the database
   _database = voctree::Database(_voctree->words());
@@ -385,23 +730,252 @@ bool VoctreeLocalizer::initDatabase(const std::string & vocTreeFilepath,
   return true;
 }
 
+bool VoctreeLocalizer::saveLocalizationMap(const std::string& filepath) const
+{
+  std::ofstream stream(filepath, std::ios::binary);
+  if(!stream.is_open())
+  {
+    ALICEVISION_LOG_ERROR("Cannot open the localization map file '" << filepath << "'.");
+    return false;
+  }
+
+  // header: the map is only valid for the same scene, vocabulary tree and describer types
+  stream.write(localizationMapMagic, sizeof(localizationMapMagic));
+  writeMapValue<std::uint32_t>(stream, localizationMapVersion);
+  writeMapValue<std::uint64_t>(stream, _sfm_data.getViews().size());
+  writeMapValue<std::uint64_t>(stream, _sfm_data.getLandmarks().size());
+  writeMapValue<std::uint64_t>(stream, computeSceneHash(_sfm_data));
+  writeMapValue<std::uint64_t>(stream, _voctree->words());
+  writeMapString(stream, feature::EImageDescriberType_enumToString(_voctreeDescType));
+  writeMapValue<std::uint32_t>(stream, _imageDescribers.size());
+  for(const auto& imageDescriber : _imageDescribers)
+    writeMapString(stream, feature::EImageDescriberType_enumToString(imageDescriber->getDescriberType()));
+
+  // database, preceded by its size
+  const std::streampos databaseSizePosition = stream.tellp();
+  writeMapValue<std::uint64_t>(stream, 0);
+  _database.save(stream);
+  const std::streampos databaseEndPosition = stream.tellp();
+  stream.seekp(databaseSizePosition);
+  writeMapValue<std::uint64_t>(stream, databaseEndPosition - databaseSizePosition - std::streamoff(sizeof(std::uint64_t)));
+  stream.seekp(databaseEndPosition);
+
+  // one block per view, the offsets of the blocks are stored in a table at the end of the file
+  std::vector<std::pair<IndexT, std::uint64_t>> viewOffsets;
+  for(const auto& mappingPerDescIt : _reconstructedRegionsMappingPerView)
+  {
+    const IndexT viewId = mappingPerDescIt.first;
+    const feature::MapRegionsPerDesc& regionsPerDesc = _regionsPerView.getData().at(viewId);
+    viewOffsets.emplace_back(viewId, static_cast<std::uint64_t>(stream.tellp()));
+
+    writeMapValue<std::uint32_t>(stream, mappingPerDescIt.second.size());
+    for(const auto& mappingIt : mappingPerDescIt.second)
+    {
+      const ReconstructedRegionsMapping& mapping = mappingIt.second;
+      const feature::Regions& regions = *regionsPerDesc.at(mappingIt.first);
+      const std::size_t nbRegions = regions.RegionCount();
+      assert(mapping._associated3dPoint.size() == nbRegions);
+
+      writeMapString(stream, feature::EImageDescriberType_enumToString(mappingIt.first));
+      writeMapValue<std::uint64_t>(stream, nbRegions);
+      writeMapValue<std::uint32_t>(stream, regions.FeatureRawSize());
+      writeMapValue<std::uint32_t>(stream, regions.DescriptorRawSize());
+      stream.write(reinterpret_cast<const char*>(mapping._associated3dPoint.data()), nbRegions * sizeof(IndexT));
+      writeMapValue<std::uint64_t>(stream, mapping._mapFullToLocal.size());
+      for(const auto& fullToLocal : mapping._mapFullToLocal)
+      {
+        writeMapValue<IndexT>(stream, fullToLocal.first);
+        writeMapValue<IndexT>(stream, fullToLocal.second);
+      }
+      if(nbRegions > 0)
+      {
+        stream.write(static_cast<const char*>(regions.FeatureRawData()), nbRegions * regions.FeatureRawSize());
+        stream.write(static_cast<const char*>(regions.DescriptorRawData()), nbRegions * regions.DescriptorRawSize());
+      }
+    }
+  }
+
+  const std::uint64_t tablePosition = stream.tellp();
+  writeMapValue<std::uint64_t>(stream, viewOffsets.size());
+  for(const auto& viewOffset : viewOffsets)
+  {
+    writeMapValue<IndexT>(stream, viewOffset.first);
+    writeMapValue<std::uint64_t>(stream, viewOffset.second);
+  }
+  writeMapValue<std::uint64_t>(stream, tablePosition);
+
+  if(!stream)
+  {
+    ALICEVISION_LOG_ERROR("Failed to write the localization map file '" << filepath << "'.");
+    return false;
+  }
+  return true;
+}
+
+bool VoctreeLocalizer::loadLocalizationMap(const std::string& filepath)
+{
+  namespace bip = boost::interprocess;
+
+  if(!boost::filesystem::exists(filepath))
+  {
+    ALICEVISION_LOG_WARNING("The localization map file '" << filepath << "' does not exist.");
+    return false;
+  }
+
+  try
+  {
+    // the pages of the file are loaded on demand, the regions are copied from the mapping
+    const bip::file_mapping file(filepath.c_str(), bip::read_only);
+    const bip::mapped_region region(file, bip::read_only);
+    const char* begin = static_cast<const char*>(region.get_address());
+    const char* end = begin + region.get_size();
+    LocalizationMapReader reader(begin, end);
+
+    // check the header
+    if(std::memcmp(reader.read(sizeof(localizationMapMagic)), localizationMapMagic, sizeof(localizationMapMagic)) != 0)
+      throw std::runtime_error("Not a localization map.");
+    if(reader.readValue<std::uint32_t>() != localizationMapVersion)
+      throw std::runtime_error("Unsupported localization map version.");
+    if(reader.readValue<std::uint64_t>() != _sfm_data.getViews().size() ||
+       reader.readValue<std::uint64_t>() != _sfm_data.getLandmarks().size() ||
+       reader.readValue<std::uint64_t>() != computeSceneHash(_sfm_data))
+      throw std::runtime_error("The localization map does not match the scene.");
+    if(reader.readValue<std::uint64_t>() != _voctree->words() ||
+       reader.readString() != feature::EImageDescriberType_enumToString(_voctreeDescType))
+      throw std::runtime_error("The localization map does not match the vocabulary tree.");
+
+    std::map<feature::EImageDescriberType, const feature::ImageDescriber*> imageDescriberPerType;
+    std::set<feature::EImageDescriberType> descTypes;
+    for(const auto& imageDescriber : _imageDescribers)
+    {
+      imageDescriberPerType[imageDescriber->getDescriberType()] = imageDescriber.get();
+      descTypes.insert(imageDescriber->getDescriberType());
+    }
+
+    const std::uint32_t nbDescTypes = reader.readValue<std::uint32_t>();
+    std::set<feature::EImageDescriberType> mapDescTypes;
+    for(std::uint32_t i = 0; i < nbDescTypes; ++i)
+      mapDescTypes.insert(feature::EImageDescriberType_stringToEnum(reader.readString()));
+    if(mapDescTypes != descTypes)
+      throw std::runtime_error("The localization map does not match the describer types.");
+
+    // database
+    const std::uint64_t databaseSize = reader.readValue<std::uint64_t>();
+    const char* databaseData = reader.read(databaseSize);
+    bip::ibufferstream databaseStream(databaseData, databaseSize);
+    _database.load(databaseStream);
+
+    // views table
+    LocalizationMapReader footerReader(end - sizeof(std::uint64_t), end);
+    const std::uint64_t tablePosition = footerReader.readValue<std::uint64_t>();
+    if(tablePosition > region.get_size())
+      throw std::runtime_error("Invalid localization map views table.");
+    LocalizationMapReader tableReader(begin + tablePosition, end);
+    const std::uint64_t nbViews = tableReader.readValue<std::uint64_t>();
+    tableReader.checkRemaining(nbViews, sizeof(IndexT) + sizeof(std::uint64_t));
+
+    // create the entries of each view, then fill them in parallel
+    std::vector<std::uint64_t> viewOffsets(nbViews);
+    std::vector<ReconstructedRegionsMappingPerDesc*> mappingsPerView(nbViews);
+    std::vector<feature::MapRegionsPerDesc*> regionsPerView(nbViews);
+    _reconstructedRegionsMappingPerView.clear();
+    _regionsPerView.getData().clear();
+    for(std::size_t i = 0; i < nbViews; ++i)
+    {
+      const IndexT viewId = tableReader.readValue<IndexT>();
+      viewOffsets[i] = tableReader.readValue<std::uint64_t>();
+      if(viewOffsets[i] > tablePosition)
+        throw std::runtime_error("Invalid localization map views table.");
+      mappingsPerView[i] = &_reconstructedRegionsMappingPerView[viewId];
+      regionsPerView[i] = &_regionsPerView.getData()[viewId];
+    }
+
+    std::string error;
+    #pragma omp parallel for
+    for(int i = 0; i < static_cast<int>(nbViews); ++i)
+    {
+      try
+      {
+        LocalizationMapReader viewReader(begin + viewOffsets[i], begin + tablePosition);
+        const std::uint32_t nbViewDescTypes = viewReader.readValue<std::uint32_t>();
+        for(std::uint32_t d = 0; d < nbViewDescTypes; ++d)
+        {
+          const feature::EImageDescriberType descType = feature::EImageDescriberType_stringToEnum(viewReader.readString());
+          const std::uint64_t nbRegions = viewReader.readValue<std::uint64_t>();
+          const std::size_t featureSize = viewReader.readValue<std::uint32_t>();
+          const std::size_t descriptorSize = viewReader.readValue<std::uint32_t>();
+          // the 3d points, features and descriptors of the regions must fit in the map
+          viewReader.checkRemaining(nbRegions, sizeof(IndexT) + featureSize + descriptorSize);
+
+          std::unique_ptr<feature::Regions>& regions = (*regionsPerView[i])[descType];
+          imageDescriberPerType.at(descType)->allocate(regions);
+          if(regions->FeatureRawSize() != featureSize || regions->DescriptorRawSize() != descriptorSize)
+            throw std::runtime_error("The localization map regions do not match the describer types.");
+
+          ReconstructedRegionsMapping& mapping = (*mappingsPerView[i])[descType];
+          mapping._associated3dPoint.resize(nbRegions);
+          if(nbRegions > 0)
+            std::memcpy(mapping._associated3dPoint.data(), viewReader.read(nbRegions * sizeof(IndexT)), nbRegions * sizeof(IndexT));
+
+          const std::uint64_t nbFullToLocal = viewReader.readValue<std::uint64_t>();
+          viewReader.checkRemaining(nbFullToLocal, 2 * sizeof(IndexT));
+          for(std::uint64_t k = 0; k < nbFullToLocal; ++k)
+          {
+            const IndexT fullIndex = viewReader.readValue<IndexT>();
+            const IndexT localIndex = viewReader.readValue<IndexT>();
+            mapping._mapFullToLocal.emplace_hint(mapping._mapFullToLocal.end(), fullIndex, localIndex);
+          }
+
+          const char* featuresData = viewReader.read(nbRegions * featureSize);
+          const char* descriptorsData = viewReader.read(nbRegions * descriptorSize);
+          regions->LoadRaw(featuresData, descriptorsData, nbRegions);
+        }
+      }
+      catch(const std::exception& e)
+      {
+        #pragma omp critical
+        error = e.what();
+      }
+    }
+    if(!error.empty())
+      throw std::runtime_error(error);
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_WARNING("Failed to load the localization map '" << filepath << "': " << e.what());
+    _database = voctree::Database();
+    _reconstructedRegionsMappingPerView.clear();
+    _regionsPerView.getData().clear();
+    return false;
+  }
+  return true;
+}
+
 bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc &queryRegions,
                                                const std::pair<std::size_t, std::size_t> &queryImageSize,
                                                const Parameters &param,
                                                bool useInputIntrinsics,
                                                camera::PinholeRadialK3 &queryIntrinsics,
                                                LocalizationResult &localizationResult,
-                                               const std::string &imagePath)
+                                               const std::string &imagePath,
+                                               const std::vector<voctree::DocMatch>* databaseMatches)
 {
   // A. Find the (visually) similar images in the database 
-  ALICEVISION_LOG_DEBUG("[database]\tRequest closest images from voctree");
-  // pass the descriptors through the vocabulary tree to get the visual words
-  // associated to each feature
-  voctree::SparseHistogram requestImageWords = _voctree->quantizeToSparse(queryRegions.at(_voctreeDescType)->blindDescriptors());
-  
-  // Request closest images from voctree
   std::vector<voctree::DocMatch> matchedImages;
-  _database.find(requestImageWords, param._numResults, matchedImages);
+  if(databaseMatches)
+  {
+    matchedImages = *databaseMatches;
+  }
+  else
+  {
+    ALICEVISION_LOG_DEBUG("[database]\tRequest closest images from voctree");
+    // pass the descriptors through the vocabulary tree to get the visual words
+    // associated to each feature
+    voctree::SparseHistogram requestImageWords = _voctree->quantizeToSparse(queryRegions.at(_voctreeDescType)->blindDescriptors());
+
+    // Request closest images from voctree
+    _database.find(requestImageWords, param._numResults, matchedImages);
+  }
   
 //  // Debugging log
 //  // for each similar image found print score and number of features
@@ -421,17 +995,14 @@ bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc
   ALICEVISION_LOG_DEBUG("[matching]\tBuilding the matcher");
   matching::RegionsDatabaseMatcherPerDesc matchers(_matcherType, queryRegions);
 
-  sfm::ImageLocalizerMatchData resectionData;
-  std::vector<IndMatch3D2D> associationIDs;
-  geometry::Pose3 pose;
- 
-  // B. for each found similar image, try to find the correspondences between the 
-  // query image and the similar image
+  // minimum number of points that allows a reliable 3D reconstruction
+  const size_t minNum3DPoints = 5;
+
+  // B. select the similar images to verify
+  std::vector<IndexT> candidateViewIds;
+  candidateViewIds.reserve(matchedImages.size());
   for(const voctree::DocMatch& matchedImage : matchedImages)
   {
-    // minimum number of points that allows a reliable 3D reconstruction
-    const size_t minNum3DPoints = 5;
-    
     // the view index of the current matched image
     const IndexT matchedViewId = matchedImage.id;
     // the handler to the current view
@@ -445,171 +1016,260 @@ bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc
       ALICEVISION_LOG_DEBUG("[matching]\tSkipping matching with " << matchedView->getImagePath() << " as it has too few visible 3D points (" << _regionsPerView.getRegionsPerDesc(matchedViewId).getNbAllRegions() << ")");
       continue;
     }
-    ALICEVISION_LOG_DEBUG("[matching]\tTrying to match the query image with " << matchedView->getImagePath());
 
     // its associated intrinsics
     const camera::IntrinsicBase *matchedIntrinsicsBase = _sfm_data.getIntrinsicPtr(matchedView->getIntrinsicId());
     if ( !isPinhole(matchedIntrinsicsBase->getType()) )
       throw std::logic_error("Unsupported intrinsic: " + EINTRINSIC_enumToString(matchedIntrinsicsBase->getType()) + " (only Pinhole cameras are supported for localization).");
 
-    const camera::Pinhole *matchedIntrinsics = (const camera::Pinhole*)(matchedIntrinsicsBase);
-    
-    matching::MatchesPerDescType featureMatches;
-    bool matchWorked = robustMatching(matchers,
-                                      // pass the input intrinsic if they are valid, null otherwise
-                                      (useInputIntrinsics) ? &queryIntrinsics : nullptr,
-                                      _regionsPerView.getRegionsPerDesc(matchedViewId),
-                                      matchedIntrinsics,
-                                      param._fDistRatio,
-                                      param._matchingError,
-                                      param._useRobustMatching,
-                                      param._useGuidedMatching,
-                                      queryImageSize,
-                                      std::make_pair(matchedView->getWidth(), matchedView->getHeight()),
-                                      featureMatches,
-                                      param._matchingEstimator);
-    if (!matchWorked)
-    {
-      ALICEVISION_LOG_DEBUG("[matching]\tMatching with " << matchedView->getImagePath() << " failed! Skipping image");
-      continue;
-    }
-
-    std::size_t nbAllMatches = featureMatches.getNbAllMatches();
-    ALICEVISION_LOG_DEBUG("[matching]\tFound " << nbAllMatches << " geometrically validated matches");
-    assert(nbAllMatches > 0);
-    
-    if(!param._visualDebug.empty() && !imagePath.empty())
-    {
-      namespace bfs = boost::filesystem;
-      const sfmData::View *mview = _sfm_data.getViews().at(matchedViewId).get();
-      const std::string queryimage = bfs::path(imagePath).stem().string();
-      const std::string matchedImage = bfs::path(mview->getImagePath()).stem().string();
-      const std::string matchedPath = mview->getImagePath();
-      
-      feature::saveMatches2SVG(imagePath,
-                      queryImageSize,
-                      queryRegions,
-                      matchedPath,
-                      std::make_pair(mview->getWidth(), mview->getHeight()),
-                      _regionsPerView.getRegionsPerDesc(matchedViewId),
-                      featureMatches,
-                      param._visualDebug + "/" + queryimage + "_" + matchedImage + ".svg"); 
-    }
-    
-    // C. recover the 2D-3D associations from the matches 
-    // Each matched feature in the current similar image is associated to a 3D point,
-    // hence we can recover the 2D-3D associations to estimate the pose
-    // Prepare data for resection
-    resectionData = sfm::ImageLocalizerMatchData();
-    resectionData.pt2D = Mat2X(2, nbAllMatches);
-    resectionData.pt3D = Mat3X(3, nbAllMatches);
-    associationIDs.clear();
-    associationIDs.reserve(nbAllMatches);
-
-    // Get the 3D points associated to each matched feature
-    std::size_t index = 0;
-    for(const auto& featureMatchesIt : featureMatches)
-    {
-      const feature::EImageDescriberType descType = featureMatchesIt.first;
-      const auto& matchedRegions = _reconstructedRegionsMappingPerView.at(matchedViewId).at(descType);
-
-      for(const matching::IndMatch& featureMatch : featureMatchesIt.second)
-      {
-        // the ID of the 3D point
-        const IndexT trackId3D = matchedRegions._associated3dPoint[featureMatch._j];
-
-        // prepare data for resectioning
-        resectionData.pt3D.col(index) = _sfm_data.getLandmarks().at(trackId3D).X;
+    candidateViewIds.push_back(matchedViewId);
+  }
 
-        const Vec2 feat = queryRegions.at(descType)->GetRegionPosition(featureMatch._i);
-        resectionData.pt2D.col(index) = feat;
+  sfm::ImageLocalizerMatchData resectionData;
+  std::vector<IndMatch3D2D> associationIDs;
+  geometry::Pose3 pose;
 
-        associationIDs.emplace_back(trackId3D, descType, featureMatch._i);
+  const int nbThreads = (param._nbVerificationThreads == 0) ? omp_get_max_threads() : static_cast<int>(param._nbVerificationThreads);
 
-        ++index;
+  // C. for each found similar image, try to find the correspondences between the
+  // query image and the similar image and to estimate the pose from them
+  if(nbThreads <= 1 || candidateViewIds.size() <= 1)
+  {
+    const auto neverCancelled = [](){ return false; };
+    for(const IndexT matchedViewId : candidateViewIds)
+    {
+      if(localizeFromMatchedImage(matchers, queryRegions, queryImageSize, param, useInputIntrinsics, matchedViewId,
+                                  imagePath, neverCancelled, queryIntrinsics, resectionData, associationIDs, pose))
+      {
+        localizationResult = LocalizationResult(resectionData, associationIDs, pose, queryIntrinsics, matchedImages, true);
+        break;
       }
     }
-    assert(index == nbAllMatches);
-
-    // estimate the pose
-    // Do the resectioning: compute the camera pose.
-    resectionData.error_max = param._errorMax;
-    ALICEVISION_LOG_DEBUG("[poseEstimation]\tEstimating camera pose...");
-    bool bResection = sfm::SfMLocalizer::Localize(queryImageSize,
-                                                   // pass the input intrinsic if they are valid, null otherwise
-                                                   (useInputIntrinsics) ? &queryIntrinsics : nullptr,
-                                                   resectionData,
-                                                   pose,
-                                                   param._resectionEstimator);
-
-    if(!bResection)
-    {
-      ALICEVISION_LOG_DEBUG("[poseEstimation]\tResection failed");
-      // try next one
+    //@todo deal with unsuccesful case...
+    return localizationResult.isValid();
+  }
+
+  // speculative verification of the similar images: the workers take the images in the
+  // order of their score and the images ranked after a successful one are cancelled
+  struct Candidate
+  {
+    bool success = false;
+    camera::PinholeRadialK3 intrinsics;
+    sfm::ImageLocalizerMatchData resectionData;
+    std::vector<IndMatch3D2D> associationIDs;
+    geometry::Pose3 pose;
+  };
+  const int nbCandidates = static_cast<int>(candidateViewIds.size());
+  std::vector<Candidate> candidates(nbCandidates);
+  std::atomic<int> firstSuccess(nbCandidates);
+
+  #pragma omp parallel for num_threads(nbThreads) schedule(dynamic)
+  for(int i = 0; i < nbCandidates; ++i)
+  {
+    const auto isCancelled = [&firstSuccess, i](){ return firstSuccess < i; };
+    if(isCancelled())
       continue;
-    }
-    ALICEVISION_LOG_DEBUG("[poseEstimation]\tResection SUCCEDED");
-       
-    ALICEVISION_LOG_DEBUG("R est\n" << pose.rotation());
-    ALICEVISION_LOG_DEBUG("t est\n" << pose.translation());
-
-    // if we didn't use the provided intrinsics, estimate K from the projection
-    // matrix estimated by the localizer and initialize the queryIntrinsics with
-    // it and the image size. This will provide a first guess for the refine function
-    if(!useInputIntrinsics)
-    {
-      // Decompose P matrix
-      Mat3 K_, R_;
-      Vec3 t_;
-      // Decompose the projection matrix  to get K, R and t using 
-      // RQ decomposition
-      KRt_From_P(resectionData.projection_matrix, &K_, &R_, &t_);
-      ALICEVISION_LOG_DEBUG("K estimated\n" << K_);
-      queryIntrinsics.setK(K_);
-      queryIntrinsics.setWidth(queryImageSize.first);
-      queryIntrinsics.setHeight(queryImageSize.second);
-    }
 
-    // D. refine the estimated pose
-    ALICEVISION_LOG_DEBUG("[poseEstimation]\tRefining estimated pose");
-    bool refineStatus = sfm::SfMLocalizer::RefinePose(&queryIntrinsics, 
-                                                       pose, 
-                                                       resectionData, 
-                                                       true /*b_refine_pose*/, 
-                                                       param._refineIntrinsics /*b_refine_intrinsic*/);
-    if(!refineStatus)
-    {
-      ALICEVISION_LOG_DEBUG("[poseEstimation]\tRefine pose failed.");
-      // try next one
+    Candidate& candidate = candidates[i];
+    candidate.intrinsics = queryIntrinsics;
+    candidate.success = localizeFromMatchedImage(matchers, queryRegions, queryImageSize, param, useInputIntrinsics, candidateViewIds[i],
+                                                 imagePath, isCancelled, candidate.intrinsics, candidate.resectionData, candidate.associationIDs, candidate.pose);
+    if(!candidate.success)
       continue;
-    }
-    
-    {
-      // just temporary code to evaluate the estimated pose @todo remove it
-      const geometry::Pose3 referencePose = _sfm_data.getPose(*_sfm_data.views.at(matchedViewId)).getTransform();
-      ALICEVISION_LOG_DEBUG("R refined\n" << pose.rotation());
-      ALICEVISION_LOG_DEBUG("t refined\n" << pose.translation());
-      ALICEVISION_LOG_DEBUG("K refined\n" << queryIntrinsics.K());
-      ALICEVISION_LOG_DEBUG("R_gt\n" << referencePose.rotation());
-      ALICEVISION_LOG_DEBUG("t_gt\n" << referencePose.translation());
-      ALICEVISION_LOG_DEBUG("angular difference: " << radianToDegree(getRotationMagnitude(pose.rotation()*referencePose.rotation().inverse())) << "deg");
-      ALICEVISION_LOG_DEBUG("center difference: " << (pose.center()-referencePose.center()).norm());
-      ALICEVISION_LOG_DEBUG("err = [err; " << radianToDegree(getRotationMagnitude(pose.rotation()*referencePose.rotation().inverse())) << ", "<< (pose.center()-referencePose.center()).norm() << "];");
-    }
-    localizationResult = LocalizationResult(resectionData, associationIDs, pose, queryIntrinsics, matchedImages, refineStatus);
-    break;
+
+    // keep the best ranked success
+    int current = firstSuccess;
+    while(i < current && !firstSuccess.compare_exchange_weak(current, i));
+  }
+
+  if(firstSuccess < nbCandidates)
+  {
+    const Candidate& candidate = candidates[firstSuccess];
+    ALICEVISION_LOG_DEBUG("[poseEstimation]\tLocalized with the candidate " << firstSuccess << " of " << nbCandidates);
+    queryIntrinsics = candidate.intrinsics;
+    localizationResult = LocalizationResult(candidate.resectionData, candidate.associationIDs, candidate.pose, queryIntrinsics, matchedImages, true);
   }
   //@todo deal with unsuccesful case...
   return localizationResult.isValid();
 } 
 
+bool VoctreeLocalizer::localizeFromMatchedImage(matching::RegionsDatabaseMatcherPerDesc& matchers,
+                                                const feature::MapRegionsPerDesc& queryRegions,
+                                                const std::pair<std::size_t, std::size_t>& queryImageSize,
+                                                const Parameters& param,
+                                                bool useInputIntrinsics,
+                                                IndexT matchedViewId,
+                                                const std::string& imagePath,
+                                                const std::function<bool()>& isCancelled,
+                                                camera::PinholeRadialK3& queryIntrinsics,
+                                                sfm::ImageLocalizerMatchData& resectionData,
+                                                std::vector<IndMatch3D2D>& associationIDs,
+                                                geometry::Pose3& pose) const
+{
+  // the handler to the current view
+  const std::shared_ptr<sfmData::View> matchedView = _sfm_data.views.at(matchedViewId);
+  ALICEVISION_LOG_DEBUG("[matching]\tTrying to match the query image with " << matchedView->getImagePath());
+
+  // its associated intrinsics
+  const camera::Pinhole *matchedIntrinsics = (const camera::Pinhole*)(_sfm_data.getIntrinsicPtr(matchedView->getIntrinsicId()));
+
+  matching::MatchesPerDescType featureMatches;
+  bool matchWorked = robustMatching(matchers,
+                                    // pass the input intrinsic if they are valid, null otherwise
+                                    (useInputIntrinsics) ? &queryIntrinsics : nullptr,
+                                    _regionsPerView.getRegionsPerDesc(matchedViewId),
+                                    matchedIntrinsics,
+                                    param._fDistRatio,
+                                    param._matchingError,
+                                    param._useRobustMatching,
+                                    param._useGuidedMatching,
+                                    queryImageSize,
+                                    std::make_pair(matchedView->getWidth(), matchedView->getHeight()),
+                                    featureMatches,
+                                    param._matchingEstimator);
+  if (!matchWorked)
+  {
+    ALICEVISION_LOG_DEBUG("[matching]\tMatching with " << matchedView->getImagePath() << " failed! Skipping image");
+    return false;
+  }
+
+  std::size_t nbAllMatches = featureMatches.getNbAllMatches();
+  ALICEVISION_LOG_DEBUG("[matching]\tFound " << nbAllMatches << " geometrically validated matches");
+  assert(nbAllMatches > 0);
+
+  if(!param._visualDebug.empty() && !imagePath.empty())
+  {
+    namespace bfs = boost::filesystem;
+    const sfmData::View *mview = _sfm_data.getViews().at(matchedViewId).get();
+    const std::string queryimage = bfs::path(imagePath).stem().string();
+    const std::string matchedImage = bfs::path(mview->getImagePath()).stem().string();
+    const std::string matchedPath = mview->getImagePath();
+
+    feature::saveMatches2SVG(imagePath,
+                    queryImageSize,
+                    queryRegions,
+                    matchedPath,
+                    std::make_pair(mview->getWidth(), mview->getHeight()),
+                    _regionsPerView.getRegionsPerDesc(matchedViewId),
+                    featureMatches,
+                    param._visualDebug + "/" + queryimage + "_" + matchedImage + ".svg");
+  }
+
+  if(isCancelled())
+    return false;
+
+  // recover the 2D-3D associations from the matches
+  // Each matched feature in the current similar image is associated to a 3D point,
+  // hence we can recover the 2D-3D associations to estimate the pose
+  // Prepare data for resection
+  resectionData = sfm::ImageLocalizerMatchData();
+  resectionData.pt2D = Mat2X(2, nbAllMatches);
+  resectionData.pt3D = Mat3X(3, nbAllMatches);
+  associationIDs.clear();
+  associationIDs.reserve(nbAllMatches);
+
+  // Get the 3D points associated to each matched feature
+  std::size_t index = 0;
+  for(const auto& featureMatchesIt : featureMatches)
+  {
+    const feature::EImageDescriberType descType = featureMatchesIt.first;
+    const auto& matchedRegions = _reconstructedRegionsMappingPerView.at(matchedViewId).at(descType);
+
+    for(const matching::IndMatch& featureMatch : featureMatchesIt.second)
+    {
+      // the ID of the 3D point
+      const IndexT trackId3D = matchedRegions._associated3dPoint[featureMatch._j];
+
+      // prepare data for resectioning
+      resectionData.pt3D.col(index) = _sfm_data.getLandmarks().at(trackId3D).X;
+
+      const Vec2 feat = queryRegions.at(descType)->GetRegionPosition(featureMatch._i);
+      resectionData.pt2D.col(index) = feat;
+
+      associationIDs.emplace_back(trackId3D, descType, featureMatch._i);
+
+      ++index;
+    }
+  }
+  assert(index == nbAllMatches);
+
+  // estimate the pose
+  // Do the resectioning: compute the camera pose.
+  resectionData.error_max = param._errorMax;
+  ALICEVISION_LOG_DEBUG("[poseEstimation]\tEstimating camera pose...");
+  bool bResection = sfm::SfMLocalizer::Localize(queryImageSize,
+                                                 // pass the input intrinsic if they are valid, null otherwise
+                                                 (useInputIntrinsics) ? &queryIntrinsics : nullptr,
+                                                 resectionData,
+                                                 pose,
+                                                 param._resectionEstimator);
+
+  if(!bResection)
+  {
+    ALICEVISION_LOG_DEBUG("[poseEstimation]\tResection failed");
+    return false;
+  }
+  ALICEVISION_LOG_DEBUG("[poseEstimation]\tResection SUCCEDED");
+
+  ALICEVISION_LOG_DEBUG("R est\n" << pose.rotation());
+  ALICEVISION_LOG_DEBUG("t est\n" << pose.translation());
+
+  if(isCancelled())
+    return false;
+
+  // if we didn't use the provided intrinsics, estimate K from the projection
+  // matrix estimated by the localizer and initialize the queryIntrinsics with
+  // it and the image size. This will provide a first guess for the refine function
+  if(!useInputIntrinsics)
+  {
+    // Decompose P matrix
+    Mat3 K_, R_;
+    Vec3 t_;
+    // Decompose the projection matrix  to get K, R and t using
+    // RQ decomposition
+    KRt_From_P(resectionData.projection_matrix, &K_, &R_, &t_);
+    ALICEVISION_LOG_DEBUG("K estimated\n" << K_);
+    queryIntrinsics.setK(K_);
+    queryIntrinsics.setWidth(queryImageSize.first);
+    queryIntrinsics.setHeight(queryImageSize.second);
+  }
+
+  // refine the estimated pose
+  ALICEVISION_LOG_DEBUG("[poseEstimation]\tRefining estimated pose");
+  bool refineStatus = sfm::SfMLocalizer::RefinePose(&queryIntrinsics,
+                                                     pose,
+                                                     resectionData,
+                                                     true /*b_refine_pose*/,
+                                                     param._refineIntrinsics /*b_refine_intrinsic*/);
+  if(!refineStatus)
+  {
+    ALICEVISION_LOG_DEBUG("[poseEstimation]\tRefine pose failed.");
+    return false;
+  }
+
+  {
+    // just temporary code to evaluate the estimated pose @todo remove it
+    const geometry::Pose3 referencePose = _sfm_data.getPose(*_sfm_data.views.at(matchedViewId)).getTransform();
+    ALICEVISION_LOG_DEBUG("R refined\n" << pose.rotation());
+    ALICEVISION_LOG_DEBUG("t refined\n" << pose.translation());
+    ALICEVISION_LOG_DEBUG("K refined\n" << queryIntrinsics.K());
+    ALICEVISION_LOG_DEBUG("R_gt\n" << referencePose.rotation());
+    ALICEVISION_LOG_DEBUG("t_gt\n" << referencePose.translation());
+    ALICEVISION_LOG_DEBUG("angular difference: " << radianToDegree(getRotationMagnitude(pose.rotation()*referencePose.rotation().inverse())) << "deg");
+    ALICEVISION_LOG_DEBUG("center difference: " << (pose.center()-referencePose.center()).norm());
+    ALICEVISION_LOG_DEBUG("err = [err; " << radianToDegree(getRotationMagnitude(pose.rotation()*referencePose.rotation().inverse())) << ", "<< (pose.center()-referencePose.center()).norm() << "];");
+  }
+  return true;
+}
+
 bool VoctreeLocalizer::localizeAllResults(const feature::MapRegionsPerDesc &queryRegions,
                                           const std::pair<std::size_t, std::size_t> & queryImageSize,
                                           const Parameters &param,
                                           bool useInputIntrinsics,
                                           camera::PinholeRadialK3 &queryIntrinsics,
                                           LocalizationResult &localizationResult,
-                                          const std::string& imagePath)
+                                          const std::string& imagePath,
+                                          const std::vector<voctree::DocMatch>* databaseMatches)
 {
   
   sfm::ImageLocalizerMatchData resectionData;
@@ -629,7 +1289,8 @@ bool VoctreeLocalizer::localizeAllResults(const feature::MapRegionsPerDesc &quer
                      resectionData.pt3D,
                      resectionData.vec_descType,
                      matchedImages,
-                     imagePath);
+                     imagePath,
+                     databaseMatches);
 
   const std::size_t numCollectedPts = occurences.size();
   std::vector<IndMatch3D2D> associationIDs;
@@ -749,23 +1410,31 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
                                           Mat &out_pt3D,
                                           std::vector<feature::EImageDescriberType>& out_descTypes,
                                           std::vector<voctree::DocMatch>& out_matchedImages,
-                                          const std::string& imagePath) const
+                                          const std::string& imagePath,
+                                          const std::vector<voctree::DocMatch>* databaseMatches) const
 {
   assert(out_descTypes.size() == 0);
 
   // A. Find the (visually) similar images in the database 
   // pass the descriptors through the vocabulary tree to get the visual words
   // associated to each feature
-  ALICEVISION_LOG_DEBUG("[database]\tRequest closest images from voctree");
   if(queryRegions.count(_voctreeDescType) == 0)
   {
     ALICEVISION_LOG_WARNING("[database]\t No feature type " << feature::EImageDescriberType_enumToString(_voctreeDescType) << " in query region.");
     return;
   }
-  voctree::SparseHistogram requestImageWords = _voctree->quantizeToSparse(queryRegions.at(_voctreeDescType)->blindDescriptors());
-  
-  // Request closest images from voctree
-  _database.find(requestImageWords, (param._numResults==0) ? (_database.size()) : (param._numResults) , out_matchedImages);
+  if(databaseMatches)
+  {
+    out_matchedImages = *databaseMatches;
+  }
+  else
+  {
+    ALICEVISION_LOG_DEBUG("[database]\tRequest closest images from voctree");
+    voctree::SparseHistogram requestImageWords = _voctree->quantizeToSparse(queryRegions.at(_voctreeDescType)->blindDescriptors());
+
+    // Request closest images from voctree
+    _database.find(requestImageWords, (param._numResults==0) ? (_database.size()) : (param._numResults) , out_matchedImages);
+  }
 
 //  // Debugging log
 //  // for each similar image found print score and number of features
@@ -783,17 +1452,16 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
   ALICEVISION_LOG_DEBUG("[matching]\tBuilding the matcher");
   matching::RegionsDatabaseMatcherPerDesc matchers(_matcherType, queryRegions);
 
-  std::map< std::pair<IndexT, IndexT>, std::size_t > repeated;
-  
-  // B. for each found similar image, try to find the correspondences between the 
-  // query image adn the similar image
-  // stop when param._maxResults successful matches have been found
-  std::size_t goodMatches = 0;
+  // minimum number of points that allows a reliable 3D reconstruction
+  const size_t minNum3DPoints = 5;
+
+  // B. select the similar images to match
+  std::vector<IndexT> candidateViewIds;
+  candidateViewIds.reserve(out_matchedImages.size());
+  // the images ranked after an image with unsupported intrinsics are not matched
+  bool unsupportedIntrinsics = false;
   for(const voctree::DocMatch& matchedImage : out_matchedImages)
   {
-    // minimum number of points that allows a reliable 3D reconstruction
-    const size_t minNum3DPoints = 5;
-
     const auto matchedViewId = matchedImage.id;
     // the handler to the current view
     const std::shared_ptr<sfmData::View> matchedView = _sfm_data.views.at(matchedViewId);
@@ -808,21 +1476,38 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
       ALICEVISION_LOG_DEBUG("[matching]\tSkipping matching with " << matchedView->getImagePath() << " as it has too few visible 3D points");
       continue;
     }
-    ALICEVISION_LOG_TRACE("[matching]\tTrying to match the query image with " << matchedView->getImagePath());
-    ALICEVISION_LOG_TRACE("[matching]\tIt has " << matchedRegions.getNbAllRegions() << " available features to match");
-    
+
     // its associated intrinsics
     // this is just ugly!
     const camera::IntrinsicBase *matchedIntrinsicsBase = _sfm_data.intrinsics.at(matchedView->getIntrinsicId()).get();
     if ( !isPinhole(matchedIntrinsicsBase->getType()) )
     {
-      //@fixme maybe better to throw something here
-      ALICEVISION_CERR("Only Pinhole cameras are supported!");
-      return;
+      unsupportedIntrinsics = true;
+      break;
     }
-    const camera::Pinhole *matchedIntrinsics = (const camera::Pinhole*)(matchedIntrinsicsBase);
+    candidateViewIds.push_back(matchedViewId);
+  }
+
+  // C. for each found similar image, try to find the correspondences between the
+  // query image adn the similar image
+  // stop when param._maxResults successful matches have been found
+  const int nbCandidates = static_cast<int>(candidateViewIds.size());
+  std::vector<matching::MatchesPerDescType> candidatesMatches(nbCandidates);
+  // 0: not matched, 1: matched, -1: matching failed
+  std::vector<std::atomic<int>> candidatesStatus(nbCandidates);
+  for(std::atomic<int>& status : candidatesStatus)
+    status = 0;
+
+  const auto matchCandidate = [&](int i)
+  {
+    const IndexT matchedViewId = candidateViewIds[i];
+    const std::shared_ptr<sfmData::View> matchedView = _sfm_data.views.at(matchedViewId);
+    const feature::MapRegionsPerDesc& matchedRegions = _regionsPerView.getRegionsPerDesc(matchedViewId);
+    const camera::Pinhole *matchedIntrinsics = (const camera::Pinhole*)(_sfm_data.intrinsics.at(matchedView->getIntrinsicId()).get());
+
+    ALICEVISION_LOG_TRACE("[matching]\tTrying to match the query image with " << matchedView->getImagePath());
+    ALICEVISION_LOG_TRACE("[matching]\tIt has " << matchedRegions.getNbAllRegions() << " available features to match");
 
-    matching::MatchesPerDescType featureMatches;
     const bool matchWorked = robustMatching(matchers,
                                       // pass the input intrinsic if they are valid, null otherwise
                                       (useInputIntrinsics) ? &queryIntrinsics : nullptr,
@@ -834,14 +1519,58 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
                                       param._useGuidedMatching,
                                       imageSize,
                                       std::make_pair(matchedView->getWidth(), matchedView->getHeight()),
-                                      featureMatches,
+                                      candidatesMatches[i],
                                       param._matchingEstimator);
-    if (!matchWorked)
+    candidatesStatus[i] = matchWorked ? 1 : -1;
+    return matchWorked;
+  };
+
+  const int nbThreads = (param._nbVerificationThreads == 0) ? omp_get_max_threads() : static_cast<int>(param._nbVerificationThreads);
+
+  if(nbThreads <= 1 || nbCandidates <= 1)
+  {
+    std::size_t nbMatched = 0;
+    for(int i = 0; i < nbCandidates; ++i)
+    {
+      if(matchCandidate(i) && (++nbMatched == param._maxResults))
+        break;
+    }
+  }
+  else
+  {
+    // speculative matching: the workers take the images in the order of their score and
+    // skip an image if enough images ranked before it have already been matched
+    #pragma omp parallel for num_threads(nbThreads) schedule(dynamic)
+    for(int i = 0; i < nbCandidates; ++i)
+    {
+      if(param._maxResults != 0)
+      {
+        std::size_t nbMatchedBefore = 0;
+        for(int j = 0; j < i; ++j)
+        {
+          if(candidatesStatus[j] == 1)
+            ++nbMatchedBefore;
+        }
+        if(nbMatchedBefore >= param._maxResults)
+          continue;
+      }
+      matchCandidate(i);
+    }
+  }
+
+  // D. merge the matches in the order of the similar images
+  std::size_t goodMatches = 0;
+  for(int i = 0; i < nbCandidates; ++i)
+  {
+    if(candidatesStatus[i] != 1)
     {
 //      ALICEVISION_LOG_DEBUG("[matching]\tMatching with " << matchedView->getImagePath() << " failed! Skipping image");
       continue;
     }
 
+    const IndexT matchedViewId = candidateViewIds[i];
+    const matching::MatchesPerDescType& featureMatches = candidatesMatches[i];
+
     ALICEVISION_LOG_DEBUG("[matching]\tFound " << featureMatches.getNbAllMatches() << " geometrically validated matches");
     assert(featureMatches.getNbAllMatches() > 0);
 
@@ -889,7 +1618,7 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
 
     const auto& matchedRegionsMapping = _reconstructedRegionsMappingPerView.at(matchedViewId);
 
-    // C. recover the 2D-3D associations from the matches 
+    // recover the 2D-3D associations from the matches 
     // Each matched feature in the current similar image is associated to a 3D point
     for(const auto& featureMatchesIt : featureMatches)
     {
@@ -920,6 +1649,13 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
       break;
     }
   }
+
+  if(unsupportedIntrinsics && ((param._maxResults == 0) || (goodMatches < param._maxResults)))
+  {
+    //@fixme maybe better to throw something here
+    ALICEVISION_CERR("Only Pinhole cameras are supported!");
+    return;
+  }
   
   if(param._nbFrameBufferMatching > 0)
   {
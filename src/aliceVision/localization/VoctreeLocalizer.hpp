@@ -22,6 +22,8 @@
 
 #include <flann/algorithms/dist.h>
 
+#include <functional>
+
 namespace aliceVision {
 namespace localization {
 
@@ -55,6 +57,11 @@ public:
       , _ccTagUseCuda(true)
       , _matchingError(std::numeric_limits<double>::infinity())
       , _nbFrameBufferMatching(10)
+      , _nbVerificationThreads(1)
+      , _useTracking(false)
+      , _trackingWindowRadius(20.0)
+      , _trackingMinInliers(30)
+      , _trackingNbViews(5)
     {}
     
     /// Enable/disable guided matching when matching images
@@ -75,6 +82,16 @@ public:
     double _matchingError;
     /// maximum capacity of the frame buffer
     std::size_t _nbFrameBufferMatching;
+    /// number of threads verifying the retrieved images concurrently (1 for sequential, 0 for the number of cores)
+    std::size_t _nbVerificationThreads;
+    /// enable/disable the tracking of the previous frames before the retrieval (video sequences)
+    bool _useTracking;
+    /// for the tracking, radius in pixels of the search window around the predicted landmark projections
+    double _trackingWindowRadius;
+    /// for the tracking, minimum number of resection inliers to accept the tracked pose
+    std::size_t _trackingMinInliers;
+    /// for the tracking, number of retrieved images of the last relocalization whose landmarks are tracked
+    std::size_t _trackingNbViews;
   };
   
 public:
@@ -91,7 +108,9 @@ public:
    * tree (usually a .weights file), if not provided the weights will be recomputed 
    * when all the documents are added.
    * @param[in] matchingDescTypes List of descriptor types to use for feature matching.
-   * @param[in] voctreeDescType Descriptor type used for image matching with voctree.
+   * @param[in] localizationMapFilepath Optional path to a localization map (see saveLocalizationMap),
+   * if provided and valid the database and the reconstructed regions are loaded from the map
+   * instead of the features and descriptors of each view.
    *
    * It enable the use of combined SIFT and CCTAG features.
    */
@@ -99,8 +118,22 @@ public:
                    const std::string &descriptorsFolder,
                    const std::string &vocTreeFilepath,
                    const std::string &weightsFilepath,
-                   const std::vector<feature::EImageDescriberType>& matchingDescTypes
+                   const std::vector<feature::EImageDescriberType>& matchingDescTypes,
+                   const std::string &localizationMapFilepath = std::string()
                   );
+
+  /**
+   * @brief Save the localization map: the vocabulary tree database, and for each view
+   * the regions associated to a 3D point with their mapping to the landmarks.
+   * Loading the map is much faster than reading the features and descriptors of each view,
+   * quantizing them and rebuilding the database.
+   * @note The map is a binary file with the native endianness, it depends on the scene
+   * (checked with a hash of the view ids, the landmark ids and their observations),
+   * the vocabulary tree and the describer types.
+   * @param[in] filepath The path of the output map file.
+   * @return true if the map is saved
+   */
+  bool saveLocalizationMap(const std::string& filepath) const;
   
   void setCudaPipe( int i ) override
   {
@@ -150,6 +183,45 @@ public:
                 camera::PinholeRadialK3 &queryIntrinsics,
                 LocalizationResult & localizationResult,
                 const std::string& imagePath = std::string()) override;
+
+  /**
+   * @brief Same as localize, but the images of the database similar to the query image
+   * can be given (see queryDatabase) instead of being requested to the vocabulary tree.
+   * @note It does not modify the localizer if \p param._nbFrameBufferMatching is 0,
+   * so it can be called concurrently from several threads.
+   *
+   * @param[in] queryRegions The input features of the query image
+   * @param[in] imageSize The size of the input image
+   * @param[in] param The parameters for the localization.
+   * @param[in] databaseMatches Optional images of the database similar to the query image,
+   * if null they are requested to the vocabulary tree.
+   * @param[in] useInputIntrinsics Uses the \p queryIntrinsics as known calibration.
+   * @param[in,out] queryIntrinsics Intrinsic parameters of the camera.
+   * @param[out] localizationResult The localization result containing the pose and the associations.
+   * @param[in] imagePath Optional complete path to the image, used only for debugging purposes.
+   * @return  true if the image has been successfully localized.
+   */
+  bool localize(const feature::MapRegionsPerDesc & queryRegions,
+                const std::pair<std::size_t, std::size_t> &imageSize,
+                const Parameters &param,
+                const std::vector<voctree::DocMatch>* databaseMatches,
+                bool useInputIntrinsics,
+                camera::PinholeRadialK3 &queryIntrinsics,
+                LocalizationResult & localizationResult,
+                const std::string& imagePath = std::string());
+
+  /**
+   * @brief Request the images of the database similar to each query image, with a single
+   * pass over the database for all the queries.
+   *
+   * @param[in] vec_queryRegions The input features of the query images
+   * @param[in] param The parameters for the localization (number of results and algorithm)
+   * @param[out] out_databaseMatches The similar images of each query image, empty
+   * if the query image has no feature of the vocabulary tree describer type.
+   */
+  void queryDatabase(const std::vector<const feature::MapRegionsPerDesc*>& vec_queryRegions,
+                     const Parameters &param,
+                     std::vector<voctree::DocMatches>& out_databaseMatches) const;
   
   
   bool localizeRig(const std::vector<image::Image<float>> & vec_imageGrey,
@@ -187,10 +259,43 @@ public:
                         std::vector<LocalizationResult>& vec_locResults);
 
 
+  /**
+   * @brief Try to localize an image by tracking the previous frames: the pose is predicted
+   * with a constant motion model, the landmarks seen by the images retrieved at the last
+   * relocalization are projected and matched in a window around their projection, then the
+   * pose is estimated with the intrinsics of the previous frame (P3P) and refined.
+   *
+   * @param[in] queryRegions The input features of the query image
+   * @param[in] imageSize The size of the input image
+   * @param[in] param The parameters for the localization
+   * @param[in] useInputIntrinsics Uses the \p queryIntrinsics as known calibration
+   * @param[in,out] queryIntrinsics Intrinsic parameters of the camera, they are used if the
+   * flag useInputIntrinsics is set to true, otherwise the ones of the previous frame are used.
+   * @param[out] localizationResult The localization result
+   * @return false if there is no previous frame or if the tracking fails
+   */
+  bool localizeByTracking(const feature::MapRegionsPerDesc &queryRegions,
+                          const std::pair<std::size_t, std::size_t> &imageSize,
+                          const Parameters &param,
+                          bool useInputIntrinsics,
+                          camera::PinholeRadialK3 &queryIntrinsics,
+                          LocalizationResult &localizationResult);
+
+  /**
+   * @brief Forget the previous frames: the next frame is relocalized with the database.
+   */
+  void resetTracking();
+
+  /// number of frames localized by tracking since the creation of the localizer
+  std::size_t getNbTrackedFrames() const { return _nbTrackedFrames; }
+
   /**
    * @brief Try to localize an image in the database: it queries the database to 
    * retrieve \p numResults matching images and it tries to localize the query image
    * wrt the retrieve images in order of their score taking the first best result.
+   * With several verification threads, the retrieved images are verified speculatively:
+   * the verifications of the images ranked after a successful one are cancelled, and the
+   * result is the one of the best ranked image, as with the sequential verification.
    *
    * @param[in] queryRegions The input features of the query image
    * @param[in] imageSize The size of the input image
@@ -201,6 +306,7 @@ public:
    * @param[out] pose The camera pose
    * @param[out] resection_data the 2D-3D correspondences used to compute the pose
    * @param[out] associationIDs the ids of the 2D-3D correspondences used to compute the pose
+   * @param[in] databaseMatches Optional result of the database query (see queryDatabase)
    * @return true if the localization is successful
    */
   bool localizeFirstBestResult(const feature::MapRegionsPerDesc &queryRegions,
@@ -209,13 +315,15 @@ public:
                                bool useInputIntrinsics,
                                camera::PinholeRadialK3 &queryIntrinsics,
                                LocalizationResult &localizationResult,
-                               const std::string &imagePath = std::string());
+                               const std::string &imagePath = std::string(),
+                               const std::vector<voctree::DocMatch>* databaseMatches = nullptr);
 
   /**
    * @brief Try to localize an image in the database: it queries the database to 
    * retrieve \p numResults matching images and it tries to localize the query image
    * wrt the retrieve images in order of their score, collecting all the 2d-3d correspondences
    * and performing the resection with all these correspondences
+   * (see getAllAssociations for the verification of the retrieved images).
    *
    * @param[in] queryRegions The input features of the query image
    * @param[in] imageSize The size of the input image
@@ -226,6 +334,7 @@ public:
    * @param[out] pose The camera pose
    * @param[out] resection_data the 2D-3D correspondences used to compute the pose
    * @param[out] associationIDs the ids of the 2D-3D correspondences used to compute the pose
+   * @param[in] databaseMatches Optional result of the database query (see queryDatabase)
    * @return true if the localization is successful
    */
   bool localizeAllResults(const feature::MapRegionsPerDesc & queryRegions,
@@ -234,11 +343,15 @@ public:
                           bool useInputIntrinsics,
                           camera::PinholeRadialK3 &queryIntrinsics,
                           LocalizationResult &localizationResult,
-                          const std::string& imagePath = std::string());
+                          const std::string& imagePath = std::string(),
+                          const std::vector<voctree::DocMatch>* databaseMatches = nullptr);
   
   
   /**
    * @brief Retrieve matches to all images of the database.
+   * With several verification threads, the retrieved images are matched concurrently and
+   * the matches are merged in the order of the retrieved images: the associations are the
+   * same as with the sequential matching.
    *
    * @param[in] queryRegions
    * @param[in] imageSize
@@ -251,6 +364,7 @@ public:
    * @param[out] out_descTypes output vector of describerType
    * @param[out] out_matchedImages image matches output
    * @param[in] imagePath
+   * @param[in] databaseMatches Optional result of the database query (see queryDatabase)
    */
   void getAllAssociations(const feature::MapRegionsPerDesc & queryRegions,
                           const std::pair<std::size_t, std::size_t> &imageSize,
@@ -262,7 +376,8 @@ public:
                           Mat &out_pt3D,
                           std::vector<feature::EImageDescriberType>& out_descTypes,
                           std::vector<voctree::DocMatch>& out_matchedImages,
-                          const std::string& imagePath = std::string()) const;
+                          const std::string& imagePath = std::string(),
+                          const std::vector<voctree::DocMatch>* databaseMatches = nullptr) const;
 
 private:
   /**
@@ -275,11 +390,22 @@ private:
    * when all the documents are added.
    * @param[in] feat_directory The path to the directory containing the features 
    * of the scene (.desc and .feat files).
+   * @param[in] localizationMapFilepath Optional path to a localization map.
    * @return true if everything went ok
    */
   bool initDatabase(const std::string & vocTreeFilepath,
                     const std::string & weightsFilepath,
-                    const std::string & featFolder);
+                    const std::string & featFolder,
+                    const std::string & localizationMapFilepath);
+
+  /**
+   * @brief Load the database and the reconstructed regions from a localization map
+   * (see saveLocalizationMap).
+   * @param[in] filepath The path of the map file.
+   * @return false if the map cannot be read or does not match the scene, the vocabulary tree
+   * or the describer types
+   */
+  bool loadLocalizationMap(const std::string& filepath);
 
   /**
    * @brief robustMatching
@@ -311,6 +437,39 @@ private:
                       matching::MatchesPerDescType & out_featureMatches,
                       robustEstimation::ERobustEstimator estimator = robustEstimation::ERobustEstimator::ACRANSAC) const;
   
+  /**
+   * @brief Match the query image with a retrieved image and estimate the pose from the
+   * 2D-3D associations of the matches (used by localizeFirstBestResult).
+   *
+   * @param[in] matchers The matchers of the query regions
+   * @param[in] queryRegions The input features of the query image
+   * @param[in] queryImageSize The size of the query image
+   * @param[in] param The parameters for the localization
+   * @param[in] useInputIntrinsics Uses the \p queryIntrinsics as known calibration
+   * @param[in] matchedViewId The view of the retrieved image
+   * @param[in] imagePath The path of the query image, for the visual debug
+   * @param[in] isCancelled Returns true if the verification can be stopped, it is checked
+   * between the matching, the resection and the refinement
+   * @param[in,out] queryIntrinsics Intrinsic parameters of the camera, estimated if
+   * \p useInputIntrinsics is false
+   * @param[out] resectionData the 2D-3D correspondences used to compute the pose
+   * @param[out] associationIDs the ids of the 2D-3D correspondences used to compute the pose
+   * @param[out] pose The camera pose
+   * @return true if the pose is estimated and refined
+   */
+  bool localizeFromMatchedImage(matching::RegionsDatabaseMatcherPerDesc& matchers,
+                                const feature::MapRegionsPerDesc& queryRegions,
+                                const std::pair<std::size_t, std::size_t>& queryImageSize,
+                                const Parameters& param,
+                                bool useInputIntrinsics,
+                                IndexT matchedViewId,
+                                const std::string& imagePath,
+                                const std::function<bool()>& isCancelled,
+                                camera::PinholeRadialK3& queryIntrinsics,
+                                sfm::ImageLocalizerMatchData& resectionData,
+                                std::vector<IndMatch3D2D>& associationIDs,
+                                geometry::Pose3& pose) const;
+
   void getAssociationsFromBuffer(matching::RegionsDatabaseMatcherPerDesc& matchers,
                                  const std::pair<std::size_t, std::size_t> & imageSize,
                                  const Parameters &param,
@@ -354,6 +513,14 @@ public:
   /// Last frames buffer
   BoundedBuffer<FrameData> _frameBuffer;
 
+  /// poses of the last localized frames, to predict the pose of the next frame when tracking
+  BoundedBuffer<geometry::Pose3> _trackedPoses;
+  /// intrinsics of the last localized frame
+  camera::PinholeRadialK3 _trackedIntrinsics;
+  /// images retrieved at the last relocalization, their landmarks are tracked
+  std::vector<voctree::DocMatch> _trackedImages;
+  std::size_t _nbTrackedFrames = 0;
+
   matching::EMatcherType _matcherType = matching::ANN_L2;
 };
 
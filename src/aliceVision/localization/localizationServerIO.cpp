@@ -0,0 +1,395 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "localizationServerIO.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/system.hpp>
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__LINUX__) || defined(__APPLE__)
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace aliceVision {
+namespace localization {
+
+namespace {
+
+/// maximum size of a message payload, larger messages are considered as corrupted
+const std::uint64_t maxMessageSize = std::uint64_t(1) << 32;
+
+struct MessageHeader
+{
+  std::uint32_t type;
+  std::uint32_t reserved;
+  std::uint64_t size;
+};
+
+template <typename T>
+void writeValue(std::ostream& stream, const T& value)
+{
+  stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T readValue(std::istream& stream)
+{
+  T value;
+  if(!stream.read(reinterpret_cast<char*>(&value), sizeof(T)))
+    throw std::runtime_error("Invalid localization server message: unexpected end of message.");
+  return value;
+}
+
+void readBytes(std::istream& stream, void* data, std::size_t size)
+{
+  if(size != 0 && !stream.read(reinterpret_cast<char*>(data), size))
+    throw std::runtime_error("Invalid localization server message: unexpected end of message.");
+}
+
+/**
+ * @brief Check that nbElements elements of elementSize bytes are left in the message,
+ * to validate the sizes read from the message before allocating anything
+ */
+void checkRemainingBytes(std::istream& stream, std::uint64_t nbElements, std::uint64_t elementSize)
+{
+  const std::istream::pos_type position = stream.tellg();
+  stream.seekg(0, std::ios::end);
+  const std::istream::pos_type end = stream.tellg();
+  stream.seekg(position);
+  if(position == std::istream::pos_type(-1) || end == std::istream::pos_type(-1))
+    throw std::runtime_error("Invalid localization server message: cannot get the message size.");
+
+  const std::uint64_t remainingBytes = static_cast<std::uint64_t>(end - position);
+  // compare with a division: nbElements * elementSize may overflow
+  if(elementSize != 0 && nbElements > remainingBytes / elementSize)
+    throw std::runtime_error("Invalid localization server message: unexpected end of message.");
+}
+
+void writeIntrinsics(std::ostream& stream, const camera::PinholeRadialK3& intrinsics)
+{
+  const std::vector<double> params = intrinsics.getParams();
+  writeValue<std::uint32_t>(stream, intrinsics.w());
+  writeValue<std::uint32_t>(stream, intrinsics.h());
+  writeValue<std::uint32_t>(stream, params.size());
+  stream.write(reinterpret_cast<const char*>(params.data()), params.size() * sizeof(double));
+}
+
+void readIntrinsics(std::istream& stream, camera::PinholeRadialK3& intrinsics)
+{
+  const std::uint32_t width = readValue<std::uint32_t>(stream);
+  const std::uint32_t height = readValue<std::uint32_t>(stream);
+  const std::uint32_t nbParams = readValue<std::uint32_t>(stream);
+  if(nbParams > 16)
+    throw std::runtime_error("Invalid localization server message: wrong number of intrinsics parameters.");
+  std::vector<double> params(nbParams);
+  readBytes(stream, params.data(), params.size() * sizeof(double));
+
+  intrinsics = camera::PinholeRadialK3(width, height);
+  if(!intrinsics.updateFromParams(params))
+    throw std::runtime_error("Invalid localization server message: wrong number of intrinsics parameters.");
+}
+
+} // namespace
+
+void writeLocalizationRequest(std::ostream& stream, const LocalizationRequest& request)
+{
+  writeValue<std::uint64_t>(stream, request.id);
+  writeValue<std::uint64_t>(stream, request.imageSize.first);
+  writeValue<std::uint64_t>(stream, request.imageSize.second);
+  writeValue<std::uint8_t>(stream, request.useInputIntrinsics);
+  writeIntrinsics(stream, request.intrinsics);
+
+  // 8-bit greyscale image
+  writeValue<std::uint32_t>(stream, request.image.Width());
+  writeValue<std::uint32_t>(stream, request.image.Height());
+  if(request.image.size() != 0)
+  {
+    const image::Image<unsigned char>::Base imageUChar = (request.image.GetMat() * 255.f).cast<unsigned char>();
+    stream.write(reinterpret_cast<const char*>(imageUChar.data()), imageUChar.size());
+  }
+
+  // raw features and descriptors of each describer type
+  writeValue<std::uint32_t>(stream, request.regions.size());
+  for(const auto& regionsPerDesc : request.regions)
+  {
+    const feature::Regions& regions = *regionsPerDesc.second;
+    const std::size_t count = regions.RegionCount();
+    writeValue<std::int32_t>(stream, static_cast<std::int32_t>(regionsPerDesc.first));
+    writeValue<std::uint64_t>(stream, count);
+    if(count == 0)
+      continue;
+    stream.write(reinterpret_cast<const char*>(regions.FeatureRawData()), count * regions.FeatureRawSize());
+    stream.write(reinterpret_cast<const char*>(regions.DescriptorRawData()), count * regions.DescriptorRawSize());
+  }
+}
+
+void readLocalizationRequest(std::istream& stream, LocalizationRequest& request)
+{
+  request.id = readValue<std::uint64_t>(stream);
+  request.imageSize.first = readValue<std::uint64_t>(stream);
+  request.imageSize.second = readValue<std::uint64_t>(stream);
+  request.useInputIntrinsics = (readValue<std::uint8_t>(stream) != 0);
+  readIntrinsics(stream, request.intrinsics);
+
+  const std::uint32_t width = readValue<std::uint32_t>(stream);
+  const std::uint32_t height = readValue<std::uint32_t>(stream);
+  request.image = image::Image<float>();
+  if(width != 0 && height != 0)
+  {
+    // no overflow: the product of two 32-bit values fits in 64 bits
+    checkRemainingBytes(stream, static_cast<std::uint64_t>(width) * height, 1);
+    image::Image<unsigned char>::Base imageUChar(height, width);
+    readBytes(stream, imageUChar.data(), imageUChar.size());
+    request.image = image::Image<float>::Base(imageUChar.cast<float>() / 255.f);
+  }
+
+  request.regions.clear();
+  const std::uint32_t nbDescTypes = readValue<std::uint32_t>(stream);
+  for(std::uint32_t i = 0; i < nbDescTypes; ++i)
+  {
+    const feature::EImageDescriberType descType = static_cast<feature::EImageDescriberType>(readValue<std::int32_t>(stream));
+    const std::uint64_t count = readValue<std::uint64_t>(stream);
+
+    std::unique_ptr<feature::Regions>& regions = request.regions[descType];
+    feature::createImageDescriber(descType)->allocate(regions);
+    if(count == 0)
+      continue;
+
+    checkRemainingBytes(stream, count, regions->FeatureRawSize() + regions->DescriptorRawSize());
+    std::vector<char> features(count * regions->FeatureRawSize());
+    std::vector<char> descriptors(count * regions->DescriptorRawSize());
+    readBytes(stream, features.data(), features.size());
+    readBytes(stream, descriptors.data(), descriptors.size());
+    regions->LoadRaw(features.data(), descriptors.data(), count);
+  }
+}
+
+void writeLocalizationResponse(std::ostream& stream, const LocalizationResponse& response)
+{
+  writeValue<std::uint64_t>(stream, response.requestId);
+  writeValue<std::uint8_t>(stream, response.localized);
+  stream.write(reinterpret_cast<const char*>(response.pose.rotation().data()), 9 * sizeof(double));
+  stream.write(reinterpret_cast<const char*>(response.pose.center().data()), 3 * sizeof(double));
+  writeIntrinsics(stream, response.intrinsics);
+  writeValue<std::uint64_t>(stream, response.nbAssociations);
+  writeValue<std::uint64_t>(stream, response.nbInliers);
+  writeValue<std::uint64_t>(stream, response.batchSize);
+  stream.write(reinterpret_cast<const char*>(response.latenciesMs.data()), response.latenciesMs.size() * sizeof(double));
+  writeValue<std::uint32_t>(stream, response.error.size());
+  stream.write(response.error.data(), response.error.size());
+}
+
+void readLocalizationResponse(std::istream& stream, LocalizationResponse& response)
+{
+  response.requestId = readValue<std::uint64_t>(stream);
+  response.localized = (readValue<std::uint8_t>(stream) != 0);
+  Mat3 rotation;
+  Vec3 center;
+  readBytes(stream, rotation.data(), 9 * sizeof(double));
+  readBytes(stream, center.data(), 3 * sizeof(double));
+  response.pose = geometry::Pose3(rotation, center);
+  readIntrinsics(stream, response.intrinsics);
+  response.nbAssociations = readValue<std::uint64_t>(stream);
+  response.nbInliers = readValue<std::uint64_t>(stream);
+  response.batchSize = readValue<std::uint64_t>(stream);
+  readBytes(stream, response.latenciesMs.data(), response.latenciesMs.size() * sizeof(double));
+  const std::uint32_t errorSize = readValue<std::uint32_t>(stream);
+  checkRemainingBytes(stream, errorSize, 1);
+  response.error.resize(errorSize);
+  readBytes(stream, &response.error[0], response.error.size());
+}
+
+#if defined(__LINUX__) || defined(__APPLE__)
+
+namespace {
+
+#if defined(MSG_NOSIGNAL)
+const int sendFlags = MSG_NOSIGNAL;
+#else
+const int sendFlags = 0;
+#endif
+
+bool setSocketAddress(const std::string& socketPath, sockaddr_un& address)
+{
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if(socketPath.size() >= sizeof(address.sun_path))
+  {
+    ALICEVISION_LOG_ERROR("The local socket path is too long: " << socketPath);
+    return false;
+  }
+  std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+  return true;
+}
+
+void disableSigPipe(int socket)
+{
+#if defined(SO_NOSIGPIPE)
+  const int value = 1;
+  setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &value, sizeof(value));
+#endif
+}
+
+bool sendAll(int socket, const char* data, std::size_t size)
+{
+  while(size > 0)
+  {
+    const ssize_t sent = ::send(socket, data, size, sendFlags);
+    if(sent < 0 && errno == EINTR)
+      continue;
+    if(sent <= 0)
+      return false;
+    data += sent;
+    size -= sent;
+  }
+  return true;
+}
+
+bool receiveAll(int socket, char* data, std::size_t size)
+{
+  while(size > 0)
+  {
+    const ssize_t received = ::recv(socket, data, size, 0);
+    if(received < 0 && errno == EINTR)
+      continue;
+    if(received <= 0)
+      return false;
+    data += received;
+    size -= received;
+  }
+  return true;
+}
+
+} // namespace
+
+int listenLocalSocket(const std::string& socketPath)
+{
+  sockaddr_un address;
+  if(!setSocketAddress(socketPath, address))
+    return -1;
+
+  const int socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if(socket < 0)
+  {
+    ALICEVISION_LOG_ERROR("Cannot create the local socket: " << std::strerror(errno));
+    return -1;
+  }
+
+  ::unlink(socketPath.c_str());
+  if(::bind(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0 ||
+     ::listen(socket, SOMAXCONN) < 0)
+  {
+    ALICEVISION_LOG_ERROR("Cannot listen to the local socket '" << socketPath << "': " << std::strerror(errno));
+    ::close(socket);
+    return -1;
+  }
+  return socket;
+}
+
+int acceptLocalSocket(int socket, int timeoutMs)
+{
+  pollfd pollSocket;
+  pollSocket.fd = socket;
+  pollSocket.events = POLLIN;
+  pollSocket.revents = 0;
+  if(::poll(&pollSocket, 1, timeoutMs) <= 0)
+    return -1;
+
+  const int connection = ::accept(socket, nullptr, nullptr);
+  if(connection >= 0)
+    disableSigPipe(connection);
+  return connection;
+}
+
+int connectLocalSocket(const std::string& socketPath)
+{
+  sockaddr_un address;
+  if(!setSocketAddress(socketPath, address))
+    return -1;
+
+  const int socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if(socket < 0)
+  {
+    ALICEVISION_LOG_ERROR("Cannot create the local socket: " << std::strerror(errno));
+    return -1;
+  }
+  if(::connect(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0)
+  {
+    ALICEVISION_LOG_ERROR("Cannot connect to the local socket '" << socketPath << "': " << std::strerror(errno));
+    ::close(socket);
+    return -1;
+  }
+  disableSigPipe(socket);
+  return socket;
+}
+
+void shutdownLocalSocket(int socket)
+{
+  ::shutdown(socket, SHUT_RD);
+}
+
+void closeLocalSocket(int socket)
+{
+  ::close(socket);
+}
+
+bool sendMessage(int socket, EServerMessage type, const std::string& payload)
+{
+  MessageHeader header;
+  header.type = static_cast<std::uint32_t>(type);
+  header.reserved = 0;
+  header.size = payload.size();
+  return sendAll(socket, reinterpret_cast<const char*>(&header), sizeof(header)) &&
+         sendAll(socket, payload.data(), payload.size());
+}
+
+bool receiveMessage(int socket, EServerMessage& type, std::string& payload)
+{
+  MessageHeader header;
+  if(!receiveAll(socket, reinterpret_cast<char*>(&header), sizeof(header)))
+    return false;
+  if(header.size > maxMessageSize)
+  {
+    ALICEVISION_LOG_ERROR("Invalid localization server message of " << header.size << " bytes.");
+    return false;
+  }
+  type = static_cast<EServerMessage>(header.type);
+  payload.resize(header.size);
+  return receiveAll(socket, &payload[0], payload.size());
+}
+
+#else
+
+int listenLocalSocket(const std::string& socketPath)
+{
+  ALICEVISION_LOG_ERROR("The local sockets are not supported on this platform.");
+  return -1;
+}
+
+int acceptLocalSocket(int socket, int timeoutMs) { return -1; }
+
+int connectLocalSocket(const std::string& socketPath)
+{
+  ALICEVISION_LOG_ERROR("The local sockets are not supported on this platform.");
+  return -1;
+}
+
+void shutdownLocalSocket(int socket) {}
+void closeLocalSocket(int socket) {}
+bool sendMessage(int socket, EServerMessage type, const std::string& payload) { return false; }
+bool receiveMessage(int socket, EServerMessage& type, std::string& payload) { return false; }
+
+#endif
+
+} // namespace localization
+} // namespace aliceVision
@@ -0,0 +1,98 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/localization/LocalizationServer.hpp>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace aliceVision {
+namespace localization {
+
+/**
+ * Messages exchanged by the localization server and its clients over a local (Unix) socket.
+ * A message is a header (type and payload size, native endianness) followed by the payload:
+ * the client and the server run on the same machine.
+ */
+enum class EServerMessage : std::uint32_t
+{
+  LOCALIZE = 1,          //< client -> server: a LocalizationRequest
+  LOCALIZE_RESULT = 2,   //< server -> client: a LocalizationResponse
+  STATISTICS = 3,        //< client -> server: request the statistics (empty payload)
+  STATISTICS_RESULT = 4  //< server -> client: the statistics as text
+};
+
+/**
+ * @brief Serialize a localization request.
+ * The image is sent as a 8-bit greyscale image, the regions with their raw features and descriptors.
+ * @param[out] stream the output stream
+ * @param[in] request the request to serialize
+ */
+void writeLocalizationRequest(std::ostream& stream, const LocalizationRequest& request);
+
+/**
+ * @brief Deserialize a localization request.
+ * The image and regions sizes are checked against the size of the message before any allocation.
+ * @param[in] stream the input stream (seekable, to get the size of the message)
+ * @param[out] request the request
+ * @throw std::runtime_error if the stream is invalid
+ */
+void readLocalizationRequest(std::istream& stream, LocalizationRequest& request);
+
+void writeLocalizationResponse(std::ostream& stream, const LocalizationResponse& response);
+
+/**
+ * @brief Deserialize a localization response.
+ * @throw std::runtime_error if the stream is invalid
+ */
+void readLocalizationResponse(std::istream& stream, LocalizationResponse& response);
+
+/**
+ * @brief Create a local socket bound to the given path and listening to the connections.
+ * An existing file at this path is removed.
+ * @return the socket, -1 on error
+ */
+int listenLocalSocket(const std::string& socketPath);
+
+/**
+ * @brief Wait for a connection on a listening socket.
+ * @param[in] socket the listening socket
+ * @param[in] timeoutMs the maximum time to wait
+ * @return the socket of the new connection, -1 on error or if the timeout is reached
+ */
+int acceptLocalSocket(int socket, int timeoutMs);
+
+/**
+ * @brief Connect to the local socket of a server.
+ * @return the socket, -1 on error
+ */
+int connectLocalSocket(const std::string& socketPath);
+
+/**
+ * @brief Stop the receptions of a socket, the blocking receptions return.
+ * The messages can still be sent.
+ */
+void shutdownLocalSocket(int socket);
+
+void closeLocalSocket(int socket);
+
+/**
+ * @brief Send a message (blocks until the whole message is sent).
+ * @return false if the connection is closed
+ */
+bool sendMessage(int socket, EServerMessage type, const std::string& payload);
+
+/**
+ * @brief Receive a message (blocks until a whole message is received).
+ * @return false if the connection is closed
+ */
+bool receiveMessage(int socket, EServerMessage& type, std::string& payload);
+
+} // namespace localization
+} // namespace aliceVision
@@ -52,24 +52,24 @@ void fillMatricesWithUndistortFeaturesMatches(const matching::IndMatches &putati
   const bool J_hasValidIntrinsics = cam_J && cam_J->isValid();
 
 
-  for (size_t i = 0; i < putativeMatches.size(); ++i)
-  {
-    const Vec2 pt_I = getFeaturePosition(feature_I, putativeMatches[i]._i);
-    if (I_hasValidIntrinsics)
-      x_I.col(i) = cam_I->get_ud_pixel(pt_I);
-    else
-      x_I.col(i) = pt_I;
-  }
+  Mat2X pts_I(2, putativeMatches.size());
+  Mat2X pts_J(2, putativeMatches.size());
 
   for (size_t i = 0; i < putativeMatches.size(); ++i)
   {
-    const Vec2 pt_J = getFeaturePosition(feature_J, putativeMatches[i]._j);
-    if (J_hasValidIntrinsics)
-      x_J.col(i) = cam_J->get_ud_pixel(pt_J);
-    else
-      x_J.col(i) = pt_J;
+    pts_I.col(i) = getFeaturePosition(feature_I, putativeMatches[i]._i);
+    pts_J.col(i) = getFeaturePosition(feature_J, putativeMatches[i]._j);
   }
 
+  // undistort all the positions at once
+  if (I_hasValidIntrinsics)
+    cam_I->get_ud_pixel(pts_I, pts_I);
+  if (J_hasValidIntrinsics)
+    cam_J->get_ud_pixel(pts_J, pts_J);
+
+  x_I = pts_I.cast<Scalar>();
+  x_J = pts_J.cast<Scalar>();
+
 }
 
 /**
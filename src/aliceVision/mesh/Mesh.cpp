@@ -1162,131 +1162,72 @@ Mesh* Mesh::generateMeshFromTrianglesSubset(const StaticVector<int>& visTris, St
 void Mesh::getNotOrientedEdges(StaticVector<StaticVector<int>*>** edgesNeighTris,
                                   StaticVector<Pixel>** edgesPointsPairs)
 {
-    // printf("getNotOrientedEdges\n");
-    StaticVector<Voxel>* edges = new StaticVector<Voxel>();
-    edges->reserve(tris->size() * 3);
+    const MeshTopology topology(*this);
 
-    for(int i = 0; i < tris->size(); i++)
-    {
-        int a = (*tris)[i].v[0];
-        int b = (*tris)[i].v[1];
-        int c = (*tris)[i].v[2];
-        edges->push_back(Voxel(std::min(a, b), std::max(a, b), i));
-        edges->push_back(Voxel(std::min(b, c), std::max(b, c), i));
-        edges->push_back(Voxel(std::min(c, a), std::max(c, a), i));
-    }
-
-    qsort(&(*edges)[0], edges->size(), sizeof(Voxel), qSortCompareVoxelByXAsc);
-
-    StaticVector<StaticVector<int>*>* _edgesNeighTris = new StaticVector<StaticVector<int>*>();
     StaticVector<Pixel>* _edgesPointsPairs = new StaticVector<Pixel>();
+    _edgesPointsPairs->getDataWritable() = topology.edgesPointsPairs;
 
-    _edgesNeighTris->reserve(tris->size() * 3);
-    _edgesPointsPairs->reserve(tris->size() * 3);
-    // remove duplicities
-    int i0 = 0;
-    long t1 = mvsUtils::initEstimate();
-    for(int i = 0; i < edges->size(); i++)
-    {
-        if((i == edges->size() - 1) || ((*edges)[i].x != (*edges)[i + 1].x))
-        {
-            StaticVector<Voxel>* edges1 = new StaticVector<Voxel>();
-            edges1->reserve(i - i0 + 1);
-            for(int j = i0; j <= i; j++)
-            {
-                edges1->push_back((*edges)[j]);
-            }
-            qsort(&(*edges1)[0], edges1->size(), sizeof(Voxel), qSortCompareVoxelByYAsc);
-
-            int j0 = 0;
-            for(int j = 0; j < edges1->size(); j++)
-            {
-                if((j == edges1->size() - 1) || ((*edges1)[j].y != (*edges1)[j + 1].y))
-                {
-                    _edgesPointsPairs->push_back(Pixel((*edges1)[j].x, (*edges1)[j].y));
-                    StaticVector<int>* neighTris = new StaticVector<int>();
-                    neighTris->reserve(j - j0 + 1);
-                    for(int k = j0; k <= j; k++)
-                    {
-                        neighTris->push_back((*edges1)[k].z);
-                    }
-                    _edgesNeighTris->push_back(neighTris);
-                    j0 = j + 1;
-                }
-            }
-
-            delete edges1;
-            i0 = i + 1;
-        }
-
-        mvsUtils::printfEstimate(i, edges->size(), t1);
-    }
-    mvsUtils::finishEstimate();
-
-    (*edgesNeighTris) = _edgesNeighTris;
+    (*edgesNeighTris) = topology.edgesNeighTris.toArrayOfArrays();
     (*edgesPointsPairs) = _edgesPointsPairs;
-
-    delete edges;
 }
 
 StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(StaticVector<StaticVector<int>*>* ptsNeighPts,
                                                              double maximalNeighDist)
+{
+    CSRAdjacency ptsNeighPtsCSR;
+    ptsNeighPtsCSR.fromArrayOfArrays(*ptsNeighPts);
+    return getLaplacianSmoothingVectors(ptsNeighPtsCSR, maximalNeighDist);
+}
+
+StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(const CSRAdjacency& ptsNeighPts, double maximalNeighDist)
 {
     StaticVector<Point3d>* nms = new StaticVector<Point3d>();
-    nms->reserve(pts->size());
+    nms->resize_with(pts->size(), Point3d(0.0, 0.0, 0.0));
 
+    #pragma omp parallel for
     for(int i = 0; i < pts->size(); i++)
     {
-        Point3d p = (*pts)[i];
-        StaticVector<int>* nei = (*ptsNeighPts)[i];
-        int nneighs = 0;
-        if(nei != nullptr)
+        const Point3d p = (*pts)[i];
+        const int nneighs = ptsNeighPts.size(i);
+
+        if(nneighs == 0)
+            continue;
+
+        double maxNeighDist = 0.0f;
+        // laplacian smoothing vector
+        Point3d n = Point3d(0.0, 0.0, 0.0);
+        for(const int* nei = ptsNeighPts.begin(i); nei != ptsNeighPts.end(i); ++nei)
         {
-            nneighs = nei->size();
+            n = n + (*pts)[*nei];
+            maxNeighDist = std::max(maxNeighDist, (p - (*pts)[*nei]).size());
         }
+        n = ((n / (float)nneighs) - p);
 
-        if(nneighs == 0)
+        float d = n.size();
+        n = n.normalize();
+
+        if(std::isnan(d) || std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z) || (d != d) || (n.x != n.x) ||
+           (n.y != n.y) || (n.z != n.z)) // check if is not NaN
         {
-            nms->push_back(Point3d(0.0, 0.0, 0.0));
+            n = Point3d(0.0, 0.0, 0.0);
         }
         else
         {
-            double maxNeighDist = 0.0f;
-            // laplacian smoothing vector
-            Point3d n = Point3d(0.0, 0.0, 0.0);
-            for(int j = 0; j < nneighs; j++)
-            {
-                n = n + (*pts)[(*nei)[j]];
-                maxNeighDist = std::max(maxNeighDist, (p - (*pts)[(*nei)[j]]).size());
-            }
-            n = ((n / (float)nneighs) - p);
-
-            float d = n.size();
-            n = n.normalize();
-
-            if(std::isnan(d) || std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z) || (d != d) || (n.x != n.x) ||
-               (n.y != n.y) || (n.z != n.z)) // check if is not NaN
-            {
-                n = Point3d(0.0, 0.0, 0.0);
-            }
-            else
-            {
-                n = n * d;
-            }
-
-            if(std::isnan(d) || std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z) || (d != d) || (n.x != n.x) ||
-               (n.y != n.y) || (n.z != n.z)) // check if is not NaN
-            {
-                n = Point3d(0.0, 0.0, 0.0);
-            }
+            n = n * d;
+        }
 
-            if((maximalNeighDist > 0.0f) && (maxNeighDist > maximalNeighDist))
-            {
-                n = Point3d(0.0, 0.0, 0.0);
-            }
+        if(std::isnan(d) || std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z) || (d != d) || (n.x != n.x) ||
+           (n.y != n.y) || (n.z != n.z)) // check if is not NaN
+        {
+            n = Point3d(0.0, 0.0, 0.0);
+        }
 
-            nms->push_back(n);
+        if((maximalNeighDist > 0.0f) && (maxNeighDist > maximalNeighDist))
+        {
+            n = Point3d(0.0, 0.0, 0.0);
         }
+
+        (*nms)[i] = n;
     }
 
     return nms;
@@ -1294,16 +1235,26 @@ StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(StaticVector<StaticVec
 
 void Mesh::laplacianSmoothPts(float maximalNeighDist)
 {
+    // use the ordered one-ring (and not MeshTopology::ptsNeighPts): it only keeps the neighbors reached
+    // by walking the triangle fan, which differs from the edge neighbors on boundary and non-manifold vertices
     StaticVector<StaticVector<int>*>* ptsNei = getPtsNeighPtsOrdered();
     laplacianSmoothPts(ptsNei, maximalNeighDist);
     deleteArrayOfArrays<int>(&ptsNei);
 }
 
 void Mesh::laplacianSmoothPts(StaticVector<StaticVector<int>*>* ptsNeighPts, double maximalNeighDist)
+{
+    CSRAdjacency ptsNeighPtsCSR;
+    ptsNeighPtsCSR.fromArrayOfArrays(*ptsNeighPts);
+    laplacianSmoothPts(ptsNeighPtsCSR, maximalNeighDist);
+}
+
+void Mesh::laplacianSmoothPts(const CSRAdjacency& ptsNeighPts, double maximalNeighDist)
 {
     StaticVector<Point3d>* nms = getLaplacianSmoothingVectors(ptsNeighPts, maximalNeighDist);
 
     // smooth
+    #pragma omp parallel for
     for(int i = 0; i < pts->size(); i++)
     {
         (*pts)[i] = (*pts)[i] + (*nms)[i];
@@ -1333,51 +1284,47 @@ double Mesh::computeTriangleMaxEdgeLength(int idTri) const
 
 StaticVector<Point3d>* Mesh::computeNormalsForPts()
 {
-    StaticVector<StaticVector<int>*>* ptsNeighTris = getPtsNeighborTriangles();
-    StaticVector<Point3d>* nms = computeNormalsForPts(ptsNeighTris);
-    deleteArrayOfArrays<int>(&ptsNeighTris);
-    return nms;
+    const MeshTopology topology(*this);
+    return computeNormalsForPts(topology.ptsNeighTris);
 }
 
 StaticVector<Point3d>* Mesh::computeNormalsForPts(StaticVector<StaticVector<int>*>* ptsNeighTris)
+{
+    CSRAdjacency ptsNeighTrisCSR;
+    ptsNeighTrisCSR.fromArrayOfArrays(*ptsNeighTris);
+    return computeNormalsForPts(ptsNeighTrisCSR);
+}
+
+StaticVector<Point3d>* Mesh::computeNormalsForPts(const CSRAdjacency& ptsNeighTris)
 {
     StaticVector<Point3d>* nms = new StaticVector<Point3d>();
-    nms->reserve(pts->size());
     nms->resize_with(pts->size(), Point3d(0.0f, 0.0f, 0.0f));
 
+    #pragma omp parallel for
     for(int i = 0; i < pts->size(); i++)
     {
-        StaticVector<int>* triTmp = (*ptsNeighTris)[i];
-        if((triTmp != nullptr) && (triTmp->size() > 0))
-        {
-            Point3d n = Point3d(0.0f, 0.0f, 0.0f);
-            float nn = 0.0f;
-            for(int j = 0; j < triTmp->size(); j++)
-            {
-                Point3d n1 = computeTriangleNormal((*triTmp)[j]);
-                n1 = n1.normalize();
-                if(std::isnan(n1.x) || std::isnan(n1.y) || std::isnan(n1.z) || (n1.x != n1.x) || (n1.y != n1.y) ||
-                   (n1.z != n1.z)) // check if is not NaN
-                {
-                    //
-                }
-                else
-                {
-                    n = n + computeTriangleNormal((*triTmp)[j]);
-                    nn += 1.0f;
-                }
-            }
-            n = n / nn;
+        if(ptsNeighTris.empty(i))
+            continue;
 
-            n = n.normalize();
-            if(std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z) || (n.x != n.x) || (n.y != n.y) ||
-               (n.z != n.z)) // check if is not NaN
-            {
-                n = Point3d(0.0f, 0.0f, 0.0f);
-            }
+        Point3d n = Point3d(0.0f, 0.0f, 0.0f);
+        float nn = 0.0f;
+        for(const int* triId = ptsNeighTris.begin(i); triId != ptsNeighTris.end(i); ++triId)
+        {
+            const Point3d n1 = computeTriangleNormal(*triId);
+            if(std::isnan(n1.x) || std::isnan(n1.y) || std::isnan(n1.z)) // check if is not NaN
+                continue;
+            n = n + n1;
+            nn += 1.0f;
+        }
+        n = n / nn;
 
-            (*nms)[i] = n;
+        n = n.normalize();
+        if(std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z)) // check if is not NaN
+        {
+            n = Point3d(0.0f, 0.0f, 0.0f);
         }
+
+        (*nms)[i] = n;
     }
 
     return nms;
@@ -2090,6 +2037,57 @@ StaticVector<StaticVector<int>*>* Mesh::computeTrisCamsFromPtsCams(StaticVector<
     return trisCams;
 }
 
+void Mesh::computeTrisCamsFromPtsCams(const StaticVector<StaticVector<int>*>& ptsCams, CSRAdjacency& out_trisCams) const
+{
+    const int nbTris = tris->size();
+
+    // gather the distinct cameras of the 3 vertices of a triangle (sorted ascending)
+    auto getTriCams = [&](int idTri, std::vector<int>& cams)
+    {
+        cams.clear();
+        for(int k = 0; k < 3; k++)
+        {
+            const StaticVector<int>* ptCams = ptsCams[(*tris)[idTri].v[k]];
+            if(ptCams != nullptr)
+                cams.insert(cams.end(), ptCams->begin(), ptCams->end());
+        }
+        std::sort(cams.begin(), cams.end());
+        cams.erase(std::unique(cams.begin(), cams.end()), cams.end());
+    };
+
+    std::vector<int> counts(nbTris, 0);
+
+    #pragma omp parallel
+    {
+        std::vector<int> cams;
+
+        #pragma omp for
+        for(int idTri = 0; idTri < nbTris; idTri++)
+        {
+            getTriCams(idTri, cams);
+            counts[idTri] = cams.size();
+        }
+    }
+
+    out_trisCams.offsets.resize(nbTris + 1);
+    out_trisCams.offsets[0] = 0;
+    for(int idTri = 0; idTri < nbTris; idTri++)
+        out_trisCams.offsets[idTri + 1] = out_trisCams.offsets[idTri] + counts[idTri];
+    out_trisCams.indices.resize(out_trisCams.offsets.back());
+
+    #pragma omp parallel
+    {
+        std::vector<int> cams;
+
+        #pragma omp for
+        for(int idTri = 0; idTri < nbTris; idTri++)
+        {
+            getTriCams(idTri, cams);
+            std::copy(cams.begin(), cams.end(), out_trisCams.indices.begin() + out_trisCams.offsets[idTri]);
+        }
+    }
+}
+
 void Mesh::initFromDepthMap(const mvsUtils::MultiViewParams* mp, StaticVector<float>* depthMap, int rc, int scale, float alpha)
 {
     initFromDepthMap(mp, &(*depthMap)[0], rc, scale, 1, alpha);
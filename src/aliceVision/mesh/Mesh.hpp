@@ -13,6 +13,7 @@
 #include <aliceVision/mvsData/StaticVector.hpp>
 #include <aliceVision/mvsData/Voxel.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
+#include <aliceVision/mesh/MeshTopology.hpp>
 
 namespace aliceVision {
 namespace mesh {
@@ -148,8 +149,11 @@ public:
                                                         double maximalNeighDist = -1.0f);
     void laplacianSmoothPts(float maximalNeighDist = -1.0f);
     void laplacianSmoothPts(StaticVector<StaticVector<int>*>* ptsNeighPts, double maximalNeighDist = -1.0f);
+    StaticVector<Point3d>* getLaplacianSmoothingVectors(const CSRAdjacency& ptsNeighPts, double maximalNeighDist = -1.0f);
+    void laplacianSmoothPts(const CSRAdjacency& ptsNeighPts, double maximalNeighDist = -1.0f);
     StaticVector<Point3d>* computeNormalsForPts();
     StaticVector<Point3d>* computeNormalsForPts(StaticVector<StaticVector<int>*>* ptsNeighTris);
+    StaticVector<Point3d>* computeNormalsForPts(const CSRAdjacency& ptsNeighTris);
     void smoothNormals(StaticVector<Point3d>* nms, StaticVector<StaticVector<int>*>* ptsNeighPts);
     Point3d computeTriangleNormal(int idTri);
     Point3d computeTriangleCenterOfGravity(int idTri) const;
@@ -196,6 +200,7 @@ public:
 
     StaticVector<StaticVector<int>*>* computeTrisCams(const mvsUtils::MultiViewParams* mp, std::string tmpDir);
     StaticVector<StaticVector<int>*>* computeTrisCamsFromPtsCams(StaticVector<StaticVector<int>*>* ptsCams) const;
+    void computeTrisCamsFromPtsCams(const StaticVector<StaticVector<int>*>& ptsCams, CSRAdjacency& out_trisCams) const;
 
     void initFromDepthMap(const mvsUtils::MultiViewParams* mp, float* depthMap, int rc, int scale, int step, float alpha);
     void initFromDepthMap(const mvsUtils::MultiViewParams* mp, StaticVector<float>* depthMap, int rc, int scale, float alpha);
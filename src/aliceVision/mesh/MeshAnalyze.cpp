@@ -151,18 +151,23 @@ void MeshAnalyze::getVertexPrincipalCurvatures(double Kh, double Kg, double& K1,
     K2 = Kh - temp;
 }
 
-bool MeshAnalyze::applyLaplacianOperator(int ptId, StaticVector<Point3d>* ptsToApplyLaplacianOp, Point3d& ln)
+namespace {
+
+/**
+ * @brief Laplacian operator of a point from the range of its neighbor point ids.
+ */
+bool laplacianOperator(int ptId, const StaticVector<Point3d>& ptsToApplyLaplacianOp, const int* neighBegin,
+                       const int* neighEnd, Point3d& ln)
 {
-    StaticVector<int>* ptNeighPtsOrdered = (*ptsNeighPtsOrdered)[ptId];
-    if(ptNeighPtsOrdered == nullptr)
+    if(neighBegin == neighEnd)
     {
         return false;
     }
 
     ln = Point3d(0.0f, 0.0f, 0.0f);
-    for(int i = 0; i < ptNeighPtsOrdered->size(); i++)
+    for(const int* nei = neighBegin; nei != neighEnd; ++nei)
     {
-        Point3d npt = (*ptsToApplyLaplacianOp)[(*ptNeighPtsOrdered)[i]];
+        const Point3d& npt = ptsToApplyLaplacianOp[*nei];
 
         if((npt.x == 0.0f) && (npt.y == 0.0f) && (npt.z == 0.0f))
         {
@@ -171,28 +176,78 @@ bool MeshAnalyze::applyLaplacianOperator(int ptId, StaticVector<Point3d>* ptsToA
         }
         ln = ln + npt;
     }
-    ln = (ln / (float)ptNeighPtsOrdered->size()) - (*ptsToApplyLaplacianOp)[ptId];
+    ln = (ln / (float)(neighEnd - neighBegin)) - ptsToApplyLaplacianOp[ptId];
 
     Point3d n = ln;
     float d = n.size();
     n = n.normalize();
-    if(std::isnan(d) || std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z) || (d != d) || (n.x != n.x) ||
-       (n.y != n.y) || (n.z != n.z)) // check if is not NaN
+    if(std::isnan(d) || std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z)) // check if is not NaN
     {
         ALICEVISION_LOG_WARNING("MeshAnalyze::applyLaplacianOperator: nan");
         return false;
     }
 
-    if(std::isnan(d) || std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z) || (d != d) || (n.x != n.x) ||
-       (n.y != n.y) || (n.z != n.z)) // check if is not NaN
+    return true;
+}
+
+/**
+ * @brief Bi-laplacian smoothing vector of a point from the range of its neighbor point ids.
+ * @param[in] getValence functor returning the number of neighbor points of a point id
+ */
+template <typename GetValence>
+bool biLaplacianSmoothingVector(int ptId, const StaticVector<Point3d>& ptsLaplacian, const int* neighBegin,
+                                const int* neighEnd, bool hasNeighTris, const GetValence& getValence, Point3d& tp)
+{
+    if(!laplacianOperator(ptId, ptsLaplacian, neighBegin, neighEnd, tp) || !hasNeighTris)
     {
-        ALICEVISION_LOG_WARNING("MeshAnalyze::applyLaplacianOperator: nan");
         return false;
     }
 
+    float sum = 0.0f;
+    for(const int* nei = neighBegin; nei != neighEnd; ++nei)
+    {
+        const int neighValence = getValence(*nei);
+        if(neighValence > 0)
+        {
+            sum += 1.0f / (float)neighValence;
+        }
+    }
+    float v = 1.0f + (1.0f / (float)(neighEnd - neighBegin)) * sum;
+
+    tp = Point3d(0.0f, 0.0f, 0.0f) - tp * (1.0f / v);
+
+    Point3d n = tp;
+    float d = n.size();
+    n = n.normalize();
+    if(std::isnan(d) || std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z)) // check if is not NaN
+    {
+        return false;
+    }
+    // page 6 eq (8)
+
     return true;
 }
 
+} // namespace
+
+bool MeshAnalyze::applyLaplacianOperator(int ptId, StaticVector<Point3d>* ptsToApplyLaplacianOp, Point3d& ln)
+{
+    const StaticVector<int>* ptNeighPtsOrdered = (*ptsNeighPtsOrdered)[ptId];
+    if(ptNeighPtsOrdered == nullptr)
+    {
+        return false;
+    }
+
+    const int* neighBegin = ptNeighPtsOrdered->getData().data();
+    return laplacianOperator(ptId, *ptsToApplyLaplacianOp, neighBegin, neighBegin + ptNeighPtsOrdered->size(), ln);
+}
+
+bool MeshAnalyze::applyLaplacianOperator(int ptId, const StaticVector<Point3d>& ptsToApplyLaplacianOp,
+                                         const CSRAdjacency& ptsNeighPts, Point3d& ln)
+{
+    return laplacianOperator(ptId, ptsToApplyLaplacianOp, ptsNeighPts.begin(ptId), ptsNeighPts.end(ptId), ln);
+}
+
 // othake et al 00 Polyhedral Surface Smoothing with Simultaneous Mesh Regularization
 // page 3 eq (3)
 bool MeshAnalyze::getLaplacianSmoothingVector(int ptId, Point3d& ln)
@@ -205,42 +260,25 @@ bool MeshAnalyze::getLaplacianSmoothingVector(int ptId, Point3d& ln)
 // pts
 bool MeshAnalyze::getBiLaplacianSmoothingVector(int ptId, StaticVector<Point3d>* ptsLaplacian, Point3d& tp)
 {
-    if(applyLaplacianOperator(ptId, ptsLaplacian, tp))
+    const StaticVector<int>* ptNeighPtsOrdered = (*ptsNeighPtsOrdered)[ptId];
+    if(ptNeighPtsOrdered == nullptr)
     {
-        StaticVector<int>* ptNeighPtsOrdered = (*ptsNeighPtsOrdered)[ptId];
-        StaticVector<int>* ptNeighTris = (*ptsNeighTrisSortedAsc)[ptId];
-        if((ptNeighPtsOrdered == nullptr) || (ptNeighTris == nullptr))
-        {
-            return false;
-        }
-
-        float sum = 0.0f;
-        for(int i = 0; i < sizeOfStaticVector<int>(ptNeighPtsOrdered); i++)
-        {
-            int neighValence = sizeOfStaticVector<int>((*ptsNeighPtsOrdered)[(*ptNeighPtsOrdered)[i]]);
-            if(neighValence > 0)
-            {
-                sum += 1.0f / (float)neighValence;
-            }
-        }
-        float v = 1.0f + (1.0f / (float)sizeOfStaticVector<int>(ptNeighPtsOrdered)) * sum;
-
-        tp = Point3d(0.0f, 0.0f, 0.0f) - tp * (1.0f / v);
-
-        Point3d n = tp;
-        float d = n.size();
-        n = n.normalize();
-        if(std::isnan(d) || std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z) || (d != d) || (n.x != n.x) ||
-           (n.y != n.y) || (n.z != n.z)) // check if is not NaN
-        {
-            return false;
-        }
-        // page 6 eq (8)
-
-        return true;
+        return false;
     }
 
-    return false;
+    const int* neighBegin = ptNeighPtsOrdered->getData().data();
+    const auto getValence = [this](int id) { return sizeOfStaticVector<int>((*ptsNeighPtsOrdered)[id]); };
+    return biLaplacianSmoothingVector(ptId, *ptsLaplacian, neighBegin, neighBegin + ptNeighPtsOrdered->size(),
+                                      (*ptsNeighTrisSortedAsc)[ptId] != nullptr, getValence, tp);
+}
+
+bool MeshAnalyze::getBiLaplacianSmoothingVector(int ptId, const StaticVector<Point3d>& ptsLaplacian,
+                                                const CSRAdjacency& ptsNeighPts, const CSRAdjacency& ptsNeighTris,
+                                                Point3d& tp)
+{
+    const auto getValence = [&ptsNeighPts](int id) { return ptsNeighPts.size(id); };
+    return biLaplacianSmoothingVector(ptId, ptsLaplacian, ptsNeighPts.begin(ptId), ptsNeighPts.end(ptId),
+                                      !ptsNeighTris.empty(ptId), getValence, tp);
 }
 
 // othake et al 00 Polyhedral Surface Smoothing with Simultaneous Mesh Regularization
@@ -10,6 +10,7 @@
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsData/StaticVector.hpp>
 #include <aliceVision/mesh/MeshClean.hpp>
+#include <aliceVision/mesh/MeshTopology.hpp>
 
 namespace aliceVision {
 namespace mesh {
@@ -28,6 +29,11 @@ public:
     bool applyLaplacianOperator(int ptId, StaticVector<Point3d>* ptsToApplyLaplacianOp, Point3d& ln);
     bool getLaplacianSmoothingVector(int ptId, Point3d& ln);
     bool getBiLaplacianSmoothingVector(int ptId, StaticVector<Point3d>* ptsLaplacian, Point3d& tp);
+    static bool applyLaplacianOperator(int ptId, const StaticVector<Point3d>& ptsToApplyLaplacianOp,
+                                       const CSRAdjacency& ptsNeighPts, Point3d& ln);
+    static bool getBiLaplacianSmoothingVector(int ptId, const StaticVector<Point3d>& ptsLaplacian,
+                                              const CSRAdjacency& ptsNeighPts, const CSRAdjacency& ptsNeighTris,
+                                              Point3d& tp);
     bool getMeanCurvAndLaplacianSmoothing(int ptId, Point3d& F, float epsilon);
     bool getVertexSurfaceNormal(int ptId, Point3d& N);
 };
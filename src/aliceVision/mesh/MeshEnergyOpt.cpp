@@ -23,21 +23,19 @@ MeshEnergyOpt::MeshEnergyOpt(mvsUtils::MultiViewParams* _mp)
 
 MeshEnergyOpt::~MeshEnergyOpt() = default;
 
-StaticVector<Point3d>* MeshEnergyOpt::computeLaplacianPtsParallel()
+StaticVector<Point3d>* MeshEnergyOpt::computeLaplacianPtsParallel(const CSRAdjacency& ptsNeighPts)
 {
     StaticVector<Point3d>* lapPts = new StaticVector<Point3d>();
     lapPts->reserve(pts->size());
     lapPts->resize_with(pts->size(), Point3d(0.0f, 0.0f, 0.f));
-    int nlabpts = 0;
 
 #pragma omp parallel for
     for(int i = 0; i < pts->size(); i++)
     {
         Point3d lapPt;
-        if(getLaplacianSmoothingVector(i, lapPt))
+        if(applyLaplacianOperator(i, *pts, ptsNeighPts, lapPt))
         {
             (*lapPts)[i] = lapPt;
-            nlabpts++;
         }
     }
 
@@ -45,10 +43,10 @@ StaticVector<Point3d>* MeshEnergyOpt::computeLaplacianPtsParallel()
 }
 
 void MeshEnergyOpt::updateGradientParallel(float lambda, const Point3d& LU,
-                                                const Point3d& RD, StaticVectorBool* ptsCanMove)
+                                                const Point3d& RD, StaticVectorBool* ptsCanMove,
+                                                const CSRAdjacency& ptsNeighPts, const CSRAdjacency& ptsNeighTris)
 {
-    // printf("nlabpts %i of %i\n",nlabpts,pts->size());
-    StaticVector<Point3d>* lapPts = computeLaplacianPtsParallel();
+    StaticVector<Point3d>* lapPts = computeLaplacianPtsParallel(ptsNeighPts);
 
     StaticVector<Point3d>* newPts = new StaticVector<Point3d>();
     newPts->reserve(pts->size());
@@ -61,7 +59,7 @@ void MeshEnergyOpt::updateGradientParallel(float lambda, const Point3d& LU,
         {
             Point3d n;
 
-            if(getBiLaplacianSmoothingVector(i, lapPts, n))
+            if(getBiLaplacianSmoothingVector(i, *lapPts, ptsNeighPts, ptsNeighTris, n))
             {
                 Point3d p = (*newPts)[i] + n * lambda;
                 if((p.x > LU.x) && (p.y > LU.y) && (p.z > LU.z) && (p.x < RD.x) && (p.y < RD.y) && (p.z < RD.z))
@@ -103,10 +101,17 @@ bool MeshEnergyOpt::optimizeSmooth(float lambda, int niter, StaticVectorBool* pt
                          << "\t- lamda: " << lambda << std::endl
                          << "\t- niters: " << niter << std::endl);
 
+    // the connectivity does not change during the smoothing:
+    // flatten the neighborhoods once into contiguous CSR arrays
+    CSRAdjacency ptsNeighPts;
+    CSRAdjacency ptsNeighTris;
+    ptsNeighPts.fromArrayOfArrays(*ptsNeighPtsOrdered);
+    ptsNeighTris.fromArrayOfArrays(*ptsNeighTrisSortedAsc);
+
     for(int i = 0; i < niter; i++)
     {
         ALICEVISION_LOG_INFO("Optimizing mesh smooth: iteration " << i);
-        updateGradientParallel(lambda, LU, RD, ptsCanMove);
+        updateGradientParallel(lambda, LU, RD, ptsCanMove, ptsNeighPts, ptsNeighTris);
         if(saveDebug)
             saveToObj(mp->mvDir + "mesh_smoothed_" + std::to_string(i) + ".obj");
     }
@@ -9,6 +9,7 @@
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsData/StaticVector.hpp>
 #include <aliceVision/mesh/MeshAnalyze.hpp>
+#include <aliceVision/mesh/MeshTopology.hpp>
 
 namespace aliceVision {
 namespace mesh {
@@ -22,8 +23,9 @@ public:
     bool optimizeSmooth(float lambda, int niter, StaticVectorBool* ptsCanMove);
 
 private:
-    StaticVector<Point3d>* computeLaplacianPtsParallel();
-    void updateGradientParallel(float lambda, const Point3d& LU, const Point3d& RD, StaticVectorBool* ptsCanMove);
+    StaticVector<Point3d>* computeLaplacianPtsParallel(const CSRAdjacency& ptsNeighPts);
+    void updateGradientParallel(float lambda, const Point3d& LU, const Point3d& RD, StaticVectorBool* ptsCanMove,
+                                const CSRAdjacency& ptsNeighPts, const CSRAdjacency& ptsNeighTris);
 };
 
 } // namespace mesh
@@ -0,0 +1,296 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MeshTopology.hpp"
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace aliceVision {
+namespace mesh {
+
+namespace {
+
+/**
+ * @brief Convert a count per element into CSR offsets (exclusive prefix sum).
+ */
+void countsToOffsets(const std::vector<int>& counts, std::vector<int>& out_offsets)
+{
+    out_offsets.resize(counts.size() + 1);
+    out_offsets[0] = 0;
+    for(std::size_t i = 0; i < counts.size(); ++i)
+        out_offsets[i + 1] = out_offsets[i] + counts[i];
+}
+
+/**
+ * @brief Sort the indices of each element of a CSR structure.
+ */
+void sortCSRElements(CSRAdjacency& adjacency)
+{
+    const int nbElements = adjacency.nbElements();
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(int i = 0; i < nbElements; ++i)
+    {
+        std::sort(adjacency.indices.begin() + adjacency.offsets[i], adjacency.indices.begin() + adjacency.offsets[i + 1]);
+    }
+}
+
+} // namespace
+
+void CSRAdjacency::fromArrayOfArrays(const StaticVector<StaticVector<int>*>& arrays)
+{
+    const int nbElements = arrays.size();
+    offsets.resize(nbElements + 1);
+    offsets[0] = 0;
+    for(int i = 0; i < nbElements; ++i)
+        offsets[i + 1] = offsets[i] + ((arrays[i] == nullptr) ? 0 : arrays[i]->size());
+
+    indices.resize(offsets.back());
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbElements; ++i)
+    {
+        if(arrays[i] != nullptr)
+            std::copy(arrays[i]->begin(), arrays[i]->end(), indices.begin() + offsets[i]);
+    }
+}
+
+StaticVector<StaticVector<int>*>* CSRAdjacency::toArrayOfArrays() const
+{
+    const int nbElements = this->nbElements();
+    StaticVector<StaticVector<int>*>* arrays = new StaticVector<StaticVector<int>*>();
+    arrays->resize_with(nbElements, nullptr);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbElements; ++i)
+    {
+        if(empty(i))
+            continue;
+        StaticVector<int>* array = new StaticVector<int>();
+        array->getDataWritable().assign(begin(i), end(i));
+        (*arrays)[i] = array;
+    }
+    return arrays;
+}
+
+void radixSortKeyValues(std::vector<std::uint64_t>& keys, std::vector<int>& values, std::uint64_t maxKey)
+{
+    assert(keys.size() == values.size());
+
+    const std::size_t n = keys.size();
+    if(n < 2)
+        return;
+
+    // 11 bits per pass keeps the per-thread histograms small (2048 buckets)
+    const int radixBits = 11;
+    const std::size_t radixSize = std::size_t(1) << radixBits;
+    const std::uint64_t radixMask = radixSize - 1;
+
+    int nbPasses = 0;
+    for(std::uint64_t k = maxKey; k != 0; k >>= radixBits)
+        ++nbPasses;
+
+    std::vector<std::uint64_t> keysTmp(n);
+    std::vector<int> valuesTmp(n);
+    std::vector<std::size_t> histograms(omp_get_max_threads() * radixSize);
+
+    for(int pass = 0; pass < nbPasses; ++pass)
+    {
+        const int shift = pass * radixBits;
+        std::fill(histograms.begin(), histograms.end(), 0);
+
+        #pragma omp parallel
+        {
+            const std::size_t nbThreads = omp_get_num_threads();
+            const std::size_t threadId = omp_get_thread_num();
+            const std::size_t chunkBegin = n * threadId / nbThreads;
+            const std::size_t chunkEnd = n * (threadId + 1) / nbThreads;
+            std::size_t* histogram = &histograms[threadId * radixSize];
+
+            for(std::size_t i = chunkBegin; i < chunkEnd; ++i)
+                ++histogram[(keys[i] >> shift) & radixMask];
+
+            #pragma omp barrier
+            #pragma omp single
+            {
+                // digit-major then thread-major prefix sum keeps the sort stable
+                std::size_t offset = 0;
+                for(std::size_t d = 0; d < radixSize; ++d)
+                {
+                    for(std::size_t t = 0; t < nbThreads; ++t)
+                    {
+                        const std::size_t count = histograms[t * radixSize + d];
+                        histograms[t * radixSize + d] = offset;
+                        offset += count;
+                    }
+                }
+            }
+
+            for(std::size_t i = chunkBegin; i < chunkEnd; ++i)
+            {
+                const std::size_t pos = histogram[(keys[i] >> shift) & radixMask]++;
+                keysTmp[pos] = keys[i];
+                valuesTmp[pos] = values[i];
+            }
+        }
+
+        keys.swap(keysTmp);
+        values.swap(valuesTmp);
+    }
+}
+
+void MeshTopology::build(const Mesh& mesh)
+{
+    buildPtsNeighTris(mesh);
+    buildEdges(mesh);
+    buildPtsNeighPts(mesh);
+}
+
+void MeshTopology::buildPtsNeighTris(const Mesh& mesh)
+{
+    const int nbPts = mesh.pts->size();
+    const int nbTris = mesh.tris->size();
+
+    std::vector<int> counts(nbPts, 0);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbTris; ++i)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            const int ptId = (*mesh.tris)[i].v[k];
+            #pragma omp atomic
+            ++counts[ptId];
+        }
+    }
+
+    countsToOffsets(counts, ptsNeighTris.offsets);
+    ptsNeighTris.indices.resize(ptsNeighTris.offsets.back());
+
+    std::vector<int> cursors(ptsNeighTris.offsets.begin(), ptsNeighTris.offsets.end() - 1);
+
+#ifdef ALICEVISION_OMP_HAVE_ATOMIC_CAPTURE
+    #pragma omp parallel for
+#endif
+    for(int i = 0; i < nbTris; ++i)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            const int ptId = (*mesh.tris)[i].v[k];
+            int pos;
+#ifdef ALICEVISION_OMP_HAVE_ATOMIC_CAPTURE
+            #pragma omp atomic capture
+#endif
+            pos = cursors[ptId]++;
+            ptsNeighTris.indices[pos] = i;
+        }
+    }
+
+    sortCSRElements(ptsNeighTris);
+}
+
+void MeshTopology::buildEdges(const Mesh& mesh)
+{
+    const std::uint64_t nbPts = mesh.pts->size();
+    const int nbTris = mesh.tris->size();
+
+    // one key per triangle edge: minPtId * nbPts + maxPtId
+    std::vector<std::uint64_t> keys(3 * static_cast<std::size_t>(nbTris));
+    std::vector<int> trisIds(keys.size());
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbTris; ++i)
+    {
+        const Mesh::triangle& t = (*mesh.tris)[i];
+        for(int k = 0; k < 3; ++k)
+        {
+            const std::uint64_t a = t.v[k];
+            const std::uint64_t b = t.v[(k + 1) % 3];
+            keys[3 * std::size_t(i) + k] = std::min(a, b) * nbPts + std::max(a, b);
+            trisIds[3 * std::size_t(i) + k] = i;
+        }
+    }
+
+    // stable sort: triangles of each edge stay sorted ascending
+    radixSortKeyValues(keys, trisIds, (nbPts == 0) ? 0 : nbPts * nbPts - 1);
+
+    edgesPointsPairs.clear();
+    edgesNeighTris.offsets.clear();
+    edgesNeighTris.offsets.reserve(keys.size() / 2 + 1);
+    edgesPointsPairs.reserve(keys.size() / 2);
+
+    for(std::size_t j = 0; j < keys.size(); ++j)
+    {
+        if((j == 0) || (keys[j] != keys[j - 1]))
+        {
+            edgesNeighTris.offsets.push_back(static_cast<int>(j));
+            edgesPointsPairs.emplace_back(static_cast<int>(keys[j] / nbPts), static_cast<int>(keys[j] % nbPts));
+        }
+    }
+    edgesNeighTris.offsets.push_back(static_cast<int>(keys.size()));
+    edgesNeighTris.indices.swap(trisIds);
+}
+
+void MeshTopology::buildPtsNeighPts(const Mesh& mesh)
+{
+    const int nbPts = mesh.pts->size();
+    const int nbEdges = edgesPointsPairs.size();
+
+    // skip degenerated edges, as done in Mesh::getPtsNeighPtsOrdered
+    std::vector<char> validEdges(nbEdges, 0);
+    std::vector<int> counts(nbPts, 0);
+
+    #pragma omp parallel for
+    for(int e = 0; e < nbEdges; ++e)
+    {
+        const Pixel& edge = edgesPointsPairs[e];
+        const double length = ((*mesh.pts)[edge.x] - (*mesh.pts)[edge.y]).size();
+        if((edge.x == edge.y) || (length <= 0.0) || std::isnan(length))
+            continue;
+
+        validEdges[e] = 1;
+        #pragma omp atomic
+        ++counts[edge.x];
+        #pragma omp atomic
+        ++counts[edge.y];
+    }
+
+    countsToOffsets(counts, ptsNeighPts.offsets);
+    ptsNeighPts.indices.resize(ptsNeighPts.offsets.back());
+
+    std::vector<int> cursors(ptsNeighPts.offsets.begin(), ptsNeighPts.offsets.end() - 1);
+
+#ifdef ALICEVISION_OMP_HAVE_ATOMIC_CAPTURE
+    #pragma omp parallel for
+#endif
+    for(int e = 0; e < nbEdges; ++e)
+    {
+        if(!validEdges[e])
+            continue;
+
+        const Pixel& edge = edgesPointsPairs[e];
+        int pos;
+#ifdef ALICEVISION_OMP_HAVE_ATOMIC_CAPTURE
+        #pragma omp atomic capture
+#endif
+        pos = cursors[edge.x]++;
+        ptsNeighPts.indices[pos] = edge.y;
+#ifdef ALICEVISION_OMP_HAVE_ATOMIC_CAPTURE
+        #pragma omp atomic capture
+#endif
+        pos = cursors[edge.y]++;
+        ptsNeighPts.indices[pos] = edge.x;
+    }
+
+    sortCSRElements(ptsNeighPts);
+}
+
+} // namespace mesh
+} // namespace aliceVision
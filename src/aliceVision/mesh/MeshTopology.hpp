@@ -0,0 +1,102 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Pixel.hpp>
+#include <aliceVision/mvsData/StaticVector.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+
+class Mesh;
+
+/**
+ * @brief Compressed Sparse Row (CSR) adjacency.
+ * The neighbors of the element i are stored contiguously in
+ * indices[offsets[i]] ... indices[offsets[i+1] - 1].
+ * It replaces the StaticVector<StaticVector<int>*>* arrays of arrays,
+ * which need one heap allocation per element.
+ */
+struct CSRAdjacency
+{
+    std::vector<int> offsets; ///< size: nbElements + 1
+    std::vector<int> indices; ///< size: offsets.back()
+
+    int nbElements() const { return offsets.empty() ? 0 : static_cast<int>(offsets.size()) - 1; }
+    int size(int i) const { return offsets[i + 1] - offsets[i]; }
+    bool empty(int i) const { return offsets[i + 1] == offsets[i]; }
+    const int* begin(int i) const { return indices.data() + offsets[i]; }
+    const int* end(int i) const { return indices.data() + offsets[i + 1]; }
+    int operator()(int i, int j) const { return indices[offsets[i] + j]; }
+
+    void clear()
+    {
+        offsets.clear();
+        indices.clear();
+    }
+
+    /**
+     * @brief Fill the CSR structure from a legacy array of arrays (nullptr entries are considered empty).
+     */
+    void fromArrayOfArrays(const StaticVector<StaticVector<int>*>& arrays);
+
+    /**
+     * @brief Convert to a legacy array of arrays (empty entries are set to nullptr).
+     * @note The caller takes ownership of the result (see deleteArrayOfArrays).
+     */
+    StaticVector<StaticVector<int>*>* toArrayOfArrays() const;
+};
+
+/**
+ * @brief Sort 64-bit keys with their associated values using a parallel LSD radix sort.
+ * The sort is stable, so values sharing the same key keep their relative order.
+ * @param[in,out] keys the keys to sort
+ * @param[in,out] values the values to reorder with the keys (same size as keys)
+ * @param[in] maxKey the maximal key value (used to skip the useless passes)
+ */
+void radixSortKeyValues(std::vector<std::uint64_t>& keys, std::vector<int>& values, std::uint64_t maxKey);
+
+/**
+ * @brief Mesh topology (vertex / triangle / edge adjacency) stored in CSR form.
+ * Built once in parallel from the mesh triangles. The mesh connectivity must not
+ * be modified while the topology is in use.
+ */
+class MeshTopology
+{
+public:
+    MeshTopology() = default;
+    explicit MeshTopology(const Mesh& mesh) { build(mesh); }
+
+    /**
+     * @brief Build all the adjacency structures from the mesh triangles.
+     */
+    void build(const Mesh& mesh);
+
+    /**
+     * @brief Build only the edges structures (edgesPointsPairs and edgesNeighTris).
+     */
+    void buildEdges(const Mesh& mesh);
+
+    /// neighbor triangles of each vertex (sorted ascending)
+    CSRAdjacency ptsNeighTris;
+    /// neighbor vertices of each vertex (sorted ascending, degenerated edges excluded)
+    CSRAdjacency ptsNeighPts;
+    /// unique not-oriented edges as (min vertex id, max vertex id), sorted lexicographically
+    std::vector<Pixel> edgesPointsPairs;
+    /// neighbor triangles of each edge (sorted ascending)
+    CSRAdjacency edgesNeighTris;
+
+private:
+    void buildPtsNeighTris(const Mesh& mesh);
+    void buildPtsNeighPts(const Mesh& mesh);
+};
+
+} // namespace mesh
+} // namespace aliceVision
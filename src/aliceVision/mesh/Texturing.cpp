@@ -7,6 +7,7 @@
 #include "Texturing.hpp"
 #include "geoMesh.hpp"
 #include "UVAtlas.hpp"
+#include "textureRasterization.hpp"
 
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/numeric/numeric.hpp>
@@ -85,41 +86,6 @@ EVisibilityRemappingMethod EVisibilityRemappingMethod_stringToEnum(const std::st
 }
 
 
-/**
- * @brief Return whether a pixel is contained in or intersected by a 2D triangle.
- * @param[in] triangle the triangle as an array of 3 point2Ds
- * @param[in] pixel the pixel to test
- * @param[out] barycentricCoords the barycentric
- *  coordinates of this pixel relative to \p triangle
- * @return
- */
-bool isPixelInTriangle(const Point2d* triangle, const Pixel& pixel, Point2d& barycentricCoords)
-{
-    // get pixel center
-    GEO::vec2 p(pixel.x + 0.5, pixel.y + 0.5);
-    GEO::vec2 V0(triangle[0].x, triangle[0].y);
-    GEO::vec2 V1(triangle[1].x, triangle[1].y);
-    GEO::vec2 V2(triangle[2].x, triangle[2].y);
-    GEO::vec2 closestPoint;
-    double l1, l2, l3;
-    double dist = GEO::Geom::point_triangle_squared_distance<GEO::vec2>(p, V0, V1, V2, closestPoint, l1, l2, l3);
-    // fill barycentric coordinates as expected by other internal methods
-    barycentricCoords.x = l3;
-    barycentricCoords.y = l2;
-    // tolerance threshold of 1/2 pixel for pixels on the edges of the triangle
-    return dist < 0.5 + std::numeric_limits<double>::epsilon();
-}
-
-Point2d barycentricToCartesian(const Point2d* triangle, const Point2d& coords)
-{
-    return triangle[0] + (triangle[2] - triangle[0]) * coords.x + (triangle[1] - triangle[0]) * coords.y;
-}
-
-Point3d barycentricToCartesian(const Point3d* triangle, const Point2d& coords)
-{
-    return triangle[0] + (triangle[2] - triangle[0]) * coords.x + (triangle[1] - triangle[0]) * coords.y;
-}
-
 void Texturing::generateUVs(mvsUtils::MultiViewParams& mp)
 {
     if(!me)
@@ -152,8 +118,8 @@ void Texturing::generateUVs(mvsUtils::MultiViewParams& mp)
         {
             std::map<int, int> uvCache;
 
-            Pixel offset = chart.targetLU;
-            offset = offset - chart.sourceLU;
+            const Point2d sourceLU(chart.sourceLU.x, chart.sourceLU.y);
+            const Point2d targetLU(chart.targetLU.x, chart.targetLU.y);
 
             // for each triangle in this chart
             for(size_t i = 0 ; i<chart.triangleIDs.size(); ++i)
@@ -178,7 +144,7 @@ void Texturing::generateUVs(mvsUtils::MultiViewParams& mp)
                         if(mp.isPixelInImage(pix, chart.refCameraID))
                         {
                             // compute the final pixel coordinates
-                            uvPix = (pix + Point2d(offset.x, offset.y)) / (float)mua.textureSide();
+                            uvPix = ((pix - sourceLU) * chart.scale + targetLU) / (float)mua.textureSide();
                             uvPix.y = 1.0 - uvPix.y;
                             if(uvPix.x >= mua.textureSide() || uvPix.y >= mua.textureSide())
                                 uvPix = Point2d();
@@ -404,76 +370,48 @@ void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
     {
         ALICEVISION_LOG_INFO(" - camera " << camId + 1 << "/" << mp.ncams << " (" << triangles.size() << " triangles)");
 
-        imageCache.refreshData(camId);
-        #pragma omp parallel for
-        for(int ti = 0; ti < triangles.size(); ++ti)
+        RasterizationSource source;
+        source.image = imageCache.getImageData(camId);
+        source.width = mp.getWidth(camId);
+        source.height = mp.getHeight(camId);
+        source.border = mp.g_border;
+        source.P = mp.camArr[camId];
+
+        #pragma omp parallel
         {
-            const unsigned int triangleId = triangles[ti];
-            // retrieve triangle 3D and UV coordinates
-            Point2d triPixs[3];
-            Point3d triPts[3];
+            std::vector<TexelColor> texels;
 
-            for(int k = 0; k < 3; k++)
+            #pragma omp for
+            for(int ti = 0; ti < triangles.size(); ++ti)
             {
-                const int pointIndex = (*me->tris)[triangleId].v[k];
-                triPts[k] = (*me->pts)[pointIndex];                               // 3D coordinates
-                const int uvPointIndex = trisUvIds[triangleId].m[k];
-                triPixs[k] = uvCoords[uvPointIndex] * texParams.textureSide;   // UV coordinates
-            }
+                const unsigned int triangleId = triangles[ti];
+                // retrieve triangle 3D and UV coordinates
+                Point2d triPixs[3];
+                Point3d triPts[3];
 
-            // compute triangle bounding box in pixel indexes
-            // min values: floor(value)
-            // max values: ceil(value)
-            Pixel LU, RD;
-            LU.x = static_cast<int>(std::floor(std::min(std::min(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
-            LU.y = static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
-            RD.x = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
-            RD.y = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
-
-            // sanity check: clamp values to [0; textureSide]
-            int texSide = static_cast<int>(texParams.textureSide);
-            LU.x = clamp(LU.x, 0, texSide);
-            LU.y = clamp(LU.y, 0, texSide);
-            RD.x = clamp(RD.x, 0, texSide);
-            RD.y = clamp(RD.y, 0, texSide);
-
-            // iterate over bounding box's pixels
-            for(int y = LU.y; y < RD.y; y++)
-            {
-                for(int x = LU.x; x < RD.x; x++)
+                for(int k = 0; k < 3; k++)
                 {
-                    Pixel pix(x, y); // top-left corner of the pixel
-                    Point2d barycCoords;
+                    const int pointIndex = (*me->tris)[triangleId].v[k];
+                    triPts[k] = (*me->pts)[pointIndex];                               // 3D coordinates
+                    const int uvPointIndex = trisUvIds[triangleId].m[k];
+                    triPixs[k] = uvCoords[uvPointIndex] * texParams.textureSide;   // UV coordinates
+                }
 
-                    // test if the pixel is inside triangle
-                    // and retrieve its barycentric coordinates
-                    if(!isPixelInTriangle(triPixs, pix, barycCoords))
-                    {
-                        continue;
-                    }
+                // get the colors of the triangle texels in the source image
+                texels.clear();
+                rasterizeTriangle(triPixs, triPts, texParams.textureSide, source, texels);
 
-                    // remap 'y' to image coordinates system (inverted Y axis)
-                    const unsigned int y_ = (texParams.textureSide - 1) - y;
-                    // 1D pixel index
-                    unsigned int xyoffset = y_ * texParams.textureSide + x;
-                    // get 3D coordinates
-                    Point3d pt3d = barycentricToCartesian(triPts, barycCoords);
-                    // get 2D coordinates in source image
-                    Point2d pixRC;
-                    mp.getPixelFor3DPoint(&pixRC, pt3d, camId);
-                    // exclude out of bounds pixels
-                    if(!mp.isPixelInImage(pixRC, camId))
-                        continue;
-                    Color color = imageCache.getPixelValueInterpolated(&pixRC, camId);
+                for(TexelColor& texel : texels)
+                {
                     // If the color is pure zero, we consider it as an invalid pixel.
                     // After correction of radial distortion, some pixels are invalid.
                     // TODO: use an alpha channel instead.
-                    if(color == Color(0.f, 0.f, 0.f))
+                    if(texel.color == Color(0.f, 0.f, 0.f))
                         continue;
                     // fill the accumulated color map for this pixel
-                    perPixelColors[xyoffset] += color;
+                    perPixelColors[texel.offset] += texel.color;
                     // fill the colorID map
-                    colorIDs[xyoffset] = xyoffset;
+                    colorIDs[texel.offset] = texel.offset;
                 }
             }
         }
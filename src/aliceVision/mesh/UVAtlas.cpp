@@ -6,8 +6,14 @@
 
 #include "UVAtlas.hpp"
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/mesh/MeshTopology.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <iostream>
+#include <numeric>
 
 namespace aliceVision {
 namespace mesh {
@@ -40,22 +46,22 @@ void UVAtlas::createCharts(vector<Chart>& charts, mvsUtils::MultiViewParams& mp,
     ALICEVISION_LOG_INFO("Creating texture charts.");
 
     // compute per cam triangle visibility
-    StaticVector<StaticVector<int>*>* trisCams = _mesh.computeTrisCamsFromPtsCams(ptsCams);
+    CSRAdjacency trisCams;
+    _mesh.computeTrisCamsFromPtsCams(*ptsCams, trisCams);
 
     // create one chart per triangle
     _triangleCameraIDs.resize(_mesh.tris->size());
     charts.resize(_mesh.tris->size());
     #pragma omp parallel for
-    for(int i = 0; i < trisCams->size(); ++i)
+    for(int i = 0; i < trisCams.nbElements(); ++i)
     {
         Chart& chart = charts[i];
         std::vector<int>& tCamIds = _triangleCameraIDs[i];
 
         // project triangle in all cams
-        auto cameras = (*trisCams)[i];
-        for(int c = 0; c < cameras->size(); ++c)
+        for(const int* camIt = trisCams.begin(i); camIt != trisCams.end(i); ++camIt)
         {
-            int cameraID = (*cameras)[c];
+            int cameraID = *camIt;
             // project triangle
             Mesh::triangle_proj tp = _mesh.getTriangleProjection(i, &mp, cameraID, mp.getWidth(cameraID), mp.getHeight(cameraID));
             if(!mp.isPixelInImage(Pixel(tp.tp2ds[0]), 10, cameraID)
@@ -71,73 +77,53 @@ void UVAtlas::createCharts(vector<Chart>& charts, mvsUtils::MultiViewParams& mp,
         // store triangle ID
         chart.triangleIDs.emplace_back(i);
     }
-    deleteArrayOfArrays<int>(&trisCams);
 }
 
 void UVAtlas::packCharts(vector<Chart>& charts, mvsUtils::MultiViewParams& mp)
 {
     ALICEVISION_LOG_INFO("Packing texture charts (" <<  charts.size() << " charts).");
 
-    function<int(int)> findChart = [&](int cid)
-    {
-        Chart& c = charts[cid];
-        if(c.mergedWith >= 0)
-        {
-            int r = findChart(c.mergedWith);
-            c.mergedWith = r;
-            return r;
-        }
-        return cid;
-    };
+    mergeCharts(_mesh, charts);
+}
 
-    // list mesh edges (with duplicates)
-    vector<Edge> alledges;
-    for(int i = 0; i < _mesh.tris->size(); ++i)
-    {
-        int a = (*_mesh.tris)[i].v[0];
-        int b = (*_mesh.tris)[i].v[1];
-        int c = (*_mesh.tris)[i].v[2];
-        Edge e1;
-        e1.pointIDs = make_pair(min(a, b), max(a, b));
-        e1.triangleIDs.emplace_back(i);
-        alledges.emplace_back(e1);
-        Edge e2;
-        e2.pointIDs = make_pair(min(b, c), max(b, c));
-        e2.triangleIDs.emplace_back(i);
-        alledges.emplace_back(e2);
-        Edge e3;
-        e3.pointIDs = make_pair(min(c, a), max(c, a));
-        e3.triangleIDs.emplace_back(i);
-        alledges.emplace_back(e3);
-    }
-    sort(alledges.begin(), alledges.end());
+void UVAtlas::mergeCharts(const Mesh& mesh, vector<Chart>& charts)
+{
+    // at this stage, chart i contains the triangle i
+    assert(charts.size() == mesh.tris->size());
+    const int nbCharts = charts.size();
+
+    // list mesh edges (without duplicates, sorted by points) and their neighbor triangles
+    MeshTopology topology;
+    topology.buildEdges(mesh);
+    const int nbEdges = topology.edgesPointsPairs.size();
 
-    // merge edges (no duplicate)
-    vector<Edge> edges;
-    auto eit = alledges.begin() + 1;
-    while(eit != alledges.end())
+    vector<int> parents(nbCharts);
+    vector<int> nbTriangles(nbCharts, 1);
+    std::iota(parents.begin(), parents.end(), 0);
+
+    const auto findChart = [&parents](int cid)
     {
-        auto& a = *(eit-1);
-        auto& b = *eit;
-        if(a == b)
+        // path halving
+        while(parents[cid] != cid)
         {
-            a.triangleIDs.insert(a.triangleIDs.end(), b.triangleIDs.begin(), b.triangleIDs.end());
-            sort(a.triangleIDs.begin(), a.triangleIDs.end());
-            edges.push_back(a);
+            parents[cid] = parents[parents[cid]];
+            cid = parents[cid];
         }
-        ++eit;
-    }
-    alledges.clear();
+        return cid;
+    };
 
     // merge charts
-    for(auto& e : edges)
+    // sequential in the order of the edges: the merge of two charts intersects their common cameras,
+    // so the resulting charts depend on the order of the merges
+    for(int e = 0; e < nbEdges; ++e)
     {
-        if(e.triangleIDs.size() != 2)
+        if(topology.edgesNeighTris.size(e) != 2)
             continue;
-        int chartIDA = findChart(e.triangleIDs[0]);
-        int chartIDB = findChart(e.triangleIDs[1]);
+        const int chartIDA = findChart(topology.edgesNeighTris(e, 0));
+        const int chartIDB = findChart(topology.edgesNeighTris(e, 1));
         if(chartIDA == chartIDB)
             continue;
+
         Chart& a = charts[chartIDA];
         Chart& b = charts[chartIDB];
         vector<int> cameraIntersection;
@@ -145,24 +131,32 @@ void UVAtlas::packCharts(vector<Chart>& charts, mvsUtils::MultiViewParams& mp)
                     a.commonCameraIDs.begin(), a.commonCameraIDs.end(),
                     b.commonCameraIDs.begin(), b.commonCameraIDs.end(),
                     back_inserter(cameraIntersection));
-        if(cameraIntersection.size() == 0) // need at least 1 camera in common
+        if(cameraIntersection.empty()) // need at least 1 camera in common
             continue;
-        if(a.triangleIDs.size() > b.triangleIDs.size())
-        {
-            // merge b in a
-            a.commonCameraIDs = cameraIntersection;
-            a.triangleIDs.insert(a.triangleIDs.end(), b.triangleIDs.begin(), b.triangleIDs.end());
-            b.mergedWith = chartIDA;
-        }
-        else
-        {
-            // merge a in b
-            b.commonCameraIDs = cameraIntersection;
-            b.triangleIDs.insert(b.triangleIDs.end(), a.triangleIDs.begin(), a.triangleIDs.end());
-            a.mergedWith = chartIDB;
-        }
+
+        // merge the smallest chart in the largest one
+        const int target = (nbTriangles[chartIDA] > nbTriangles[chartIDB]) ? chartIDA : chartIDB;
+        const int source = (target == chartIDA) ? chartIDB : chartIDA;
+        charts[target].commonCameraIDs.swap(cameraIntersection);
+        nbTriangles[target] += nbTriangles[source];
+        parents[source] = target;
+    }
+
+    // move the triangles of the merged charts to their root chart
+    vector<int> roots(nbCharts);
+    for(int i = 0; i < nbCharts; ++i)
+        roots[i] = findChart(i);
+
+    for(int i = 0; i < nbCharts; ++i)
+    {
+        if(roots[i] == i)
+            continue;
+        Chart& root = charts[roots[i]];
+        if(root.triangleIDs.capacity() < nbTriangles[roots[i]])
+            root.triangleIDs.reserve(nbTriangles[roots[i]]);
+        root.triangleIDs.insert(root.triangleIDs.end(), charts[i].triangleIDs.begin(), charts[i].triangleIDs.end());
+        charts[i].mergedWith = roots[i];
     }
-    edges.clear();
 
     // remove merged charts
     charts.erase(remove_if(charts.begin(), charts.end(), [](Chart& c)
@@ -218,6 +212,29 @@ void UVAtlas::createTextureAtlases(vector<Chart>& charts, mvsUtils::MultiViewPar
 {
     ALICEVISION_LOG_INFO("Creating texture atlases.");
 
+    packChartsInAtlases(charts, _textureSide, _gutterSize, _atlases);
+
+    for(std::size_t i = 0; i < _atlases.size(); ++i)
+        ALICEVISION_LOG_INFO("\t- texture atlas " << (i + 1) << " filled with " << _atlases[i].size() << " charts.");
+}
+
+void UVAtlas::packChartsInAtlases(vector<Chart>& charts, int textureSide, int gutterSize, vector<vector<Chart>>& out_atlases)
+{
+    // downscale the charts that do not fit in an empty texture atlas (with their gutter)
+    const int maxChartSide = std::max(1, textureSide - 2 - 2 * gutterSize);
+    int nbDownscaledCharts = 0;
+    for(Chart& chart: charts)
+    {
+        const int sourceSide = std::max(chart.sourceRD.x - chart.sourceLU.x, chart.sourceRD.y - chart.sourceLU.y);
+        if(sourceSide > maxChartSide)
+        {
+            chart.scale = double(maxChartSide) / double(sourceSide);
+            ++nbDownscaledCharts;
+        }
+    }
+    if(nbDownscaledCharts > 0)
+        ALICEVISION_LOG_WARNING(nbDownscaledCharts << " charts are larger than the texture side (" << textureSide << ") and are downscaled.");
+
     // sort charts by size, descending
     std::sort(charts.begin(), charts.end(), [](const Chart& a, const Chart& b)
     {
@@ -228,49 +245,111 @@ void UVAtlas::createTextureAtlases(vector<Chart>& charts, mvsUtils::MultiViewPar
         return wa > wb;
     });
 
-    std::size_t i = 0; // forward index
-    std::size_t j = charts.size() - 1; // backward index
-    std::size_t texCount = 0;
+    // expected filling of an atlas, the charts that do not fit are handled in the next round
+    const double atlasFillRatio = 0.8;
+    const double atlasArea = double(textureSide) * double(textureSide);
+
+    const auto chartArea = [&](const Chart& chart)
+    {
+        return double(chart.width() + 2 * gutterSize) * double(chart.height() + 2 * gutterSize);
+    };
+
+    vector<ChartRect*> roots; // one guillotine tree per texture atlas
+
+    const auto insertChart = [&](std::size_t atlasID, int chartID) -> bool
+    {
+        Chart& chart = charts[chartID];
+        ChartRect* rect = roots[atlasID]->insert(chart, gutterSize);
+        if(!rect)
+            return false;
+
+        // store the final position
+        chart.targetLU = rect->LU;
+        chart.targetLU.x += gutterSize;
+        chart.targetLU.y += gutterSize;
+        // add to the texture atlas
+        out_atlases[atlasID].emplace_back(chart);
+        return true;
+    };
+
+    // chart indices, sorted by size (descending)
+    vector<int> remaining(charts.size());
+    std::iota(remaining.begin(), remaining.end(), 0);
 
-    // insert charts into one or more texture atlas
-    while(i <= j)
+    while(!remaining.empty())
     {
-        texCount++;
-        // create a texture atlas
-        ALICEVISION_LOG_INFO("\t- texture atlas " << texCount);
-        vector<Chart> atlas;
-        // create a tree root
-        ChartRect* root = new ChartRect();
-        root->LU.x = 0;
-        root->LU.y = 0;
-        root->RD.x = _textureSide - 1;
-        root->RD.y = _textureSide - 1;
-
-        const auto insertChart = [&](size_t idx) -> bool
+        // distribute the charts (largest first) to the least filled atlas
+        double totalArea = 0.0;
+        for(int chartID: remaining)
+            totalArea += chartArea(charts[chartID]);
+        const int nbAtlases = std::max(1, static_cast<int>(std::ceil(totalArea / (atlasFillRatio * atlasArea))));
+
+        vector<vector<int>> atlasesCharts(nbAtlases);
+        vector<double> atlasesArea(nbAtlases, 0.0);
+        for(int chartID: remaining)
+        {
+            const int atlasID = std::min_element(atlasesArea.begin(), atlasesArea.end()) - atlasesArea.begin();
+            atlasesCharts[atlasID].push_back(chartID);
+            atlasesArea[atlasID] += chartArea(charts[chartID]);
+        }
+
+        // fill the new atlases concurrently
+        const std::size_t firstAtlasID = roots.size();
+        for(int a = 0; a < nbAtlases; ++a)
+        {
+            ChartRect* root = new ChartRect();
+            root->LU.x = 0;
+            root->LU.y = 0;
+            root->RD.x = textureSide - 1;
+            root->RD.y = textureSide - 1;
+            roots.push_back(root);
+        }
+        out_atlases.resize(roots.size());
+
+        vector<vector<int>> rejected(nbAtlases);
+        #pragma omp parallel for schedule(dynamic, 1)
+        for(int a = 0; a < nbAtlases; ++a)
         {
-            Chart& chart = charts[idx];
-            ChartRect* rect = root->insert(chart, _gutterSize);
-            if(!rect)
-                return false;
-
-            // store the final position
-            chart.targetLU = rect->LU;
-            chart.targetLU.x += _gutterSize;
-            chart.targetLU.y += _gutterSize;
-            // add to the current texture atlas
-            atlas.emplace_back(chart);
-            return true;
-        };
-        // insert as many charts as possible in forward direction (largest to smallest)
-        while(i <= j && insertChart(i)) { ++i; }
-        // fill potential empty space (i != j) in backward direction
-        while(j > i && insertChart(j)) { --j; }
-
-        // atlas is full or all charts have been handled
-        ALICEVISION_LOG_INFO("Filled with " << atlas.size() << " charts.");
-        // store this texture
-        _atlases.emplace_back(atlas);
-        // clear the whole tree
+            for(int chartID: atlasesCharts[a])
+            {
+                if(!insertChart(firstAtlasID + a, chartID))
+                    rejected[a].push_back(chartID);
+            }
+        }
+
+        vector<int> nextRemaining;
+        for(const vector<int>& atlasRejected: rejected)
+            nextRemaining.insert(nextRemaining.end(), atlasRejected.begin(), atlasRejected.end());
+        std::sort(nextRemaining.begin(), nextRemaining.end());
+
+        if(nextRemaining.size() == remaining.size())
+        {
+            // cannot happen: every chart fits in an empty atlas once downscaled
+            ALICEVISION_LOG_ERROR(nextRemaining.size() << " charts cannot be packed in the texture atlases.");
+            break;
+        }
+
+        // backfill the empty space of the existing atlases
+        vector<int> notInserted;
+        for(int chartID: nextRemaining)
+        {
+            bool inserted = false;
+            for(std::size_t atlasID = 0; atlasID < roots.size() && !inserted; ++atlasID)
+                inserted = insertChart(atlasID, chartID);
+            if(!inserted)
+                notInserted.push_back(chartID);
+        }
+        remaining.swap(notInserted);
+    }
+
+    // remove empty atlases and clear the trees
+    out_atlases.erase(remove_if(out_atlases.begin(), out_atlases.end(), [](const vector<Chart>& atlas)
+            {
+                return atlas.empty();
+            }), out_atlases.end());
+
+    for(ChartRect* root: roots)
+    {
         root->clear();
         delete root;
     }
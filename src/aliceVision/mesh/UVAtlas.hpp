@@ -9,6 +9,7 @@
 #include <aliceVision/mvsData/StaticVector.hpp>
 #include <aliceVision/mesh/Mesh.hpp>
 
+#include <cmath>
 #include <vector>
 
 namespace aliceVision {
@@ -34,8 +35,9 @@ public:
         Pixel sourceRD;                                         // right-down pixel coordinates (in refCamera space)
         Pixel targetLU;                                         // left-up pixel coordinates (in uvatlas texture)
         int mergedWith = -1;                                    // ID of target chart, or -1 (not merged)
-        int width() const { return sourceRD.x - sourceLU.x; }
-        int height() const { return sourceRD.y - sourceLU.y; }
+        double scale = 1.0;                                     // refCamera to uvatlas texture pixels (< 1 if downscaled to fit)
+        int width() const { return static_cast<int>(std::ceil((sourceRD.x - sourceLU.x) * scale)); }
+        int height() const { return static_cast<int>(std::ceil((sourceRD.y - sourceLU.y) * scale)); }
     };
 
     struct ChartRect
@@ -58,6 +60,29 @@ public:
     int textureSide() const { return _textureSide; }
     const Mesh& mesh() const { return _mesh; }
 
+    /**
+     * @brief Merge the charts of adjacent triangles while they have at least one common camera.
+     * Union-find over the mesh edges shared by 2 triangles, in the order of the edges
+     * (the edges list is built in parallel): the result does not depend on the number of threads.
+     * @param[in] mesh the input mesh
+     * @param[in,out] charts one chart per triangle as input, the merged charts as output
+     */
+    static void mergeCharts(const Mesh& mesh, std::vector<Chart>& charts);
+
+    /**
+     * @brief Pack the charts into one or more texture atlases.
+     * Charts are distributed over the atlases by area and each atlas is filled concurrently
+     * with its own guillotine tree. Charts that do not fit are backfilled in the previous atlases
+     * or go to the next round of atlases.
+     * Charts larger than the texture side are downscaled (see Chart::scale) so that all the triangles get texels.
+     * @param[in,out] charts the charts to pack (sorted by size and updated with their target position)
+     * @param[in] textureSide the texture atlas side
+     * @param[in] gutterSize the gutter size around each chart
+     * @param[out] out_atlases the charts of each texture atlas
+     */
+    static void packChartsInAtlases(std::vector<Chart>& charts, int textureSide, int gutterSize,
+                                    std::vector<std::vector<Chart>>& out_atlases);
+
 private:
     void createCharts(std::vector<Chart>& charts, mvsUtils::MultiViewParams& mp, StaticVector<StaticVector<int>*>* ptsCams);
     void packCharts(std::vector<Chart>& charts, mvsUtils::MultiViewParams& mp);
@@ -0,0 +1,110 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mesh/UVAtlas.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE UVAtlas
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::mesh;
+
+namespace {
+
+/**
+ * @brief Create a regular grid mesh of (size x size) vertices, 2 triangles per cell.
+ */
+void createGridMesh(Mesh& mesh, int size)
+{
+    mesh.pts = new StaticVector<Point3d>();
+    mesh.tris = new StaticVector<Mesh::triangle>();
+
+    for(int y = 0; y < size; ++y)
+        for(int x = 0; x < size; ++x)
+            mesh.pts->push_back(Point3d(x, y, 0.0));
+
+    for(int y = 0; y < size - 1; ++y)
+    {
+        for(int x = 0; x < size - 1; ++x)
+        {
+            const int a = y * size + x;
+            mesh.tris->push_back(Mesh::triangle(a, a + 1, a + size + 1));
+            mesh.tris->push_back(Mesh::triangle(a, a + size + 1, a + size));
+        }
+    }
+}
+
+/**
+ * @brief One chart per triangle, seen by a few random cameras.
+ */
+std::vector<UVAtlas::Chart> createTriangleCharts(const Mesh& mesh, int nbCameras)
+{
+    std::mt19937 randomNumberGenerator(0);
+    std::uniform_int_distribution<int> camera(0, nbCameras - 1);
+    std::uniform_int_distribution<int> nbVisibleCameras(1, 3);
+
+    std::vector<UVAtlas::Chart> charts(mesh.tris->size());
+    for(int i = 0; i < charts.size(); ++i)
+    {
+        const int nbVisible = nbVisibleCameras(randomNumberGenerator);
+        for(int k = 0; k < nbVisible; ++k)
+            charts[i].commonCameraIDs.push_back(camera(randomNumberGenerator));
+        std::sort(charts[i].commonCameraIDs.begin(), charts[i].commonCameraIDs.end());
+        charts[i].commonCameraIDs.erase(std::unique(charts[i].commonCameraIDs.begin(), charts[i].commonCameraIDs.end()),
+                                        charts[i].commonCameraIDs.end());
+        charts[i].triangleIDs.push_back(i);
+    }
+    return charts;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(UVAtlas_mergeCharts_threads)
+{
+    Mesh mesh;
+    createGridMesh(mesh, 200);
+    const std::vector<UVAtlas::Chart> triangleCharts = createTriangleCharts(mesh, 4);
+
+    // the merged charts do not depend on the number of threads
+    const int nbThreads = omp_get_max_threads();
+    std::vector<UVAtlas::Chart> charts[2];
+    for(int t = 0; t < 2; ++t)
+    {
+        omp_set_num_threads(t == 0 ? 1 : 8);
+        charts[t] = triangleCharts;
+        UVAtlas::mergeCharts(mesh, charts[t]);
+    }
+    omp_set_num_threads(nbThreads);
+
+    BOOST_REQUIRE_EQUAL(charts[0].size(), charts[1].size());
+    BOOST_CHECK_LT(charts[0].size(), triangleCharts.size());
+    for(std::size_t i = 0; i < charts[0].size(); ++i)
+    {
+        BOOST_CHECK(charts[0][i].triangleIDs == charts[1][i].triangleIDs);
+        BOOST_CHECK(charts[0][i].commonCameraIDs == charts[1][i].commonCameraIDs);
+    }
+
+    // each triangle is in one chart, seen by the common cameras of its chart
+    std::vector<int> nbChartsPerTriangle(triangleCharts.size(), 0);
+    for(const UVAtlas::Chart& chart : charts[0])
+    {
+        BOOST_CHECK(!chart.commonCameraIDs.empty());
+        for(int triangleID : chart.triangleIDs)
+        {
+            ++nbChartsPerTriangle[triangleID];
+            const std::vector<int>& triangleCameraIDs = triangleCharts[triangleID].commonCameraIDs;
+            BOOST_CHECK(std::includes(triangleCameraIDs.begin(), triangleCameraIDs.end(),
+                                      chart.commonCameraIDs.begin(), chart.commonCameraIDs.end()));
+        }
+    }
+    BOOST_CHECK(std::all_of(nbChartsPerTriangle.begin(), nbChartsPerTriangle.end(), [](int n) { return n == 1; }));
+}
@@ -0,0 +1,233 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mesh/MeshTopology.hpp>
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#define BOOST_TEST_MODULE meshTopology
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::mesh;
+
+namespace {
+
+/**
+ * @brief Create a regular grid mesh of (size x size) vertices, 2 triangles per cell.
+ */
+void createGridMesh(Mesh& mesh, int size)
+{
+    mesh.pts = new StaticVector<Point3d>();
+    mesh.tris = new StaticVector<Mesh::triangle>();
+
+    for(int y = 0; y < size; ++y)
+        for(int x = 0; x < size; ++x)
+            mesh.pts->push_back(Point3d(x, y, 0.0));
+
+    for(int y = 0; y < size - 1; ++y)
+    {
+        for(int x = 0; x < size - 1; ++x)
+        {
+            const int a = y * size + x;
+            mesh.tris->push_back(Mesh::triangle(a, a + 1, a + size + 1));
+            mesh.tris->push_back(Mesh::triangle(a, a + size + 1, a + size));
+        }
+    }
+}
+
+std::vector<int> getElement(const CSRAdjacency& adjacency, int i)
+{
+    return std::vector<int>(adjacency.begin(i), adjacency.end(i));
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(MeshTopology_radixSort_empty)
+{
+    std::vector<std::uint64_t> keys;
+    std::vector<int> values;
+    radixSortKeyValues(keys, values, 0);
+    BOOST_CHECK(keys.empty());
+    BOOST_CHECK(values.empty());
+
+    keys.push_back(42);
+    values.push_back(7);
+    radixSortKeyValues(keys, values, 42);
+    BOOST_CHECK_EQUAL(keys[0], 42);
+    BOOST_CHECK_EQUAL(values[0], 7);
+}
+
+BOOST_AUTO_TEST_CASE(MeshTopology_radixSort_stable)
+{
+    std::mt19937_64 randomNumberGenerator(0);
+
+    // few distinct keys (duplicates check the stability) and large keys (several radix passes)
+    for(const std::uint64_t maxKey : {std::uint64_t(15), std::uint64_t(1) << 20, (std::uint64_t(1) << 40) - 1})
+    {
+        std::uniform_int_distribution<std::uint64_t> distribution(0, maxKey);
+        const int n = 100000;
+
+        std::vector<std::uint64_t> keys(n);
+        std::vector<int> values(n);
+        std::vector<std::pair<std::uint64_t, int>> expected(n);
+        for(int i = 0; i < n; ++i)
+        {
+            keys[i] = distribution(randomNumberGenerator);
+            values[i] = i;
+            expected[i] = std::make_pair(keys[i], i);
+        }
+        std::stable_sort(expected.begin(), expected.end(),
+                         [](const std::pair<std::uint64_t, int>& a, const std::pair<std::uint64_t, int>& b) {
+                             return a.first < b.first;
+                         });
+
+        radixSortKeyValues(keys, values, maxKey);
+
+        for(int i = 0; i < n; ++i)
+        {
+            BOOST_REQUIRE_EQUAL(keys[i], expected[i].first);
+            BOOST_REQUIRE_EQUAL(values[i], expected[i].second);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MeshTopology_CSRAdjacency_arrayOfArrays)
+{
+    StaticVector<StaticVector<int>*> arrays;
+    arrays.resize_with(3, nullptr);
+    arrays[0] = new StaticVector<int>();
+    arrays[0]->push_back(4);
+    arrays[0]->push_back(2);
+    arrays[2] = new StaticVector<int>();
+    arrays[2]->push_back(1);
+
+    CSRAdjacency adjacency;
+    adjacency.fromArrayOfArrays(arrays);
+
+    BOOST_CHECK_EQUAL(adjacency.nbElements(), 3);
+    BOOST_CHECK(getElement(adjacency, 0) == std::vector<int>({4, 2}));
+    BOOST_CHECK(adjacency.empty(1));
+    BOOST_CHECK(getElement(adjacency, 2) == std::vector<int>({1}));
+
+    StaticVector<StaticVector<int>*>* converted = adjacency.toArrayOfArrays();
+    BOOST_CHECK_EQUAL(converted->size(), 3);
+    BOOST_CHECK((*converted)[0]->getData() == arrays[0]->getData());
+    BOOST_CHECK((*converted)[1] == nullptr);
+    BOOST_CHECK((*converted)[2]->getData() == arrays[2]->getData());
+
+    deleteArrayOfArrays<int>(&converted);
+    delete arrays[0];
+    delete arrays[2];
+}
+
+BOOST_AUTO_TEST_CASE(MeshTopology_square)
+{
+    // 3 --- 2
+    // |   / |
+    // | /   |
+    // 0 --- 1
+    Mesh mesh;
+    createGridMesh(mesh, 2);
+    std::swap((*mesh.pts)[2], (*mesh.pts)[3]);
+    (*mesh.tris)[0] = Mesh::triangle(0, 1, 2);
+    (*mesh.tris)[1] = Mesh::triangle(0, 2, 3);
+
+    const MeshTopology topology(mesh);
+
+    BOOST_CHECK(getElement(topology.ptsNeighTris, 0) == std::vector<int>({0, 1}));
+    BOOST_CHECK(getElement(topology.ptsNeighTris, 1) == std::vector<int>({0}));
+    BOOST_CHECK(getElement(topology.ptsNeighTris, 2) == std::vector<int>({0, 1}));
+    BOOST_CHECK(getElement(topology.ptsNeighTris, 3) == std::vector<int>({1}));
+
+    BOOST_CHECK(getElement(topology.ptsNeighPts, 0) == std::vector<int>({1, 2, 3}));
+    BOOST_CHECK(getElement(topology.ptsNeighPts, 1) == std::vector<int>({0, 2}));
+    BOOST_CHECK(getElement(topology.ptsNeighPts, 2) == std::vector<int>({0, 1, 3}));
+    BOOST_CHECK(getElement(topology.ptsNeighPts, 3) == std::vector<int>({0, 2}));
+
+    const std::vector<Pixel> expectedEdges = {Pixel(0, 1), Pixel(0, 2), Pixel(0, 3), Pixel(1, 2), Pixel(2, 3)};
+    BOOST_REQUIRE_EQUAL(topology.edgesPointsPairs.size(), expectedEdges.size());
+    BOOST_REQUIRE_EQUAL(topology.edgesNeighTris.nbElements(), expectedEdges.size());
+    for(std::size_t e = 0; e < expectedEdges.size(); ++e)
+    {
+        BOOST_CHECK_EQUAL(topology.edgesPointsPairs[e].x, expectedEdges[e].x);
+        BOOST_CHECK_EQUAL(topology.edgesPointsPairs[e].y, expectedEdges[e].y);
+    }
+    BOOST_CHECK(getElement(topology.edgesNeighTris, 0) == std::vector<int>({0}));
+    BOOST_CHECK(getElement(topology.edgesNeighTris, 1) == std::vector<int>({0, 1}));
+    BOOST_CHECK(getElement(topology.edgesNeighTris, 2) == std::vector<int>({1}));
+    BOOST_CHECK(getElement(topology.edgesNeighTris, 3) == std::vector<int>({0}));
+    BOOST_CHECK(getElement(topology.edgesNeighTris, 4) == std::vector<int>({1}));
+}
+
+BOOST_AUTO_TEST_CASE(MeshTopology_degeneratedEdge)
+{
+    // the points 1 and 2 are at the same position: the edge (1, 2) is not a points neighborhood
+    Mesh mesh;
+    mesh.pts = new StaticVector<Point3d>();
+    mesh.tris = new StaticVector<Mesh::triangle>();
+    mesh.pts->push_back(Point3d(0.0, 0.0, 0.0));
+    mesh.pts->push_back(Point3d(1.0, 0.0, 0.0));
+    mesh.pts->push_back(Point3d(1.0, 0.0, 0.0));
+    mesh.tris->push_back(Mesh::triangle(0, 1, 2));
+
+    const MeshTopology topology(mesh);
+
+    BOOST_CHECK_EQUAL(topology.edgesPointsPairs.size(), 3);
+    BOOST_CHECK(getElement(topology.ptsNeighPts, 0) == std::vector<int>({1, 2}));
+    BOOST_CHECK(getElement(topology.ptsNeighPts, 1) == std::vector<int>({0}));
+    BOOST_CHECK(getElement(topology.ptsNeighPts, 2) == std::vector<int>({0}));
+}
+
+BOOST_AUTO_TEST_CASE(MeshTopology_grid)
+{
+    const int size = 50;
+    Mesh mesh;
+    createGridMesh(mesh, size);
+
+    const MeshTopology topology(mesh);
+    const int nbCells = (size - 1) * (size - 1);
+
+    BOOST_CHECK_EQUAL(topology.ptsNeighTris.nbElements(), mesh.pts->size());
+    BOOST_CHECK_EQUAL(topology.ptsNeighPts.nbElements(), mesh.pts->size());
+    // horizontal + vertical + diagonal edges
+    BOOST_CHECK_EQUAL(topology.edgesPointsPairs.size(), 2 * size * (size - 1) + nbCells);
+    BOOST_CHECK_EQUAL(topology.ptsNeighTris.indices.size(), 3 * mesh.tris->size());
+
+    // inner vertices: 6 neighbor points and 6 neighbor triangles
+    const int inner = (size / 2) * size + size / 2;
+    BOOST_CHECK_EQUAL(topology.ptsNeighPts.size(inner), 6);
+    BOOST_CHECK_EQUAL(topology.ptsNeighTris.size(inner), 6);
+
+    for(int e = 0; e < topology.edgesNeighTris.nbElements(); ++e)
+    {
+        const Pixel& edge = topology.edgesPointsPairs[e];
+        BOOST_CHECK_LT(edge.x, edge.y);
+        if(e > 0)
+        {
+            const Pixel& previous = topology.edgesPointsPairs[e - 1];
+            BOOST_CHECK((previous.x < edge.x) || ((previous.x == edge.x) && (previous.y < edge.y)));
+        }
+
+        // manifold: 1 triangle on the border, 2 inside
+        BOOST_CHECK(topology.edgesNeighTris.size(e) == 1 || topology.edgesNeighTris.size(e) == 2);
+        for(const int* triId = topology.edgesNeighTris.begin(e); triId != topology.edgesNeighTris.end(e); ++triId)
+        {
+            const Mesh::triangle& t = (*mesh.tris)[*triId];
+            BOOST_CHECK(std::count(t.v, t.v + 3, edge.x) == 1 && std::count(t.v, t.v + 3, edge.y) == 1);
+        }
+    }
+
+    for(int ptId = 0; ptId < mesh.pts->size(); ++ptId)
+    {
+        BOOST_CHECK(std::is_sorted(topology.ptsNeighTris.begin(ptId), topology.ptsNeighTris.end(ptId)));
+        BOOST_CHECK(std::is_sorted(topology.ptsNeighPts.begin(ptId), topology.ptsNeighPts.end(ptId)));
+    }
+}
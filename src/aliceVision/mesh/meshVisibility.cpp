@@ -109,6 +109,10 @@ void remapMeshVisibilities_pushVerticesVisibilityToTriangles(
         }
     }
 
+    // for each reference vertex, find the closest output triangle:
+    // store the 3 output vertices (or -1) to transfer its visibility to
+    std::vector<int> refPtsTargets(3 * std::size_t(refMesh.pts->size()), -1);
+
     #pragma omp parallel for
     for (int rvi = 0; rvi < refMesh.pts->size(); ++rvi)
     {
@@ -129,18 +133,49 @@ void remapMeshVisibilities_pushVerticesVisibilityToTriangles(
         if(std::sqrt(dist2) > avgEdgeLength)
             continue;
 
-        #pragma omp critical
+        for (int i = 0; i < 3; ++i)
+        {
+            GEO::index_t v = meshG.facets.vertex(f, i);
+            if (v == GEO::NO_VERTEX)
+                continue;
+            refPtsTargets[3 * std::size_t(rvi) + i] = reorderedVertices[v];
+        }
+    }
+
+    // invert the mapping into a CSR structure: output vertex => reference vertices
+    CSRAdjacency ptsRefPts;
+    {
+        std::vector<int> counts(mesh.pts->size(), 0);
+        for(int target : refPtsTargets)
+        {
+            if(target != -1)
+                ++counts[target];
+        }
+        ptsRefPts.offsets.resize(counts.size() + 1);
+        ptsRefPts.offsets[0] = 0;
+        for(std::size_t vi = 0; vi < counts.size(); ++vi)
+            ptsRefPts.offsets[vi + 1] = ptsRefPts.offsets[vi] + counts[vi];
+        ptsRefPts.indices.resize(ptsRefPts.offsets.back());
+
+        std::vector<int> cursors(ptsRefPts.offsets.begin(), ptsRefPts.offsets.end() - 1);
+        for(std::size_t i = 0; i < refPtsTargets.size(); ++i)
+        {
+            const int target = refPtsTargets[i];
+            if(target != -1)
+                ptsRefPts.indices[cursors[target]++] = static_cast<int>(i / 3);
+        }
+    }
+
+    // each output vertex is only written by one thread: no critical section needed
+    #pragma omp parallel for
+    for (int vi = 0; vi < mesh.pts->size(); ++vi)
+    {
+        PointVisibility* pOut = out_ptsVisibilities[vi];
+        for(const int* rvi = ptsRefPts.begin(vi); rvi != ptsRefPts.end(vi); ++rvi)
         {
-            for (int i = 0; i < 3; ++i)
-            {
-                GEO::index_t v = meshG.facets.vertex(f, i);
-                if (v == GEO::NO_VERTEX)
-                    continue;
-                PointVisibility* pOut = out_ptsVisibilities[reorderedVertices[v]];
-                
-                for(int j = 0; j < rpVis->size(); ++j)
-                    pOut->push_back_distinct((*rpVis)[j]);
-            }
+            const PointVisibility* rpVis = refPtsVisibilities[*rvi];
+            for(int j = 0; j < rpVis->size(); ++j)
+                pOut->push_back_distinct((*rpVis)[j]);
         }
     }
 
@@ -0,0 +1,313 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "textureRasterization.hpp"
+#include <aliceVision/config.hpp>
+
+#include <geogram/basic/geometry_nd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+#include <xmmintrin.h>
+#endif
+
+namespace aliceVision {
+namespace mesh {
+
+namespace {
+
+/// number of texels projected at once
+const int texelsBatchSize = 4;
+
+/**
+ * @brief Compute the triangle bounding box in texel indexes, clamped to [0; textureSide].
+ */
+void getTriangleBoundingBox(const Point2d* triPixs, int textureSide, Pixel& out_LU, Pixel& out_RD)
+{
+    // min values: floor(value)
+    // max values: ceil(value)
+    out_LU.x = static_cast<int>(std::floor(std::min(std::min(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
+    out_LU.y = static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
+    out_RD.x = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
+    out_RD.y = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
+
+    out_LU.x = std::min(std::max(out_LU.x, 0), textureSide);
+    out_LU.y = std::min(std::max(out_LU.y, 0), textureSide);
+    out_RD.x = std::min(std::max(out_RD.x, 0), textureSide);
+    out_RD.y = std::min(std::max(out_RD.y, 0), textureSide);
+}
+
+inline unsigned int getTexelOffset(int x, int y, int textureSide)
+{
+    // remap 'y' to image coordinates system (inverted Y axis)
+    return static_cast<unsigned int>((textureSide - 1) - y) * textureSide + x;
+}
+
+/**
+ * @brief Same test as mvsUtils::MultiViewParams::isPixelInImage (rounded pixel position inside the image border).
+ */
+inline bool isInSourceImage(const RasterizationSource& source, double x, double y)
+{
+    const double xr = x + 0.5;
+    const double yr = y + 0.5;
+    return (xr >= source.border) && (xr < source.width - source.border) &&
+           (yr >= source.border) && (yr < source.height - source.border);
+}
+
+/**
+ * @brief Project a 3D point and sample its color if it is visible in the source image.
+ */
+void sampleTexel(const RasterizationSource& source, const Point3d& pt3d, unsigned int offset, std::vector<TexelColor>& out_texels)
+{
+    const Point3d XT = source.P * pt3d;
+    if(XT.z <= 0)
+        return;
+    const double x = XT.x / XT.z;
+    const double y = XT.y / XT.z;
+    if(!isInSourceImage(source, x, y))
+        return;
+    out_texels.push_back({offset, sampleBilinear(source, static_cast<float>(x), static_cast<float>(y))});
+}
+
+/**
+ * @brief Project a batch of texels of the same scanline and sample their colors.
+ * @param[in] rowXT homogeneous projection of the first texel of the scanline
+ * @param[in] dXTdx homogeneous projection increment between 2 consecutive texels
+ * @param[in] texelsX texels positions relative to the first texel of the scanline
+ */
+void sampleTexelsBatch(const RasterizationSource& source, const Point3d& rowXT, const Point3d& dXTdx,
+                       const int* texelsX, const unsigned int* offsets, int nbTexels, std::vector<TexelColor>& out_texels)
+{
+    float u[texelsBatchSize];
+    float v[texelsBatchSize];
+    int validMask = 0;
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+    // unused lanes duplicate the first texel
+    const __m128 k = _mm_setr_ps(static_cast<float>(texelsX[0]),
+                                 static_cast<float>(texelsX[nbTexels > 1 ? 1 : 0]),
+                                 static_cast<float>(texelsX[nbTexels > 2 ? 2 : 0]),
+                                 static_cast<float>(texelsX[nbTexels > 3 ? 3 : 0]));
+    const __m128 x = _mm_add_ps(_mm_set1_ps(static_cast<float>(rowXT.x)), _mm_mul_ps(k, _mm_set1_ps(static_cast<float>(dXTdx.x))));
+    const __m128 y = _mm_add_ps(_mm_set1_ps(static_cast<float>(rowXT.y)), _mm_mul_ps(k, _mm_set1_ps(static_cast<float>(dXTdx.y))));
+    const __m128 z = _mm_add_ps(_mm_set1_ps(static_cast<float>(rowXT.z)), _mm_mul_ps(k, _mm_set1_ps(static_cast<float>(dXTdx.z))));
+
+    const __m128 pu = _mm_div_ps(x, z);
+    const __m128 pv = _mm_div_ps(y, z);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 ur = _mm_add_ps(pu, half);
+    const __m128 vr = _mm_add_ps(pv, half);
+    const __m128 border = _mm_set1_ps(static_cast<float>(source.border));
+
+    __m128 valid = _mm_cmpgt_ps(z, _mm_setzero_ps());
+    valid = _mm_and_ps(valid, _mm_cmpge_ps(ur, border));
+    valid = _mm_and_ps(valid, _mm_cmplt_ps(ur, _mm_set1_ps(static_cast<float>(source.width - source.border))));
+    valid = _mm_and_ps(valid, _mm_cmpge_ps(vr, border));
+    valid = _mm_and_ps(valid, _mm_cmplt_ps(vr, _mm_set1_ps(static_cast<float>(source.height - source.border))));
+
+    _mm_storeu_ps(u, pu);
+    _mm_storeu_ps(v, pv);
+    validMask = _mm_movemask_ps(valid);
+#else
+    for(int i = 0; i < nbTexels; ++i)
+    {
+        const double z = rowXT.z + texelsX[i] * dXTdx.z;
+        if(z <= 0)
+            continue;
+        const double x = (rowXT.x + texelsX[i] * dXTdx.x) / z;
+        const double y = (rowXT.y + texelsX[i] * dXTdx.y) / z;
+        if(!isInSourceImage(source, x, y))
+            continue;
+        u[i] = static_cast<float>(x);
+        v[i] = static_cast<float>(y);
+        validMask |= (1 << i);
+    }
+#endif
+
+    for(int i = 0; i < nbTexels; ++i)
+    {
+        if(validMask & (1 << i))
+            out_texels.push_back({offsets[i], sampleBilinear(source, u[i], v[i])});
+    }
+}
+
+} // namespace
+
+bool isPixelInTriangle(const Point2d* triangle, const Pixel& pixel, Point2d& barycentricCoords)
+{
+    // get pixel center
+    GEO::vec2 p(pixel.x + 0.5, pixel.y + 0.5);
+    GEO::vec2 V0(triangle[0].x, triangle[0].y);
+    GEO::vec2 V1(triangle[1].x, triangle[1].y);
+    GEO::vec2 V2(triangle[2].x, triangle[2].y);
+    GEO::vec2 closestPoint;
+    double l1, l2, l3;
+    double dist = GEO::Geom::point_triangle_squared_distance<GEO::vec2>(p, V0, V1, V2, closestPoint, l1, l2, l3);
+    // fill barycentric coordinates as expected by other internal methods
+    barycentricCoords.x = l3;
+    barycentricCoords.y = l2;
+    // tolerance threshold of 1/2 pixel for pixels on the edges of the triangle
+    return dist < 0.5 + std::numeric_limits<double>::epsilon();
+}
+
+Point2d barycentricToCartesian(const Point2d* triangle, const Point2d& coords)
+{
+    return triangle[0] + (triangle[2] - triangle[0]) * coords.x + (triangle[1] - triangle[0]) * coords.y;
+}
+
+Point3d barycentricToCartesian(const Point3d* triangle, const Point2d& coords)
+{
+    return triangle[0] + (triangle[2] - triangle[0]) * coords.x + (triangle[1] - triangle[0]) * coords.y;
+}
+
+Color sampleBilinear(const RasterizationSource& source, float x, float y)
+{
+    const int xp = static_cast<int>(x);
+    const int yp = static_cast<int>(y);
+
+    const float ui = x - static_cast<float>(xp);
+    const float vi = y - static_cast<float>(yp);
+
+    // column-major storage: (x, y + 1) follows (x, y), (x + 1, y) is one column (height) away
+    const Color* p = source.image + static_cast<std::size_t>(xp) * source.height + yp;
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+    // each load reads 3 color channels and the first channel of the next pixel,
+    // which exists as the position is inside the image border
+    const __m128 lu = _mm_loadu_ps(p[0].m);
+    const __m128 ld = _mm_loadu_ps(p[1].m);
+    const __m128 ru = _mm_loadu_ps(p[source.height].m);
+    const __m128 rd = _mm_loadu_ps(p[source.height + 1].m);
+    const __m128 wu = _mm_set1_ps(ui);
+    const __m128 wv = _mm_set1_ps(vi);
+
+    const __m128 u = _mm_add_ps(lu, _mm_mul_ps(_mm_sub_ps(ru, lu), wu));
+    const __m128 d = _mm_add_ps(ld, _mm_mul_ps(_mm_sub_ps(rd, ld), wu));
+    const __m128 out = _mm_add_ps(u, _mm_mul_ps(_mm_sub_ps(d, u), wv));
+
+    float rgbx[4];
+    _mm_storeu_ps(rgbx, out);
+    return Color(rgbx[0], rgbx[1], rgbx[2]);
+#else
+    const Color& lu = p[0];
+    const Color& ld = p[1];
+    const Color& ru = p[source.height];
+    const Color& rd = p[source.height + 1];
+
+    // bilinear interpolation of the pixel intensity value
+    const Color u = lu + (ru - lu) * ui;
+    const Color d = ld + (rd - ld) * ui;
+    return u + (d - u) * vi;
+#endif
+}
+
+void rasterizeTriangleExact(const Point2d* triPixs, const Point3d* triPts, int textureSide,
+                            const RasterizationSource& source, std::vector<TexelColor>& out_texels)
+{
+    Pixel LU, RD;
+    getTriangleBoundingBox(triPixs, textureSide, LU, RD);
+
+    // iterate over bounding box's pixels
+    for(int y = LU.y; y < RD.y; ++y)
+    {
+        for(int x = LU.x; x < RD.x; ++x)
+        {
+            Point2d barycCoords;
+            // test if the pixel is inside triangle
+            // and retrieve its barycentric coordinates
+            if(!isPixelInTriangle(triPixs, Pixel(x, y), barycCoords))
+                continue;
+            sampleTexel(source, barycentricToCartesian(triPts, barycCoords), getTexelOffset(x, y, textureSide), out_texels);
+        }
+    }
+}
+
+void rasterizeTriangle(const Point2d* triPixs, const Point3d* triPts, int textureSide,
+                       const RasterizationSource& source, std::vector<TexelColor>& out_texels)
+{
+    const Point2d& V0 = triPixs[0];
+    const Point2d e1 = triPixs[1] - V0;
+    const Point2d e2 = triPixs[2] - V0;
+    const double det = e1.x * e2.y - e1.y * e2.x;
+
+    if(std::abs(det) < 1e-9)
+    {
+        // degenerated triangle in texture space
+        rasterizeTriangleExact(triPixs, triPts, textureSide, source, out_texels);
+        return;
+    }
+
+    Pixel LU, RD;
+    getTriangleBoundingBox(triPixs, textureSide, LU, RD);
+
+    // barycentric weights of V1 and V2 are linear in the texel position:
+    // l1 = (e2.y * (px - V0.x) - e2.x * (py - V0.y)) / det
+    // l2 = (e1.x * (py - V0.y) - e1.y * (px - V0.x)) / det
+    const double dl1dx = e2.y / det;
+    const double dl2dx = -e1.y / det;
+
+    // the distance of a texel to the line of the edge opposite to Vi is li * hi (hi: triangle height)
+    const double h0 = std::abs(det) / (triPixs[2] - triPixs[1]).size();
+    const double h1 = std::abs(det) / e2.size();
+    const double h2 = std::abs(det) / e1.size();
+    // same tolerance as isPixelInTriangle (squared distance)
+    const double maxEdgeDist = std::sqrt(0.5 + std::numeric_limits<double>::epsilon());
+
+    // the homogeneous projection is linear in barycentric coordinates: XT = XT0 + l1 * Q1 + l2 * Q2
+    const Point3d XT0 = source.P * triPts[0];
+    const Point3d Q1 = source.P * triPts[1] - XT0;
+    const Point3d Q2 = source.P * triPts[2] - XT0;
+    const Point3d dXTdx = Q1 * dl1dx + Q2 * dl2dx;
+
+    int texelsX[texelsBatchSize];
+    unsigned int offsets[texelsBatchSize];
+
+    for(int y = LU.y; y < RD.y; ++y)
+    {
+        // barycentric coordinates of the first texel center of the scanline
+        const double px = LU.x + 0.5 - V0.x;
+        const double py = y + 0.5 - V0.y;
+        const double rowL1 = (e2.y * px - e2.x * py) / det;
+        const double rowL2 = (e1.x * py - e1.y * px) / det;
+        const Point3d rowXT = XT0 + Q1 * rowL1 + Q2 * rowL2;
+
+        int nbTexels = 0;
+        for(int k = 0; k < RD.x - LU.x; ++k)
+        {
+            const double l1 = rowL1 + k * dl1dx;
+            const double l2 = rowL2 + k * dl2dx;
+            const double l0 = 1.0 - l1 - l2;
+            const int x = LU.x + k;
+
+            if(l0 >= 0.0 && l1 >= 0.0 && l2 >= 0.0)
+            {
+                // inside the triangle
+                texelsX[nbTexels] = k;
+                offsets[nbTexels] = getTexelOffset(x, y, textureSide);
+                if(++nbTexels == texelsBatchSize)
+                {
+                    sampleTexelsBatch(source, rowXT, dXTdx, texelsX, offsets, nbTexels, out_texels);
+                    nbTexels = 0;
+                }
+            }
+            else if(std::min(std::min(l0 * h0, l1 * h1), l2 * h2) > -maxEdgeDist)
+            {
+                // close to an edge: use the closest point in the triangle
+                Point2d barycCoords;
+                if(isPixelInTriangle(triPixs, Pixel(x, y), barycCoords))
+                    sampleTexel(source, barycentricToCartesian(triPts, barycCoords), getTexelOffset(x, y, textureSide), out_texels);
+            }
+        }
+        if(nbTexels > 0)
+            sampleTexelsBatch(source, rowXT, dXTdx, texelsX, offsets, nbTexels, out_texels);
+    }
+}
+
+} // namespace mesh
+} // namespace aliceVision
@@ -0,0 +1,86 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Color.hpp>
+#include <aliceVision/mvsData/Matrix3x4.hpp>
+#include <aliceVision/mvsData/Pixel.hpp>
+#include <aliceVision/mvsData/Point2d.hpp>
+#include <aliceVision/mvsData/Point3d.hpp>
+
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+
+/**
+ * @brief Source image used to sample the texels colors.
+ * The image is stored column-major as in mvsUtils::ImagesCache (pixel (x, y) at index x * height + y).
+ */
+struct RasterizationSource
+{
+    const Color* image = nullptr;
+    int width = 0;
+    int height = 0;
+    /// pixels closer to the image border are ignored (see mvsUtils::MultiViewParams::isPixelInImage)
+    int border = 2;
+    /// camera projection matrix
+    Matrix3x4 P;
+};
+
+/**
+ * @brief Color sampled for a texel of the texture atlas.
+ */
+struct TexelColor
+{
+    /// 1D texel index in the texture (Y axis inverted, image coordinates system)
+    unsigned int offset;
+    Color color;
+};
+
+/**
+ * @brief Return whether a pixel is contained in or intersected by a 2D triangle.
+ * @param[in] triangle the triangle as an array of 3 point2Ds
+ * @param[in] pixel the pixel to test
+ * @param[out] barycentricCoords the barycentric coordinates of this pixel relative to \p triangle
+ * @return true if the pixel center is less than half a pixel away from the triangle
+ */
+bool isPixelInTriangle(const Point2d* triangle, const Pixel& pixel, Point2d& barycentricCoords);
+
+Point2d barycentricToCartesian(const Point2d* triangle, const Point2d& coords);
+Point3d barycentricToCartesian(const Point3d* triangle, const Point2d& coords);
+
+/**
+ * @brief Bilinear interpolation of the source image color at a subpixel position.
+ * The position must be inside the image border.
+ */
+Color sampleBilinear(const RasterizationSource& source, float x, float y);
+
+/**
+ * @brief Rasterize a triangle of the texture atlas and sample its texels in the source image.
+ * Texels are visited scanline by scanline with incremental barycentric coordinates. As the projection
+ * is linear in homogeneous coordinates, the inner texels are projected by batches (SSE when available)
+ * and sampled with a vectorized bilinear kernel. Texels intersected by the triangle edges fall back to
+ * the exact point-triangle distance test.
+ * @param[in] triPixs the triangle texture coordinates (in pixels)
+ * @param[in] triPts the triangle 3D coordinates
+ * @param[in] textureSide the texture side
+ * @param[in] source the source image
+ * @param[in,out] out_texels the sampled texels are appended
+ */
+void rasterizeTriangle(const Point2d* triPixs, const Point3d* triPts, int textureSide,
+                       const RasterizationSource& source, std::vector<TexelColor>& out_texels);
+
+/**
+ * @brief Reference rasterization: exact pixel-triangle test and projection of each texel of the bounding box.
+ * Same parameters and results as rasterizeTriangle (up to floating point precision).
+ */
+void rasterizeTriangleExact(const Point2d* triPixs, const Point3d* triPts, int textureSide,
+                            const RasterizationSource& source, std::vector<TexelColor>& out_texels);
+
+} // namespace mesh
+} // namespace aliceVision
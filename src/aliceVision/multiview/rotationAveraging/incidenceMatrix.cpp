@@ -0,0 +1,322 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "incidenceMatrix.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace aliceVision {
+namespace rotationAveraging {
+
+namespace {
+
+/// Below this number of views, the dense factorization is faster than the iterative solver
+const std::size_t maxNbViewsDenseSolver = 300;
+
+/// Size of the blocks of the parallel dot product
+const Eigen::Index dotBlockSize = 4096;
+
+/**
+ * @brief Dot product computed in parallel by fixed-size blocks.
+ * The partial sums are added in the order of the blocks:
+ * the result does not depend on the number of threads (unlike an omp reduction).
+ */
+double parallelDot(const Vec& a, const Vec& b)
+{
+  const Eigen::Index size = a.size();
+  const int nbBlocks = static_cast<int>((size + dotBlockSize - 1) / dotBlockSize);
+  std::vector<double> blockSums(nbBlocks);
+
+  #pragma omp parallel for
+  for(int block = 0; block < nbBlocks; ++block)
+  {
+    const Eigen::Index begin = block * dotBlockSize;
+    const Eigen::Index blockSize = std::min(dotBlockSize, size - begin);
+    blockSums[block] = a.segment(begin, blockSize).dot(b.segment(begin, blockSize));
+  }
+
+  double result = 0.0;
+  for(double blockSum : blockSums)
+    result += blockSum;
+  return result;
+}
+
+} // namespace
+
+bool useIterativeLinearSolver(ELinearSolverType solverType, std::size_t nbViews)
+{
+  switch(solverType)
+  {
+    case LINEAR_SOLVER_DENSE:     return false;
+    case LINEAR_SOLVER_ITERATIVE: return true;
+    case LINEAR_SOLVER_AUTO:
+    default:                      return nbViews > maxNbViewsDenseSolver;
+  }
+}
+
+IncidenceMatrix::IncidenceMatrix(const RelativeRotations& relRs, std::size_t nbViews, std::size_t fixedViewId)
+  : _edges(relRs.size())
+  , _nbVariables(nbViews - 1)
+{
+  const auto getVariable = [fixedViewId](std::size_t viewId)
+  {
+    if(viewId == fixedViewId)
+      return -1;
+    return static_cast<int>(viewId < fixedViewId ? viewId : viewId - 1);
+  };
+
+  for(std::size_t e = 0; e < relRs.size(); ++e)
+  {
+    assert(relRs[e].i < nbViews && relRs[e].j < nbViews);
+    _edges[e].i = getVariable(relRs[e].i);
+    _edges[e].j = getVariable(relRs[e].j);
+  }
+}
+
+IncidenceMatrix IncidenceMatrix::fromRotationCorrections(const RelativeRotations& relRs, std::size_t nbViews, std::size_t fixedViewId)
+{
+  IncidenceMatrix A(relRs, nbViews, fixedViewId);
+  for(Edge& edge : A._edges)
+  {
+    edge.blockI = -Mat3::Identity();
+    edge.scaleJ = 1.0;
+  }
+  A.buildIncidentEdges();
+  return A;
+}
+
+IncidenceMatrix IncidenceMatrix::fromRotationConstraints(const RelativeRotations& relRs, std::size_t nbViews, std::size_t fixedViewId)
+{
+  IncidenceMatrix A(relRs, nbViews, fixedViewId);
+  for(std::size_t e = 0; e < relRs.size(); ++e)
+  {
+    A._edges[e].blockI = -relRs[e].Rij * relRs[e].weight;
+    A._edges[e].scaleJ = relRs[e].weight;
+  }
+  A.buildIncidentEdges();
+  return A;
+}
+
+void IncidenceMatrix::buildIncidentEdges()
+{
+  std::vector<int> counts(_nbVariables, 0);
+  for(const Edge& edge : _edges)
+  {
+    if(edge.i >= 0)
+      ++counts[edge.i];
+    if(edge.j >= 0)
+      ++counts[edge.j];
+  }
+
+  _incidentEdgesOffsets.resize(_nbVariables + 1);
+  _incidentEdgesOffsets[0] = 0;
+  for(std::size_t v = 0; v < _nbVariables; ++v)
+    _incidentEdgesOffsets[v + 1] = _incidentEdgesOffsets[v] + counts[v];
+
+  _incidentEdges.resize(_incidentEdgesOffsets.back());
+  std::vector<int> cursors(_incidentEdgesOffsets.begin(), _incidentEdgesOffsets.end() - 1);
+  for(std::size_t e = 0; e < _edges.size(); ++e)
+  {
+    if(_edges[e].i >= 0)
+      _incidentEdges[cursors[_edges[e].i]++] = 2 * static_cast<int>(e);
+    if(_edges[e].j >= 0)
+      _incidentEdges[cursors[_edges[e].j]++] = 2 * static_cast<int>(e) + 1;
+  }
+}
+
+void IncidenceMatrix::multiply(const Vec& x, Vec& y) const
+{
+  assert(x.size() == cols());
+  y.resize(rows());
+
+  const int nbEdges = static_cast<int>(_edges.size());
+  #pragma omp parallel for
+  for(int e = 0; e < nbEdges; ++e)
+  {
+    const Edge& edge = _edges[e];
+    Vec3 value = Vec3::Zero();
+    if(edge.i >= 0)
+      value += edge.blockI * x.segment<3>(3 * edge.i);
+    if(edge.j >= 0)
+      value += edge.scaleJ * x.segment<3>(3 * edge.j);
+    y.segment<3>(3 * e) = value;
+  }
+}
+
+void IncidenceMatrix::multiplyTranspose(const Vec& y, Vec& x) const
+{
+  assert(y.size() == rows());
+  x.resize(cols());
+
+  // gather per variable: no write conflict, no atomic
+  const int nbVariables = static_cast<int>(_nbVariables);
+  #pragma omp parallel for schedule(dynamic, 256)
+  for(int v = 0; v < nbVariables; ++v)
+  {
+    Vec3 value = Vec3::Zero();
+    for(int k = _incidentEdgesOffsets[v]; k < _incidentEdgesOffsets[v + 1]; ++k)
+    {
+      const int e = _incidentEdges[k] / 2;
+      if(_incidentEdges[k] % 2 == 0)
+        value += _edges[e].blockI.transpose() * y.segment<3>(3 * e);
+      else
+        value += _edges[e].scaleJ * y.segment<3>(3 * e);
+    }
+    x.segment<3>(3 * v) = value;
+  }
+}
+
+void IncidenceMatrix::multiplyNormal(const Vec& rowWeights, const Vec& x, Vec& y, Vec& buffer) const
+{
+  multiply(x, buffer);
+  if(rowWeights.size() != 0)
+    buffer.array() *= rowWeights.array();
+  multiplyTranspose(buffer, y);
+}
+
+void IncidenceMatrix::normalDiagonal(const Vec& rowWeights, Vec& diagonal) const
+{
+  diagonal.resize(cols());
+
+  const int nbVariables = static_cast<int>(_nbVariables);
+  #pragma omp parallel for schedule(dynamic, 256)
+  for(int v = 0; v < nbVariables; ++v)
+  {
+    Vec3 value = Vec3::Zero();
+    for(int k = _incidentEdgesOffsets[v]; k < _incidentEdgesOffsets[v + 1]; ++k)
+    {
+      const int e = _incidentEdges[k] / 2;
+      const Vec3 weights = (rowWeights.size() != 0) ? Vec3(rowWeights.segment<3>(3 * e)) : Vec3::Ones();
+      if(_incidentEdges[k] % 2 == 0)
+        value += _edges[e].blockI.cwiseAbs2().transpose() * weights;
+      else
+        value += _edges[e].scaleJ * _edges[e].scaleJ * weights;
+    }
+    diagonal.segment<3>(3 * v) = value;
+  }
+}
+
+void IncidenceMatrix::fixedViewContribution(const Vec3& fixedViewValue, Vec& c) const
+{
+  c.resize(rows());
+
+  const int nbEdges = static_cast<int>(_edges.size());
+  #pragma omp parallel for
+  for(int e = 0; e < nbEdges; ++e)
+  {
+    const Edge& edge = _edges[e];
+    Vec3 value = Vec3::Zero();
+    if(edge.i < 0)
+      value += edge.blockI * fixedViewValue;
+    if(edge.j < 0)
+      value += edge.scaleJ * fixedViewValue;
+    c.segment<3>(3 * e) = value;
+  }
+}
+
+sMat IncidenceMatrix::toSparse() const
+{
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(12 * _edges.size());
+  for(std::size_t e = 0; e < _edges.size(); ++e)
+  {
+    const Edge& edge = _edges[e];
+    const int row = 3 * static_cast<int>(e);
+    for(int k = 0; k < 3; ++k)
+    {
+      if(edge.i >= 0)
+      {
+        for(int l = 0; l < 3; ++l)
+          triplets.emplace_back(row + k, 3 * edge.i + l, edge.blockI(k, l));
+      }
+      if(edge.j >= 0)
+        triplets.emplace_back(row + k, 3 * edge.j + k, edge.scaleJ);
+    }
+  }
+
+  sMat A(rows(), cols());
+  A.setFromTriplets(triplets.begin(), triplets.end());
+  return A;
+}
+
+bool solveNormalEquationsCG(const IncidenceMatrix& A,
+                            const Vec& rowWeights,
+                            const Vec& b,
+                            Vec& x,
+                            double relativeTolerance,
+                            unsigned int maxIterations)
+{
+  const Eigen::Index n = A.cols();
+  assert(b.size() == n);
+
+  if(maxIterations == 0)
+    maxIterations = static_cast<unsigned int>(std::max(Eigen::Index(100), n));
+
+  if(x.size() != n)
+    x = Vec::Zero(n);
+
+  const double bNorm = std::sqrt(parallelDot(b, b));
+  if(bNorm == 0.0)
+  {
+    x.setZero();
+    return true;
+  }
+
+  // Jacobi preconditioner (unconstrained variables are left unchanged)
+  Vec invDiagonal;
+  A.normalDiagonal(rowWeights, invDiagonal);
+  for(Eigen::Index i = 0; i < n; ++i)
+    invDiagonal(i) = (invDiagonal(i) > 0.0) ? 1.0 / invDiagonal(i) : 0.0;
+
+  Vec buffer(A.rows()), Ap(n);
+  Vec r(n), z(n), p(n);
+
+  // r = b - H * x (warm start)
+  A.multiplyNormal(rowWeights, x, Ap, buffer);
+  r = b - Ap;
+  z = invDiagonal.cwiseProduct(r);
+  p = z;
+  double rz = parallelDot(r, z);
+
+  const double threshold = relativeTolerance * bNorm;
+  unsigned int iteration = 0;
+  double rNorm = std::sqrt(parallelDot(r, r));
+  for(; iteration < maxIterations && rNorm > threshold; ++iteration)
+  {
+    A.multiplyNormal(rowWeights, p, Ap, buffer);
+    const double pAp = parallelDot(p, Ap);
+    if(!(pAp > 0.0))
+    {
+      ALICEVISION_LOG_DEBUG("Conjugate gradient breakdown: the normal equations are not positive definite.");
+      return false;
+    }
+
+    const double alpha = rz / pAp;
+    x += alpha * p;
+    r -= alpha * Ap;
+    z = invDiagonal.cwiseProduct(r);
+
+    const double rzNext = parallelDot(r, z);
+    p = z + (rzNext / rz) * p;
+    rz = rzNext;
+    rNorm = std::sqrt(parallelDot(r, r));
+  }
+
+  if(rNorm > threshold)
+  {
+    ALICEVISION_LOG_DEBUG("Conjugate gradient did not converge after " << iteration << " iterations (relative residual: " << rNorm / bNorm << ").");
+    return false;
+  }
+
+  return true;
+}
+
+} // namespace rotationAveraging
+} // namespace aliceVision
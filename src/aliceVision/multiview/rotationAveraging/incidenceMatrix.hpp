@@ -0,0 +1,141 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/multiview/rotationAveraging/common.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace aliceVision {
+namespace rotationAveraging {
+
+/**
+ * Linear solver used for the normal equations of the rotation averaging problems.
+ * The dense solver is the default, the iterative solver is opt-in: it falls back
+ * to the dense solver if the conjugate gradient does not converge.
+ */
+enum ELinearSolverType
+{
+  LINEAR_SOLVER_AUTO = 0,      //< dense for small graphs, iterative otherwise
+  LINEAR_SOLVER_DENSE = 1,     //< dense factorization (time grows with the cube of the number of views)
+  LINEAR_SOLVER_ITERATIVE = 2  //< matrix-free preconditioned conjugate gradient
+};
+
+/**
+ * @brief Resolve the linear solver type according to the problem size.
+ * @param[in] solverType the requested linear solver type
+ * @param[in] nbViews the number of views of the rotation graph
+ * @return true if the iterative solver must be used
+ */
+bool useIterativeLinearSolver(ELinearSolverType solverType, std::size_t nbViews);
+
+/**
+ * @brief Matrix-free block incidence matrix A of a relative rotations graph.
+ *
+ * The 3 rows of the relative rotation e = (i, j) contain blockI(e) in the columns of the view i
+ * and scaleJ(e) * Identity in the columns of the view j.
+ * The columns of the fixed view are removed: the view v != fixedViewId owns the 3 columns
+ * starting at 3 * (v < fixedViewId ? v : v - 1).
+ *
+ * A, A^T or A^T A are never assembled: the products are computed in parallel
+ * from the edges list and from the list of edges incident to each view.
+ */
+class IncidenceMatrix
+{
+public:
+  /**
+   * @brief Build the matrix of the rotation corrections: [-I, I] per relative rotation, see l1::RefineRotationsAvgL1IRLS
+   * @param[in] relRs the relative rotations (the view indices must be in [0, nbViews[)
+   * @param[in] nbViews the number of views
+   * @param[in] fixedViewId the view whose columns are removed
+   */
+  static IncidenceMatrix fromRotationCorrections(const RelativeRotations& relRs, std::size_t nbViews, std::size_t fixedViewId);
+
+  /**
+   * @brief Build the matrix of the rotation constraints: w * [-Rij, I] per relative rotation, see l2::L2RotationAveraging
+   * @param[in] relRs the relative rotations (the view indices must be in [0, nbViews[)
+   * @param[in] nbViews the number of views
+   * @param[in] fixedViewId the view whose columns are removed
+   */
+  static IncidenceMatrix fromRotationConstraints(const RelativeRotations& relRs, std::size_t nbViews, std::size_t fixedViewId);
+
+  Eigen::Index rows() const { return 3 * static_cast<Eigen::Index>(_edges.size()); }
+  Eigen::Index cols() const { return 3 * static_cast<Eigen::Index>(_nbVariables); }
+
+  /// y = A * x
+  void multiply(const Vec& x, Vec& y) const;
+
+  /// x = A^T * y
+  void multiplyTranspose(const Vec& y, Vec& x) const;
+
+  /**
+   * @brief y = A^T * diag(rowWeights) * A * x
+   * @param[in] rowWeights one weight per row (empty for unit weights)
+   * @param[in] x input vector
+   * @param[out] y output vector
+   * @param[out] buffer temporary buffer of size rows()
+   */
+  void multiplyNormal(const Vec& rowWeights, const Vec& x, Vec& y, Vec& buffer) const;
+
+  /**
+   * @brief Diagonal of A^T * diag(rowWeights) * A
+   * @param[in] rowWeights one weight per row (empty for unit weights)
+   * @param[out] diagonal output diagonal
+   */
+  void normalDiagonal(const Vec& rowWeights, Vec& diagonal) const;
+
+  /**
+   * @brief Contribution of the fixed view to the rows: c = A_fixed * fixedViewValue
+   * @param[in] fixedViewValue the value of the fixed view unknowns
+   * @param[out] c output vector of size rows()
+   */
+  void fixedViewContribution(const Vec3& fixedViewValue, Vec& c) const;
+
+  /// Assemble A as a sparse matrix (for the dense solver fallback)
+  sMat toSparse() const;
+
+private:
+  struct Edge
+  {
+    int i; //< variable of the view i (-1 for the fixed view)
+    int j; //< variable of the view j (-1 for the fixed view)
+    Mat3 blockI;
+    double scaleJ;
+  };
+
+  IncidenceMatrix(const RelativeRotations& relRs, std::size_t nbViews, std::size_t fixedViewId);
+  void buildIncidentEdges();
+
+  std::vector<Edge> _edges;
+  std::size_t _nbVariables = 0;
+  /// edges incident to each variable (CSR): 2 * edgeId for the side i, 2 * edgeId + 1 for the side j
+  std::vector<int> _incidentEdgesOffsets;
+  std::vector<int> _incidentEdges;
+};
+
+/**
+ * @brief Solve (A^T * diag(rowWeights) * A) * x = b with a Jacobi preconditioned conjugate gradient.
+ * The result does not depend on the number of threads.
+ * @param[in] A the incidence matrix
+ * @param[in] rowWeights one positive weight per row of A (empty for unit weights)
+ * @param[in] b the right hand side
+ * @param[in,out] x the initial guess (warm start) and the solution
+ * @param[in] relativeTolerance stop when the residual norm is below relativeTolerance * norm(b)
+ * @param[in] maxIterations maximum number of iterations, 0 for the size of the system
+ * @return false if the solver broke down (the system is not positive definite)
+ *         or did not converge within maxIterations
+ */
+bool solveNormalEquationsCG(const IncidenceMatrix& A,
+                            const Vec& rowWeights,
+                            const Vec& b,
+                            Vec& x,
+                            double relativeTolerance = 1e-8,
+                            unsigned int maxIterations = 0);
+
+} // namespace rotationAveraging
+} // namespace aliceVision
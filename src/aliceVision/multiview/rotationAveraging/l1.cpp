@@ -7,6 +7,7 @@
 
 #include "l1.hpp"
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #ifdef ALICEVISION_ROTATION_AVERAGING_WITH_BOOST
 #include <boost/graph/adjacency_list.hpp>
@@ -44,6 +45,58 @@ namespace aliceVision   {
 namespace rotationAveraging  {
 namespace l1  {
 
+// Products and normal equations solver used by the L1RA and IRLS implementations:
+// - dense/sparse Eigen matrices: A^T * W * A is assembled and factorized (dense LDLT)
+// - IncidenceMatrix: matrix-free products and conjugate gradient (warm started from x)
+
+template<typename MATRIX_TYPE>
+inline void _Multiply(const MATRIX_TYPE& A, const Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x, Eigen::Matrix<REAL, Eigen::Dynamic, 1>& y)
+{
+  y = A*x;
+}
+inline void _Multiply(const IncidenceMatrix& A, const Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x, Eigen::Matrix<REAL, Eigen::Dynamic, 1>& y)
+{
+  A.multiply(x, y);
+}
+
+template<typename MATRIX_TYPE>
+inline void _MultiplyTranspose(const MATRIX_TYPE& A, const Eigen::Matrix<REAL, Eigen::Dynamic, 1>& y, Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x)
+{
+  x = A.transpose()*y;
+}
+inline void _MultiplyTranspose(const IncidenceMatrix& A, const Eigen::Matrix<REAL, Eigen::Dynamic, 1>& y, Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x)
+{
+  A.multiplyTranspose(y, x);
+}
+
+// solve (A^T * diag(w) * A) * x = b
+template<typename MATRIX_TYPE>
+inline bool _SolveNormalEquations(
+  const MATRIX_TYPE& A,
+  const Eigen::Matrix<REAL, Eigen::Dynamic, 1>& w,
+  const Eigen::Matrix<REAL, Eigen::Dynamic, 1>& b,
+  Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x)
+{
+  typedef Eigen::Matrix<REAL, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
+  // optimized solver as A^T * W * A is positive definite and symmetric
+  const Eigen::LDLT<Matrix> solver(Matrix(A.transpose()*(Eigen::DiagonalMatrix<REAL,Eigen::Dynamic>(w)*A)));
+  if (solver.info() != Eigen::Success)
+    return false;
+  x = solver.solve(b);
+  return (solver.info() == Eigen::Success);
+}
+inline bool _SolveNormalEquations(
+  const IncidenceMatrix& A,
+  const Eigen::Matrix<REAL, Eigen::Dynamic, 1>& w,
+  const Eigen::Matrix<REAL, Eigen::Dynamic, 1>& b,
+  Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x)
+{
+  if (solveNormalEquationsCG(A, w, b, x))
+    return true;
+  ALICEVISION_LOG_WARNING("The conjugate gradient did not converge, fall back to the dense solver.");
+  return _SolveNormalEquations(A.toSparse(), w, b, x);
+}
+
 // Minimum l1 error approximation:
 //
 // Let A be a M x N matrix with full rank. Given y of R^M, the problem
@@ -67,7 +120,6 @@ inline bool TRobustRegressionL1PD(
   Eigen::Matrix<REAL, Eigen::Dynamic, 1>& xp,
   REAL pdtol, unsigned pdmaxiter)
 {
-  typedef Eigen::Matrix<REAL, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
   typedef Eigen::Matrix<REAL, Eigen::Dynamic, 1> Vector;
   const unsigned M = (unsigned)y.size();
   const unsigned N = (unsigned)xp.size();
@@ -78,7 +130,8 @@ inline bool TRobustRegressionL1PD(
   const REAL mu(10);
 
   Vector x(xp);
-  Vector Ax(A*x);
+  Vector Ax(M);
+  _Multiply(A, x, Ax);
   Vector tmpM1(y-Ax);
   Vector tmpM2(-tmpM1);
   Vector tmpM3(tmpM1.cwiseAbs()), tmpM4(M);
@@ -91,16 +144,15 @@ inline bool TRobustRegressionL1PD(
     lamu1(i) = -1.0/fu1(i);
     lamu2(i) = -1.0/fu2(i);
   }
-  const MATRIX_TYPE At(A.transpose());
-  Vector Atv(At*(lamu1-lamu2));
+  Vector Atv(N);
+  _MultiplyTranspose(A, Vector(lamu1-lamu2), Atv);
   REAL AtvNormSq = Atv.squaredNorm();
   Vector rdual((-lamu1-lamu2).array() + REAL(1));
   REAL rdualNormSq = rdual.squaredNorm();
 
-  Vector w2(M), sig1(M), sig2(M), sigx(M), dx(N), up(N), Atdv(N);
+  Vector w2(M), sig1(M), sig2(M), sigx(M), dx(Vector::Zero(N)), up(N), Atdv(N), w1p(N);
   Vector Axp(M), Atvp(M);
-  Vector &Adx(sigx), &du(w2), &w1p(dx);
-  Matrix H11p(N,N);
+  Vector &Adx(sigx), &du(w2);
   Vector &dlamu1(tmpM3), &dlamu2(tmpM4);
   for (unsigned pditer=0; pditer<pdmaxiter; ++pditer) {
     // surrogate duality gap
@@ -127,19 +179,22 @@ inline bool TRobustRegressionL1PD(
     sig2 = tmpM1 - tmpM2;
     sigx = sig1 - sig2.cwiseAbs2().cwiseQuotient(sig1);
 
-    H11p = At*(Eigen::DiagonalMatrix<REAL,Eigen::Dynamic>(sigx)*A);
-    w1p = At*(tmpM4 - tmpM3 - (sig2.cwiseQuotient(sig1).cwiseProduct(w2)));
+    _MultiplyTranspose(A, Vector(tmpM4 - tmpM3 - (sig2.cwiseQuotient(sig1).cwiseProduct(w2))), w1p);
 
-    // optimized solver as A is positive definite and symmetric
-    dx = H11p.ldlt().solve(w1p);
+    // solve (A^T * diag(sigx) * A) * dx = w1p (dx holds the previous step as initial guess)
+    if (!_SolveNormalEquations(A, sigx, w1p, dx)) {
+      // returning last iterate
+      xp = x;
+      return false;
+    }
 
-    Adx = A*dx;
+    _Multiply(A, dx, Adx);
 
     du = (w2 - sig2.cwiseProduct(Adx)).cwiseQuotient(sig1);
 
     dlamu1 = -tmpM1.cwiseProduct(Adx-du) - lamu1 + tmpM3;
     dlamu2 =  tmpM2.cwiseProduct(Adx+du) - lamu2 + tmpM4;
-    Atdv = At*(dlamu1-dlamu2);
+    _MultiplyTranspose(A, Vector(dlamu1-dlamu2), Atdv);
 
     // make sure that the step is feasible: keeps lamu1,lamu2 > 0, fu1,fu2 < 0
     REAL s(1);
@@ -221,6 +276,14 @@ bool RobustRegressionL1PD(
 {
   return TRobustRegressionL1PD(A, b, x, pdtol, pdmaxiter);
 }
+bool RobustRegressionL1PD(
+  const IncidenceMatrix& A,
+  const Eigen::Matrix<REAL, Eigen::Dynamic, 1>& b,
+  Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x,
+  REAL pdtol, unsigned pdmaxiter)
+{
+  return TRobustRegressionL1PD(A, b, x, pdtol, pdmaxiter);
+}
 
 /*----------------------------------------------------------------*/
 
@@ -232,36 +295,30 @@ inline bool TIterativelyReweightedLeastSquares(
   Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x,
   REAL sigma, REAL eps)
 {
-  typedef Eigen::Matrix<REAL, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
   typedef Eigen::Matrix<REAL, Eigen::Dynamic, 1> Vector;
   const unsigned m = (unsigned)b.size();
   const unsigned n = (unsigned)x.size();
   assert(A.rows() == m && A.cols() == n);
 
   // iterate optimization till the desired precision is reached
-  Vector xp(n), e(m);
+  Vector xp(n), e(m), Atb(n);
   const REAL sigmaSq(Square(sigma));
   unsigned iter = 0;
   REAL delta = std::numeric_limits<REAL>::max(), deltap;
   do {
     xp = x;
     // compute error vector
-    e = A*x-b;
+    _Multiply(A, x, e);
+    e -= b;
     // compute robust errors using the Huber-like loss function
     for (unsigned i=0; i<m; ++i) {
       REAL& err = e(i);
       const REAL errSq(Square(err));
       err = sigmaSq / (errSq + sigmaSq);
     }
-    // solve the linear system using l2 norm
-    const MATRIX_TYPE AtF(A.transpose()*e.asDiagonal());
-    const Eigen::LDLT<Matrix> solver(AtF*A); // compute the Cholesky decomposition
-    if (solver.info() != Eigen::Success) {
-      ALICEVISION_LOG_WARNING("error: decomposing linear system failed");
-      return false;
-    }
-    x = solver.solve(AtF*b);
-    if (solver.info() != Eigen::Success) {
+    // solve the linear system using l2 norm: (A^T * F * A) * x = A^T * F * b
+    _MultiplyTranspose(A, Vector(e.cwiseProduct(b)), Atb);
+    if (!_SolveNormalEquations(A, e, Atb, x)) {
       ALICEVISION_LOG_WARNING("error: solving linear system failed");
       return false;
     }
@@ -288,6 +345,14 @@ bool IterativelyReweightedLeastSquares(
 {
   return TIterativelyReweightedLeastSquares(A, b, x, sigma, eps);
 }
+bool IterativelyReweightedLeastSquares(
+  const IncidenceMatrix& A,
+  const Eigen::Matrix<REAL, Eigen::Dynamic, 1>& b,
+  Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x,
+  REAL sigma, REAL eps)
+{
+  return TIterativelyReweightedLeastSquares(A, b, x, sigma, eps);
+}
 
 /////////////////////////
 
@@ -552,7 +617,8 @@ bool GlobalRotationsRobust(
   Matrix3x3Arr& Rs,
   const size_t nMainViewID,
   float threshold,
-  std::vector<bool> * vec_Inliers)
+  std::vector<bool> * vec_Inliers,
+  ELinearSolverType solverType)
 {
   assert(!Rs.empty());
 
@@ -560,7 +626,7 @@ bool GlobalRotationsRobust(
   InitRotationsMST(RelRs, Rs, nMainViewID);
 
   // refine global rotations based on the relative rotations
-  const bool bOk = RefineRotationsAvgL1IRLS(RelRs, Rs, nMainViewID);
+  const bool bOk = RefineRotationsAvgL1IRLS(RelRs, Rs, nMainViewID, aliceVision::degreeToRadian(5.0), solverType);
 
   // find outlier relative rotations
   if (threshold>=0 && vec_Inliers)  {
@@ -605,7 +671,8 @@ inline void _FillErrorMatrix(
   const Matrix3x3Arr& Rs,
   Eigen::Matrix<REAL,Eigen::Dynamic,1>& b)
 {
-  for (size_t r = 0; r < RelRs.size(); ++r) {
+  #pragma omp parallel for
+  for (int r = 0; r < RelRs.size(); ++r) {
     const RelativeRotation& relR = RelRs[r];
     const Matrix3x3& Ri = Rs[relR.i];
     const Matrix3x3& Rj = Rs[relR.j];
@@ -623,7 +690,8 @@ inline void _CorrectMatrix(
   const size_t nMainViewID,
   Matrix3x3Arr& Rs)
 {
-  for (size_t r = 0; r < Rs.size(); ++r) {
+  #pragma omp parallel for
+  for (int r = 0; r < Rs.size(); ++r) {
     if (r == nMainViewID)
       continue;
     Matrix3x3& Ri = Rs[r];
@@ -635,35 +703,23 @@ inline void _CorrectMatrix(
   }
 }
 
-// Refine the global rotations using to the given relative rotations, similar to:
-// "Efficient and Robust Large-Scale Rotation Averaging", Chatterjee and Govindu, 2013
-// L1 Rotation Averaging (L1RA) and Iteratively Reweighted Least Squares (IRLS) implementations combined
-bool RefineRotationsAvgL1IRLS(
+// L1RA then IRLS iterations on the linear system Ax=b
+template<typename MATRIX_TYPE>
+inline bool _RefineRotationsAvgL1IRLS(
+  const MATRIX_TYPE& A,
   const RelativeRotations& RelRs,
   Matrix3x3Arr& Rs,
   const size_t nMainViewID,
-  REAL sigma)
+  REAL sigma,
+  unsigned& iter1,
+  unsigned& iter2)
 {
-  assert(!RelRs.empty() && !Rs.empty());
-  assert(Rs[nMainViewID] == Matrix3x3::Identity());
-
-  REAL fMinBefore, fMaxBefore, fMeanBefore = RelRotationAvgError(RelRs, Rs, &fMinBefore, &fMaxBefore);
-
-  const unsigned nObss = (unsigned)RelRs.size();
-  const unsigned nVars = (unsigned)Rs.size()-1; // main view is kept constant
-  const unsigned m = nObss*3;
-  const unsigned n = nVars*3;
-
-  // build mapping matrix A in Ax=b
-  Eigen::SparseMatrix<REAL,Eigen::ColMajor> A(m, n);
-  _FillMappingMatrix(RelRs, nMainViewID, A);
-
   // init x with 0 that corresponds to trusting completely the initial Ri guess
-  Vec x(Vec::Zero(n)), b(m);
+  Vec x(Vec::Zero(A.cols())), b(A.rows());
 
   // L1RA iterate optimization till the desired precision is reached
   REAL e = std::numeric_limits<REAL>::max(), ep;
-  unsigned iter1 = 0;
+  iter1 = 0;
   do {
     // compute errors for each relative rotation
     _FillErrorMatrix(RelRs, Rs, b);
@@ -681,7 +737,7 @@ bool RefineRotationsAvgL1IRLS(
   // IRLS iterate optimization till the desired precision is reached
   x.setZero();
   e = std::numeric_limits<REAL>::max();
-  unsigned iter2 = 0;
+  iter2 = 0;
   do {
     // compute errors for each relative rotation
     _FillErrorMatrix(RelRs, Rs, b);
@@ -696,6 +752,43 @@ bool RefineRotationsAvgL1IRLS(
     // apply correction to global rotations
     _CorrectMatrix(x, nMainViewID, Rs);
   } while (++iter2 < 32 && e > 1e-5 && (ep-e)/e > 1e-2);
+  return true;
+}
+
+// Refine the global rotations using to the given relative rotations, similar to:
+// "Efficient and Robust Large-Scale Rotation Averaging", Chatterjee and Govindu, 2013
+// L1 Rotation Averaging (L1RA) and Iteratively Reweighted Least Squares (IRLS) implementations combined
+bool RefineRotationsAvgL1IRLS(
+  const RelativeRotations& RelRs,
+  Matrix3x3Arr& Rs,
+  const size_t nMainViewID,
+  REAL sigma,
+  ELinearSolverType solverType)
+{
+  assert(!RelRs.empty() && !Rs.empty());
+  assert(Rs[nMainViewID] == Matrix3x3::Identity());
+
+  REAL fMinBefore, fMaxBefore, fMeanBefore = RelRotationAvgError(RelRs, Rs, &fMinBefore, &fMaxBefore);
+
+  const unsigned nObss = (unsigned)RelRs.size();
+  const unsigned nVars = (unsigned)Rs.size()-1; // main view is kept constant
+  const unsigned m = nObss*3;
+  const unsigned n = nVars*3;
+
+  unsigned iter1 = 0, iter2 = 0;
+  bool bOk = false;
+  if (useIterativeLinearSolver(solverType, Rs.size())) {
+    // matrix-free mapping matrix A in Ax=b
+    const IncidenceMatrix A = IncidenceMatrix::fromRotationCorrections(RelRs, Rs.size(), nMainViewID);
+    bOk = _RefineRotationsAvgL1IRLS(A, RelRs, Rs, nMainViewID, sigma, iter1, iter2);
+  } else {
+    // build mapping matrix A in Ax=b
+    Eigen::SparseMatrix<REAL,Eigen::ColMajor> A(m, n);
+    _FillMappingMatrix(RelRs, nMainViewID, A);
+    bOk = _RefineRotationsAvgL1IRLS(A, RelRs, Rs, nMainViewID, sigma, iter1, iter2);
+  }
+  if (!bOk)
+    return false;
 
   REAL fMinAfter, fMaxAfter, fMeanAfter = RelRotationAvgError(RelRs, Rs, &fMinAfter, &fMaxAfter);
 
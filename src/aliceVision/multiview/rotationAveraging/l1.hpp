@@ -8,6 +8,7 @@
 #pragma once
 
 #include <aliceVision/multiview/rotationAveraging/common.hpp>
+#include <aliceVision/multiview/rotationAveraging/incidenceMatrix.hpp>
 
 //------------------
 //-- Bibliography --
@@ -47,13 +48,15 @@ void InitRotationsMST
  * @param[in] nMainViewID Id of the image considered as Identity (unit rotation)
  * @param[in] threshold (optionnal) threshold
  * @param[out] vec_inliers rotation labelled as inliers or outliers
+ * @param[in] solverType linear solver of the refinement (see RefineRotationsAvgL1IRLS)
  */
 bool GlobalRotationsRobust(
   const RelativeRotations& RelRs,
   Matrix3x3Arr& Rs,
   const size_t nMainViewID,
   float threshold = 0.f,
-  std::vector<bool> * vec_inliers = nullptr);
+  std::vector<bool> * vec_inliers = nullptr,
+  ELinearSolverType solverType = LINEAR_SOLVER_DENSE);
 
 /**
  * @brief Implementation of Iteratively Reweighted Least Squares (IRLS) [1].
@@ -62,12 +65,14 @@ bool GlobalRotationsRobust(
  * @param[out] Rs output global rotation matrices
  * @param[in] nMainViewID Id of the image considered as Identity (unit rotation)
  * @param[in] sigma factor
+ * @param[in] solverType linear solver: dense factorization, or matrix-free conjugate gradient (opt-in, for large graphs)
  */
 bool RefineRotationsAvgL1IRLS(
   const RelativeRotations& RelRs,
   Matrix3x3Arr& Rs,
   const size_t nMainViewID,
-  REAL sigma=aliceVision::degreeToRadian(5.0));
+  REAL sigma=aliceVision::degreeToRadian(5.0),
+  ELinearSolverType solverType = LINEAR_SOLVER_DENSE);
 
 /**
  * @brief Sort relative rotation as inlier, outlier rotations.
@@ -100,6 +105,13 @@ bool RobustRegressionL1PD(
   Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x,
   REAL pdtol=1e-3, unsigned pdmaxiter=50);
 
+// L1RA [1] for matrix-free incidence matrix (conjugate gradient)
+bool RobustRegressionL1PD(
+  const IncidenceMatrix& A,
+  const Eigen::Matrix<REAL, Eigen::Dynamic, 1>& b,
+  Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x,
+  REAL pdtol=1e-3, unsigned pdmaxiter=50);
+
 /// IRLS [1] for dense A matrix
 bool IterativelyReweightedLeastSquares(
   const Eigen::Matrix<REAL, Eigen::Dynamic, Eigen::Dynamic>& A,
@@ -114,6 +126,13 @@ bool IterativelyReweightedLeastSquares(
   Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x,
   REAL sigma, REAL eps=1e-5);
 
+/// IRLS [1] for matrix-free incidence matrix (conjugate gradient warm started from x)
+bool IterativelyReweightedLeastSquares(
+  const IncidenceMatrix& A,
+  const Eigen::Matrix<REAL, Eigen::Dynamic, 1>& b,
+  Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x,
+  REAL sigma, REAL eps=1e-5);
+
 } // namespace l1
 } // namespace rotationAveraging
 } // namespace aliceVision
@@ -51,6 +51,48 @@ bool compare_first_abs(std::pair<double, Vec> const &x, std::pair<double, Vec> c
  return fabs(x.first) < fabs(y.first);
 }
 
+// Solve [1] formula 6.62 with R0 fixed to Identity:
+//  for each column k of the rotations, minimize || A x + A_0 e_k ||
+//  (A_0 e_k is the contribution of the fixed R0 column) using the normal equations
+//  A^T A x = - A^T A_0 e_k, solved with a matrix-free conjugate gradient.
+bool L2RotationAveraging_Iterative( size_t nCamera,
+  const RelativeRotations& vec_relativeRot,
+  // Output
+  std::vector<Mat3> & vec_ApprRotMatrix)
+{
+  const size_t nMainViewID = 0;
+  const IncidenceMatrix A = IncidenceMatrix::fromRotationConstraints(vec_relativeRot, nCamera, nMainViewID);
+  const Vec unitWeights;
+
+  Vec columns[3];
+  Vec fixedViewContribution, rhs;
+  for (int k = 0; k < 3; ++k)
+  {
+    A.fixedViewContribution(Vec3::Unit(k), fixedViewContribution);
+    A.multiplyTranspose(fixedViewContribution, rhs);
+    rhs = -rhs;
+    columns[k] = Vec::Zero(A.cols());
+    if (!solveNormalEquationsCG(A, unitWeights, rhs, columns[k]))
+      return false;
+  }
+
+  //-- Enforce the orthogonality constraint
+  //   (approximate rotation in the Frobenius norm using SVD).
+  vec_ApprRotMatrix.resize(nCamera);
+  vec_ApprRotMatrix[nMainViewID] = Mat3::Identity();
+  #pragma omp parallel for
+  for (int i = 1; i < nCamera; ++i)
+  {
+    const int v = i - 1;
+    Mat3 Rotation;
+    Rotation << columns[0].segment<3>(3 * v),
+                columns[1].segment<3>(3 * v),
+                columns[2].segment<3>(3 * v);
+    vec_ApprRotMatrix[i] = ClosestSVDRotationMatrix(Rotation);
+  }
+  return true;
+}
+
 //-- Solve the Global Rotation matrix registration for each camera given a list
 //    of relative orientation using matrix parametrization
 //    [1] formula 6.62 page 100. Dense formulation.
@@ -77,8 +119,16 @@ bool compare_first_abs(std::pair<double, Vec> const &x, std::pair<double, Vec> c
 bool L2RotationAveraging( size_t nCamera,
   const RelativeRotations& vec_relativeRot,
   // Output
-  std::vector<Mat3> & vec_ApprRotMatrix)
+  std::vector<Mat3> & vec_ApprRotMatrix,
+  ELinearSolverType solverType)
 {
+  if (useIterativeLinearSolver(solverType, nCamera))
+  {
+    if (L2RotationAveraging_Iterative(nCamera, vec_relativeRot, vec_ApprRotMatrix))
+      return true;
+    ALICEVISION_LOG_WARNING("The conjugate gradient did not converge, fall back to the dense solver.");
+  }
+
   const size_t nRotationEstimation = vec_relativeRot.size();
   //--
   // Setup the Action Matrix
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <aliceVision/multiview/rotationAveraging/common.hpp>
+#include <aliceVision/multiview/rotationAveraging/incidenceMatrix.hpp>
 #include <vector>
 
 #ifdef _MSC_VER
@@ -55,10 +56,17 @@ Mat3 ClosestSVDRotationMatrix(const Mat3 & rotMat);
 // vector.add( RelativeRotation(1,2, R12) );
 // vector.add( RelativeRotation(0,2, R02) );
 //
+// With the dense solver, the rotations are the 3 eigenvectors of the smallest eigenvalues of A^T A.
+// With the iterative solver (opt-in, for large graphs), R0 is fixed to Identity and the 3 columns
+// of the other rotations are the least squares solutions of the remaining linear systems,
+// solved with a matrix-free conjugate gradient: this formulation differs from the dense one.
+// If the conjugate gradient does not converge, the dense solver is used.
+//
 bool L2RotationAveraging( size_t nCamera,
   const RelativeRotations& vec_relativeRot,
   // Output
-  std::vector<Mat3> & vec_ApprRotMatrix);
+  std::vector<Mat3> & vec_ApprRotMatrix,
+  ELinearSolverType solverType = LINEAR_SOLVER_DENSE);
 
 // None linear refinement of the rotation using an angle-axis representation
 bool L2RotationAveraging_Refine(
@@ -8,6 +8,7 @@
 #include "aliceVision/multiview/rotationAveraging/rotationAveraging.hpp"
 #include "aliceVision/multiview/essential.hpp"
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 #include "aliceVision/multiview/NViewDataSet.hpp"
 
 #include <iostream>
@@ -15,6 +16,7 @@
 #include <vector>
 #include <iterator>
 #include <utility>
+#include <random>
 
 #define BOOST_TEST_MODULE rotationAveraging
 #include <boost/test/included/unit_test.hpp>
@@ -318,6 +320,96 @@ BOOST_AUTO_TEST_CASE ( rotationAveraging_RefineRotationsAvgL1IRLS_CompleteGraph_
   }
 }
 
+// Link each camera of a ring to the nbNeighbors next ones, with noisy relative rotations
+RelativeRotations createRingRelativeRotations(const NViewDataSet& d, std::size_t nbNeighbors, double noiseDegrees)
+{
+  std::mt19937 randomNumberGenerator(0);
+  std::normal_distribution<double> noise(0.0, degreeToRadian(noiseDegrees));
+
+  const std::size_t nbViews = d._R.size();
+  RelativeRotations relativeRotations;
+  for(std::size_t i = 0; i < nbViews; ++i)
+  {
+    for(std::size_t k = 1; k <= nbNeighbors; ++k)
+    {
+      const std::size_t j = (i + k) % nbViews;
+      Mat3 Rrel;
+      Vec3 trel;
+      RelativeCameraMotion(d._R[i], d._t[i], d._R[j], d._t[j], &Rrel, &trel);
+      const Vec3 axis = Vec3::Random().normalized();
+      Rrel = Eigen::AngleAxisd(noise(randomNumberGenerator), axis).toRotationMatrix() * Rrel;
+      relativeRotations.push_back(RelativeRotation(i, j, Rrel, 1));
+    }
+  }
+  return relativeRotations;
+}
+
+BOOST_AUTO_TEST_CASE ( rotationAveraging_L2RotationAveraging_iterative)
+{
+  const int iNviews = 20;
+  const NViewDataSet d = NRealisticCamerasRing(iNviews, 5,
+    NViewDatasetConfigurator(1,1,0,0,5,0)); // Suppose a camera with Unit matrix as K
+
+  const RelativeRotations vec_relativeRotEstimate = createRingRelativeRotations(d, 3, 0.0);
+
+  std::vector<Mat3> vec_globalR;
+  BOOST_CHECK(L2RotationAveraging(iNviews, vec_relativeRotEstimate, vec_globalR, LINEAR_SOLVER_ITERATIVE));
+  BOOST_CHECK_EQUAL(iNviews, vec_globalR.size());
+
+  // Check that each global rotation is near the true one (up to the global gauge)
+  for (std::size_t i = 0; i < iNviews; ++i)
+  {
+    BOOST_CHECK_SMALL(FrobeniusDistance(Mat3(d._R[i] * d._R[0].transpose()), Mat3(vec_globalR[i] * vec_globalR[0].transpose())), 1e-6);
+  }
+}
+
+BOOST_AUTO_TEST_CASE ( rotationAveraging_RefineRotationsAvgL1IRLS_iterative)
+{
+  const int iNviews = 30;
+  const NViewDataSet d = NRealisticCamerasRing(iNviews, 5,
+    NViewDatasetConfigurator(1,1,0,0,5,0)); // Suppose a camera with Unit matrix as K
+
+  const RelativeRotations vec_relativeRotEstimate = createRingRelativeRotations(d, 4, 1.0);
+
+  // The matrix-free solver must give the same solution as the dense one
+  Matrix3x3Arr vec_globalR_dense(iNviews);
+  Matrix3x3Arr vec_globalR_iterative(iNviews);
+  std::size_t nMainViewID = 0;
+  BOOST_CHECK(GlobalRotationsRobust(vec_relativeRotEstimate, vec_globalR_dense, nMainViewID, 0.0f, nullptr, LINEAR_SOLVER_DENSE));
+  BOOST_CHECK(GlobalRotationsRobust(vec_relativeRotEstimate, vec_globalR_iterative, nMainViewID, 0.0f, nullptr, LINEAR_SOLVER_ITERATIVE));
+
+  for (std::size_t i = 0; i < iNviews; ++i)
+  {
+    BOOST_CHECK_SMALL(FrobeniusDistance(vec_globalR_dense[i], vec_globalR_iterative[i]), 1e-6);
+    // noisy relative rotations (1 degree): the global rotations remain close to the true ones
+    BOOST_CHECK_SMALL(FrobeniusDistance(Mat3(d._R[i] * d._R[0].transpose()), vec_globalR_iterative[i]), 0.05);
+  }
+}
+
+BOOST_AUTO_TEST_CASE ( rotationAveraging_iterative_threads)
+{
+  // several blocks of the parallel dot products
+  const int iNviews = 2000;
+  const NViewDataSet d = NRealisticCamerasRing(iNviews, 5,
+    NViewDatasetConfigurator(1,1,0,0,5,0)); // Suppose a camera with Unit matrix as K
+
+  const RelativeRotations vec_relativeRotEstimate = createRingRelativeRotations(d, 2, 1.0);
+
+  // The iterative solver must not depend on the number of threads
+  const int nbThreads = omp_get_max_threads();
+  std::vector<Mat3> vec_globalR_threads[2];
+  for (int t = 0; t < 2; ++t)
+  {
+    omp_set_num_threads(t == 0 ? 1 : 4);
+    BOOST_CHECK(L2RotationAveraging(iNviews, vec_relativeRotEstimate, vec_globalR_threads[t], LINEAR_SOLVER_ITERATIVE));
+  }
+  omp_set_num_threads(nbThreads);
+
+  BOOST_REQUIRE_EQUAL(vec_globalR_threads[0].size(), vec_globalR_threads[1].size());
+  for (std::size_t i = 0; i < iNviews; ++i)
+    BOOST_CHECK(vec_globalR_threads[0][i] == vec_globalR_threads[1][i]);
+}
+
 /*
 template<typename TYPE, int N>
 inline REAL ComputePSNR(const Eigen::Matrix<REAL, N,1>& x0, const Eigen::Matrix<REAL, N,1>& x)
@@ -149,6 +149,12 @@ Color ImagesCache::getPixelValueInterpolated(const Point2d* pix, int camId)
     return out;
 }
 
+const Color* ImagesCache::getImageData(int camId)
+{
+    refreshData(camId);
+    return imgs[(*camIdMapId)[camId]];
+}
+
 rgb ImagesCache::getPixelValue(const Pixel& pix, int camId)
 {
     refreshData(camId);
@@ -40,6 +40,10 @@ public:
     int getPixelId(int x, int y, int imgid);
     void refreshData(int camId);
     Color getPixelValueInterpolated(const Point2d* pix, int camId);
+    /**
+     * @brief Get the image of a camera (loaded if needed), pixels are indexed with getPixelId.
+     */
+    const Color* getImageData(int camId);
     rgb getPixelValue(const Pixel& pix, int camId);
 };
 
@@ -14,6 +14,8 @@
 #include "aliceVision/feature/Regions.hpp"
 #include "aliceVision/camera/IntrinsicBase.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 namespace aliceVision {
@@ -282,6 +284,91 @@ void GuidedMatching(
   }
 }
 
+/**
+ * @brief Guided Matching with predicted positions (features + descriptors with distance ratio):
+ * each left region is matched with the right regions located in a window around its
+ * predicted position in the right image, keeping the best one under the user specified
+ * distance ratio (on the squared descriptor distances).
+ * The right regions are bucketed in a grid with cells of the window size, so only
+ * the regions of the neighbouring cells are compared.
+ *
+ * @param[in] lPredictedPositions the predicted position of each left region in the right image,
+ * the regions with a non finite position are not matched
+ * @param[in] lRegions regions (point features & corresponding descriptors)
+ * @param[in] rRegions regions (point features & corresponding descriptors)
+ * @param[in] windowRadius radius of the search window in pixels
+ * @param[in] distRatio maximal authorized distance ratio
+ * @param[out] out_matches corresponding index
+ */
+inline void GuidedMatchingInWindow(
+  const std::vector<Vec2>& lPredictedPositions,
+  const feature::Regions& lRegions,
+  const feature::Regions& rRegions,
+  double windowRadius,
+  double distRatio,
+  matching::IndMatches& out_matches)
+{
+  assert(lPredictedPositions.size() == lRegions.RegionCount());
+
+  if(rRegions.RegionCount() == 0 || windowRadius <= 0.0)
+    return;
+
+  std::vector<Vec2> rRegionsPos(rRegions.RegionCount());
+  for(std::size_t j = 0; j < rRegions.RegionCount(); ++j)
+    rRegionsPos[j] = rRegions.GetRegionPosition(j);
+
+  // bucket the right regions
+  Vec2 minPos = rRegionsPos.front();
+  Vec2 maxPos = rRegionsPos.front();
+  for(const Vec2& pos : rRegionsPos)
+  {
+    minPos = minPos.cwiseMin(pos);
+    maxPos = maxPos.cwiseMax(pos);
+  }
+  const int nbCellsX = static_cast<int>((maxPos.x() - minPos.x()) / windowRadius) + 1;
+  const int nbCellsY = static_cast<int>((maxPos.y() - minPos.y()) / windowRadius) + 1;
+  std::vector<std::vector<std::size_t>> cells(nbCellsX * nbCellsY);
+  for(std::size_t j = 0; j < rRegionsPos.size(); ++j)
+  {
+    const int cellX = static_cast<int>((rRegionsPos[j].x() - minPos.x()) / windowRadius);
+    const int cellY = static_cast<int>((rRegionsPos[j].y() - minPos.y()) / windowRadius);
+    cells[cellY * nbCellsX + cellX].push_back(j);
+  }
+
+  const double squaredRadius = Square(windowRadius);
+  for(std::size_t i = 0; i < lRegions.RegionCount(); ++i)
+  {
+    const Vec2& pos = lPredictedPositions[i];
+    if(!pos.allFinite())
+      continue;
+
+    // cells overlapped by the window
+    const int firstCellX = std::max(0, static_cast<int>(std::floor((pos.x() - windowRadius - minPos.x()) / windowRadius)));
+    const int firstCellY = std::max(0, static_cast<int>(std::floor((pos.y() - windowRadius - minPos.y()) / windowRadius)));
+    const int lastCellX = std::min(nbCellsX - 1, static_cast<int>(std::floor((pos.x() + windowRadius - minPos.x()) / windowRadius)));
+    const int lastCellY = std::min(nbCellsY - 1, static_cast<int>(std::floor((pos.y() + windowRadius - minPos.y()) / windowRadius)));
+
+    distanceRatio<double> dR;
+    for(int cellY = firstCellY; cellY <= lastCellY; ++cellY)
+    {
+      for(int cellX = firstCellX; cellX <= lastCellX; ++cellX)
+      {
+        for(const std::size_t j : cells[cellY * nbCellsX + cellX])
+        {
+          if((rRegionsPos[j] - pos).squaredNorm() < squaredRadius)
+            dR.update(j, lRegions.SquaredDescriptorDistance(i, &rRegions, j));
+        }
+      }
+    }
+    // Add correspondence only iff the distance ratio is valid
+    if(dR.isValid(distRatio))
+      out_matches.emplace_back(i, dR.idx);
+  }
+
+  // Remove duplicates (when multiple points at same position exist)
+  matching::IndMatch::getDeduplicated(out_matches);
+}
+
 /// Compute a bucket index from an epipolar point
 ///  (the one that is closer to image border intersection)
 inline unsigned int pix_to_bucket(const Vec2i &x, int W, int H)
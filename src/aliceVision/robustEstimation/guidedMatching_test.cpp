@@ -0,0 +1,93 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/robustEstimation/guidedMatching.hpp"
+#include "aliceVision/feature/regionsFactory.hpp"
+
+#include <limits>
+#include <vector>
+
+#define BOOST_TEST_MODULE guidedMatching
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::robustEstimation;
+
+namespace {
+
+feature::SIFT_Regions::DescriptorT makeDescriptor(unsigned char value)
+{
+  feature::SIFT_Regions::DescriptorT descriptor;
+  for(std::size_t i = 0; i < descriptor.size(); ++i)
+    descriptor[i] = value;
+  return descriptor;
+}
+
+void addRegion(feature::SIFT_Regions& regions, float x, float y, unsigned char value)
+{
+  regions.Features().emplace_back(x, y, 1.f, 0.f);
+  regions.Descriptors().push_back(makeDescriptor(value));
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(GuidedMatchingInWindow_matchInWindow)
+{
+  // right regions on a grid, with a descriptor specific to each position
+  feature::SIFT_Regions rRegions;
+  for(int y = 0; y < 10; ++y)
+    for(int x = 0; x < 10; ++x)
+      addRegion(rRegions, 10.f * x, 10.f * y, static_cast<unsigned char>(2 * (y * 10 + x)));
+
+  // left regions: the same descriptors, predicted near the right position
+  feature::SIFT_Regions lRegions;
+  std::vector<Vec2> lPredictedPositions;
+  const std::vector<int> rIndices = {0, 15, 42, 99};
+  for(int rIndex : rIndices)
+  {
+    addRegion(lRegions, 0.f, 0.f, static_cast<unsigned char>(2 * rIndex));
+    lPredictedPositions.push_back(rRegions.GetRegionPosition(rIndex) + Vec2(3.0, -2.0));
+  }
+  // a region predicted out of the image
+  addRegion(lRegions, 0.f, 0.f, 0);
+  lPredictedPositions.push_back(Vec2(500.0, 500.0));
+  // a region without prediction
+  addRegion(lRegions, 0.f, 0.f, 0);
+  lPredictedPositions.push_back(Vec2::Constant(std::numeric_limits<double>::quiet_NaN()));
+
+  matching::IndMatches matches;
+  GuidedMatchingInWindow(lPredictedPositions, lRegions, rRegions, 15.0, Square(0.8), matches);
+
+  BOOST_CHECK_EQUAL(matches.size(), rIndices.size());
+  for(const matching::IndMatch& match : matches)
+  {
+    BOOST_CHECK_LT(match._i, rIndices.size());
+    BOOST_CHECK_EQUAL(match._j, rIndices[match._i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GuidedMatchingInWindow_outOfWindow)
+{
+  feature::SIFT_Regions rRegions;
+  addRegion(rRegions, 0.f, 0.f, 10);
+  addRegion(rRegions, 100.f, 0.f, 50);
+  addRegion(rRegions, 100.f, 100.f, 90);
+
+  // the right region with the same descriptor is out of the window
+  feature::SIFT_Regions lRegions;
+  addRegion(lRegions, 0.f, 0.f, 10);
+  const std::vector<Vec2> lPredictedPositions = {Vec2(100.0, 50.0)};
+
+  matching::IndMatches matches;
+  GuidedMatchingInWindow(lPredictedPositions, lRegions, rRegions, 40.0, Square(0.8), matches);
+  BOOST_CHECK(matches.empty());
+
+  // with a larger window, the right regions are found
+  GuidedMatchingInWindow(lPredictedPositions, lRegions, rRegions, 200.0, Square(0.8), matches);
+  BOOST_CHECK_EQUAL(matches.size(), 1);
+  BOOST_CHECK_EQUAL(matches.front()._j, 0);
+}
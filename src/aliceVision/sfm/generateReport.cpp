@@ -20,7 +20,8 @@ namespace aliceVision {
 namespace sfm {
 
 bool generateSfMReport(const sfmData::SfMData& sfmData,
-                       const std::string& htmlFilename)
+                       const std::string& htmlFilename,
+                       const std::vector<std::pair<std::string, double>>& stagesTimes)
 {
   // Compute mean,max,median residual values per View
   IndexT residualCount = 0;
@@ -70,6 +71,39 @@ bool generateSfMReport(const sfmData::SfMData& sfmData,
   htmlDocStream.pushInfo( os.str() );
   htmlDocStream.pushInfo( sFullLine );
 
+  if(!stagesTimes.empty())
+  {
+    // Stage | Time (s)
+    htmlDocStream.pushInfo( "Timing:" + sNewLine );
+    htmlDocStream.pushInfo( sTableBegin );
+    os.str("");
+    os << sRowBegin
+      << sColBegin + "Stage" + sColEnd
+      << sColBegin + "Time (s)" + sColEnd
+      << sRowEnd;
+    htmlDocStream.pushInfo( os.str() );
+
+    double totalTime = 0.0;
+    for(const auto& stageTime : stagesTimes)
+    {
+      os.str("");
+      os << sRowBegin
+        << sColBegin << stageTime.first << sColEnd
+        << sColBegin << stageTime.second << sColEnd
+        << sRowEnd;
+      htmlDocStream.pushInfo( os.str() );
+      totalTime += stageTime.second;
+    }
+    os.str("");
+    os << sRowBegin
+      << sColBegin << "Total" << sColEnd
+      << sColBegin << totalTime << sColEnd
+      << sRowEnd;
+    htmlDocStream.pushInfo( os.str() );
+    htmlDocStream.pushInfo( sTableEnd );
+    htmlDocStream.pushInfo( sFullLine );
+  }
+
   htmlDocStream.pushInfo( sTableBegin);
   os.str("");
   os << sRowBegin
@@ -8,6 +8,8 @@
 #pragma once
 
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace aliceVision {
 
@@ -21,9 +23,12 @@ namespace sfm {
  * @brief generate a report for the structure from motion
  * @param sfmData The input sfmData
  * @param htmlFilename The filename of the HTML report
+ * @param stagesTimes The (name, time in seconds) of the reconstruction stages (optional)
  * @return true if ok
  */
-bool generateSfMReport(const sfmData::SfMData& sfmData, const std::string& htmlFilename);
+bool generateSfMReport(const sfmData::SfMData& sfmData,
+                       const std::string& htmlFilename,
+                       const std::vector<std::pair<std::string, double>>& stagesTimes = {});
 
 } // namespace sfm
 } // namespace aliceVision
@@ -39,6 +39,35 @@ using namespace aliceVision::camera;
 using namespace aliceVision::geometry;
 using namespace aliceVision::sfmData;
 
+namespace {
+
+/// View pairs matches per pose pair (min pose id, max pose id)
+typedef std::map<Pair, std::vector<matching::PairwiseMatches::const_iterator>> PairwiseMatchesPerPosePair;
+
+/**
+ * @brief List the pairwise matches shared between the poses of a triplet
+ * @param[in] matchesPerPosePair the pairwise matches indexed per pose pair
+ * @param[in] triplet the triplet of poses
+ * @param[out] out_pairwiseMatches the pairwise matches of the triplet
+ */
+void getTripletPairwiseMatches(const PairwiseMatchesPerPosePair& matchesPerPosePair,
+                               const graph::Triplet& triplet,
+                               std::vector<matching::PairwiseMatches::const_iterator>& out_pairwiseMatches)
+{
+  out_pairwiseMatches.clear();
+  const Pair posePairs[3] = {std::minmax(triplet.i, triplet.j),
+                             std::minmax(triplet.i, triplet.k),
+                             std::minmax(triplet.j, triplet.k)};
+  for(const Pair& posePair : posePairs)
+  {
+    const auto it = matchesPerPosePair.find(posePair);
+    if(it != matchesPerPosePair.end())
+      out_pairwiseMatches.insert(out_pairwiseMatches.end(), it->second.begin(), it->second.end());
+  }
+}
+
+} // namespace
+
 /// Use features in normalized camera frames
 bool GlobalSfMTranslationAveragingSolver::Run(ETranslationAveragingMethod eTranslationAveragingMethod,
                     SfMData& sfmData,
@@ -320,9 +349,12 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
   std::transform(map_globalR.begin(), map_globalR.end(),
     std::inserter(set_pose_ids, set_pose_ids.begin()), stl::RetrieveKey());
   // List shared correspondences (pairs) between poses
-  for (const auto & match_iterator : pairwiseMatches)
+  // and index them per pose pair, to retrieve the matches of a triplet without scanning all the pairs
+  PairwiseMatchesPerPosePair matchesPerPosePair;
+  for (matching::PairwiseMatches::const_iterator match_iterator = pairwiseMatches.begin();
+    match_iterator != pairwiseMatches.end(); ++match_iterator)
   {
-    const Pair pair = match_iterator.first;
+    const Pair pair = match_iterator->first;
     const View * v1 = sfmData.getViews().at(pair.first).get();
     const View * v2 = sfmData.getViews().at(pair.second).get();
 
@@ -333,6 +365,7 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
     {
       rotation_pose_id_graph.insert(
         std::make_pair(v1->getPoseId(), v2->getPoseId()));
+      matchesPerPosePair[std::minmax(v1->getPoseId(), v2->getPoseId())].push_back(match_iterator);
     }
   }
   // List putative triplets (from global rotations Ids)
@@ -346,37 +379,21 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
     // An estimated triplets of translation mark three edges as estimated.
 
     //-- precompute the number of track per triplet:
-    HashMap<IndexT, IndexT> map_tracksPerTriplets;
+    std::vector<IndexT> vec_tracksPerTriplets(vec_triplets.size());
 
-    #pragma omp parallel for schedule(dynamic)
-    for (int i = 0; i < (int)vec_triplets.size(); ++i)
+    #pragma omp parallel
     {
-      // List matches that belong to the triplet of poses
-      const graph::Triplet & triplet = vec_triplets[i];
-      matching::PairwiseMatches map_triplet_matches;
-      const std::set<IndexT> set_triplet_pose_ids = {triplet.i, triplet.j, triplet.k};
-      // List shared correspondences (pairs) between the triplet poses
-      for (const auto & match_iterator : pairwiseMatches)
-      {
-        const Pair pair = match_iterator.first;
-        const View * v1 = sfmData.getViews().at(pair.first).get();
-        const View * v2 = sfmData.getViews().at(pair.second).get();
-        if (// Consider the pair iff it is supported by the triplet graph & 2 different pose id
-            (v1->getPoseId() != v2->getPoseId())
-            && set_triplet_pose_ids.count(v1->getPoseId())
-            && set_triplet_pose_ids.count(v2->getPoseId()))
-        {
-          map_triplet_matches.insert( match_iterator );
-        }
-      }
-      // Compute tracks:
-      {
-        aliceVision::track::TracksBuilder tracksBuilder;
-        tracksBuilder.build(map_triplet_matches);
-        tracksBuilder.filter(3);
+      // per thread buffers, reused from one triplet to the next
+      std::vector<matching::PairwiseMatches::const_iterator> tripletPairwiseMatches;
+      aliceVision::track::TracksCounter tracksCounter;
 
-        #pragma omp critical
-        map_tracksPerTriplets[i] = tracksBuilder.nbTracks(); //count the # of matches in the UF tree
+      #pragma omp for schedule(dynamic)
+      for (int i = 0; i < (int)vec_triplets.size(); ++i)
+      {
+        // List matches that belong to the triplet of poses
+        getTripletPairwiseMatches(matchesPerPosePair, vec_triplets[i], tripletPairwiseMatches);
+        // Count the tracks visible in the 3 poses
+        vec_tracksPerTriplets[i] = tracksCounter.countTracks(tripletPairwiseMatches, 3);
       }
     }
 
@@ -424,7 +441,7 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
         std::vector<size_t> vec_commonTracksPerTriplets;
         for (const size_t triplet_index : vec_possibleTripletIndexes)
         {
-          vec_commonTracksPerTriplets.push_back(map_tracksPerTriplets[triplet_index]);
+          vec_commonTracksPerTriplets.push_back(vec_tracksPerTriplets[triplet_index]);
         }
 
         using namespace stl::indexed_sort;
@@ -458,12 +475,19 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
           std::vector<size_t> vec_inliers;
           aliceVision::track::TracksMap pose_triplet_tracks;
 
+          // List matches that belong to the triplet of poses
+          std::vector<matching::PairwiseMatches::const_iterator> tripletPairwiseMatches;
+          getTripletPairwiseMatches(matchesPerPosePair, triplet, tripletPairwiseMatches);
+          matching::PairwiseMatches map_triplet_matches;
+          for (const auto & match_iterator : tripletPairwiseMatches)
+            map_triplet_matches.insert(*match_iterator);
+
           const std::string sOutDirectory = "./";
           const bool bTriplet_estimation = Estimate_T_triplet(
               sfmData,
               map_globalR,
               normalizedFeaturesPerView,
-              pairwiseMatches,
+              map_triplet_matches,
               triplet,
               vec_tis,
               dPrecision,
@@ -584,7 +608,7 @@ bool GlobalSfMTranslationAveragingSolver::Estimate_T_triplet(
   const SfMData& sfmData,
   const HashMap<IndexT, Mat3>& map_globalR,
   const feature::FeaturesPerView& normalizedFeaturesPerView,
-  const matching::PairwiseMatches& pairwiseMatches,
+  const matching::PairwiseMatches& map_triplet_matches,
   const graph::Triplet& poses_id,
   std::vector<Vec3>& vec_tis,
   double& precision, // UpperBound of the precision found by the AContrario estimator
@@ -592,24 +616,6 @@ bool GlobalSfMTranslationAveragingSolver::Estimate_T_triplet(
   aliceVision::track::TracksMap& tracks,
   const std::string& outDirectory) const
 {
-  // List matches that belong to the triplet of poses
-  matching::PairwiseMatches map_triplet_matches;
-  const std::set<IndexT> set_pose_ids = {poses_id.i, poses_id.j, poses_id.k};
-  // List shared correspondences (pairs) between poses
-  for (const auto & match_iterator : pairwiseMatches)
-  {
-    const Pair& pair = match_iterator.first;
-    const View* v1 = sfmData.getViews().at(pair.first).get();
-    const View* v2 = sfmData.getViews().at(pair.second).get();
-    if (// Consider the pair iff it is supported by the triplet graph & 2 different pose id
-        (v1->getPoseId() != v2->getPoseId())
-        && set_pose_ids.count(v1->getPoseId())
-        && set_pose_ids.count(v2->getPoseId()))
-    {
-      map_triplet_matches.insert( match_iterator );
-    }
-  }
-
   aliceVision::track::TracksBuilder tracksBuilder;
   tracksBuilder.build(map_triplet_matches);
   tracksBuilder.filter(3);
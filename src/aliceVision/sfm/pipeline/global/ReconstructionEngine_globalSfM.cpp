@@ -71,27 +71,41 @@ void ReconstructionEngine_globalSfM::SetFeaturesProvider(feature::FeaturesPerVie
 
   // Copy features and save a normalized version
   _normalizedFeaturesPerView = std::make_shared<FeaturesPerView>(*featuresPerView);
-  #pragma omp parallel
+
+  // list the views to process them with a parallel for (instead of tasks over the map)
+  std::vector<MapFeaturesPerView::iterator> viewsFeatures;
+  viewsFeatures.reserve(_normalizedFeaturesPerView->getData().size());
   for(MapFeaturesPerView::iterator iter = _normalizedFeaturesPerView->getData().begin();
     iter != _normalizedFeaturesPerView->getData().end(); ++iter)
+    viewsFeatures.push_back(iter);
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < viewsFeatures.size(); ++i)
   {
-    #pragma omp single nowait
+    MapFeaturesPerView::iterator iter = viewsFeatures[i];
+
+    // get the related view & camera intrinsic and compute the corresponding bearing vectors
+    const View * view = _sfmData.getViews().at(iter->first).get();
+    const auto camIt = _sfmData.getIntrinsics().find(view->getIntrinsicId());
+    if(camIt == _sfmData.getIntrinsics().end())
+      continue;
+
+    const IntrinsicBase* cam = camIt->second.get();
+    for(auto& iterFeatPerDesc: iter->second)
     {
-      // get the related view & camera intrinsic and compute the corresponding bearing vectors
-      const View * view = _sfmData.getViews().at(iter->first).get();
-      if(_sfmData.getIntrinsics().count(view->getIntrinsicId()))
-      {
-        const std::shared_ptr<IntrinsicBase> cam = _sfmData.getIntrinsics().find(view->getIntrinsicId())->second;
-        for(auto& iterFeatPerDesc: iter->second)
-        {
-          for (PointFeatures::iterator iterPt = iterFeatPerDesc.second.begin();
-            iterPt != iterFeatPerDesc.second.end(); ++iterPt)
-          {
-            const Vec3 bearingVector = (*cam)(cam->get_ud_pixel(iterPt->coords().cast<double>()));
-            iterPt->coords() << (bearingVector.head(2) / bearingVector(2)).cast<float>();
-          }
-        }
-      }
+      PointFeatures& features = iterFeatPerDesc.second;
+
+      // undistort and compute the bearing vectors of all the features at once
+      Mat2X points(2, features.size());
+      for(std::size_t p = 0; p < features.size(); ++p)
+        points.col(p) = features[p].coords().cast<double>();
+
+      Mat3X bearingVectors;
+      cam->get_ud_pixel(points, points);
+      (*cam)(points, bearingVectors);
+
+      for(std::size_t p = 0; p < features.size(); ++p)
+        features[p].coords() << (bearingVectors.col(p).head<2>() / bearingVectors(2, p)).cast<float>();
     }
   }
 }
@@ -125,8 +139,12 @@ bool ReconstructionEngine_globalSfM::process()
     KeepOnlyReferencedElement(set_remainingIds, *_pairwiseMatches);
   }
 
+  _stagesTimes.clear();
+  system::Timer stageTimer;
+
   aliceVision::rotationAveraging::RelativeRotations relatives_R;
   Compute_Relative_Rotations(relatives_R);
+  addStageTime("Relative rotations", stageTimer);
 
   HashMap<IndexT, Mat3> global_rotations;
   if(!Compute_Global_Rotations(relatives_R, global_rotations))
@@ -134,22 +152,29 @@ bool ReconstructionEngine_globalSfM::process()
     ALICEVISION_LOG_WARNING("GlobalSfM:: Rotation Averaging failure!");
     return false;
   }
+  addStageTime("Global rotations", stageTimer);
+
   matching::PairwiseMatches tripletWise_matches;
   if(!Compute_Global_Translations(global_rotations, tripletWise_matches))
   {
     ALICEVISION_LOG_WARNING("GlobalSfM:: Translation Averaging failure!");
     return false;
   }
+  addStageTime("Global translations", stageTimer);
+
   if(!Compute_Initial_Structure(tripletWise_matches))
   {
     ALICEVISION_LOG_WARNING("GlobalSfM:: Cannot initialize an initial structure!");
     return false;
   }
+  addStageTime("Initial structure", stageTimer);
+
   if(!Adjust())
   {
     ALICEVISION_LOG_WARNING("GlobalSfM:: Non-linear adjustment failure!");
     return false;
   }
+  addStageTime("Bundle adjustment", stageTimer);
 
   //-- Export statistics about the SfM process
   if (!_loggingFile.empty())
@@ -167,12 +192,22 @@ bool ReconstructionEngine_globalSfM::process()
       << "-- Pose count: " << _sfmData.getPoses().size() << "<br>"
       << "-- Track count: "  << _sfmData.getLandmarks().size() << "<br>"
       << "-------------------------------" << "<br>";
+    for(const auto& stageTime : _stagesTimes)
+      os << "-- " << stageTime.first << ": " << stageTime.second << " s<br>";
     _htmlDocStream->pushInfo(os.str());
   }
 
   return true;
 }
 
+void ReconstructionEngine_globalSfM::addStageTime(const std::string& stageName, system::Timer& timer)
+{
+  const double elapsed = timer.elapsed();
+  ALICEVISION_LOG_INFO("GlobalSfM:: " << stageName << " took (s): " << elapsed);
+  _stagesTimes.emplace_back(stageName, elapsed);
+  timer.reset();
+}
+
 /// Compute from relative rotations the global rotations of the camera poses
 bool ReconstructionEngine_globalSfM::Compute_Global_Rotations(const rotationAveraging::RelativeRotations& relatives_R,
                                                               HashMap<IndexT, Mat3>& global_rotations)
@@ -455,42 +490,64 @@ void ReconstructionEngine_globalSfM::Compute_Relative_Rotations(rotationAveragin
     poseWiseMatches[Pair(v1->getPoseId(), v2->getPoseId())].insert(pair);
   }
 
-  boost::progress_display progressBar( poseWiseMatches.size(), std::cout, "\n- Relative pose computation -\n" );
+  // List the view pairs to process (one per relative pose)
+  std::vector<std::pair<Pair, Pair>> relativePosePairs; // (pose pair, view pair)
+  relativePosePairs.reserve(poseWiseMatches.size());
+  for(const auto& relativePoseIt: poseWiseMatches)
+  {
+    // If a pair has the same ID, discard it
+    if(relativePoseIt.first.first == relativePoseIt.first.second)
+      continue;
+
+    // Select common bearing vectors
+    if(relativePoseIt.second.size() > 1)
+    {
+      ALICEVISION_LOG_WARNING("Compute relative pose between more than two view is not supported");
+      continue;
+    }
+    relativePosePairs.emplace_back(relativePoseIt.first, *relativePoseIt.second.begin());
+  }
+
+  // Process the most expensive pairs (the ones with the most matches) first,
+  // so the dynamic scheduling keeps all the threads busy until the end
+  std::vector<std::size_t> processingOrder(relativePosePairs.size());
+  {
+    std::vector<std::size_t> nbMatchesPerPair(relativePosePairs.size());
+    for(std::size_t i = 0; i < relativePosePairs.size(); ++i)
+    {
+      processingOrder[i] = i;
+      nbMatchesPerPair[i] = _pairwiseMatches->at(relativePosePairs[i].second).getNbAllMatches();
+    }
+    std::stable_sort(processingOrder.begin(), processingOrder.end(), [&nbMatchesPerPair](std::size_t a, std::size_t b)
+    {
+      return nbMatchesPerPair[a] > nbMatchesPerPair[b];
+    });
+  }
+
+  // One result slot per pair: no synchronization needed to store the results
+  // and the output order does not depend on the threads scheduling
+  std::vector<rotationAveraging::RelativeRotation> relativeRotations(relativePosePairs.size());
+  std::vector<char> validRelativeRotations(relativePosePairs.size(), 0);
+
+  boost::progress_display progressBar( relativePosePairs.size(), std::cout, "\n- Relative pose computation -\n" );
   #pragma omp parallel for schedule(dynamic)
   // Compute the relative pose from pairwise point matches:
-  for (int i = 0; i < poseWiseMatches.size(); ++i)
+  for (int k = 0; k < relativePosePairs.size(); ++k)
   {
     #pragma omp critical
     {
       ++progressBar;
     }
     {
-      PoseWiseMatches::const_iterator iter (poseWiseMatches.begin());
-      std::advance(iter, i);
-      const auto& relative_pose_iterator(*iter);
-      const Pair relative_pose_pair = relative_pose_iterator.first;
-      const PairSet& match_pairs = relative_pose_iterator.second;
-
-      // If a pair has the same ID, discard it
-      if (relative_pose_pair.first == relative_pose_pair.second)
-      {
-        continue;
-      }
-
-      // Select common bearing vectors
-      if (match_pairs.size() > 1)
-      {
-        ALICEVISION_LOG_WARNING("Compute relative pose between more than two view is not supported");
-        continue;
-      }
-
-      const Pair pairIterator = *(match_pairs.begin());
+      const std::size_t i = processingOrder[k];
+      const Pair relative_pose_pair = relativePosePairs[i].first;
+      const Pair pairIterator = relativePosePairs[i].second;
 
       const IndexT I = pairIterator.first;
       const IndexT J = pairIterator.second;
 
-      const View* view_I = _sfmData.views[I].get();
-      const View* view_J = _sfmData.views[J].get();
+      const View* view_I = _sfmData.views.at(I).get();
+      const View* view_J = _sfmData.views.at(J).get();
 
       // Check that valid cameras are existing for the pair of view
       if (_sfmData.getIntrinsics().count(view_I->getIntrinsicId()) == 0 ||
@@ -509,10 +566,14 @@ void ReconstructionEngine_globalSfM::Compute_Relative_Rotations(rotationAveragin
         assert(descType != feature::EImageDescriberType::UNINITIALIZED);
         const matching::IndMatches & matches = matchesPerDescIt.second;
 
+        // retrieve the normalized features once per describer type
+        const feature::PointFeatures& normalizedFeatures_I = _normalizedFeaturesPerView->getFeatures(I, descType);
+        const feature::PointFeatures& normalizedFeatures_J = _normalizedFeaturesPerView->getFeatures(J, descType);
+
         for (const auto & match : matches)
         {
-          x1.col(iBearing) = _normalizedFeaturesPerView->getFeatures(I, descType)[match._i].coords().cast<double>();
-          x2.col(iBearing++) = _normalizedFeaturesPerView->getFeatures(J, descType)[match._j].coords().cast<double>();
+          x1.col(iBearing) = normalizedFeatures_I[match._i].coords().cast<double>();
+          x2.col(iBearing++) = normalizedFeatures_J[match._j].coords().cast<double>();
         }
       }
       assert(nbBearing == iBearing);
@@ -566,10 +627,14 @@ void ReconstructionEngine_globalSfM::Compute_Relative_Rotations(rotationAveragin
           if(descType == feature::EImageDescriberType::UNINITIALIZED)
             throw std::logic_error("descType UNINITIALIZED");
           const matching::IndMatches & matches = matchesPerDescIt.second;
+
+          const feature::PointFeatures& features_I = _featuresPerView->getFeatures(I, descType);
+          const feature::PointFeatures& features_J = _featuresPerView->getFeatures(J, descType);
+
           for (const matching::IndMatch& match: matches)
           {
-            const Vec2 x1_ = _featuresPerView->getFeatures(I, descType)[match._i].coords().cast<double>();
-            const Vec2 x2_ = _featuresPerView->getFeatures(J, descType)[match._j].coords().cast<double>();
+            const Vec2 x1_ = features_I[match._i].coords().cast<double>();
+            const Vec2 x2_ = features_J[match._j].coords().cast<double>();
             Vec3 X;
             TriangulateDLT(P1, x1_, P2, x2_, &X);
             Observations obs;
@@ -608,17 +673,22 @@ void ReconstructionEngine_globalSfM::Compute_Relative_Rotations(rotationAveragin
           relativePose_info.relativePose = Pose3(Rrel, -Rrel.transpose() * trel);
         }
       }
-      #pragma omp critical
-      {
-        // Add the relative rotation to the relative 'rotation' pose graph
-        using namespace aliceVision::rotationAveraging;
-          vec_relatives_R.emplace_back(
+
+      // Store the relative rotation of the relative 'rotation' pose graph
+      relativeRotations[i] = rotationAveraging::RelativeRotation(
             relative_pose_pair.first, relative_pose_pair.second,
             relativePose_info.relativePose.rotation(), relativePose_info.vec_inliers.size());
-      }
+      validRelativeRotations[i] = 1;
     }
   } // for all relative pose
 
+  // Add the relative rotations to the relative 'rotation' pose graph (in the pose pairs order)
+  for(std::size_t i = 0; i < relativeRotations.size(); ++i)
+  {
+    if(validRelativeRotations[i])
+      vec_relatives_R.push_back(relativeRotations[i]);
+  }
+
   // Re-weight rotation in [0,1]
   if (vec_relatives_R.size() > 1)
   {
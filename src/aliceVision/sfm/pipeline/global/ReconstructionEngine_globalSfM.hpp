@@ -10,9 +10,14 @@
 #include <aliceVision/sfm/pipeline/ReconstructionEngine.hpp>
 #include <aliceVision/sfm/pipeline/global/GlobalSfMRotationAveragingSolver.hpp>
 #include <aliceVision/sfm/pipeline/global/GlobalSfMTranslationAveragingSolver.hpp>
+#include <aliceVision/system/Timer.hpp>
 
 #include <dependencies/htmlDoc/htmlDoc.hpp>
 
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace aliceVision{
 namespace sfm{
 
@@ -36,6 +41,15 @@ public:
 
   virtual bool process();
 
+  /**
+   * @brief Get the computation time of each stage of the last process() call
+   * @return the (stage name, time in seconds) list, in the processing order
+   */
+  const std::vector<std::pair<std::string, double>>& getStagesTimes() const
+  {
+    return _stagesTimes;
+  }
+
 protected:
   /// Compute from relative rotations the global rotations of the camera poses
   bool Compute_Global_Rotations(const aliceVision::rotationAveraging::RelativeRotations& vec_relatives_R,
@@ -55,6 +69,9 @@ private:
   /// Compute relative rotations
   void Compute_Relative_Rotations(aliceVision::rotationAveraging::RelativeRotations& vec_relatives_R);
 
+  /// Log and store the time elapsed since the last stage, then restart the timer
+  void addStageTime(const std::string& stageName, system::Timer& timer);
+
   // Logger
   std::shared_ptr<htmlDocument::htmlDocumentStream> _htmlDocStream;
   std::string _loggingFile;
@@ -68,6 +85,9 @@ private:
   matching::PairwiseMatches* _pairwiseMatches;
 
   std::shared_ptr<feature::FeaturesPerView> _normalizedFeaturesPerView;
+
+  /// computation time of each stage (name, seconds)
+  std::vector<std::pair<std::string, double>> _stagesTimes;
 };
 
 } // namespace sfm
@@ -0,0 +1,788 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "binaryIO.hpp"
+#include <aliceVision/camera/camera.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+namespace {
+
+const char binaryMagic[8] = {'A', 'V', 'S', 'F', 'M', 'B', 'I', 'N'};
+const uint32_t binaryVersion = 1;
+
+/**
+ * @brief Sections of an SfMData binary file,
+ * the values must not be changed (unknown sections are ignored by the reader)
+ */
+enum class ESection : uint32_t
+{
+  FOLDERS = 1,
+  VIEWS = 2,
+  INTRINSICS = 3,
+  POSES = 4,
+  RIGS = 5,
+  STRUCTURE = 6,
+  STRUCTURE_OBSERVATIONS = 7,
+  CONTROL_POINTS = 8,
+  CONTROL_POINTS_OBSERVATIONS = 9,
+  POSES_UNCERTAINTY = 10,
+  LANDMARKS_UNCERTAINTY = 11
+};
+
+/// entry of the section directory
+struct SectionEntry
+{
+  uint32_t type = 0;
+  uint32_t reserved = 0;
+  uint64_t offset = 0;
+  uint64_t size = 0;
+};
+
+/**
+ * @brief Get the sections of the given SfMData parts
+ */
+std::vector<ESection> getSections(ESfMData partFlag)
+{
+  std::vector<ESection> sections = {ESection::FOLDERS};
+
+  if((partFlag & VIEWS) == VIEWS)
+    sections.push_back(ESection::VIEWS);
+  if((partFlag & INTRINSICS) == INTRINSICS)
+    sections.push_back(ESection::INTRINSICS);
+  if((partFlag & EXTRINSICS) == EXTRINSICS)
+  {
+    sections.push_back(ESection::POSES);
+    sections.push_back(ESection::RIGS);
+  }
+  if((partFlag & STRUCTURE) == STRUCTURE)
+  {
+    sections.push_back(ESection::STRUCTURE);
+    if((partFlag & OBSERVATIONS) == OBSERVATIONS)
+      sections.push_back(ESection::STRUCTURE_OBSERVATIONS);
+  }
+  if((partFlag & CONTROL_POINTS) == CONTROL_POINTS)
+  {
+    sections.push_back(ESection::CONTROL_POINTS);
+    sections.push_back(ESection::CONTROL_POINTS_OBSERVATIONS);
+  }
+  if((partFlag & POSES_UNCERTAINTY) == POSES_UNCERTAINTY)
+    sections.push_back(ESection::POSES_UNCERTAINTY);
+  if((partFlag & LANDMARKS_UNCERTAINTY) == LANDMARKS_UNCERTAINTY)
+    sections.push_back(ESection::LANDMARKS_UNCERTAINTY);
+
+  return sections;
+}
+
+/**
+ * @brief Binary content of a section
+ */
+class SectionWriter
+{
+public:
+  void clear() { _data.clear(); }
+  const std::string& data() const { return _data; }
+
+  template<typename T>
+  void write(const T& value)
+  {
+    _data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template<typename T>
+  void write(const std::vector<T>& values)
+  {
+    _data.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+  }
+
+  void writeString(const std::string& value)
+  {
+    write(static_cast<uint64_t>(value.size()));
+    _data.append(value);
+  }
+
+private:
+  std::string _data;
+};
+
+/**
+ * @brief Reader of the binary content of a section, with bounds checking
+ */
+class SectionReader
+{
+public:
+  SectionReader(const char* data, std::size_t size, const std::string& filename)
+    : _data(data)
+    , _size(size)
+    , _filename(filename)
+  {}
+
+  template<typename T>
+  T read()
+  {
+    T value;
+    check(1, sizeof(T));
+    std::memcpy(&value, _data + _pos, sizeof(T));
+    _pos += sizeof(T);
+    return value;
+  }
+
+  template<typename T>
+  void read(std::vector<T>& values, uint64_t size)
+  {
+    check(size, sizeof(T));
+    values.resize(size);
+    if(size > 0)
+      std::memcpy(values.data(), _data + _pos, size * sizeof(T));
+    _pos += size * sizeof(T);
+  }
+
+  std::string readString()
+  {
+    const uint64_t size = read<uint64_t>();
+    check(size, 1);
+    const std::string value(_data + _pos, size);
+    _pos += size;
+    return value;
+  }
+
+  [[noreturn]] void error(const std::string& message) const
+  {
+    throw std::runtime_error("Invalid SfMData binary file '" + _filename + "': " + message + ".");
+  }
+
+private:
+  void check(uint64_t count, std::size_t elementSize) const
+  {
+    if(count > (_size - _pos) / elementSize)
+      error("truncated section");
+  }
+
+  const char* _data;
+  std::size_t _size;
+  const std::string& _filename;
+  std::size_t _pos = 0;
+};
+
+void writeFolders(SectionWriter& section, const sfmData::SfMData& sfmData)
+{
+  section.write(static_cast<uint64_t>(sfmData.getRelativeFeaturesFolders().size()));
+  for(const std::string& folder : sfmData.getRelativeFeaturesFolders())
+    section.writeString(folder);
+
+  section.write(static_cast<uint64_t>(sfmData.getRelativeMatchesFolders().size()));
+  for(const std::string& folder : sfmData.getRelativeMatchesFolders())
+    section.writeString(folder);
+}
+
+void readFolders(SectionReader& section, sfmData::SfMData& sfmData)
+{
+  const uint64_t nbFeaturesFolders = section.read<uint64_t>();
+  for(uint64_t i = 0; i < nbFeaturesFolders; ++i)
+    sfmData.addFeaturesFolder(section.readString());
+
+  const uint64_t nbMatchesFolders = section.read<uint64_t>();
+  for(uint64_t i = 0; i < nbMatchesFolders; ++i)
+    sfmData.addMatchesFolder(section.readString());
+}
+
+void writeViews(SectionWriter& section, const sfmData::Views& views)
+{
+  std::vector<uint32_t> viewIds, poseIds, intrinsicIds, rigIds, subPoseIds, resectionIds;
+  std::vector<uint64_t> widths, heights;
+
+  for(const auto& viewPair : views)
+  {
+    const sfmData::View& view = *viewPair.second;
+    viewIds.push_back(view.getViewId());
+    poseIds.push_back(view.getPoseId());
+    intrinsicIds.push_back(view.getIntrinsicId());
+    rigIds.push_back(view.getRigId());
+    subPoseIds.push_back(view.getSubPoseId());
+    resectionIds.push_back(view.getResectionId());
+    widths.push_back(view.getWidth());
+    heights.push_back(view.getHeight());
+  }
+
+  section.write(static_cast<uint64_t>(views.size()));
+  section.write(viewIds);
+  section.write(poseIds);
+  section.write(intrinsicIds);
+  section.write(rigIds);
+  section.write(subPoseIds);
+  section.write(resectionIds);
+  section.write(widths);
+  section.write(heights);
+
+  for(const auto& viewPair : views)
+  {
+    const sfmData::View& view = *viewPair.second;
+    section.writeString(view.getImagePath());
+    section.write(static_cast<uint64_t>(view.getMetadata().size()));
+    for(const auto& metadataPair : view.getMetadata())
+    {
+      section.writeString(metadataPair.first);
+      section.writeString(metadataPair.second);
+    }
+  }
+}
+
+void readViews(SectionReader& section, sfmData::Views& views)
+{
+  std::vector<uint32_t> viewIds, poseIds, intrinsicIds, rigIds, subPoseIds, resectionIds;
+  std::vector<uint64_t> widths, heights;
+
+  const uint64_t nbViews = section.read<uint64_t>();
+  section.read(viewIds, nbViews);
+  section.read(poseIds, nbViews);
+  section.read(intrinsicIds, nbViews);
+  section.read(rigIds, nbViews);
+  section.read(subPoseIds, nbViews);
+  section.read(resectionIds, nbViews);
+  section.read(widths, nbViews);
+  section.read(heights, nbViews);
+
+  for(uint64_t i = 0; i < nbViews; ++i)
+  {
+    std::shared_ptr<sfmData::View> view = std::make_shared<sfmData::View>();
+    view->setViewId(viewIds[i]);
+    view->setPoseId(poseIds[i]);
+    view->setIntrinsicId(intrinsicIds[i]);
+    if(rigIds[i] != UndefinedIndexT)
+      view->setRigAndSubPoseId(rigIds[i], subPoseIds[i]);
+    view->setResectionId(resectionIds[i]);
+    view->setWidth(widths[i]);
+    view->setHeight(heights[i]);
+    view->setImagePath(section.readString());
+
+    const uint64_t nbMetadata = section.read<uint64_t>();
+    for(uint64_t m = 0; m < nbMetadata; ++m)
+    {
+      const std::string key = section.readString();
+      view->addMetadata(key, section.readString());
+    }
+
+    views.emplace(viewIds[i], view);
+  }
+}
+
+void writeIntrinsics(SectionWriter& section, const sfmData::Intrinsics& intrinsics)
+{
+  section.write(static_cast<uint64_t>(intrinsics.size()));
+
+  for(const auto& intrinsicPair : intrinsics)
+  {
+    const camera::IntrinsicBase& intrinsic = *intrinsicPair.second;
+    const camera::EINTRINSIC intrinsicType = intrinsic.getType();
+
+    // same restriction as the JSON file
+    if(!camera::isPinhole(intrinsicType))
+      throw std::out_of_range("Only Pinhole camera model supported");
+
+    const camera::Pinhole& pinholeIntrinsic = dynamic_cast<const camera::Pinhole&>(intrinsic);
+    const Vec2 principalPoint = pinholeIntrinsic.getPrincipalPoint();
+    const std::vector<double> distortionParams = pinholeIntrinsic.getDistortionParams();
+
+    section.write(static_cast<uint32_t>(intrinsicPair.first));
+    section.writeString(camera::EINTRINSIC_enumToString(intrinsicType));
+    section.write(static_cast<uint32_t>(intrinsic.w()));
+    section.write(static_cast<uint32_t>(intrinsic.h()));
+    section.writeString(intrinsic.serialNumber());
+    section.write(intrinsic.initialFocalLengthPix());
+    section.write(pinholeIntrinsic.getFocalLengthPix());
+    section.write(principalPoint(0));
+    section.write(principalPoint(1));
+    section.write(static_cast<uint64_t>(distortionParams.size()));
+    section.write(distortionParams);
+    section.write(static_cast<uint8_t>(intrinsic.isLocked() ? 1 : 0));
+  }
+}
+
+void readIntrinsics(SectionReader& section, sfmData::Intrinsics& intrinsics)
+{
+  const uint64_t nbIntrinsics = section.read<uint64_t>();
+
+  for(uint64_t i = 0; i < nbIntrinsics; ++i)
+  {
+    const IndexT intrinsicId = section.read<uint32_t>();
+    const camera::EINTRINSIC intrinsicType = camera::EINTRINSIC_stringToEnum(section.readString());
+    const unsigned int width = section.read<uint32_t>();
+    const unsigned int height = section.read<uint32_t>();
+    const std::string serialNumber = section.readString();
+    const double pxInitialFocalLength = section.read<double>();
+    const double pxFocalLength = section.read<double>();
+    const double ppx = section.read<double>();
+    const double ppy = section.read<double>();
+    std::vector<double> distortionParams;
+    section.read(distortionParams, section.read<uint64_t>());
+    const bool locked = (section.read<uint8_t>() != 0);
+
+    if(!camera::isPinhole(intrinsicType))
+      section.error("only Pinhole camera model supported");
+
+    std::shared_ptr<camera::Pinhole> pinholeIntrinsic = camera::createPinholeIntrinsic(intrinsicType, width, height, pxFocalLength, ppx, ppy);
+    pinholeIntrinsic->setInitialFocalLengthPix(pxInitialFocalLength);
+    pinholeIntrinsic->setSerialNumber(serialNumber);
+
+    // ensure that we have the right number of params
+    distortionParams.resize(pinholeIntrinsic->getDistortionParams().size(), 0.0);
+    pinholeIntrinsic->setDistortionParams(distortionParams);
+
+    if(locked)
+      pinholeIntrinsic->lock();
+    else
+      pinholeIntrinsic->unlock();
+
+    intrinsics.emplace(intrinsicId, std::static_pointer_cast<camera::IntrinsicBase>(pinholeIntrinsic));
+  }
+}
+
+void writePoses(SectionWriter& section, const sfmData::Poses& poses)
+{
+  std::vector<uint32_t> poseIds;
+  std::vector<double> rotations, centers;
+  std::vector<uint8_t> locked;
+
+  for(const auto& posePair : poses)
+  {
+    const geometry::Pose3& transform = posePair.second.getTransform();
+    poseIds.push_back(posePair.first);
+    rotations.insert(rotations.end(), transform.rotation().data(), transform.rotation().data() + 9);
+    centers.insert(centers.end(), transform.center().data(), transform.center().data() + 3);
+    locked.push_back(posePair.second.isLocked() ? 1 : 0);
+  }
+
+  section.write(static_cast<uint64_t>(poses.size()));
+  section.write(poseIds);
+  section.write(rotations);
+  section.write(centers);
+  section.write(locked);
+}
+
+void readPoses(SectionReader& section, sfmData::Poses& poses)
+{
+  std::vector<uint32_t> poseIds;
+  std::vector<double> rotations, centers;
+  std::vector<uint8_t> locked;
+
+  const uint64_t nbPoses = section.read<uint64_t>();
+  section.read(poseIds, nbPoses);
+  section.read(rotations, 9 * nbPoses);
+  section.read(centers, 3 * nbPoses);
+  section.read(locked, nbPoses);
+
+  for(uint64_t i = 0; i < nbPoses; ++i)
+  {
+    const geometry::Pose3 transform(Eigen::Map<const Mat3>(rotations.data() + 9 * i),
+                                    Eigen::Map<const Vec3>(centers.data() + 3 * i));
+    poses.emplace(poseIds[i], sfmData::CameraPose(transform, locked[i] != 0));
+  }
+}
+
+void writeRigs(SectionWriter& section, const sfmData::Rigs& rigs)
+{
+  section.write(static_cast<uint64_t>(rigs.size()));
+
+  for(const auto& rigPair : rigs)
+  {
+    section.write(static_cast<uint32_t>(rigPair.first));
+    section.write(static_cast<uint64_t>(rigPair.second.getSubPoses().size()));
+
+    for(const sfmData::RigSubPose& subPose : rigPair.second.getSubPoses())
+    {
+      section.write(static_cast<uint8_t>(subPose.status));
+      const Mat3 rotation = subPose.pose.rotation();
+      const Vec3 center = subPose.pose.center();
+      for(int i = 0; i < 9; ++i)
+        section.write(rotation(i));
+      for(int i = 0; i < 3; ++i)
+        section.write(center(i));
+    }
+  }
+}
+
+void readRigs(SectionReader& section, sfmData::Rigs& rigs)
+{
+  const uint64_t nbRigs = section.read<uint64_t>();
+
+  for(uint64_t r = 0; r < nbRigs; ++r)
+  {
+    const IndexT rigId = section.read<uint32_t>();
+    const uint64_t nbSubPoses = section.read<uint64_t>();
+    // a sub-pose takes 97 bytes
+    std::vector<uint8_t> subPosesData;
+    section.read(subPosesData, nbSubPoses * (1 + 12 * sizeof(double)));
+
+    sfmData::Rig rig(nbSubPoses);
+    const uint8_t* data = subPosesData.data();
+    for(uint64_t s = 0; s < nbSubPoses; ++s)
+    {
+      const uint8_t status = *data++;
+      if(status > static_cast<uint8_t>(sfmData::ERigSubPoseStatus::CONSTANT))
+        section.error("invalid rig sub-pose status");
+
+      Mat3 rotation;
+      Vec3 center;
+      std::memcpy(rotation.data(), data, 9 * sizeof(double));
+      data += 9 * sizeof(double);
+      std::memcpy(center.data(), data, 3 * sizeof(double));
+      data += 3 * sizeof(double);
+
+      rig.setSubPose(s, sfmData::RigSubPose(geometry::Pose3(rotation, center), static_cast<sfmData::ERigSubPoseStatus>(status)));
+    }
+
+    rigs.emplace(rigId, rig);
+  }
+}
+
+/**
+ * @brief Write the landmarks by columns, the describer types are stored in a table
+ */
+void writeLandmarks(SectionWriter& section, const sfmData::Landmarks& landmarks)
+{
+  std::vector<uint32_t> landmarkIds;
+  std::vector<double> positions;
+  std::vector<uint8_t> colors;
+  std::vector<uint8_t> descTypeIndexes;
+  std::map<feature::EImageDescriberType, uint8_t> descTypes;
+
+  landmarkIds.reserve(landmarks.size());
+  positions.reserve(3 * landmarks.size());
+  colors.reserve(3 * landmarks.size());
+  descTypeIndexes.reserve(landmarks.size());
+
+  for(const auto& landmarkPair : landmarks)
+  {
+    const sfmData::Landmark& landmark = landmarkPair.second;
+    landmarkIds.push_back(landmarkPair.first);
+    positions.insert(positions.end(), landmark.X.data(), landmark.X.data() + 3);
+    colors.push_back(landmark.rgb.r());
+    colors.push_back(landmark.rgb.g());
+    colors.push_back(landmark.rgb.b());
+
+    const auto descTypeIt = descTypes.emplace(landmark.descType, static_cast<uint8_t>(descTypes.size())).first;
+    descTypeIndexes.push_back(descTypeIt->second);
+  }
+
+  // the describer types, in the order of their index
+  std::vector<std::string> descTypeNames(descTypes.size());
+  for(const auto& descTypePair : descTypes)
+    descTypeNames[descTypePair.second] = feature::EImageDescriberType_enumToString(descTypePair.first);
+
+  section.write(static_cast<uint64_t>(landmarks.size()));
+  section.write(landmarkIds);
+  section.write(positions);
+  section.write(colors);
+  section.write(static_cast<uint64_t>(descTypeNames.size()));
+  for(const std::string& descTypeName : descTypeNames)
+    section.writeString(descTypeName);
+  section.write(descTypeIndexes);
+}
+
+/**
+ * @brief Write the observations of the landmarks in CSR form
+ */
+void writeObservations(SectionWriter& section, const sfmData::Landmarks& landmarks)
+{
+  std::vector<uint64_t> offsets;
+  std::vector<uint32_t> viewIds;
+  std::vector<uint32_t> featureIds;
+  std::vector<double> positions;
+
+  offsets.reserve(landmarks.size() + 1);
+  offsets.push_back(0);
+
+  for(const auto& landmarkPair : landmarks)
+  {
+    for(const auto& observationPair : landmarkPair.second.observations)
+    {
+      viewIds.push_back(observationPair.first);
+      featureIds.push_back(observationPair.second.id_feat);
+      positions.push_back(observationPair.second.x(0));
+      positions.push_back(observationPair.second.x(1));
+    }
+    offsets.push_back(viewIds.size());
+  }
+
+  section.write(static_cast<uint64_t>(landmarks.size()));
+  section.write(offsets);
+  section.write(viewIds);
+  section.write(featureIds);
+  section.write(positions);
+}
+
+/**
+ * @brief Read the landmarks and optionally their observations
+ * @param[in] landmarksSection the section of the landmarks
+ * @param[in] observationsSection the section of the observations, nullptr to skip the observations
+ */
+void readLandmarks(SectionReader& landmarksSection, SectionReader* observationsSection, sfmData::Landmarks& landmarks)
+{
+  std::vector<uint32_t> landmarkIds;
+  std::vector<double> positions;
+  std::vector<uint8_t> colors;
+  std::vector<uint8_t> descTypeIndexes;
+  std::vector<feature::EImageDescriberType> descTypes;
+
+  const uint64_t nbLandmarks = landmarksSection.read<uint64_t>();
+  landmarksSection.read(landmarkIds, nbLandmarks);
+  landmarksSection.read(positions, 3 * nbLandmarks);
+  landmarksSection.read(colors, 3 * nbLandmarks);
+  const uint64_t nbDescTypes = landmarksSection.read<uint64_t>();
+  for(uint64_t i = 0; i < nbDescTypes; ++i)
+    descTypes.push_back(feature::EImageDescriberType_stringToEnum(landmarksSection.readString()));
+  landmarksSection.read(descTypeIndexes, nbLandmarks);
+
+  std::vector<uint64_t> offsets;
+  std::vector<uint32_t> viewIds;
+  std::vector<uint32_t> featureIds;
+  std::vector<double> observationPositions;
+
+  if(observationsSection != nullptr)
+  {
+    if(observationsSection->read<uint64_t>() != nbLandmarks)
+      observationsSection->error("the observations do not match the landmarks");
+    observationsSection->read(offsets, nbLandmarks + 1);
+
+    const uint64_t nbObservations = offsets.back();
+    observationsSection->read(viewIds, nbObservations);
+    observationsSection->read(featureIds, nbObservations);
+    observationsSection->read(observationPositions, 2 * nbObservations);
+
+    for(uint64_t i = 0; i < nbLandmarks; ++i)
+    {
+      if(offsets[i] > offsets[i + 1])
+        observationsSection->error("invalid observation offsets");
+    }
+  }
+
+  for(uint64_t i = 0; i < nbLandmarks; ++i)
+  {
+    if(descTypeIndexes[i] >= descTypes.size())
+      landmarksSection.error("invalid describer type");
+
+    sfmData::Landmark landmark(Eigen::Map<const Vec3>(positions.data() + 3 * i), descTypes[descTypeIndexes[i]]);
+    landmark.rgb = image::RGBColor(colors[3 * i], colors[3 * i + 1], colors[3 * i + 2]);
+
+    if(observationsSection != nullptr)
+    {
+      landmark.observations.reserve(offsets[i + 1] - offsets[i]);
+      for(uint64_t o = offsets[i]; o < offsets[i + 1]; ++o)
+      {
+        // the observations are saved in increasing order
+        landmark.observations.emplace_hint(landmark.observations.end(), viewIds[o],
+                                           sfmData::Observation(Vec2(observationPositions[2 * o], observationPositions[2 * o + 1]), featureIds[o]));
+      }
+    }
+
+    // the landmarks are saved in increasing order
+    landmarks.emplace_hint(landmarks.end(), landmarkIds[i], std::move(landmark));
+  }
+}
+
+template<typename UncertaintyT>
+void writeUncertainty(SectionWriter& section, const HashMap<IndexT, UncertaintyT>& uncertainties)
+{
+  std::vector<uint32_t> ids;
+  std::vector<double> values;
+
+  for(const auto& uncertaintyPair : uncertainties)
+  {
+    ids.push_back(uncertaintyPair.first);
+    values.insert(values.end(), uncertaintyPair.second.data(), uncertaintyPair.second.data() + UncertaintyT::SizeAtCompileTime);
+  }
+
+  section.write(static_cast<uint64_t>(uncertainties.size()));
+  section.write(ids);
+  section.write(values);
+}
+
+template<typename UncertaintyT>
+void readUncertainty(SectionReader& section, HashMap<IndexT, UncertaintyT>& uncertainties)
+{
+  std::vector<uint32_t> ids;
+  std::vector<double> values;
+
+  const uint64_t size = section.read<uint64_t>();
+  section.read(ids, size);
+  section.read(values, UncertaintyT::SizeAtCompileTime * size);
+
+  for(uint64_t i = 0; i < size; ++i)
+    uncertainties.emplace(ids[i], Eigen::Map<const UncertaintyT>(values.data() + UncertaintyT::SizeAtCompileTime * i));
+}
+
+} // namespace
+
+bool saveBinary(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  std::ofstream stream(filename, std::ios::binary);
+  if(!stream.is_open())
+    throw std::runtime_error("Cannot open the file '" + filename + "' for writing.");
+
+  const std::vector<ESection> sections = getSections(partFlag);
+  std::vector<SectionEntry> directory(sections.size());
+
+  // header, the directory is written again at the end with the position of the sections
+  const uint32_t nbSections = sections.size();
+  stream.write(binaryMagic, sizeof(binaryMagic));
+  stream.write(reinterpret_cast<const char*>(&binaryVersion), sizeof(uint32_t));
+  stream.write(reinterpret_cast<const char*>(&nbSections), sizeof(uint32_t));
+  const std::streamoff directoryOffset = stream.tellp();
+  stream.write(reinterpret_cast<const char*>(directory.data()), directory.size() * sizeof(SectionEntry));
+
+  // sections
+  SectionWriter section;
+  for(std::size_t i = 0; i < sections.size(); ++i)
+  {
+    section.clear();
+    switch(sections[i])
+    {
+      case ESection::FOLDERS:                     writeFolders(section, sfmData); break;
+      case ESection::VIEWS:                       writeViews(section, sfmData.getViews()); break;
+      case ESection::INTRINSICS:                  writeIntrinsics(section, sfmData.getIntrinsics()); break;
+      case ESection::POSES:                       writePoses(section, sfmData.getPoses()); break;
+      case ESection::RIGS:                        writeRigs(section, sfmData.getRigs()); break;
+      case ESection::STRUCTURE:                   writeLandmarks(section, sfmData.getLandmarks()); break;
+      case ESection::STRUCTURE_OBSERVATIONS:      writeObservations(section, sfmData.getLandmarks()); break;
+      case ESection::CONTROL_POINTS:              writeLandmarks(section, sfmData.getControlPoints()); break;
+      case ESection::CONTROL_POINTS_OBSERVATIONS: writeObservations(section, sfmData.getControlPoints()); break;
+      case ESection::POSES_UNCERTAINTY:           writeUncertainty(section, sfmData._posesUncertainty); break;
+      case ESection::LANDMARKS_UNCERTAINTY:       writeUncertainty(section, sfmData._landmarksUncertainty); break;
+    }
+
+    directory[i].type = static_cast<uint32_t>(sections[i]);
+    directory[i].offset = stream.tellp();
+    directory[i].size = section.data().size();
+    stream.write(section.data().data(), section.data().size());
+  }
+
+  stream.seekp(directoryOffset);
+  stream.write(reinterpret_cast<const char*>(directory.data()), directory.size() * sizeof(SectionEntry));
+
+  if(!stream.good())
+    throw std::runtime_error("Failed to write the file '" + filename + "'.");
+
+  return true;
+}
+
+bool loadBinary(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  namespace bip = boost::interprocess;
+
+  // the file is mapped: only the pages of the requested sections are read from the disk
+  // and the sections are decoded in place, without an intermediate copy
+  bip::file_mapping file;
+  bip::mapped_region region;
+  try
+  {
+    file = bip::file_mapping(filename.c_str(), bip::read_only);
+    region = bip::mapped_region(file, bip::read_only);
+  }
+  catch(const bip::interprocess_exception& e)
+  {
+    throw std::runtime_error("Cannot open the file '" + filename + "': " + e.what());
+  }
+
+  const char* fileData = static_cast<const char*>(region.get_address());
+  const uint64_t fileSize = region.get_size();
+
+  const auto error = [&filename](const std::string& message)
+  {
+    throw std::runtime_error("Invalid SfMData binary file '" + filename + "': " + message + ".");
+  };
+
+  // header
+  const std::size_t headerSize = sizeof(binaryMagic) + 2 * sizeof(uint32_t);
+  if(fileSize < headerSize || std::memcmp(fileData, binaryMagic, sizeof(binaryMagic)) != 0)
+    error("not an SfMData binary file");
+
+  SectionReader header(fileData, fileSize, filename);
+  header.read<uint64_t>(); // magic, checked above
+  const uint32_t version = header.read<uint32_t>();
+  const uint32_t nbSections = header.read<uint32_t>();
+  if(version > binaryVersion)
+    error("unsupported version " + std::to_string(version));
+  if(nbSections > (fileSize - headerSize) / sizeof(SectionEntry))
+    error("truncated section directory");
+
+  std::vector<SectionEntry> directory;
+  header.read(directory, nbSections);
+
+  // find the directory entry of a section, nullptr if the file has no such section
+  const auto findSection = [&](ESection type) -> const SectionEntry*
+  {
+    for(const SectionEntry& entry : directory)
+    {
+      if(entry.type != static_cast<uint32_t>(type))
+        continue;
+      if(entry.offset > fileSize || entry.size > fileSize - entry.offset)
+        error("truncated file");
+      return &entry;
+    }
+    return nullptr;
+  };
+
+  const std::vector<ESection> sections = getSections(partFlag);
+  const auto isRequested = [&sections](ESection type)
+  {
+    return std::find(sections.begin(), sections.end(), type) != sections.end();
+  };
+
+  for(ESection type : sections)
+  {
+    // the observations are read with their landmarks
+    if(type == ESection::STRUCTURE_OBSERVATIONS || type == ESection::CONTROL_POINTS_OBSERVATIONS)
+      continue;
+
+    const SectionEntry* entry = findSection(type);
+    if(entry == nullptr)
+      continue;
+
+    SectionReader section(fileData + entry->offset, entry->size, filename);
+    switch(type)
+    {
+      case ESection::FOLDERS:               readFolders(section, sfmData); break;
+      case ESection::VIEWS:                 readViews(section, sfmData.getViews()); break;
+      case ESection::INTRINSICS:            readIntrinsics(section, sfmData.getIntrinsics()); break;
+      case ESection::POSES:                 readPoses(section, sfmData.getPoses()); break;
+      case ESection::RIGS:                  readRigs(section, sfmData.getRigs()); break;
+      case ESection::POSES_UNCERTAINTY:     readUncertainty(section, sfmData._posesUncertainty); break;
+      case ESection::LANDMARKS_UNCERTAINTY: readUncertainty(section, sfmData._landmarksUncertainty); break;
+      case ESection::STRUCTURE:
+      case ESection::CONTROL_POINTS:
+      {
+        const bool isStructure = (type == ESection::STRUCTURE);
+        const ESection observationsType = isStructure ? ESection::STRUCTURE_OBSERVATIONS : ESection::CONTROL_POINTS_OBSERVATIONS;
+        const SectionEntry* observationsEntry = isRequested(observationsType) ? findSection(observationsType) : nullptr;
+        const bool hasObservations = (observationsEntry != nullptr);
+        SectionReader observationsSection(hasObservations ? fileData + observationsEntry->offset : nullptr,
+                                          hasObservations ? observationsEntry->size : 0, filename);
+        readLandmarks(section, hasObservations ? &observationsSection : nullptr,
+                      isStructure ? sfmData.getLandmarks() : sfmData.getControlPoints());
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  return true;
+}
+
+} // namespace sfmDataIO
+} // namespace aliceVision
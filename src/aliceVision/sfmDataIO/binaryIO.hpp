@@ -0,0 +1,46 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+
+#include <string>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+/**
+ * @brief Save an SfMData in a binary file (.sfmb).
+ *
+ * The file starts with a versioned header and a directory of sections, one section per part
+ * of the SfMData (views, intrinsics, poses, rigs, landmarks, observations, control points,
+ * uncertainties), so that each part can be loaded without reading the others.
+ * The landmarks and the poses are stored by columns (ids, positions, colors...) and the
+ * observations in CSR form (offset of the observations of each landmark, view ids,
+ * feature ids and positions).
+ * The values are stored in the byte order of the machine.
+ * @param[in] sfmData The input SfMData
+ * @param[in] filename The filename
+ * @param[in] partFlag The ESfMData save flag
+ * @return true if completed
+ * @throw std::runtime_error if the file cannot be written
+ */
+bool saveBinary(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag);
+
+/**
+ * @brief Load an SfMData from a binary file (.sfmb).
+ * The file is mapped in memory and only the sections of the requested parts are decoded.
+ * @param[out] sfmData The output SfMData
+ * @param[in] filename The filename
+ * @param[in] partFlag The ESfMData load flag
+ * @return true if completed
+ * @throw std::runtime_error if the file cannot be read or is not a valid SfMData binary file
+ */
+bool loadBinary(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag);
+
+} // namespace sfmDataIO
+} // namespace aliceVision
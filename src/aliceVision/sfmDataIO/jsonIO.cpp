@@ -383,6 +383,17 @@ bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfM
 }
 
 bool loadJSON(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag, bool incompleteViews)
+{
+  // main tree
+  bpt::ptree fileTree;
+
+  // read the json file and initialize the tree
+  bpt::read_json(filename, fileTree);
+
+  return loadJSONTree(sfmData, fileTree, partFlag, incompleteViews);
+}
+
+bool loadJSONTree(sfmData::SfMData& sfmData, bpt::ptree& fileTree, ESfMData partFlag, bool incompleteViews)
 {
   Vec3 version;
 
@@ -393,12 +404,6 @@ bool loadJSON(sfmData::SfMData& sfmData, const std::string& filename, ESfMData p
   const bool loadStructure = (partFlag & STRUCTURE) == STRUCTURE;
   const bool loadControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
 
-  // main tree
-  bpt::ptree fileTree;
-
-  // read the json file and initialize the tree
-  bpt::read_json(filename, fileTree);
-
   // version
   loadMatrix("version", version, fileTree);
 
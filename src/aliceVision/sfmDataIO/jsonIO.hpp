@@ -123,7 +123,7 @@ inline void loadCameraPose(const std::string& name, sfmData::CameraPose& cameraP
   loadPose3(name + ".transform", pose, cameraPoseTree);
   cameraPose.setTransform(pose);
 
-  if(cameraPoseTree.get<bool>("locked", false))
+  if(cameraPoseTree.get<bool>(name + ".locked", false))
     cameraPose.lock();
   else
     cameraPose.unlock();
@@ -214,5 +214,15 @@ bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfM
  */
 bool loadJSON(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag, bool incompleteViews = false);
 
+/**
+ * @brief Load an SfMData from the property tree of a JSON SfMData file.
+ * @param[out] sfmData The output SfMData
+ * @param[in,out] fileTree The tree of the file
+ * @param[in] partFlag The ESfMData load flag
+ * @param[in] incompleteViews If true, try to load incomplete views
+ * @return true if completed
+ */
+bool loadJSONTree(sfmData::SfMData& sfmData, bpt::ptree& fileTree, ESfMData partFlag, bool incompleteViews = false);
+
 } // namespace sfmDataIO
 } // namespace aliceVision
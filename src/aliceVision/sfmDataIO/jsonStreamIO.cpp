@@ -0,0 +1,1015 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "jsonStreamIO.hpp"
+#include <aliceVision/sfmDataIO/jsonIO.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+namespace {
+
+/// size of the read buffer and size of the write buffer before a flush
+const std::size_t streamBufferSize = 1 << 20;
+
+/// number of landmarks formatted by a thread at once
+const std::size_t landmarkChunkSize = 1024;
+
+// writing: the values are formatted like boost::property_tree::write_json,
+// all the values are strings and the indentation is 4 spaces per level
+
+void appendIndent(std::string& out, int indent)
+{
+  out.append(4 * indent, ' ');
+}
+
+void appendString(std::string& out, const std::string& value)
+{
+  static const char* hexdigits = "0123456789ABCDEF";
+
+  out += '"';
+  for(const char ch : value)
+  {
+    const unsigned char c = static_cast<unsigned char>(ch);
+    if(c == 0x20 || c == 0x21 || (c >= 0x23 && c <= 0x2E) ||
+       (c >= 0x30 && c <= 0x5B) || c >= 0x5D)
+      out += ch;
+    else if(ch == '\b') out += "\\b";
+    else if(ch == '\f') out += "\\f";
+    else if(ch == '\n') out += "\\n";
+    else if(ch == '\r') out += "\\r";
+    else if(ch == '\t') out += "\\t";
+    else if(ch == '/')  out += "\\/";
+    else if(ch == '"')  out += "\\\"";
+    else if(ch == '\\') out += "\\\\";
+    else
+    {
+      out += "\\u00";
+      out += hexdigits[c / 16];
+      out += hexdigits[c % 16];
+    }
+  }
+  out += '"';
+}
+
+void appendValue(std::string& out, const std::string& value)
+{
+  appendString(out, value);
+}
+
+void appendValue(std::string& out, double value)
+{
+  char buffer[32];
+  const int size = std::snprintf(buffer, sizeof(buffer), "\"%.*g\"", std::numeric_limits<double>::max_digits10, value);
+  out.append(buffer, size);
+}
+
+void appendValue(std::string& out, float value)
+{
+  char buffer[32];
+  const int size = std::snprintf(buffer, sizeof(buffer), "\"%.*g\"", std::numeric_limits<float>::max_digits10, value);
+  out.append(buffer, size);
+}
+
+void appendValue(std::string& out, unsigned int value)
+{
+  char buffer[16];
+  const int size = std::snprintf(buffer, sizeof(buffer), "\"%u\"", value);
+  out.append(buffer, size);
+}
+
+void appendValue(std::string& out, unsigned char value)
+{
+  appendValue(out, static_cast<unsigned int>(value));
+}
+
+/// append the key of an object member at the given indentation
+void appendKey(std::string& out, const char* key, int indent)
+{
+  appendIndent(out, indent);
+  out += '"';
+  out += key;
+  out += "\": ";
+}
+
+template<typename Derived>
+void appendMatrix(std::string& out, const Eigen::MatrixBase<Derived>& matrix, int indent)
+{
+  const int size = matrix.size();
+  if(size == 0)
+  {
+    out += "\"\"";
+    return;
+  }
+
+  out += "[\n";
+  for(int i = 0; i < size; ++i)
+  {
+    appendIndent(out, indent + 1);
+    appendValue(out, matrix(i));
+    if(i + 1 != size)
+      out += ',';
+    out += '\n';
+  }
+  appendIndent(out, indent);
+  out += ']';
+}
+
+/// same output as write_json for a tree that is not the root
+void appendTree(std::string& out, const bpt::ptree& tree, int indent)
+{
+  if(tree.empty())
+  {
+    appendString(out, tree.data());
+    return;
+  }
+
+  const bool isArray = (tree.count(std::string()) == tree.size());
+  out += isArray ? "[\n" : "{\n";
+  for(bpt::ptree::const_iterator it = tree.begin(); it != tree.end(); ++it)
+  {
+    appendIndent(out, indent + 1);
+    if(!isArray)
+    {
+      appendString(out, it->first);
+      out += ": ";
+    }
+    appendTree(out, it->second, indent + 1);
+    if(std::next(it) != tree.end())
+      out += ',';
+    out += '\n';
+  }
+  appendIndent(out, indent);
+  out += isArray ? ']' : '}';
+}
+
+/// same output as saveLandmark
+void appendLandmark(std::string& out, IndexT landmarkId, const sfmData::Landmark& landmark, int indent)
+{
+  out += "{\n";
+  appendKey(out, "landmarkId", indent + 1);
+  appendValue(out, landmarkId);
+  out += ",\n";
+  appendKey(out, "descType", indent + 1);
+  appendValue(out, feature::EImageDescriberType_enumToString(landmark.descType));
+  out += ",\n";
+  appendKey(out, "color", indent + 1);
+  appendMatrix(out, landmark.rgb, indent + 1);
+  out += ",\n";
+  appendKey(out, "X", indent + 1);
+  appendMatrix(out, landmark.X, indent + 1);
+  out += ",\n";
+  appendKey(out, "observations", indent + 1);
+
+  if(landmark.observations.empty())
+  {
+    out += "\"\"";
+  }
+  else
+  {
+    out += "[\n";
+    std::size_t i = 0;
+    for(const auto& obsPair : landmark.observations)
+    {
+      appendIndent(out, indent + 2);
+      out += "{\n";
+      appendKey(out, "observationId", indent + 3);
+      appendValue(out, obsPair.first);
+      out += ",\n";
+      appendKey(out, "featureId", indent + 3);
+      appendValue(out, obsPair.second.id_feat);
+      out += ",\n";
+      appendKey(out, "x", indent + 3);
+      appendMatrix(out, obsPair.second.x, indent + 3);
+      out += '\n';
+      appendIndent(out, indent + 2);
+      out += '}';
+      if(++i != landmark.observations.size())
+        out += ',';
+      out += '\n';
+    }
+    appendIndent(out, indent + 1);
+    out += ']';
+  }
+
+  out += '\n';
+  appendIndent(out, indent);
+  out += '}';
+}
+
+/**
+ * @brief Buffered writer of a JSON file
+ */
+class JsonFileWriter
+{
+public:
+  explicit JsonFileWriter(const std::string& filename)
+    : _filename(filename)
+    , _stream(filename)
+  {
+    if(!_stream.is_open())
+      throw std::runtime_error("Cannot open the file '" + filename + "' for writing.");
+    _buffer.reserve(2 * streamBufferSize);
+  }
+
+  std::string& buffer() { return _buffer; }
+
+  /// write the buffer if it is full
+  void flushIfFull()
+  {
+    if(_buffer.size() >= streamBufferSize)
+      flush();
+  }
+
+  void flush()
+  {
+    _stream.write(_buffer.data(), _buffer.size());
+    _buffer.clear();
+    if(!_stream.good())
+      throw std::runtime_error("Failed to write the file '" + _filename + "'.");
+  }
+
+private:
+  std::string _filename;
+  std::ofstream _stream;
+  std::string _buffer;
+};
+
+/**
+ * @brief Write the elements of a container in an array, one element at a time
+ * @param[in] appendElement function appending an element to the output at the given indentation
+ */
+template<typename Container, typename AppendElement>
+void writeArray(JsonFileWriter& writer, const Container& container, int indent, AppendElement appendElement)
+{
+  std::string& out = writer.buffer();
+  out += "[\n";
+  std::size_t i = 0;
+  for(const auto& element : container)
+  {
+    appendIndent(out, indent + 1);
+    appendElement(out, element, indent + 1);
+    if(++i != container.size())
+      out += ',';
+    out += '\n';
+    writer.flushIfFull();
+  }
+  appendIndent(out, indent);
+  out += ']';
+}
+
+/**
+ * @brief Write the landmarks in an array, the landmarks are formatted by chunks in parallel
+ * and written in order
+ */
+void writeLandmarks(JsonFileWriter& writer, const sfmData::Landmarks& landmarks, int indent)
+{
+  const std::size_t nbChunks = 4 * omp_get_max_threads();
+  const std::size_t batchSize = nbChunks * landmarkChunkSize;
+
+  std::vector<const sfmData::Landmarks::value_type*> batch;
+  batch.reserve(batchSize);
+  std::vector<std::string> chunks(nbChunks);
+
+  writer.buffer() += "[\n";
+
+  std::size_t nbFormatted = 0;
+  sfmData::Landmarks::const_iterator landmarkIt = landmarks.begin();
+  while(landmarkIt != landmarks.end())
+  {
+    batch.clear();
+    for(; landmarkIt != landmarks.end() && batch.size() < batchSize; ++landmarkIt)
+      batch.push_back(&(*landmarkIt));
+
+    const int nbBatchChunks = (batch.size() + landmarkChunkSize - 1) / landmarkChunkSize;
+
+    #pragma omp parallel for
+    for(int c = 0; c < nbBatchChunks; ++c)
+    {
+      std::string& chunk = chunks[c];
+      chunk.clear();
+      const std::size_t end = std::min(batch.size(), (c + 1) * landmarkChunkSize);
+      for(std::size_t i = c * landmarkChunkSize; i < end; ++i)
+      {
+        appendIndent(chunk, indent + 1);
+        appendLandmark(chunk, batch[i]->first, batch[i]->second, indent + 1);
+        if(nbFormatted + i + 1 != landmarks.size())
+          chunk += ',';
+        chunk += '\n';
+      }
+    }
+
+    for(int c = 0; c < nbBatchChunks; ++c)
+    {
+      writer.buffer() += chunks[c];
+      writer.flushIfFull();
+    }
+    nbFormatted += batch.size();
+  }
+
+  appendIndent(writer.buffer(), indent);
+  writer.buffer() += ']';
+}
+
+/**
+ * @brief Pull parser of a JSON stream
+ *
+ * The values are read one at a time: the caller walks through the objects and arrays
+ * and reads the values it needs, the other values are skipped.
+ * Like boost::property_tree::read_json, the literals (numbers, true, false, null)
+ * are read as their text.
+ */
+class JsonStreamReader
+{
+public:
+  JsonStreamReader(std::istream& stream, const std::string& filename)
+    : _stream(stream)
+    , _filename(filename)
+    , _buffer(streamBufferSize)
+  {}
+
+  /// skip the whitespaces and get the next character without consuming it, 0 at the end of the stream
+  char peek()
+  {
+    while(true)
+    {
+      if(_pos == _size && !fill())
+        return '\0';
+      const char c = _buffer[_pos];
+      if(c != ' ' && c != '\n' && c != '\r' && c != '\t')
+        return c;
+      ++_pos;
+    }
+  }
+
+  void beginObject()
+  {
+    expect('{');
+    _first.push_back(true);
+  }
+
+  /**
+   * @brief Read the key of the next member of the current object
+   * @return false at the end of the object
+   */
+  bool nextMember(std::string& key)
+  {
+    if(peek() == '}')
+    {
+      ++_pos;
+      _first.pop_back();
+      return false;
+    }
+    if(!_first.back())
+      expect(',');
+    _first.back() = false;
+    if(peek() != '"')
+      error("expected a key");
+    readString(key);
+    expect(':');
+    return true;
+  }
+
+  void beginArray()
+  {
+    expect('[');
+    _first.push_back(true);
+  }
+
+  /**
+   * @brief Move to the next element of the current array
+   * @return false at the end of the array
+   */
+  bool nextElement()
+  {
+    if(peek() == ']')
+    {
+      ++_pos;
+      _first.pop_back();
+      return false;
+    }
+    if(!_first.back())
+      expect(',');
+    _first.back() = false;
+    return true;
+  }
+
+  /**
+   * @brief Begin an array, boost::property_tree::write_json writes the empty arrays as empty strings
+   * @return false if the array is empty (no need to call nextElement)
+   */
+  bool beginArrayOrEmpty()
+  {
+    if(peek() == '[')
+    {
+      beginArray();
+      return true;
+    }
+    readScalar(_scalar);
+    if(!_scalar.empty())
+      error("expected an array");
+    return false;
+  }
+
+  /// read a string or a literal
+  void readScalar(std::string& value)
+  {
+    const char c = peek();
+    if(c == '"')
+      readString(value);
+    else if(c == '{' || c == '[')
+      error("expected a value");
+    else
+      readLiteral(value);
+  }
+
+  void readValue(std::string& value)
+  {
+    readScalar(value);
+  }
+
+  void readValue(double& value)
+  {
+    readScalar(_scalar);
+    const char* begin = _scalar.c_str();
+    char* end = nullptr;
+    value = std::strtod(begin, &end);
+    if(end == begin || *end != '\0')
+      error("invalid number '" + _scalar + "'");
+  }
+
+  void readValue(unsigned int& value)
+  {
+    value = readUnsigned(std::numeric_limits<unsigned int>::max());
+  }
+
+  void readValue(unsigned char& value)
+  {
+    value = static_cast<unsigned char>(readUnsigned(std::numeric_limits<unsigned char>::max()));
+  }
+
+  /// read a value in a property tree, like boost::property_tree::read_json
+  void readTree(bpt::ptree& tree)
+  {
+    const char c = peek();
+    if(c == '{')
+    {
+      std::string key;
+      beginObject();
+      while(nextMember(key))
+      {
+        bpt::ptree::iterator it = tree.push_back(bpt::ptree::value_type(key, bpt::ptree()));
+        readTree(it->second);
+      }
+    }
+    else if(c == '[')
+    {
+      beginArray();
+      while(nextElement())
+      {
+        bpt::ptree::iterator it = tree.push_back(bpt::ptree::value_type(std::string(), bpt::ptree()));
+        readTree(it->second);
+      }
+    }
+    else
+    {
+      readScalar(tree.data());
+    }
+  }
+
+  /// skip the next value
+  void skipValue()
+  {
+    const char c = peek();
+    if(c == '{')
+    {
+      beginObject();
+      while(nextMember(_scalar))
+        skipValue();
+    }
+    else if(c == '[')
+    {
+      beginArray();
+      while(nextElement())
+        skipValue();
+    }
+    else
+    {
+      readScalar(_scalar);
+    }
+  }
+
+  /// check that there is nothing after the root value
+  void end()
+  {
+    if(peek() != '\0')
+      error("unexpected data after the root value");
+  }
+
+  [[noreturn]] void error(const std::string& message) const
+  {
+    throw std::runtime_error("Invalid JSON file '" + _filename + "' at byte " + std::to_string(_offset + _pos) + ": " + message + ".");
+  }
+
+private:
+  bool fill()
+  {
+    _offset += _size;
+    _pos = 0;
+    _size = 0;
+    if(_stream.bad())
+      error("read error");
+    _stream.read(_buffer.data(), _buffer.size());
+    _size = _stream.gcount();
+    return _size > 0;
+  }
+
+  /// get the next character, including the whitespaces
+  char get()
+  {
+    if(_pos == _size && !fill())
+      error("unexpected end of file");
+    return _buffer[_pos++];
+  }
+
+  void expect(char c)
+  {
+    peek();
+    if(get() != c)
+    {
+      --_pos;
+      error(std::string("expected '") + c + "'");
+    }
+  }
+
+  unsigned long readUnsigned(unsigned long max)
+  {
+    readScalar(_scalar);
+    const char* begin = _scalar.c_str();
+    char* end = nullptr;
+    errno = 0;
+    const unsigned long value = std::strtoul(begin, &end, 10);
+    if(end == begin || *end != '\0' || _scalar[0] == '-' || errno == ERANGE || value > max)
+      error("invalid integer '" + _scalar + "'");
+    return value;
+  }
+
+  void readString(std::string& value)
+  {
+    expect('"');
+    value.clear();
+    while(true)
+    {
+      if(_pos == _size && !fill())
+        error("unterminated string");
+
+      // copy the characters until the end of the string or an escape sequence
+      const char* begin = _buffer.data() + _pos;
+      const char* end = _buffer.data() + _size;
+      const char* it = begin;
+      while(it != end && *it != '"' && *it != '\\')
+        ++it;
+      value.append(begin, it);
+      _pos += it - begin;
+      if(it == end)
+        continue;
+
+      ++_pos;
+      if(*it == '"')
+        return;
+
+      const char escape = get();
+      switch(escape)
+      {
+        case '"':  value += '"';  break;
+        case '\\': value += '\\'; break;
+        case '/':  value += '/';  break;
+        case 'b':  value += '\b'; break;
+        case 'f':  value += '\f'; break;
+        case 'n':  value += '\n'; break;
+        case 'r':  value += '\r'; break;
+        case 't':  value += '\t'; break;
+        case 'u':  appendCodepoint(value, readCodepoint()); break;
+        default:   error("invalid escape sequence");
+      }
+    }
+  }
+
+  unsigned int readHex()
+  {
+    unsigned int value = 0;
+    for(int i = 0; i < 4; ++i)
+    {
+      const char c = get();
+      value *= 16;
+      if(c >= '0' && c <= '9')
+        value += c - '0';
+      else if(c >= 'a' && c <= 'f')
+        value += c - 'a' + 10;
+      else if(c >= 'A' && c <= 'F')
+        value += c - 'A' + 10;
+      else
+        error("invalid unicode escape sequence");
+    }
+    return value;
+  }
+
+  /// read the code point of a \u escape sequence (after the 'u'), with its low surrogate if any
+  unsigned int readCodepoint()
+  {
+    const unsigned int codepoint = readHex();
+    if(codepoint < 0xD800 || codepoint > 0xDFFF)
+      return codepoint;
+    if(codepoint > 0xDBFF || get() != '\\' || get() != 'u')
+      error("invalid surrogate pair");
+    const unsigned int low = readHex();
+    if(low < 0xDC00 || low > 0xDFFF)
+      error("invalid surrogate pair");
+    return 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+  }
+
+  /// append a code point in UTF-8
+  static void appendCodepoint(std::string& value, unsigned int codepoint)
+  {
+    if(codepoint < 0x80)
+    {
+      value += static_cast<char>(codepoint);
+    }
+    else if(codepoint < 0x800)
+    {
+      value += static_cast<char>(0xC0 | (codepoint >> 6));
+      value += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+    else if(codepoint < 0x10000)
+    {
+      value += static_cast<char>(0xE0 | (codepoint >> 12));
+      value += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+      value += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+    else
+    {
+      value += static_cast<char>(0xF0 | (codepoint >> 18));
+      value += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+      value += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+      value += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+  }
+
+  /// read a number, true, false or null as text
+  void readLiteral(std::string& value)
+  {
+    value.clear();
+    while(true)
+    {
+      if(_pos == _size && !fill())
+        break;
+      const char c = _buffer[_pos];
+      if(!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           c == '-' || c == '+' || c == '.'))
+        break;
+      value += c;
+      ++_pos;
+    }
+    if(value.empty())
+      error("expected a value");
+  }
+
+  std::istream& _stream;
+  std::string _filename;
+  std::vector<char> _buffer;
+  /// position of the next character in the buffer
+  std::size_t _pos = 0;
+  /// number of characters in the buffer
+  std::size_t _size = 0;
+  /// position of the buffer in the stream
+  std::size_t _offset = 0;
+  /// for each opened object or array, true before its first member or element
+  std::vector<bool> _first;
+  /// reused storage of the scalars
+  std::string _scalar;
+};
+
+template<typename Derived>
+void readMatrix(JsonStreamReader& reader, const std::string& name, Eigen::MatrixBase<Derived>& matrix)
+{
+  const int size = matrix.size();
+  int i = 0;
+
+  if(reader.beginArrayOrEmpty())
+  {
+    while(reader.nextElement())
+    {
+      if(i >= size)
+        reader.error("invalid matrix / vector size for: " + name);
+      reader.readValue(matrix(i));
+      ++i;
+    }
+  }
+
+  if(i != size)
+    reader.error("invalid matrix / vector size for: " + name);
+}
+
+/// same as loadLandmark for an observation
+void readObservation(JsonStreamReader& reader, IndexT& observationId, sfmData::Observation& observation)
+{
+  bool hasObservationId = false;
+  bool hasFeatureId = false;
+  bool hasX = false;
+  std::string key;
+
+  reader.beginObject();
+  while(reader.nextMember(key))
+  {
+    if(key == "observationId")
+    {
+      reader.readValue(observationId);
+      hasObservationId = true;
+    }
+    else if(key == "featureId")
+    {
+      reader.readValue(observation.id_feat);
+      hasFeatureId = true;
+    }
+    else if(key == "x")
+    {
+      readMatrix(reader, key, observation.x);
+      hasX = true;
+    }
+    else
+    {
+      reader.skipValue();
+    }
+  }
+
+  if(!hasObservationId || !hasFeatureId || !hasX)
+    reader.error("incomplete observation");
+}
+
+/// same as loadLandmark
+void readLandmark(JsonStreamReader& reader, IndexT& landmarkId, sfmData::Landmark& landmark)
+{
+  bool hasLandmarkId = false;
+  bool hasDescType = false;
+  bool hasColor = false;
+  bool hasX = false;
+  bool hasObservations = false;
+  std::string key;
+
+  reader.beginObject();
+  while(reader.nextMember(key))
+  {
+    if(key == "landmarkId")
+    {
+      reader.readValue(landmarkId);
+      hasLandmarkId = true;
+    }
+    else if(key == "descType")
+    {
+      std::string descType;
+      reader.readValue(descType);
+      landmark.descType = feature::EImageDescriberType_stringToEnum(descType);
+      hasDescType = true;
+    }
+    else if(key == "color")
+    {
+      readMatrix(reader, key, landmark.rgb);
+      hasColor = true;
+    }
+    else if(key == "X")
+    {
+      readMatrix(reader, key, landmark.X);
+      hasX = true;
+    }
+    else if(key == "observations")
+    {
+      if(reader.beginArrayOrEmpty())
+      {
+        while(reader.nextElement())
+        {
+          IndexT observationId;
+          sfmData::Observation observation;
+          readObservation(reader, observationId, observation);
+          // the observations are saved in increasing order
+          landmark.observations.emplace_hint(landmark.observations.end(), observationId, observation);
+        }
+      }
+      hasObservations = true;
+    }
+    else
+    {
+      reader.skipValue();
+    }
+  }
+
+  if(!hasLandmarkId || !hasDescType || !hasColor || !hasX || !hasObservations)
+    reader.error("incomplete landmark");
+}
+
+void readLandmarks(JsonStreamReader& reader, sfmData::Landmarks& landmarks)
+{
+  if(!reader.beginArrayOrEmpty())
+    return;
+
+  while(reader.nextElement())
+  {
+    IndexT landmarkId;
+    sfmData::Landmark landmark;
+    readLandmark(reader, landmarkId, landmark);
+    // the landmarks are saved in increasing order
+    landmarks.emplace_hint(landmarks.end(), landmarkId, std::move(landmark));
+  }
+}
+
+} // namespace
+
+bool saveJSONStream(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  const Vec3 version = {1, 0, 0};
+
+  // save flags
+  const bool saveViews = (partFlag & VIEWS) == VIEWS;
+  const bool saveIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
+  const bool saveExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
+  const bool saveStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool saveControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
+
+  JsonFileWriter writer(filename);
+  std::string& out = writer.buffer();
+
+  // the members of the root object, in the order of saveJSON
+  bool firstMember = true;
+  const auto beginMember = [&](const char* key)
+  {
+    if(!firstMember)
+      out += ",\n";
+    firstMember = false;
+    appendKey(out, key, 1);
+  };
+
+  out += "{\n";
+
+  // file version
+  beginMember("version");
+  appendMatrix(out, version, 1);
+
+  // folders
+  const auto appendFolder = [](std::string& folderOut, const std::string& folder, int)
+  {
+    appendString(folderOut, folder);
+  };
+
+  if(!sfmData.getRelativeFeaturesFolders().empty())
+  {
+    beginMember("featuresFolders");
+    writeArray(writer, sfmData.getRelativeFeaturesFolders(), 1, appendFolder);
+  }
+
+  if(!sfmData.getRelativeMatchesFolders().empty())
+  {
+    beginMember("matchesFolders");
+    writeArray(writer, sfmData.getRelativeMatchesFolders(), 1, appendFolder);
+  }
+
+  // views
+  if(saveViews && !sfmData.getViews().empty())
+  {
+    beginMember("views");
+    writeArray(writer, sfmData.getViews(), 1, [](std::string& viewOut, const sfmData::Views::value_type& viewPair, int indent)
+    {
+      bpt::ptree viewsTree;
+      saveView("", *(viewPair.second), viewsTree);
+      appendTree(viewOut, viewsTree.front().second, indent);
+    });
+  }
+
+  // intrinsics
+  if(saveIntrinsics && !sfmData.getIntrinsics().empty())
+  {
+    beginMember("intrinsics");
+    writeArray(writer, sfmData.getIntrinsics(), 1, [](std::string& intrinsicOut, const sfmData::Intrinsics::value_type& intrinsicPair, int indent)
+    {
+      bpt::ptree intrinsicsTree;
+      saveIntrinsic("", intrinsicPair.first, intrinsicPair.second, intrinsicsTree);
+      appendTree(intrinsicOut, intrinsicsTree.front().second, indent);
+    });
+  }
+
+  //extrinsics
+  if(saveExtrinsics)
+  {
+    // poses
+    if(!sfmData.getPoses().empty())
+    {
+      beginMember("poses");
+      writeArray(writer, sfmData.getPoses(), 1, [](std::string& poseOut, const sfmData::Poses::value_type& posePair, int indent)
+      {
+        bpt::ptree poseTree;
+        poseTree.put("poseId", posePair.first);
+        saveCameraPose("pose", posePair.second, poseTree);
+        appendTree(poseOut, poseTree, indent);
+      });
+    }
+
+    // rigs
+    if(!sfmData.getRigs().empty())
+    {
+      beginMember("rigs");
+      writeArray(writer, sfmData.getRigs(), 1, [](std::string& rigOut, const sfmData::Rigs::value_type& rigPair, int indent)
+      {
+        bpt::ptree rigsTree;
+        saveRig("", rigPair.first, rigPair.second, rigsTree);
+        appendTree(rigOut, rigsTree.front().second, indent);
+      });
+    }
+  }
+
+  // structure
+  if(saveStructure && !sfmData.getLandmarks().empty())
+  {
+    beginMember("structure");
+    writeLandmarks(writer, sfmData.getLandmarks(), 1);
+  }
+
+  // control points
+  if(saveControlPoints && !sfmData.getControlPoints().empty())
+  {
+    beginMember("controlPoints");
+    writeLandmarks(writer, sfmData.getControlPoints(), 1);
+  }
+
+  out += "\n}\n";
+  writer.flush();
+
+  return true;
+}
+
+bool loadJSONStream(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag, bool incompleteViews)
+{
+  // load flags
+  const bool loadViews = (partFlag & VIEWS) == VIEWS;
+  const bool loadIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
+  const bool loadExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
+  const bool loadStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool loadControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
+
+  std::ifstream stream(filename, std::ios::binary);
+  if(!stream.is_open())
+    throw std::runtime_error("Cannot open the file '" + filename + "'.");
+
+  JsonStreamReader reader(stream, filename);
+
+  // tree of the parts other than the landmarks
+  bpt::ptree fileTree;
+
+  std::string key;
+  reader.beginObject();
+  while(reader.nextMember(key))
+  {
+    if(key == "structure")
+    {
+      if(loadStructure)
+        readLandmarks(reader, sfmData.getLandmarks());
+      else
+        reader.skipValue();
+    }
+    else if(key == "controlPoints")
+    {
+      if(loadControlPoints)
+        readLandmarks(reader, sfmData.getControlPoints());
+      else
+        reader.skipValue();
+    }
+    else if((key == "views" && !loadViews) ||
+            (key == "intrinsics" && !loadIntrinsics) ||
+            ((key == "poses" || key == "rigs") && !loadExtrinsics))
+    {
+      reader.skipValue();
+    }
+    else
+    {
+      bpt::ptree::iterator it = fileTree.push_back(bpt::ptree::value_type(key, bpt::ptree()));
+      reader.readTree(it->second);
+    }
+  }
+  reader.end();
+
+  return loadJSONTree(sfmData, fileTree, partFlag, incompleteViews);
+}
+
+} // namespace sfmDataIO
+} // namespace aliceVision
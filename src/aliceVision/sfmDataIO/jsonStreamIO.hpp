@@ -0,0 +1,44 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+
+#include <string>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+/**
+ * @brief Save an SfMData in a JSON file without building the whole property tree.
+ * The landmarks are formatted in parallel chunks and written through a buffer,
+ * the other parts are written from their property tree one element at a time.
+ * The output is byte-identical to saveJSON.
+ * @param[in] sfmData The input SfMData
+ * @param[in] filename The filename
+ * @param[in] partFlag The ESfMData save flag
+ * @return true if completed
+ * @throw std::runtime_error if the file cannot be written
+ */
+bool saveJSONStream(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag);
+
+/**
+ * @brief Load an SfMData from a JSON file with a streaming parser.
+ * The landmarks and their observations are parsed directly in the SfMData,
+ * the other parts are parsed in a property tree and loaded like loadJSON.
+ * The parts that are not requested are skipped without being parsed.
+ * @param[out] sfmData The output SfMData
+ * @param[in] filename The filename
+ * @param[in] partFlag The ESfMData load flag
+ * @param[in] incompleteViews If true, try to load incomplete views
+ * @return true if completed
+ * @throw std::runtime_error if the file cannot be read or is not a valid SfMData JSON file
+ */
+bool loadJSONStream(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag, bool incompleteViews = false);
+
+} // namespace sfmDataIO
+} // namespace aliceVision
@@ -8,7 +8,9 @@
 #include "sfmDataIO.hpp"
 #include <aliceVision/config.hpp>
 #include <aliceVision/stl/mapUtils.hpp>
+#include <aliceVision/sfmDataIO/binaryIO.hpp>
 #include <aliceVision/sfmDataIO/jsonIO.hpp>
+#include <aliceVision/sfmDataIO/jsonStreamIO.hpp>
 #include <aliceVision/sfmDataIO/plyIO.hpp>
 #include <aliceVision/sfmDataIO/bafIO.hpp>
 #include <aliceVision/sfmDataIO/gtIO.hpp>
@@ -99,7 +101,11 @@ bool Load(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partF
 
   if(extension == ".sfm" || extension == ".json") // JSON File
   {
-    status = loadJSON(sfmData, filename, partFlag);
+    status = loadJSONStream(sfmData, filename, partFlag);
+  }
+  else if(extension == ".sfmb") // Binary File
+  {
+    status = loadBinary(sfmData, filename, partFlag);
   }
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
   else if(extension == ".abc") // Alembic
@@ -137,7 +143,11 @@ bool Save(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData
 
   if(extension == ".sfm" || extension == ".json") // JSON File
   {
-    status = saveJSON(sfmData, tmpPath, partFlag);
+    status = saveJSONStream(sfmData, tmpPath, partFlag);
+  }
+  else if(extension == ".sfmb") // Binary File
+  {
+    status = saveBinary(sfmData, tmpPath, partFlag);
   }
   else if(extension == ".ply") // Polygon File
   {
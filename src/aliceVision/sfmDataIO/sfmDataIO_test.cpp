@@ -7,9 +7,13 @@
 
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/sfm/sfm.hpp>
+#include <aliceVision/sfmDataIO/jsonIO.hpp>
+#include <aliceVision/sfmDataIO/jsonStreamIO.hpp>
 
 #include <boost/filesystem.hpp>
 
+#include <fstream>
+#include <iterator>
 #include <sstream>
 
 #define BOOST_TEST_MODULE sfmDataIO
@@ -173,6 +177,172 @@ BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD_JSON) {
   }
 }
 
+std::string readFile(const std::string& filename)
+{
+  std::ifstream stream(filename, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+BOOST_AUTO_TEST_CASE(SfMData_IO_JSON_STREAM) {
+
+  sfmData::SfMData sfmData = createTestScene(5, 50, false);
+
+  // the values that need to be escaped, the empty containers and the control points
+  sfmData.addFeaturesFolder("features/\"quoted\"\ttab\x01\xc3\xa9");
+  sfmData.addMatchesFolder("matches");
+  sfmData.views.at(0)->addMetadata("Exif:Comment", "line\nbreak");
+  sfmData.structure[1].X = Vec3(-0.1, 1e-30, 123456789.123456789);
+  sfmData.structure[1].rgb = image::RGBColor(0, 128, 255);
+  sfmData.structure[1].descType = feature::EImageDescriberType::AKAZE;
+  sfmData.control_points[0].X = Vec3(1.0 / 3.0, 2.0, 3.0);
+  sfmData.control_points[0].descType = feature::EImageDescriberType::SIFT;
+  sfmData.control_points[0].observations[2] = sfmData::Observation(Vec2(0.5, 0.25), 7);
+
+  const std::string ptreeFilename = "SAVE_LOAD_PTREE.sfm";
+  const std::string streamFilename = "SAVE_LOAD_STREAM.sfm";
+
+  // SAVE: same output as the property tree
+  BOOST_CHECK( saveJSON(sfmData, ptreeFilename, ALL) );
+  BOOST_CHECK( saveJSONStream(sfmData, streamFilename, ALL) );
+  BOOST_CHECK( readFile(ptreeFilename) == readFile(streamFilename) );
+
+  BOOST_CHECK( saveJSON(sfmData, ptreeFilename, ESfMData(VIEWS | STRUCTURE)) );
+  BOOST_CHECK( saveJSONStream(sfmData, streamFilename, ESfMData(VIEWS | STRUCTURE)) );
+  BOOST_CHECK( readFile(ptreeFilename) == readFile(streamFilename) );
+
+  BOOST_CHECK( saveJSONStream(sfmData, streamFilename, ALL) );
+
+  // LOAD
+  {
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( loadJSONStream(sfmDataLoad, streamFilename, ALL) );
+    BOOST_CHECK( sfmDataLoad == sfmData );
+    BOOST_CHECK( sfmDataLoad.getRelativeFeaturesFolders() == sfmData.getRelativeFeaturesFolders() );
+    BOOST_CHECK( sfmDataLoad.views.at(0)->getMetadata() == sfmData.views.at(0)->getMetadata() );
+    BOOST_CHECK_EQUAL( sfmDataLoad.structure.at(1).X, sfmData.structure.at(1).X );
+
+    sfmData::SfMData sfmDataLoadPtree;
+    BOOST_CHECK( loadJSON(sfmDataLoadPtree, streamFilename, ALL) );
+    BOOST_CHECK( sfmDataLoad == sfmDataLoadPtree );
+  }
+
+  // LOAD (only a subpart: STRUCTURE)
+  {
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( loadJSONStream(sfmDataLoad, streamFilename, STRUCTURE) );
+    BOOST_CHECK_EQUAL( sfmDataLoad.views.size(), 0);
+    BOOST_CHECK_EQUAL( sfmDataLoad.intrinsics.size(), 0);
+    BOOST_CHECK( sfmDataLoad.structure == sfmData.structure );
+    BOOST_CHECK_EQUAL( sfmDataLoad.control_points.size(), 0);
+  }
+
+  // LOAD (invalid file)
+  {
+    std::ofstream stream(streamFilename);
+    stream << "{\n    \"version\": [\n        \"1\",\n";
+    stream.close();
+
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK_THROW( loadJSONStream(sfmDataLoad, streamFilename, ALL), std::runtime_error );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD_BINARY) {
+
+  sfmData::SfMData sfmData = createTestScene(5, 50, false);
+
+  sfmData.addFeaturesFolder("features");
+  sfmData.addMatchesFolder("matches");
+  sfmData.views.at(0)->addMetadata("Make", "Camera");
+  sfmData.views.at(1)->setRigAndSubPoseId(0, 1);
+  sfmData.getRigs()[0] = sfmData::Rig(2);
+  sfmData.getRigs()[0].setSubPose(1, sfmData::RigSubPose(Pose3(RotationAroundY(0.5), Vec3(1.0, 2.0, 3.0)), sfmData::ERigSubPoseStatus::CONSTANT));
+  sfmData.getPoses().at(2) = sfmData::CameraPose(Pose3(RotationAroundX(0.1), Vec3(-1.0, 0.5, 2.0)), true);
+  sfmData.structure[1].X = Vec3(-0.1, 1e-30, 123456789.123456789);
+  sfmData.structure[1].rgb = image::RGBColor(0, 128, 255);
+  sfmData.structure[1].descType = feature::EImageDescriberType::AKAZE;
+  sfmData.control_points[0].X = Vec3(1.0 / 3.0, 2.0, 3.0);
+  sfmData.control_points[0].descType = feature::EImageDescriberType::SIFT;
+  sfmData.control_points[0].observations[2] = sfmData::Observation(Vec2(0.5, 0.25), 7);
+  sfmData._posesUncertainty[0] << 1.0, 2.0, 3.0, 4.0, 5.0, 6.0;
+  sfmData._landmarksUncertainty[1] = Vec3(0.1, 0.2, 0.3);
+
+  const std::string filename = "SAVE_LOAD.sfmb";
+  BOOST_CHECK( Save(sfmData, filename, ALL) );
+
+  // LOAD
+  {
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( Load(sfmDataLoad, filename, ALL) );
+    BOOST_CHECK( sfmDataLoad == sfmData );
+    BOOST_CHECK( sfmDataLoad.getRelativeFeaturesFolders() == sfmData.getRelativeFeaturesFolders() );
+    BOOST_CHECK( sfmDataLoad.getRelativeMatchesFolders() == sfmData.getRelativeMatchesFolders() );
+    BOOST_CHECK( sfmDataLoad.views.at(0)->getMetadata() == sfmData.views.at(0)->getMetadata() );
+    BOOST_CHECK_EQUAL( sfmDataLoad.structure.at(1).X, sfmData.structure.at(1).X );
+    BOOST_CHECK( sfmDataLoad._posesUncertainty == sfmData._posesUncertainty );
+    BOOST_CHECK( sfmDataLoad._landmarksUncertainty == sfmData._landmarksUncertainty );
+  }
+
+  // LOAD (subparts: VIEWS | INTRINSICS)
+  {
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( Load(sfmDataLoad, filename, ESfMData(VIEWS | INTRINSICS)) );
+    BOOST_CHECK_EQUAL( sfmDataLoad.views.size(), sfmData.views.size());
+    BOOST_CHECK_EQUAL( sfmDataLoad.intrinsics.size(), sfmData.intrinsics.size());
+    BOOST_CHECK_EQUAL( sfmDataLoad.getPoses().size(), 0);
+    BOOST_CHECK_EQUAL( sfmDataLoad.getRigs().size(), 0);
+    BOOST_CHECK_EQUAL( sfmDataLoad.structure.size(), 0);
+    BOOST_CHECK_EQUAL( sfmDataLoad.control_points.size(), 0);
+    BOOST_CHECK_EQUAL( sfmDataLoad._posesUncertainty.size(), 0);
+  }
+
+  // LOAD (only a subpart: EXTRINSICS)
+  {
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( Load(sfmDataLoad, filename, EXTRINSICS) );
+    BOOST_CHECK_EQUAL( sfmDataLoad.views.size(), 0);
+    BOOST_CHECK( sfmDataLoad.getPoses() == sfmData.getPoses() );
+    BOOST_CHECK( sfmDataLoad.getRigs() == sfmData.getRigs() );
+    BOOST_CHECK_EQUAL( sfmDataLoad.structure.size(), 0);
+  }
+
+  // LOAD (only a subpart: STRUCTURE without the observations)
+  {
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( Load(sfmDataLoad, filename, STRUCTURE) );
+    BOOST_CHECK_EQUAL( sfmDataLoad.views.size(), 0);
+    BOOST_CHECK_EQUAL( sfmDataLoad.structure.size(), sfmData.structure.size());
+    for(const auto& landmarkPair : sfmDataLoad.structure)
+    {
+      BOOST_CHECK_EQUAL( landmarkPair.second.X, sfmData.structure.at(landmarkPair.first).X );
+      BOOST_CHECK( landmarkPair.second.observations.empty() );
+    }
+  }
+
+  // JSON -> binary -> JSON
+  {
+    BOOST_CHECK( Save(sfmData, "SAVE_LOAD_BINARY_1.sfm", ALL) );
+    sfmData::SfMData sfmDataJson;
+    BOOST_CHECK( Load(sfmDataJson, "SAVE_LOAD_BINARY_1.sfm", ALL) );
+    BOOST_CHECK( Save(sfmDataJson, filename, ALL) );
+    sfmData::SfMData sfmDataBinary;
+    BOOST_CHECK( Load(sfmDataBinary, filename, ALL) );
+    BOOST_CHECK( Save(sfmDataBinary, "SAVE_LOAD_BINARY_2.sfm", ALL) );
+    BOOST_CHECK( readFile("SAVE_LOAD_BINARY_1.sfm") == readFile("SAVE_LOAD_BINARY_2.sfm") );
+  }
+
+  // LOAD (truncated file)
+  {
+    const std::string content = readFile(filename);
+    std::ofstream stream(filename, std::ios::binary);
+    stream.write(content.data(), content.size() / 2);
+    stream.close();
+
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK_THROW( Load(sfmDataLoad, filename, ALL), std::runtime_error );
+  }
+}
+
 /*
 BOOST_AUTO_TEST_CASE(SfMData_IO_BigFile) {
   const int nbViews = 1000;
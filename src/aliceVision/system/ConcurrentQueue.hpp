@@ -0,0 +1,131 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Bounded blocking FIFO queue to pipeline producer and consumer threads.
+ *
+ * push() blocks while the queue is full and pop() blocks while it is empty.
+ * Once closed, push() fails and pop() returns the remaining elements then fails,
+ * which stops the consumers.
+ */
+template <typename T>
+class ConcurrentQueue
+{
+public:
+  /**
+   * @param[in] capacity maximum number of elements in the queue (0 for unbounded)
+   */
+  explicit ConcurrentQueue(std::size_t capacity = 0)
+    : _capacity(capacity)
+  {}
+
+  ConcurrentQueue(const ConcurrentQueue&) = delete;
+  ConcurrentQueue& operator=(const ConcurrentQueue&) = delete;
+
+  /**
+   * @brief Add an element at the end of the queue (blocks while the queue is full)
+   * @return false if the queue is closed (the element is not added)
+   */
+  bool push(T value)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notFull.wait(lock, [this]() { return _closed || _capacity == 0 || _queue.size() < _capacity; });
+    if(_closed)
+      return false;
+    _queue.push_back(std::move(value));
+    lock.unlock();
+    _notEmpty.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Remove the first element of the queue (blocks while the queue is empty and not closed)
+   * @return false if the queue is closed and empty
+   */
+  bool pop(T& value)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notEmpty.wait(lock, [this]() { return _closed || !_queue.empty(); });
+    if(_queue.empty())
+      return false;
+    value = std::move(_queue.front());
+    _queue.pop_front();
+    lock.unlock();
+    _notFull.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Remove up to maxCount elements from the front of the queue
+   * (blocks while the queue is empty and not closed, but never waits for more than one element)
+   * @param[out] values the removed elements, in the queue order
+   * @param[in] maxCount maximum number of elements to remove
+   * @return false if the queue is closed and empty
+   */
+  bool popBatch(std::vector<T>& values, std::size_t maxCount)
+  {
+    values.clear();
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notEmpty.wait(lock, [this]() { return _closed || !_queue.empty(); });
+    if(_queue.empty())
+      return false;
+    while(!_queue.empty() && values.size() < maxCount)
+    {
+      values.push_back(std::move(_queue.front()));
+      _queue.pop_front();
+    }
+    lock.unlock();
+    _notFull.notify_all();
+    return true;
+  }
+
+  /**
+   * @brief Close the queue: no more element can be added and the waiting threads are released
+   */
+  void close()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _closed = true;
+    }
+    _notEmpty.notify_all();
+    _notFull.notify_all();
+  }
+
+  bool isClosed() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _closed;
+  }
+
+  std::size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _queue.size();
+  }
+
+private:
+  const std::size_t _capacity;
+  bool _closed = false;
+  std::deque<T> _queue;
+  mutable std::mutex _mutex;
+  std::condition_variable _notEmpty;
+  std::condition_variable _notFull;
+};
+
+} // namespace system
+} // namespace aliceVision
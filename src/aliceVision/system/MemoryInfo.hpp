@@ -24,6 +24,18 @@ struct MemoryInfo
 
 MemoryInfo getMemoryInfo();
 
+/**
+ * @brief Get the peak resident set size of the current process
+ * @return the peak resident memory in bytes (0 if unavailable on this system)
+ */
+std::size_t getPeakResidentMemory();
+
+/**
+ * @brief Get the current resident set size of the current process
+ * @return the resident memory in bytes (0 if unavailable on this system)
+ */
+std::size_t getResidentMemory();
+
 std::ostream& operator<<(std::ostream& os, const MemoryInfo& infos);
 
 }
@@ -161,6 +161,97 @@ void TracksBuilder::exportToSTL(TracksMap& allTracks) const
   }
 }
 
+std::size_t TracksCounter::countTracks(const std::vector<PairwiseMatches::const_iterator>& pairwiseMatches, std::size_t minTrackLength)
+{
+  // list the referenced features
+  _features.clear();
+  for(const PairwiseMatches::const_iterator& matchesPerDescIt: pairwiseMatches)
+  {
+    const std::size_t I = matchesPerDescIt->first.first;
+    const std::size_t J = matchesPerDescIt->first.second;
+
+    for(const auto& matchesIt: matchesPerDescIt->second)
+    {
+      const feature::EImageDescriberType descType = matchesIt.first;
+      for(const IndMatch& m: matchesIt.second)
+      {
+        _features.emplace_back(I, KeypointId(descType, m._i));
+        _features.emplace_back(J, KeypointId(descType, m._j));
+      }
+    }
+  }
+  std::sort(_features.begin(), _features.end());
+  _features.erase(std::unique(_features.begin(), _features.end(), [](const TracksBuilder::IndexedFeaturePair& a, const TracksBuilder::IndexedFeaturePair& b)
+  {
+    return !(a < b) && !(b < a);
+  }), _features.end());
+
+  // make the union according the pair matches
+  _parents.resize(_features.size());
+  for(std::size_t i = 0; i < _parents.size(); ++i)
+    _parents[i] = i;
+
+  for(const PairwiseMatches::const_iterator& matchesPerDescIt: pairwiseMatches)
+  {
+    const std::size_t I = matchesPerDescIt->first.first;
+    const std::size_t J = matchesPerDescIt->first.second;
+
+    for(const auto& matchesIt: matchesPerDescIt->second)
+    {
+      const feature::EImageDescriberType descType = matchesIt.first;
+      for(const IndMatch& m: matchesIt.second)
+      {
+        const std::size_t rootI = findRoot(getFeatureIndex(TracksBuilder::IndexedFeaturePair(I, KeypointId(descType, m._i))));
+        const std::size_t rootJ = findRoot(getFeatureIndex(TracksBuilder::IndexedFeaturePair(J, KeypointId(descType, m._j))));
+        if(rootI != rootJ)
+          _parents[std::max(rootI, rootJ)] = std::min(rootI, rootJ);
+      }
+    }
+  }
+
+  // group the features per track, then per view
+  _rootsAndViews.resize(_features.size());
+  for(std::size_t i = 0; i < _features.size(); ++i)
+    _rootsAndViews[i] = std::make_pair(findRoot(i), _features[i].first);
+  std::sort(_rootsAndViews.begin(), _rootsAndViews.end());
+
+  // remove bad tracks:
+  // - track that are too short,
+  // - track with id conflicts (many times the same image index)
+  std::size_t nbTracks = 0;
+  std::size_t trackBegin = 0;
+  while(trackBegin < _rootsAndViews.size())
+  {
+    std::size_t trackEnd = trackBegin + 1;
+    bool conflict = false;
+    while(trackEnd < _rootsAndViews.size() && _rootsAndViews[trackEnd].first == _rootsAndViews[trackBegin].first)
+    {
+      conflict |= (_rootsAndViews[trackEnd].second == _rootsAndViews[trackEnd - 1].second);
+      ++trackEnd;
+    }
+    if(!conflict && (trackEnd - trackBegin) >= minTrackLength)
+      ++nbTracks;
+    trackBegin = trackEnd;
+  }
+  return nbTracks;
+}
+
+std::size_t TracksCounter::findRoot(std::size_t index)
+{
+  // path halving
+  while(_parents[index] != index)
+  {
+    _parents[index] = _parents[_parents[index]];
+    index = _parents[index];
+  }
+  return index;
+}
+
+std::size_t TracksCounter::getFeatureIndex(const TracksBuilder::IndexedFeaturePair& feature) const
+{
+  return std::lower_bound(_features.begin(), _features.end(), feature) - _features.begin();
+}
+
 namespace tracksUtilsMap {
 
 bool getCommonTracksInImages(const std::set<std::size_t>& imageIndexes,
@@ -193,6 +193,36 @@ struct TracksBuilder
   }
 };
 
+/**
+ * @brief Count the tracks of a small subset of pairwise matches (e.g. the view pairs of a triplet of poses).
+ *
+ * Gives the same result as TracksBuilder::build(), filter(minTrackLength) and nbTracks(),
+ * with a flat union-find over the referenced features only.
+ * The internal buffers are reused between calls, so keep one instance per thread.
+ */
+class TracksCounter
+{
+public:
+  /**
+   * @brief Count the valid tracks (long enough and without view conflict) built from the given pairwise matches
+   * @param[in] pairwiseMatches iterators on the pairwise matches to use
+   * @param[in] minTrackLength minimal number of views of a track
+   * @return number of valid tracks
+   */
+  std::size_t countTracks(const std::vector<PairwiseMatches::const_iterator>& pairwiseMatches, std::size_t minTrackLength = 2);
+
+private:
+  std::size_t findRoot(std::size_t index);
+  std::size_t getFeatureIndex(const TracksBuilder::IndexedFeaturePair& feature) const;
+
+  /// referenced features (sorted and unique)
+  std::vector<TracksBuilder::IndexedFeaturePair> _features;
+  /// union-find parent of each feature
+  std::vector<std::size_t> _parents;
+  /// (root, viewId) of each feature
+  std::vector<std::pair<std::size_t, std::size_t>> _rootsAndViews;
+};
+
 namespace tracksUtilsMap {
 
 /**
@@ -10,6 +10,7 @@
 
 #include <vector>
 #include <utility>
+#include <random>
 
 #define BOOST_TEST_MODULE Track
 #include <boost/test/included/unit_test.hpp>
@@ -178,6 +179,41 @@ BOOST_AUTO_TEST_CASE(Track_Conflict) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(Track_TracksCounter)
+{
+  std::mt19937 randomNumberGenerator(0);
+  std::uniform_int_distribution<int> featureDistribution(0, 30);
+
+  for(int test = 0; test < 10; ++test)
+  {
+    // random matches between 4 views, with conflicts
+    PairwiseMatches map_pairwisematches;
+    for(std::size_t I = 0; I < 4; ++I)
+    {
+      for(std::size_t J = I + 1; J < 4; ++J)
+      {
+        std::vector<IndMatch>& matches = map_pairwisematches[std::make_pair(I, J)][EImageDescriberType::UNKNOWN];
+        for(int m = 0; m < 20; ++m)
+          matches.emplace_back(featureDistribution(randomNumberGenerator), featureDistribution(randomNumberGenerator));
+      }
+    }
+
+    std::vector<PairwiseMatches::const_iterator> pairwiseMatches;
+    for(PairwiseMatches::const_iterator it = map_pairwisematches.begin(); it != map_pairwisematches.end(); ++it)
+      pairwiseMatches.push_back(it);
+
+    TracksCounter tracksCounter;
+    for(std::size_t minTrackLength = 2; minTrackLength <= 4; ++minTrackLength)
+    {
+      TracksBuilder trackBuilder;
+      trackBuilder.build(map_pairwisematches);
+      trackBuilder.filter(minTrackLength);
+
+      BOOST_CHECK_EQUAL(trackBuilder.nbTracks(), tracksCounter.countTracks(pairwiseMatches, minTrackLength));
+    }
+  }
+}
+
 BOOST_AUTO_TEST_CASE(Track_GetCommonTracksInImages)
 {
   {
@@ -51,6 +51,11 @@ DocId Database::insert(DocId doc_id, const SparseHistogram& document)
   return doc_id;
 }
 
+DocId Database::insert(DocId doc_id, const FlatSparseHistogram& document)
+{
+  return insert(doc_id, document.toSparseHistogram());
+}
+
 void Database::sanityCheck(std::size_t N, std::map<std::size_t, DocMatches>& matches) const
 {
   // if N is equal to zero
@@ -129,6 +134,29 @@ void Database::find( const SparseHistogram& query, std::size_t N, std::vector<Do
   std::copy(bestN(acc).begin(), bestN(acc).end(), matches.begin());
 }
 
+void Database::find(const std::vector<SparseHistogram>& queries, std::size_t N, std::vector<DocMatches>& matches, const std::string &distanceMethod) const
+{
+  using bestN_tag = boost::accumulators::tag::tail<boost::accumulators::left>;
+  using BestNAccumulator = boost::accumulators::accumulator_set<DocMatch, boost::accumulators::features<bestN_tag> >;
+
+  std::vector<BestNAccumulator> accs(queries.size(), BestNAccumulator(bestN_tag::cache_size = N));
+
+  // each document histogram is loaded once and compared to all the queries
+  for(const auto& document: database_)
+  {
+    for(std::size_t q = 0; q < queries.size(); ++q)
+      accs[q](DocMatch(document.first, sparseDistance(queries[q], document.second, distanceMethod, word_weights_)));
+  }
+
+  boost::accumulators::extractor<bestN_tag> bestN;
+  matches.resize(queries.size());
+  for(std::size_t q = 0; q < queries.size(); ++q)
+  {
+    matches[q].resize(std::min(N, database_.size()));
+    std::copy(bestN(accs[q]).begin(), bestN(accs[q]).end(), matches[q].begin());
+  }
+}
+
 /**
  * @brief Compute the TF-IDF weights of all the words. To be called after inserting a corpus of
  * training examples into the database.
@@ -177,6 +205,98 @@ void Database::loadWeights(const std::string& file)
   }
 }
 
+void Database::save(std::ostream& stream) const
+{
+  const uint32_t num_words = word_weights_.size();
+  const uint64_t num_documents = database_.size();
+  stream.write((const char*) (&num_words), sizeof (uint32_t));
+  stream.write((const char*) (word_weights_.data()), num_words * sizeof (float));
+  stream.write((const char*) (&num_documents), sizeof (uint64_t));
+
+  // one block per document: the words, the number of features per word, then the features
+  std::vector<Word> words;
+  std::vector<uint32_t> sizes;
+  std::vector<IndexT> features;
+  for(const auto& document : database_)
+  {
+    words.clear();
+    sizes.clear();
+    features.clear();
+    for(const auto& word : document.second)
+    {
+      words.push_back(word.first);
+      sizes.push_back(word.second.size());
+      features.insert(features.end(), word.second.begin(), word.second.end());
+    }
+
+    const DocId doc_id = document.first;
+    const uint32_t num_doc_words = words.size();
+    const uint64_t num_features = features.size();
+    stream.write((const char*) (&doc_id), sizeof (DocId));
+    stream.write((const char*) (&num_doc_words), sizeof (uint32_t));
+    stream.write((const char*) (&num_features), sizeof (uint64_t));
+    stream.write((const char*) (words.data()), num_doc_words * sizeof (Word));
+    stream.write((const char*) (sizes.data()), num_doc_words * sizeof (uint32_t));
+    stream.write((const char*) (features.data()), num_features * sizeof (IndexT));
+  }
+
+  if(!stream)
+    throw std::runtime_error("Failed to save the vocabulary tree database.");
+}
+
+void Database::load(std::istream& stream)
+{
+  const auto read = [&stream](void* data, std::size_t size)
+  {
+    stream.read((char*) data, size);
+    if(!stream)
+      throw std::runtime_error("Failed to load the vocabulary tree database: truncated stream.");
+  };
+
+  uint32_t num_words = 0;
+  read(&num_words, sizeof (uint32_t));
+  word_weights_.resize(num_words);
+  read(word_weights_.data(), num_words * sizeof (float));
+  word_files_.assign(num_words, InvertedFile());
+  database_.clear();
+
+  uint64_t num_documents = 0;
+  read(&num_documents, sizeof (uint64_t));
+
+  std::vector<Word> words;
+  std::vector<uint32_t> sizes;
+  std::vector<IndexT> features;
+  for(uint64_t i = 0; i < num_documents; ++i)
+  {
+    DocId doc_id;
+    uint32_t num_doc_words = 0;
+    uint64_t num_features = 0;
+    read(&doc_id, sizeof (DocId));
+    read(&num_doc_words, sizeof (uint32_t));
+    read(&num_features, sizeof (uint64_t));
+    words.resize(num_doc_words);
+    sizes.resize(num_doc_words);
+    features.resize(num_features);
+    read(words.data(), num_doc_words * sizeof (Word));
+    read(sizes.data(), num_doc_words * sizeof (uint32_t));
+    read(features.data(), num_features * sizeof (IndexT));
+
+    // documents and words are stored in increasing order: insert at the end
+    SparseHistogram document;
+    std::size_t offset = 0;
+    for(uint32_t w = 0; w < num_doc_words; ++w)
+    {
+      if(words[w] < 0 || words[w] >= (Word) num_words || offset + sizes[w] > num_features)
+        throw std::runtime_error("Failed to load the vocabulary tree database: invalid document.");
+
+      word_files_[words[w]].push_back(WordFrequency(doc_id, sizes[w]));
+      document.emplace_hint(document.end(), words[w], std::vector<IndexT>(features.begin() + offset, features.begin() + offset + sizes[w]));
+      offset += sizes[w];
+    }
+    database_.emplace_hint(database_.end(), doc_id, std::move(document));
+  }
+}
+
 ///**
 // * Normalize a document vector representing the histogram of visual words for a given image
 // * 
@@ -7,10 +7,12 @@
 #pragma once
 
 #include "VocabularyTree.hpp"
+#include "FlatSparseHistogram.hpp"
 #include <aliceVision/types.hpp>
 
 #include <map>
 #include <cstddef>
+#include <iostream>
 #include <string>
 
 namespace aliceVision{
@@ -75,6 +77,15 @@ public:
    */
   DocId insert(DocId doc_id, const SparseHistogram& document);
 
+  /**
+   * @brief Insert a new document given as a flat histogram.
+   *
+   * @param doc_id Unique ID of the new document to insert
+   * @param document The histogram of the quantized words of the document/image.
+   * \return An ID representing the inserted document.
+   */
+  DocId insert(DocId doc_id, const FlatSparseHistogram& document);
+
   /**
    * @brief Perform a sanity check of the database by querying each document
    * of the database and finding its top N matches
@@ -104,6 +115,18 @@ public:
    */
   void find(const SparseHistogram& query, std::size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
 
+  /**
+   * @brief Find the top N matches in the database for a batch of query documents.
+   * The documents of the database are read once for all the queries,
+   * the results are the same as calling find for each query.
+   *
+   * @param[in] queries The query documents, normalized sets of quantized words.
+   * @param[in] N        The number of matches to return per query.
+   * @param[out] matches  IDs and scores for the top N matching database documents of each query.
+   * @param[in] distanceMethod distance method (norm L1, etc.)
+   */
+  void find(const std::vector<SparseHistogram>& queries, std::size_t N, std::vector<DocMatches>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
+
   /**
    * @brief Compute the TF-IDF weights of all the words. To be called after inserting a corpus of
    * training examples into the database.
@@ -123,9 +146,18 @@ public:
   /// Load the vocabulary word weights from a file.
   void loadWeights(const std::string& file);
 
-  // Save weights and documents
-  //void save(const std::string& file) const;
-  //void load(const std::string& file);
+  /**
+   * @brief Save the word weights and the documents in a binary stream.
+   * @param[out] stream the output binary stream
+   */
+  void save(std::ostream& stream) const;
+
+  /**
+   * @brief Load the word weights and the documents from a binary stream (see save).
+   * The inverted files are rebuilt from the documents.
+   * @param[in] stream the input binary stream
+   */
+  void load(std::istream& stream);
 
   const SparseHistogramPerImage& getSparseHistogramPerImage() const
   {
@@ -0,0 +1,224 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "FlatSparseHistogram.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/functional/hash.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+namespace aliceVision {
+namespace voctree {
+
+namespace bfs = boost::filesystem;
+
+FlatSparseHistogram::FlatSparseHistogram(const Document& document, bool withFeatures)
+{
+  // sort the features by word, the features of a word stay in increasing order
+  std::vector<std::pair<Word, IndexT>> wordFeatures(document.size());
+  for(std::size_t i = 0; i < document.size(); ++i)
+    wordFeatures[i] = std::make_pair(document[i], static_cast<IndexT>(i));
+  std::sort(wordFeatures.begin(), wordFeatures.end());
+
+  if(withFeatures)
+    _features.reserve(wordFeatures.size());
+
+  for(const auto& wordFeature : wordFeatures)
+  {
+    if(_words.empty() || _words.back() != wordFeature.first)
+    {
+      if(withFeatures)
+        _featureOffsets.push_back(_features.size());
+      _words.push_back(wordFeature.first);
+      _counts.push_back(0);
+    }
+    ++_counts.back();
+    if(withFeatures)
+      _features.push_back(wordFeature.second);
+  }
+}
+
+FlatSparseHistogram::FlatSparseHistogram(const SparseHistogram& histogram, bool withFeatures)
+{
+  _words.reserve(histogram.size());
+  _counts.reserve(histogram.size());
+  if(withFeatures)
+    _featureOffsets.reserve(histogram.size());
+
+  for(const auto& word : histogram)
+  {
+    _words.push_back(word.first);
+    _counts.push_back(word.second.size());
+    if(withFeatures)
+    {
+      _featureOffsets.push_back(_features.size());
+      _features.insert(_features.end(), word.second.begin(), word.second.end());
+    }
+  }
+}
+
+SparseHistogram FlatSparseHistogram::toSparseHistogram() const
+{
+  SparseHistogram histogram;
+  for(std::size_t i = 0; i < _words.size(); ++i)
+  {
+    // the words are stored in increasing order: insert at the end
+    if(hasFeatures())
+      histogram.emplace_hint(histogram.end(), _words[i], std::vector<IndexT>(features(i), features(i) + _counts[i]));
+    else
+      histogram.emplace_hint(histogram.end(), _words[i], std::vector<IndexT>(_counts[i], UndefinedIndexT));
+  }
+  return histogram;
+}
+
+std::size_t FlatSparseHistogram::nbFeatures() const
+{
+  return std::accumulate(_counts.begin(), _counts.end(), std::size_t(0));
+}
+
+void FlatSparseHistogram::save(std::ostream& stream) const
+{
+  const uint32_t num_words = _words.size();
+  const uint8_t with_features = hasFeatures() ? 1 : 0;
+  const uint64_t num_features = _features.size();
+  stream.write((const char*) (&num_words), sizeof (uint32_t));
+  stream.write((const char*) (&with_features), sizeof (uint8_t));
+  stream.write((const char*) (&num_features), sizeof (uint64_t));
+  stream.write((const char*) (_words.data()), num_words * sizeof (Word));
+  stream.write((const char*) (_counts.data()), num_words * sizeof (uint32_t));
+  stream.write((const char*) (_features.data()), num_features * sizeof (IndexT));
+
+  if(!stream)
+    throw std::runtime_error("Failed to save the sparse histogram.");
+}
+
+void FlatSparseHistogram::load(std::istream& stream)
+{
+  const auto read = [&stream](void* data, std::size_t size)
+  {
+    stream.read((char*) data, size);
+    if(!stream)
+      throw std::runtime_error("Failed to load the sparse histogram: truncated stream.");
+  };
+
+  uint32_t num_words = 0;
+  uint8_t with_features = 0;
+  uint64_t num_features = 0;
+  read(&num_words, sizeof (uint32_t));
+  read(&with_features, sizeof (uint8_t));
+  read(&num_features, sizeof (uint64_t));
+
+  if(!with_features && num_features != 0)
+    throw std::runtime_error("Failed to load the sparse histogram: invalid histogram.");
+
+  _words.resize(num_words);
+  _counts.resize(num_words);
+  _features.resize(num_features);
+  read(_words.data(), num_words * sizeof (Word));
+  read(_counts.data(), num_words * sizeof (uint32_t));
+  read(_features.data(), num_features * sizeof (IndexT));
+
+  _featureOffsets.clear();
+  uint64_t offset = 0;
+  for(uint32_t w = 0; w < num_words; ++w)
+  {
+    if(_words[w] < 0 || (w > 0 && _words[w] <= _words[w - 1]))
+      throw std::runtime_error("Failed to load the sparse histogram: invalid histogram.");
+    if(with_features)
+      _featureOffsets.push_back(offset);
+    offset += _counts[w];
+  }
+  if(with_features && offset != num_features)
+    throw std::runtime_error("Failed to load the sparse histogram: invalid histogram.");
+}
+
+HistogramCache::HistogramCache(const std::string& folder, const std::string& treeFilepath, std::size_t maxDescriptors)
+  : _folder(folder)
+{
+  boost::system::error_code ec;
+  std::size_t key = 0;
+  boost::hash_combine(key, bfs::absolute(treeFilepath).string());
+  boost::hash_combine(key, bfs::file_size(treeFilepath, ec));
+  boost::hash_combine(key, bfs::last_write_time(treeFilepath, ec));
+  boost::hash_combine(key, maxDescriptors);
+  _key = key;
+
+  if(!bfs::exists(_folder))
+    bfs::create_directories(_folder);
+}
+
+std::string HistogramCache::getFilepath(IndexT viewId) const
+{
+  return (bfs::path(_folder) / (std::to_string(viewId) + ".hist")).string();
+}
+
+uint64_t HistogramCache::getKey(const std::string& descriptorsFilepath) const
+{
+  boost::system::error_code ec;
+  std::size_t key = _key;
+  boost::hash_combine(key, bfs::absolute(descriptorsFilepath).string());
+  boost::hash_combine(key, bfs::file_size(descriptorsFilepath, ec));
+  boost::hash_combine(key, bfs::last_write_time(descriptorsFilepath, ec));
+  return key;
+}
+
+bool HistogramCache::load(IndexT viewId, const std::string& descriptorsFilepath, FlatSparseHistogram& histogram) const
+{
+  std::ifstream stream(getFilepath(viewId), std::ios::binary);
+  if(!stream.is_open())
+    return false;
+
+  uint64_t key = 0;
+  stream.read((char*) (&key), sizeof (uint64_t));
+  if(!stream || key != getKey(descriptorsFilepath))
+    return false;
+
+  try
+  {
+    histogram.load(stream);
+  }
+  catch(std::exception& e)
+  {
+    ALICEVISION_LOG_WARNING("Invalid histogram cache file for the view " << viewId << ": " << e.what());
+    return false;
+  }
+  return true;
+}
+
+bool HistogramCache::save(IndexT viewId, const std::string& descriptorsFilepath, const FlatSparseHistogram& histogram) const
+{
+  // write a temporary file then rename it, so that a concurrent reader never sees a partial file
+  const std::string filepath = getFilepath(viewId);
+  const std::string tmpFilepath = filepath + ".tmp";
+  try
+  {
+    std::ofstream stream(tmpFilepath, std::ios::binary);
+    if(!stream.is_open())
+      return false;
+    const uint64_t key = getKey(descriptorsFilepath);
+    stream.write((const char*) (&key), sizeof (uint64_t));
+    histogram.save(stream);
+  }
+  catch(std::exception& e)
+  {
+    ALICEVISION_LOG_WARNING("Cannot write the histogram cache file for the view " << viewId << ": " << e.what());
+    return false;
+  }
+
+  boost::system::error_code ec;
+  bfs::rename(tmpFilepath, filepath, ec);
+  return !ec;
+}
+
+} // namespace voctree
+} // namespace aliceVision
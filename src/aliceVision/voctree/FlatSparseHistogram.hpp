@@ -0,0 +1,180 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/voctree/VocabularyTree.hpp>
+#include <aliceVision/types.hpp>
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace voctree {
+
+/**
+ * @brief Compact version of a SparseHistogram: the sorted visual words and their number of
+ * features are stored in two contiguous arrays, instead of one heap node per word.
+ * The features of each word are optional, stored in a side array when needed.
+ */
+class FlatSparseHistogram
+{
+public:
+  /// Iterator on the (word, number of features) of the histogram, in increasing word order
+  class const_iterator
+  {
+  public:
+    const_iterator(const FlatSparseHistogram& histogram, std::size_t index)
+      : _histogram(&histogram)
+      , _index(index)
+    {}
+
+    Word word() const { return _histogram->_words[_index]; }
+    std::size_t count() const { return _histogram->_counts[_index]; }
+
+    const_iterator& operator++() { ++_index; return *this; }
+    bool operator==(const const_iterator& other) const { return _index == other._index; }
+    bool operator!=(const const_iterator& other) const { return _index != other._index; }
+
+  private:
+    const FlatSparseHistogram* _histogram;
+    std::size_t _index;
+  };
+
+  FlatSparseHistogram() = default;
+
+  /**
+   * @brief Build the histogram of a document.
+   * @param[in] document the visual word of each feature
+   * @param[in] withFeatures keep the features of each word, otherwise only their number
+   */
+  explicit FlatSparseHistogram(const Document& document, bool withFeatures = true);
+
+  /**
+   * @brief Build the histogram from a SparseHistogram.
+   * @param[in] histogram the histogram to convert
+   * @param[in] withFeatures keep the features of each word, otherwise only their number
+   */
+  explicit FlatSparseHistogram(const SparseHistogram& histogram, bool withFeatures = true);
+
+  /**
+   * @brief Convert to a SparseHistogram.
+   * Without the features, each word keeps its number of features with UndefinedIndexT.
+   */
+  SparseHistogram toSparseHistogram() const;
+
+  /// Number of distinct words
+  std::size_t size() const { return _words.size(); }
+  bool empty() const { return _words.empty(); }
+
+  /// Total number of features
+  std::size_t nbFeatures() const;
+
+  bool hasFeatures() const { return !_featureOffsets.empty(); }
+
+  /// The sorted words
+  const std::vector<Word>& words() const { return _words; }
+  /// The number of features of each word
+  const std::vector<uint32_t>& counts() const { return _counts; }
+
+  /**
+   * @brief Get the features of the i-th word (only if hasFeatures).
+   * @return a pointer to the first feature, the word has counts()[i] features
+   */
+  const IndexT* features(std::size_t i) const { return _features.data() + _featureOffsets[i]; }
+
+  const_iterator begin() const { return const_iterator(*this, 0); }
+  const_iterator end() const { return const_iterator(*this, _words.size()); }
+
+  /**
+   * @brief Save the histogram in a binary stream.
+   * @param[out] stream the output binary stream
+   */
+  void save(std::ostream& stream) const;
+
+  /**
+   * @brief Load the histogram from a binary stream (see save).
+   * @param[in] stream the input binary stream
+   * @throw std::runtime_error if the stream is truncated or invalid
+   */
+  void load(std::istream& stream);
+
+  bool operator==(const FlatSparseHistogram& other) const
+  {
+    return _words == other._words &&
+           _counts == other._counts &&
+           _featureOffsets == other._featureOffsets &&
+           _features == other._features;
+  }
+
+private:
+  std::vector<Word> _words;
+  std::vector<uint32_t> _counts;
+  /// offset of the features of each word in _features, empty without the features
+  std::vector<uint32_t> _featureOffsets;
+  std::vector<IndexT> _features;
+};
+
+typedef std::map<DocId, FlatSparseHistogram> FlatSparseHistogramPerImage;
+
+/**
+ * @brief compute the sparse distance between two flat histograms according to the chosen distance method.
+ * The distance is the same as the one of the equivalent SparseHistograms.
+ *
+ * @param v1 The first sparse histogram
+ * @param v2 The second sparse histogram
+ * @param distanceMethod distance method (norm L1, etc.)
+ * @param word_weights
+ * @return the distance of the two histograms
+ */
+float sparseDistance(const FlatSparseHistogram& v1, const FlatSparseHistogram& v2, const std::string &distanceMethod = "classic", const std::vector<float>& word_weights = std::vector<float>());
+
+/**
+ * @brief Binary on-disk cache of the histograms of the views, one file per view.
+ *
+ * A cached histogram is only valid for the same vocabulary tree, the same maximum number
+ * of descriptors and the same descriptor file: they are hashed in a key stored in the file
+ * (with the size and the modification time of the files).
+ */
+class HistogramCache
+{
+public:
+  /**
+   * @param[in] folder the folder of the cache files, created if needed
+   * @param[in] treeFilepath the vocabulary tree used to quantize the descriptors
+   * @param[in] maxDescriptors the maximum number of descriptors quantized per image
+   */
+  HistogramCache(const std::string& folder, const std::string& treeFilepath, std::size_t maxDescriptors);
+
+  /**
+   * @brief Load the cached histogram of a view.
+   * @param[in] viewId the view
+   * @param[in] descriptorsFilepath the descriptor file of the view
+   * @param[out] histogram the cached histogram
+   * @return false if there is no valid histogram in the cache
+   */
+  bool load(IndexT viewId, const std::string& descriptorsFilepath, FlatSparseHistogram& histogram) const;
+
+  /**
+   * @brief Save the histogram of a view in the cache.
+   * @return false if the cache file cannot be written
+   */
+  bool save(IndexT viewId, const std::string& descriptorsFilepath, const FlatSparseHistogram& histogram) const;
+
+private:
+  std::string getFilepath(IndexT viewId) const;
+  uint64_t getKey(const std::string& descriptorsFilepath) const;
+
+  std::string _folder;
+  /// hash of the tree and the parameters
+  uint64_t _key;
+};
+
+} // namespace voctree
+} // namespace aliceVision
@@ -10,14 +10,17 @@
 #include "DefaultAllocator.hpp"
 
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/function.hpp>
 #include <boost/foreach.hpp>
 
 #include <algorithm>
+#include <cstdint>
 #include <numeric>
 #include <vector>
 #include <limits>
+#include <random>
 #include <stdio.h>
 #include <stdlib.h>
 #include <iostream>
@@ -33,13 +36,20 @@ struct InitRandom
 
   template<class Feature, class Distance, class FeatureAllocator>
   void operator()(const std::vector<Feature*>& features, size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, const int verbose = 0)
+  {
+    std::mt19937 generator;
+    (*this)(features, k, centers, distance, generator, verbose);
+  }
+
+  template<class Feature, class Distance, class FeatureAllocator>
+  void operator()(const std::vector<Feature*>& features, size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, std::mt19937& generator, const int verbose = 0)
   {
     ALICEVISION_LOG_DEBUG("#\t\tRandom initialization");
     // Construct a random permutation of the features using a Fisher-Yates shuffle
     std::vector<Feature*> features_perm = features;
     for(size_t i = features.size(); i > 1; --i)
     {
-      size_t k = rand() % i;
+      size_t k = std::uniform_int_distribution<size_t>(0, i - 1)(generator);
       std::swap(features_perm[i - 1], features_perm[k]);
     }
     // Take the first k permuted features as the initial centers
@@ -61,6 +71,13 @@ struct InitKmeanspp
 
   template<class Feature, class Distance, class FeatureAllocator>
   void operator()(const std::vector<Feature*>& features, size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, const int verbose = 0)
+  {
+    std::mt19937 generator;
+    (*this)(features, k, centers, distance, generator, verbose);
+  }
+
+  template<class Feature, class Distance, class FeatureAllocator>
+  void operator()(const std::vector<Feature*>& features, size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, std::mt19937& generator, const int verbose = 0)
   {
     typedef typename Distance::result_type squared_distance_type;
 
@@ -86,7 +103,7 @@ struct InitKmeanspp
     typename std::vector<Feature*>::const_iterator featiter;
 
     // 1. Choose a random center
-    size_t randCenter = rand() % features.size();
+    size_t randCenter = std::uniform_int_distribution<size_t>(0, features.size() - 1)(generator);
 
     // add it to the centers
     centers[0] = *features[ randCenter ];
@@ -118,7 +135,7 @@ struct InitKmeanspp
         // 0 and this sum, then start compute the sum from the first element again
         // until the partial sum is greater than the number drawn: the
         // the previous element is what we are looking for
-        const float perc = (float)rand() / RAND_MAX;
+        const float perc = std::uniform_real_distribution<float>(0.f, 1.f)(generator);
         squared_distance_type partial = (squared_distance_type)(currSum * perc);
         // look for the element that cap the partial sum that has been
         // drawn
@@ -138,12 +155,11 @@ struct InitKmeanspp
           ++dstiter;
         }
 
-        // get the index
-        std::size_t featidx;
-        if(dstiter == dists.end())
-          featidx = features.size() - 1;
-        else
-          featidx = dstiter - dists.begin();
+        // get the index of the element that capped the partial sum
+        // (the iterator has been moved past it)
+        std::size_t featidx = 0;
+        if(dstiter != dists.begin())
+          featidx = (dstiter - dists.begin()) - 1;
 
         // 2. compute the distance of each feature from the current center
         squared_distance_type distSum = 0;
@@ -190,6 +206,12 @@ struct InitGiven
   {
     // Do nothing!
   }
+
+  template<class Feature, class Distance, class FeatureAllocator>
+  void operator()(const std::vector<Feature*>& features, std::size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, std::mt19937& generator, const int verbose = 0)
+  {
+    // Do nothing!
+  }
 };
 
 template<class Feature>
@@ -257,6 +279,10 @@ bool checkVectorElements(const std::vector<Feature, FeatureAllocator> &f, const
  * @brief Class for performing K-means clustering, optimized for a particular feature type and metric.
  *
  * The standard Lloyd's algorithm is used. By default, cluster centers are initialized randomly.
+ * With a mini-batch size, the mini-batch k-means is used instead:
+ *
+ *  Sculley, D. (2010). "Web-scale k-means clustering" Proceedings of the 19th
+ *  international conference on World Wide Web. pp. 1177–1178.
  */
 template<class Feature,
          class Distance = L2<Feature, Feature>,
@@ -265,7 +291,7 @@ class SimpleKmeans
 {
 public:
   typedef typename Distance::result_type squared_distance_type;
-  typedef boost::function<void(const std::vector<Feature*>&, std::size_t, std::vector<Feature, FeatureAllocator>&, Distance, const int verbose) > Initializer;
+  typedef boost::function<void(const std::vector<Feature*>&, std::size_t, std::vector<Feature, FeatureAllocator>&, Distance, std::mt19937& generator, const int verbose) > Initializer;
 
   /**
    * @brief Constructor
@@ -304,6 +330,37 @@ public:
     restarts_ = restarts;
   }
 
+  std::size_t getMiniBatchSize() const
+  {
+    return mini_batch_size_;
+  }
+
+  /**
+   * @brief Set the number of features drawn at each iteration of the mini-batch k-means.
+   * Each iteration only assigns the features of the batch, the centers are updated with
+   * a per-center learning rate. The sets smaller than the batch size are clustered with
+   * the Lloyd's algorithm.
+   * @param[in] size the size of the mini-batches, 0 to always use the Lloyd's algorithm
+   */
+  void setMiniBatchSize(std::size_t size)
+  {
+    mini_batch_size_ = size;
+  }
+
+  std::uint32_t getSeed() const
+  {
+    return seed_;
+  }
+
+  /**
+   * @brief Set the seed of the random generator used by cluster and clusterPointers
+   * (initial centers, mini-batches, re-seeding of the empty clusters)
+   */
+  void setSeed(std::uint32_t seed)
+  {
+    seed_ = seed;
+  }
+
   int getVerbose() const
   {
     return verbose_;
@@ -339,19 +396,51 @@ public:
    */
   squared_distance_type clusterPointers(const std::vector<Feature*>& features, std::size_t k,
                                         std::vector<Feature, FeatureAllocator>& centers,
-                                        std::vector<unsigned int>& membership) const;
+                                        std::vector<unsigned int>& membership) const
+  {
+    return clusterPointers(features, k, centers, membership, seed_);
+  }
+
+  /**
+   * @brief Partition a set of features into k clusters with a given random seed.
+   *
+   * The random generator is local to the call: concurrent calls do not share any state
+   * and the result only depends on the seed (for a given number of threads).
+   *
+   * @param      features   The features to be clustered.
+   * @param      k          The number of clusters.
+   * @param[out] centers    A set of k cluster centers.
+   * @param[out] membership Cluster assignment for each feature
+   * @param      seed       The seed of the random generator
+   */
+  squared_distance_type clusterPointers(const std::vector<Feature*>& features, std::size_t k,
+                                        std::vector<Feature, FeatureAllocator>& centers,
+                                        std::vector<unsigned int>& membership,
+                                        std::uint32_t seed) const;
 
 private:
 
   squared_distance_type clusterOnce(const std::vector<Feature*>& features, std::size_t k,
                                     std::vector<Feature, FeatureAllocator>& centers,
-                                    std::vector<unsigned int>& membership) const;
+                                    std::vector<unsigned int>& membership,
+                                    std::mt19937& generator) const;
+
+  squared_distance_type clusterMiniBatch(const std::vector<Feature*>& features, std::size_t k,
+                                         std::vector<Feature, FeatureAllocator>& centers,
+                                         std::vector<unsigned int>& membership,
+                                         std::mt19937& generator) const;
+
+  /// Find the nearest center to a feature.
+  unsigned int nearestCenter(const Feature& feature, std::size_t k,
+                             const std::vector<Feature, FeatureAllocator>& centers) const;
 
   Feature zero_;
   Distance distance_;
   Initializer choose_centers_;
   std::size_t max_iterations_;
   std::size_t restarts_;
+  std::size_t mini_batch_size_;
+  std::uint32_t seed_;
   int verbose_;
 };
 
@@ -363,7 +452,9 @@ distance_(d),
 choose_centers_(InitKmeanspp()),
 max_iterations_(100),
 verbose_(verbose),
-restarts_(1)
+restarts_(1),
+mini_batch_size_(0),
+seed_(std::mt19937::default_seed)
 {
 }
 
@@ -384,19 +475,38 @@ template < class Feature, class Distance, class FeatureAllocator >
 typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
 SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterPointers(const std::vector<Feature*>& features, size_t k,
                                                                    std::vector<Feature, FeatureAllocator>& centers,
-                                                                   std::vector<unsigned int>& membership) const
+                                                                   std::vector<unsigned int>& membership,
+                                                                   std::uint32_t seed) const
 {
+  std::mt19937 generator(seed);
   std::vector<Feature, FeatureAllocator> new_centers(centers);
   new_centers.resize(k);
   std::vector<unsigned int> new_membership(features.size());
 
+  const bool useMiniBatch = (mini_batch_size_ > 0) && (features.size() > mini_batch_size_);
+
   squared_distance_type least_sse = std::numeric_limits<squared_distance_type>::max();
   assert(restarts_ > 0);
   for(std::size_t starts = 0; starts < restarts_; ++starts)
   {
     if(verbose_ > 0) ALICEVISION_LOG_DEBUG("Trial " << starts + 1 << "/" << restarts_);
-    choose_centers_(features, k, new_centers, distance_, verbose_);
-    squared_distance_type sse = clusterOnce(features, k, new_centers, new_membership);
+    squared_distance_type sse;
+    if(useMiniBatch)
+    {
+      // the initial centers are chosen among a random sample of the features
+      const std::size_t initSize = std::min(features.size(), 3 * mini_batch_size_);
+      std::vector<Feature*> initFeatures(initSize);
+      std::uniform_int_distribution<std::size_t> sampleIndex(0, features.size() - 1);
+      for(std::size_t i = 0; i < initSize; ++i)
+        initFeatures[i] = features[sampleIndex(generator)];
+      choose_centers_(initFeatures, k, new_centers, distance_, generator, verbose_);
+      sse = clusterMiniBatch(features, k, new_centers, new_membership, generator);
+    }
+    else
+    {
+      choose_centers_(features, k, new_centers, distance_, generator, verbose_);
+      sse = clusterOnce(features, k, new_centers, new_membership, generator);
+    }
     if(verbose_ > 0) ALICEVISION_LOG_DEBUG("End of Trial " << starts + 1 << "/" << restarts_);
     if(sse < least_sse)
     {
@@ -415,7 +525,8 @@ template < class Feature, class Distance, class FeatureAllocator >
 typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
 SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector<Feature*>& features, std::size_t k,
                                                                std::vector<Feature, FeatureAllocator>& centers,
-                                                               std::vector<unsigned int>& membership) const
+                                                               std::vector<unsigned int>& membership,
+                                                               std::mt19937& generator) const
 {
   typedef typename std::vector<Feature, FeatureAllocator>::value_type centerType;
   typedef typename Distance::value_type feature_value_type;
@@ -424,6 +535,11 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector
   std::vector<Feature, FeatureAllocator> new_centers(k);
   squared_distance_type max_center_shift = std::numeric_limits<squared_distance_type>::max();
 
+  // each thread accumulates its own centers, they are summed at the end of the iteration
+  const std::size_t nbThreads = omp_get_max_threads();
+  std::vector< std::vector<std::size_t> > thread_center_counts(nbThreads, std::vector<std::size_t>(k));
+  std::vector< std::vector<Feature, FeatureAllocator> > thread_centers(nbThreads, std::vector<Feature, FeatureAllocator>(k));
+
   if(verbose_ > 0) ALICEVISION_LOG_DEBUG("Iterations");
   for(std::size_t iter = 0; iter < max_iterations_; ++iter)
   {
@@ -434,35 +550,24 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector
     std::fill(new_centers.begin(), new_centers.end(), zero_);
     //		for(std::size_t i = 0; i < k; checkElements(new_centers[i++], "aft"));
     assert(checkVectorElements(new_centers, "newcenters init"));
+    for(std::size_t t = 0; t < nbThreads; ++t)
+    {
+      std::fill(thread_center_counts[t].begin(), thread_center_counts[t].end(), 0);
+      std::fill(thread_centers[t].begin(), thread_centers[t].end(), zero_);
+    }
     bool is_stable = true;
 
 
     // Assign data objects to current centers
-    #pragma omp parallel for shared( new_centers, new_center_counts, features, centers, membership)
+    #pragma omp parallel for shared( thread_centers, thread_center_counts, features, centers, membership)
     for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(features.size()); ++i)
     {
-      squared_distance_type d_min = std::numeric_limits<squared_distance_type>::max();
-      unsigned int nearest = 0;
-      bool found = false;
-
       // @todo if k is large, let's say k>100 use FLAAN to retrieve the 
       // cluster center
 
       // Find the nearest cluster center to feature i
-      for(unsigned int j = 0; j < k; ++j)
-      {
-        squared_distance_type distance = distance_(*features[i], centers[j]);
-        //		printf("\t\tdistance %f\n", (float)distance);
-        //		PrintFeat(*features[i] );
-        if(distance < d_min)
-        {
-          d_min = distance;
-          nearest = j;
-          found = true;
-        }
-        //		 printf("\t distance %f %f\n", (double)distance, (double)d_min);
-      }
-      assert(found);
+      const unsigned int nearest = nearestCenter(*features[i], k, centers);
+
       // Assign feature i to the cluster it is nearest to
       if(membership[i] != nearest)
       {
@@ -470,17 +575,21 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector
         membership[i] = nearest;
       }
       // Accumulate the cluster center and its membership count
-      //	  printf("\t nearest %d\n", nearest);
-      //			checkElements(*features[i], "feat");
-      #pragma omp critical
+      const int thread = omp_get_thread_num();
+      thread_centers[thread][nearest] += *features[i];
+      ++thread_center_counts[thread][nearest];
+    }//for
+
+    for(std::size_t t = 0; t < nbThreads; ++t)
+    {
+      for(std::size_t i = 0; i < k; ++i)
       {
-        new_centers[nearest] += *features[i];
-        //			checkElements(new_centers[nearest], "sum");
-        //	  printf("\t new_centers[nearest] += *features[i];\n");
-        ++new_center_counts[nearest];
-        //	  printf("\taccumulate\n");
+        if(thread_center_counts[t][i] == 0)
+          continue;
+        new_centers[i] += thread_centers[t][i];
+        new_center_counts[i] += thread_center_counts[t][i];
       }
-    }//for
+    }
 
     if(is_stable) break;
 
@@ -509,7 +618,7 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector
       {
         // Choose a new center randomly from the input features
         // @todo use a better strategy like taking splitting the largest cluster
-        unsigned int index = rand() % features.size();
+        const std::size_t index = std::uniform_int_distribution<std::size_t>(0, features.size() - 1)(generator);
         centers[i] = *features[index];
         ALICEVISION_LOG_DEBUG("Choosing a new center: " << index);
       }
@@ -530,5 +639,86 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector
   return sse;
 }
 
+template < class Feature, class Distance, class FeatureAllocator >
+typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
+SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterMiniBatch(const std::vector<Feature*>& features, std::size_t k,
+                                                                    std::vector<Feature, FeatureAllocator>& centers,
+                                                                    std::vector<unsigned int>& membership,
+                                                                    std::mt19937& generator) const
+{
+  std::uniform_int_distribution<std::size_t> sampleIndex(0, features.size() - 1);
+
+  std::vector<std::size_t> batch(mini_batch_size_);
+  std::vector<unsigned int> batch_membership(mini_batch_size_);
+  // sum and number of all the features assigned to each center so far
+  std::vector<std::size_t> center_counts(k, 0);
+  std::vector<Feature, FeatureAllocator> center_sums(k, zero_);
+
+  if(verbose_ > 0) ALICEVISION_LOG_DEBUG("Mini-batch iterations");
+  for(std::size_t iter = 0; iter < max_iterations_; ++iter)
+  {
+    if(verbose_ > 0) ALICEVISION_LOG_DEBUG("*");
+    for(std::size_t i = 0; i < mini_batch_size_; ++i)
+      batch[i] = sampleIndex(generator);
+
+    // Assign the features of the batch to the current centers
+    #pragma omp parallel for
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(mini_batch_size_); ++i)
+      batch_membership[i] = nearestCenter(*features[batch[i]], k, centers);
+
+    // Accumulate the features of the batch: each center is the mean of all the
+    // features assigned to it so far, i.e. a per-center learning rate of 1 / count
+    for(std::size_t i = 0; i < mini_batch_size_; ++i)
+    {
+      center_sums[batch_membership[i]] += *features[batch[i]];
+      ++center_counts[batch_membership[i]];
+    }
+
+    squared_distance_type max_center_shift = 0;
+    for(std::size_t i = 0; i < k; ++i)
+    {
+      // the centers without any feature so far keep their initial value
+      if(center_counts[i] == 0)
+        continue;
+      const Feature new_center = center_sums[i] / center_counts[i];
+      max_center_shift = std::max(max_center_shift, distance_(new_center, centers[i]));
+      centers[i] = new_center;
+    }
+    if(max_center_shift <= 10e-10) break;
+  }
+  if(verbose_ > 0) ALICEVISION_LOG_DEBUG("");
+
+  // Assign all the features to the final centers and return the sum squared error
+  squared_distance_type sse = squared_distance_type(0);
+  #pragma omp parallel for reduction(+:sse)
+  for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(features.size()); ++i)
+  {
+    membership[i] = nearestCenter(*features[i], k, centers);
+    sse += distance_(*features[i], centers[membership[i]]);
+  }
+  return sse;
+}
+
+template < class Feature, class Distance, class FeatureAllocator >
+unsigned int SimpleKmeans<Feature, Distance, FeatureAllocator>::nearestCenter(const Feature& feature, std::size_t k,
+                                                                             const std::vector<Feature, FeatureAllocator>& centers) const
+{
+  squared_distance_type d_min = std::numeric_limits<squared_distance_type>::max();
+  unsigned int nearest = 0;
+  bool found = false;
+  for(unsigned int j = 0; j < k; ++j)
+  {
+    const squared_distance_type distance = distance_(feature, centers[j]);
+    if(distance < d_min)
+    {
+      d_min = distance;
+      nearest = j;
+      found = true;
+    }
+  }
+  assert(found);
+  return nearest;
+}
+
 }
 }
@@ -8,7 +8,11 @@
 
 #include "MutableVocabularyTree.hpp"
 #include "SimpleKmeans.hpp"
-#include <deque>
+
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <cstdint>
+#include <vector>
 //#include <cstdio> //DEBUG
 
 namespace aliceVision {
@@ -41,6 +45,10 @@ public:
    * @brief Build a new vocabulary tree.
    *
    * The number of words in the resulting vocabulary is at most k ^ levels.
+   * The sibling nodes of a level are clustered concurrently once there are enough
+   * nodes to occupy all the threads, before that each k-means is parallelized.
+   * Each node has its own random generator, seeded from the k-means seed and the node index,
+   * so the tree does not depend on the order in which the nodes are clustered.
    *
    * @param training_features The set of training features to cluster.
    * @param k                 The branching factor, or max children of any node.
@@ -105,69 +113,79 @@ void TreeBuilder<Feature, DistanceT, FeatureAllocator>::build(const FeatureVecto
   tree_.centers().reserve(tree_.nodes());
   tree_.validCenters().reserve(tree_.nodes());
 
-  // We keep a queue of disjoint feature subsets to cluster.
+  // We keep the disjoint feature subsets to cluster at the current level.
   // Feature* is used to avoid copying features.
-  std::deque< std::vector<Feature*> > subset_queue(1);
+  std::vector< std::vector<Feature*> > subsets(1);
 
   {
-    // At first the queue contains one "subset" containing all the features.
-    std::vector<Feature*> &feature_ptrs = subset_queue.front();
+    // At first there is one "subset" containing all the features.
+    std::vector<Feature*> &feature_ptrs = subsets.front();
     feature_ptrs.reserve(training_features.size());
     for(const Feature& f: training_features)
     {
       feature_ptrs.push_back(const_cast<Feature*> (&f));
     }
   }
-  FeatureVector centers; // always size k
   for(uint32_t level = 0; level < levels; ++level)
   {
     if(verbose_) printf("# Level %u\n", level);
-    std::vector<unsigned int> membership;
 
-    for(std::size_t i = 0, ie = subset_queue.size(); i < ie; ++i)
+    // The k centers of the subset i are stored at levelBegin + i * k,
+    // its k new subsets at i * k in the subsets of the next level.
+    const std::size_t nbSubsets = subsets.size();
+    const std::size_t levelBegin = tree_.centers().size();
+    tree_.centers().resize(levelBegin + nbSubsets * k, zero_);
+    tree_.validCenters().resize(levelBegin + nbSubsets * k, 0);
+    std::vector< std::vector<Feature*> > new_subsets(nbSubsets * k);
+
+    // Cluster the sibling nodes concurrently if there are enough of them,
+    // otherwise the k-means of each node uses all the threads.
+    const bool parallelNodes = nbSubsets >= static_cast<std::size_t>(omp_get_max_threads());
+
+    #pragma omp parallel for schedule(dynamic) if(parallelNodes)
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(nbSubsets); ++i)
     {
-      std::vector<Feature*> &subset = subset_queue.front();
-      if(verbose_ > 1) printf("#\tClustering subset %lu/%lu of size %lu\n", i + 1, ie, subset.size());
+      std::vector<Feature*> &subset = subsets[i];
+      if(verbose_ > 1) printf("#\tClustering subset %lu/%lu of size %lu\n", static_cast<std::size_t>(i) + 1, nbSubsets, subset.size());
+
+      const std::size_t centersBegin = levelBegin + i * k;
 
       // If the subset already has k or fewer elements, just use those as the centers.
+      // The non-existent centers stay invalid and their k empty subsets mark all
+      // their children invalid.
       if(subset.size() <= k)
       {
         if(verbose_ > 2) printf("#\tno need to cluster %lu elements\n", subset.size());
         for(std::size_t j = 0; j < subset.size(); ++j)
         {
-          tree_.centers().push_back(*subset[j]);
-          tree_.validCenters().push_back(1);
+          tree_.centers()[centersBegin + j] = *subset[j];
+          tree_.validCenters()[centersBegin + j] = 1;
         }
-        // Mark non-existent centers as invalid.
-        tree_.centers().insert(tree_.centers().end(), k - subset.size(), zero_);
-        tree_.validCenters().insert(tree_.validCenters().end(), k - subset.size(), 0);
-
-        // Push k empty subsets into the queue so all children get marked invalid.
-        subset_queue.pop_front();
-        subset_queue.insert(subset_queue.end(), k, std::vector<Feature*>());
       }
       else
       {
         // Cluster the current subset into k centers.
         if(verbose_ > 2) printf("#\tclustering the current subset of %lu elements into %d centers\n", subset.size(), k);
-        kmeans_.clusterPointers(subset, k, centers, membership);
+        FeatureVector centers; // always size k
+        std::vector<unsigned int> membership;
+        // the centers index of the node is unique in the tree
+        const std::uint32_t nodeSeed = kmeans_.getSeed() + static_cast<std::uint32_t>(centersBegin);
+        kmeans_.clusterPointers(subset, k, centers, membership, nodeSeed);
         // Add the centers and mark them as valid.
-        tree_.centers().insert(tree_.centers().end(), centers.begin(), centers.end());
-        tree_.validCenters().insert(tree_.validCenters().end(), k, 1);
+        std::copy(centers.begin(), centers.end(), tree_.centers().begin() + centersBegin);
+        std::fill(tree_.validCenters().begin() + centersBegin, tree_.validCenters().begin() + centersBegin + k, 1);
         // Partition the current subset into k new subsets based on the cluster assignments.
-        std::vector< std::vector<Feature*> > new_subsets(k);
         assert(membership.size() >= subset.size());
         for(std::size_t j = 0; j < subset.size(); ++j)
         {
           assert(membership[j] < k);
-          assert(membership[j] < new_subsets.size());
-          new_subsets[ membership[j] ].push_back(subset[j]);
+          new_subsets[i * k + membership[j]].push_back(subset[j]);
         }
-        // Update the queue
-        subset_queue.pop_front();
-        subset_queue.insert(subset_queue.end(), new_subsets.begin(), new_subsets.end());
       }
+      // The subset is not needed anymore.
+      std::vector<Feature*>().swap(subset);
     }
+    subsets.swap(new_subsets);
     if(verbose_) printf("# centers so far = %lu\n", tree_.centers().size());
   }
 }
@@ -5,36 +5,46 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "VocabularyTree.hpp"
+#include "FlatSparseHistogram.hpp"
 
 namespace aliceVision {
 namespace voctree {
 
-float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const std::string &distanceMethod, const std::vector<float>& word_weights)
+namespace {
+
+/// The word of a SparseHistogram or FlatSparseHistogram iterator
+inline Word word(const SparseHistogram::const_iterator& it) { return it->first; }
+inline Word word(const FlatSparseHistogram::const_iterator& it) { return it.word(); }
+
+/// The number of features of a SparseHistogram or FlatSparseHistogram iterator
+inline std::size_t count(const SparseHistogram::const_iterator& it) { return it->second.size(); }
+inline std::size_t count(const FlatSparseHistogram::const_iterator& it) { return it.count(); }
+
+/// Distance between two histograms given by their iterators on the (word, number of features) in increasing word order
+template<class Iterator>
+float sparseDistance(Iterator i1, Iterator i1e, Iterator i2, Iterator i2e, const std::string &distanceMethod, const std::vector<float>& word_weights)
 {
 
   float distance = 0.0f;
   float epsilon = 0.001;
   
-  SparseHistogram::const_iterator i1 = v1.begin(), i1e = v1.end();
-  SparseHistogram::const_iterator i2 = v2.begin(), i2e = v2.end();
-  
   if(distanceMethod.compare("classic") == 0) 
   {      
     while(i1 != i1e && i2 != i2e)
     {
-      if(i2->first < i1->first)
+      if(word(i2) < word(i1))
       {
-        distance += i2->second.size();
+        distance += count(i2);
         ++i2;
       }
-      else if(i1->first < i2->first)
+      else if(word(i1) < word(i2))
       {
-        distance += i1->second.size();
+        distance += count(i1);
         ++i1;
       }
       else
       {
-        distance += fabs(i1->second.size() - i2->second.size());
+        distance += fabs(count(i1) - count(i2));
         ++i1;
         ++i2;
       }
@@ -42,13 +52,13 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
 
     while(i1 != i1e)
     {
-      distance += i1->second.size();
+      distance += count(i1);
       ++i1;
     }
 
     while(i2 != i2e)
     {
-      distance += i2->second.size();
+      distance += count(i2);
       ++i2;
     }
   }
@@ -61,21 +71,21 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
     
     while(i1 != i1e && i2 != i2e)
     {
-      if(i2->first < i1->first)
+      if(word(i2) < word(i1))
       {
-        N2 += i2->second.size();
+        N2 += count(i2);
         ++i2;
       }
-      else if(i1->first < i2->first)
+      else if(word(i1) < word(i2))
       {
-        N1 += i1->second.size();
+        N1 += count(i1);
          ++i1;
       }
       else
       {
-        score += std::min(i1->second.size(), i2->second.size());
-        N1 += i1->second.size();
-        N2 += i2->second.size();
+        score += std::min(count(i1), count(i2));
+        N1 += count(i1);
+        N2 += count(i2);
         ++i1;
         ++i2;
       }
@@ -83,13 +93,13 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
 
     while(i1 != i1e)
     {
-      N1 += i1->second.size();
+      N1 += count(i1);
       ++i1;
     }
 
     while(i2 != i2e)
     {
-      N2 += i2->second.size();
+      N2 += count(i2);
       ++i2;
     }
     
@@ -104,19 +114,19 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
     
     while(i1 != i1e && i2 != i2e)
     {
-      if(i2->first < i1->first)
+      if(word(i2) < word(i1))
       {
-        N2 += i2->second.size();
+        N2 += count(i2);
         ++i2;
       }
-      else if(i1->first < i2->first)
+      else if(word(i1) < word(i2))
       {
-        N1 += i1->second.size();
+        N1 += count(i1);
         ++i1;
       }
       else
       {
-        if( ( fabs(i1->second.size() - 1.0) < epsilon ) && ( fabs(i2->second.size() - 1.0) < epsilon) )
+        if( ( fabs(count(i1) - 1.0) < epsilon ) && ( fabs(count(i2) - 1.0) < epsilon) )
         {
           score += 1;
           N1 += 1;
@@ -129,13 +139,13 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
 
     while(i1 != i1e)
     {
-      N1 += i1->second.size();
+      N1 += count(i1);
       ++i1;
     }
 
     while(i2 != i2e)
     {
-      N2 += i2->second.size();
+      N2 += count(i2);
       ++i2;
     }
     
@@ -150,21 +160,21 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
     
     while(i1 != i1e && i2 != i2e)
     {
-      if(i2->first < i1->first)
+      if(word(i2) < word(i1))
       {
-        N2 += i2->second.size()*word_weights[i2->first];
+        N2 += count(i2)*word_weights[word(i2)];
         ++i2;
       }
-      else if(i1->first < i2->first)
+      else if(word(i1) < word(i2))
       {
-        N1 += i1->second.size()*word_weights[i1->first];
+        N1 += count(i1)*word_weights[word(i1)];
          ++i1;
       }
-        if( ( fabs(i1->second.size() - 1.0) < epsilon ) && ( fabs(i2->second.size() - 1.0) < epsilon) )
+        if( ( fabs(count(i1) - 1.0) < epsilon ) && ( fabs(count(i2) - 1.0) < epsilon) )
         {
-          score += word_weights[i1->first];
-          N1 += word_weights[i1->first];
-          N2 += word_weights[i2->first];
+          score += word_weights[word(i1)];
+          N1 += word_weights[word(i1)];
+          N2 += word_weights[word(i2)];
         }
         ++i1;
         ++i2;
@@ -172,13 +182,13 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
 
     while(i1 != i1e)
     {
-      N1 += i1->second.size()*word_weights[i1->first];
+      N1 += count(i1)*word_weights[word(i1)];
       ++i1;
     }
 
     while(i2 != i2e)
     {
-      N2 += i2->second.size()*word_weights[i2->first];
+      N2 += count(i2)*word_weights[word(i2)];
       ++i2;
     }
     
@@ -194,21 +204,21 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
     
     while(i1 != i1e && i2 != i2e)
     {
-      if(i2->first < i1->first)
+      if(word(i2) < word(i1))
       {
-        N2 += i2->second.size() / word_weights[i2->first];
+        N2 += count(i2) / word_weights[word(i2)];
         ++i2;
       }
-      else if(i1->first < i2->first)
+      else if(word(i1) < word(i2))
       {
-        N1 += i1->second.size() / word_weights[i1->first];
+        N1 += count(i1) / word_weights[word(i1)];
          ++i1;
       }
       else
       {
-        compteur[i1->first] += std::min(i1->second.size(), i2->second.size());
-        N1 += i1->second.size() / word_weights[i1->first];
-        N2 += i2->second.size() / word_weights[i2->first];
+        compteur[word(i1)] += std::min(count(i1), count(i2));
+        N1 += count(i1) / word_weights[word(i1)];
+        N2 += count(i2) / word_weights[word(i2)];
         ++i1;
         ++i2;
       }
@@ -216,13 +226,13 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
 
     while(i1 != i1e)
     {
-      N1 += i1->second.size() / word_weights[i1->first];
+      N1 += count(i1) / word_weights[word(i1)];
       ++i1;
     }
 
     while(i2 != i2e)
     {
-      N2 += i2->second.size() / word_weights[i2->first];;
+      N2 += count(i2) / word_weights[word(i2)];;
       ++i2;
     }
     
@@ -239,5 +249,17 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
   return distance;
 }
 
+} // namespace
+
+float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const std::string &distanceMethod, const std::vector<float>& word_weights)
+{
+  return sparseDistance(v1.begin(), v1.end(), v2.begin(), v2.end(), distanceMethod, word_weights);
+}
+
+float sparseDistance(const FlatSparseHistogram& v1, const FlatSparseHistogram& v2, const std::string &distanceMethod, const std::vector<float>& word_weights)
+{
+  return sparseDistance(v1.begin(), v1.end(), v2.begin(), v2.end(), distanceMethod, word_weights);
+}
+
 } //namespace voctree
 } //namespace aliceVision
\ No newline at end of file
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <aliceVision/voctree/Database.hpp>
+#include <aliceVision/voctree/FlatSparseHistogram.hpp>
 #include <aliceVision/voctree/VocabularyTree.hpp>
 
 #include <string>
@@ -29,6 +30,8 @@ namespace voctree {
  * @param[out] db The built database
  * @param[out] documents A map containing for each image the list of associated visual words
  * @param[in] Nmax The maximum number of features loaded in each desc file. For Nmax = 0 (default), all the descriptors are loaded.
+ * @param[in] histogramCache The cache of the histograms of the images (optional): the cached images are not loaded
+ * nor quantized, the others are added to the cache. The documents then only keep the number of features per word.
  * @return the number of overall features read
  */
 template<class DescriptorT, class VocDescriptorT>
@@ -36,7 +39,26 @@ std::size_t populateDatabase(const sfmData::SfMData& sfmData,
                              const std::vector<std::string>& featuresFolders,
                              const VocabularyTree<VocDescriptorT>& tree,
                              Database& db,
-                             const int Nmax = 0);
+                             const int Nmax = 0,
+                             const HistogramCache* histogramCache = nullptr);
+
+/**
+ * @brief Compute the histogram of the visual words of an image.
+ *
+ * @param[in] viewId The view of the image
+ * @param[in] descriptorsFilepath The descriptor file of the image
+ * @param[in] tree The vocabulary tree to be used for feature quantization
+ * @param[out] histogram The histogram of the image (with the features if there is no cache)
+ * @param[in] Nmax The maximum number of features loaded. For Nmax = 0 (default), all the descriptors are loaded.
+ * @param[in] histogramCache The cache of the histograms of the images (optional)
+ */
+template<class DescriptorT, class VocDescriptorT>
+void computeHistogram(IndexT viewId,
+                      const std::string& descriptorsFilepath,
+                      const VocabularyTree<VocDescriptorT>& tree,
+                      FlatSparseHistogram& histogram,
+                      const int Nmax = 0,
+                      const HistogramCache* histogramCache = nullptr);
 
 /**
  * @brief Given an non empty database, it queries the database with a set of images
@@ -21,42 +21,68 @@
 namespace aliceVision {
 namespace voctree {
 
+template<class DescriptorT, class VocDescriptorT>
+void computeHistogram(IndexT viewId,
+                      const std::string& descriptorsFilepath,
+                      const VocabularyTree<VocDescriptorT>& tree,
+                      FlatSparseHistogram& histogram,
+                      const int Nmax,
+                      const HistogramCache* histogramCache)
+{
+  if(histogramCache != nullptr && histogramCache->load(viewId, descriptorsFilepath, histogram))
+    return;
+
+  std::vector<DescriptorT> descriptors;
+
+  // Read the descriptors
+  loadDescsFromBinFile(descriptorsFilepath, descriptors, false, Nmax);
+
+  // the cache only keeps the number of features per word
+  histogram = FlatSparseHistogram(tree.quantize(descriptors), histogramCache == nullptr);
+
+  if(histogramCache != nullptr && !histogramCache->save(viewId, descriptorsFilepath, histogram))
+    ALICEVISION_LOG_WARNING("Cannot save the histogram of the view " << viewId << " in the cache.");
+}
+
 template<class DescriptorT, class VocDescriptorT>
 std::size_t populateDatabase(const sfmData::SfMData& sfmData,
                              const std::vector<std::string>& featuresFolders,
                              const VocabularyTree<VocDescriptorT>& tree,
                              Database& db,
-                             const int Nmax)
+                             const int Nmax,
+                             const HistogramCache* histogramCache)
 {
   std::map<IndexT, std::string> descriptorsFiles;
   getListOfDescriptorFiles(sfmData, featuresFolders, descriptorsFiles);
   std::size_t numDescriptors = 0;
-  
+
+  const std::vector<std::pair<IndexT, std::string>> descriptorsFilesVector(descriptorsFiles.begin(), descriptorsFiles.end());
+  std::vector<FlatSparseHistogram> histograms(descriptorsFilesVector.size());
+
   // Read the descriptors
   ALICEVISION_LOG_DEBUG("Reading the descriptors from " << descriptorsFiles.size() <<" files...");
   boost::progress_display display(descriptorsFiles.size());
 
-  // Run through the path vector and read the descriptors
-  for(const auto &currentFile : descriptorsFiles)
+  // The images are loaded and quantized in parallel
+  #pragma omp parallel for reduction(+:numDescriptors)
+  for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(descriptorsFilesVector.size()); ++i)
   {
-    
-    std::vector<DescriptorT> descriptors;
-
-    // Read the descriptors
-    loadDescsFromBinFile(currentFile.second, descriptors, false, Nmax);
-    size_t result = descriptors.size();
-    
-    SparseHistogram newDoc =  tree.quantizeToSparse(descriptors);
-
-    // Insert document in database
-    db.insert(currentFile.first, newDoc);
+    const auto& currentFile = descriptorsFilesVector[i];
+    computeHistogram<DescriptorT>(currentFile.first, currentFile.second, tree, histograms[i], Nmax, histogramCache);
 
     // Update the overall counter
-    numDescriptors += result;
-    
-    ++display;
+    numDescriptors += histograms[i].nbFeatures();
+
+    #pragma omp critical
+    {
+      ++display;
+    }
   }
 
+  // Insert the documents in the database, in the order of the files
+  for(std::size_t i = 0; i < descriptorsFilesVector.size(); ++i)
+    db.insert(descriptorsFilesVector[i].first, histograms[i]);
+
   // Return the result
   return numDescriptors;
 }
@@ -43,6 +43,9 @@ void getListOfDescriptorFiles(const sfmData::SfMData& sfmData,
  * @param[in] featuresFolders The folder(s) containing the descriptor files (optional)
  * @param[in,out] descriptors the vector to which append all the read descriptors
  * @param[in,out] numFeatures a vector collecting for each file read the number of features read
+ * @param[in] maxDescriptors if the files contain more descriptors, the same ratio of
+ * evenly spaced descriptors is kept in each file, so that the training set fits in memory
+ * (0 to read all the descriptors)
  * @return the total number of features read
  *
  */
@@ -50,7 +53,8 @@ template<class DescriptorT, class FileDescriptorT>
 std::size_t readDescFromFiles(const sfmData::SfMData& sfmData,
                          const std::vector<std::string>& featuresFolders,
                          std::vector<DescriptorT>& descriptors,
-                         std::vector<std::size_t>& numFeatures);
+                         std::vector<std::size_t>& numFeatures,
+                         std::size_t maxDescriptors = 0);
 
 } // namespace voctree
 } // namespace aliceVision
@@ -11,6 +11,7 @@
 #include <boost/algorithm/string/case_conv.hpp>
 #include <boost/progress.hpp>
 
+#include <cmath>
 #include <iostream>
 #include <fstream>
 
@@ -21,7 +22,8 @@ template<class DescriptorT, class FileDescriptorT>
 std::size_t readDescFromFiles(const sfmData::SfMData& sfmData,
                          const std::vector<std::string>& featuresFolders,
                          std::vector<DescriptorT>& descriptors,
-                         std::vector<std::size_t> &numFeatures)
+                         std::vector<std::size_t> &numFeatures,
+                         std::size_t maxDescriptors)
 {
   namespace bfs = boost::filesystem;
   std::map<IndexT, std::string> descriptorsFiles;
@@ -59,8 +61,14 @@ std::size_t readDescFromFiles(const sfmData::SfMData& sfmData,
     return 0;
   }
 
+  // Ratio of the descriptors to keep in each file
+  const bool subsample = (maxDescriptors > 0) && (numDescriptors > maxDescriptors);
+  const double keepRatio = subsample ? static_cast<double>(maxDescriptors) / numDescriptors : 1.0;
+  if(subsample)
+    ALICEVISION_LOG_INFO("Keeping " << maxDescriptors << " of the " << numDescriptors << " descriptors (" << keepRatio * 100.0 << "%)");
+
   // Allocate the memory
-  descriptors.reserve(numDescriptors);
+  descriptors.reserve(subsample ? maxDescriptors + descriptorsFiles.size() : numDescriptors);
   std::size_t numDescriptorsCheck = numDescriptors; // for later check
   numDescriptors = 0;
 
@@ -68,11 +76,29 @@ std::size_t readDescFromFiles(const sfmData::SfMData& sfmData,
   ALICEVISION_LOG_DEBUG("Reading the descriptors...");
   display.restart(descriptorsFiles.size());
 
+  // descriptors of the current file, in their file representation
+  std::vector<FileDescriptorT> fileDescriptors;
+
   // Run through the path vector and read the descriptors
   for(const auto &currentFile : descriptorsFiles)
   {
-    // Read the descriptors and append them in the vector
-    feature::loadDescsFromBinFile<DescriptorT, FileDescriptorT>(currentFile.second, descriptors, true);
+    if(subsample)
+    {
+      // Only one file is loaded at a time, then the evenly spaced descriptors are kept
+      feature::loadDescsFromBinFile<FileDescriptorT, FileDescriptorT>(currentFile.second, fileDescriptors, false);
+      const std::size_t numKept = static_cast<std::size_t>(std::ceil(fileDescriptors.size() * keepRatio));
+      DescriptorT descriptor;
+      for(std::size_t i = 0; i < numKept; ++i)
+      {
+        feature::convertDesc<FileDescriptorT, DescriptorT>(fileDescriptors[i * fileDescriptors.size() / numKept], descriptor);
+        descriptors.push_back(descriptor);
+      }
+    }
+    else
+    {
+      // Read the descriptors and append them in the vector
+      feature::loadDescsFromBinFile<DescriptorT, FileDescriptorT>(currentFile.second, descriptors, true);
+    }
     std::size_t result = descriptors.size();
 
     // Add the number of descriptors from this file
@@ -83,7 +109,7 @@ std::size_t readDescFromFiles(const sfmData::SfMData& sfmData,
 
     ++display;
   }
-  assert(numDescriptors == numDescriptorsCheck);
+  assert(subsample || numDescriptors == numDescriptorsCheck);
 
   // Return the result
   return numDescriptors;
@@ -290,3 +290,80 @@ BOOST_AUTO_TEST_CASE(kmeanVarying)
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(kmeanMiniBatch)
+{
+  using namespace aliceVision;
+  ALICEVISION_LOG_DEBUG("Testing mini-batch kmeans...");
+
+  const std::size_t DIMENSION = 16;
+  const std::size_t FEATURENUMBER = 1000;
+  const std::size_t K = 8;
+  const std::size_t STEP = 5 * K;
+
+  typedef Eigen::RowVectorXf FeatureFloat;
+  typedef std::vector<FeatureFloat, Eigen::aligned_allocator<FeatureFloat> > FeatureFloatVector;
+
+  FeatureFloatVector features;
+  FeatureFloatVector centers;
+  std::vector<unsigned int> membership;
+  features.reserve(FEATURENUMBER * K);
+
+  // generate k clusters well far away
+  for(std::size_t i = 0; i < K; ++i)
+  {
+    for(std::size_t j = 0; j < FEATURENUMBER; ++j)
+      features.push_back((FeatureFloat::Random(DIMENSION) + FeatureFloat::Constant(DIMENSION, STEP * i) - FeatureFloat::Constant(DIMENSION, STEP * (K - 1) / 2)) / ((STEP * (K - 1) / 2) * sqrt(DIMENSION)));
+  }
+
+  voctree::SimpleKmeans<FeatureFloat> kmeans(FeatureFloat::Zero(DIMENSION));
+  kmeans.setVerbose(0);
+  kmeans.setRestarts(3);
+  kmeans.setMiniBatchSize(200);
+  BOOST_CHECK_EQUAL(kmeans.getMiniBatchSize(), 200);
+
+  kmeans.cluster(features, K, centers, membership);
+
+  BOOST_CHECK_EQUAL(centers.size(), K);
+  BOOST_CHECK(voctree::checkVectorElements(centers, "minibatch"));
+  BOOST_CHECK_EQUAL(membership.size(), features.size());
+
+  // all the features of a generated cluster are assigned to the same center
+  std::vector<std::size_t> h(K, 0);
+  for(std::size_t i = 0; i < K; ++i)
+  {
+    const unsigned int center = membership[i * FEATURENUMBER];
+    for(std::size_t j = 0; j < FEATURENUMBER; ++j)
+      BOOST_CHECK_EQUAL(membership[i * FEATURENUMBER + j], center);
+    ++h[center];
+  }
+  for(std::size_t i = 0; i < h.size(); ++i)
+    BOOST_CHECK_EQUAL(h[i], 1);
+
+  // a set smaller than the batch size is clustered with the Lloyd's algorithm
+  FeatureFloatVector smallFeatures(features.begin(), features.begin() + 100);
+  kmeans.cluster(smallFeatures, 4, centers, membership);
+  BOOST_CHECK_EQUAL(centers.size(), 4);
+  BOOST_CHECK_EQUAL(membership.size(), smallFeatures.size());
+}
+
+BOOST_AUTO_TEST_CASE(kmeanDescriptorDistance)
+{
+  using namespace aliceVision;
+
+  typedef feature::Descriptor<float, 128> DescriptorFloat;
+  typedef feature::Descriptor<unsigned char, 128> DescriptorUChar;
+
+  DescriptorFloat a, b;
+  DescriptorUChar ua, ub;
+  for(std::size_t i = 0; i < 128; ++i)
+  {
+    a[i] = ua[i] = static_cast<unsigned char>(i);
+    b[i] = ub[i] = static_cast<unsigned char>(255 - 2 * i);
+  }
+
+  // the vectorized float distance matches the generic one
+  const double expected = voctree::L2<DescriptorUChar>()(ua, ub);
+  BOOST_CHECK_CLOSE(voctree::L2<DescriptorFloat>()(a, b), expected, 1e-4);
+  BOOST_CHECK_EQUAL(voctree::L2<DescriptorFloat>()(a, a), 0.0);
+}
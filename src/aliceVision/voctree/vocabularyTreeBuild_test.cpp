@@ -6,9 +6,11 @@
 
 #include <aliceVision/voctree/TreeBuilder.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <Eigen/Core>
 
+#include <cstdint>
 #include <iostream>
 #include <fstream>
 #include <vector>
@@ -83,3 +85,86 @@ BOOST_AUTO_TEST_CASE(voctreeBuilder)
   }
 //  voctree::printFeatVector( features ); 
 }
+
+BOOST_AUTO_TEST_CASE(voctreeBuilderMiniBatch)
+{
+  using namespace aliceVision;
+
+  const std::size_t DIMENSION = 3;
+  const std::size_t FEATURENUMBER = 100;
+  const std::size_t K = 4;
+  const std::size_t LEVELS = 3;
+  const std::size_t LEAVESNUMBER = std::pow(K, LEVELS);
+  const std::size_t STEP = 1;
+
+  typedef Eigen::Matrix<float, 1, DIMENSION> FeatureFloat;
+  typedef std::vector<FeatureFloat, Eigen::aligned_allocator<FeatureFloat> > FeatureFloatVector;
+
+  FeatureFloatVector features;
+  features.reserve(FEATURENUMBER * LEAVESNUMBER);
+
+  for(std::size_t i = 0; i < LEAVESNUMBER; ++i)
+  {
+    for(std::size_t j = 0; j < FEATURENUMBER; ++j)
+      features.push_back((FeatureFloat::Random(1, DIMENSION) + Eigen::MatrixXf::Constant(1, DIMENSION, STEP * i) - Eigen::MatrixXf::Constant(1, DIMENSION, STEP * (LEAVESNUMBER - 1) / 2)) / ((STEP * (LEAVESNUMBER - 1) / 2) * sqrt(DIMENSION)));
+  }
+
+  // the first levels use the mini-batch k-means, the last one the standard k-means
+  voctree::TreeBuilder<FeatureFloat> builder(FeatureFloat::Zero());
+  builder.setVerbose(0);
+  builder.kmeans().setRestarts(3);
+  builder.kmeans().setMiniBatchSize(500);
+  builder.build(features, K, LEVELS);
+
+  BOOST_CHECK_EQUAL(builder.tree().centers().size(), K + K * K + K * K * K);
+  BOOST_CHECK_EQUAL(builder.tree().words(), LEAVESNUMBER);
+
+  // the centers should all be valid in this configuration
+  const std::vector<uint8_t>& valid = builder.tree().validCenters();
+  for(std::size_t i = 0; i < valid.size(); ++i)
+    BOOST_CHECK(valid[i] != 0);
+
+  // each feature is quantized in a valid word
+  for(std::size_t i = 0; i < features.size(); i += 37)
+    BOOST_CHECK_LT(builder.tree().quantize(features[i]), LEAVESNUMBER);
+}
+
+BOOST_AUTO_TEST_CASE(voctreeBuilderReproducible)
+{
+  using namespace aliceVision;
+
+  const std::size_t DIMENSION = 3;
+  const std::size_t FEATURENUMBER = 50;
+  const std::size_t K = 3;
+  const std::size_t LEVELS = 3;
+
+  typedef Eigen::Matrix<float, 1, DIMENSION> FeatureFloat;
+  typedef std::vector<FeatureFloat, Eigen::aligned_allocator<FeatureFloat> > FeatureFloatVector;
+
+  FeatureFloatVector features;
+  for(std::size_t i = 0; i < FEATURENUMBER * K * K * K; ++i)
+    features.push_back(FeatureFloat::Random(1, DIMENSION));
+
+  // the sibling nodes are clustered concurrently as soon as there are as many nodes as threads:
+  // each node has its own generator, the trees built with the same seed are identical
+  const int nbThreads = omp_get_max_threads();
+  omp_set_num_threads(K);
+
+  const auto buildTree = [&](std::uint32_t seed, std::size_t miniBatchSize) -> FeatureFloatVector
+  {
+    voctree::TreeBuilder<FeatureFloat> builder(FeatureFloat::Zero());
+    builder.kmeans().setSeed(seed);
+    builder.kmeans().setMiniBatchSize(miniBatchSize);
+    builder.build(features, K, LEVELS);
+    return builder.tree().centers();
+  };
+
+  for(const std::size_t miniBatchSize : {std::size_t(0), std::size_t(200)})
+  {
+    const FeatureFloatVector centers = buildTree(42, miniBatchSize);
+    BOOST_CHECK(centers == buildTree(42, miniBatchSize));
+    BOOST_CHECK(centers != buildTree(43, miniBatchSize));
+  }
+
+  omp_set_num_threads(nbThreads);
+}
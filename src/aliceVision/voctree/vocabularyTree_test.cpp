@@ -8,6 +8,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <vector>
 
 #define BOOST_TEST_MODULE vocabularyTree
@@ -57,3 +58,164 @@ BOOST_AUTO_TEST_CASE(database)
     BOOST_CHECK_SMALL(static_cast<double>(match[0].score), 0.001);
   }
 }
+
+BOOST_AUTO_TEST_CASE(databaseSaveLoad)
+{
+  const int cardDocuments = 10;
+  const int cardWords = 12;
+
+  // documents sharing some words, with repeated words
+  Database db(2 * cardWords);
+  for(int i = 0; i < cardDocuments; ++i)
+  {
+    vector<Word> document;
+    for(int j = 0; j < cardWords; ++j)
+      document.push_back((i + j * j) % (2 * cardWords));
+    SparseHistogram histo;
+    computeSparseHistogram(document, histo);
+    db.insert(10 * i, histo);
+  }
+  db.computeTfIdfWeights();
+
+  std::stringstream stream;
+  db.save(stream);
+
+  Database loadedDb;
+  loadedDb.load(stream);
+
+  BOOST_CHECK_EQUAL(loadedDb.size(), db.size());
+  BOOST_CHECK(loadedDb.getSparseHistogramPerImage() == db.getSparseHistogramPerImage());
+
+  // same matches with the loaded weights and inverted files
+  for(const auto& document : db.getSparseHistogramPerImage())
+  {
+    vector<DocMatch> matches, loadedMatches;
+    db.find(document.second, 4, matches);
+    loadedDb.find(document.second, 4, loadedMatches);
+    BOOST_CHECK(matches == loadedMatches);
+  }
+
+  // truncated stream
+  const std::string data = stream.str();
+  std::stringstream truncatedStream(data.substr(0, data.size() / 2));
+  BOOST_CHECK_THROW(loadedDb.load(truncatedStream), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(databaseBatchFind)
+{
+  const int cardDocuments = 10;
+  const int cardWords = 12;
+
+  Database db(2 * cardWords);
+  for(int i = 0; i < cardDocuments; ++i)
+  {
+    vector<Word> document;
+    for(int j = 0; j < cardWords; ++j)
+      document.push_back((i + j * j) % (2 * cardWords));
+    SparseHistogram histo;
+    computeSparseHistogram(document, histo);
+    db.insert(i, histo);
+  }
+  db.computeTfIdfWeights();
+
+  std::vector<SparseHistogram> queries;
+  for(const auto& document : db.getSparseHistogramPerImage())
+    queries.push_back(document.second);
+
+  // the batch query gives the same matches as the queries one by one
+  std::vector<DocMatches> batchMatches;
+  db.find(queries, 4, batchMatches);
+  BOOST_CHECK_EQUAL(batchMatches.size(), queries.size());
+
+  for(std::size_t q = 0; q < queries.size(); ++q)
+  {
+    vector<DocMatch> matches;
+    db.find(queries[q], 4, matches);
+    BOOST_CHECK(matches == batchMatches[q]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(flatSparseHistogram)
+{
+  const int cardDocuments = 10;
+  const int cardWords = 12;
+
+  std::vector<FlatSparseHistogram> flatHistograms;
+  std::vector<SparseHistogram> histograms;
+  for(int i = 0; i < cardDocuments; ++i)
+  {
+    // repeated words, not sorted
+    vector<Word> document;
+    for(int j = 0; j < cardWords; ++j)
+      document.push_back((i + j * j) % (2 * cardWords));
+    SparseHistogram histo;
+    computeSparseHistogram(document, histo);
+    histograms.push_back(histo);
+
+    const FlatSparseHistogram flatHisto(document);
+    BOOST_CHECK(flatHisto.hasFeatures());
+    BOOST_CHECK_EQUAL(flatHisto.size(), histo.size());
+    BOOST_CHECK_EQUAL(flatHisto.nbFeatures(), document.size());
+    BOOST_CHECK(flatHisto.toSparseHistogram() == histo);
+    BOOST_CHECK(FlatSparseHistogram(histo) == flatHisto);
+    flatHistograms.push_back(flatHisto);
+
+    // without the features, only the number of features per word is kept
+    const FlatSparseHistogram countHisto(document, false);
+    BOOST_CHECK(!countHisto.hasFeatures());
+    BOOST_CHECK(countHisto.words() == flatHisto.words());
+    BOOST_CHECK(countHisto.counts() == flatHisto.counts());
+    const SparseHistogram countSparseHisto = countHisto.toSparseHistogram();
+    BOOST_CHECK_EQUAL(countSparseHisto.size(), histo.size());
+    for(const auto& word : histo)
+      BOOST_CHECK_EQUAL(countSparseHisto.at(word.first).size(), word.second.size());
+  }
+
+  // same distances as the SparseHistograms
+  const std::vector<float> weights(2 * cardWords, 0.5f);
+  for(const std::string distanceMethod : {"classic", "commonPoints", "strongCommonPoints", "inversedWeightedCommonPoints"})
+  {
+    for(int i = 0; i < cardDocuments; ++i)
+    {
+      for(int j = 0; j < cardDocuments; ++j)
+      {
+        BOOST_CHECK_EQUAL(sparseDistance(flatHistograms[i], flatHistograms[j], distanceMethod, weights),
+                          sparseDistance(histograms[i], histograms[j], distanceMethod, weights));
+      }
+    }
+  }
+
+  // save / load, with and without the features
+  for(bool withFeatures : {true, false})
+  {
+    const FlatSparseHistogram histo(histograms.front(), withFeatures);
+    std::stringstream stream;
+    histo.save(stream);
+
+    FlatSparseHistogram loadedHisto;
+    loadedHisto.load(stream);
+    BOOST_CHECK(loadedHisto == histo);
+
+    const std::string data = stream.str();
+    std::stringstream truncatedStream(data.substr(0, data.size() - 2));
+    BOOST_CHECK_THROW(loadedHisto.load(truncatedStream), std::runtime_error);
+  }
+
+  // a database built from the flat histograms gives the same matches
+  Database db(2 * cardWords);
+  Database flatDb(2 * cardWords);
+  for(int i = 0; i < cardDocuments; ++i)
+  {
+    db.insert(i, histograms[i]);
+    flatDb.insert(i, flatHistograms[i]);
+  }
+  db.computeTfIdfWeights();
+  flatDb.computeTfIdfWeights();
+  for(int i = 0; i < cardDocuments; ++i)
+  {
+    vector<DocMatch> matches, flatMatches;
+    db.find(histograms[i], 4, matches);
+    flatDb.find(histograms[i], 4, flatMatches);
+    BOOST_CHECK(matches == flatMatches);
+  }
+}
@@ -0,0 +1,200 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/feature/akaze/AKAZE.hpp>
+#include <aliceVision/feature/akaze/ImageDescriber_AKAZE.hpp>
+#include <aliceVision/image/all.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 2
+
+using namespace aliceVision;
+using namespace aliceVision::feature;
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Synthetic 4:3 image made of random discs (blob and corner responses at all scales).
+ */
+image::Image<float> createSyntheticImage(int width)
+{
+  const int height = width * 3 / 4;
+  std::mt19937 randomNumberGenerator(0);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+
+  image::Image<float> img(width, height, true, 0.2f);
+  for(int i = 0; i < width / 4; ++i)
+  {
+    const float cx = uniform(randomNumberGenerator) * width;
+    const float cy = uniform(randomNumberGenerator) * height;
+    const float radius = 3.f + uniform(randomNumberGenerator) * width / 50.f;
+    const float value = uniform(randomNumberGenerator);
+    for(int y = std::max(0, int(cy - radius)); y < std::min(height, int(cy + radius)); ++y)
+      for(int x = std::max(0, int(cx - radius)); x < std::min(width, int(cx + radius)); ++x)
+        if(Square(x - cx) + Square(y - cy) < Square(radius))
+          img(y, x) = value;
+  }
+  return img;
+}
+
+/**
+ * @brief Time each stage of the AKAZE extraction of an image.
+ */
+void benchmarkImage(const image::Image<float>& img, int nbRepetitions)
+{
+  double scaleSpaceTime = 0.0;
+  double detectionTime = 0.0;
+  double extractionTime = 0.0;
+  std::size_t nbKeypoints = 0;
+  std::size_t nbFeatures = 0;
+  image::resetImagePoolStatistics();
+
+  for(int i = 0; i < nbRepetitions; ++i)
+  {
+    AKAZE akaze(img, AKAZEConfig());
+
+    system::Timer timer;
+    akaze.Compute_AKAZEScaleSpace();
+    scaleSpaceTime += timer.elapsedMs();
+
+    timer.reset();
+    std::vector<AKAZEKeypoint> keypoints;
+    akaze.Feature_Detection(keypoints);
+    akaze.Do_Subpixel_Refinement(keypoints);
+    detectionTime += timer.elapsedMs();
+    nbKeypoints = keypoints.size();
+
+    // full extraction: scale space, detection and MSURF descriptors
+    ImageDescriber_AKAZE imageDescriber;
+    std::unique_ptr<Regions> regions;
+    timer.reset();
+    imageDescriber.describe(img, regions);
+    extractionTime += timer.elapsedMs();
+    nbFeatures = regions->RegionCount();
+  }
+
+  ALICEVISION_LOG_INFO("Image " << img.Width() << "x" << img.Height() << ":" << std::endl
+                       << "\t- scale space: " << system::prettyTime(scaleSpaceTime / nbRepetitions) << std::endl
+                       << "\t- detection and refinement: " << system::prettyTime(detectionTime / nbRepetitions)
+                       << " (" << nbKeypoints << " keypoints)" << std::endl
+                       << "\t- full extraction: " << system::prettyTime(extractionTime / nbRepetitions)
+                       << " (" << nbFeatures << " features)");
+
+  const image::ImagePoolStatistics poolStatistics = image::getImagePoolStatistics();
+  ALICEVISION_LOG_INFO("Image buffers: " << poolStatistics.nbAllocations << " allocations ("
+                       << poolStatistics.allocatedBytes / (1024 * 1024) << " MB), "
+                       << poolStatistics.nbReuses << " reuses from the image pool");
+}
+
+/**
+ * @brief Log the memory kept by the thread-local image pools and the resident memory.
+ */
+void logMemory(const std::string& step)
+{
+  ALICEVISION_LOG_INFO(step << ": " << image::ImagePool<float>::localPoolsPooledBytes() / (1024 * 1024) << " MB in the image pools, "
+                       << "resident memory: " << system::getResidentMemory() / (1024 * 1024) << " MB");
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<std::string> imagePaths;
+  std::vector<int> imageWidths = {1024, 2048, 4096, 6912};
+  int nbRepetitions = 1;
+  bool useImagePool = true;
+  int localPoolCapacity = static_cast<int>(image::defaultLocalImagePoolCapacity >> 20);
+  bool releaseImagePools = true;
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+
+  po::options_description allParams("AliceVision Sample featuresAKAZEBenchmark\n"
+                                    "Benchmark of the AKAZE feature extraction on images or on synthetic 4:3 images");
+  allParams.add_options()
+    ("input,i", po::value<std::vector<std::string>>(&imagePaths)->multitoken(),
+      "Input images (synthetic images are used if empty).")
+    ("imageWidths", po::value<std::vector<int>>(&imageWidths)->multitoken()->default_value(imageWidths, "1024 2048 4096 6912"),
+      "Width of the synthetic images (the height is 3/4 of the width).")
+    ("nbRepetitions", po::value<int>(&nbRepetitions)->default_value(nbRepetitions),
+      "Number of runs of each measure.")
+    ("imagePool", po::value<bool>(&useImagePool)->default_value(useImagePool),
+      "Reuse the image buffers through the image pools (run once with each value to compare the peak memory).")
+    ("localPoolCapacity", po::value<int>(&localPoolCapacity)->default_value(localPoolCapacity),
+      "Memory kept by each thread-local image pool (in MB).")
+    ("releaseImagePools", po::value<bool>(&releaseImagePools)->default_value(releaseImagePools),
+      "Free the thread-local image pools after each image, as the feature extraction does after each job.")
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  ALICEVISION_LOG_INFO("Number of threads: " << omp_get_max_threads());
+  image::setImagePoolEnabled(useImagePool);
+  image::ImagePool<float>::setLocalPoolsCapacity(static_cast<std::size_t>(localPoolCapacity) << 20);
+
+  // an image is a job: free the thread-local pools once it is done
+  const auto endJob = [&]()
+  {
+    logMemory("End of the image");
+    if(releaseImagePools)
+    {
+      image::ImagePool<float>::clearLocalPools();
+      logMemory("Image pools released");
+    }
+  };
+
+  if(!imagePaths.empty())
+  {
+    for(const std::string& imagePath : imagePaths)
+    {
+      image::Image<float> img;
+      image::readImage(imagePath, img);
+      ALICEVISION_LOG_INFO("Input image: " << imagePath);
+      benchmarkImage(img, nbRepetitions);
+      endJob();
+    }
+  }
+  else
+  {
+    for(int width : imageWidths)
+    {
+      benchmarkImage(createSyntheticImage(width), nbRepetitions);
+      endJob();
+    }
+  }
+
+  ALICEVISION_LOG_INFO("Peak resident memory: " << system::getPeakResidentMemory() / (1024 * 1024) << " MB");
+
+  return EXIT_SUCCESS;
+}
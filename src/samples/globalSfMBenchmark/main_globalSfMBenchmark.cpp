@@ -0,0 +1,152 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/sfm.hpp>
+#include <aliceVision/sfm/utils/syntheticScene.hpp>
+#include <aliceVision/sfm/pipeline/global/GlobalSfMTranslationAveragingSolver.hpp>
+#include <aliceVision/feature/FeaturesPerView.hpp>
+#include <aliceVision/matching/IndMatch.hpp>
+#include <aliceVision/multiview/NViewDataSet.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+using namespace aliceVision::sfmData;
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Convert the features in normalized camera frames, as done by ReconstructionEngine_globalSfM.
+ */
+void normalizeFeatures(const SfMData& sfmData, feature::FeaturesPerView& featuresPerView)
+{
+  for(auto& viewFeatures: featuresPerView.getData())
+  {
+    const View& view = *sfmData.getViews().at(viewFeatures.first);
+    const camera::IntrinsicBase& cam = *sfmData.getIntrinsics().at(view.getIntrinsicId());
+
+    for(auto& featuresPerDesc: viewFeatures.second)
+    {
+      for(feature::PointFeature& feature: featuresPerDesc.second)
+      {
+        const Vec3 bearingVector = cam(cam.get_ud_pixel(feature.coords().cast<double>()));
+        feature.coords() << (bearingVector.head(2) / bearingVector(2)).cast<float>();
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<int> nbViewsList = {1000, 5000, 20000};
+  int nbPoints = 256;
+  int translationAveragingMethod = static_cast<int>(TRANSLATION_AVERAGING_SOFTL1);
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+
+  po::options_description allParams("AliceVision Sample globalSfMBenchmark\n"
+                                    "Benchmark of the global SfM relative translations estimation on synthetic camera rings");
+  allParams.add_options()
+    ("nbViews", po::value<std::vector<int>>(&nbViewsList)->multitoken()->default_value(nbViewsList, "1000 5000 20000"),
+      "Number of views of the synthetic scenes.")
+    ("nbPoints", po::value<int>(&nbPoints)->default_value(nbPoints),
+      "Number of 3D points of the synthetic scenes.")
+    ("translationAveraging", po::value<int>(&translationAveragingMethod)->default_value(translationAveragingMethod),
+      "* 1: L1 minimization\n"
+      "* 2: L2 minimization of sum of squared Chordal distances\n"
+      "* 3: SoftL1 minimization")
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  if(translationAveragingMethod < TRANSLATION_AVERAGING_L1 ||
+     translationAveragingMethod > TRANSLATION_AVERAGING_SOFTL1)
+  {
+    ALICEVISION_LOG_ERROR("Translation averaging method is invalid");
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_LOG_INFO("Number of threads: " << omp_get_max_threads());
+
+  for(int nbViews: nbViewsList)
+  {
+    const NViewDatasetConfigurator config;
+    const NViewDataSet d = NRealisticCamerasRing(nbViews, nbPoints, config);
+    const SfMData sfmData = getInputScene(d, config, camera::PINHOLE_CAMERA);
+
+    std::normal_distribution<double> distribution(0.0, 0.5);
+    feature::FeaturesPerView featuresPerView;
+    generateSyntheticFeatures(featuresPerView, feature::EImageDescriberType::UNKNOWN, sfmData, distribution);
+    normalizeFeatures(sfmData, featuresPerView);
+
+    matching::PairwiseMatches pairwiseMatches;
+    generateSyntheticMatches(pairwiseMatches, sfmData, feature::EImageDescriberType::UNKNOWN);
+
+    // use the ground truth rotations as global rotations
+    HashMap<IndexT, Mat3> globalRotations;
+    for(const auto& posePair: sfmData.getPoses())
+      globalRotations[posePair.first] = posePair.second.getTransform().rotation();
+
+    ALICEVISION_LOG_INFO("Synthetic scene: " << sfmData.getViews().size() << " views, "
+                         << sfmData.getLandmarks().size() << " landmarks, "
+                         << pairwiseMatches.size() << " matching pairs.");
+
+    // remove poses and structure
+    SfMData sfmDataToEstimate = sfmData;
+    sfmDataToEstimate.getPoses().clear();
+    sfmDataToEstimate.structure.clear();
+
+    matching::PairwiseMatches tripletWiseMatches;
+    GlobalSfMTranslationAveragingSolver translationAveragingSolver;
+
+    system::Timer timer;
+    const bool success = translationAveragingSolver.Run(ETranslationAveragingMethod(translationAveragingMethod),
+                                                        sfmDataToEstimate,
+                                                        featuresPerView,
+                                                        pairwiseMatches,
+                                                        globalRotations,
+                                                        tripletWiseMatches);
+    const double translationTime = timer.elapsedMs();
+
+    ALICEVISION_LOG_INFO("\t- translation averaging: " << system::prettyTime(translationTime)
+                         << (success ? "" : " (failed)") << std::endl
+                         << "\t- estimated poses: " << sfmDataToEstimate.getPoses().size());
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/image/Image.hpp>
+#include <aliceVision/image/filtering.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+using namespace aliceVision::image;
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Mean time (in milliseconds) of nbRepetitions calls of a function.
+ */
+template <typename Function>
+double meanTime(int nbRepetitions, Function function)
+{
+  system::Timer timer;
+  for(int i = 0; i < nbRepetitions; ++i)
+    function();
+  return timer.elapsedMs() / nbRepetitions;
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<int> imageWidths = {640, 1920, 4000};
+  std::vector<int> kernelSizes = {3, 7, 15, 31};
+  int nbRepetitions = 5;
+  int nbOctaves = 4;
+  int nbScales = 3;
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+
+  po::options_description allParams("AliceVision Sample imageConvolutionBenchmark\n"
+                                    "Benchmark of the separable convolutions and of the Gaussian pyramid on random 4:3 images");
+  allParams.add_options()
+    ("imageWidths", po::value<std::vector<int>>(&imageWidths)->multitoken()->default_value(imageWidths, "640 1920 4000"),
+      "Width of the images (the height is 3/4 of the width).")
+    ("kernelSizes", po::value<std::vector<int>>(&kernelSizes)->multitoken()->default_value(kernelSizes, "3 7 15 31"),
+      "Size of the kernels (odd numbers).")
+    ("nbRepetitions", po::value<int>(&nbRepetitions)->default_value(nbRepetitions),
+      "Number of runs of each measure.")
+    ("nbOctaves", po::value<int>(&nbOctaves)->default_value(nbOctaves),
+      "Number of octaves of the Gaussian pyramid.")
+    ("nbScales", po::value<int>(&nbScales)->default_value(nbScales),
+      "Number of scales per octave of the Gaussian pyramid.")
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  for(int kernelSize : kernelSizes)
+  {
+    if(kernelSize < 1 || kernelSize % 2 == 0)
+    {
+      ALICEVISION_LOG_ERROR("Invalid kernel size: " << kernelSize << " (must be an odd number)");
+      return EXIT_FAILURE;
+    }
+  }
+
+  ALICEVISION_LOG_INFO("Number of threads: " << omp_get_max_threads());
+
+  std::mt19937 randomNumberGenerator(0);
+  std::uniform_real_distribution<float> pixelValue(0.f, 1.f);
+
+  for(int width : imageWidths)
+  {
+    const int height = width * 3 / 4;
+    Image<float> img(width, height);
+    for(int i = 0; i < img.size(); ++i)
+      img.data()[i] = pixelValue(randomNumberGenerator);
+
+    ALICEVISION_LOG_INFO("Image " << width << "x" << height << ":");
+
+    for(int kernelSize : kernelSizes)
+    {
+      const Vec kernel = ComputeGaussianKernel(kernelSize, kernelSize / 6.0);
+      const Eigen::Matrix<float, 1, Eigen::Dynamic> kernelf = kernel.cast<float>().transpose();
+      Image<float> tmp, out;
+
+      // generic path: horizontal then vertical 1d convolutions
+      const double genericTime = meanTime(nbRepetitions, [&]()
+      {
+        ImageHorizontalConvolution(img, kernelf, tmp);
+        ImageVerticalConvolution(tmp, kernelf, out);
+      });
+
+      // float path: tiled SIMD separable convolution
+      const double separableTime = meanTime(nbRepetitions, [&]()
+      {
+        ImageSeparableConvolution(img, kernel, kernel, out);
+      });
+
+      // blur then half sample vs fused blur and half sample
+      const double blurHalfSampleTime = meanTime(nbRepetitions, [&]()
+      {
+        ImageSeparableConvolution(img, kernel, kernel, tmp);
+        typedef Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic> EvenStride;
+        out = Image<float>(Eigen::Map<const RowMatrixXf, 0, EvenStride>(tmp.data(), (height + 1) / 2, (width + 1) / 2, EvenStride(2 * width, 2)));
+      });
+      const double fusedTime = meanTime(nbRepetitions, [&]()
+      {
+        SeparableConvolution2d(img.GetMat(), kernelf, kernelf, &static_cast<Image<float>::Base&>(out), 2);
+      });
+
+      ALICEVISION_LOG_INFO("\t- kernel size " << kernelSize << ":" << std::endl
+                           << "\t  horizontal + vertical convolutions: " << system::prettyTime(genericTime) << std::endl
+                           << "\t  separable convolution: " << system::prettyTime(separableTime) << std::endl
+                           << "\t  convolution + half sample: " << system::prettyTime(blurHalfSampleTime) << std::endl
+                           << "\t  fused convolution and half sample: " << system::prettyTime(fusedTime));
+    }
+
+    GaussianPyramid pyramid;
+    const double pyramidTime = meanTime(nbRepetitions, [&]()
+    {
+      ImageGaussianPyramid(img, nbOctaves, nbScales, 1.6f, 0.5f, pyramid);
+    });
+    ALICEVISION_LOG_INFO("\t- Gaussian pyramid (" << pyramid.size() << " octaves, " << nbScales << " scales): "
+                         << system::prettyTime(pyramidTime));
+  }
+
+  return EXIT_SUCCESS;
+}
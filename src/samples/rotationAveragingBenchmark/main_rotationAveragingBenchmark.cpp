@@ -0,0 +1,177 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/multiview/rotationAveraging/rotationAveraging.hpp>
+#include <aliceVision/multiview/NViewDataSet.hpp>
+#include <aliceVision/multiview/essential.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+using namespace aliceVision::rotationAveraging;
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Link each camera of the ring to its nbNeighbors next cameras, with noisy relative rotations.
+ */
+RelativeRotations createRelativeRotations(const NViewDataSet& d, int nbNeighbors, double noiseDegrees)
+{
+  std::mt19937 randomNumberGenerator(0);
+  std::normal_distribution<double> noise(0.0, degreeToRadian(noiseDegrees));
+  std::uniform_real_distribution<double> axisCoordinate(-1.0, 1.0);
+
+  const std::size_t nbViews = d._R.size();
+  RelativeRotations relativeRotations;
+  relativeRotations.reserve(nbViews * nbNeighbors);
+
+  for(std::size_t i = 0; i < nbViews; ++i)
+  {
+    for(int k = 1; k <= nbNeighbors; ++k)
+    {
+      const std::size_t j = (i + k) % nbViews;
+      Mat3 Rij;
+      Vec3 tij;
+      RelativeCameraMotion(d._R[i], d._t[i], d._R[j], d._t[j], &Rij, &tij);
+
+      const Vec3 axis = Vec3(axisCoordinate(randomNumberGenerator),
+                             axisCoordinate(randomNumberGenerator),
+                             axisCoordinate(randomNumberGenerator)).normalized();
+      Rij = Eigen::AngleAxisd(noise(randomNumberGenerator), axis).toRotationMatrix() * Rij;
+      relativeRotations.emplace_back(i, j, Rij, 1.0f);
+    }
+  }
+  return relativeRotations;
+}
+
+/**
+ * @brief Mean angular error (in degrees) to the ground truth, the first view being used to fix the gauge.
+ */
+double meanAngularError(const NViewDataSet& d, const std::vector<Mat3>& globalRotations)
+{
+  double error = 0.0;
+  for(std::size_t i = 0; i < globalRotations.size(); ++i)
+  {
+    const Mat3 gtRotation = d._R[i] * d._R[0].transpose();
+    const Mat3 rotation = globalRotations[i] * globalRotations[0].transpose();
+    error += radianToDegree(getRotationMagnitude(rotation * gtRotation.transpose()));
+  }
+  return error / globalRotations.size();
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<int> nbViewsList = {1000, 10000, 100000};
+  int nbNeighbors = 10;
+  double noiseDegrees = 1.0;
+  int linearSolverType = static_cast<int>(LINEAR_SOLVER_AUTO);
+  bool runL1 = true;
+  bool runL2 = true;
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+
+  po::options_description allParams("AliceVision Sample rotationAveragingBenchmark\n"
+                                    "Benchmark of the L1 and L2 rotation averaging on synthetic camera rings");
+  allParams.add_options()
+    ("nbViews", po::value<std::vector<int>>(&nbViewsList)->multitoken()->default_value(nbViewsList, "1000 10000 100000"),
+      "Number of views of the synthetic rotation graphs.")
+    ("nbNeighbors", po::value<int>(&nbNeighbors)->default_value(nbNeighbors),
+      "Number of relative rotations per view.")
+    ("noise", po::value<double>(&noiseDegrees)->default_value(noiseDegrees),
+      "Standard deviation of the relative rotations noise (in degrees).")
+    ("linearSolver", po::value<int>(&linearSolverType)->default_value(linearSolverType),
+      "* 0: automatic (dense for small graphs, iterative otherwise)\n"
+      "* 1: dense\n"
+      "* 2: iterative (conjugate gradient)")
+    ("l1", po::value<bool>(&runL1)->default_value(runL1),
+      "Run the L1 rotation averaging.")
+    ("l2", po::value<bool>(&runL2)->default_value(runL2),
+      "Run the L2 rotation averaging.")
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  if(linearSolverType < LINEAR_SOLVER_AUTO || linearSolverType > LINEAR_SOLVER_ITERATIVE)
+  {
+    ALICEVISION_LOG_ERROR("Linear solver type is invalid");
+    return EXIT_FAILURE;
+  }
+
+  const ELinearSolverType solverType = static_cast<ELinearSolverType>(linearSolverType);
+
+  ALICEVISION_LOG_INFO("Number of threads: " << omp_get_max_threads());
+
+  for(int nbViews: nbViewsList)
+  {
+    // only the camera poses are used
+    const NViewDataSet d = NRealisticCamerasRing(nbViews, 1, NViewDatasetConfigurator(1, 1, 0, 0, 5, 0));
+    const RelativeRotations relativeRotations = createRelativeRotations(d, nbViews > nbNeighbors ? nbNeighbors : nbViews - 1, noiseDegrees);
+
+    ALICEVISION_LOG_INFO("Synthetic rotation graph: " << nbViews << " views, "
+                         << relativeRotations.size() << " relative rotations, "
+                         << (useIterativeLinearSolver(solverType, nbViews) ? "iterative" : "dense") << " linear solver.");
+
+    if(runL1)
+    {
+      std::vector<Mat3> globalRotations(nbViews);
+      std::vector<bool> inliers;
+
+      system::Timer timer;
+      const bool success = l1::GlobalRotationsRobust(relativeRotations, globalRotations, 0, 0.0f, &inliers, solverType);
+      const double l1Time = timer.elapsedMs();
+
+      ALICEVISION_LOG_INFO("\t- L1 rotation averaging: " << system::prettyTime(l1Time)
+                           << (success ? "" : " (failed)") << std::endl
+                           << "\t  mean angular error: " << meanAngularError(d, globalRotations) << " degrees");
+    }
+
+    if(runL2)
+    {
+      std::vector<Mat3> globalRotations;
+
+      system::Timer timer;
+      const bool success = l2::L2RotationAveraging(nbViews, relativeRotations, globalRotations, solverType);
+      const double l2Time = timer.elapsedMs();
+
+      ALICEVISION_LOG_INFO("\t- L2 rotation averaging: " << system::prettyTime(l2Time)
+                           << (success ? "" : " (failed)") << std::endl
+                           << "\t  mean angular error: " << meanAngularError(d, globalRotations) << " degrees");
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,201 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/sfmDataIO/jsonIO.hpp>
+#include <aliceVision/sfmDataIO/jsonStreamIO.hpp>
+#include <aliceVision/camera/camera.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+/**
+ * @brief Create a synthetic scene, each landmark is observed by nbObservations consecutive views.
+ */
+sfmData::SfMData createScene(int nbViews, int nbLandmarks, int nbObservations)
+{
+  std::mt19937 randomNumberGenerator(0);
+  std::uniform_real_distribution<double> coordinate(-100.0, 100.0);
+  std::uniform_real_distribution<double> pixel(0.0, 1000.0);
+  std::uniform_int_distribution<int> color(0, 255);
+
+  sfmData::SfMData sfmData;
+  sfmData.intrinsics[0] = std::make_shared<camera::PinholeRadialK3>(1000, 1000, 800.0, 500.0, 500.0);
+
+  for(int i = 0; i < nbViews; ++i)
+  {
+    const std::string path = "dataset/" + std::to_string(i) + ".jpg";
+    std::shared_ptr<sfmData::View> view = std::make_shared<sfmData::View>(path, i, 0, i, 1000, 1000);
+    view->addMetadata("Make", "Camera");
+    sfmData.views[i] = view;
+    sfmData.setPose(*view, sfmData::CameraPose(geometry::Pose3(Mat3::Identity(), Vec3(coordinate(randomNumberGenerator), 0.0, 0.0))));
+  }
+
+  for(int i = 0; i < nbLandmarks; ++i)
+  {
+    sfmData::Landmark& landmark = sfmData.structure[i];
+    landmark.X = Vec3(coordinate(randomNumberGenerator), coordinate(randomNumberGenerator), coordinate(randomNumberGenerator));
+    landmark.rgb = image::RGBColor(color(randomNumberGenerator), color(randomNumberGenerator), color(randomNumberGenerator));
+    landmark.descType = feature::EImageDescriberType::SIFT;
+
+    for(int j = 0; j < nbObservations; ++j)
+    {
+      const IndexT viewId = (i + j) % nbViews;
+      landmark.observations[viewId] = sfmData::Observation(Vec2(pixel(randomNumberGenerator), pixel(randomNumberGenerator)), i);
+    }
+  }
+
+  return sfmData;
+}
+
+std::string readFile(const std::string& filename)
+{
+  std::ifstream stream(filename, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+int main(int argc, char** argv)
+{
+  int nbViews = 1000;
+  int nbLandmarks = 1000000;
+  int nbObservations = 4;
+  std::string outputFolder = fs::temp_directory_path().string();
+  bool runPropertyTree = true;
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+
+  po::options_description allParams("AliceVision Sample sfmDataIOBenchmark\n"
+                                    "Benchmark of the property tree and the streaming SfMData JSON reader / writer");
+  allParams.add_options()
+    ("nbViews", po::value<int>(&nbViews)->default_value(nbViews),
+      "Number of views of the synthetic scene.")
+    ("nbLandmarks", po::value<int>(&nbLandmarks)->default_value(nbLandmarks),
+      "Number of landmarks of the synthetic scene.")
+    ("nbObservations", po::value<int>(&nbObservations)->default_value(nbObservations),
+      "Number of observations per landmark.")
+    ("output,o", po::value<std::string>(&outputFolder)->default_value(outputFolder),
+      "Folder of the written SfMData files.")
+    ("propertyTree", po::value<bool>(&runPropertyTree)->default_value(runPropertyTree),
+      "Run the property tree reader / writer and compare their results.")
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  if(nbViews <= 0 || nbLandmarks < 0 || nbObservations <= 0 || nbObservations > nbViews)
+  {
+    ALICEVISION_LOG_ERROR("Invalid synthetic scene size");
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_LOG_INFO("Number of threads: " << omp_get_max_threads());
+
+  const sfmData::SfMData sfmData = createScene(nbViews, nbLandmarks, nbObservations);
+
+  ALICEVISION_LOG_INFO("Synthetic scene: " << nbViews << " views, "
+                       << nbLandmarks << " landmarks, "
+                       << nbObservations << " observations per landmark.");
+
+  const std::string streamFilename = (fs::path(outputFolder) / "sfmDataIOBenchmark_stream.sfm").string();
+  const std::string ptreeFilename = (fs::path(outputFolder) / "sfmDataIOBenchmark_ptree.sfm").string();
+  bool success = true;
+
+  try
+  {
+    system::Timer timer;
+    sfmDataIO::saveJSONStream(sfmData, streamFilename, sfmDataIO::ALL);
+    const double streamSaveTime = timer.elapsedMs();
+
+    timer.reset();
+    sfmData::SfMData streamSfMData;
+    sfmDataIO::loadJSONStream(streamSfMData, streamFilename, sfmDataIO::ALL);
+    const double streamLoadTime = timer.elapsedMs();
+
+    ALICEVISION_LOG_INFO("\t- streaming: save " << system::prettyTime(streamSaveTime)
+                         << ", load " << system::prettyTime(streamLoadTime)
+                         << ", file size: " << fs::file_size(streamFilename) << " bytes");
+
+    if(!(streamSfMData == sfmData))
+    {
+      ALICEVISION_LOG_ERROR("The SfMData loaded by the streaming reader is different.");
+      success = false;
+    }
+
+    if(runPropertyTree)
+    {
+      timer.reset();
+      sfmDataIO::saveJSON(sfmData, ptreeFilename, sfmDataIO::ALL);
+      const double ptreeSaveTime = timer.elapsedMs();
+
+      timer.reset();
+      sfmData::SfMData ptreeSfMData;
+      sfmDataIO::loadJSON(ptreeSfMData, ptreeFilename, sfmDataIO::ALL);
+      const double ptreeLoadTime = timer.elapsedMs();
+
+      ALICEVISION_LOG_INFO("\t- property tree: save " << system::prettyTime(ptreeSaveTime)
+                           << ", load " << system::prettyTime(ptreeLoadTime) << std::endl
+                           << "\t  speedup: save x" << ptreeSaveTime / streamSaveTime
+                           << ", load x" << ptreeLoadTime / streamLoadTime);
+
+      if(readFile(ptreeFilename) != readFile(streamFilename))
+      {
+        ALICEVISION_LOG_ERROR("The files written by the property tree and the streaming writer are different.");
+        success = false;
+      }
+      if(!(ptreeSfMData == streamSfMData))
+      {
+        ALICEVISION_LOG_ERROR("The SfMData loaded by the property tree and the streaming reader are different.");
+        success = false;
+      }
+      fs::remove(ptreeFilename);
+    }
+    fs::remove(streamFilename);
+  }
+  catch(std::exception& e)
+  {
+    ALICEVISION_LOG_ERROR(e.what());
+    return EXIT_FAILURE;
+  }
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
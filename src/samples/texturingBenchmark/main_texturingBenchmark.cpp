@@ -0,0 +1,178 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/textureRasterization.hpp>
+#include <aliceVision/mvsData/Voxel.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+using namespace aliceVision::mesh;
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Fixed texturing setup: a wavy grid surface in front of a pinhole camera,
+ *        unwrapped on a regular grid of the texture.
+ */
+struct TexturingSetup
+{
+    std::vector<Color> image;
+    RasterizationSource source;
+    std::vector<Point3d> pts;
+    std::vector<Point2d> uvs; ///< in texture pixels
+    std::vector<Voxel> tris;
+};
+
+void createTexturingSetup(int gridSide, int textureSide, int imageWidth, int imageHeight, TexturingSetup& setup)
+{
+    // synthetic image (column-major as in mvsUtils::ImagesCache)
+    setup.image.resize(static_cast<std::size_t>(imageWidth) * imageHeight);
+    for(int x = 0; x < imageWidth; ++x)
+        for(int y = 0; y < imageHeight; ++y)
+            setup.image[static_cast<std::size_t>(x) * imageHeight + y] = Color(0.1f + 0.8f * x / imageWidth,
+                                                                                0.1f + 0.8f * y / imageHeight,
+                                                                                0.5f + 0.4f * std::sin(0.05f * (x + y)));
+
+    // camera at the origin looking toward +Z
+    const double focal = 0.8 * imageWidth;
+    Matrix3x4& P = setup.source.P;
+    P.m11 = focal; P.m12 = 0.0;   P.m13 = imageWidth / 2.0;  P.m14 = 0.0;
+    P.m21 = 0.0;   P.m22 = focal; P.m23 = imageHeight / 2.0; P.m24 = 0.0;
+    P.m31 = 0.0;   P.m32 = 0.0;   P.m33 = 1.0;               P.m34 = 0.0;
+    setup.source.image = setup.image.data();
+    setup.source.width = imageWidth;
+    setup.source.height = imageHeight;
+
+    // grid surface and its texture coordinates
+    const int nbPtsSide = gridSide + 1;
+    for(int y = 0; y < nbPtsSide; ++y)
+    {
+        for(int x = 0; x < nbPtsSide; ++x)
+        {
+            const double u = double(x) / gridSide;
+            const double v = double(y) / gridSide;
+            setup.pts.emplace_back(u - 0.5, (v - 0.5) * imageHeight / imageWidth, 1.5 + 0.1 * std::sin(10.0 * u) * std::cos(7.0 * v));
+            setup.uvs.emplace_back(u * (textureSide - 1), v * (textureSide - 1));
+        }
+    }
+    for(int y = 0; y < gridSide; ++y)
+    {
+        for(int x = 0; x < gridSide; ++x)
+        {
+            const int a = y * nbPtsSide + x;
+            setup.tris.emplace_back(a, a + 1, a + nbPtsSide);
+            setup.tris.emplace_back(a + 1, a + nbPtsSide + 1, a + nbPtsSide);
+        }
+    }
+}
+
+template <typename RasterizeFunction>
+double textureAllTriangles(const TexturingSetup& setup, int textureSide, RasterizeFunction rasterize, std::vector<Color>& out_texture)
+{
+    out_texture.assign(static_cast<std::size_t>(textureSide) * textureSide, Color());
+    std::vector<TexelColor> texels;
+
+    system::Timer timer;
+    for(const Voxel& tri: setup.tris)
+    {
+        const Point2d triPixs[3] = {setup.uvs[tri.x], setup.uvs[tri.y], setup.uvs[tri.z]};
+        const Point3d triPts[3] = {setup.pts[tri.x], setup.pts[tri.y], setup.pts[tri.z]};
+        texels.clear();
+        rasterize(triPixs, triPts, textureSide, setup.source, texels);
+        for(const TexelColor& texel: texels)
+            out_texture[texel.offset] = texel.color;
+    }
+    return timer.elapsedMs();
+}
+
+int main(int argc, char** argv)
+{
+    int gridSide = 512;
+    int textureSide = 4096;
+    int imageWidth = 4000;
+    int imageHeight = 3000;
+    int nbRuns = 3;
+    std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+
+    po::options_description allParams("AliceVision Sample texturingBenchmark\n"
+                                      "Micro-benchmark of the texture triangles rasterization on a fixed mesh/camera setup");
+    allParams.add_options()
+        ("gridSide", po::value<int>(&gridSide)->default_value(gridSide),
+            "Number of quads on each side of the synthetic grid mesh (2 triangles per quad).")
+        ("textureSide", po::value<int>(&textureSide)->default_value(textureSide),
+            "Output texture side.")
+        ("imageWidth", po::value<int>(&imageWidth)->default_value(imageWidth),
+            "Source image width.")
+        ("imageHeight", po::value<int>(&imageHeight)->default_value(imageHeight),
+            "Source image height.")
+        ("nbRuns", po::value<int>(&nbRuns)->default_value(nbRuns),
+            "Number of runs (the best time is reported).")
+        ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+            "verbosity level (fatal, error, warning, info, debug, trace).");
+
+    po::variables_map vm;
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+        if(vm.count("help"))
+        {
+            ALICEVISION_COUT(allParams);
+            return EXIT_SUCCESS;
+        }
+        po::notify(vm);
+    }
+    catch(boost::program_options::error& e)
+    {
+        ALICEVISION_CERR("ERROR: " << e.what());
+        ALICEVISION_COUT("Usage:\n\n" << allParams);
+        return EXIT_FAILURE;
+    }
+
+    system::Logger::get()->setLogLevel(verboseLevel);
+
+    TexturingSetup setup;
+    createTexturingSetup(gridSide, textureSide, imageWidth, imageHeight, setup);
+    ALICEVISION_LOG_INFO("Texturing " << setup.tris.size() << " triangles in a " << textureSide << "x" << textureSide << " texture.");
+
+    std::vector<Color> textureExact;
+    std::vector<Color> textureFast;
+    double timeExact = std::numeric_limits<double>::max();
+    double timeFast = std::numeric_limits<double>::max();
+    for(int i = 0; i < nbRuns; ++i)
+    {
+        timeExact = std::min(timeExact, textureAllTriangles(setup, textureSide, rasterizeTriangleExact, textureExact));
+        timeFast = std::min(timeFast, textureAllTriangles(setup, textureSide, rasterizeTriangle, textureFast));
+    }
+
+    float maxDiff = 0.0f;
+    for(std::size_t i = 0; i < textureExact.size(); ++i)
+    {
+        const Color diff = textureExact[i] - textureFast[i];
+        maxDiff = std::max(maxDiff, std::max(std::abs(diff.r), std::max(std::abs(diff.g), std::abs(diff.b))));
+    }
+
+    ALICEVISION_LOG_INFO("Texture rasterization:" << std::endl
+                         << "\t- per texel (reference): " << timeExact << " ms" << std::endl
+                         << "\t- scanline / batched: " << timeFast << " ms (x" << timeExact / timeFast << ")" << std::endl
+                         << "\t- max color difference: " << maxDiff);
+
+    return EXIT_SUCCESS;
+}
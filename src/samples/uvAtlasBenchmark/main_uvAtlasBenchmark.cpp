@@ -0,0 +1,179 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mesh/UVAtlas.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+using namespace aliceVision::mesh;
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Create a regular grid mesh of gridSide x gridSide quads (2 triangles per quad)
+ *        and one chart per triangle.
+ * Cameras are laid out on a regular grid, each one sees the triangles of its cell and of half of the neighboring cells.
+ */
+void createSyntheticMesh(int gridSide, int cameraFootprint, Mesh& mesh, std::vector<UVAtlas::Chart>& charts)
+{
+    const int nbPtsSide = gridSide + 1;
+    mesh.pts = new StaticVector<Point3d>();
+    mesh.tris = new StaticVector<Mesh::triangle>();
+    mesh.pts->resize(nbPtsSide * nbPtsSide);
+    mesh.tris->resize(2 * gridSide * gridSide);
+    charts.resize(mesh.tris->size());
+
+    const int nbCamerasSide = (gridSide + cameraFootprint - 1) / cameraFootprint;
+
+    #pragma omp parallel for
+    for(int y = 0; y < nbPtsSide; ++y)
+        for(int x = 0; x < nbPtsSide; ++x)
+            (*mesh.pts)[y * nbPtsSide + x] = Point3d(x, y, 0.0);
+
+    #pragma omp parallel for
+    for(int y = 0; y < gridSide; ++y)
+    {
+        for(int x = 0; x < gridSide; ++x)
+        {
+            const int a = y * nbPtsSide + x;
+            const int quadID = y * gridSide + x;
+            (*mesh.tris)[2 * quadID] = Mesh::triangle(a, a + 1, a + nbPtsSide);
+            (*mesh.tris)[2 * quadID + 1] = Mesh::triangle(a + 1, a + nbPtsSide + 1, a + nbPtsSide);
+
+            std::vector<int> cameraIDs;
+            const int halfFootprint = cameraFootprint / 2;
+            for(int cy = std::max(0, (y - halfFootprint) / cameraFootprint); cy <= std::min(nbCamerasSide - 1, (y + halfFootprint) / cameraFootprint); ++cy)
+                for(int cx = std::max(0, (x - halfFootprint) / cameraFootprint); cx <= std::min(nbCamerasSide - 1, (x + halfFootprint) / cameraFootprint); ++cx)
+                    cameraIDs.push_back(cy * nbCamerasSide + cx);
+
+            for(int k = 0; k < 2; ++k)
+            {
+                UVAtlas::Chart& chart = charts[2 * quadID + k];
+                chart.commonCameraIDs = cameraIDs;
+                chart.triangleIDs.assign(1, 2 * quadID + k);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Set the chart bounds from the triangles bounding box on the grid.
+ */
+void computeChartsBounds(const Mesh& mesh, int texelsPerQuad, std::vector<UVAtlas::Chart>& charts)
+{
+    #pragma omp parallel for
+    for(int i = 0; i < charts.size(); ++i)
+    {
+        UVAtlas::Chart& chart = charts[i];
+        Pixel lu(std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
+        Pixel rd(std::numeric_limits<int>::min(), std::numeric_limits<int>::min());
+        for(int triangleID: chart.triangleIDs)
+        {
+            for(int k = 0; k < 3; ++k)
+            {
+                const Point3d& p = (*mesh.pts)[(*mesh.tris)[triangleID].v[k]];
+                lu.x = std::min(lu.x, static_cast<int>(p.x) * texelsPerQuad);
+                lu.y = std::min(lu.y, static_cast<int>(p.y) * texelsPerQuad);
+                rd.x = std::max(rd.x, static_cast<int>(p.x) * texelsPerQuad);
+                rd.y = std::max(rd.y, static_cast<int>(p.y) * texelsPerQuad);
+            }
+        }
+        chart.sourceLU = lu;
+        chart.sourceRD = rd;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<int> nbTrianglesList = {1000000, 10000000};
+    int cameraFootprint = 16;
+    int texelsPerQuad = 16;
+    int textureSide = 8192;
+    int gutterSize = 2;
+    std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+
+    po::options_description allParams("AliceVision Sample uvAtlasBenchmark\n"
+                                      "Benchmark of the UV atlas chart merging and packing on synthetic grid meshes");
+    allParams.add_options()
+        ("nbTriangles", po::value<std::vector<int>>(&nbTrianglesList)->multitoken()->default_value(nbTrianglesList, "1000000 10000000"),
+            "Number of triangles of the synthetic meshes.")
+        ("cameraFootprint", po::value<int>(&cameraFootprint)->default_value(cameraFootprint),
+            "Side (in quads) of the grid area seen by each synthetic camera.")
+        ("texelsPerQuad", po::value<int>(&texelsPerQuad)->default_value(texelsPerQuad),
+            "Texture resolution of a grid quad (in pixels).")
+        ("textureSide", po::value<int>(&textureSide)->default_value(textureSide),
+            "Output texture side.")
+        ("gutterSize", po::value<int>(&gutterSize)->default_value(gutterSize),
+            "Gutter size around each chart (in pixels).")
+        ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+            "verbosity level (fatal, error, warning, info, debug, trace).");
+
+    po::variables_map vm;
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+        if(vm.count("help"))
+        {
+            ALICEVISION_COUT(allParams);
+            return EXIT_SUCCESS;
+        }
+        po::notify(vm);
+    }
+    catch(boost::program_options::error& e)
+    {
+        ALICEVISION_CERR("ERROR: " << e.what());
+        ALICEVISION_COUT("Usage:\n\n" << allParams);
+        return EXIT_FAILURE;
+    }
+
+    system::Logger::get()->setLogLevel(verboseLevel);
+
+    ALICEVISION_LOG_INFO("Number of threads: " << omp_get_max_threads());
+
+    for(int nbTriangles: nbTrianglesList)
+    {
+        const int gridSide = std::max(1, static_cast<int>(std::sqrt(nbTriangles / 2.0)));
+
+        Mesh mesh;
+        std::vector<UVAtlas::Chart> charts;
+        createSyntheticMesh(gridSide, cameraFootprint, mesh, charts);
+
+        ALICEVISION_LOG_INFO("Synthetic mesh: " << mesh.tris->size() << " triangles, " << mesh.pts->size() << " points.");
+
+        system::Timer timer;
+        UVAtlas::mergeCharts(mesh, charts);
+        const double mergeTime = timer.elapsedMs();
+
+        computeChartsBounds(mesh, texelsPerQuad, charts);
+
+        std::vector<std::vector<UVAtlas::Chart>> atlases;
+        timer.reset();
+        UVAtlas::packChartsInAtlases(charts, textureSide, gutterSize, atlases);
+        const double packTime = timer.elapsedMs();
+
+        ALICEVISION_LOG_INFO("\t- charts merging: " << system::prettyTime(mergeTime) << " (" << charts.size() << " charts)" << std::endl
+                          << "\t- charts packing: " << system::prettyTime(packTime) << " (" << atlases.size() << " texture atlases)");
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -20,7 +20,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -43,6 +43,8 @@ int main(int argc, char **argv)
   bool flagExtrinsics = true;
   bool flagStructure = true;
   bool flagObservations = true;
+  bool flagControlPoints = false;
+  bool flagUncertainty = false;
 
   po::options_description allParams("AliceVision convertSfMFormat");
 
@@ -51,7 +53,7 @@ int main(int argc, char **argv)
     ("input,i", po::value<std::string>(&sfmDataFilename)->required(),
       "SfMData file.")
     ("output,o", po::value<std::string>(&outputSfMDataFilename)->required(),
-      "Path to the output Alembic file.");
+      "Path to the output SfMData file (*.sfm, *.json, *.sfmb, *.abc, *.ply, *.baf).");
 
   po::options_description optionalParams("Optional parameters");
   optionalParams.add_options()
@@ -64,7 +66,11 @@ int main(int argc, char **argv)
     ("structure", po::value<bool>(&flagStructure)->default_value(flagStructure),
       "Export structure.")
     ("observations", po::value<bool>(&flagObservations)->default_value(flagObservations),
-      "Export observations.");
+      "Export observations.")
+    ("controlPoints", po::value<bool>(&flagControlPoints)->default_value(flagControlPoints),
+      "Export control points.")
+    ("uncertainty", po::value<bool>(&flagUncertainty)->default_value(flagUncertainty),
+      "Export poses and landmarks uncertainty.");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -114,13 +120,15 @@ int main(int argc, char **argv)
        | (flagIntrinsics   ? sfmDataIO::INTRINSICS   : 0)
        | (flagExtrinsics   ? sfmDataIO::EXTRINSICS   : 0)
        | (flagObservations ? sfmDataIO::OBSERVATIONS : 0)
-       | (flagStructure    ? sfmDataIO::STRUCTURE    : 0);
+       | (flagStructure    ? sfmDataIO::STRUCTURE    : 0)
+       | (flagControlPoints ? sfmDataIO::CONTROL_POINTS : 0)
+       | (flagUncertainty  ? sfmDataIO::UNCERTAINTY  : 0);
 
   flags = (flags) ? flags : sfmDataIO::ALL;
 
-  // load input SfMData scene
+  // load input SfMData scene, only the exported parts are read
   sfmData::SfMData sfmData;
-  if(!sfmDataIO::Load(sfmData, sfmDataFilename, sfmDataIO::ESfMData::ALL))
+  if(!sfmDataIO::Load(sfmData, sfmDataFilename, sfmDataIO::ESfMData(flags)))
   {
     ALICEVISION_LOG_ERROR("The input SfMData file '" << sfmDataFilename << "' cannot be read");
     return EXIT_FAILURE;
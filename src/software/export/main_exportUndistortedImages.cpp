@@ -8,6 +8,7 @@
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
 #include <aliceVision/image/all.hpp>
+#include <aliceVision/camera/cameraUndistortImage.hpp>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
@@ -101,6 +102,8 @@ int main(int argc, char *argv[])
 
   // export views as undistorted images (those with valid Intrinsics)
   image::Image<image::RGBfColor> image, image_ud;
+  // the views sharing an intrinsic share the same undistortion remap table
+  camera::UndistortRemapCache remapCache;
   boost::progress_display progressBar(sfmData.getViews().size());
   for(sfmData::Views::const_iterator iter = sfmData.getViews().begin(); iter != sfmData.getViews().end(); ++iter, ++progressBar)
   {
@@ -118,7 +121,7 @@ int main(int argc, char *argv[])
     {
       // undistort the image and save it
       image::readImage(srcImage, image);
-      camera::UndistortImage(image, cam, image_ud, image::FBLACK);
+      camera::UndistortImage(image, *remapCache.get(*cam, image.Width(), image.Height()), image_ud, image::FBLACK);
       image::writeImage(dstImage, image_ud);
     }
     else // (no distortion)
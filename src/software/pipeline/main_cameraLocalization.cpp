@@ -11,6 +11,7 @@
 #include <aliceVision/localization/CCTagLocalizer.hpp>
 #endif
 #include <aliceVision/localization/LocalizationResult.hpp>
+#include <aliceVision/localization/LocalizationServer.hpp>
 #include <aliceVision/localization/optimization.hpp>
 #include <aliceVision/image/io.hpp>
 #include <aliceVision/dataio/FeedProvider.hpp>
@@ -45,7 +46,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 4
 
 using namespace aliceVision;
 
@@ -103,11 +104,25 @@ int main(int argc, char** argv)
   std::string vocTreeFilepath;
   /// the vocabulary tree weights file
   std::string weightsFilepath;
+  /// the localization map file
+  std::string localizationMapFilepath;
   /// Number of previous frame of the sequence to use for matching
   std::size_t nbFrameBufferMatching = 10;
+  /// number of threads verifying the similar images concurrently
+  std::size_t nbVerificationThreads = 1;
+  /// enable/disable the tracking of the previous frames before the retrieval
+  bool useTracking = false;
+  /// radius in pixels of the tracking search window
+  double trackingWindowRadius = 20.0;
+  /// minimum number of inliers to accept a tracked pose
+  std::size_t trackingMinInliers = 30;
   /// enable/disable the robust matching (geometric validation) when matching query image
   /// and databases images
   bool robustMatching = true;
+  /// number of frames of the media decoded ahead (0 = Disable)
+  std::size_t prefetchFrames = 8;
+  /// number of threads decoding the frames ahead (image sequences only)
+  std::size_t prefetchThreads = 1;
   
   /// the Alembic export file
   std::string exportAlembicFile = "trackedcameras.abc";
@@ -162,6 +177,11 @@ int main(int argc, char** argv)
           "("+str_estimatorChoices+")").c_str())
       ("calibration", po::value<std::string>(&calibFile)/*->required( )*/, 
           "Calibration file")
+      ("prefetchFrames", po::value<std::size_t>(&prefetchFrames)->default_value(prefetchFrames),
+          "Number of frames of the media decoded ahead while the current one is localized "
+          "(0 = Disable)")
+      ("prefetchThreads", po::value<std::size_t>(&prefetchThreads)->default_value(prefetchThreads),
+          "Number of threads decoding the frames ahead (a video is always decoded by a single thread)")
       ("refineIntrinsics", po::value<bool>(&refineIntrinsics), 
           "Enable/Disable camera intrinsics refinement for each localized image")
       ("reprojectionError", po::value<double>(&resectionErrorMax)->default_value(resectionErrorMax), 
@@ -183,6 +203,9 @@ int main(int argc, char** argv)
           "[voctree] Filename for the vocabulary tree")
       ("voctreeWeights", po::value<std::string>(&weightsFilepath), 
           "[voctree] Filename for the vocabulary tree weights")
+      ("localizationMap", po::value<std::string>(&localizationMapFilepath),
+          "[voctree] Filename for the localization map (see aliceVision_utils_localizationMapCreation), "
+          "it replaces the loading of the features and descriptors of the scene")
       ("algorithm", po::value<std::string>(&algostring)->default_value(algostring), 
           "[voctree] Algorithm type: FirstBest, AllResults" )
       ("matchingError", po::value<double>(&matchingErrorMax)->default_value(matchingErrorMax), 
@@ -192,6 +215,17 @@ int main(int argc, char** argv)
       ("nbFrameBufferMatching", po::value<std::size_t>(&nbFrameBufferMatching)->default_value(nbFrameBufferMatching),
           "[voctree] Number of previous frame of the sequence to use for matching "
           "(0 = Disable)")
+      ("nbVerificationThreads", po::value<std::size_t>(&nbVerificationThreads)->default_value(nbVerificationThreads),
+          "[voctree] Number of threads verifying the similar images concurrently "
+          "(1 = sequential, 0 = number of cores)")
+      ("tracking", po::value<bool>(&useTracking)->default_value(useTracking),
+          "[voctree] Enable/Disable the tracking of the previous frames: the landmarks are "
+          "matched around their predicted projection and the database is only queried "
+          "when the tracking fails")
+      ("trackingWindowRadius", po::value<double>(&trackingWindowRadius)->default_value(trackingWindowRadius),
+          "[voctree] Radius in pixels of the search window around the predicted landmark projections")
+      ("trackingMinInliers", po::value<std::size_t>(&trackingMinInliers)->default_value(trackingMinInliers),
+          "[voctree] Minimum number of resection inliers to accept a tracked pose")
       ("robustMatching", po::value<bool>(&robustMatching)->default_value(robustMatching), 
           "[voctree] Enable/Disable the robust matching between query and database images, "
           "all putative matches will be considered.")
@@ -339,7 +373,8 @@ int main(int argc, char** argv)
                                                    descriptorsFolder,
                                                    vocTreeFilepath,
                                                    weightsFilepath,
-                                                   matchDescTypes);
+                                                   matchDescTypes,
+                                                   localizationMapFilepath);
 
     localizer.reset(tmpLoc);
     
@@ -352,6 +387,10 @@ int main(int argc, char** argv)
     tmpParam->_ccTagUseCuda = false;
     tmpParam->_matchingError = matchingErrorMax;
     tmpParam->_nbFrameBufferMatching = nbFrameBufferMatching;
+    tmpParam->_nbVerificationThreads = nbVerificationThreads;
+    tmpParam->_useTracking = useTracking;
+    tmpParam->_trackingWindowRadius = trackingWindowRadius;
+    tmpParam->_trackingMinInliers = trackingMinInliers;
     tmpParam->_useRobustMatching = robustMatching;
   }
   
@@ -374,7 +413,11 @@ int main(int argc, char** argv)
   }
   
   // create the feedProvider
-  dataio::FeedProvider feed(mediaFilepath, calibFile);
+  dataio::FeedPrefetchOptions prefetchOptions;
+  prefetchOptions.nbFrames = prefetchFrames;
+  prefetchOptions.nbThreads = prefetchThreads;
+  prefetchOptions.imageType = dataio::EFeedImageType::GRAY_FLOAT; // converted by the decode threads
+  dataio::FeedProvider feed(mediaFilepath, calibFile, prefetchOptions);
   if(!feed.isInit())
   {
     ALICEVISION_CERR("ERROR while initializing the FeedProvider!");
@@ -403,6 +446,8 @@ int main(int argc, char** argv)
   // Define an accumulator set for computing the mean and the
   // standard deviation of the time taken for localization
   bacc::accumulator_set<double, bacc::stats<bacc::tag::mean, bacc::tag::min, bacc::tag::max, bacc::tag::sum > > stats;
+  // distribution of the localization latencies
+  localization::LatencyHistogram latencies;
   
   std::vector<localization::LocalizationResult> vec_localizationResults;
   
@@ -423,6 +468,7 @@ int main(int argc, char** argv)
     auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
     ALICEVISION_COUT("\nLocalization took  " << detect_elapsed.count() << " [ms]");
     stats(detect_elapsed.count());
+    latencies.add(std::chrono::duration<double, std::milli>(detect_end - detect_start).count());
     
     vec_localizationResults.emplace_back(localizationResult);
 
@@ -514,7 +560,16 @@ int main(int argc, char** argv)
   for(std::size_t i = 0; i < goodFrameList.size(); ++i)
     ALICEVISION_COUT(goodFrameList[i]);
   ALICEVISION_COUT("Processing took " << bacc::sum(stats)/1000 << " [s] overall");
+  ALICEVISION_COUT("Localization frame rate:   " << ((bacc::sum(stats) > 0) ? 1000.0 * frameCounter / bacc::sum(stats) : 0.0) << " [fps]");
+  if(const localization::VoctreeLocalizer* voctreeLocalizer = dynamic_cast<const localization::VoctreeLocalizer*>(localizer.get()))
+  {
+    if(useTracking)
+      ALICEVISION_COUT("Frames localized by tracking:   " << voctreeLocalizer->getNbTrackedFrames() << "/" << frameCounter);
+  }
   ALICEVISION_COUT("Mean time for localization:   " << bacc::mean(stats) << " [ms]");
   ALICEVISION_COUT("Max time for localization:   " << bacc::max(stats) << " [ms]");
   ALICEVISION_COUT("Min time for localization:   " << bacc::min(stats) << " [ms]");
+  ALICEVISION_COUT("Median time for localization:   " << latencies.percentile(0.5) << " [ms]");
+  ALICEVISION_COUT("90th percentile time for localization:   " << latencies.percentile(0.9) << " [ms]");
+  ALICEVISION_COUT("99th percentile time for localization:   " << latencies.percentile(0.99) << " [ms]");
 }
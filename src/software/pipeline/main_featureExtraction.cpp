@@ -16,6 +16,7 @@
 #include <aliceVision/system/gpu.hpp>
 #endif
 #include <aliceVision/image/all.hpp>
+#include <aliceVision/system/ConcurrentQueue.hpp>
 #include <aliceVision/system/MemoryInfo.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/Logger.hpp>
@@ -26,7 +27,11 @@
 #include <boost/filesystem.hpp>
 #include <boost/progress.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -37,7 +42,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -128,7 +133,7 @@ public:
     _imageDescribers.push_back(imageDescriber);
   }
 
-  void process()
+  bool process()
   {
     // iteration on each view in the range in order
     // to prepare viewJob stack
@@ -169,61 +174,321 @@ public:
       if(jobMaxMemoryConsuption == 0)
         throw std::runtime_error("Cannot compute feature extraction job max memory consumption.");
 
-      std::size_t nbThreads =  (0.9 * memoryInformation.freeRam) / jobMaxMemoryConsuption;
+      std::size_t memoryBudget = 0.9 * memoryInformation.freeRam;
 
       if(memoryInformation.freeRam == 0)
       {
         ALICEVISION_LOG_WARNING("Cannot find available system memory, this can be due to OS limitations.\n"
-                                "Use only one thread for CPU feature extraction.");
-        nbThreads = 1;
+                                "Use only one job at a time for CPU feature extraction.");
+        memoryBudget = jobMaxMemoryConsuption;
       }
 
       // nbThreads should not be higher than user maxThreads param
+      std::size_t nbThreads = static_cast<std::size_t>(omp_get_num_procs());
       if(_maxThreads > 0)
         nbThreads = std::min(static_cast<std::size_t>(_maxThreads), nbThreads);
 
-      // nbThreads should not be higher than the core number
-      nbThreads = std::min(static_cast<std::size_t>(omp_get_num_procs()), nbThreads);
-
       // nbThreads should not be higher than the job number
       nbThreads = std::min(_cpuJobs.size(), nbThreads);
 
       ALICEVISION_LOG_DEBUG("# threads for extraction: " << nbThreads);
-      omp_set_nested(1);
 
-#pragma omp parallel for num_threads(nbThreads)
-      for(int i = 0; i < _cpuJobs.size(); ++i)
-        computeViewJob(_cpuJobs.at(i));
+      // the image pools keep buffers between the images: their memory is taken from the budget,
+      // with a small cap per pool (float and uchar pools of the describe threads and of their OpenMP workers)
+      const std::size_t nbLocalPools = 2 * (nbThreads + static_cast<std::size_t>(omp_get_num_procs()));
+      const std::size_t poolCapacity = std::min(image::defaultLocalImagePoolCapacity, memoryBudget / (4 * (nbLocalPools + 1)));
+      image::ImagePool<float>::setLocalPoolsCapacity(poolCapacity);
+      image::ImagePool<unsigned char>::setLocalPoolsCapacity(poolCapacity);
+      _imagePool.setCapacity(poolCapacity);
+      memoryBudget -= (nbLocalPools + 1) * poolCapacity;
+      ALICEVISION_LOG_DEBUG("Image pools capacity: " << poolCapacity / (1024 * 1024) << " MB per pool");
+
+      if(!processPipeline(nbThreads, memoryBudget))
+        return false;
+
+      const image::ImagePoolStatistics poolStatistics = image::getImagePoolStatistics();
+      ALICEVISION_LOG_DEBUG("Image pool statistics: " << poolStatistics.nbAllocations << " allocations ("
+                            << poolStatistics.allocatedBytes / (1024 * 1024) << " MB), " << poolStatistics.nbReuses << " reuses");
+      ALICEVISION_LOG_DEBUG("Peak resident memory: " << system::getPeakResidentMemory() / (1024 * 1024) << " MB");
     }
 
     if(!_gpuJobs.empty())
     {
       for(const auto& job : _gpuJobs)
+      {
         computeViewJob(job, true);
+        image::ImagePool<unsigned char>::local().clear();
+      }
     }
+    return true;
   }
 
 private:
 
-  void computeViewJob(const ViewJob& job, bool useGPU = false)
+  /// Image of a view, decoded and waiting for description
+  struct DecodedView
   {
+    std::size_t jobIndex = 0;
     image::Image<float> imageGrayFloat;
-    image::Image<unsigned char> imageGrayUChar;
+  };
 
-    image::readImage(job.view.getImagePath(), imageGrayFloat);
+  /// Regions of a view, described and waiting for writing
+  struct DescribedView
+  {
+    std::size_t jobIndex = 0;
+    std::vector<std::unique_ptr<feature::Regions>> regions; //< one per job cpuImageDescriberIndexes
+  };
+
+  /**
+   * @brief Memory shared by the jobs in flight: a job is admitted in the pipeline only
+   * when its memory consumption fits in the remaining budget.
+   */
+  class MemoryBudget
+  {
+  public:
+    explicit MemoryBudget(std::size_t budget)
+      : _budget(budget)
+    {}
+
+    /**
+     * @brief Wait until the given amount of memory is available and reserve it
+     * @note A job larger than the whole budget is admitted when no other job is in flight.
+     * @return false if the budget is closed
+     */
+    bool acquire(std::size_t memory)
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _released.wait(lock, [&]() { return _closed || _used == 0 || _used + memory <= _budget; });
+      if(_closed)
+        return false;
+      _used += memory;
+      return true;
+    }
+
+    void release(std::size_t memory)
+    {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _used -= memory;
+      }
+      _released.notify_all();
+    }
+
+    /// Release the threads waiting for memory (stop the pipeline)
+    void close()
+    {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _closed = true;
+      }
+      _released.notify_all();
+    }
+
+  private:
+    const std::size_t _budget;
+    std::size_t _used = 0;
+    bool _closed = false;
+    std::mutex _mutex;
+    std::condition_variable _released;
+  };
+
+  /// Throughput of a pipeline stage
+  struct StageStatistics
+  {
+    std::string name;
+    std::size_t nbThreads = 0;
+    std::size_t nbViews = 0;
+    double busyTime = 0.0; //< in seconds, summed over the stage threads
+    std::mutex mutex;
+
+    void addView(double time)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++nbViews;
+      busyTime += time;
+    }
+
+    void log() const
+    {
+      const double throughput = (busyTime > 0.0) ? nbViews * nbThreads / busyTime : 0.0;
+      ALICEVISION_LOG_INFO(std::left << std::setw(10) << name << nbThreads << " thread(s), "
+                           << nbViews << " views, busy: " << busyTime << " s, throughput: " << throughput << " views/s");
+    }
+  };
+
+  /**
+   * @brief Process the CPU jobs in a pipeline: decode threads read the images, describe workers
+   * extract the regions and a writer thread saves them. The stages are connected with bounded queues
+   * and the jobs in flight share the memory budget, so the I/O overlaps with the description.
+   * @param[in] nbThreads the number of describe workers
+   * @param[in] memoryBudget the memory shared by the jobs in flight
+   * @return false if a job failed
+   */
+  bool processPipeline(std::size_t nbThreads, std::size_t memoryBudget)
+  {
+    const std::size_t nbDecodeThreads = std::min<std::size_t>(2, _cpuJobs.size());
+    const std::size_t nbWriteThreads = 1;
+
+    // bounded queues: limit the number of images and regions waiting in memory
+    system::ConcurrentQueue<std::unique_ptr<DecodedView>> decodedQueue(nbThreads);
+    system::ConcurrentQueue<std::unique_ptr<DescribedView>> describedQueue(nbThreads);
+    MemoryBudget budget(memoryBudget);
+    std::atomic<std::size_t> nextJob(0);
+    std::atomic<bool> success(true);
+
+    StageStatistics decodeStatistics, describeStatistics, writeStatistics;
+    decodeStatistics.name = "decode:";
+    decodeStatistics.nbThreads = nbDecodeThreads;
+    describeStatistics.name = "describe:";
+    describeStatistics.nbThreads = nbThreads;
+    writeStatistics.name = "write:";
+    writeStatistics.nbThreads = nbWriteThreads;
+
+    const auto stopPipeline = [&]()
+    {
+      success = false;
+      budget.close();
+      decodedQueue.close();
+      describedQueue.close();
+    };
+
+    const auto decode = [&]()
+    {
+      try
+      {
+        for(std::size_t i = nextJob++; i < _cpuJobs.size(); i = nextJob++)
+        {
+          const ViewJob& job = _cpuJobs.at(i);
+          if(!budget.acquire(job.memoryConsuption))
+            break;
+
+          system::Timer timer;
+          std::unique_ptr<DecodedView> decodedView(new DecodedView);
+          decodedView->jobIndex = i;
+          // reuse the buffer of a previously described image with the same resolution
+          if(job.view.getWidth() > 0 && job.view.getHeight() > 0)
+            _imagePool.resize(decodedView->imageGrayFloat, job.view.getWidth(), job.view.getHeight());
+          image::readImage(job.view.getImagePath(), decodedView->imageGrayFloat);
+          decodeStatistics.addView(timer.elapsed());
+
+          if(!decodedQueue.push(std::move(decodedView)))
+            break;
+        }
+      }
+      catch(const std::exception& e)
+      {
+        ALICEVISION_LOG_ERROR("Cannot read image: " << e.what());
+        stopPipeline();
+      }
+    };
+
+    // the describe workers share the cores: each one runs its OpenMP regions on its part of them
+    const int nbThreadsPerDescribe = std::max(1, omp_get_num_procs() / static_cast<int>(nbThreads));
+
+    const auto describe = [&]()
+    {
+      omp_set_num_threads(nbThreadsPerDescribe);
+      try
+      {
+        std::unique_ptr<DecodedView> decodedView;
+        while(decodedQueue.pop(decodedView))
+        {
+          system::Timer timer;
+          const ViewJob& job = _cpuJobs.at(decodedView->jobIndex);
+          std::unique_ptr<DescribedView> describedView(new DescribedView);
+          describedView->jobIndex = decodedView->jobIndex;
+          describeView(job, decodedView->imageGrayFloat, job.cpuImageDescriberIndexes, false, describedView->regions);
+          _imagePool.release(decodedView->imageGrayFloat);
+          decodedView.reset();
+          // the temporary buffers of the job kept by the pools of this thread are not needed anymore
+          image::ImagePool<float>::local().clear();
+          image::ImagePool<unsigned char>::local().clear();
+          describeStatistics.addView(timer.elapsed());
+
+          if(!describedQueue.push(std::move(describedView)))
+            break;
+        }
+      }
+      catch(const std::exception& e)
+      {
+        ALICEVISION_LOG_ERROR("Cannot extract features: " << e.what());
+        stopPipeline();
+      }
+    };
+
+    const auto write = [&]()
+    {
+      try
+      {
+        std::unique_ptr<DescribedView> describedView;
+        while(describedQueue.pop(describedView))
+        {
+          system::Timer timer;
+          const ViewJob& job = _cpuJobs.at(describedView->jobIndex);
+          writeView(job, job.cpuImageDescriberIndexes, describedView->regions);
+          describedView.reset();
+          budget.release(job.memoryConsuption);
+          writeStatistics.addView(timer.elapsed());
+        }
+      }
+      catch(const std::exception& e)
+      {
+        ALICEVISION_LOG_ERROR("Cannot write features: " << e.what());
+        stopPipeline();
+      }
+    };
+
+    std::vector<std::thread> decodeThreads, describeThreads, writeThreads;
+    for(std::size_t i = 0; i < nbDecodeThreads; ++i)
+      decodeThreads.emplace_back(decode);
+    for(std::size_t i = 0; i < nbThreads; ++i)
+      describeThreads.emplace_back(describe);
+    for(std::size_t i = 0; i < nbWriteThreads; ++i)
+      writeThreads.emplace_back(write);
+
+    // each stage closes the queue of the next one when all its threads are done
+    for(std::thread& thread : decodeThreads)
+      thread.join();
+    decodedQueue.close();
+    for(std::thread& thread : describeThreads)
+      thread.join();
+    describedQueue.close();
+    for(std::thread& thread : writeThreads)
+      thread.join();
+
+    // free the buffers kept by the OpenMP workers of the describers and by the decoded images pool
+    image::ImagePool<float>::clearLocalPools();
+    image::ImagePool<unsigned char>::clearLocalPools();
+    _imagePool.clear();
+
+    ALICEVISION_LOG_INFO("Feature extraction pipeline statistics:");
+    decodeStatistics.log();
+    describeStatistics.log();
+    writeStatistics.log();
+
+    return success;
+  }
 
-    const auto imageDescriberIndexes = useGPU ? job.gpuImageDescriberIndexes : job.cpuImageDescriberIndexes;
+  void describeView(const ViewJob& job,
+                    const image::Image<float>& imageGrayFloat,
+                    const std::vector<std::size_t>& imageDescriberIndexes,
+                    bool useGPU,
+                    std::vector<std::unique_ptr<feature::Regions>>& regionsPerDescriber)
+  {
+    image::ImagePool<unsigned char>& pool = image::ImagePool<unsigned char>::local();
+    image::Image<unsigned char> imageGrayUChar;
+    regionsPerDescriber.resize(imageDescriberIndexes.size());
 
-    for(auto& imageDescriberIndex : imageDescriberIndexes)
+    for(std::size_t i = 0; i < imageDescriberIndexes.size(); ++i)
     {
-      const auto& imageDescriber = _imageDescribers.at(imageDescriberIndex);
+      const auto& imageDescriber = _imageDescribers.at(imageDescriberIndexes.at(i));
       const feature::EImageDescriberType imageDescriberType = imageDescriber->getDescriberType();
       const std::string imageDescriberTypeName = feature::EImageDescriberType_enumToString(imageDescriberType);
 
-      // Compute features and descriptors and export them to files
+      // Compute features and descriptors
       ALICEVISION_LOG_INFO("Extracting " << imageDescriberTypeName  << " features from view '" << job.view.getImagePath() << "' " << (useGPU ? "[gpu]" : "[cpu]"));
 
-      std::unique_ptr<feature::Regions> regions;
+      std::unique_ptr<feature::Regions>& regions = regionsPerDescriber.at(i);
       if(imageDescriber->useFloatImage())
       {
         // image buffer use float image, use the read buffer
@@ -233,14 +498,45 @@ private:
       {
         // image buffer can't use float image
         if(imageGrayUChar.Width() == 0) // the first time, convert the float buffer to uchar
-          imageGrayUChar = (imageGrayFloat.GetMat() * 255.f).cast<unsigned char>();
+        {
+          pool.resize(imageGrayUChar, imageGrayFloat.Width(), imageGrayFloat.Height());
+          imageGrayUChar.array() = (imageGrayFloat.array() * 255.f).cast<unsigned char>();
+        }
         imageDescriber->describe(imageGrayUChar, regions);
       }
-      imageDescriber->Save(regions.get(), job.getFeaturesPath(imageDescriberType), job.getDescriptorPath(imageDescriberType));
+    }
+    pool.release(imageGrayUChar);
+  }
+
+  void writeView(const ViewJob& job,
+                 const std::vector<std::size_t>& imageDescriberIndexes,
+                 const std::vector<std::unique_ptr<feature::Regions>>& regionsPerDescriber)
+  {
+    for(std::size_t i = 0; i < imageDescriberIndexes.size(); ++i)
+    {
+      const auto& imageDescriber = _imageDescribers.at(imageDescriberIndexes.at(i));
+      const feature::EImageDescriberType imageDescriberType = imageDescriber->getDescriberType();
+      const std::string imageDescriberTypeName = feature::EImageDescriberType_enumToString(imageDescriberType);
+      const feature::Regions* regions = regionsPerDescriber.at(i).get();
+
+      // Export features and descriptors to files
+      imageDescriber->Save(regions, job.getFeaturesPath(imageDescriberType), job.getDescriptorPath(imageDescriberType));
       ALICEVISION_LOG_INFO(std::left << std::setw(6) << " " << regions->RegionCount() << " " << imageDescriberTypeName  << " features extracted from view '" << job.view.getImagePath() << "'");
     }
   }
 
+  void computeViewJob(const ViewJob& job, bool useGPU = false)
+  {
+    image::Image<float> imageGrayFloat;
+    image::readImage(job.view.getImagePath(), imageGrayFloat);
+
+    const auto& imageDescriberIndexes = useGPU ? job.gpuImageDescriberIndexes : job.cpuImageDescriberIndexes;
+
+    std::vector<std::unique_ptr<feature::Regions>> regionsPerDescriber;
+    describeView(job, imageGrayFloat, imageDescriberIndexes, useGPU, regionsPerDescriber);
+    writeView(job, imageDescriberIndexes, regionsPerDescriber);
+  }
+
   const sfmData::SfMData& _sfmData;
   std::vector<std::shared_ptr<feature::ImageDescriber>> _imageDescribers;
   std::string _outputFolder;
@@ -249,6 +545,8 @@ private:
   int _maxThreads = -1;
   std::vector<ViewJob> _cpuJobs;
   std::vector<ViewJob> _gpuJobs;
+  /// buffers of the decoded images, shared by the decode and describe threads
+  image::ImagePool<float> _imagePool;
 };
 
 
@@ -270,6 +568,7 @@ int main(int argc, char **argv)
   int rangeSize = 1;
   int maxThreads = 0;
   bool forceCpuExtraction = false;
+  std::size_t tileSize = 0;
 
   po::options_description allParams("AliceVision featureExtraction");
 
@@ -289,6 +588,9 @@ int main(int argc, char **argv)
       "Configuration 'ultra' can take long time !")
     ("forceCpuExtraction", po::value<bool>(&forceCpuExtraction)->default_value(forceCpuExtraction),
       "Use only CPU feature extraction methods.")
+    ("tileSize", po::value<std::size_t>(&tileSize)->default_value(tileSize),
+      "Images larger than this size (in pixels) are processed on overlapping tiles in parallel, "
+      "to reduce the memory needed by very large images (0 to disable the tiling).")
     ("rangeStart", po::value<int>(&rangeStart)->default_value(rangeStart),
       "Range image index start.")
     ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
@@ -394,6 +696,7 @@ int main(int argc, char **argv)
     {
       std::shared_ptr<feature::ImageDescriber> imageDescriber = feature::createImageDescriber(imageDescriberType);
       imageDescriber->setConfigurationPreset(describerPreset);
+      imageDescriber->setTileSize(tileSize);
       if(forceCpuExtraction)
         imageDescriber->setUseCuda(false);
 
@@ -408,7 +711,11 @@ int main(int argc, char **argv)
   {
     system::Timer timer;
 
-    extractor.process();
+    if(!extractor.process())
+    {
+      ALICEVISION_LOG_ERROR("Feature extraction failed.");
+      return EXIT_FAILURE;
+    }
 
     ALICEVISION_LOG_INFO("Task done in (s): " + std::to_string(timer.elapsed()));
   }
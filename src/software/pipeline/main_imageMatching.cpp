@@ -7,6 +7,7 @@
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
 #include <aliceVision/voctree/Database.hpp>
+#include <aliceVision/voctree/FlatSparseHistogram.hpp>
 #include <aliceVision/voctree/VocabularyTree.hpp>
 #include <aliceVision/voctree/databaseIO.hpp>
 #include <aliceVision/system/Logger.hpp>
@@ -21,6 +22,7 @@
 #include <iostream>
 #include <fstream>
 #include <ostream>
+#include <memory>
 #include <string>
 #include <set>
 #include <chrono>
@@ -28,7 +30,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 static const int DIMENSION = 128;
 
@@ -294,7 +296,8 @@ void generateFromVoctree(PairList& allMatches,
                          const aliceVision::voctree::VocabularyTree<DescriptorFloat>& tree,
                          EImageMatchingMode modeMultiSfM,
                          std::size_t nbMaxDescriptors,
-                         std::size_t numImageQuery)
+                         std::size_t numImageQuery,
+                         const aliceVision::voctree::HistogramCache* histogramCache)
 {
   ALICEVISION_LOG_INFO("Generate matches in mode: " + EImageMatchingMode_enumToString(modeMultiSfM));
 
@@ -330,11 +333,10 @@ void generateFromVoctree(PairList& allMatches,
     }
     else // mode AB
     {
-      // compute the sparse histogram of each image A
-      std::vector<DescriptorUChar> descriptors;
-      // read the descriptors
-      loadDescsFromBinFile(featuresPathA, descriptors, false, nbMaxDescriptors);
-      imageSH = tree.quantizeToSparse(descriptors);
+      // compute the sparse histogram of each image A (or read it from the cache)
+      aliceVision::voctree::FlatSparseHistogram histogram;
+      aliceVision::voctree::computeHistogram<DescriptorUChar>(viewIdA, featuresPathA, tree, histogram, nbMaxDescriptors, histogramCache);
+      imageSH = histogram.toSparseHistogram();
     }
 
     std::vector<aliceVision::voctree::DocMatch> matches;
@@ -378,6 +380,8 @@ int main(int argc, char** argv)
   std::string weightsName;
   /// flag for the optional weights file
   bool withWeights = false;
+  /// the folder of the cache of the image histograms
+  std::string histogramCacheFolder;
 
   // multiple SfM parameters
 
@@ -419,7 +423,10 @@ int main(int argc, char** argv)
       "The number of matches to retrieve for each image (If 0 it will "
       "retrieve all the matches).")
     ("weights,w", po::value<std::string>(&weightsName),
-      "Input name for the vocabulary tree weight file, if not provided all voctree leaves will have the same weight.");
+      "Input name for the vocabulary tree weight file, if not provided all voctree leaves will have the same weight.")
+    ("histogramCache", po::value<std::string>(&histogramCacheFolder)->default_value(histogramCacheFolder),
+      "Folder of the cache of the image histograms: the next runs with the same vocabulary tree and maxDescriptors "
+      "skip the loading and the quantization of the descriptors (if empty, no cache).");
 
   po::options_description multiSfMParams("Multiple SfM");
   multiSfMParams.add_options()
@@ -570,6 +577,13 @@ int main(int argc, char** argv)
     if(matchingMode == EImageMatchingMode::A_A_AND_A_B)
       db2 = db; // initialize database2 with database1 initialization
 
+    std::unique_ptr<aliceVision::voctree::HistogramCache> histogramCache;
+    if(!histogramCacheFolder.empty())
+    {
+      ALICEVISION_LOG_INFO("Using the histogram cache: " << histogramCacheFolder);
+      histogramCache.reset(new aliceVision::voctree::HistogramCache(histogramCacheFolder, treeName, nbMaxDescriptors));
+    }
+
     // read the descriptors and populate the databases
     {
       std::stringstream ss;
@@ -590,7 +604,7 @@ int main(int argc, char** argv)
            (matchingMode == EImageMatchingMode::A_AB) ||
            (matchingMode == EImageMatchingMode::A_A))
         {
-          nbFeaturesLoadedInputA = voctree::populateDatabase<DescriptorUChar>(sfmDataA, featuresFolders, tree, db, nbMaxDescriptors);
+          nbFeaturesLoadedInputA = voctree::populateDatabase<DescriptorUChar>(sfmDataA, featuresFolders, tree, db, nbMaxDescriptors, histogramCache.get());
           nbSetDescriptors = db.getSparseHistogramPerImage().size();
 
           if(nbFeaturesLoadedInputA == 0)
@@ -603,13 +617,13 @@ int main(int argc, char** argv)
         if((matchingMode == EImageMatchingMode::A_AB) ||
            (matchingMode == EImageMatchingMode::A_B))
         {
-          nbFeaturesLoadedInputB = voctree::populateDatabase<DescriptorUChar>(sfmDataB, featuresFolders, tree, db, nbMaxDescriptors);
+          nbFeaturesLoadedInputB = voctree::populateDatabase<DescriptorUChar>(sfmDataB, featuresFolders, tree, db, nbMaxDescriptors, histogramCache.get());
           nbSetDescriptors = db.getSparseHistogramPerImage().size();
         }
 
         if(matchingMode == EImageMatchingMode::A_A_AND_A_B)
         {
-          nbFeaturesLoadedInputB = voctree::populateDatabase<DescriptorUChar>(sfmDataB, featuresFolders, tree, db2, nbMaxDescriptors);
+          nbFeaturesLoadedInputB = voctree::populateDatabase<DescriptorUChar>(sfmDataB, featuresFolders, tree, db2, nbMaxDescriptors, histogramCache.get());
           nbSetDescriptors += db2.getSparseHistogramPerImage().size();
         }
 
@@ -646,12 +660,12 @@ int main(int argc, char** argv)
 
       if(matchingMode == EImageMatchingMode::A_A_AND_A_B)
       {
-        generateFromVoctree(allMatches, descriptorsFilesA, db,  tree, EImageMatchingMode::A_A, nbMaxDescriptors, numImageQuery);
-        generateFromVoctree(allMatches, descriptorsFilesA, db2, tree, EImageMatchingMode::A_B, nbMaxDescriptors, numImageQuery);
+        generateFromVoctree(allMatches, descriptorsFilesA, db,  tree, EImageMatchingMode::A_A, nbMaxDescriptors, numImageQuery, histogramCache.get());
+        generateFromVoctree(allMatches, descriptorsFilesA, db2, tree, EImageMatchingMode::A_B, nbMaxDescriptors, numImageQuery, histogramCache.get());
       }
       else
       {
-        generateFromVoctree(allMatches, descriptorsFilesA, db, tree, matchingMode,  nbMaxDescriptors, numImageQuery);
+        generateFromVoctree(allMatches, descriptorsFilesA, db, tree, matchingMode,  nbMaxDescriptors, numImageQuery, histogramCache.get());
       }
 
       auto detect_elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - detect_start);
@@ -17,14 +17,18 @@
 #include <aliceVision/fuseCut/ReconstructionPlan.hpp>
 #include <aliceVision/fuseCut/DelaunayGraphCut.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 
+#include <cstdlib>
+#include <thread>
+
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -80,6 +84,110 @@ inline std::istream& operator>>(std::istream& in, ERepartitionMode& out_mode)
 }
 
 
+enum EPartitioningStage
+{
+    eStageUndefined = 0,
+    eStageAll = 1,
+    eStagePlan = 2,
+    eStageReconstruct = 3,
+    eStageMerge = 4,
+};
+
+EPartitioningStage EPartitioningStage_stringToEnum(const std::string& s)
+{
+    if(s == "all")
+        return eStageAll;
+    if(s == "plan")
+        return eStagePlan;
+    if(s == "reconstruct")
+        return eStageReconstruct;
+    if(s == "merge")
+        return eStageMerge;
+    return eStageUndefined;
+}
+
+inline std::istream& operator>>(std::istream& in, EPartitioningStage& out_stage)
+{
+    std::string s;
+    in >> s;
+    out_stage = EPartitioningStage_stringToEnum(s);
+    return in;
+}
+
+/**
+ * @brief Build the command line of a child process reconstructing a range of voxels.
+ * The stage, range and threads options of the current command line are replaced.
+ */
+std::string buildVoxelRangeCommandLine(int argc, char* argv[], int voxelRangeStart, int voxelRangeSize, int maxThreads)
+{
+    const std::vector<std::string> replacedOptions = {"--partitioningStage", "--nbLocalProcesses", "--voxelRangeStart", "--voxelRangeSize", "--maxThreads"};
+
+    std::string cmd = std::string("\"") + argv[0] + "\"";
+    for(int i = 1; i < argc; ++i)
+    {
+        const std::string arg(argv[i]);
+        bool isReplaced = false;
+        for(const std::string& option : replacedOptions)
+        {
+            if(arg == option)
+            {
+                isReplaced = true;
+                ++i; // skip the option value
+                break;
+            }
+            if(arg.compare(0, option.size() + 1, option + "=") == 0)
+            {
+                isReplaced = true;
+                break;
+            }
+        }
+        if(!isReplaced)
+            cmd += " \"" + arg + "\"";
+    }
+    cmd += " --partitioningStage reconstruct";
+    cmd += " --voxelRangeStart " + std::to_string(voxelRangeStart);
+    cmd += " --voxelRangeSize " + std::to_string(voxelRangeSize);
+    cmd += " --maxThreads " + std::to_string(maxThreads);
+    return cmd;
+}
+
+/**
+ * @brief Reconstruct all the voxels with @p nbProcesses local processes running in parallel.
+ * The available threads are shared between the processes.
+ * @return true if all the processes succeed
+ */
+bool runLocalVoxelsReconstruction(int argc, char* argv[], int nbVoxels, int nbProcesses)
+{
+    nbProcesses = std::max(1, std::min(nbProcesses, nbVoxels));
+    const int voxelRangeSize = (nbVoxels + nbProcesses - 1) / nbProcesses;
+    const int maxThreadsPerProcess = std::max(1, omp_get_max_threads() / nbProcesses);
+
+    std::vector<std::thread> workers;
+    std::vector<int> returnCodes(nbProcesses, EXIT_FAILURE);
+
+    for(int p = 0; p < nbProcesses; ++p)
+    {
+        const std::string cmd = buildVoxelRangeCommandLine(argc, argv, p * voxelRangeSize, voxelRangeSize, maxThreadsPerProcess);
+        ALICEVISION_LOG_INFO("Start local process " << p << ": " << cmd);
+        workers.emplace_back([cmd, p, &returnCodes]()
+        {
+            returnCodes[p] = std::system(cmd.c_str());
+        });
+    }
+
+    bool success = true;
+    for(int p = 0; p < nbProcesses; ++p)
+    {
+        workers[p].join();
+        if(returnCodes[p] != EXIT_SUCCESS)
+        {
+            ALICEVISION_LOG_ERROR("Local process " << p << " failed with return code: " << returnCodes[p]);
+            success = false;
+        }
+    }
+    return success;
+}
+
 int main(int argc, char* argv[])
 {
     system::Timer timer;
@@ -94,6 +202,11 @@ int main(int argc, char* argv[])
     ERepartitionMode repartitionMode = eRepartitionMultiResolution;
     po::options_description inputParams;
     int maxPtsPerVoxel = 6000000;
+    EPartitioningStage partitioningStage = eStageAll;
+    int voxelRangeStart = -1;
+    int voxelRangeSize = -1;
+    int nbLocalProcesses = 0;
+    int maxThreads = 0;
 
     fuseCut::FuseParams fuseParams;
 
@@ -128,7 +241,19 @@ int main(int argc, char* argv[])
         ("partitioning", po::value<EPartitioningMode>(&partitioningMode)->default_value(partitioningMode),
             "Partitioning: 'singleBlock' or 'auto'.")
         ("repartition", po::value<ERepartitionMode>(&repartitionMode)->default_value(repartitionMode),
-            "Repartition: 'multiResolution' or 'regularGrid'.");
+            "Repartition: 'multiResolution' or 'regularGrid'.")
+        ("partitioningStage", po::value<EPartitioningStage>(&partitioningStage)->default_value(partitioningStage),
+            "Stage of the 'regularGrid' / 'auto' partitioning to run: 'all', 'plan' (write one job per voxel), "
+            "'reconstruct' (reconstruct the voxels from voxelRangeStart to voxelRangeStart+voxelRangeSize) "
+            "or 'merge' (join the voxels meshes and visibilities).")
+        ("voxelRangeStart", po::value<int>(&voxelRangeStart)->default_value(voxelRangeStart),
+            "Reconstruct a sub-range of voxels from index voxelRangeStart to voxelRangeStart+voxelRangeSize.")
+        ("voxelRangeSize", po::value<int>(&voxelRangeSize)->default_value(voxelRangeSize),
+            "Reconstruct a sub-range of N voxels (N=voxelRangeSize).")
+        ("nbLocalProcesses", po::value<int>(&nbLocalProcesses)->default_value(nbLocalProcesses),
+            "With the 'all' stage, reconstruct the voxels in N local processes running in parallel (0 or 1: in this process).")
+        ("maxThreads", po::value<int>(&maxThreads)->default_value(maxThreads),
+            "Maximum number of threads (0: all the available threads).");
 
     po::options_description advancedParams("Advanced parameters");
     advancedParams.add_options()
@@ -189,6 +314,9 @@ int main(int argc, char* argv[])
     // set verbose level
     system::Logger::get()->setLogLevel(verboseLevel);
 
+    if(maxThreads > 0)
+        omp_set_num_threads(maxThreads);
+
     // .ini and files parsing
     mvsUtils::MultiViewParams mp(iniFilepath, depthMapFolder, depthMapFilterFolder, true);
     mvsUtils::PreMatchCams pc(&mp);
@@ -205,6 +333,11 @@ int main(int argc, char* argv[])
     ALICEVISION_LOG_WARNING("repartitionMode: " << repartitionMode);
     ALICEVISION_LOG_WARNING("partitioningMode: " << partitioningMode);
 
+    if(partitioningStage == eStageUndefined)
+        throw std::invalid_argument("Partitioning stage is not defined");
+    if(partitioningStage != eStageAll && (repartitionMode != eRepartitionRegularGrid || partitioningMode != ePartitioningAuto))
+        throw std::invalid_argument("Partitioning stages are only available with 'regularGrid' repartition and 'auto' partitioning.");
+
     switch(repartitionMode)
     {
         case eRepartitionRegularGrid:
@@ -215,10 +348,16 @@ int main(int argc, char* argv[])
                 {
                     ALICEVISION_LOG_INFO("Meshing mode: regular Grid, partitioning: auto.");
                     fuseCut::LargeScale lsbase(&mp, &pc, tmpDirectory.string() + "/");
-                    lsbase.generateSpace(maxPtsPerVoxel, ocTreeDim, true);
                     std::string voxelsArrayFileName = lsbase.spaceFolderName + "hexahsToReconstruct.bin";
+                    const bool voxelsArrayExists = bfs::exists(voxelsArrayFileName);
+
+                    // check before generating the space: the voxels array is only computed by the 'all' and 'plan' stages
+                    if(!voxelsArrayExists && (partitioningStage == eStageReconstruct || partitioningStage == eStageMerge))
+                        throw std::runtime_error("Missing voxels array, the 'plan' stage should be run first: " + voxelsArrayFileName);
+
+                    lsbase.generateSpace(maxPtsPerVoxel, ocTreeDim, true);
                     StaticVector<Point3d>* voxelsArray = nullptr;
-                    if(bfs::exists(voxelsArrayFileName))
+                    if(voxelsArrayExists)
                     {
                         // If already computed reload it.
                         ALICEVISION_LOG_INFO("Voxels array already computed, reload from file: " << voxelsArrayFileName);
@@ -231,7 +370,50 @@ int main(int argc, char* argv[])
                         voxelsArray = rp.computeReconstructionPlanBinSearch(fuseParams.maxPoints);
                         saveArrayToFile<Point3d>(voxelsArrayFileName, voxelsArray);
                     }
-                    fuseCut::reconstructSpaceAccordingToVoxelsArray(voxelsArrayFileName, &lsbase);
+
+                    const int nbVoxels = voxelsArray->size() / 8;
+                    ALICEVISION_LOG_INFO("Number of voxels to reconstruct: " << nbVoxels);
+
+                    if(partitioningStage == eStagePlan)
+                    {
+                        fuseCut::writeVoxelsReconstructionJobs(voxelsArrayFileName, &lsbase);
+                        delete voxelsArray;
+                        break;
+                    }
+
+                    if(partitioningStage == eStageReconstruct)
+                    {
+                        if(voxelRangeSize != -1 && voxelRangeStart < 0)
+                            throw std::invalid_argument("Invalid sub-range of voxels to reconstruct.");
+                        fuseCut::reconstructSpaceAccordingToVoxelsArray(voxelsArrayFileName, &lsbase, voxelRangeStart, voxelRangeSize);
+                        delete voxelsArray;
+                        break;
+                    }
+
+                    if(partitioningStage == eStageAll)
+                    {
+                        if(nbLocalProcesses > 1)
+                        {
+                            fuseCut::writeVoxelsReconstructionJobs(voxelsArrayFileName, &lsbase);
+                            if(!runLocalVoxelsReconstruction(argc, argv, nbVoxels, nbLocalProcesses))
+                                throw std::runtime_error("Voxels reconstruction failed.");
+                        }
+                        else
+                        {
+                            fuseCut::reconstructSpaceAccordingToVoxelsArray(voxelsArrayFileName, &lsbase);
+                        }
+                    }
+
+                    // Merge stage
+                    const std::vector<std::string> recsDirs = lsbase.getRecsDirs(voxelsArray);
+                    const std::vector<int> notReconstructedVoxels = fuseCut::getNotReconstructedVoxels(recsDirs);
+                    if(!notReconstructedVoxels.empty())
+                    {
+                        for(int voxelId : notReconstructedVoxels)
+                            ALICEVISION_LOG_ERROR("Voxel " << voxelId << " is not reconstructed: " << recsDirs[voxelId]);
+                        throw std::runtime_error(std::to_string(notReconstructedVoxels.size()) + " voxel(s) not reconstructed, cannot merge.");
+                    }
+
                     // Join meshes
                     mesh::Mesh* mesh = fuseCut::joinMeshes(voxelsArrayFileName, &lsbase);
 
@@ -249,9 +431,10 @@ int main(int argc, char* argv[])
                     delete mesh;
 
                     // Join ptsCams
-                    StaticVector<StaticVector<int>*>* ptsCams = fuseCut::loadLargeScalePtsCams(lsbase.getRecsDirs(voxelsArray));
+                    StaticVector<StaticVector<int>*>* ptsCams = fuseCut::loadLargeScalePtsCams(recsDirs);
                     saveArrayOfArraysToFile<int>((outDirectory/"meshPtsCamsFromDGC.bin").string(), ptsCams);
                     deleteArrayOfArrays<int>(&ptsCams);
+                    delete voxelsArray;
                     break;
                 }
                 case ePartitioningSingleBlock:
@@ -9,6 +9,7 @@
 #include <aliceVision/image/all.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/system/ConcurrentQueue.hpp>
 #include <aliceVision/config.hpp>
 
 #include <boost/program_options.hpp>
@@ -22,6 +23,9 @@
 #include <set>
 #include <iterator>
 #include <iomanip>
+#include <atomic>
+#include <memory>
+#include <thread>
 
 // These constants define the current software version.
 // They must be updated when the command line is changed.
@@ -154,6 +158,14 @@ void retrieveSeedsPerView(
   }
 }
 
+/// Image of a view going through the export pipeline
+struct ViewImage
+{
+  IndexT viewId = UndefinedIndexT;
+  Image<RGBfColor> image;
+  oiio::ParamValueList metadata;
+};
+
 bool prepareDenseScene(const SfMData& sfmData, const std::string& outFolder)
 {
   // defined view Ids
@@ -177,119 +189,178 @@ bool prepareDenseScene(const SfMData& sfmData, const std::string& outFolder)
   //   - viewId_P.txt (Pose of the reconstructed camera)
   //   - viewId.exr (undistorted colored image)
   //   - viewId_seeds.bin (3d points visible in this image)
+  //
+  // The views go through a pipeline: a reader thread loads the source images,
+  // the main thread exports the camera and seeds files and undistorts the image (multithreaded),
+  // a writer thread writes the undistorted images.
 
-#pragma omp parallel for num_threads(3)
-  for(int i = 0; i < viewIds.size(); ++i)
-  {
-    auto itView = viewIds.begin();
-    std::advance(itView, i);
-
-    const IndexT viewId = *itView;
-    const View* view = sfmData.getViews().at(viewId).get();
-
-    assert(view->getViewId() == viewId);
-    Intrinsics::const_iterator iterIntrinsic = sfmData.getIntrinsics().find(view->getIntrinsicId());
+  // the views sharing an intrinsic share the same undistortion remap table
+  camera::UndistortRemapCache remapCache;
 
-    // We have a valid view with a corresponding camera & pose
-    const std::string baseFilename = std::to_string(viewId);
+  // bounded queues: limit the number of images in memory
+  system::ConcurrentQueue<std::shared_ptr<ViewImage>> readQueue(2);
+  system::ConcurrentQueue<std::shared_ptr<ViewImage>> writeQueue(2);
+  std::atomic<bool> success(true);
 
-    oiio::ParamValueList metadata;
+  std::thread reader([&]()
+  {
+    try
+    {
+      for(const IndexT viewId : viewIds)
+      {
+        std::shared_ptr<ViewImage> viewImage = std::make_shared<ViewImage>();
+        viewImage->viewId = viewId;
+        readImage(sfmData.getViews().at(viewId)->getImagePath(), viewImage->image);
+        if(!readQueue.push(viewImage))
+          break;
+      }
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_ERROR("Cannot read image: " << e.what());
+      success = false;
+    }
+    readQueue.close();
+  });
 
-    // Export camera
+  std::thread writer([&]()
+  {
+    std::shared_ptr<ViewImage> viewImage;
+    try
     {
-      // Export camera pose
-      const Pose3 pose = sfmData.getPose(*view).getTransform();
-      Mat34 P = iterIntrinsic->second.get()->get_projective_equivalent(pose);
-      std::ofstream fileP((fs::path(outFolder) / (baseFilename + "_P.txt")).string());
-      fileP << std::setprecision(10)
-           << P(0, 0) << " " << P(0, 1) << " " << P(0, 2) << " " << P(0, 3) << "\n"
-           << P(1, 0) << " " << P(1, 1) << " " << P(1, 2) << " " << P(1, 3) << "\n"
-           << P(2, 0) << " " << P(2, 1) << " " << P(2, 2) << " " << P(2, 3) << "\n";
-      fileP.close();
-
-      Mat4 projectionMatrix;
-
-      projectionMatrix << P(0, 0), P(0, 1), P(0, 2), P(0, 3),
-                          P(1, 0), P(1, 1), P(1, 2), P(1, 3),
-                          P(2, 0), P(2, 1), P(2, 2), P(2, 3),
-                                0,       0,       0,       1;
-
-      // Export camera intrinsics
-      const Mat3 K = dynamic_cast<const Pinhole*>(sfmData.getIntrinsicPtr(view->getIntrinsicId()))->K();
-      const Mat3& R = pose.rotation();
-      const Vec3& t = pose.translation();
-      std::ofstream fileKRt((fs::path(outFolder) / (baseFilename + "_KRt.txt")).string());
-      fileKRt << std::setprecision(10)
-           << K(0, 0) << " " << K(0, 1) << " " << K(0, 2) << "\n"
-           << K(1, 0) << " " << K(1, 1) << " " << K(1, 2) << "\n"
-           << K(2, 0) << " " << K(2, 1) << " " << K(2, 2) << "\n"
-           << "\n"
-           << R(0, 0) << " " << R(0, 1) << " " << R(0, 2) << "\n"
-           << R(1, 0) << " " << R(1, 1) << " " << R(1, 2) << "\n"
-           << R(2, 0) << " " << R(2, 1) << " " << R(2, 2) << "\n"
-           << "\n"
-           << t(0) << " " << t(1) << " " << t(2) << "\n";
-      fileKRt.close();
-
-
-      // convert matrices to rowMajor
-      std::vector<double> vP(projectionMatrix.size());
-      std::vector<double> vK(K.size());
-      std::vector<double> vR(R.size());
-
-      typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXd;
-      Eigen::Map<RowMatrixXd>(vP.data(), projectionMatrix.rows(), projectionMatrix.cols()) = projectionMatrix;
-      Eigen::Map<RowMatrixXd>(vK.data(), K.rows(), K.cols()) = K;
-      Eigen::Map<RowMatrixXd>(vR.data(), R.rows(), R.cols()) = R;
-
-      // add metadata
-      metadata.push_back(oiio::ParamValue("AliceVision:downscale", 1));
-      metadata.push_back(oiio::ParamValue("AliceVision:P", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX44), 1, vP.data()));
-      metadata.push_back(oiio::ParamValue("AliceVision:K", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX33), 1, vK.data()));
-      metadata.push_back(oiio::ParamValue("AliceVision:R", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX33), 1, vR.data()));
-      metadata.push_back(oiio::ParamValue("AliceVision:t", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::VEC3), 1, t.data()));
+      while(writeQueue.pop(viewImage))
+      {
+        writeImage((fs::path(outFolder) / (std::to_string(viewImage->viewId) + ".exr")).string(), viewImage->image, viewImage->metadata);
+        ++my_progress_bar;
+      }
     }
-    
-    // Export undistort image
+    catch(const std::exception& e)
     {
-      const std::string srcImage = view->getImagePath();
-      std::string dstColorImage = (fs::path(outFolder) / (baseFilename + ".exr")).string();
+      ALICEVISION_LOG_ERROR("Cannot write image: " << e.what());
+      success = false;
+    }
+    // stop the pipeline on error
+    writeQueue.close();
+    readQueue.close();
+  });
 
-      const IntrinsicBase* cam = iterIntrinsic->second.get();
-      Image<RGBfColor> image, image_ud;
+  try
+  {
+    std::shared_ptr<ViewImage> viewImage;
+    while(readQueue.pop(viewImage))
+    {
+      const IndexT viewId = viewImage->viewId;
+      const View* view = sfmData.getViews().at(viewId).get();
 
-      readImage(srcImage, image);
-      
-      // Undistort
-      if(cam->isValid() && cam->have_disto())
+      assert(view->getViewId() == viewId);
+      Intrinsics::const_iterator iterIntrinsic = sfmData.getIntrinsics().find(view->getIntrinsicId());
+
+      // We have a valid view with a corresponding camera & pose
+      const std::string baseFilename = std::to_string(viewId);
+
+      oiio::ParamValueList& metadata = viewImage->metadata;
+
+      // Export camera
       {
-        // undistort the image and save it
-        UndistortImage(image, cam, image_ud, FBLACK);
-        writeImage(dstColorImage, image_ud, metadata);
+        // Export camera pose
+        const Pose3 pose = sfmData.getPose(*view).getTransform();
+        Mat34 P = iterIntrinsic->second.get()->get_projective_equivalent(pose);
+        std::ofstream fileP((fs::path(outFolder) / (baseFilename + "_P.txt")).string());
+        fileP << std::setprecision(10)
+             << P(0, 0) << " " << P(0, 1) << " " << P(0, 2) << " " << P(0, 3) << "\n"
+             << P(1, 0) << " " << P(1, 1) << " " << P(1, 2) << " " << P(1, 3) << "\n"
+             << P(2, 0) << " " << P(2, 1) << " " << P(2, 2) << " " << P(2, 3) << "\n";
+        fileP.close();
+
+        Mat4 projectionMatrix;
+
+        projectionMatrix << P(0, 0), P(0, 1), P(0, 2), P(0, 3),
+                            P(1, 0), P(1, 1), P(1, 2), P(1, 3),
+                            P(2, 0), P(2, 1), P(2, 2), P(2, 3),
+                                  0,       0,       0,       1;
+
+        // Export camera intrinsics
+        const Mat3 K = dynamic_cast<const Pinhole*>(sfmData.getIntrinsicPtr(view->getIntrinsicId()))->K();
+        const Mat3& R = pose.rotation();
+        const Vec3& t = pose.translation();
+        std::ofstream fileKRt((fs::path(outFolder) / (baseFilename + "_KRt.txt")).string());
+        fileKRt << std::setprecision(10)
+             << K(0, 0) << " " << K(0, 1) << " " << K(0, 2) << "\n"
+             << K(1, 0) << " " << K(1, 1) << " " << K(1, 2) << "\n"
+             << K(2, 0) << " " << K(2, 1) << " " << K(2, 2) << "\n"
+             << "\n"
+             << R(0, 0) << " " << R(0, 1) << " " << R(0, 2) << "\n"
+             << R(1, 0) << " " << R(1, 1) << " " << R(1, 2) << "\n"
+             << R(2, 0) << " " << R(2, 1) << " " << R(2, 2) << "\n"
+             << "\n"
+             << t(0) << " " << t(1) << " " << t(2) << "\n";
+        fileKRt.close();
+
+
+        // convert matrices to rowMajor
+        std::vector<double> vP(projectionMatrix.size());
+        std::vector<double> vK(K.size());
+        std::vector<double> vR(R.size());
+
+        typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXd;
+        Eigen::Map<RowMatrixXd>(vP.data(), projectionMatrix.rows(), projectionMatrix.cols()) = projectionMatrix;
+        Eigen::Map<RowMatrixXd>(vK.data(), K.rows(), K.cols()) = K;
+        Eigen::Map<RowMatrixXd>(vR.data(), R.rows(), R.cols()) = R;
+
+        // add metadata
+        metadata.push_back(oiio::ParamValue("AliceVision:downscale", 1));
+        metadata.push_back(oiio::ParamValue("AliceVision:P", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX44), 1, vP.data()));
+        metadata.push_back(oiio::ParamValue("AliceVision:K", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX33), 1, vK.data()));
+        metadata.push_back(oiio::ParamValue("AliceVision:R", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX33), 1, vR.data()));
+        metadata.push_back(oiio::ParamValue("AliceVision:t", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::VEC3), 1, t.data()));
       }
-      else
+    
+      // Undistort image
       {
-        writeImage(dstColorImage, image, metadata);
+        const IntrinsicBase* cam = iterIntrinsic->second.get();
+
+        if(cam->isValid() && cam->have_disto())
+        {
+          Image<RGBfColor> image_ud;
+          UndistortImage(viewImage->image, *remapCache.get(*cam, viewImage->image.Width(), viewImage->image.Height()), image_ud, FBLACK);
+          viewImage->image.swap(image_ud);
+        }
       }
-    }
     
-    // Export Seeds
-    {
-      const std::string seedsFilepath = (fs::path(outFolder) / (baseFilename + "_seeds.bin")).string();
-      std::ofstream seedsFile(seedsFilepath, std::ios::binary);
+      // Export Seeds
+      {
+        const std::string seedsFilepath = (fs::path(outFolder) / (baseFilename + "_seeds.bin")).string();
+        std::ofstream seedsFile(seedsFilepath, std::ios::binary);
       
-      const int nbSeeds = seedsPerView[viewId].size();
-      seedsFile.write((char*)&nbSeeds, sizeof(int));
+        const int nbSeeds = seedsPerView[viewId].size();
+        seedsFile.write((char*)&nbSeeds, sizeof(int));
       
-      for(const Seed& seed: seedsPerView.at(viewId))
-      {
-        seedsFile.write((char*)&seed, sizeof(seed_io_block) + sizeof(unsigned short) + 2 * sizeof(point2d)); //sizeof(Seed));
+        for(const Seed& seed: seedsPerView.at(viewId))
+        {
+          seedsFile.write((char*)&seed, sizeof(seed_io_block) + sizeof(unsigned short) + 2 * sizeof(point2d)); //sizeof(Seed));
+        }
+        seedsFile.close();
       }
-      seedsFile.close();
+
+      // the image is written by the writer thread
+      if(!writeQueue.push(viewImage))
+        break;
     }
-   #pragma omp critical
-    ++my_progress_bar;
   }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_ERROR("Cannot export view: " << e.what());
+    success = false;
+  }
+  // stop the reader if the loop has been interrupted
+  readQueue.close();
+  writeQueue.close();
+
+  reader.join();
+  writer.join();
+
+  if(!success)
+    return false;
 
   // Write the mvs ini file
   std::ostringstream os;
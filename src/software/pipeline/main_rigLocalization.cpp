@@ -43,7 +43,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -103,6 +103,8 @@ int main(int argc, char** argv)
   std::string vocTreeFilepath;
   /// the vocabulary tree weights file
   std::string weightsFilepath;
+  /// the localization map file
+  std::string localizationMapFilepath;
   /// the localization algorithm to use for the voctree localizer
   std::string algostring = "AllResults";
   /// number of documents to search when querying the voctree
@@ -168,6 +170,9 @@ int main(int argc, char** argv)
           "[voctree] Filename for the vocabulary tree")
       ("voctreeWeights", po::value<std::string>(&weightsFilepath),
           "[voctree] Filename for the vocabulary tree weights")
+      ("localizationMap", po::value<std::string>(&localizationMapFilepath),
+          "[voctree] Filename for the localization map (see aliceVision_utils_localizationMapCreation), "
+          "it replaces the loading of the features and descriptors of the scene")
       ("algorithm", po::value<std::string>(&algostring)->default_value(algostring),
           "[voctree] Algorithm type: {FirstBest,AllResults}" )
       ("nbImageMatch", po::value<std::size_t>(&numResults)->default_value(numResults),
@@ -272,7 +277,8 @@ int main(int argc, char** argv)
                                                             descriptorsFolder,
                                                             vocTreeFilepath,
                                                             weightsFilepath,
-                                                            matchDescTypes
+                                                            matchDescTypes,
+                                                            localizationMapFilepath
                                                             );
     localizer.reset(tmpLoc);
     
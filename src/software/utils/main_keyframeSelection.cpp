@@ -16,7 +16,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision::keyframe;
 
@@ -43,6 +43,9 @@ int main(int argc, char** argv)
   unsigned int minFrameStep = 12;
   unsigned int maxFrameStep = 36;
   unsigned int maxNbOutFrame = 0;
+  bool pipelined = false;
+  unsigned int maxThreads = 0;
+  unsigned int decodeAheadFrames = 32;
 
   po::options_description allParams("This program is used to extract keyframes from single camera or a camera rig");
 
@@ -80,7 +83,14 @@ int main(int argc, char** argv)
       ("maxFrameStep", po::value<unsigned int>(&maxFrameStep)->default_value(maxFrameStep), 
         "maximum number of frames after which a keyframe can be taken")
       ("maxNbOutFrame", po::value<unsigned int>(&maxNbOutFrame)->default_value(maxNbOutFrame), 
-        "maximum number of output frames (0 = no limit)");
+        "maximum number of output frames (0 = no limit)")
+      ("pipelined", po::value<bool>(&pipelined)->default_value(pipelined),
+        "decode the frames ahead with a thread per media and evaluate the frames of a step window in parallel "
+        "(same keyframes as the sequential process)")
+      ("maxThreads", po::value<unsigned int>(&maxThreads)->default_value(maxThreads),
+        "maximum number of threads evaluating the frames in pipelined mode (0 = all)")
+      ("decodeAheadFrames", po::value<unsigned int>(&decodeAheadFrames)->default_value(decodeAheadFrames),
+        "maximum number of frames decoded ahead per media in pipelined mode");
 
   allParams.add(inputParams).add(metadataParams).add(algorithmParams);
 
@@ -157,7 +167,10 @@ int main(int argc, char** argv)
                  << "\tsharp subset : "               << sharpSubset     << std::endl
                  << "\tmin frame step : "             << minFrameStep    << std::endl
                  << "\tmax frame step : "             << maxFrameStep    << std::endl
-                 << "\tmax nb out frame : "           << maxNbOutFrame   << std::endl);
+                 << "\tmax nb out frame : "           << maxNbOutFrame   << std::endl
+                 << "\tpipelined : "                  << pipelined       << std::endl
+                 << "\tmax threads : "                << maxThreads      << std::endl
+                 << "\tdecode ahead frames : "        << decodeAheadFrames << std::endl);
   }
 
   // initialize KeyframeSelector
@@ -195,6 +208,9 @@ int main(int argc, char** argv)
   selector.setMinFrameStep(minFrameStep);
   selector.setMaxFrameStep(maxFrameStep);
   selector.setMaxOutFrame(maxNbOutFrame);
+  selector.setPipelined(pipelined);
+  selector.setMaxThreads(maxThreads);
+  selector.setDecodeAheadFrames(decodeAheadFrames);
   
   // process
   selector.process();        
@@ -0,0 +1,285 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/dataio/FeedProvider.hpp>
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/localization/LocalizationServer.hpp>
+#include <aliceVision/localization/localizationServerIO.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/cmdline.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+
+namespace {
+
+/**
+ * @brief Send the frames of a media to the localization server, one request at a time,
+ * as a camera would do.
+ * @return false if the connection or the media failed
+ */
+bool runCamera(int cameraIndex,
+               const std::string& socketPath,
+               const std::string& mediaFilepath,
+               const std::string& calibFile,
+               const std::vector<feature::EImageDescriberType>& describerTypes,
+               feature::EImageDescriberPreset featurePreset,
+               localization::LatencyHistogram& roundTripLatencies,
+               std::atomic<std::size_t>& nbLocalized)
+{
+  dataio::FeedProvider feed(mediaFilepath, calibFile);
+  if(!feed.isInit())
+  {
+    ALICEVISION_LOG_ERROR("[camera " << cameraIndex << "] Cannot initialize the FeedProvider.");
+    return false;
+  }
+
+  const int socket = localization::connectLocalSocket(socketPath);
+  if(socket < 0)
+    return false;
+
+  // the features are extracted by the client: only the regions are sent
+  std::vector<std::unique_ptr<feature::ImageDescriber>> imageDescribers;
+  for(feature::EImageDescriberType describerType : describerTypes)
+  {
+    imageDescribers.push_back(feature::createImageDescriber(describerType));
+    imageDescribers.back()->setConfigurationPreset(featurePreset);
+  }
+
+  image::Image<float> imageGrey;
+  image::Image<unsigned char> imageUChar;
+  camera::PinholeRadialK3 queryIntrinsics;
+  bool hasIntrinsics = false;
+  std::string currentImgName;
+  std::uint64_t frameIndex = 0;
+  bool success = true;
+
+  while(feed.readImage(imageGrey, queryIntrinsics, currentImgName, hasIntrinsics))
+  {
+    localization::LocalizationRequest request;
+    request.id = frameIndex++;
+    request.imageSize = std::make_pair(imageGrey.Width(), imageGrey.Height());
+    request.useInputIntrinsics = hasIntrinsics;
+    request.intrinsics = queryIntrinsics;
+
+    if(imageDescribers.empty())
+    {
+      request.image = imageGrey;
+    }
+    else
+    {
+      imageUChar = (imageGrey.GetMat() * 255.f).cast<unsigned char>();
+      for(const auto& imageDescriber : imageDescribers)
+      {
+        std::unique_ptr<feature::Regions>& regions = request.regions[imageDescriber->getDescriberType()];
+        imageDescriber->allocate(regions);
+        if(imageDescriber->useFloatImage())
+          imageDescriber->describe(imageGrey, regions, nullptr);
+        else
+          imageDescriber->describe(imageUChar, regions, nullptr);
+      }
+    }
+
+    std::ostringstream stream;
+    localization::writeLocalizationRequest(stream, request);
+
+    system::Timer timer;
+    localization::EServerMessage type;
+    std::string payload;
+    if(!localization::sendMessage(socket, localization::EServerMessage::LOCALIZE, stream.str()) ||
+       !localization::receiveMessage(socket, type, payload) ||
+       type != localization::EServerMessage::LOCALIZE_RESULT)
+    {
+      ALICEVISION_LOG_ERROR("[camera " << cameraIndex << "] The connection to the server is lost.");
+      success = false;
+      break;
+    }
+    roundTripLatencies.add(timer.elapsedMs());
+
+    localization::LocalizationResponse response;
+    try
+    {
+      std::istringstream responseStream(payload);
+      localization::readLocalizationResponse(responseStream, response);
+    }
+    catch(std::exception& e)
+    {
+      ALICEVISION_LOG_ERROR("[camera " << cameraIndex << "] " << e.what());
+      success = false;
+      break;
+    }
+
+    if(response.localized)
+      ++nbLocalized;
+
+    ALICEVISION_LOG_INFO("[camera " << cameraIndex << "] " << currentImgName
+                         << (response.localized ? ": localized" : ": not localized")
+                         << ", inliers: " << response.nbInliers << "/" << response.nbAssociations
+                         << ", batch size: " << response.batchSize
+                         << ", server latency: " << response.latenciesMs[static_cast<std::size_t>(localization::ELocalizationStage::TOTAL)] << " ms"
+                         << (response.error.empty() ? std::string() : ", error: " + response.error));
+    if(response.localized)
+      ALICEVISION_LOG_DEBUG("[camera " << cameraIndex << "] center: " << response.pose.center().transpose());
+
+    feed.goToNextFrame();
+  }
+
+  localization::closeLocalSocket(socket);
+  return success;
+}
+
+} // namespace
+
+/*
+ * This program is a test client of the localization server: each simulated camera sends
+ * the frames of a media and waits for their localization before sending the next one.
+ */
+int main(int argc, char** argv)
+{
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string socketPath = "/tmp/aliceVision_localizationServer.sock";
+  std::string mediaFilepath;
+  std::string calibFile;
+  bool sendRegions = false;
+  std::string matchDescTypeNames = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
+  feature::EImageDescriberPreset featurePreset = feature::EImageDescriberPreset::NORMAL;
+  std::size_t nbCameras = 1;
+  bool printServerStatistics = false;
+
+  po::options_description allParams("This program is a test client of the localization server.\n"
+                                    "AliceVision localizationClient");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("mediafile", po::value<std::string>(&mediaFilepath)->required(),
+      "The folder path or the filename for the media to track");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("socket", po::value<std::string>(&socketPath)->default_value(socketPath),
+      "Path of the local socket of the server.")
+    ("calibration", po::value<std::string>(&calibFile),
+      "Calibration file")
+    ("sendRegions", po::value<bool>(&sendRegions)->default_value(sendRegions),
+      "Extract the features on the client and send them instead of the images.")
+    ("matchDescTypes", po::value<std::string>(&matchDescTypeNames)->default_value(matchDescTypeNames),
+      "The describer types to extract with sendRegions.")
+    ("preset", po::value<feature::EImageDescriberPreset>(&featurePreset)->default_value(featurePreset),
+      "Preset for the feature extractor with sendRegions {LOW,MEDIUM,NORMAL,HIGH,ULTRA}.")
+    ("nbCameras", po::value<std::size_t>(&nbCameras)->default_value(nbCameras),
+      "Number of simulated cameras, each one sends all the frames of the media.")
+    ("printServerStatistics", po::value<bool>(&printServerStatistics)->default_value(printServerStatistics),
+      "Print the statistics of the server at the end.");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  std::vector<feature::EImageDescriberType> describerTypes;
+  if(sendRegions)
+    describerTypes = feature::EImageDescriberType_stringToEnums(matchDescTypeNames);
+
+  localization::LatencyHistogram roundTripLatencies;
+  std::atomic<std::size_t> nbLocalized(0);
+  std::atomic<bool> success(true);
+
+  system::Timer timer;
+  std::vector<std::thread> cameras;
+  for(std::size_t i = 0; i < nbCameras; ++i)
+  {
+    cameras.emplace_back([&, i]()
+    {
+      if(!runCamera(i, socketPath, mediaFilepath, calibFile, describerTypes, featurePreset, roundTripLatencies, nbLocalized))
+        success = false;
+    });
+  }
+  for(std::thread& camera : cameras)
+    camera.join();
+
+  const double elapsedMs = timer.elapsedMs();
+  std::ostringstream statistics;
+  statistics << "localized: " << nbLocalized << "/" << roundTripLatencies.count()
+             << ", throughput: " << ((elapsedMs > 0.0) ? roundTripLatencies.count() * 1000.0 / elapsedMs : 0.0) << " images/s" << std::endl
+             << "round trip: ";
+  roundTripLatencies.print(statistics);
+  roundTripLatencies.printBuckets(statistics);
+  ALICEVISION_LOG_INFO("Client statistics:\n" << statistics.str());
+
+  if(printServerStatistics)
+  {
+    const int socket = localization::connectLocalSocket(socketPath);
+    localization::EServerMessage type;
+    std::string payload;
+    if(socket >= 0 &&
+       localization::sendMessage(socket, localization::EServerMessage::STATISTICS, std::string()) &&
+       localization::receiveMessage(socket, type, payload) &&
+       type == localization::EServerMessage::STATISTICS_RESULT)
+    {
+      ALICEVISION_LOG_INFO("Server statistics:\n" << payload);
+    }
+    else
+    {
+      ALICEVISION_LOG_ERROR("Cannot get the statistics of the server.");
+      success = false;
+    }
+    if(socket >= 0)
+      localization::closeLocalSocket(socket);
+  }
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
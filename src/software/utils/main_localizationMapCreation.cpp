@@ -0,0 +1,133 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/localization/VoctreeLocalizer.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/cmdline.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <string>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+
+/*
+ * This program builds the localization map of a scene once: the vocabulary tree database
+ * and the descriptors of the reconstructed landmarks, ready to be loaded by the localizers.
+ */
+int main(int argc, char** argv)
+{
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string sfmDataFilename;
+  std::string descriptorsFolder;
+  std::string vocTreeFilepath;
+  std::string weightsFilepath;
+  std::string matchDescTypeNames = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
+  std::string outputFilepath;
+
+  po::options_description allParams("This program builds the localization map of a scene: the vocabulary tree database\n"
+                                    "and the features of the reconstructed landmarks are saved in a single file,\n"
+                                    "which is loaded by the localizers (--localizationMap) much faster than the features of each view.\n"
+                                    "AliceVision localizationMapCreation");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("input,i", po::value<std::string>(&sfmDataFilename)->required(),
+      "SfMData file of the scene.")
+    ("voctree", po::value<std::string>(&vocTreeFilepath)->required(),
+      "Filename for the vocabulary tree.")
+    ("output,o", po::value<std::string>(&outputFilepath)->required(),
+      "Output localization map file.");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("descriptorPath", po::value<std::string>(&descriptorsFolder),
+      "Folder containing the descriptors for all the images (ie the *.desc.)")
+    ("voctreeWeights", po::value<std::string>(&weightsFilepath),
+      "Filename for the vocabulary tree weights.")
+    ("matchDescTypes", po::value<std::string>(&matchDescTypeNames)->default_value(matchDescTypeNames),
+      "The describer types to use for the matching.");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  // load SfMData
+  sfmData::SfMData sfmData;
+  if(!sfmDataIO::Load(sfmData, sfmDataFilename, sfmDataIO::ESfMData::ALL))
+  {
+    ALICEVISION_LOG_ERROR("The input SfMData file '" + sfmDataFilename + "' cannot be read.");
+    return EXIT_FAILURE;
+  }
+
+  const std::vector<feature::EImageDescriberType> matchDescTypes = feature::EImageDescriberType_stringToEnums(matchDescTypeNames);
+
+  // build the database and the reconstructed regions from the features of each view
+  system::Timer timer;
+  localization::VoctreeLocalizer localizer(sfmData, descriptorsFolder, vocTreeFilepath, weightsFilepath, matchDescTypes);
+  if(!localizer.isInit())
+  {
+    ALICEVISION_LOG_ERROR("Cannot initialize the localizer.");
+    return EXIT_FAILURE;
+  }
+  ALICEVISION_LOG_INFO("Localization database built in " << system::prettyTime(timer.elapsedMs()) << ".");
+
+  timer.reset();
+  if(!localizer.saveLocalizationMap(outputFilepath))
+  {
+    ALICEVISION_LOG_ERROR("Cannot save the localization map '" << outputFilepath << "'.");
+    return EXIT_FAILURE;
+  }
+  ALICEVISION_LOG_INFO("Localization map saved in " << system::prettyTime(timer.elapsedMs()) << ": " << outputFilepath);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,354 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/localization/VoctreeLocalizer.hpp>
+#include <aliceVision/localization/LocalizationServer.hpp>
+#include <aliceVision/localization/localizationServerIO.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/robustEstimation/estimators.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/cmdline.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+
+namespace {
+
+std::atomic<bool> stopRequested(false);
+
+void requestStop(int)
+{
+  stopRequested = true;
+}
+
+/// a client connection, the responses can be sent by the worker threads after the client is gone
+struct Connection
+{
+  explicit Connection(int socket)
+    : socket(socket)
+  {}
+
+  ~Connection()
+  {
+    localization::closeLocalSocket(socket);
+  }
+
+  bool send(localization::EServerMessage type, const std::string& payload)
+  {
+    std::lock_guard<std::mutex> lock(sendMutex);
+    return localization::sendMessage(socket, type, payload);
+  }
+
+  const int socket;
+  std::mutex sendMutex;
+};
+
+/// a thread receiving the requests of a client
+struct ClientThread
+{
+  std::thread thread;
+  std::weak_ptr<Connection> connection;
+  std::shared_ptr<std::atomic<bool>> done;
+};
+
+/**
+ * @brief Receive the requests of a client until it disconnects
+ */
+void serveClient(std::shared_ptr<Connection> connection, localization::LocalizationServer& server)
+{
+  localization::EServerMessage type;
+  std::string payload;
+
+  while(localization::receiveMessage(connection->socket, type, payload))
+  {
+    if(type == localization::EServerMessage::STATISTICS)
+    {
+      std::ostringstream statistics;
+      server.printStatistics(statistics, true);
+      connection->send(localization::EServerMessage::STATISTICS_RESULT, statistics.str());
+      continue;
+    }
+    if(type != localization::EServerMessage::LOCALIZE)
+    {
+      ALICEVISION_LOG_WARNING("Unknown message type " << static_cast<std::uint32_t>(type) << ", the client is disconnected.");
+      break;
+    }
+
+    localization::LocalizationRequest request;
+    try
+    {
+      std::istringstream stream(payload);
+      localization::readLocalizationRequest(stream, request);
+    }
+    catch(std::exception& e)
+    {
+      ALICEVISION_LOG_WARNING(e.what() << " The client is disconnected.");
+      break;
+    }
+
+    const bool submitted = server.submit(std::move(request), [connection](const localization::LocalizationResponse& response)
+    {
+      std::ostringstream stream;
+      localization::writeLocalizationResponse(stream, response);
+      connection->send(localization::EServerMessage::LOCALIZE_RESULT, stream.str());
+    });
+
+    if(!submitted)
+      break;
+  }
+}
+
+} // namespace
+
+/*
+ * This program runs a localization service: the vocabulary tree localizer is loaded once,
+ * then the clients send the images (or their features) to localize through a local socket.
+ */
+int main(int argc, char** argv)
+{
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string sfmFilePath;
+  std::string descriptorsFolder;
+  std::string vocTreeFilepath;
+  std::string weightsFilepath;
+  std::string localizationMapFilepath;
+  std::string socketPath = "/tmp/aliceVision_localizationServer.sock";
+  std::string matchDescTypeNames = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
+  feature::EImageDescriberPreset featurePreset = feature::EImageDescriberPreset::NORMAL;
+  robustEstimation::ERobustEstimator resectionEstimator = robustEstimation::ERobustEstimator::ACRANSAC;
+  robustEstimation::ERobustEstimator matchingEstimator = robustEstimation::ERobustEstimator::ACRANSAC;
+  const std::string str_estimatorChoices = robustEstimation::ERobustEstimator_enumToString(robustEstimation::ERobustEstimator::ACRANSAC)
+                                          +", "+robustEstimation::ERobustEstimator_enumToString(robustEstimation::ERobustEstimator::LORANSAC);
+  bool refineIntrinsics = false;
+  double resectionErrorMax = 4.0;
+  double matchingErrorMax = 4.0;
+  std::string algostring = "AllResults";
+  std::size_t numResults = 4;
+  std::size_t maxResults = 10;
+  bool robustMatching = true;
+  std::size_t nbThreads = 0;
+  std::size_t maxBatchSize = 8;
+  std::size_t queueCapacity = 64;
+
+  po::options_description allParams("This program runs a localization server: the scene is loaded once and the clients\n"
+                                    "send the images (or their features) to localize through a local socket.\n"
+                                    "AliceVision localizationServer");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("sfmdata", po::value<std::string>(&sfmFilePath)->required(),
+      "The sfm_data.json kind of file generated by AliceVision.")
+    ("voctree", po::value<std::string>(&vocTreeFilepath)->required(),
+      "Filename for the vocabulary tree.");
+
+  po::options_description localizerParams("Localizer parameters");
+  localizerParams.add_options()
+    ("descriptorPath", po::value<std::string>(&descriptorsFolder),
+      "Folder containing the descriptors for all the images (ie the *.desc.)")
+    ("voctreeWeights", po::value<std::string>(&weightsFilepath),
+      "Filename for the vocabulary tree weights.")
+    ("localizationMap", po::value<std::string>(&localizationMapFilepath),
+      "Filename for the localization map (see aliceVision_utils_localizationMapCreation), "
+      "it replaces the loading of the features and descriptors of the scene.")
+    ("matchDescTypes", po::value<std::string>(&matchDescTypeNames)->default_value(matchDescTypeNames),
+      "The describer types to use for the matching.")
+    ("preset", po::value<feature::EImageDescriberPreset>(&featurePreset)->default_value(featurePreset),
+      "Preset for the feature extractor when localizing a new image {LOW,MEDIUM,NORMAL,HIGH,ULTRA}.")
+    ("resectionEstimator", po::value<robustEstimation::ERobustEstimator>(&resectionEstimator)->default_value(resectionEstimator),
+      std::string("The type of *sac framework to use for resection (" + str_estimatorChoices + ").").c_str())
+    ("matchingEstimator", po::value<robustEstimation::ERobustEstimator>(&matchingEstimator)->default_value(matchingEstimator),
+      std::string("The type of *sac framework to use for matching (" + str_estimatorChoices + ").").c_str())
+    ("refineIntrinsics", po::value<bool>(&refineIntrinsics)->default_value(refineIntrinsics),
+      "Enable/Disable camera intrinsics refinement for each localized image.")
+    ("reprojectionError", po::value<double>(&resectionErrorMax)->default_value(resectionErrorMax),
+      "Maximum reprojection error (in pixels) allowed for resectioning. If set to 0 it lets the ACRansac select an optimal value.")
+    ("nbImageMatch", po::value<std::size_t>(&numResults)->default_value(numResults),
+      "Number of images to retrieve in database.")
+    ("maxResults", po::value<std::size_t>(&maxResults)->default_value(maxResults),
+      "For algorithm AllResults, it stops the image matching when this number of matched images is reached. If 0 it is ignored.")
+    ("algorithm", po::value<std::string>(&algostring)->default_value(algostring),
+      "Algorithm type: FirstBest, AllResults.")
+    ("matchingError", po::value<double>(&matchingErrorMax)->default_value(matchingErrorMax),
+      "Maximum matching error (in pixels) allowed for image matching with geometric verification. "
+      "If set to 0 it lets the ACRansac select an optimal value.")
+    ("robustMatching", po::value<bool>(&robustMatching)->default_value(robustMatching),
+      "Enable/Disable the robust matching between query and database images, all putative matches will be considered.");
+
+  po::options_description serverParams("Server parameters");
+  serverParams.add_options()
+    ("socket", po::value<std::string>(&socketPath)->default_value(socketPath),
+      "Path of the local socket of the server.")
+    ("nbThreads", po::value<std::size_t>(&nbThreads)->default_value(nbThreads),
+      "Number of worker threads (0 for the number of cores).")
+    ("maxBatchSize", po::value<std::size_t>(&maxBatchSize)->default_value(maxBatchSize),
+      "Maximum number of queued requests processed together by a worker (single vocabulary tree query).")
+    ("queueCapacity", po::value<std::size_t>(&queueCapacity)->default_value(queueCapacity),
+      "Maximum number of pending requests, the clients wait when the queue is full (0 for unbounded).");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(localizerParams).add(serverParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  if(!robustEstimation::checkRobustEstimator(matchingEstimator, matchingErrorMax) ||
+     !robustEstimation::checkRobustEstimator(resectionEstimator, resectionErrorMax))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // load SfMData
+  sfmData::SfMData sfmData;
+  if(!sfmDataIO::Load(sfmData, sfmFilePath, sfmDataIO::ESfMData::ALL))
+  {
+    ALICEVISION_LOG_ERROR("The input SfMData file '" + sfmFilePath + "' cannot be read.");
+    return EXIT_FAILURE;
+  }
+
+  const std::vector<feature::EImageDescriberType> matchDescTypes = feature::EImageDescriberType_stringToEnums(matchDescTypeNames);
+
+  system::Timer timer;
+  localization::VoctreeLocalizer localizer(sfmData, descriptorsFolder, vocTreeFilepath, weightsFilepath, matchDescTypes, localizationMapFilepath);
+  if(!localizer.isInit())
+  {
+    ALICEVISION_LOG_ERROR("Cannot initialize the localizer.");
+    return EXIT_FAILURE;
+  }
+  ALICEVISION_LOG_INFO("Localizer initialized in " << system::prettyTime(timer.elapsedMs()) << ".");
+
+  localization::VoctreeLocalizer::Parameters param;
+  param._algorithm = localization::VoctreeLocalizer::initFromString(algostring);
+  param._numResults = numResults;
+  param._maxResults = maxResults;
+  param._ccTagUseCuda = false;
+  param._matchingError = matchingErrorMax;
+  param._nbFrameBufferMatching = 0;
+  param._useRobustMatching = robustMatching;
+  param._featurePreset = featurePreset;
+  param._refineIntrinsics = refineIntrinsics;
+  param._errorMax = resectionErrorMax;
+  param._resectionEstimator = resectionEstimator;
+  param._matchingEstimator = matchingEstimator;
+
+  const int serverSocket = localization::listenLocalSocket(socketPath);
+  if(serverSocket < 0)
+    return EXIT_FAILURE;
+
+  std::signal(SIGINT, requestStop);
+  std::signal(SIGTERM, requestStop);
+
+  std::list<ClientThread> clientThreads;
+  {
+    localization::LocalizationServer server(localizer, param, nbThreads, maxBatchSize, queueCapacity);
+    ALICEVISION_LOG_INFO("Localization server listening to " << socketPath);
+
+    while(!stopRequested)
+    {
+      // join the threads of the disconnected clients
+      for(auto it = clientThreads.begin(); it != clientThreads.end();)
+      {
+        if(*it->done)
+        {
+          it->thread.join();
+          it = clientThreads.erase(it);
+        }
+        else
+          ++it;
+      }
+
+      const int socket = localization::acceptLocalSocket(serverSocket, 500);
+      if(socket < 0)
+        continue;
+
+      ALICEVISION_LOG_INFO("New client connection.");
+      std::shared_ptr<Connection> connection = std::make_shared<Connection>(socket);
+      std::shared_ptr<std::atomic<bool>> done = std::make_shared<std::atomic<bool>>(false);
+      clientThreads.push_back(ClientThread());
+      clientThreads.back().connection = connection;
+      clientThreads.back().done = done;
+      clientThreads.back().thread = std::thread([connection, done, &server]()
+      {
+        serveClient(connection, server);
+        *done = true;
+      });
+    }
+
+    ALICEVISION_LOG_INFO("Stop the localization server.");
+
+    // stop receiving the requests, the pending ones are processed and their responses sent
+    for(ClientThread& clientThread : clientThreads)
+    {
+      if(std::shared_ptr<Connection> connection = clientThread.connection.lock())
+        localization::shutdownLocalSocket(connection->socket);
+    }
+    for(ClientThread& clientThread : clientThreads)
+      clientThread.thread.join();
+    server.stop();
+
+    std::ostringstream statistics;
+    server.printStatistics(statistics, true);
+    ALICEVISION_LOG_INFO("Localization server statistics:\n" << statistics.str());
+  }
+
+  localization::closeLocalSocket(serverSocket);
+  std::remove(socketPath.c_str());
+
+  return EXIT_SUCCESS;
+}